@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Minimal self-calibrating microbenchmark harness. Each case runs its body for a growing number of
+// iterations until a run takes long enough to time reliably, then reports the per-iteration cost.
+namespace Bench {
+
+class State {
+public:
+    explicit State(uint64_t iterations) : iterations_(iterations) {}
+
+    uint64_t Iterations() const { return iterations_; }
+
+    /// @brief Attaches an extra value to the report (e.g. items processed per iteration).
+    void SetCounter(std::string name, double value) { counters_.emplace_back(std::move(name), value); }
+
+    const std::vector<std::pair<std::string, double>>& Counters() const { return counters_; }
+
+private:
+    uint64_t iterations_;
+    std::vector<std::pair<std::string, double>> counters_;
+};
+
+using Function = void (*)(State&);
+
+struct Registrar {
+    Registrar(const char* name, Function function);
+};
+
+/// @brief Prevents the compiler from discarding a computed value.
+template <class T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+int RunAll(int argc, char** argv);
+
+} // namespace Bench
+
+#define BENCH_CASE(name)                                         \
+    static void name(Bench::State& state);                       \
+    static const Bench::Registrar name##Registrar(#name, name); \
+    static void name(Bench::State& state)
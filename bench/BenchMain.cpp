@@ -0,0 +1,81 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace Bench {
+namespace {
+
+// A single timed run must take at least this long before its result is trusted.
+constexpr auto kMinRunTime = std::chrono::milliseconds(200);
+constexpr uint64_t kMaxIterations = 1ull << 32;
+
+struct Case {
+    const char* name;
+    Function function;
+};
+
+std::vector<Case>& Registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+} // namespace
+
+Registrar::Registrar(const char* name, Function function) {
+    Registry().push_back({ name, function });
+}
+
+int RunAll(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    std::printf("%-48s %14s %14s\n", "benchmark", "ns/iter", "iterations");
+    for (const auto& benchCase : Registry()) {
+        if (filter && !std::strstr(benchCase.name, filter)) {
+            continue;
+        }
+
+        // A run with no iterations first, so function-local statics (corpora, temp files) are built
+        // outside the timed runs.
+        State warmUp(0);
+        benchCase.function(warmUp);
+
+        uint64_t iterations = 1;
+        for (;;) {
+            State state(iterations);
+            const auto start = std::chrono::steady_clock::now();
+            benchCase.function(state);
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+
+            if (elapsed >= kMinRunTime || iterations >= kMaxIterations) {
+                const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+                std::printf("%-48s %14.1f %14llu",
+                    benchCase.name,
+                    ns / static_cast<double>(iterations),
+                    static_cast<unsigned long long>(iterations));
+                for (const auto& [name, value] : state.Counters()) {
+                    std::printf("  %s=%.6g", name.c_str(), value);
+                }
+                std::printf("\n");
+                break;
+            }
+
+            // Aim a little past the target so the next run is usually the last.
+            const double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+            const double target = std::chrono::duration<double, std::nano>(kMinRunTime).count() * 1.2;
+            uint64_t next = ns > 0 ? static_cast<uint64_t>(static_cast<double>(iterations) * target / ns) : iterations * 10;
+            if (next <= iterations) {
+                next = iterations * 2;
+            } else if (next > iterations * 100) {
+                next = iterations * 100;
+            }
+            iterations = next;
+        }
+    }
+    return 0;
+}
+
+} // namespace Bench
+
+int main(int argc, char** argv) {
+    return Bench::RunAll(argc, argv);
+}
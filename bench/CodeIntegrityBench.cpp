@@ -0,0 +1,115 @@
+#include "Bench.h"
+#include "CodeIntegrity.h"
+#include "SyntheticProcess.h"
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+// The diff kernel over 64 MB of identical code at each instruction-set level, and a full integrity check
+// of a 200-module process with 512 KB of relocated code per module (100 MB in all) and 64 planted inline
+// patches; "found" should equal "planted".
+
+namespace {
+constexpr size_t kPlanted = 64;
+constexpr size_t kDiffBytes = 64 << 20;
+
+const std::vector<uint8_t>& DiffBuffer() {
+    static const std::vector<uint8_t> buffer = [] {
+        std::vector<uint8_t> bytes(kDiffBytes);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+        }
+        return bytes;
+    }();
+    return buffer;
+}
+
+void DiffKernel(Bench::State& state, Simd::Level level) {
+    const auto& memory = DiffBuffer();
+    static const std::vector<uint8_t> file = DiffBuffer();
+    level = std::min(level, Simd::Detect());
+    std::vector<CodeIntegrity::Range> ranges;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        bool truncated = false;
+        ranges.clear();
+        Bench::DoNotOptimize(CodeIntegrity::Diff(memory.data(), file.data(), memory.size(), 0, ranges, 64, truncated, level));
+    }
+    state.SetCounter("MB", static_cast<double>(kDiffBytes >> 20));
+    state.SetCounter("level", static_cast<double>(level));
+}
+
+const std::vector<SyntheticProcess::Image>& PatchedProcess() {
+    static const auto images = [] {
+        SyntheticProcess::Options options;
+        options.modules = 200;
+        options.codeSize = 512 << 10;
+        options.relocations = 4096;
+        auto process = SyntheticProcess::Build(options);
+        SyntheticProcess::PatchCode(process, kPlanted, 11);
+        return process;
+    }();
+    return images;
+}
+
+// Serves the synthetic images' file bytes by path, standing in for the files on disk.
+CodeIntegrity::File OpenSyntheticFile(const std::wstring& path) {
+    static const auto byPath = [] {
+        std::unordered_map<std::wstring, const SyntheticProcess::Image*> images;
+        for (const auto& image : PatchedProcess()) {
+            images.emplace(image.path, &image);
+        }
+        return images;
+    }();
+    const auto it = byPath.find(path);
+    if (it == byPath.end()) {
+        return {};
+    }
+    CodeIntegrity::File file;
+    file.data = it->second->file.data();
+    file.size = it->second->file.size();
+    return file;
+}
+
+void CheckProcess(Bench::State& state, uint32_t threads) {
+    const auto modules = SyntheticProcess::Modules(PatchedProcess());
+    OpenSyntheticFile(modules.front().path);
+    CodeIntegrity::Options options;
+    options.threads = threads;
+    size_t found = 0;
+    uint64_t compared = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const auto results = CodeIntegrity::Check(modules, OpenSyntheticFile, options);
+        found = 0;
+        compared = 0;
+        for (const auto& result : results) {
+            found += result.ranges.size();
+            compared += result.bytesCompared;
+        }
+    }
+    state.SetCounter("modules", static_cast<double>(modules.size()));
+    state.SetCounter("MB", static_cast<double>(compared >> 20));
+    state.SetCounter("planted", static_cast<double>(kPlanted));
+    state.SetCounter("found", static_cast<double>(found));
+}
+} // namespace
+
+BENCH_CASE(CodeDiff64MBScalar) {
+    DiffKernel(state, Simd::Level::Scalar);
+}
+
+BENCH_CASE(CodeDiff64MBSse2) {
+    DiffKernel(state, Simd::Level::Sse2);
+}
+
+BENCH_CASE(CodeDiff64MBAvx2) {
+    DiffKernel(state, Simd::Level::Avx2);
+}
+
+BENCH_CASE(CodeIntegrity200SingleThread) {
+    CheckProcess(state, 1);
+}
+
+BENCH_CASE(CodeIntegrity200AllCores) {
+    CheckProcess(state, std::max(1u, std::thread::hardware_concurrency()));
+}
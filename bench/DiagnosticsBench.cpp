@@ -0,0 +1,25 @@
+#include "Bench.h"
+#include "Diagnostics.h"
+
+// Counters sit on hot paths (every PIDL allocation), so an increment must stay a single relaxed RMW.
+
+BENCH_CASE(DiagnosticsIncrementLocal) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Diagnostics::Increment(Diagnostics::Counter::PidlBytesAllocated, 24);
+    }
+}
+
+BENCH_CASE(DiagnosticsIncrementShared) {
+    Diagnostics::Publish();
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Diagnostics::Increment(Diagnostics::Counter::PidlBytesAllocated, 24);
+    }
+    state.SetCounter("published", Diagnostics::Publish() ? 1 : 0);
+}
+
+BENCH_CASE(DiagnosticsFormatReport) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        auto report = Diagnostics::FormatReport();
+        Bench::DoNotOptimize(report);
+    }
+}
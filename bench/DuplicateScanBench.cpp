@@ -0,0 +1,131 @@
+#include "Bench.h"
+#include "DuplicateScan.h"
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+// Duplicate detection over 2,000 modules with 20 DLLs also loaded from a second directory (40 copies),
+// 10 older builds loaded beside the current one (20 versions) and 10 unrelated files that happen to
+// share a fingerprint, which hashing must tell apart. Each file is 256 KB, served from memory. The
+// cached case is a refresh: the colliding files are already in the hash cache.
+
+namespace {
+constexpr uint32_t kModules = 2000;
+constexpr uint32_t kCopies = 20;
+constexpr uint32_t kVersions = 10;
+constexpr uint32_t kCollisions = 10;
+constexpr size_t kFileBytes = 256 << 10;
+
+struct Snapshot {
+    std::vector<DuplicateScan::Module> modules;
+    std::unordered_map<std::wstring, uint64_t> contentByPath; // Seed of each file's bytes
+};
+
+DuplicateScan::Fingerprint FingerprintOf(uint32_t index) {
+    DuplicateScan::Fingerprint fingerprint;
+    fingerprint.timeDateStamp = index * 2654435761u;
+    fingerprint.sizeOfImage = 0x10000 + index * 0x1000;
+    fingerprint.checksum = index * 40503u + 7;
+    fingerprint.machine = 0x8664;
+    return fingerprint;
+}
+
+const Snapshot& Process() {
+    static const Snapshot snapshot = [] {
+        Snapshot built;
+        auto add = [&built](std::wstring path, const DuplicateScan::Fingerprint& fingerprint, uint64_t content) {
+            DuplicateScan::Module module;
+            module.path = std::move(path);
+            module.base = 0x7FF800000000ull + built.modules.size() * 0x100000;
+            module.fingerprint = fingerprint;
+            module.fingerprinted = true;
+            built.contentByPath.emplace(module.path, content);
+            built.modules.push_back(std::move(module));
+        };
+        auto name = [](uint32_t index) {
+            std::wstring text = std::to_wstring(index);
+            return L"mod" + std::wstring(4 - std::min<size_t>(text.size(), 4), L'0') + text + L".dll";
+        };
+        for (uint32_t i = 0; i < kModules; ++i) {
+            add(L"C:\\Windows\\System32\\" + name(i), FingerprintOf(i), i);
+        }
+        for (uint32_t i = 0; i < kCopies; ++i) {
+            add(L"C:\\Program Files\\App" + std::to_wstring(i) + L"\\" + name(i), FingerprintOf(i), i);
+        }
+        for (uint32_t i = kCopies; i < kCopies + kVersions; ++i) {
+            auto older = FingerprintOf(i);
+            --older.timeDateStamp;
+            add(L"C:\\Program Files\\Old\\" + name(i), older, 100000 + i);
+        }
+        for (uint32_t i = kCopies + kVersions; i < kCopies + kVersions + kCollisions; ++i) {
+            add(L"C:\\Temp\\other" + std::to_wstring(i) + L".dll", FingerprintOf(i), 200000 + i);
+        }
+        return built;
+    }();
+    return snapshot;
+}
+
+class MemoryFile : public Platform::SequentialFile {
+public:
+    explicit MemoryFile(uint64_t content) : state_(content * 0x9E3779B97F4A7C15ull + 1) {
+        identity_.volume = 1;
+        identity_.fileId = content;
+        identity_.size = kFileBytes;
+    }
+
+    const Platform::FileIdentity& Identity() const override { return identity_; }
+
+    bool Read(void* buffer, size_t size, size_t& bytesRead) override {
+        bytesRead = std::min(size, kFileBytes - offset_);
+        auto* bytes = static_cast<uint8_t*>(buffer);
+        for (size_t i = 0; i < bytesRead; ++i) {
+            state_ = state_ * 6364136223846793005ull + 1442695040888963407ull;
+            bytes[i] = static_cast<uint8_t>(state_ >> 56);
+        }
+        offset_ += bytesRead;
+        return true;
+    }
+
+private:
+    Platform::FileIdentity identity_;
+    uint64_t state_;
+    size_t offset_ = 0;
+};
+
+std::unique_ptr<Platform::SequentialFile> OpenMemoryFile(const std::wstring& path) {
+    const auto& files = Process().contentByPath;
+    const auto it = files.find(path);
+    if (it == files.end()) {
+        return nullptr;
+    }
+    return std::make_unique<MemoryFile>(it->second);
+}
+
+void DetectDuplicates(Bench::State& state, bool cached) {
+    const auto& modules = Process().modules;
+    const uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    // Filled by the untimed warm-up run.
+    static FileHash::Cache warmCache;
+    if (cached && warmCache.Size() == 0) {
+        DuplicateScan::Detect(modules, OpenMemoryFile, &warmCache, threads);
+    }
+    DuplicateScan::Report report;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        FileHash::Cache coldCache;
+        report = DuplicateScan::Detect(modules, OpenMemoryFile, cached ? &warmCache : &coldCache, threads);
+    }
+    state.SetCounter("modules", static_cast<double>(modules.size()));
+    state.SetCounter("hashed", static_cast<double>(report.filesHashed));
+    state.SetCounter("copies", static_cast<double>(report.copies));
+    state.SetCounter("versions", static_cast<double>(report.versions));
+}
+} // namespace
+
+BENCH_CASE(DuplicateScan2000Cold) {
+    DetectDuplicates(state, false);
+}
+
+BENCH_CASE(DuplicateScan2000Cached) {
+    DetectDuplicates(state, true);
+}
@@ -0,0 +1,65 @@
+#include "Bench.h"
+#include "FakeModules.h"
+#include "ModuleEnumerator.h"
+#include "PidlCodec.h"
+
+#include <memory>
+
+// Folder enumeration over fake module snapshots, at our largest real process (1,500 modules) and 10x and
+// 100x beyond it. FirstPage is what the view waits on before it can show anything and should not depend on
+// the snapshot size; FullWalk is the cost of listing everything.
+
+namespace {
+constexpr size_t kPageSize = 64;
+
+void FirstPage(Bench::State& state, size_t moduleCount) {
+    auto snapshot = FakeModules::MakeSnapshot(moduleCount);
+    void* items[kPageSize] = {};
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        ModuleEnumerator enumerator(snapshot, FakeModules::Describe, true);
+        const size_t fetched = enumerator.Next(kPageSize, items);
+        for (size_t j = 0; j < fetched; ++j) {
+            PidlCodec::Free(items[j]);
+        }
+    }
+}
+
+void FullWalk(Bench::State& state, size_t moduleCount) {
+    auto snapshot = FakeModules::MakeSnapshot(moduleCount);
+    void* items[kPageSize] = {};
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        ModuleEnumerator enumerator(snapshot, FakeModules::Describe, true);
+        size_t fetched = 0;
+        while ((fetched = enumerator.Next(kPageSize, items)) != 0) {
+            for (size_t j = 0; j < fetched; ++j) {
+                PidlCodec::Free(items[j]);
+            }
+        }
+    }
+    state.SetCounter("items", static_cast<double>(moduleCount + 1));
+}
+} // namespace
+
+BENCH_CASE(EnumerateFirstPage1500) {
+    FirstPage(state, 1500);
+}
+
+BENCH_CASE(EnumerateFirstPage150000) {
+    FirstPage(state, 150000);
+}
+
+BENCH_CASE(EnumerateFullWalk1500) {
+    FullWalk(state, 1500);
+}
+
+BENCH_CASE(EnumerateFullWalk15000) {
+    FullWalk(state, 15000);
+}
+
+BENCH_CASE(EnumerateSkipToEnd150000) {
+    auto snapshot = FakeModules::MakeSnapshot(150000);
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        ModuleEnumerator enumerator(snapshot, FakeModules::Describe, true);
+        Bench::DoNotOptimize(enumerator.Skip(150001));
+    }
+}
@@ -0,0 +1,123 @@
+#include "Bench.h"
+#include "FileHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// SHA-256 and SHA-1 over 64 MB with and without the SHA extensions, and a hashing pass over 400 module
+// files of 1 MB each served from memory: first cold, then again with every identity already cached.
+
+namespace {
+constexpr size_t kKernelBytes = 64 << 20;
+constexpr size_t kFiles = 400;
+constexpr size_t kFileBytes = 1 << 20;
+
+const std::vector<uint8_t>& KernelBuffer() {
+    static const std::vector<uint8_t> buffer = [] {
+        std::vector<uint8_t> bytes(kKernelBytes);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+        }
+        return bytes;
+    }();
+    return buffer;
+}
+
+template <class Hasher>
+void HashKernel(Bench::State& state, bool extensions) {
+    const auto& bytes = KernelBuffer();
+    extensions = extensions && Simd::ShaExtensions();
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Hasher hasher(extensions);
+        hasher.Update(bytes.data(), bytes.size());
+        Bench::DoNotOptimize(hasher.Final());
+    }
+    state.SetCounter("MB", static_cast<double>(kKernelBytes >> 20));
+    state.SetCounter("extensions", extensions ? 1.0 : 0.0);
+}
+
+// A module file held in memory: every path maps to a slice of the kernel buffer, with a distinct identity.
+class MemoryFile : public Platform::SequentialFile {
+public:
+    MemoryFile(uint64_t id, const uint8_t* data, size_t size) : data_(data), size_(size) {
+        identity_.volume = 1;
+        identity_.fileId = id;
+        identity_.size = size;
+        identity_.lastWriteTime = 133000000000000000;
+    }
+
+    const Platform::FileIdentity& Identity() const override { return identity_; }
+
+    bool Read(void* buffer, size_t size, size_t& bytesRead) override {
+        bytesRead = std::min(size, size_ - offset_);
+        std::memcpy(buffer, data_ + offset_, bytesRead);
+        offset_ += bytesRead;
+        return true;
+    }
+
+private:
+    Platform::FileIdentity identity_;
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_ = 0;
+};
+
+std::unique_ptr<Platform::SequentialFile> OpenMemoryFile(const std::wstring& path) {
+    const uint64_t id = std::stoull(path.substr(path.find_last_of(L'\\') + 1));
+    const uint8_t* data = KernelBuffer().data() + (id * 4096) % (kKernelBytes - kFileBytes);
+    return std::make_unique<MemoryFile>(id, data, kFileBytes);
+}
+
+std::vector<std::wstring> FilePaths() {
+    std::vector<std::wstring> paths;
+    for (size_t i = 0; i < kFiles; ++i) {
+        paths.push_back(L"C:\\Windows\\System32\\" + std::to_wstring(i));
+    }
+    return paths;
+}
+
+void HashPass(Bench::State& state, bool warm) {
+    const auto paths = FilePaths();
+    FileHash::Options options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    // Filled by the untimed warm-up run.
+    static FileHash::Cache warmCache;
+    if (warm && warmCache.Size() == 0) {
+        FileHash::HashFiles(paths, &warmCache, OpenMemoryFile, options);
+    }
+    FileHash::Stats stats;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        FileHash::Cache coldCache;
+        Bench::DoNotOptimize(FileHash::HashFiles(paths, warm ? &warmCache : &coldCache, OpenMemoryFile, options, &stats));
+    }
+    state.SetCounter("files", static_cast<double>(kFiles));
+    state.SetCounter("MB", static_cast<double>(stats.bytesRead >> 20));
+    state.SetCounter("cached", static_cast<double>(stats.cacheHits));
+}
+} // namespace
+
+BENCH_CASE(Sha256_64MBScalar) {
+    HashKernel<Sha::Sha256>(state, false);
+}
+
+BENCH_CASE(Sha256_64MBExtensions) {
+    HashKernel<Sha::Sha256>(state, true);
+}
+
+BENCH_CASE(Sha1_64MBScalar) {
+    HashKernel<Sha::Sha1>(state, false);
+}
+
+BENCH_CASE(Sha1_64MBExtensions) {
+    HashKernel<Sha::Sha1>(state, true);
+}
+
+BENCH_CASE(HashFiles400Cold) {
+    HashPass(state, false);
+}
+
+BENCH_CASE(HashFiles400Cached) {
+    HashPass(state, true);
+}
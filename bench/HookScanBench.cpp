@@ -0,0 +1,42 @@
+#include "Bench.h"
+#include "HookScan.h"
+#include "SyntheticProcess.h"
+
+#include <algorithm>
+#include <thread>
+
+// A full IAT/EAT scan of a 400-module process (8 x 32 imports and 200 exports per module) with 64
+// planted hooks; "flagged" should equal "planted". The budget for a real Explorer is well under a second.
+
+namespace {
+constexpr size_t kPlanted = 64;
+
+const std::vector<SyntheticProcess::Image>& HookedProcess() {
+    static const auto images = [] {
+        auto process = SyntheticProcess::Build({});
+        SyntheticProcess::Hook(process, kPlanted, 7);
+        return process;
+    }();
+    return images;
+}
+
+void ScanProcess(Bench::State& state, uint32_t threads) {
+    const auto modules = SyntheticProcess::Modules(HookedProcess());
+    size_t flagged = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const auto report = HookScan::Scan(modules, nullptr, threads);
+        flagged = report.findings.size();
+    }
+    state.SetCounter("modules", static_cast<double>(modules.size()));
+    state.SetCounter("planted", static_cast<double>(kPlanted));
+    state.SetCounter("flagged", static_cast<double>(flagged));
+}
+} // namespace
+
+BENCH_CASE(HookScan400SingleThread) {
+    ScanProcess(state, 1);
+}
+
+BENCH_CASE(HookScan400AllCores) {
+    ScanProcess(state, std::max(1u, std::thread::hardware_concurrency()));
+}
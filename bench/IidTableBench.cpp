@@ -0,0 +1,36 @@
+#include "Bench.h"
+#include "IidTable.h"
+#include "QiProfiler.h"
+
+// QueryInterface runs constantly while Explorer drives a view, so naming and counting a request has to
+// cost about as much as the QI itself.
+
+namespace {
+const Guid kShellFolder2 = Guid::Parse("93F2F68C-1D1B-11D3-A30E-00C04F79ABD1");
+const Guid kUnknownIid = Guid::Parse("0DEADBEE-F00D-4BAD-8BAD-F00DCAFEBABE");
+} // namespace
+
+BENCH_CASE(IidTableLookupHit) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Bench::DoNotOptimize(IidTable::Lookup(kShellFolder2));
+    }
+    state.SetCounter("entries", static_cast<double>(IidTable::Size()));
+}
+
+BENCH_CASE(IidTableLookupMiss) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Bench::DoNotOptimize(IidTable::Lookup(kUnknownIid));
+    }
+}
+
+BENCH_CASE(QiProfilerRecordKnown) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        QiProfiler::Record(QiProfiler::Source::ModuleFolder, kShellFolder2, true);
+    }
+}
+
+BENCH_CASE(QiProfilerRecordUnknown) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        QiProfiler::Record(QiProfiler::Source::ModuleFolder, kUnknownIid, false);
+    }
+}
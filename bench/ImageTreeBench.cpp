@@ -0,0 +1,55 @@
+#include "Bench.h"
+#include "ImageTree.h"
+#include "SyntheticPe.h"
+
+#include <vector>
+
+// Opening a node of the per-module subtree: what the first open costs (decoding straight from the
+// image) and what every later one costs (a cache hit). The image is a large one, 4,000 exports and
+// 40 modules' worth of imports.
+
+namespace {
+SyntheticPe::Options LargeImage() {
+    SyntheticPe::Options options;
+    options.sectionCount = 8;
+    options.exportCount = 4000;
+    options.importModuleCount = 40;
+    options.importsPerModule = 100;
+    return options;
+}
+
+void DecodeNode(Bench::State& state, ImageTree::Node node) {
+    static const auto image = SyntheticPe::Build(LargeImage());
+    const PeImage::View view(image.data(), image.size());
+    size_t entries = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const auto listing = ImageTree::Decode(view, node);
+        entries = listing.entries.size();
+    }
+    state.SetCounter("entries", static_cast<double>(entries));
+}
+} // namespace
+
+BENCH_CASE(ImageTreeDecodeExports4000) {
+    DecodeNode(state, ImageTree::Node::Exports);
+}
+
+BENCH_CASE(ImageTreeDecodeImports4000) {
+    DecodeNode(state, ImageTree::Node::Imports);
+}
+
+BENCH_CASE(ImageTreeDecodeResources) {
+    DecodeNode(state, ImageTree::Node::Resources);
+}
+
+// Reopening a node already decoded: the lookup GetDetailsOf pays per visible row is this plus an index.
+BENCH_CASE(ImageTreeCacheHit) {
+    static const auto path = SyntheticPe::WriteTemp(LargeImage(), "explorer_modules_bench_tree.dll").wstring();
+    static ImageTree::Cache cache(16 * 1024 * 1024);
+    size_t entries = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        entries = cache.Get(path, ImageTree::Node::Exports)->entries.size();
+    }
+    state.SetCounter("entries", static_cast<double>(entries));
+    state.SetCounter("cacheBytes", static_cast<double>(cache.TotalBytes()));
+}
@@ -0,0 +1,54 @@
+#include "Bench.h"
+#include "FakeModules.h"
+#include "LruCache.h"
+#include "PeImage.h"
+
+#include <string>
+#include <vector>
+
+// The folder's path -> ImageInfo cache under column-fill access patterns. The default budget is 2048
+// entries; with 15,000 modules a full scroll evicts on nearly every lookup.
+
+namespace {
+constexpr size_t kDefaultBudget = 2048;
+
+std::vector<std::wstring> Paths(size_t count) {
+    auto snapshot = FakeModules::MakeSnapshot(count);
+    std::vector<std::wstring> paths;
+    ModuleRecord record = {};
+    for (auto handle : *snapshot) {
+        FakeModules::Describe(handle, record);
+        paths.push_back(record.path);
+    }
+    return paths;
+}
+
+// Scrolls through every path in order, inserting on a miss as ModuleFolder::GetImageInfo does.
+void Scroll(Bench::State& state, size_t moduleCount, size_t budget) {
+    static const auto paths = Paths(150000);
+    LruCache<std::wstring, PeImage::ImageInfo> cache(budget);
+    PeImage::ImageInfo info = { L"Contoso Ltd.", L"Contoso synthetic module", L"10.0.22621.1", L"x64" };
+    uint64_t hits = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const auto& path = paths[i % moduleCount];
+        if (cache.Find(path)) {
+            ++hits;
+        } else {
+            cache.Insert(path, info);
+        }
+    }
+    state.SetCounter("hitRate", static_cast<double>(hits) / static_cast<double>(state.Iterations()));
+}
+} // namespace
+
+BENCH_CASE(MetadataCacheScroll1500) {
+    Scroll(state, 1500, kDefaultBudget);
+}
+
+BENCH_CASE(MetadataCacheScroll15000) {
+    Scroll(state, 15000, kDefaultBudget);
+}
+
+BENCH_CASE(MetadataCacheScroll150000Budget16384) {
+    Scroll(state, 150000, 16384);
+}
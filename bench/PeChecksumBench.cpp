@@ -0,0 +1,98 @@
+#include "Bench.h"
+#include "PeChecksum.h"
+#include "SyntheticPe.h"
+
+#include <algorithm>
+
+// The word-sum kernel over 64 MB at each instruction-set level, and verification of 16 synthetic images
+// with 8 MB of code each (128 MB in all) whose CheckSum was stamped at build time, 4 of them altered
+// afterwards; "mismatch" should equal "altered".
+
+namespace {
+constexpr size_t kKernelBytes = 64 << 20;
+constexpr size_t kImages = 16;
+constexpr size_t kAltered = 4;
+
+const std::vector<uint8_t>& KernelBuffer() {
+    static const std::vector<uint8_t> buffer = [] {
+        std::vector<uint8_t> bytes(kKernelBytes);
+        for (size_t i = 0; i < bytes.size(); ++i) {
+            bytes[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+        }
+        return bytes;
+    }();
+    return buffer;
+}
+
+void SumKernel(Bench::State& state, Simd::Level level) {
+    const auto& bytes = KernelBuffer();
+    level = std::min(level, Simd::Detect());
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Bench::DoNotOptimize(PeChecksum::SumWords(bytes.data(), bytes.size(), level));
+    }
+    state.SetCounter("MB", static_cast<double>(kKernelBytes >> 20));
+    state.SetCounter("level", static_cast<double>(level));
+}
+
+const std::vector<std::vector<uint8_t>>& StampedImages() {
+    static const auto images = [] {
+        std::vector<std::vector<uint8_t>> files;
+        for (size_t i = 0; i < kImages; ++i) {
+            SyntheticPe::Options options;
+            options.sectionCount = 4;
+            options.exportCount = 500;
+            options.codeSize = 8 << 20;
+            options.checksum = true;
+            files.push_back(SyntheticPe::Build(options));
+            if (i % (kImages / kAltered) == 0) {
+                files.back()[files.back().size() / 2] ^= 0x40;
+            }
+        }
+        return files;
+    }();
+    return images;
+}
+
+void VerifyImages(Bench::State& state, Simd::Level level) {
+    const auto& images = StampedImages();
+    level = std::min(level, Simd::Detect());
+    size_t ok = 0;
+    size_t mismatch = 0;
+    uint64_t bytes = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        ok = 0;
+        mismatch = 0;
+        bytes = 0;
+        for (const auto& image : images) {
+            const auto result = PeChecksum::Verify(image.data(), image.size(), level);
+            ok += result.status == PeChecksum::Status::Ok;
+            mismatch += result.status == PeChecksum::Status::Mismatch;
+            bytes += image.size();
+        }
+    }
+    state.SetCounter("MB", static_cast<double>(bytes >> 20));
+    state.SetCounter("ok", static_cast<double>(ok));
+    state.SetCounter("altered", static_cast<double>(kAltered));
+    state.SetCounter("mismatch", static_cast<double>(mismatch));
+}
+} // namespace
+
+BENCH_CASE(PeChecksum64MBScalar) {
+    SumKernel(state, Simd::Level::Scalar);
+}
+
+BENCH_CASE(PeChecksum64MBSse2) {
+    SumKernel(state, Simd::Level::Sse2);
+}
+
+BENCH_CASE(PeChecksum64MBAvx2) {
+    SumKernel(state, Simd::Level::Avx2);
+}
+
+BENCH_CASE(PeChecksumVerify16x8MBScalar) {
+    VerifyImages(state, Simd::Level::Scalar);
+}
+
+BENCH_CASE(PeChecksumVerify16x8MBAvx2) {
+    VerifyImages(state, Simd::Level::Avx2);
+}
@@ -0,0 +1,109 @@
+#include "Bench.h"
+#include "PeIcon.h"
+#include "SyntheticPe.h"
+
+// Icon decoding, and the 32-pixel icons of 400 synthetic modules that share 8 distinct icons between
+// them, as system DLLs do. "Uncached" decodes every module's icon; "Cold" goes through an empty
+// PeIcon::Cache, hashing every group but decoding each distinct icon once; "Redraw" is a view repainting
+// with the cache warm and each module's group digest already known, so it only looks pixels up.
+
+namespace {
+constexpr size_t kModules = 400;
+constexpr uint32_t kDistinctIcons = 8;
+constexpr uint32_t kSize = 32;
+
+const std::vector<std::vector<uint8_t>>& Modules() {
+    static const auto images = [] {
+        std::vector<std::vector<uint8_t>> built;
+        for (size_t i = 0; i < kModules; ++i) {
+            SyntheticPe::Options options;
+            options.iconSet = 1 + static_cast<uint32_t>(i % kDistinctIcons);
+            options.iconBitCount = i % 4 == 3 ? 8 : 32;
+            built.push_back(SyntheticPe::Build(options));
+        }
+        return built;
+    }();
+    return images;
+}
+
+void DecodeOne(Bench::State& state, uint16_t bitCount) {
+    SyntheticPe::Options options;
+    options.iconSet = 1;
+    options.iconBitCount = bitCount;
+    const auto image = SyntheticPe::Build(options);
+    const PeImage::View view(image.data(), image.size());
+    PeIcon::Group group;
+    PeIcon::ReadGroup(view, group);
+    size_t length = 0;
+    const uint8_t* data = PeIcon::FindIcon(view, group.entries[PeIcon::Preference(group, kSize)[0]].id, length);
+    PeIcon::Image decoded;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        PeIcon::Decode(data, length, decoded);
+        Bench::DoNotOptimize(decoded.pixels.data());
+    }
+    state.SetCounter("pixels", static_cast<double>(decoded.pixels.size()));
+}
+} // namespace
+
+BENCH_CASE(PeIconDecode32x32x32bpp) {
+    DecodeOne(state, 32);
+}
+
+BENCH_CASE(PeIconDecode32x32x8bpp) {
+    DecodeOne(state, 8);
+}
+
+BENCH_CASE(PeIconLoad400Uncached) {
+    const auto& modules = Modules();
+    size_t decoded = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        decoded = 0;
+        for (const auto& module : modules) {
+            const PeImage::View view(module.data(), module.size());
+            PeIcon::Group group;
+            PeIcon::Image image;
+            decoded += PeIcon::ReadGroup(view, group) && PeIcon::Load(view, group, kSize, image);
+        }
+    }
+    state.SetCounter("modules", static_cast<double>(modules.size()));
+    state.SetCounter("decoded", static_cast<double>(decoded));
+}
+
+BENCH_CASE(PeIconLoad400Cold) {
+    const auto& modules = Modules();
+    PeIcon::Cache::Stats stats = {};
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        PeIcon::Cache cache;
+        for (const auto& module : modules) {
+            Bench::DoNotOptimize(PeIcon::Get(PeImage::View(module.data(), module.size()), kSize, cache));
+        }
+        stats = cache.GetStats();
+    }
+    state.SetCounter("modules", static_cast<double>(modules.size()));
+    state.SetCounter("decoded", static_cast<double>(stats.misses));
+    state.SetCounter("KB", static_cast<double>(stats.bytes >> 10));
+}
+
+BENCH_CASE(PeIconRedraw400) {
+    const auto& modules = Modules();
+    static PeIcon::Cache cache;
+    static std::vector<Sha::Sha256::Digest> digests;
+    if (digests.empty()) {
+        for (const auto& module : modules) {
+            const PeImage::View view(module.data(), module.size());
+            PeIcon::Group group;
+            PeIcon::ReadGroup(view, group);
+            digests.push_back(group.digest);
+            PeIcon::Get(view, kSize, cache);
+        }
+    }
+    size_t found = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        found = 0;
+        for (const auto& digest : digests) {
+            found += cache.Find(digest, kSize) != nullptr;
+        }
+    }
+    state.SetCounter("modules", static_cast<double>(modules.size()));
+    state.SetCounter("found", static_cast<double>(found));
+}
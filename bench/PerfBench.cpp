@@ -0,0 +1,69 @@
+#include "Bench.h"
+#include "Perf.h"
+
+#include <filesystem>
+#include <thread>
+
+// Overhead of the instrumentation itself. ClockNow is the floor: a ScopedTimer reads the clock twice,
+// so anything much above 2x ClockNow is histogram or trace cost.
+
+BENCH_CASE(ClockNow) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        auto now = Perf::Clock::now();
+        Bench::DoNotOptimize(now);
+    }
+}
+
+BENCH_CASE(HistogramRecord) {
+    Perf::Histogram histogram;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        histogram.Record(i * 37 + 1000);
+    }
+    Bench::DoNotOptimize(histogram.Count());
+}
+
+BENCH_CASE(HistogramRecordContended4Threads) {
+    Perf::Histogram histogram;
+    const uint64_t perThread = state.Iterations() / 4 + 1;
+    std::thread threads[4];
+    for (auto& thread : threads) {
+        thread = std::thread([&histogram, perThread] {
+            for (uint64_t i = 0; i < perThread; ++i) {
+                histogram.Record(i + 500);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    Bench::DoNotOptimize(histogram.Count());
+}
+
+BENCH_CASE(HistogramPercentiles) {
+    Perf::Histogram histogram;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        histogram.Record(i * 101);
+    }
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Bench::DoNotOptimize(histogram.ValueAtPercentile(99));
+    }
+}
+
+BENCH_CASE(ScopedTimer) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Perf::ScopedTimer timer(Perf::Op::CompareIDs);
+    }
+    Perf::ResetHistograms();
+}
+
+BENCH_CASE(ScopedTimerTracing) {
+    const auto path = std::filesystem::temp_directory_path() / "ExplorerModulesBench.trace.json";
+    Perf::StartTrace(path);
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        Perf::ScopedTimer timer(Perf::Op::CompareIDs);
+    }
+    Perf::StopTrace();
+    Perf::ResetHistograms();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
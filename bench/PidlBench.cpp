@@ -0,0 +1,111 @@
+#include "Bench.h"
+#include "FakeModules.h"
+#include "PidlCodec.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Item ID encoding, decoding and the comparisons behind CompareIDs. Explorer calls CompareIDs
+// O(n log n) times per sort, so the per-call cost multiplies quickly on folders with many modules.
+
+namespace {
+const std::wstring kPath = L"C:\\Windows\\System32\\windows.storage.dll";
+
+std::vector<void*> MakeItems(size_t count) {
+    std::vector<void*> items;
+    for (size_t i = 0; i < count; ++i) {
+        auto path = L"C:\\Windows\\System32\\module" + std::to_wstring((i * 7919) % count) + L".dll";
+        items.push_back(PidlCodec::Create(PidlCodec::kModuleSignature, path, 0x7FF800000000ull + i * 0x100000,
+            static_cast<uint32_t>(0x10000 + i)));
+    }
+    return items;
+}
+
+void FreeItems(std::vector<void*>& items) {
+    for (void* item : items) {
+        PidlCodec::Free(item);
+    }
+}
+
+// Sorts a fresh copy of a 15,000-module folder (10x our largest real process) per iteration.
+void SortAll(Bench::State& state, PidlCodec::SortKey key) {
+    constexpr size_t kModules = 15000;
+    auto snapshot = FakeModules::MakeSnapshot(kModules);
+    std::vector<void*> items;
+    ModuleRecord record = {};
+    for (auto handle : *snapshot) {
+        FakeModules::Describe(handle, record);
+        items.push_back(PidlCodec::Create(PidlCodec::kModuleSignature, record.path,
+            reinterpret_cast<uintptr_t>(record.baseAddress), record.size));
+    }
+    std::vector<void*> sorted;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        sorted = items;
+        std::sort(sorted.begin(), sorted.end(),
+            [key](const void* left, const void* right) { return PidlCodec::Compare(left, right, key) < 0; });
+        Bench::DoNotOptimize(sorted.front());
+    }
+    state.SetCounter("items", static_cast<double>(kModules));
+    FreeItems(items);
+}
+
+void CompareAll(Bench::State& state, PidlCodec::SortKey key) {
+    auto items = MakeItems(256);
+    int total = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const size_t a = i % items.size();
+        const size_t b = (i * 31 + 7) % items.size();
+        total += PidlCodec::Compare(items[a], items[b], key);
+    }
+    Bench::DoNotOptimize(total);
+    FreeItems(items);
+}
+} // namespace
+
+BENCH_CASE(PidlCreateFromPath) {
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        void* item = PidlCodec::Create(PidlCodec::kModuleSignature, kPath, 0x7FF812340000ull, 0x2A000);
+        Bench::DoNotOptimize(item);
+        PidlCodec::Free(item);
+    }
+}
+
+BENCH_CASE(PidlClone) {
+    void* item = PidlCodec::Create(PidlCodec::kModuleSignature, kPath, 0x7FF812340000ull, 0x2A000);
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        void* clone = PidlCodec::Clone(item);
+        Bench::DoNotOptimize(clone);
+        PidlCodec::Free(clone);
+    }
+    PidlCodec::Free(item);
+}
+
+BENCH_CASE(PidlGetPath) {
+    void* item = PidlCodec::Create(PidlCodec::kModuleSignature, kPath, 0x7FF812340000ull, 0x2A000);
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        auto path = PidlCodec::GetPath(item);
+        Bench::DoNotOptimize(path);
+    }
+    PidlCodec::Free(item);
+}
+
+BENCH_CASE(CompareIDsName) {
+    CompareAll(state, PidlCodec::SortKey::Name);
+}
+
+BENCH_CASE(CompareIDsPath) {
+    CompareAll(state, PidlCodec::SortKey::Path);
+}
+
+BENCH_CASE(CompareIDsBaseAddress) {
+    CompareAll(state, PidlCodec::SortKey::BaseAddress);
+}
+
+BENCH_CASE(SortName15000) {
+    SortAll(state, PidlCodec::SortKey::Name);
+}
+
+BENCH_CASE(SortBaseAddress15000) {
+    SortAll(state, PidlCodec::SortKey::BaseAddress);
+}
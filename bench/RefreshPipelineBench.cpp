@@ -0,0 +1,28 @@
+#include "Bench.h"
+#include "RefreshPipeline.h"
+
+// Cost of the loader-callback side of RefreshPipeline, which runs under the loader lock. Back-to-back
+// events mostly coalesce; threadsPerEvent shows how often one still pays for a thread start.
+
+namespace {
+void NoNotify() {}
+} // namespace
+
+BENCH_CASE(LoaderEventStorm) {
+    RefreshPipeline pipeline(NoNotify);
+    LDR_DLL_NOTIFICATION_DATA data = {};
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        RefreshPipeline::DllNotificationCallback(LDR_DLL_NOTIFICATION_REASON_LOADED, &data, &pipeline);
+    }
+    pipeline.Drain();
+    const auto stats = pipeline.GetStats();
+    state.SetCounter("threadsPerEvent", static_cast<double>(stats.threadsStarted) / static_cast<double>(stats.events));
+}
+
+BENCH_CASE(LoaderEventIgnoredReason) {
+    RefreshPipeline pipeline(NoNotify);
+    LDR_DLL_NOTIFICATION_DATA data = {};
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        RefreshPipeline::DllNotificationCallback(0, &data, &pipeline);
+    }
+}
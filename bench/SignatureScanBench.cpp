@@ -0,0 +1,104 @@
+#include "Bench.h"
+#include "SignatureScan.h"
+#include "SyntheticProcess.h"
+
+#include <algorithm>
+#include <random>
+
+// Signature search over a 200-module process with 512 KB of code per module (100 MB in all). Three
+// signatures are each planted 16 times; the 64-pattern cases add 61 random signatures that are not
+// planted, so the prefilter has many first bytes to look for. "hits" should equal "planted". Building
+// the automaton for 1000 patterns is timed separately.
+
+namespace {
+constexpr size_t kPlantedEach = 16;
+
+const std::vector<std::vector<uint8_t>>& PlantedBytes() {
+    static const std::vector<std::vector<uint8_t>> bytes = {
+        { 0x48, 0x8B, 0x05, 0x11, 0x22, 0x33, 0x44, 0x48, 0x85, 0xC0, 0x74, 0x0C },
+        { 0xFF, 0x25, 0xA1, 0xB2, 0xC3, 0xD4, 0x90, 0x90, 0xCC, 0xCC, 0xCC, 0xCC },
+        { 0x4C, 0x8B, 0xD1, 0xB8, 0x18, 0x00, 0x00, 0x00, 0x0F, 0x05, 0xC3, 0x66 },
+    };
+    return bytes;
+}
+
+const std::vector<SyntheticProcess::Image>& PlantedProcess() {
+    static const auto images = [] {
+        SyntheticProcess::Options options;
+        options.modules = 200;
+        options.codeSize = 512 << 10;
+        auto process = SyntheticProcess::Build(options);
+        uint64_t seed = 21;
+        for (const auto& bytes : PlantedBytes()) {
+            SyntheticProcess::Plant(process, bytes, kPlantedEach, seed++);
+        }
+        return process;
+    }();
+    return images;
+}
+
+// The planted signatures, each with its fourth byte a wildcard, then random 12-byte signatures.
+std::vector<SignatureScan::Pattern> Patterns(size_t count, uint64_t seed) {
+    std::vector<SignatureScan::Pattern> patterns;
+    for (const auto& bytes : PlantedBytes()) {
+        SignatureScan::Pattern pattern{ bytes, std::vector<uint8_t>(bytes.size(), 0xFF), L"planted" };
+        pattern.mask[3] = 0;
+        patterns.push_back(std::move(pattern));
+    }
+    std::mt19937_64 random(seed);
+    while (patterns.size() < count) {
+        SignatureScan::Pattern pattern{ std::vector<uint8_t>(12), std::vector<uint8_t>(12, 0xFF), L"random" };
+        for (auto& byte : pattern.bytes) {
+            byte = static_cast<uint8_t>(random());
+        }
+        pattern.mask[6] = 0;
+        patterns.push_back(std::move(pattern));
+    }
+    return patterns;
+}
+
+void Search(Bench::State& state, size_t patternCount, Simd::Level level) {
+    const auto modules = SyntheticProcess::Modules(PlantedProcess());
+    const SignatureScan::Matcher matcher(Patterns(patternCount, 5));
+    SignatureScan::Options options;
+    options.level = std::min(level, Simd::Detect());
+    SignatureScan::Stats stats;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        stats = SignatureScan::Search(modules, matcher, options, nullptr, nullptr);
+    }
+    state.SetCounter("MB", static_cast<double>(stats.bytesScanned >> 20));
+    state.SetCounter("planted", static_cast<double>(kPlantedEach * PlantedBytes().size()));
+    state.SetCounter("hits", static_cast<double>(stats.hits));
+    state.SetCounter("level", static_cast<double>(options.level));
+}
+} // namespace
+
+BENCH_CASE(SignatureSearch3PatternsScalar) {
+    Search(state, 3, Simd::Level::Scalar);
+}
+
+BENCH_CASE(SignatureSearch3PatternsSse2) {
+    Search(state, 3, Simd::Level::Sse2);
+}
+
+BENCH_CASE(SignatureSearch3PatternsAvx2) {
+    Search(state, 3, Simd::Level::Avx2);
+}
+
+BENCH_CASE(SignatureSearch64PatternsScalar) {
+    Search(state, 64, Simd::Level::Scalar);
+}
+
+BENCH_CASE(SignatureSearch64PatternsAvx2) {
+    Search(state, 64, Simd::Level::Avx2);
+}
+
+BENCH_CASE(SignatureMatcherBuild1000) {
+    const auto patterns = Patterns(1000, 9);
+    size_t states = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const SignatureScan::Matcher matcher(patterns);
+        states = matcher.StateCount();
+    }
+    state.SetCounter("states", static_cast<double>(states));
+}
@@ -0,0 +1,116 @@
+#include "Bench.h"
+#include "FakeModules.h"
+#include "Platform.h"
+#include "SnapshotCompare.h"
+#include "SnapshotExport.h"
+#include "SnapshotFormat.h"
+
+#include <filesystem>
+#include <string>
+
+// Exporting a 15,000 module table in each format, and what reading a binary snapshot back costs: a
+// column scan straight out of the mapping, with no parsing beyond the header. The SnapshotCompare cases
+// are the per-file costs of SnapshotDiff.
+
+namespace {
+constexpr uint64_t kRows = 15000;
+
+PeImage::ImageInfo FakeImageInfo(const std::filesystem::path&) {
+    PeImage::ImageInfo info = { L"Contoso Ltd.", L"Contoso synthetic module", L"10.0.22621.1", L"x64" };
+    info.machine = PeImage::kMachineAmd64;
+    info.fileVersionNumber = 0x000A0000585D0001;
+    return info;
+}
+
+std::filesystem::path TempPath(const char* fileName) {
+    return std::filesystem::temp_directory_path() / fileName;
+}
+
+// A binary snapshot of the first count fake modules, written once per file name.
+std::filesystem::path WriteSnapshot(const char* fileName, size_t count) {
+    const auto snapshot = FakeModules::MakeSnapshot(count);
+    const auto path = TempPath(fileName);
+    uint64_t rows = 0;
+    auto writer = SnapshotExport::Open(SnapshotExport::Format::Binary, path, snapshot->size(), 0, 0);
+    SnapshotExport::WriteModules(*writer, *snapshot, FakeModules::Describe, FakeImageInfo, rows);
+    writer->Finish();
+    return path;
+}
+
+void Export(Bench::State& state, SnapshotExport::Format format, const char* fileName) {
+    static const auto snapshot = FakeModules::MakeSnapshot(kRows);
+    const auto path = TempPath(fileName);
+    uint64_t rows = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        auto writer = SnapshotExport::Open(format, path, snapshot->size(), 0, 0);
+        if (!writer) {
+            return;
+        }
+        SnapshotExport::WriteModules(*writer, *snapshot, FakeModules::Describe, FakeImageInfo, rows);
+        writer->Finish();
+    }
+    state.SetCounter("rows", static_cast<double>(rows));
+    state.SetCounter("bytes", static_cast<double>(std::filesystem::file_size(path)));
+}
+} // namespace
+
+BENCH_CASE(SnapshotExportBinary15000) {
+    Export(state, SnapshotExport::Format::Binary, "explorer_modules_bench.emsnap");
+}
+
+BENCH_CASE(SnapshotExportCsv15000) {
+    Export(state, SnapshotExport::Format::Csv, "explorer_modules_bench.csv");
+}
+
+BENCH_CASE(SnapshotExportJson15000) {
+    Export(state, SnapshotExport::Format::Json, "explorer_modules_bench.json");
+}
+
+// Open, map and validate, then total a fixed-width column and the string lengths of another.
+BENCH_CASE(SnapshotReadColumnScan15000) {
+    static const auto path = WriteSnapshot("explorer_modules_bench_read.emsnap", kRows);
+
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const auto file = Platform::MappedFile::Open(path);
+        const SnapshotFormat::Reader reader(file->Data(), file->Size());
+        const auto* sizes = reader.U32Column(SnapshotFormat::ColumnId::Size);
+        const auto* paths = reader.StringColumn(SnapshotFormat::ColumnId::Path);
+        for (uint64_t row = 0; row < reader.RowCount(); ++row) {
+            total += sizes[row] + reader.String(paths[row]).size();
+        }
+    }
+    Bench::DoNotOptimize(total);
+    state.SetCounter("rows", static_cast<double>(kRows));
+}
+
+// Interning every path of a snapshot whose paths are already known, as for all but the first file of a
+// fleet.
+BENCH_CASE(SnapshotLoadEntries15000) {
+    static const auto path = WriteSnapshot("explorer_modules_bench_read.emsnap", kRows);
+    static const auto file = Platform::MappedFile::Open(path);
+    static SnapshotCompare::PathInterner interner;
+    const SnapshotFormat::Reader reader(file->Data(), file->Size());
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        auto entries = SnapshotCompare::LoadEntries(reader, interner);
+        Bench::DoNotOptimize(entries);
+    }
+    state.SetCounter("rows", static_cast<double>(kRows));
+}
+
+// Two snapshots sharing 14,000 modules.
+BENCH_CASE(SnapshotCompare15000) {
+    static SnapshotCompare::PathInterner interner;
+    static const auto load = [](const std::filesystem::path& path) {
+        const auto file = Platform::MappedFile::Open(path);
+        return SnapshotCompare::LoadEntries(SnapshotFormat::Reader(file->Data(), file->Size()), interner);
+    };
+    static const auto before = load(WriteSnapshot("explorer_modules_bench_read.emsnap", kRows));
+    static const auto after = load(WriteSnapshot("explorer_modules_bench_after.emsnap", kRows - 1000));
+    size_t removed = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        const auto diff = SnapshotCompare::Compare(before, after);
+        removed = diff.removed.size();
+    }
+    state.SetCounter("removed", static_cast<double>(removed));
+}
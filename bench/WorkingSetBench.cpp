@@ -0,0 +1,88 @@
+#include "Bench.h"
+#include "Platform.h"
+#include "WorkingSet.h"
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// The working-set refresh over a large process: 2,000 modules of 1 MB (512,000 pages) against a fake
+// query, once with nothing changed since the last refresh (the delta path the timer takes almost
+// always) and once with one page of every module flipping each time. The third case queries the real
+// backend over a 64 MB buffer split into 64 "modules", half of it touched.
+
+namespace {
+constexpr uint32_t kModules = 2000;
+constexpr uint64_t kModuleSize = 1 << 20;
+constexpr uint64_t kPageSize = 4096;
+
+uint64_t g_flip = 0; // Which fake query answer to give
+
+bool FakeQuery(const uint64_t* pages, size_t count, uint8_t* flags) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t page = pages[i] / kPageSize;
+        flags[i] = (page % 3 ? WorkingSet::kResident : 0) | (page % 5 ? WorkingSet::kShared : 0);
+        if (page % 256 == 0) {
+            flags[i] ^= g_flip & WorkingSet::kResident;
+        }
+    }
+    return true;
+}
+
+std::vector<WorkingSet::Module> FakeModules() {
+    std::vector<WorkingSet::Module> modules;
+    for (uint32_t i = 0; i < kModules; ++i) {
+        // Reverse order, as the loader lists them relative to address
+        modules.push_back({ 0x7FF800000000ull - uint64_t{ i } * 2 * kModuleSize, kModuleSize });
+    }
+    return modules;
+}
+
+void Refreshes(Bench::State& state, bool flip) {
+    const auto modules = FakeModules();
+    WorkingSet::Tracker tracker(FakeQuery, kPageSize);
+    g_flip = 0;
+    tracker.Refresh(modules);
+    size_t changed = 0;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        g_flip += flip;
+        tracker.Refresh(modules);
+        changed = tracker.Changed().size();
+    }
+    state.SetCounter("pages", static_cast<double>(tracker.GetStats().pagesQueried / tracker.GetStats().refreshes));
+    state.SetCounter("changed", static_cast<double>(changed));
+}
+} // namespace
+
+BENCH_CASE(WorkingSetRefreshUnchanged) {
+    Refreshes(state, false);
+}
+
+BENCH_CASE(WorkingSetRefreshChanged) {
+    Refreshes(state, true);
+}
+
+BENCH_CASE(WorkingSetRefreshReal) {
+    constexpr size_t kBytes = 64 << 20;
+    constexpr uint32_t kParts = 64;
+    // Default-initialized, so the second half stays untouched where the allocator maps fresh pages
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[kBytes]);
+    std::memset(buffer.get(), 1, kBytes / 2);
+    const uint64_t start = reinterpret_cast<uint64_t>(buffer.get());
+    std::vector<WorkingSet::Module> modules;
+    for (uint32_t i = 0; i < kParts; ++i) {
+        modules.push_back({ start + i * (kBytes / kParts), kBytes / kParts });
+    }
+    WorkingSet::Tracker tracker(Platform::QueryWorkingSet, Platform::PageSize());
+    bool ok = true;
+    for (uint64_t i = 0; i < state.Iterations(); ++i) {
+        ok &= tracker.Refresh(modules);
+    }
+    uint64_t resident = 0;
+    for (const auto& module : modules) {
+        const auto* counts = tracker.Find(module.base);
+        resident += counts ? counts->resident : 0;
+    }
+    state.SetCounter("ok", ok);
+    state.SetCounter("residentKB", static_cast<double>(resident * Platform::PageSize() / 1024));
+}
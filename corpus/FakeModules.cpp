@@ -0,0 +1,68 @@
+#include "FakeModules.h"
+
+#include <cwchar>
+#include <iterator>
+
+namespace FakeModules {
+namespace {
+
+constexpr const wchar_t* kDirectories[] = {
+    L"C:\\Windows\\System32\\",
+    L"C:\\Program Files\\Contoso\\Plugins\\",
+    L"C:\\Program Files (x86)\\Fabrikam\\bin\\",
+    L"C:\\Users\\Public\\AppData\\Local\\Litware\\Extensions\\",
+};
+
+constexpr const wchar_t* kVendors[] = {
+    L"contoso", L"fabrikam", L"litware", L"adatum", L"northwind", L"tailspin", L"wingtip", L"proseware",
+};
+
+constexpr const wchar_t* kComponents[] = {
+    L"core", L"ui", L"net", L"crypto", L"render", L"plugin", L"shim", L"host", L"sync", L"search",
+};
+
+uint64_t Mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+} // namespace
+
+std::shared_ptr<const ModuleEnumerator::Snapshot> MakeSnapshot(size_t count) {
+    auto snapshot = std::make_shared<ModuleEnumerator::Snapshot>(count);
+    for (size_t i = 0; i < count; ++i) {
+        (*snapshot)[i] = static_cast<ModuleEnumerator::Handle>(i + 1);
+    }
+    return snapshot;
+}
+
+bool Describe(ModuleEnumerator::Handle handle, ModuleRecord& record) {
+    const size_t index = static_cast<size_t>(handle - 1);
+    const uint64_t hash = Mix(index);
+    record.path = kDirectories[hash % std::size(kDirectories)];
+    record.path += FileName(index);
+    record.baseAddress = reinterpret_cast<void*>(static_cast<uintptr_t>(BaseAddress(index)));
+    // 16 KB to 16 MB, page-aligned
+    record.size = static_cast<uint32_t>(((hash >> 8) % 4096 + 4) * 0x1000);
+    return true;
+}
+
+std::wstring FileName(size_t index) {
+    const uint64_t hash = Mix(index ^ 0x5DEECE66Dull);
+    wchar_t name[64] = {};
+    std::swprintf(name, std::size(name), L"%ls_%ls%05zu.dll", kVendors[hash % std::size(kVendors)],
+        kComponents[(hash >> 16) % std::size(kComponents)], index);
+    return name;
+}
+
+uint64_t BaseAddress(size_t index) {
+    if constexpr (sizeof(uintptr_t) == 8) {
+        return 0x7FF800000000ull + static_cast<uint64_t>(index) * 0x200000;
+    } else {
+        return 0x10000000ull + static_cast<uint64_t>(index % 0x300) * 0x200000;
+    }
+}
+
+} // namespace FakeModules
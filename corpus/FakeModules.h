@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ModuleEnumerator.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Fake loaded-module snapshots for driving enumeration, sorting and the metadata cache at scales beyond
+// what a real process reaches. Everything about a module is derived from its handle, so Describe needs
+// no state and any number of snapshots can share it.
+namespace FakeModules {
+
+/// @brief A snapshot of count modules with handles 1..count in load order.
+std::shared_ptr<const ModuleEnumerator::Snapshot> MakeSnapshot(size_t count);
+
+/// @brief A ModuleEnumerator::DescribeFn for MakeSnapshot handles: a path under one of a few install
+/// directories ending in FileName(handle - 1), a base address and a size. Never fails.
+bool Describe(ModuleEnumerator::Handle handle, ModuleRecord& record);
+
+/// @brief File name of the index-th module, e.g. "fabrikam_render01234.dll". Names are spread across a
+/// handful of vendor prefixes so they do not sort in load order. PeCorpusGen uses the same names.
+std::wstring FileName(size_t index);
+
+/// @brief The base address Describe reports for the index-th module: 2 MB-aligned slots in the usual
+/// 64-bit DLL range.
+uint64_t BaseAddress(size_t index);
+
+} // namespace FakeModules
@@ -0,0 +1,712 @@
+#include "SyntheticPe.h"
+
+#include "PeChecksum.h"
+#include "PeIcon.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace SyntheticPe {
+namespace {
+
+constexpr uint32_t kFileAlignment = 0x200;
+constexpr uint32_t kSectionAlignment = 0x1000;
+constexpr uint32_t kNtOffset = 0x40;
+constexpr size_t kFileHeaderSize = 20;
+constexpr size_t kSectionHeaderSize = 40;
+constexpr uint32_t kTextSize = 0x400;
+constexpr uint32_t kMaxSections = 0xFFFF;
+
+constexpr uint32_t kCodeCharacteristics = 0x60000020; // Code, executable, readable
+constexpr uint32_t kDataCharacteristics = 0x40000040; // Initialized data, readable
+constexpr uint32_t kWritableCharacteristics = 0xC0000040; // Initialized data, readable, writable
+constexpr uint32_t kRelocCharacteristics = 0x42000040; // Initialized data, discardable, readable
+
+constexpr uint16_t kRelocHighLow = 3;
+constexpr uint16_t kRelocDir64 = 10;
+
+struct SectionData {
+    const char* name;
+    uint32_t characteristics;
+    uint32_t rva = 0;
+    std::vector<uint8_t> data;
+};
+
+struct Directories {
+    PeImage::DataDirectory exports = {};
+    PeImage::DataDirectory imports = {};
+    PeImage::DataDirectory iat = {};
+    PeImage::DataDirectory resources = {};
+    PeImage::DataDirectory relocations = {};
+};
+
+uint64_t SplitMix(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+template <class T>
+void Put(std::vector<uint8_t>& out, size_t offset, T value) {
+    if (out.size() < offset + sizeof(T)) {
+        out.resize(offset + sizeof(T));
+    }
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+template <class T>
+void Append(std::vector<uint8_t>& out, T value) {
+    Put(out, out.size(), value);
+}
+
+void AppendAscii(std::vector<uint8_t>& out, const char* text) {
+    out.insert(out.end(), text, text + std::strlen(text) + 1);
+}
+
+void AppendUtf16(std::vector<uint8_t>& out, const std::wstring& text, bool terminate = true) {
+    for (wchar_t ch : text) {
+        Append(out, static_cast<uint16_t>(ch));
+    }
+    if (terminate) {
+        Append(out, uint16_t{ 0 });
+    }
+}
+
+void PadTo(std::vector<uint8_t>& out, size_t alignment) {
+    while (out.size() % alignment != 0) {
+        out.push_back(0);
+    }
+}
+
+uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Writes a version block header and key; returns its offset for EndBlock.
+size_t BeginBlock(std::vector<uint8_t>& out, const wchar_t* key, uint16_t valueLength, uint16_t type) {
+    PadTo(out, 4);
+    const size_t start = out.size();
+    Append(out, uint16_t{ 0 });
+    Append(out, valueLength);
+    Append(out, type);
+    AppendUtf16(out, key);
+    PadTo(out, 4);
+    return start;
+}
+
+void EndBlock(std::vector<uint8_t>& out, size_t start) {
+    Put(out, start, static_cast<uint16_t>(out.size() - start));
+}
+
+void AppendString(std::vector<uint8_t>& out, const wchar_t* key, const std::wstring& value, bool terminate) {
+    const size_t length = value.size() + (terminate ? 1 : 0);
+    size_t block = BeginBlock(out, key, static_cast<uint16_t>(length), 1);
+    AppendUtf16(out, value, terminate);
+    EndBlock(out, block);
+}
+
+std::vector<uint8_t> BuildVersionResource(const Options& options) {
+    const bool terminate = options.defect != Defect::UnterminatedStrings;
+    std::vector<uint8_t> out;
+    size_t root = BeginBlock(out, L"VS_VERSION_INFO", 52, 0);
+    Append(out, uint32_t{ 0xFEEF04BD }); // VS_FIXEDFILEINFO.dwSignature
+    Append(out, uint32_t{ 0x00010000 }); // dwStrucVersion
+    Append(out, static_cast<uint32_t>(options.version.fileVersionNumber >> 32)); // dwFileVersionMS
+    Append(out, static_cast<uint32_t>(options.version.fileVersionNumber));       // dwFileVersionLS
+    Append(out, static_cast<uint32_t>(options.version.fileVersionNumber >> 32)); // dwProductVersionMS
+    Append(out, static_cast<uint32_t>(options.version.fileVersionNumber));       // dwProductVersionLS
+    for (int i = 0; i < 7; ++i) {
+        Append(out, uint32_t{ 0 });
+    }
+
+    size_t stringFileInfo = BeginBlock(out, L"StringFileInfo", 0, 1);
+    size_t table = BeginBlock(out, L"040904b0", 0, 1);
+    AppendString(out, L"CompanyName", options.version.companyName, terminate);
+    AppendString(out, L"FileDescription", options.version.description, terminate);
+    AppendString(out, L"FileVersion", options.version.fileVersion, terminate);
+    AppendString(out, L"ProductName", L"Explorer Modules synthetic image", terminate);
+    EndBlock(out, table);
+    EndBlock(out, stringFileInfo);
+
+    size_t varFileInfo = BeginBlock(out, L"VarFileInfo", 0, 1);
+    size_t translation = BeginBlock(out, L"Translation", 4, 0);
+    Append(out, uint16_t{ 0x0409 });
+    Append(out, uint16_t{ 0x04B0 });
+    EndBlock(out, translation);
+    EndBlock(out, varFileInfo);
+
+    EndBlock(out, root);
+    if (options.defect == Defect::VersionLengthOverflow) {
+        Put(out, root, uint16_t{ 0xFFFF });
+    }
+    return out;
+}
+
+// Resource tree with one path: RT_VERSION / 1 / 0x409.
+std::vector<uint8_t> BuildResources(const Options& options, uint32_t rva) {
+    std::vector<uint8_t> out;
+    auto directory = [&out](uint32_t id, uint32_t target) {
+        for (int i = 0; i < 3; ++i) {
+            Append(out, uint32_t{ 0 }); // Characteristics, TimeDateStamp, versions
+        }
+        Append(out, uint16_t{ 0 }); // Named entries
+        Append(out, uint16_t{ 1 }); // Id entries
+        Append(out, id);
+        Append(out, target);
+    };
+    directory(PeImage::kResourceTypeVersion, 0x80000000u | 0x18);
+    directory(1, options.defect == Defect::ResourceLoop ? 0x80000000u : 0x80000000u | 0x30);
+    directory(0x409, 0x48);
+
+    auto version = BuildVersionResource(options);
+    constexpr uint32_t kVersionOffset = 0x58;
+    Append(out, rva + kVersionOffset);
+    Append(out, static_cast<uint32_t>(version.size()));
+    Append(out, uint32_t{ 0 });
+    Append(out, uint32_t{ 0 });
+    out.insert(out.end(), version.begin(), version.end());
+    return out;
+}
+
+// One RT_ICON image: a size x size DIB whose top-left corner is transparent (AND mask set, and alpha 0
+// at 32 bits per pixel). Colours and palette derive from set and size.
+std::vector<uint8_t> BuildIconImage(uint32_t set, uint32_t size, uint16_t bitCount) {
+    uint64_t state = uint64_t{ set } << 32 | size;
+    const uint32_t paletteSize = bitCount <= 8 ? 1u << bitCount : 0;
+    const size_t xorStride = (size_t{ size } * bitCount + 31) / 32 * 4;
+    const size_t andStride = (size_t{ size } + 31) / 32 * 4;
+    // BITMAPINFOHEADER; compression (BI_RGB), resolution and colour counts stay zero.
+    std::vector<uint8_t> out(40, 0);
+    Put(out, 0, uint32_t{ 40 });
+    Put(out, 4, static_cast<int32_t>(size));
+    Put(out, 8, static_cast<int32_t>(size * 2));
+    Put(out, 12, uint16_t{ 1 });
+    Put(out, 14, bitCount);
+    Put(out, 20, static_cast<uint32_t>((xorStride + andStride) * size));
+    for (uint32_t i = 0; i < paletteSize; ++i) {
+        Append(out, static_cast<uint32_t>(SplitMix(state) & 0x00FFFFFF));
+    }
+    const uint32_t base = static_cast<uint32_t>(SplitMix(state));
+    auto transparent = [size](uint32_t x, uint32_t top) { return x + top < size / 4; };
+    const size_t xorOffset = out.size();
+    out.resize(xorOffset + (xorStride + andStride) * size);
+    for (uint32_t row = 0; row < size; ++row) {
+        const uint32_t top = size - 1 - row; // DIB rows run bottom-up
+        uint8_t* pixels = out.data() + xorOffset + row * xorStride;
+        uint8_t* mask = out.data() + xorOffset + xorStride * size + row * andStride;
+        for (uint32_t x = 0; x < size; ++x) {
+            const uint32_t value = base + x * 0x010307 + top * 0x070301;
+            const bool clear = transparent(x, top);
+            if (clear) {
+                mask[x / 8] |= static_cast<uint8_t>(0x80 >> (x % 8));
+            }
+            switch (bitCount) {
+            case 32: {
+                const uint32_t pixel = clear ? 0 : (0xFF000000u | (value & 0x00FFFFFF));
+                std::memcpy(pixels + x * 4, &pixel, 4);
+                break;
+            }
+            case 24:
+                std::memcpy(pixels + x * 3, &value, 3);
+                break;
+            default: {
+                const uint32_t perByte = 8 / bitCount;
+                const uint32_t index = value % paletteSize;
+                pixels[x / perByte] |= static_cast<uint8_t>(index << (8 - bitCount * (x % perByte + 1)));
+                break;
+            }
+            }
+        }
+    }
+    return out;
+}
+
+struct ResourceLeaf {
+    uint32_t type;
+    uint32_t name;
+    std::vector<uint8_t> data;
+};
+
+// Resource tree of integer-named leaves, each in language 0x409. leaves must be sorted by type, then
+// name, as the loader's binary search expects.
+std::vector<uint8_t> BuildResourceTree(const std::vector<ResourceLeaf>& leaves, uint32_t rva) {
+    std::vector<uint32_t> types;
+    for (const auto& leaf : leaves) {
+        if (types.empty() || types.back() != leaf.type) {
+            types.push_back(leaf.type);
+        }
+    }
+    auto countNames = [&leaves](uint32_t type) {
+        return static_cast<uint32_t>(std::count_if(leaves.begin(), leaves.end(),
+            [type](const ResourceLeaf& leaf) { return leaf.type == type; }));
+    };
+    // Directories first (root, types, languages), then data entries, then the data.
+    size_t offset = 16 + 8 * types.size();
+    std::vector<size_t> typeDirectories;
+    for (uint32_t type : types) {
+        typeDirectories.push_back(offset);
+        offset += 16 + 8 * size_t{ countNames(type) };
+    }
+    std::vector<size_t> languageDirectories;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        languageDirectories.push_back(offset);
+        offset += 24;
+    }
+    std::vector<size_t> dataEntries;
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        dataEntries.push_back(offset);
+        offset += 16;
+    }
+    std::vector<uint8_t> out(offset, 0);
+
+    auto directory = [&out](size_t at, uint16_t count) {
+        Put(out, at + 14, count); // Characteristics, TimeDateStamp, versions and named entries stay zero
+        return at + 16;
+    };
+    size_t rootEntry = directory(0, static_cast<uint16_t>(types.size()));
+    size_t leaf = 0;
+    for (size_t t = 0; t < types.size(); ++t) {
+        Put(out, rootEntry, types[t]);
+        Put(out, rootEntry + 4, static_cast<uint32_t>(0x80000000u | typeDirectories[t]));
+        rootEntry += 8;
+        size_t nameEntry = directory(typeDirectories[t], static_cast<uint16_t>(countNames(types[t])));
+        for (; leaf < leaves.size() && leaves[leaf].type == types[t]; ++leaf) {
+            Put(out, nameEntry, leaves[leaf].name);
+            Put(out, nameEntry + 4, static_cast<uint32_t>(0x80000000u | languageDirectories[leaf]));
+            nameEntry += 8;
+            const size_t languageEntry = directory(languageDirectories[leaf], 1);
+            Put(out, languageEntry, uint32_t{ 0x409 });
+            Put(out, languageEntry + 4, static_cast<uint32_t>(dataEntries[leaf]));
+        }
+    }
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        PadTo(out, 8);
+        Put(out, dataEntries[i], static_cast<uint32_t>(rva + out.size()));
+        Put(out, dataEntries[i] + 4, static_cast<uint32_t>(leaves[i].data.size()));
+        out.insert(out.end(), leaves[i].data.begin(), leaves[i].data.end());
+    }
+    return out;
+}
+
+// Icons, a group naming them, and the version resource if there is one.
+std::vector<uint8_t> BuildIconResources(const Options& options, uint32_t rva) {
+    constexpr uint32_t kIconSizes[] = { 16, 32, 48 };
+    std::vector<ResourceLeaf> leaves;
+    std::vector<uint8_t> group;
+    Append(group, uint16_t{ 0 });
+    Append(group, uint16_t{ 1 }); // Icon
+    Append(group, static_cast<uint16_t>(std::size(kIconSizes)));
+    uint16_t id = 1;
+    for (uint32_t size : kIconSizes) {
+        auto image = BuildIconImage(options.iconSet, size, options.iconBitCount);
+        Append(group, static_cast<uint8_t>(size));
+        Append(group, static_cast<uint8_t>(size));
+        Append(group, static_cast<uint8_t>(options.iconBitCount < 8 ? 1u << options.iconBitCount : 0));
+        Append(group, uint8_t{ 0 });
+        Append(group, uint16_t{ 1 }); // Planes
+        Append(group, options.iconBitCount);
+        Append(group, static_cast<uint32_t>(image.size()));
+        Append(group, id);
+        leaves.push_back({ PeIcon::kResourceTypeIcon, id++, std::move(image) });
+    }
+    leaves.push_back({ PeIcon::kResourceTypeGroupIcon, 1, std::move(group) });
+    if (options.versionResource) {
+        leaves.push_back({ PeImage::kResourceTypeVersion, 1, BuildVersionResource(options) });
+    }
+    return BuildResourceTree(leaves, rva);
+}
+
+// IMAGE_EXPORT_DIRECTORY followed by the address, name pointer and ordinal tables, the DLL name and
+// the function names. Names are zero-padded so they are already in the sorted order the loader expects.
+std::vector<uint8_t> BuildExports(const Options& options, uint32_t rva, uint32_t textRva) {
+    const uint32_t count = options.exportCount;
+    const uint32_t functions = 40;
+    const uint32_t names = functions + 4 * count;
+    const uint32_t ordinals = names + 4 * count;
+    const uint32_t dllName = ordinals + 2 * count;
+
+    std::vector<uint8_t> out(dllName, 0);
+    Put(out, 12, rva + dllName);
+    Put(out, 16, uint32_t{ 1 }); // Ordinal base
+    Put(out, 20, count);
+    Put(out, 24, count);
+    Put(out, 28, rva + functions);
+    Put(out, 32, rva + names);
+    Put(out, 36, rva + ordinals);
+    AppendAscii(out, "synthetic.dll");
+
+    for (uint32_t i = 0; i < count; ++i) {
+        char name[24] = {};
+        std::snprintf(name, sizeof(name), "Export%06u", i);
+        const uint32_t nameRva = options.defect == Defect::ExportNamesOutOfRange
+            ? 0x7FFFFF00u + i
+            : rva + static_cast<uint32_t>(out.size());
+        AppendAscii(out, name);
+        Put(out, functions + 4 * i, textRva + (i * 16) % kTextSize);
+        Put(out, names + 4 * i, nameRva);
+        Put(out, ordinals + 2 * i, static_cast<uint16_t>(i));
+    }
+    return out;
+}
+
+// Import descriptors, then every lookup table, every IAT (contiguous, so one IAT directory covers
+// them), the hint/name entries and the DLL names.
+std::vector<uint8_t> BuildImports(const Options& options, uint32_t rva, bool pe32Plus, Directories& directories) {
+    const uint32_t modules = options.importModuleCount;
+    const uint32_t perModule = options.importsPerModule;
+    const uint32_t thunkSize = pe32Plus ? 8 : 4;
+    const uint32_t tableSize = (perModule + 1) * thunkSize;
+    const uint32_t lookupTables = (modules + 1) * 20;
+    const uint32_t addressTables = lookupTables + modules * tableSize;
+    const uint32_t hintNames = addressTables + modules * tableSize;
+
+    std::vector<uint8_t> out(hintNames, 0);
+    for (uint32_t m = 0; m < modules; ++m) {
+        for (uint32_t f = 0; f < perModule; ++f) {
+            PadTo(out, 2);
+            const uint64_t hintName = rva + static_cast<uint32_t>(out.size());
+            Append(out, static_cast<uint16_t>(f));
+            char name[24] = {};
+            std::snprintf(name, sizeof(name), "Export%06u", f);
+            AppendAscii(out, name);
+            const size_t slot = m * static_cast<size_t>(tableSize) + f * static_cast<size_t>(thunkSize);
+            if (pe32Plus) {
+                Put(out, lookupTables + slot, hintName);
+                Put(out, addressTables + slot, hintName);
+            } else {
+                Put(out, lookupTables + slot, static_cast<uint32_t>(hintName));
+                Put(out, addressTables + slot, static_cast<uint32_t>(hintName));
+            }
+        }
+    }
+    for (uint32_t m = 0; m < modules; ++m) {
+        char name[32] = {};
+        std::snprintf(name, sizeof(name), "synthetic-import-%04u.dll", options.firstImportModule + m);
+        const uint32_t nameRva = rva + static_cast<uint32_t>(out.size());
+        AppendAscii(out, name);
+        const size_t descriptor = m * size_t{ 20 };
+        Put(out, descriptor, rva + lookupTables + m * tableSize);
+        Put(out, descriptor + 12, nameRva);
+        Put(out, descriptor + 16, rva + addressTables + m * tableSize);
+    }
+
+    directories.imports = { rva, lookupTables };
+    directories.iat = { rva + addressTables, modules * tableSize };
+    return out;
+}
+
+// The .text section: int3 filler, or pseudo-random bytes for an explicit codeSize, with
+// relocationCount pointer-sized absolute addresses into the section at evenly spaced offsets.
+// Appends the section offset of each to fixups.
+std::vector<uint8_t> BuildCode(const Options& options, uint32_t textRva, uint64_t imageBase, bool pe32Plus,
+    std::vector<uint32_t>& fixups) {
+    const uint32_t size = options.codeSize ? options.codeSize : kTextSize;
+    std::vector<uint8_t> out(size, 0xCC);
+    uint64_t state = size ^ 0x5EED;
+    if (options.codeSize) {
+        for (size_t i = 0; i + 8 <= out.size(); i += 8) {
+            const uint64_t bytes = SplitMix(state);
+            std::memcpy(out.data() + i, &bytes, sizeof(bytes));
+        }
+    }
+
+    const uint32_t width = pe32Plus ? 8 : 4;
+    const uint32_t count = std::min(options.relocationCount, size / width);
+    const uint32_t stride = count ? size / count / width * width : 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t offset = i * stride;
+        const uint64_t target = imageBase + textRva + SplitMix(state) % size;
+        if (pe32Plus) {
+            Put(out, offset, target);
+        } else {
+            Put(out, offset, static_cast<uint32_t>(target));
+        }
+        fixups.push_back(textRva + offset);
+    }
+    return out;
+}
+
+// Base relocation blocks, one per 4 KB page, for ascending fixup RVAs.
+std::vector<uint8_t> BuildRelocations(const std::vector<uint32_t>& fixups, bool pe32Plus) {
+    const uint16_t type = pe32Plus ? kRelocDir64 : kRelocHighLow;
+    std::vector<uint8_t> out;
+    for (size_t i = 0; i < fixups.size();) {
+        const uint32_t page = fixups[i] & ~0xFFFu;
+        const size_t block = out.size();
+        Append(out, page);
+        Append(out, uint32_t{ 0 });
+        for (; i < fixups.size() && (fixups[i] & ~0xFFFu) == page; ++i) {
+            Append(out, static_cast<uint16_t>(type << 12 | (fixups[i] & 0xFFF)));
+        }
+        if (out.size() % 4 != 0) {
+            Append(out, uint16_t{ 0 }); // IMAGE_REL_BASED_ABSOLUTE padding
+        }
+        Put(out, block + 4, static_cast<uint32_t>(out.size() - block));
+    }
+    return out;
+}
+
+const char* FillerName(uint32_t index) {
+    static constexpr const char* kNames[] = { ".text", ".rdata", ".data", ".pdata", ".didat", ".tls", ".00cfg" };
+    return index < std::size(kNames) ? kNames[index] : nullptr;
+}
+
+void ApplyHeaderDefect(std::vector<uint8_t>& image, const Options& options, size_t optional,
+    size_t directoriesOffset, size_t sectionTable, uint32_t sectionCount) {
+    const size_t fileHeader = kNtOffset + 4;
+    switch (options.defect) {
+    case Defect::TruncatedHeaders:
+        image.resize(optional + 32);
+        break;
+    case Defect::BadNtOffset:
+        Put(image, 0x3C, static_cast<uint32_t>(image.size() + 0x100));
+        break;
+    case Defect::SectionCountOverflow:
+        Put(image, fileHeader + 2, static_cast<uint16_t>(kMaxSections));
+        break;
+    case Defect::SectionPastEnd: {
+        const size_t last = sectionTable + (sectionCount - 1) * kSectionHeaderSize;
+        Put(image, last + 16, uint32_t{ 0x10000 });
+        Put(image, last + 20, static_cast<uint32_t>(image.size() - 0x10));
+        break;
+    }
+    case Defect::DirectoryOutOfRange: {
+        uint32_t sizeOfImage = 0;
+        std::memcpy(&sizeOfImage, image.data() + optional + 56, sizeof(sizeOfImage));
+        for (uint32_t index : { PeImage::kDirectoryExport, PeImage::kDirectoryImport, PeImage::kDirectoryResource }) {
+            Put(image, directoriesOffset + index * 8, sizeOfImage + 0x1000);
+            Put(image, directoriesOffset + index * 8 + 4, uint32_t{ 0x100 });
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+} // namespace
+
+const char* DefectName(Defect defect) {
+    switch (defect) {
+    case Defect::None: return "None";
+    case Defect::TruncatedHeaders: return "TruncatedHeaders";
+    case Defect::BadNtOffset: return "BadNtOffset";
+    case Defect::SectionCountOverflow: return "SectionCountOverflow";
+    case Defect::SectionPastEnd: return "SectionPastEnd";
+    case Defect::DirectoryOutOfRange: return "DirectoryOutOfRange";
+    case Defect::ExportNamesOutOfRange: return "ExportNamesOutOfRange";
+    case Defect::ResourceLoop: return "ResourceLoop";
+    case Defect::VersionLengthOverflow: return "VersionLengthOverflow";
+    case Defect::UnterminatedStrings: return "UnterminatedStrings";
+    }
+    return "Unknown";
+}
+
+std::vector<uint8_t> Build(const Options& options) {
+    const bool pe32Plus = options.machine != PeImage::kMachineI386 && options.machine != PeImage::kMachineArm;
+    const uint16_t optionalSize = pe32Plus ? 240 : 224;
+
+    const uint32_t dataSections = (options.exportCount ? 1 : 0) +
+        (options.importModuleCount && options.importsPerModule ? 1 : 0) + (options.versionResource || options.iconSet ? 1 : 0) +
+        (options.relocationCount ? 1 : 0);
+    const uint64_t imageBase = pe32Plus ? 0x180000000 : 0x10000000;
+    const uint32_t requested = std::min(options.sectionCount, kMaxSections);
+    const uint32_t fillerCount = std::max<uint32_t>(1, requested > dataSections ? requested - dataSections : 0);
+    const uint32_t sectionCount = fillerCount + dataSections;
+
+    const size_t optional = kNtOffset + 4 + kFileHeaderSize;
+    const size_t sectionTable = optional + optionalSize;
+    const uint32_t headersSize = AlignUp(static_cast<uint32_t>(sectionTable + sectionCount * kSectionHeaderSize),
+        kFileAlignment);
+
+    // Lay the sections out in address order; each builder needs its own RVA to emit pointers.
+    std::vector<SectionData> sections;
+    sections.reserve(sectionCount);
+    Directories directories;
+    uint32_t rva = AlignUp(headersSize, kSectionAlignment);
+    auto add = [&](const char* name, uint32_t characteristics, std::vector<uint8_t> data) {
+        sections.push_back({ name, characteristics, rva, std::move(data) });
+        rva += AlignUp(std::max<uint32_t>(static_cast<uint32_t>(sections.back().data.size()), 1), kSectionAlignment);
+    };
+
+    const uint32_t textRva = rva;
+    std::vector<uint32_t> fixups;
+    add(".text", kCodeCharacteristics, BuildCode(options, textRva, imageBase, pe32Plus, fixups));
+    for (uint32_t i = 1; i < fillerCount; ++i) {
+        add(FillerName(i), kWritableCharacteristics, std::vector<uint8_t>(0x200, static_cast<uint8_t>(i)));
+    }
+    if (options.exportCount) {
+        const uint32_t exportRva = rva;
+        add(".edata", kDataCharacteristics, BuildExports(options, exportRva, textRva));
+        directories.exports = { exportRva, static_cast<uint32_t>(sections.back().data.size()) };
+    }
+    if (options.importModuleCount && options.importsPerModule) {
+        add(".idata", kWritableCharacteristics, BuildImports(options, rva, pe32Plus, directories));
+    }
+    if (options.versionResource || options.iconSet) {
+        const uint32_t resourceRva = rva;
+        add(".rsrc", kDataCharacteristics,
+            options.iconSet ? BuildIconResources(options, resourceRva) : BuildResources(options, resourceRva));
+        directories.resources = { resourceRva, static_cast<uint32_t>(sections.back().data.size()) };
+    }
+    if (options.relocationCount) {
+        const uint32_t relocationRva = rva;
+        add(".reloc", kRelocCharacteristics, BuildRelocations(fixups, pe32Plus));
+        directories.relocations = { relocationRva, static_cast<uint32_t>(sections.back().data.size()) };
+    }
+    const uint32_t sizeOfImage = rva;
+
+    uint32_t fileSize = headersSize;
+    for (const auto& section : sections) {
+        fileSize += AlignUp(static_cast<uint32_t>(section.data.size()), kFileAlignment);
+    }
+    std::vector<uint8_t> image(fileSize, 0);
+
+    Put(image, 0, uint16_t{ 0x5A4D });
+    Put(image, 0x3C, kNtOffset);
+    Put(image, kNtOffset, uint32_t{ 0x00004550 });
+
+    const size_t fileHeader = kNtOffset + 4;
+    Put(image, fileHeader, options.machine);
+    Put(image, fileHeader + 2, static_cast<uint16_t>(sectionCount));
+    Put(image, fileHeader + 16, optionalSize);
+    // Executable and DLL, plus large-address-aware (PE32+) or 32-bit machine (PE32)
+    Put(image, fileHeader + 18, static_cast<uint16_t>(pe32Plus ? 0x2022 : 0x2102));
+
+    size_t directoriesOffset = 0;
+    if (pe32Plus) {
+        Put(image, optional, PeImage::kOptionalMagicPe32Plus);
+        Put(image, optional + 24, imageBase);
+        Put(image, optional + 70, uint16_t{ 0x0160 }); // High-entropy VA, dynamic base, NX compatible
+        Put(image, optional + 108, PeImage::kDirectoryCount);
+        directoriesOffset = optional + 112;
+    } else {
+        Put(image, optional, PeImage::kOptionalMagicPe32);
+        Put(image, optional + 28, static_cast<uint32_t>(imageBase));
+        Put(image, optional + 70, uint16_t{ 0x0140 }); // Dynamic base, NX compatible
+        Put(image, optional + 92, PeImage::kDirectoryCount);
+        directoriesOffset = optional + 96;
+    }
+    Put(image, optional + 16, textRva); // AddressOfEntryPoint
+    Put(image, optional + 32, kSectionAlignment);
+    Put(image, optional + 36, kFileAlignment);
+    Put(image, optional + 40, uint16_t{ 6 }); // Operating system version 6.0
+    Put(image, optional + 48, uint16_t{ 6 }); // Subsystem version 6.0
+    Put(image, optional + 56, sizeOfImage);
+    Put(image, optional + 60, headersSize);
+    Put(image, optional + 68, uint16_t{ 2 }); // Windows GUI
+
+    auto putDirectory = [&](uint32_t index, PeImage::DataDirectory directory) {
+        Put(image, directoriesOffset + index * 8, directory.rva);
+        Put(image, directoriesOffset + index * 8 + 4, directory.size);
+    };
+    putDirectory(PeImage::kDirectoryExport, directories.exports);
+    putDirectory(PeImage::kDirectoryImport, directories.imports);
+    putDirectory(PeImage::kDirectoryResource, directories.resources);
+    putDirectory(PeImage::kDirectoryBaseReloc, directories.relocations);
+    putDirectory(PeImage::kDirectoryIat, directories.iat);
+
+    uint32_t rawOffset = headersSize;
+    for (size_t i = 0; i < sections.size(); ++i) {
+        const auto& section = sections[i];
+        const size_t header = sectionTable + i * kSectionHeaderSize;
+        const uint32_t rawSize = AlignUp(static_cast<uint32_t>(section.data.size()), kFileAlignment);
+        if (section.name) {
+            std::memcpy(image.data() + header, section.name, std::min<size_t>(std::strlen(section.name), 8));
+        } else {
+            char name[16] = {};
+            std::snprintf(name, sizeof(name), ".s%05u", static_cast<unsigned>(i % 100000));
+            std::memcpy(image.data() + header, name, 8);
+        }
+        Put(image, header + 8, static_cast<uint32_t>(section.data.size()));
+        Put(image, header + 12, section.rva);
+        Put(image, header + 16, rawSize);
+        Put(image, header + 20, rawOffset);
+        Put(image, header + 36, section.characteristics);
+        std::memcpy(image.data() + rawOffset, section.data.data(), section.data.size());
+        rawOffset += rawSize;
+    }
+
+    ApplyHeaderDefect(image, options, optional, directoriesOffset, sectionTable, sectionCount);
+    if (options.checksum) {
+        Put(image, optional + 64, PeChecksum::Compute(image.data(), image.size()));
+    }
+    return image;
+}
+
+bool Write(const std::filesystem::path& path, const std::vector<uint8_t>& image) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+    return static_cast<bool>(file);
+}
+
+std::filesystem::path WriteTemp(const Options& options, const std::string& fileName) {
+    auto path = std::filesystem::temp_directory_path() / fileName;
+    Write(path, Build(options));
+    return path;
+}
+
+Options CorpusOptions(uint64_t seed, size_t index, uint32_t malformedEvery) {
+    static constexpr const wchar_t* kCompanies[] = {
+        L"Contoso Ltd.", L"Fabrikam, Inc.", L"Litware, Inc.", L"Northwind Traders", L"Microsoft Corporation",
+    };
+    static constexpr const wchar_t* kDescriptions[] = {
+        L"Shell extension", L"Rendering plug-in", L"Network client library", L"Search indexer helper",
+        L"Cryptographic provider",
+    };
+
+    uint64_t state = seed ^ (index * 0xD1B54A32D192ED03ull);
+    auto next = [&state](uint64_t bound) { return SplitMix(state) % bound; };
+
+    Options options;
+    const uint64_t machine = next(100);
+    options.machine = machine < 70 ? PeImage::kMachineAmd64
+        : machine < 85 ? PeImage::kMachineI386
+        : machine < 95 ? PeImage::kMachineArm64
+        : PeImage::kMachineArm;
+    options.sectionCount = next(20) == 0 ? static_cast<uint32_t>(16 + next(81)) : static_cast<uint32_t>(3 + next(8));
+
+    const uint64_t exports = next(10);
+    options.exportCount = exports < 4 ? 0 : exports < 9 ? static_cast<uint32_t>(1 + next(200)) : static_cast<uint32_t>(200 + next(4800));
+    options.importModuleCount = static_cast<uint32_t>(1 + next(24));
+    options.importsPerModule = static_cast<uint32_t>(1 + next(64));
+
+    options.versionResource = next(10) != 0;
+    options.version.companyName = kCompanies[next(std::size(kCompanies))];
+    options.version.description = kDescriptions[next(std::size(kDescriptions))];
+    const auto build = static_cast<uint16_t>(10000 + next(20000));
+    const auto revision = static_cast<uint16_t>(next(5000));
+    options.version.fileVersion = L"10.0." + std::to_wstring(build) + L"." + std::to_wstring(revision);
+    options.version.fileVersionNumber = (uint64_t{ 10 } << 48) | (uint64_t{ build } << 16) | revision;
+    // Most real DLLs are relocatable; the .text of a corpus image is small, so this is dense.
+    options.relocationCount = next(4) != 0 ? static_cast<uint32_t>(1 + next(64)) : 0;
+
+    if (malformedEvery && index % malformedEvery == malformedEvery - 1) {
+        options.defect = kAllDefects[(index / malformedEvery) % std::size(kAllDefects)];
+        // Version and export defects need something to corrupt.
+        options.versionResource = true;
+        options.exportCount = std::max<uint32_t>(options.exportCount, 8);
+    }
+    return options;
+}
+
+void Mutate(std::vector<uint8_t>& image, uint64_t seed, uint32_t flips) {
+    if (image.empty()) {
+        return;
+    }
+    static constexpr uint8_t kBoundaries[] = { 0x00, 0x7F, 0x80, 0xFF };
+    uint64_t state = seed;
+    const size_t headerSpan = std::min<size_t>(image.size(), 0x1000);
+    for (uint32_t i = 0; i < flips; ++i) {
+        const uint64_t choice = SplitMix(state);
+        const size_t span = (choice & 3) != 0 ? headerSpan : image.size();
+        const size_t offset = static_cast<size_t>(SplitMix(state) % span);
+        image[offset] = (choice & 4) != 0 ? kBoundaries[(choice >> 3) & 3] : static_cast<uint8_t>(choice >> 8);
+    }
+}
+
+} // namespace SyntheticPe
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "PeImage.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Generator for synthetic PE32/PE32+ DLL images, well-formed or deliberately broken, so the parsers can
+// be benchmarked and fuzzed at scales we cannot reproduce with real machines. Images are laid out as
+// files on disk; they are never meant to be loaded.
+namespace SyntheticPe {
+
+struct VersionStrings {
+    std::wstring companyName;
+    std::wstring description;
+    std::wstring fileVersion;
+    uint64_t fileVersionNumber = 0; // VS_FIXEDFILEINFO file version, as PeImage::ImageInfo holds it
+};
+
+// Each defect targets one bounds check in the parsers. Generated images are otherwise well-formed.
+enum class Defect {
+    None,
+    TruncatedHeaders,      // File ends inside the optional header
+    BadNtOffset,           // e_lfanew points past the end of the file
+    SectionCountOverflow,  // NumberOfSections runs the section table past the end of the file
+    SectionPastEnd,        // The last section's raw data runs past the end of the file
+    DirectoryOutOfRange,   // Export, import and resource directories point outside every section
+    ExportNamesOutOfRange, // Export name pointers point outside the image
+    ResourceLoop,          // The resource name level points back at the root directory
+    VersionLengthOverflow, // VS_VERSIONINFO claims to be longer than the resource
+    UnterminatedStrings,   // Version string values have no NUL terminator
+};
+
+constexpr Defect kAllDefects[] = {
+    Defect::TruncatedHeaders,
+    Defect::BadNtOffset,
+    Defect::SectionCountOverflow,
+    Defect::SectionPastEnd,
+    Defect::DirectoryOutOfRange,
+    Defect::ExportNamesOutOfRange,
+    Defect::ResourceLoop,
+    Defect::VersionLengthOverflow,
+    Defect::UnterminatedStrings,
+};
+
+const char* DefectName(Defect defect);
+
+struct Options {
+    /// PeImage::kMachine*. I386 and ARM produce PE32; everything else PE32+.
+    uint16_t machine = PeImage::kMachineAmd64;
+    /// Total sections. .edata, .idata and .rsrc count towards it when present; filler sections (.text
+    /// first) make up the rest. There is always at least a .text section.
+    uint32_t sectionCount = 1;
+    uint32_t exportCount = 0;
+    /// Imported DLLs are named synthetic-import-NNNN.dll, NNNN counting up from firstImportModule, and
+    /// each imports Export000000 onwards by name, so images with enough exports can stand in for them.
+    uint32_t importModuleCount = 0;
+    uint32_t importsPerModule = 0;
+    uint32_t firstImportModule = 0;
+    /// Size of .text; 0 for a small block of int3 filler. A larger section gets pseudo-random bytes.
+    uint32_t codeSize = 0;
+    /// Absolute pointers spread through .text, each with a base relocation in a .reloc section (which
+    /// counts towards sectionCount like the other data sections).
+    uint32_t relocationCount = 0;
+    bool versionResource = true;
+    /// Nonzero for an RT_GROUP_ICON with 16, 32 and 48 pixel images at iconBitCount (1, 4, 8, 24 or 32)
+    /// bits per pixel. The pixels derive from iconSet alone, so images with the same iconSet carry
+    /// byte-identical icons.
+    uint32_t iconSet = 0;
+    uint16_t iconBitCount = 32;
+    VersionStrings version = { L"Contoso Ltd.", L"Contoso synthetic module", L"10.0.22621.1", 0x000A0000585D0001 };
+    /// Stamp the optional header's CheckSum, as link /release does; otherwise it is left zero.
+    bool checksum = false;
+    Defect defect = Defect::None;
+};
+
+std::vector<uint8_t> Build(const Options& options);
+
+/// @brief Writes image to path, replacing any existing file. Returns false on I/O failure.
+bool Write(const std::filesystem::path& path, const std::vector<uint8_t>& image);
+
+/// @brief Writes Build(options) to a file in the temp directory and returns its path.
+std::filesystem::path WriteTemp(const Options& options, const std::string& fileName);
+
+/// @brief Options for the index-th image of a corpus, drawn deterministically from seed with a realistic
+/// spread of machines, section counts and table sizes. With malformedEvery > 0, every malformedEvery-th
+/// image carries a defect, cycling through kAllDefects.
+Options CorpusOptions(uint64_t seed, size_t index, uint32_t malformedEvery);
+
+/// @brief Overwrites flips bytes with random or boundary values (0x00, 0x7F, 0x80, 0xFF), mostly in
+/// the first 4 KB where the headers and tables live. Deterministic for a given seed.
+void Mutate(std::vector<uint8_t>& image, uint64_t seed, uint32_t flips);
+
+} // namespace SyntheticPe
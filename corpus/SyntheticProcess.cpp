@@ -0,0 +1,287 @@
+#include "SyntheticProcess.h"
+
+#include "PeImage.h"
+#include "SyntheticPe.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+#include <iterator>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace SyntheticProcess {
+namespace {
+
+constexpr uint64_t kFirstBase = 0x00007FF800000000ull;
+constexpr uint64_t kAllocationGranularity = 0x10000;
+
+// Unbacked targets for patched entries: low addresses, below every module.
+constexpr uint64_t kTrampolines = 0x10000;
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Applies the base relocations of a mapped 64-bit image for loading at base.
+void Relocate(std::vector<uint8_t>& mapped, uint64_t base) {
+    const PeImage::View view(mapped.data(), mapped.size(), PeImage::Layout::Mapped);
+    const uint64_t delta = base - view.ImageBase();
+    const auto directory = view.Directory(PeImage::kDirectoryBaseReloc);
+    for (uint32_t block = directory.rva; directory.rva != 0 && block + 8 <= directory.rva + directory.size;) {
+        const uint8_t* header = view.AtRva(block, 8);
+        const uint32_t blockSize = header ? PeImage::ReadAt<uint32_t>(header, 4) : 0;
+        if (blockSize < 8) {
+            return;
+        }
+        const uint32_t page = PeImage::ReadAt<uint32_t>(header, 0);
+        for (uint32_t entry = block + 8; entry + 2 <= block + blockSize; entry += 2) {
+            const uint16_t fixup = PeImage::ReadAt<uint16_t>(mapped.data(), entry);
+            const uint32_t rva = page + (fixup & 0xFFF);
+            if (fixup >> 12 == 10 && rva + 8 <= mapped.size()) { // IMAGE_REL_BASED_DIR64
+                const uint64_t value = PeImage::ReadAt<uint64_t>(mapped.data(), rva) + delta;
+                std::memcpy(mapped.data() + rva, &value, sizeof(value));
+            }
+        }
+        block += blockSize;
+    }
+}
+
+// Lays a file image out as the loader would: headers, then each section at its RVA.
+std::vector<uint8_t> Map(const std::vector<uint8_t>& file) {
+    const PeImage::View view(file.data(), file.size());
+    std::vector<uint8_t> mapped(view.SizeOfImage(), 0);
+    std::memcpy(mapped.data(), file.data(), std::min<size_t>({ view.SizeOfHeaders(), file.size(), mapped.size() }));
+    for (uint32_t i = 0; i < view.SectionCount(); ++i) {
+        const auto section = view.SectionAt(i);
+        if (section.virtualAddress >= mapped.size() || section.pointerToRawData >= file.size()) {
+            continue;
+        }
+        const size_t length = std::min<size_t>({ section.sizeOfRawData, mapped.size() - section.virtualAddress,
+            file.size() - section.pointerToRawData });
+        std::memcpy(mapped.data() + section.virtualAddress, file.data() + section.pointerToRawData, length);
+    }
+    return mapped;
+}
+
+std::string CString(const PeImage::View& view, uint32_t rva) {
+    const uint8_t* start = view.AtRva(rva, 1);
+    if (!start) {
+        return {};
+    }
+    const size_t limit = view.Size() - (start - view.Data());
+    const auto* nul = static_cast<const uint8_t*>(std::memchr(start, 0, limit));
+    return std::string(reinterpret_cast<const char*>(start), nul ? static_cast<size_t>(nul - start) : 0);
+}
+
+std::unordered_map<std::string, uint32_t> ReadExports(const PeImage::View& view) {
+    std::unordered_map<std::string, uint32_t> exports;
+    const auto directory = view.Directory(PeImage::kDirectoryExport);
+    const uint8_t* header = directory.rva ? view.AtRva(directory.rva, 40) : nullptr;
+    if (!header) {
+        return exports;
+    }
+    const uint32_t names = PeImage::ReadAt<uint32_t>(header, 24);
+    for (uint32_t i = 0; i < names; ++i) {
+        const uint8_t* name = view.AtRva(PeImage::ReadAt<uint32_t>(header, 32) + i * 4, 4);
+        const uint8_t* ordinal = view.AtRva(PeImage::ReadAt<uint32_t>(header, 36) + i * 2, 2);
+        const uint8_t* function = ordinal
+            ? view.AtRva(PeImage::ReadAt<uint32_t>(header, 28) + PeImage::ReadAt<uint16_t>(ordinal, 0) * 4u, 4) : nullptr;
+        if (name && function) {
+            exports.emplace(CString(view, PeImage::ReadAt<uint32_t>(name, 0)), PeImage::ReadAt<uint32_t>(function, 0));
+        }
+    }
+    return exports;
+}
+
+// Calls visit(descriptor name RVA, IAT slot RVA, lookup thunk) for every import of a mapped 64-bit image.
+template <class Visit>
+void ForEachImport(const PeImage::View& view, Visit visit) {
+    const auto directory = view.Directory(PeImage::kDirectoryImport);
+    for (uint32_t descriptor = directory.rva; directory.rva != 0; descriptor += 20) {
+        const uint8_t* data = view.AtRva(descriptor, 20);
+        if (!data || PeImage::ReadAt<uint32_t>(data, 12) == 0) {
+            return;
+        }
+        const uint32_t lookup = PeImage::ReadAt<uint32_t>(data, 0);
+        const uint32_t addresses = PeImage::ReadAt<uint32_t>(data, 16);
+        for (uint32_t slot = 0;; ++slot) {
+            const uint8_t* thunk = view.AtRva(lookup + slot * 8, 8);
+            if (!thunk || PeImage::ReadAt<uint64_t>(thunk, 0) == 0) {
+                break;
+            }
+            visit(PeImage::ReadAt<uint32_t>(data, 12), addresses + slot * 8, PeImage::ReadAt<uint64_t>(thunk, 0));
+        }
+    }
+}
+
+std::wstring LowerFileName(const std::wstring& path) {
+    std::wstring name = path.substr(path.find_last_of(L'\\') + 1);
+    std::transform(name.begin(), name.end(), name.begin(), [](wchar_t ch) {
+        return ch >= L'A' && ch <= L'Z' ? static_cast<wchar_t>(ch - L'A' + L'a') : ch;
+    });
+    return name;
+}
+
+constexpr uint32_t kCodeSiteSpacing = 64; // Far enough apart that no two patches read as one range
+
+struct CodeSite {
+    size_t image;
+    uint32_t rva;
+};
+
+// count distinct kCodeSiteSpacing-aligned spots in the images' .text sections, drawn from random.
+std::vector<CodeSite> PickCodeSites(const std::vector<Image>& images, size_t count, std::mt19937_64& random) {
+    std::vector<CodeSite> sites;
+    for (size_t i = 0; i < images.size(); ++i) {
+        const PeImage::View view(images[i].mapped.data(), images[i].mapped.size(), PeImage::Layout::Mapped);
+        if (view.SectionCount() == 0) {
+            continue;
+        }
+        const auto text = view.SectionAt(0);
+        for (uint32_t offset = 0; offset + kCodeSiteSpacing <= text.virtualSize; offset += kCodeSiteSpacing) {
+            sites.push_back({ i, text.virtualAddress + offset });
+        }
+    }
+    count = std::min(count, sites.size());
+    for (size_t n = 0; n < count; ++n) {
+        std::swap(sites[n], sites[n + random() % (sites.size() - n)]);
+    }
+    sites.resize(count);
+    return sites;
+}
+
+} // namespace
+
+std::vector<Image> Build(const Options& options) {
+    const uint32_t importModules = options.modules > 1
+        ? static_cast<uint32_t>(std::min<size_t>(options.importModules, options.modules - 1)) : 0;
+    std::vector<Image> images(options.modules);
+    std::vector<std::unordered_map<std::string, uint32_t>> exports(options.modules);
+    std::unordered_map<std::wstring, size_t> byName;
+
+    uint64_t base = kFirstBase;
+    for (size_t i = 0; i < options.modules; ++i) {
+        SyntheticPe::Options pe;
+        pe.sectionCount = 4;
+        pe.exportCount = options.exportsPerModule;
+        pe.importModuleCount = importModules;
+        pe.importsPerModule = std::min(options.importsPerModule, options.exportsPerModule);
+        pe.firstImportModule = static_cast<uint32_t>((i * 7919 + options.seed) % (options.modules - importModules + 1));
+        pe.versionResource = false;
+        pe.codeSize = options.codeSize;
+        pe.relocationCount = options.relocations;
+
+        wchar_t path[96] = {};
+        std::swprintf(path, std::size(path), L"C:\\Windows\\System32\\synthetic-import-%04u.dll", static_cast<unsigned>(i));
+        images[i].path = path;
+        images[i].base = base;
+        images[i].file = SyntheticPe::Build(pe);
+        images[i].mapped = Map(images[i].file);
+        Relocate(images[i].mapped, base);
+        exports[i] = ReadExports(PeImage::View(images[i].mapped.data(), images[i].mapped.size(), PeImage::Layout::Mapped));
+        byName.emplace(LowerFileName(images[i].path), i);
+        // Leave a gap, so the address just past a module belongs to no module.
+        base += AlignUp(images[i].mapped.size(), kAllocationGranularity) + kAllocationGranularity;
+    }
+
+    for (auto& image : images) {
+        const PeImage::View view(image.mapped.data(), image.mapped.size(), PeImage::Layout::Mapped);
+        ForEachImport(view, [&](uint32_t nameRva, uint32_t slot, uint64_t lookup) {
+            const std::string dll = CString(view, nameRva);
+            const auto target = byName.find(std::wstring(dll.begin(), dll.end()));
+            if (target == byName.end()) {
+                return;
+            }
+            const auto function = exports[target->second].find(CString(view, static_cast<uint32_t>(lookup + 2)));
+            if (function != exports[target->second].end()) {
+                const uint64_t address = images[target->second].base + function->second;
+                std::memcpy(image.mapped.data() + slot, &address, sizeof(address));
+            }
+        });
+    }
+    return images;
+}
+
+size_t Hook(std::vector<Image>& images, size_t count, uint64_t seed) {
+    struct Candidate {
+        size_t image;
+        uint32_t rva;
+        bool import;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < images.size(); ++i) {
+        const PeImage::View view(images[i].mapped.data(), images[i].mapped.size(), PeImage::Layout::Mapped);
+        ForEachImport(view, [&](uint32_t, uint32_t slot, uint64_t) {
+            candidates.push_back({ i, slot, true });
+        });
+        const auto directory = view.Directory(PeImage::kDirectoryExport);
+        if (const uint8_t* header = directory.rva ? view.AtRva(directory.rva, 40) : nullptr) {
+            for (uint32_t f = 0; f < PeImage::ReadAt<uint32_t>(header, 20); ++f) {
+                candidates.push_back({ i, PeImage::ReadAt<uint32_t>(header, 28) + f * 4, false });
+            }
+        }
+    }
+
+    std::mt19937_64 random(seed);
+    count = std::min(count, candidates.size());
+    for (size_t n = 0; n < count; ++n) {
+        std::swap(candidates[n], candidates[n + random() % (candidates.size() - n)]);
+        const Candidate& hook = candidates[n];
+        Image& image = images[hook.image];
+        // Half go into another module (its headers, where no export points), half outside every module.
+        const bool redirect = (random() & 1) && images.size() > 1;
+        if (hook.import) {
+            const size_t other = redirect ? (hook.image + 1 + random() % (images.size() - 1)) % images.size() : hook.image;
+            const uint64_t address = redirect ? images[other].base + 8 : kTrampolines + n * 16;
+            std::memcpy(image.mapped.data() + hook.rva, &address, sizeof(address));
+        } else {
+            // An export RVA is relative to its own module, so it can only reach modules above it.
+            const bool above = hook.image + 1 < images.size();
+            const uint64_t target = redirect && above ? images[hook.image + 1].base + 8 : image.base + image.mapped.size() + 0x8000;
+            const auto rva = static_cast<uint32_t>(target - image.base);
+            std::memcpy(image.mapped.data() + hook.rva, &rva, sizeof(rva));
+        }
+    }
+    return count;
+}
+
+size_t PatchCode(std::vector<Image>& images, size_t count, uint64_t seed) {
+    std::mt19937_64 random(seed);
+    const auto sites = PickCodeSites(images, count, random);
+    for (const auto& site : sites) {
+        uint8_t* code = images[site.image].mapped.data() + site.rva;
+        // jmp rel32; every byte is forced to differ from the original so each patch is exactly 5 bytes.
+        uint8_t patch[5] = { 0xE9 };
+        const auto displacement = static_cast<uint32_t>(random());
+        std::memcpy(patch + 1, &displacement, sizeof(displacement));
+        for (size_t b = 0; b < sizeof(patch); ++b) {
+            code[b] = patch[b] != code[b] ? patch[b] : static_cast<uint8_t>(~code[b]);
+        }
+    }
+    return sites.size();
+}
+
+size_t Plant(std::vector<Image>& images, const std::vector<uint8_t>& bytes, size_t count, uint64_t seed) {
+    if (bytes.empty() || bytes.size() > kCodeSiteSpacing) {
+        return 0;
+    }
+    std::mt19937_64 random(seed);
+    const auto sites = PickCodeSites(images, count, random);
+    for (const auto& site : sites) {
+        std::memcpy(images[site.image].mapped.data() + site.rva, bytes.data(), bytes.size());
+    }
+    return sites.size();
+}
+
+std::vector<HookScan::Module> Modules(const std::vector<Image>& images) {
+    std::vector<HookScan::Module> modules;
+    modules.reserve(images.size());
+    for (const auto& image : images) {
+        modules.push_back({ image.path, image.base, image.mapped.data(), image.mapped.size() });
+    }
+    return modules;
+}
+
+} // namespace SyntheticProcess
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "HookScan.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A fake process for HookScan: SyntheticPe images mapped as the loader would (sections at their RVAs)
+// at distinct base addresses, with every import bound to the exporting module's address. Binding is done
+// here from the file images, independently of HookScan's own export resolution, so the two check each
+// other. Relocations are applied for the new base, as the loader would. Hook then patches import and
+// export table entries the way hooking code does, PatchCode patches code, and Plant writes known bytes.
+namespace SyntheticProcess {
+
+struct Options {
+    size_t modules = 400;
+    uint32_t exportsPerModule = 200;
+    uint32_t importModules = 8;     // DLLs each module imports from
+    uint32_t importsPerModule = 32; // Functions imported from each of them; at most exportsPerModule
+    uint32_t codeSize = 0;          // SyntheticPe::Options::codeSize
+    uint32_t relocations = 0;       // Absolute pointers in .text, applied for the new base when mapping
+    uint64_t seed = 1;
+};
+
+struct Image {
+    std::wstring path; // ...\synthetic-import-NNNN.dll, the name other modules import it by
+    uint64_t base = 0;
+    std::vector<uint8_t> file;   // The image as it is on disk
+    std::vector<uint8_t> mapped; // SizeOfImage bytes
+};
+
+std::vector<Image> Build(const Options& options);
+
+/// @brief Redirects count distinct IAT slots and EAT entries, chosen from seed: some into another
+/// module, some outside every module. Returns how many entries were patched.
+size_t Hook(std::vector<Image>& images, size_t count, uint64_t seed);
+
+/// @brief Overwrites count distinct 64-byte-aligned spots in the images' .text sections with a 5-byte
+/// relative jump, as inline hooks do. Returns how many were patched.
+size_t PatchCode(std::vector<Image>& images, size_t count, uint64_t seed);
+
+/// @brief Copies bytes (at most 64) verbatim to count distinct such spots, planting a known signature.
+/// Returns how many were written.
+size_t Plant(std::vector<Image>& images, const std::vector<uint8_t>& bytes, size_t count, uint64_t seed);
+
+/// @brief The images as HookScan sees them; they point into images, which must outlive the result.
+std::vector<HookScan::Module> Modules(const std::vector<Image>& images);
+
+} // namespace SyntheticProcess
@@ -0,0 +1,187 @@
+#include "AddressSpace.h"
+
+#include <algorithm>
+
+namespace AddressSpace {
+namespace {
+
+constexpr uint32_t kNoSection = UINT32_MAX;
+
+// A run of one module's image: a section, or the gap before, between or after them.
+struct Interval {
+    uint64_t begin;
+    uint64_t end;
+    uint32_t module;
+    uint32_t section; // kNoSection for a gap
+};
+
+void Add(Usage& usage, Platform::RegionUse use, uint64_t bytes) {
+    switch (use) {
+    case Platform::RegionUse::Reserved:
+        return;
+    case Platform::RegionUse::Shared:
+        break;
+    case Platform::RegionUse::CopyOnWrite:
+        usage.copyOnWrite += bytes;
+        break;
+    case Platform::RegionUse::Private:
+        usage.privateBytes += bytes;
+        break;
+    }
+    usage.committed += bytes;
+}
+
+std::wstring Kilobytes(uint64_t bytes) {
+    return std::to_wstring((bytes + 1023) / 1024) + L" KB";
+}
+
+} // namespace
+
+Usage& Usage::operator+=(const Usage& other) {
+    committed += other.committed;
+    privateBytes += other.privateBytes;
+    copyOnWrite += other.copyOnWrite;
+    return *this;
+}
+
+std::vector<Section> Sections(const PeImage::View& view, uint64_t pageSize) {
+    std::vector<Section> sections;
+    if (!view.IsValid() || pageSize == 0) {
+        return sections;
+    }
+    const uint64_t imageSize = view.SizeOfImage();
+    const auto pages = [pageSize, imageSize](uint64_t rva, uint64_t size) {
+        return static_cast<uint32_t>(std::min((size + pageSize - 1) / pageSize * pageSize, imageSize - rva));
+    };
+    sections.reserve(view.SectionCount() + 1);
+    for (uint32_t i = 0; i < view.SectionCount(); ++i) {
+        const PeImage::Section header = view.SectionAt(i);
+        if (header.virtualAddress >= imageSize) {
+            continue;
+        }
+        Section section;
+        section.name.assign(header.name, std::find(header.name, header.name + sizeof(header.name), '\0'));
+        section.rva = header.virtualAddress;
+        section.size = pages(header.virtualAddress, header.virtualSize ? header.virtualSize : header.sizeOfRawData);
+        sections.push_back(std::move(section));
+    }
+    std::sort(sections.begin(), sections.end(), [](const Section& a, const Section& b) { return a.rva < b.rva; });
+    const uint32_t headers = sections.empty() ? pages(0, view.SizeOfHeaders()) : sections.front().rva;
+    if (headers) {
+        Section section;
+        section.name = "(headers)";
+        section.size = headers;
+        sections.insert(sections.begin(), std::move(section));
+    }
+    return sections;
+}
+
+Map::Map(std::vector<Module> modules, const std::vector<Platform::MemoryRegion>& regions) : modules_(std::move(modules)) {
+    std::sort(modules_.begin(), modules_.end(), [](const Module& a, const Module& b) { return a.base < b.base; });
+
+    // Cover every module, in address order, with its sections and the gaps between them.
+    std::vector<Interval> intervals;
+    for (uint32_t m = 0; m < modules_.size(); ++m) {
+        const Module& module = modules_[m];
+        uint64_t end = module.base + module.size;
+        if (m + 1 < modules_.size()) {
+            end = std::min(end, modules_[m + 1].base);
+        }
+        uint64_t cursor = module.base;
+        for (uint32_t s = 0; s < module.sections.size() && cursor < end; ++s) {
+            const Section& section = module.sections[s];
+            const uint64_t begin = std::max(module.base + section.rva, cursor);
+            const uint64_t last = std::min(module.base + section.rva + section.size, end);
+            if (begin >= last) {
+                continue;
+            }
+            if (begin > cursor) {
+                intervals.push_back({ cursor, begin, m, kNoSection });
+            }
+            intervals.push_back({ begin, last, m, s });
+            cursor = last;
+        }
+        if (cursor < end) {
+            intervals.push_back({ cursor, end, m, kNoSection });
+        }
+    }
+
+    // Both lists are ascending: each step finishes a region or an interval, so the sweep is linear.
+    size_t r = 0;
+    size_t i = 0;
+    while (r < regions.size() && i < intervals.size()) {
+        const Platform::MemoryRegion& region = regions[r];
+        const Interval& interval = intervals[i];
+        const uint64_t regionEnd = region.base + region.size;
+        const uint64_t begin = std::max(region.base, interval.begin);
+        const uint64_t end = std::min(regionEnd, interval.end);
+        if (begin < end) {
+            Module& module = modules_[interval.module];
+            Add(module.usage, region.use, end - begin);
+            if (interval.section != kNoSection) {
+                Add(module.sections[interval.section].usage, region.use, end - begin);
+            }
+        }
+        if (regionEnd <= interval.end) {
+            ++r;
+        } else {
+            ++i;
+        }
+    }
+
+    stats_.regions = regions.size();
+    stats_.intervals = intervals.size();
+    for (const auto& module : modules_) {
+        stats_.imageBytes += module.usage.committed;
+    }
+}
+
+const Module* Map::Find(uint64_t base) const {
+    const auto module = std::lower_bound(modules_.begin(), modules_.end(), base,
+        [](const Module& entry, uint64_t value) { return entry.base < value; });
+    return module != modules_.end() && module->base == base ? &*module : nullptr;
+}
+
+size_t Map::Bytes() const {
+    size_t bytes = modules_.capacity() * sizeof(Module);
+    for (const auto& module : modules_) {
+        bytes += module.sections.capacity() * sizeof(Section);
+    }
+    return bytes;
+}
+
+std::wstring FormatCommitted(const Usage& usage) {
+    return Kilobytes(usage.committed);
+}
+
+std::wstring FormatPrivate(const Usage& usage) {
+    if (usage.committed == 0) {
+        return {};
+    }
+    return Kilobytes(usage.privateBytes) + L" / " + Kilobytes(usage.copyOnWrite);
+}
+
+ImageTree::Listing Describe(const Module& module) {
+    ImageTree::Listing listing;
+    const auto row = [&listing](std::wstring name, const Usage& usage) {
+        listing.entries.push_back({ std::move(name),
+            { Kilobytes(usage.committed), Kilobytes(usage.privateBytes), Kilobytes(usage.copyOnWrite) } });
+    };
+    Usage sections;
+    for (const auto& section : module.sections) {
+        std::wstring name;
+        for (const char c : section.name) {
+            name.push_back(static_cast<unsigned char>(c));
+        }
+        row(std::move(name), section.usage);
+        sections += section.usage;
+    }
+    const Usage other{ module.usage.committed - sections.committed, module.usage.privateBytes - sections.privateBytes,
+        module.usage.copyOnWrite - sections.copyOnWrite };
+    if (other.committed) {
+        row(L"(other)", other);
+    }
+    return listing;
+}
+
+} // namespace AddressSpace
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "ImageTree.h"
+#include "PeImage.h"
+#include "Platform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Committed memory attributed to the sections of each loaded module. One walk of the address space
+// (Platform::WalkAddressSpace) yields its regions in ascending order; the modules' sections, sorted
+// the same way, form a list of intervals. A two-pointer sweep over both lists attributes every region
+// to the intervals it overlaps, so the cost is linear in regions plus intervals, with no per-module
+// query.
+namespace AddressSpace {
+
+struct Usage {
+    uint64_t committed = 0;    // Bytes, whatever their use
+    uint64_t privateBytes = 0; // Of those, this process's own: written copies and writable data
+    uint64_t copyOnWrite = 0;  // Of those, still shared but to be copied on the first write
+
+    Usage& operator+=(const Usage& other);
+    bool operator==(const Usage&) const = default;
+};
+
+struct Section {
+    std::string name;  // As in the section table, or "(headers)"
+    uint32_t rva = 0;
+    uint32_t size = 0; // Mapped size, in whole pages
+    Usage usage;
+};
+
+struct Module {
+    uint64_t base = 0;
+    uint64_t size = 0;             // SizeOfImage
+    std::vector<Section> sections; // Sorted by rva, as Sections returns them
+    Usage usage;                   // The whole image, sections or not
+};
+
+/// @brief The headers and sections of an image as mapped: "(headers)" from 0 to the first section,
+/// then each section rounded up to whole pages and clipped to SizeOfImage. Empty for an invalid view.
+std::vector<Section> Sections(const PeImage::View& view, uint64_t pageSize);
+
+// The modules with their usage filled in, sorted by base.
+class Map {
+public:
+    struct Stats {
+        size_t regions = 0;
+        size_t intervals = 0;  // Sections, plus the gaps between them
+        uint64_t imageBytes = 0; // Committed bytes attributed to some module
+    };
+
+    Map() = default;
+
+    /// @brief Attributes regions, ascending and non-overlapping as a walk returns them, to modules in
+    /// any order. Overlapping images (never seen in practice) end where the next one starts.
+    Map(std::vector<Module> modules, const std::vector<Platform::MemoryRegion>& regions);
+
+    const std::vector<Module>& Modules() const { return modules_; }
+
+    /// @brief The module loaded at base, or null.
+    const Module* Find(uint64_t base) const;
+
+    Stats GetStats() const { return stats_; }
+
+    /// @brief Approximate bytes held by the modules and their section lists.
+    size_t Bytes() const;
+
+private:
+    std::vector<Module> modules_;
+    Stats stats_;
+};
+
+/// @brief Column text: "1234 KB" committed.
+std::wstring FormatCommitted(const Usage& usage);
+
+/// @brief Column text: "80 KB / 12 KB", private then copy-on-write, or empty when nothing is committed.
+std::wstring FormatPrivate(const Usage& usage);
+
+/// @brief The per-section detail view of a module: name | committed | private | copy-on-write, with a
+/// final "(other)" row for committed pages outside every section.
+ImageTree::Listing Describe(const Module& module);
+
+} // namespace AddressSpace
@@ -1,6 +1,7 @@
 #include "ModuleFolder.h"
 #include "IidNames.h"
 #include "Log.h"
+#include "QiProfiler.h"
 #include <wrl.h>
 #include <wrl/module.h>
 
@@ -12,24 +13,28 @@ using Microsoft::WRL::RuntimeClassFlags;
 class ModuleFolderClassFactory final
     : public RuntimeClass<RuntimeClassFlags<Microsoft::WRL::ClassicCom>, IClassFactory> {
 public:
-    IFACEMETHODIMP CreateInstance(IUnknown* outer, REFIID riid, void** ppv) override {
-        auto iidText = IidNames::ToString(riid);
+    IFACEMETHODIMP QueryInterface(REFIID riid, void** ppv) override {
+        HRESULT hr = RuntimeClass::QueryInterface(riid, ppv);
+        QiProfiler::Record(QiProfiler::Source::ClassFactory, IidNames::ToGuid(riid), SUCCEEDED(hr));
+        return hr;
+    }
 
-        Log::Write(Log::Level::Trace, L"ClassFactory::CreateInstance called (riid=%s)", iidText.c_str());
+    IFACEMETHODIMP CreateInstance(IUnknown* outer, REFIID riid, void** ppv) override {
+        LOG_TRACE(L"ClassFactory::CreateInstance called (riid={})", IidNames::ToString(riid));
 
         if (outer != nullptr) {
-            Log::Write(Log::Level::Warn, L"ClassFactory::CreateInstance aggregation not supported");
+            LOG_WARN(L"ClassFactory::CreateInstance aggregation not supported");
             return CLASS_E_NOAGGREGATION;
         }
         auto folder = Make<ModuleFolder>();
         if (!folder) {
-            Log::Write(Log::Level::Error, L"ClassFactory::CreateInstance out of memory");
+            LOG_ERROR(L"ClassFactory::CreateInstance out of memory");
             return E_OUTOFMEMORY;
         }
         HRESULT hr = folder.CopyTo(riid, ppv);
         if (!SUCCEEDED(hr))
         {
-            Log::Write(Log::Level::Error, L"ClassFactory::CreateInstance hr=0x%08X", hr);
+            LOG_ERROR(L"ClassFactory::CreateInstance hr=0x{:08X}", static_cast<unsigned long>(hr));
         }
         return hr;
     }
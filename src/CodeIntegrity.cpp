@@ -0,0 +1,405 @@
+#include "CodeIntegrity.h"
+
+#include "PeImage.h"
+#include "Platform.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <semaphore>
+#include <thread>
+
+#if defined(EXPLORER_MODULES_X64)
+#include <immintrin.h>
+#endif
+
+namespace CodeIntegrity {
+namespace {
+
+// Changed bytes separated by fewer equal bytes than this are reported as one range, so a patched
+// instruction with an unchanged byte in the middle is not split.
+constexpr size_t kMergeGap = 8;
+
+constexpr uint32_t kSectionCode = 0x00000020;    // IMAGE_SCN_CNT_CODE
+constexpr uint32_t kSectionExecute = 0x20000000; // IMAGE_SCN_MEM_EXECUTE
+
+constexpr uint16_t kRelocAbsolute = 0;
+constexpr uint16_t kRelocHighLow = 3;
+constexpr uint16_t kRelocHighAdj = 4;
+constexpr uint16_t kRelocDir64 = 10;
+// Widest fixup of the types that are masked rather than applied (the ARM MOV32 pairs).
+constexpr uint32_t kMaskedFixupSize = 8;
+
+// IMAGE_LOAD_CONFIG_DIRECTORY32/64 fields that locate the dynamic value relocation table: its VA (older
+// linkers) and its offset and section (newer ones).
+constexpr size_t kLoadConfigDvrtVa32 = 0x78;
+constexpr size_t kLoadConfigDvrtOffset32 = 0x88;
+constexpr size_t kLoadConfigDvrtVa64 = 0xC0;
+constexpr size_t kLoadConfigDvrtOffset64 = 0xE0;
+
+size_t MismatchScalar(const uint8_t* a, const uint8_t* b, size_t position, size_t size) {
+    for (; position + 8 <= size; position += 8) {
+        uint64_t left = 0;
+        uint64_t right = 0;
+        std::memcpy(&left, a + position, sizeof(left));
+        std::memcpy(&right, b + position, sizeof(right));
+        if (left != right) {
+            return position + static_cast<size_t>(std::countr_zero(left ^ right) / 8);
+        }
+    }
+    for (; position < size; ++position) {
+        if (a[position] != b[position]) {
+            return position;
+        }
+    }
+    return size;
+}
+
+#if defined(EXPLORER_MODULES_X64)
+size_t MismatchSse2(const uint8_t* a, const uint8_t* b, size_t position, size_t size) {
+    // 64 bytes per iteration; the four compares are folded so the common all-equal case costs one branch.
+    for (; position + 64 <= size; position += 64) {
+        const auto* left = reinterpret_cast<const __m128i*>(a + position);
+        const auto* right = reinterpret_cast<const __m128i*>(b + position);
+        const __m128i e0 = _mm_cmpeq_epi8(_mm_loadu_si128(left), _mm_loadu_si128(right));
+        const __m128i e1 = _mm_cmpeq_epi8(_mm_loadu_si128(left + 1), _mm_loadu_si128(right + 1));
+        const __m128i e2 = _mm_cmpeq_epi8(_mm_loadu_si128(left + 2), _mm_loadu_si128(right + 2));
+        const __m128i e3 = _mm_cmpeq_epi8(_mm_loadu_si128(left + 3), _mm_loadu_si128(right + 3));
+        if (_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(e0, e1), _mm_and_si128(e2, e3))) != 0xFFFF) {
+            const uint64_t low = static_cast<uint32_t>(_mm_movemask_epi8(e0)) |
+                static_cast<uint32_t>(_mm_movemask_epi8(e1)) << 16;
+            const uint64_t high = static_cast<uint32_t>(_mm_movemask_epi8(e2)) |
+                static_cast<uint32_t>(_mm_movemask_epi8(e3)) << 16;
+            return position + static_cast<size_t>(std::countr_zero(~(low | high << 32)));
+        }
+    }
+    return MismatchScalar(a, b, position, size);
+}
+
+EXPLORER_MODULES_TARGET_AVX2
+size_t MismatchAvx2(const uint8_t* a, const uint8_t* b, size_t position, size_t size) {
+    for (; position + 128 <= size; position += 128) {
+        const auto* left = reinterpret_cast<const __m256i*>(a + position);
+        const auto* right = reinterpret_cast<const __m256i*>(b + position);
+        const __m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(left), _mm256_loadu_si256(right));
+        const __m256i e1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(left + 1), _mm256_loadu_si256(right + 1));
+        const __m256i e2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(left + 2), _mm256_loadu_si256(right + 2));
+        const __m256i e3 = _mm256_cmpeq_epi8(_mm256_loadu_si256(left + 3), _mm256_loadu_si256(right + 3));
+        const __m256i all = _mm256_and_si256(_mm256_and_si256(e0, e1), _mm256_and_si256(e2, e3));
+        if (static_cast<uint32_t>(_mm256_movemask_epi8(all)) != 0xFFFFFFFFu) {
+            const uint64_t first = static_cast<uint32_t>(_mm256_movemask_epi8(e0)) |
+                uint64_t{ static_cast<uint32_t>(_mm256_movemask_epi8(e1)) } << 32;
+            if (first != ~uint64_t{ 0 }) {
+                return position + static_cast<size_t>(std::countr_zero(~first));
+            }
+            const uint64_t second = static_cast<uint32_t>(_mm256_movemask_epi8(e2)) |
+                uint64_t{ static_cast<uint32_t>(_mm256_movemask_epi8(e3)) } << 32;
+            return position + 64 + static_cast<size_t>(std::countr_zero(~second));
+        }
+    }
+    return MismatchSse2(a, b, position, size);
+}
+#endif
+
+// The first index at or after position where a and b differ, or size.
+size_t Mismatch(const uint8_t* a, const uint8_t* b, size_t position, size_t size, Simd::Level level) {
+#if defined(EXPLORER_MODULES_X64)
+    if (level == Simd::Level::Avx2) {
+        return MismatchAvx2(a, b, position, size);
+    }
+    if (level == Simd::Level::Sse2) {
+        return MismatchSse2(a, b, position, size);
+    }
+#else
+    (void)level;
+#endif
+    return MismatchScalar(a, b, position, size);
+}
+
+// True if the load config points at a dynamic value relocation table. The loader applies it on top of the
+// base relocations (import control flow guard, retpoline and switch-table fixups), patching code the file
+// does not show, and its records are not undone here.
+bool HasDynamicRelocations(const PeImage::View& view) {
+    const auto directory = view.Directory(PeImage::kDirectoryLoadConfig);
+    const uint8_t* config = directory.rva != 0 ? view.AtRva(directory.rva, sizeof(uint32_t)) : nullptr;
+    if (config == nullptr) {
+        return false;
+    }
+    // The structure's own Size field says which fields this linker version wrote.
+    size_t size = std::min<size_t>(PeImage::ReadAt<uint32_t>(config, 0), directory.size);
+    config = view.AtRva(directory.rva, size);
+    if (config == nullptr) {
+        return false;
+    }
+    const bool is64 = view.Is64Bit();
+    const size_t vaOffset = is64 ? kLoadConfigDvrtVa64 : kLoadConfigDvrtVa32;
+    const size_t tableOffset = is64 ? kLoadConfigDvrtOffset64 : kLoadConfigDvrtOffset32;
+    const size_t vaSize = is64 ? sizeof(uint64_t) : sizeof(uint32_t);
+    if (size >= vaOffset + vaSize) {
+        const uint64_t va = is64 ? PeImage::ReadAt<uint64_t>(config, vaOffset) : PeImage::ReadAt<uint32_t>(config, vaOffset);
+        if (va != 0) {
+            return true;
+        }
+    }
+    // DynamicValueRelocTableOffset, then the 1-based DynamicValueRelocTableSection.
+    return size >= tableOffset + sizeof(uint32_t) + sizeof(uint16_t) &&
+        PeImage::ReadAt<uint16_t>(config, tableOffset + sizeof(uint32_t)) != 0;
+}
+
+// An executable section's code, copied from fileOffset in the file to offset in the scratch buffer.
+struct CodeSpan {
+    uint32_t rva;
+    uint32_t size;
+    size_t offset;
+    uint32_t fileOffset;
+};
+
+// Finds the span holding [rva, rva + size), or nullptr.
+CodeSpan* SpanAt(std::vector<CodeSpan>& spans, uint64_t rva, uint64_t size) {
+    for (auto& span : spans) {
+        if (rva >= span.rva && rva + size <= uint64_t{ span.rva } + span.size) {
+            return &span;
+        }
+    }
+    return nullptr;
+}
+
+class Checker {
+public:
+    Checker(OpenFileFn open, const Options& options) : open_(open), options_(options) {}
+
+    // I/O phase: with an I/O slot held, copies the executable sections out of the file and applies the
+    // base relocations to the copy. Returns false (with result.status set) if there is nothing to compare.
+    bool Load(const Module& module, const PeImage::View& memory, ModuleResult& result) {
+        File file = open_(module.path);
+        const PeImage::View disk(file.data, file.data ? file.size : 0);
+        if (!disk.IsValid()) {
+            result.status = Status::NoFile;
+            return false;
+        }
+        if (disk.SizeOfImage() != memory.SizeOfImage() || disk.SectionCount() != memory.SectionCount()) {
+            result.status = Status::FileChanged;
+            return false;
+        }
+        if (HasDynamicRelocations(disk)) {
+            result.status = Status::DynamicRelocations;
+            return false;
+        }
+
+        spans_.clear();
+        masks_.clear();
+        size_t total = 0;
+        for (uint32_t i = 0; i < memory.SectionCount(); ++i) {
+            const auto loaded = memory.SectionAt(i);
+            const auto onDisk = disk.SectionAt(i);
+            if (std::memcmp(&loaded, &onDisk, sizeof(loaded)) != 0) {
+                result.status = Status::FileChanged;
+                return false;
+            }
+            if ((loaded.characteristics & (kSectionCode | kSectionExecute)) == 0) {
+                continue;
+            }
+            // Past the raw data the loader zero-fills, and there is nothing on disk to compare.
+            uint64_t size = loaded.virtualSize ? std::min(loaded.virtualSize, loaded.sizeOfRawData) : loaded.sizeOfRawData;
+            size = std::min<uint64_t>(size, module.size > loaded.virtualAddress ? module.size - loaded.virtualAddress : 0);
+            size = std::min<uint64_t>(size, disk.Size() > loaded.pointerToRawData ? disk.Size() - loaded.pointerToRawData : 0);
+            if (size == 0) {
+                continue;
+            }
+            spans_.push_back({ loaded.virtualAddress, static_cast<uint32_t>(size), total, loaded.pointerToRawData });
+            total += static_cast<size_t>(size);
+        }
+
+        if (scratch_.size() < total) {
+            scratch_.resize(total);
+        }
+        for (const auto& span : spans_) {
+            std::memcpy(scratch_.data() + span.offset, disk.Data() + span.fileOffset, span.size);
+        }
+        ApplyRelocations(disk, module.base - disk.ImageBase());
+        return true;
+    }
+
+    // Compare phase: no file access. Masks what the loader legitimately writes, then diffs.
+    void Compare(const Module& module, const PeImage::View& memory, ModuleResult& result) {
+        const auto iat = memory.Directory(PeImage::kDirectoryIat);
+        if (iat.rva != 0 && iat.size != 0) {
+            masks_.push_back({ iat.rva, iat.size });
+        }
+        for (const auto& mask : masks_) {
+            for (const auto& span : spans_) {
+                const uint64_t start = std::max<uint64_t>(mask.rva, span.rva);
+                const uint64_t end = std::min<uint64_t>(uint64_t{ mask.rva } + mask.size, uint64_t{ span.rva } + span.size);
+                if (start < end) {
+                    std::memcpy(scratch_.data() + span.offset + (start - span.rva), module.image + start,
+                        static_cast<size_t>(end - start));
+                }
+            }
+        }
+
+        result.status = Status::Intact;
+        for (const auto& span : spans_) {
+            ++result.sectionsChecked;
+            result.bytesCompared += span.size;
+            result.bytesChanged += Diff(module.image + span.rva, scratch_.data() + span.offset, span.size, span.rva,
+                result.ranges, options_.maxRanges, result.truncated, options_.level);
+        }
+        if (result.bytesChanged != 0) {
+            result.status = Status::Modified;
+        }
+    }
+
+private:
+    void ApplyRelocations(const PeImage::View& disk, uint64_t delta) {
+        const auto directory = disk.Directory(PeImage::kDirectoryBaseReloc);
+        uint64_t block = directory.rva;
+        const uint64_t end = uint64_t{ directory.rva } + directory.size;
+        while (directory.rva != 0 && block + 8 <= end) {
+            const uint8_t* header = disk.AtRva(static_cast<uint32_t>(block), 8);
+            if (!header) {
+                return;
+            }
+            const uint32_t page = PeImage::ReadAt<uint32_t>(header, 0);
+            const uint32_t blockSize = PeImage::ReadAt<uint32_t>(header, 4);
+            if (blockSize < 8 || block + blockSize > end) {
+                return;
+            }
+            const uint8_t* entries = disk.AtRva(static_cast<uint32_t>(block + 8), blockSize - 8);
+            if (!entries) {
+                return;
+            }
+            const uint32_t count = (blockSize - 8) / 2;
+            for (uint32_t i = 0; i < count; ++i) {
+                const uint16_t entry = PeImage::ReadAt<uint16_t>(entries, i * size_t{ 2 });
+                const uint16_t type = entry >> 12;
+                const uint64_t rva = uint64_t{ page } + (entry & 0xFFF);
+                if (type == kRelocAbsolute) {
+                    continue;
+                }
+                if (type == kRelocHighLow || type == kRelocDir64) {
+                    const size_t width = type == kRelocDir64 ? 8 : 4;
+                    if (CodeSpan* span = SpanAt(spans_, rva, width)) {
+                        uint8_t* target = scratch_.data() + span->offset + (rva - span->rva);
+                        if (width == 8) {
+                            const uint64_t value = PeImage::ReadAt<uint64_t>(target, 0) + delta;
+                            std::memcpy(target, &value, sizeof(value));
+                        } else {
+                            const uint32_t value = PeImage::ReadAt<uint32_t>(target, 0) + static_cast<uint32_t>(delta);
+                            std::memcpy(target, &value, sizeof(value));
+                        }
+                    } else {
+                        // Straddles a section boundary; rare enough to just exclude.
+                        masks_.push_back({ static_cast<uint32_t>(rva), static_cast<uint32_t>(width) });
+                    }
+                    continue;
+                }
+                // Types this checker does not apply are masked. HIGHADJ uses the next entry as its operand.
+                masks_.push_back({ static_cast<uint32_t>(rva), kMaskedFixupSize });
+                if (type == kRelocHighAdj) {
+                    ++i;
+                }
+            }
+            block += blockSize;
+        }
+    }
+
+    OpenFileFn open_;
+    const Options& options_;
+    std::vector<uint8_t> scratch_;
+    std::vector<CodeSpan> spans_;
+    std::vector<Range> masks_;
+};
+
+} // namespace
+
+File OpenMappedFile(const std::wstring& path) {
+    std::shared_ptr<Platform::MappedFile> mapped = Platform::MappedFile::Open(std::filesystem::path(path));
+    if (!mapped) {
+        return {};
+    }
+    File file;
+    file.data = mapped->Data();
+    file.size = mapped->Size();
+    file.owner = std::move(mapped);
+    return file;
+}
+
+uint64_t Diff(const uint8_t* memory, const uint8_t* file, size_t size, uint32_t rva, std::vector<Range>& ranges,
+    size_t maxRanges, bool& truncated, Simd::Level level) {
+    uint64_t changed = 0;
+    size_t position = 0;
+    while ((position = Mismatch(memory, file, position, size, level)) < size) {
+        const size_t start = position;
+        size_t end = position + 1;
+        ++changed;
+        // Runs are short (a patched instruction or two), so they are extended a byte at a time.
+        for (position = end; position < size && position - end < kMergeGap; ++position) {
+            if (memory[position] != file[position]) {
+                end = position + 1;
+                ++changed;
+            }
+        }
+        if (ranges.size() < maxRanges) {
+            ranges.push_back({ static_cast<uint32_t>(rva + start), static_cast<uint32_t>(end - start) });
+        } else {
+            truncated = true;
+        }
+    }
+    return changed;
+}
+
+std::vector<ModuleResult> Check(const std::vector<Module>& modules, OpenFileFn open, const Options& options) {
+    std::vector<ModuleResult> results(modules.size());
+    std::counting_semaphore<> ioSlots(std::max<std::ptrdiff_t>(options.ioConcurrency, 1));
+    std::atomic<size_t> next{ 0 };
+    auto work = [&] {
+        Checker checker(open, options);
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < modules.size();) {
+            const Module& module = modules[i];
+            const PeImage::View memory(module.image, module.image ? module.size : 0, PeImage::Layout::Mapped);
+            if (!memory.IsValid()) {
+                continue;
+            }
+            ioSlots.acquire();
+            const bool loaded = checker.Load(module, memory, results[i]);
+            ioSlots.release();
+            if (loaded) {
+                checker.Compare(module, memory, results[i]);
+            }
+        }
+    };
+
+    const size_t workerCount = std::min<size_t>(std::max(options.threads, 1u), modules.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return results;
+}
+
+std::wstring Summary(const ModuleResult& result) {
+    switch (result.status) {
+    case Status::Intact:
+        return L"OK";
+    case Status::Modified: {
+        std::wstring text = L"Modified: " + std::to_wstring(result.bytesChanged) + L" bytes in ";
+        text += std::to_wstring(result.ranges.size()) + (result.truncated ? L"+ ranges" : L" ranges");
+        return text;
+    }
+    case Status::FileChanged:
+        return L"File changed";
+    case Status::NoFile:
+        return L"No file";
+    case Status::DynamicRelocations:
+        return L"Not checked (dynamic relocations)";
+    default:
+        return L"";
+    }
+}
+
+} // namespace CodeIntegrity
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "HookScan.h"
+#include "Simd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Detects inline patches by comparing each loaded module's executable sections with the same sections
+// of its file on disk. The file bytes get the module's base relocations applied (for the difference
+// between the load address and the preferred ImageBase), and the IAT, which the loader fills in, is
+// masked, so a rebased and bound module compares equal to its file. Images whose load config carries a
+// dynamic value relocation table are not compared, since the loader patches their code further.
+//
+// Modules are checked in parallel. Opening the files and copying their code out is the I/O-bound part,
+// so only a few modules are in that phase at once; a cold file cache does not see hundreds of
+// concurrent reads. The comparison itself is a vectorized scan that reports the changed ranges.
+namespace CodeIntegrity {
+
+// The same description of a loaded image the hook scanner takes.
+using Module = HookScan::Module;
+
+struct Range {
+    uint32_t rva;
+    uint32_t size;
+};
+
+enum class Status : uint8_t {
+    NotChecked,         // No readable image, or its headers are invalid
+    Intact,
+    Modified,           // Code differs from the file
+    FileChanged,        // The file's section table no longer matches the loaded image (replaced on disk)
+    NoFile,             // The file could not be opened or parsed
+    DynamicRelocations, // Not compared: the loader also applies a dynamic value relocation table
+};
+
+struct ModuleResult {
+    Status status = Status::NotChecked;
+    uint32_t sectionsChecked = 0;
+    uint64_t bytesCompared = 0;
+    uint64_t bytesChanged = 0;
+    std::vector<Range> ranges; // Changed runs in RVA order, at most Options::maxRanges
+    bool truncated = false;    // More runs than maxRanges
+};
+
+// A module file supplied by OpenFileFn; data stays valid while owner is held.
+struct File {
+    std::shared_ptr<const void> owner;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+/// @brief Opens a module's file, leaving data null if it cannot. Must be thread-safe.
+using OpenFileFn = File (*)(const std::wstring& path);
+
+/// @brief Maps the file with Platform::MappedFile.
+File OpenMappedFile(const std::wstring& path);
+
+struct Options {
+    uint32_t threads = 1;
+    uint32_t ioConcurrency = 4; // Modules reading their file at once
+    uint32_t maxRanges = 64;
+    Simd::Level level = Simd::Active();
+};
+
+/// @brief Compares size bytes of memory with file. Differences closer than a few bytes form one range;
+/// ranges are appended with RVAs relative to rva until there are maxRanges, after which truncated is
+/// set. Returns the number of differing bytes.
+uint64_t Diff(const uint8_t* memory, const uint8_t* file, size_t size, uint32_t rva, std::vector<Range>& ranges,
+    size_t maxRanges, bool& truncated, Simd::Level level);
+
+/// @brief Checks every module; the result is parallel to modules.
+std::vector<ModuleResult> Check(const std::vector<Module>& modules, OpenFileFn open, const Options& options);
+
+/// @brief Column text: "OK", "Modified: n bytes in m ranges", "File changed", "No file",
+/// "Not checked (dynamic relocations)", or empty.
+std::wstring Summary(const ModuleResult& result);
+
+} // namespace CodeIntegrity
@@ -0,0 +1,150 @@
+#include "Diagnostics.h"
+
+#include "MemoryBudget.h"
+#include "Perf.h"
+#include "Platform.h"
+#include "QiProfiler.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+
+namespace Diagnostics {
+namespace {
+
+constexpr uint32_t kCounterCount = static_cast<uint32_t>(Counter::Count);
+constexpr size_t kReportQiEntries = 10;
+
+constexpr std::array<const wchar_t*, kCounterCount> kCounterNames = {
+    L"Enumerations served",
+    L"Modules parsed",
+    L"Metadata cache hits",
+    L"Metadata cache misses",
+    L"Metadata cache evictions",
+    L"Loader events received",
+    L"Loader events coalesced",
+    L"Refreshes sent",
+    L"PIDL bytes allocated",
+    L"Refresh threads started",
+    L"Subtree nodes decoded",
+    L"Subtree cache evictions",
+    L"Hook scans",
+    L"Hooked entries found",
+    L"Integrity checks",
+    L"Modules with modified code",
+    L"Signature searches",
+    L"Signature hits found",
+    L"Files hashed",
+    L"Hash cache hits",
+    L"Checksum mismatches found",
+    L"Duplicate scans",
+    L"Duplicate modules found",
+    L"Module files changed",
+    L"Metadata invalidations",
+    L"Icons decoded",
+    L"Icon cache hits",
+    L"Sessions started",
+    L"Idle trims",
+    L"Bytes trimmed",
+};
+
+// Counts accumulate here until Publish() moves them into shared memory.
+SharedBlock g_localBlock = {};
+std::atomic<SharedBlock*> g_block{ &g_localBlock };
+
+std::mutex g_publishMutex;
+std::unique_ptr<Platform::SharedMemory> g_sharedMemory;
+
+uint64_t LoadCounter(SharedBlock* block, uint32_t index) {
+    return std::atomic_ref<uint64_t>(block->counters[index]).load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+std::wstring SharedBlockName(uint32_t processId) {
+    return L"Local\\ExplorerModulesNamespace.Diagnostics." + std::to_wstring(processId);
+}
+
+const wchar_t* CounterName(Counter counter) {
+    auto index = static_cast<size_t>(counter);
+    return index < kCounterNames.size() ? kCounterNames[index] : L"Unknown";
+}
+
+void Increment(Counter counter, uint64_t delta) {
+    SharedBlock* block = g_block.load(std::memory_order_acquire);
+    std::atomic_ref<uint64_t>(block->counters[static_cast<uint32_t>(counter)])
+        .fetch_add(delta, std::memory_order_relaxed);
+}
+
+uint64_t Get(Counter counter) {
+    return LoadCounter(g_block.load(std::memory_order_acquire), static_cast<uint32_t>(counter));
+}
+
+bool Publish() {
+    std::lock_guard<std::mutex> lock(g_publishMutex);
+    if (g_sharedMemory) {
+        return true;
+    }
+
+    const uint32_t processId = Platform::CurrentProcessId();
+    auto memory = Platform::SharedMemory::Create(SharedBlockName(processId), sizeof(SharedBlock));
+    if (!memory) {
+        return false;
+    }
+
+    auto* shared = static_cast<SharedBlock*>(memory->Data());
+    shared->layoutVersion = kLayoutVersion;
+    shared->headerSize = static_cast<uint32_t>(offsetof(SharedBlock, counters));
+    shared->counterCount = kCounterCount;
+    shared->processId = processId;
+    shared->publishedAtUnixMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    for (uint32_t i = 0; i < kCounterSlots; ++i) {
+        std::atomic_ref<uint64_t>(shared->counters[i]).store(LoadCounter(&g_localBlock, i), std::memory_order_relaxed);
+    }
+    // Magic goes last so a reader that races with us never sees a half-initialized header as valid.
+    std::atomic_ref<uint32_t>(shared->magic).store(kMagic, std::memory_order_release);
+
+    // Increments that land on the local block between the copy and this store are lost; that window is
+    // a handful of instructions on first folder open and not worth a lock on every increment.
+    g_block.store(shared, std::memory_order_release);
+    g_sharedMemory = std::move(memory);
+    return true;
+}
+
+std::wstring FormatCompact() {
+    auto value = [](Counter counter) { return std::to_wstring(Get(counter)); };
+    return L"Enumerations " + value(Counter::EnumerationsServed) + L", parsed " + value(Counter::ModulesParsed) +
+        L", cache hit/miss/evict " + value(Counter::MetadataCacheHits) + L"/" + value(Counter::MetadataCacheMisses) +
+        L"/" + value(Counter::MetadataCacheEvictions) + L", loader events " + value(Counter::LoaderEventsReceived) +
+        L" (" + value(Counter::LoaderEventsCoalesced) + L" coalesced), refreshes " + value(Counter::RefreshesSent) +
+        L", PIDL bytes " + value(Counter::PidlBytesAllocated);
+}
+
+std::wstring FormatReport() {
+    std::wstring report;
+    for (uint32_t i = 0; i < kCounterCount; ++i) {
+        report += kCounterNames[i];
+        report += L": ";
+        report += std::to_wstring(Get(static_cast<Counter>(i)));
+        report += L"\n";
+    }
+    auto memory = MemoryBudget::Process().Format();
+    report += L"\nMemory held\n";
+    report += memory;
+    auto latency = Perf::FormatSummary();
+    if (!latency.empty()) {
+        report += L"\nLatency\n";
+        report += latency;
+    }
+    auto interfaces = QiProfiler::FormatReport(kReportQiEntries);
+    if (!interfaces.empty()) {
+        report += L"\nQueryInterface\n";
+        report += interfaces;
+    }
+    return report;
+}
+
+} // namespace Diagnostics
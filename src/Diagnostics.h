@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+// Always-on counters describing what the extension has been doing. They live in process memory until
+// Publish() is called, after which they are kept in a named shared-memory block so that an external
+// reader (tools/DiagnosticsDump) can watch them without injecting into Explorer.
+namespace Diagnostics {
+
+// Append-only: new counters go before Count and bump kLayoutVersion. Never reorder or reuse slots.
+enum class Counter : uint32_t {
+    EnumerationsServed,
+    ModulesParsed,
+    MetadataCacheHits,
+    MetadataCacheMisses,
+    MetadataCacheEvictions,
+    LoaderEventsReceived,
+    LoaderEventsCoalesced,
+    RefreshesSent,
+    PidlBytesAllocated,
+    RefreshThreadsStarted,
+    TreeNodesDecoded,
+    TreeCacheEvictions,
+    HookScans,
+    HookedEntriesFound,
+    IntegrityChecks,
+    ModifiedModulesFound,
+    SignatureSearches,
+    SignatureHitsFound,
+    FilesHashed,
+    HashCacheHits,
+    ChecksumMismatchesFound,
+    DuplicateScans,
+    DuplicateModulesFound,
+    ModuleFilesChanged,
+    MetadataInvalidations,
+    IconsDecoded,
+    IconCacheHits,
+    SessionsStarted,
+    IdleTrims,
+    BytesTrimmed,
+    Count
+};
+
+constexpr uint32_t kMagic = 0x47444D45; // 'EMDG'
+constexpr uint32_t kLayoutVersion = 13;
+constexpr uint32_t kCounterSlots = 32; // Room to grow without changing the block size.
+
+// Counters defined by each layout version, indexed by version: 1 ends at PidlBytesAllocated, 2 adds
+// RefreshThreadsStarted, 3 the tree, 4 hooks, 5 integrity, 6 signatures, 7 hashes, 8 checksums,
+// 9 duplicates, 10 file changes, 11 icons, 12 sessions, 13 idle trims. Appending a counter means
+// appending its version here.
+constexpr uint32_t kCountersInLayout[] = { 0, 9, 10, 12, 14, 16, 18, 20, 21, 23, 25, 27, 28, 30 };
+
+static_assert(static_cast<uint32_t>(Counter::Count) <= kCounterSlots, "Out of counter slots");
+static_assert(kCountersInLayout[kLayoutVersion] == static_cast<uint32_t>(Counter::Count),
+    "Counters were appended without bumping kLayoutVersion");
+static_assert(std::size(kCountersInLayout) == kLayoutVersion + 1, "kCountersInLayout must end at kLayoutVersion");
+
+// Shared-memory layout. Readers must check magic, then use min(counterCount, what they understand).
+struct SharedBlock {
+    uint32_t magic;
+    uint32_t layoutVersion;
+    uint32_t headerSize;   // offsetof(SharedBlock, counters)
+    uint32_t counterCount; // Number of meaningful entries in counters
+    uint32_t processId;
+    uint32_t reserved;
+    uint64_t publishedAtUnixMs;
+    uint64_t counters[kCounterSlots]; // Accessed with std::atomic_ref
+};
+
+static_assert(sizeof(SharedBlock) == 32 + kCounterSlots * sizeof(uint64_t), "SharedBlock layout changed");
+
+/// @brief Name of the block published by the given process ("Local\ExplorerModulesNamespace.Diagnostics.<pid>").
+std::wstring SharedBlockName(uint32_t processId);
+
+const wchar_t* CounterName(Counter counter);
+
+void Increment(Counter counter, uint64_t delta = 1);
+
+uint64_t Get(Counter counter);
+
+/// @brief Moves the counters into the named shared-memory block. Safe to call repeatedly; only the first
+/// successful call does anything. Returns true once the block is published.
+bool Publish();
+
+/// @brief One line of "name=value" pairs, for places with little room.
+std::wstring FormatCompact();
+
+/// @brief Multi-line report with every counter followed by the memory held, the latency summary and the
+/// busiest QueryInterface requests.
+std::wstring FormatReport();
+
+} // namespace Diagnostics
@@ -1,12 +1,13 @@
 #include "DllNotification.h"
+#include "Diagnostics.h"
 #include "Log.h"
-#include "ModuleFolder.h"
+#include "ModuleHelpers.h"
 #include "NtDll.h"
+#include "RefreshPipeline.h"
 
 #include <windows.h>
 #include <winternl.h> // For UNICODE_STRING
 #include <shlobj.h>
-#include <thread>
 #include <string>
 #include <shared_mutex>
 #include <mutex>
@@ -16,28 +17,17 @@ namespace {
     PVOID g_notificationCookie = nullptr;
     LdrRegisterDllNotification_t g_LdrRegisterDllNotification = nullptr;
     LdrUnregisterDllNotification_t g_LdrUnregisterDllNotification = nullptr;
-    
-    void RefreshWindowThread() {
+
+    void NotifyShell() {
         // CoInitialize is required for many Shell APIs, though SHChangeNotify might not strictly require it, 
         // relying on parsing definitely does if it involves COM objects.
         HRESULT hr = CoInitialize(nullptr);
-        
-        // Prefix with :: to ensure it parses as a CLSID/Namespace location
-        std::wstring parsingName = std::wstring(kNamespaceParentParsingName) + L"\\::" + kModuleFolderClsidString;
 
-        // Notify Explorer that the contents of our folder have changed.
-        // SHCNE_UPDATEDIR indicates the contents of the folder identified by the PIDL have changed.
-        // SHCNF_PARSE_NAME is not standard, so we must parse it to a PIDL first.
-        
-        PIDLIST_ABSOLUTE pidl = nullptr;
-        SFGAOF sfgao = 0;
-        HRESULT hrParse = SHParseDisplayName(parsingName.c_str(), nullptr, &pidl, 0, &sfgao);
-        
-        if (SUCCEEDED(hrParse)) {
-            SHChangeNotify(SHCNE_UPDATEDIR, SHCNF_IDLIST, pidl, nullptr);
-            CoTaskMemFree(pidl);
-        } else {
-             Log::Write(Log::Level::Error, L"SHParseDisplayName failed for %s: 0x%08X", parsingName.c_str(), hrParse);
+        // Follow the new module list on disk before the view re-reads it.
+        ModuleHelpers::UpdateWatchedFiles();
+
+        if (ModuleHelpers::NotifyFolderChanged()) {
+            Diagnostics::Increment(Diagnostics::Counter::RefreshesSent);
         }
 
         if (SUCCEEDED(hr)) {
@@ -45,22 +35,21 @@ namespace {
         }
     }
 
-    VOID CALLBACK DllNotificationCallback(
-        _In_     ULONG                       NotificationReason,
-        _In_     PCLDR_DLL_NOTIFICATION_DATA NotificationData,
-        _In_opt_ PVOID                       Context
-    ) {
-        UNREFERENCED_PARAMETER(NotificationData);
-        UNREFERENCED_PARAMETER(Context);
+    // Outlives the registration: refresh threads may still be running after ShutdownDllNotification.
+    RefreshPipeline g_refreshPipeline(NotifyShell);
 
-        if (NotificationReason == LDR_DLL_NOTIFICATION_REASON_LOADED || 
-            NotificationReason == LDR_DLL_NOTIFICATION_REASON_UNLOADED) {
-            
-            // Execute the refresh on a separate thread to avoid deadlock issues 
-            // "It is unsafe for the notification callback to call functions in ANY other module other than itself."
-            std::thread t(RefreshWindowThread);
-            t.detach();
+    // Runs under the loader lock, on the thread doing the load: timestamp the event for the load
+    // timeline, then hand it to the refresh pipeline.
+    VOID CALLBACK OnDllNotification(ULONG reason, PCLDR_DLL_NOTIFICATION_DATA data, PVOID context) {
+        const auto now = Perf::Clock::now();
+        if (data && reason == LDR_DLL_NOTIFICATION_REASON_LOADED) {
+            const UNICODE_STRING* name = data->Loaded.FullDllName;
+            ModuleHelpers::GetLoadTimeline().OnLoaded(GetCurrentThreadId(), data->Loaded.DllBase,
+                name ? name->Buffer : nullptr, name && name->Buffer ? name->Length / sizeof(wchar_t) : 0, now);
+        } else if (data && reason == LDR_DLL_NOTIFICATION_REASON_UNLOADED) {
+            ModuleHelpers::GetLoadTimeline().OnUnloaded(data->Unloaded.DllBase);
         }
+        RefreshPipeline::DllNotificationCallback(reason, data, context);
     }
 }
 
@@ -74,7 +63,7 @@ void InitializeDllNotification() {
 
     HMODULE hNtdll = GetModuleHandleW(L"ntdll.dll");
     if (!hNtdll) {
-        Log::Write(Log::Level::Error, L"Could not get handle to ntdll.dll");
+        LOG_ERROR(L"Could not get handle to ntdll.dll");
         return;
     }
 
@@ -82,15 +71,16 @@ void InitializeDllNotification() {
     g_LdrUnregisterDllNotification = (LdrUnregisterDllNotification_t)GetProcAddress(hNtdll, "LdrUnregisterDllNotification");
 
     if (g_LdrRegisterDllNotification && g_LdrUnregisterDllNotification) {
-        NTSTATUS status = g_LdrRegisterDllNotification(0, DllNotificationCallback, nullptr, &g_notificationCookie);
+        NTSTATUS status = g_LdrRegisterDllNotification(0, OnDllNotification,
+            &g_refreshPipeline, &g_notificationCookie);
         if (status != 0) { // STATUS_SUCCESS = 0
-             Log::Write(Log::Level::Error, L"Failed to register DLL notification: 0x%x", status);
+             LOG_ERROR(L"Failed to register DLL notification: 0x{:08X}", static_cast<unsigned long>(status));
              g_notificationCookie = nullptr;
         } else {
-             Log::Write(Log::Level::Info, L"Registered DLL notification");
+             LOG_INFO(L"Registered DLL notification");
         }
     } else {
-        Log::Write(Log::Level::Error, L"Could not find LdrRegisterDllNotification or LdrUnregisterDllNotification in ntdll.dll");
+        LOG_ERROR(L"Could not find LdrRegisterDllNotification or LdrUnregisterDllNotification in ntdll.dll");
     }
 }
 
@@ -99,6 +89,10 @@ void ShutdownDllNotification() {
     if (g_notificationCookie && g_LdrUnregisterDllNotification) {
         g_LdrUnregisterDllNotification(g_notificationCookie);
         g_notificationCookie = nullptr;
-        Log::Write(Log::Level::Info, L"Unregistered DLL notification");
+        LOG_INFO(L"Unregistered DLL notification");
     }
 }
+
+bool DllNotificationIdle() {
+    return g_refreshPipeline.GetStats().inFlight == 0;
+}
@@ -2,3 +2,6 @@
 
 void InitializeDllNotification();
 void ShutdownDllNotification();
+
+/// @brief True when no refresh started by a loader notification is still running.
+bool DllNotificationIdle();
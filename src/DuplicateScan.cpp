@@ -0,0 +1,158 @@
+#include "DuplicateScan.h"
+
+#include "PeImage.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <unordered_map>
+
+namespace DuplicateScan {
+namespace {
+
+struct FingerprintHash {
+    size_t operator()(const Fingerprint& fingerprint) const {
+        uint64_t hash = (uint64_t{ fingerprint.timeDateStamp } << 32 | fingerprint.sizeOfImage) * 0x9E3779B97F4A7C15ull;
+        hash ^= (uint64_t{ fingerprint.checksum } << 16 | fingerprint.machine) * 0xC2B2AE3D27D4EB4Full;
+        return static_cast<size_t>(hash ^ hash >> 31);
+    }
+};
+
+// File names are compared as the loader compares them: without the directory, ignoring case.
+std::wstring LowerFileName(const std::wstring& path) {
+    const size_t slash = path.find_last_of(L"\\/");
+    std::wstring name = path.substr(slash == std::wstring::npos ? 0 : slash + 1);
+    for (auto& c : name) {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+    return name;
+}
+
+// Content key within a fingerprint group: the SHA-256 if the file was read, empty if it could not be
+// (such modules stay matched by fingerprint alone).
+std::string ContentKey(uint32_t group, const FileHash::FileResult& file) {
+    std::string key(reinterpret_cast<const char*>(&group), sizeof(group));
+    if (file.status == FileHash::Status::Hashed || file.status == FileHash::Status::Cached) {
+        key.append(reinterpret_cast<const char*>(file.digests.sha256.data()), file.digests.sha256.size());
+    }
+    return key;
+}
+
+} // namespace
+
+bool ReadFingerprint(const uint8_t* headers, size_t size, Fingerprint& fingerprint) {
+    const PeImage::View view(headers, size);
+    if (!view.IsValid()) {
+        return false;
+    }
+    fingerprint.timeDateStamp = view.TimeDateStamp();
+    fingerprint.sizeOfImage = view.SizeOfImage();
+    fingerprint.checksum = view.Checksum();
+    fingerprint.machine = view.Machine();
+    return true;
+}
+
+Report Detect(const std::vector<Module>& modules, FileHash::OpenFn open, FileHash::Cache* cache, uint32_t threads) {
+    Report report;
+    report.modules.resize(modules.size());
+
+    // The build each module holds, as a small integer: first its fingerprint group, then, where groups
+    // have more than one member, refined by content.
+    std::vector<uint32_t> build(modules.size());
+    std::vector<uint32_t> members;
+    std::unordered_map<Fingerprint, uint32_t, FingerprintHash> byFingerprint;
+    byFingerprint.reserve(modules.size());
+    for (size_t i = 0; i < modules.size(); ++i) {
+        uint32_t id = static_cast<uint32_t>(members.size());
+        if (modules[i].fingerprinted) {
+            id = byFingerprint.try_emplace(modules[i].fingerprint, id).first->second;
+        }
+        if (id == members.size()) {
+            members.push_back(0);
+        }
+        build[i] = id;
+        ++members[id];
+    }
+
+    std::vector<size_t> colliding;
+    std::vector<std::wstring> paths;
+    for (size_t i = 0; i < modules.size(); ++i) {
+        if (members[build[i]] > 1) {
+            colliding.push_back(i);
+            paths.push_back(modules[i].path);
+        }
+    }
+    if (!colliding.empty()) {
+        FileHash::Options options;
+        options.threads = threads;
+        const auto files = FileHash::HashFiles(paths, cache, open, options);
+        report.filesHashed = static_cast<uint32_t>(files.size());
+        std::unordered_map<std::string, uint32_t> byContent;
+        for (size_t i = 0; i < colliding.size(); ++i) {
+            const size_t module = colliding[i];
+            const auto inserted = byContent.try_emplace(ContentKey(build[module], files[i]), static_cast<uint32_t>(members.size()));
+            if (inserted.second) {
+                members.push_back(0);
+            }
+            --members[build[module]];
+            build[module] = inserted.first->second;
+            ++members[build[module]];
+        }
+    }
+
+    for (size_t i = 0; i < modules.size(); ++i) {
+        if (members[build[i]] > 1) {
+            report.modules[i].flags |= kCopy;
+            report.modules[i].copies = members[build[i]];
+            ++report.copies;
+        }
+    }
+
+    // Modules sharing a file name, chained through next so the grouping stays linear.
+    std::vector<uint32_t> next(modules.size(), UINT32_MAX);
+    std::unordered_map<std::wstring, uint32_t> byName;
+    byName.reserve(modules.size());
+    for (size_t i = modules.size(); i-- > 0;) {
+        auto [entry, inserted] = byName.try_emplace(LowerFileName(modules[i].path), static_cast<uint32_t>(i));
+        if (!inserted) {
+            next[i] = entry->second;
+            entry->second = static_cast<uint32_t>(i);
+        }
+    }
+    std::vector<uint32_t> builds;
+    for (const auto& [name, first] : byName) {
+        if (next[first] == UINT32_MAX) {
+            continue;
+        }
+        builds.clear();
+        for (uint32_t i = first; i != UINT32_MAX; i = next[i]) {
+            builds.push_back(build[i]);
+        }
+        std::sort(builds.begin(), builds.end());
+        const auto versions = static_cast<uint32_t>(std::unique(builds.begin(), builds.end()) - builds.begin());
+        if (versions < 2) {
+            continue;
+        }
+        for (uint32_t i = first; i != UINT32_MAX; i = next[i]) {
+            report.modules[i].flags |= kVersion;
+            report.modules[i].versions = versions;
+            ++report.versions;
+        }
+    }
+    return report;
+}
+
+std::wstring Summary(const ModuleResult& result) {
+    std::wstring text;
+    if (result.flags & kCopy) {
+        text = std::to_wstring(result.copies) + L" copies";
+    }
+    if (result.flags & kVersion) {
+        if (!text.empty()) {
+            text += L", ";
+        }
+        text += std::to_wstring(result.versions) + L" versions";
+    }
+    return text;
+}
+
+} // namespace DuplicateScan
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "FileHash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Finds the same DLL loaded more than once from different paths, and different builds of one DLL loaded
+// side by side. Each module is fingerprinted from fields of its headers that are already in memory
+// (TimeDateStamp, SizeOfImage, CheckSum, Machine), and modules are grouped by fingerprint and by file
+// name with hash tables, so a pass is linear in the number of modules and cheap enough for every
+// refresh. Files are read only when two modules at different paths share a fingerprint: their contents
+// are hashed (through a FileHash::Cache, so only the first pass reads them) to confirm a true copy.
+namespace DuplicateScan {
+
+struct Fingerprint {
+    uint32_t timeDateStamp = 0;
+    uint32_t sizeOfImage = 0;
+    uint32_t checksum = 0;
+    uint16_t machine = 0;
+
+    bool operator==(const Fingerprint&) const = default;
+};
+
+/// @brief Reads the fingerprint from the start of an image, in either layout. Returns false if the
+/// headers do not parse within size bytes.
+bool ReadFingerprint(const uint8_t* headers, size_t size, Fingerprint& fingerprint);
+
+struct Module {
+    std::wstring path;
+    uint64_t base = 0;
+    Fingerprint fingerprint;
+    bool fingerprinted = false; // False if the headers could not be read; the module then matches nothing
+};
+
+enum Flags : uint8_t {
+    kCopy = 1,    // The same file content is loaded from another path as well
+    kVersion = 2, // Another module with the same file name has a different build
+};
+
+struct ModuleResult {
+    uint8_t flags = 0;
+    uint32_t copies = 0;   // kCopy: modules with this content, including this one
+    uint32_t versions = 0; // kVersion: distinct builds loaded under this file name
+};
+
+struct Report {
+    std::vector<ModuleResult> modules; // Parallel to the input
+    uint32_t copies = 0;               // Modules flagged kCopy
+    uint32_t versions = 0;             // Modules flagged kVersion
+    uint32_t filesHashed = 0;          // Files whose content was compared (read or cached)
+};
+
+/// @brief Groups modules as described above, hashing colliding files with open on up to threads threads.
+/// cache may be null.
+Report Detect(const std::vector<Module>& modules, FileHash::OpenFn open, FileHash::Cache* cache, uint32_t threads = 1);
+
+/// @brief Column text: "2 copies", "3 versions", both, or empty.
+std::wstring Summary(const ModuleResult& result);
+
+} // namespace DuplicateScan
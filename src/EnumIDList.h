@@ -3,14 +3,18 @@
 #include <windows.h>
 #include <shlobj.h>
 #include <wrl.h>
-#include <vector>
+#include <memory>
 
+#include "ModuleEnumerator.h"
+
+// IEnumIDList over a snapshot of module handles. Paths are looked up and PIDLs encoded only when Next()
+// asks for them (see ModuleEnumerator), so the first page of a view costs the same whatever the number of
+// loaded modules, and Skip() never touches a module.
 class EnumIDList final
     : public Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>,
         IEnumIDList> {
 public:
-    explicit EnumIDList(const std::vector<PIDLIST_RELATIVE>& items);
-    ~EnumIDList();
+    explicit EnumIDList(ModuleEnumerator enumerator);
 
     IFACEMETHODIMP Next(ULONG celt, PITEMID_CHILD* rgelt, ULONG* fetched) override;
     IFACEMETHODIMP Skip(ULONG celt) override;
@@ -18,6 +22,6 @@ public:
     IFACEMETHODIMP Clone(IEnumIDList** ppenum) override;
 
 private:
-    std::vector<PIDLIST_RELATIVE> items_;
-    ULONG index_ = 0;
+    std::shared_ptr<void> session_; // ModuleHelpers::AcquireSession, held while the shell enumerates
+    ModuleEnumerator enumerator_;
 };
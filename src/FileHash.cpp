@@ -0,0 +1,196 @@
+#include "FileHash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <semaphore>
+#include <thread>
+
+namespace FileHash {
+namespace {
+
+// Reads one file in chunks, holding an I/O slot only for each read, and feeds every chunk to the
+// requested hashers.
+Status HashFile(Platform::SequentialFile& file, uint32_t algorithms, Simd::Level level, std::vector<uint8_t>& buffer,
+    std::counting_semaphore<>& ioSlots, Digests& digests, uint64_t& bytesRead) {
+    std::optional<Sha::Sha256> sha256;
+    std::optional<Sha::Sha1> sha1;
+    std::optional<PeChecksum::Accumulator> checksum;
+    uint32_t storedChecksum = 0;
+    if (algorithms & kSha256) {
+        sha256.emplace();
+    }
+    if (algorithms & kSha1) {
+        sha1.emplace();
+    }
+    for (bool first = true;; first = false) {
+        size_t count = 0;
+        ioSlots.acquire();
+        const bool read = file.Read(buffer.data(), buffer.size(), count);
+        ioSlots.release();
+        if (!read) {
+            return Status::ReadError;
+        }
+        bytesRead += count;
+        if (first && (algorithms & kPeChecksum) && PeChecksum::ReadStored(buffer.data(), count, storedChecksum)) {
+            checksum.emplace(level);
+        }
+        if (checksum) {
+            checksum->Update(buffer.data(), count);
+        }
+        if (sha256) {
+            sha256->Update(buffer.data(), count);
+        }
+        if (sha1) {
+            sha1->Update(buffer.data(), count);
+        }
+        if (count < buffer.size()) {
+            break;
+        }
+    }
+    digests.algorithms = algorithms;
+    if (sha256) {
+        digests.sha256 = sha256->Final();
+    }
+    if (sha1) {
+        digests.sha1 = sha1->Final();
+    }
+    if (checksum) {
+        digests.peChecksum = PeChecksum::Compare(storedChecksum, checksum->Finish(storedChecksum));
+    }
+    return Status::Hashed;
+}
+
+// A table node: the entry and the next pointer, plus the hash the node caches.
+constexpr size_t kEntryBytes = sizeof(std::pair<const Platform::FileIdentity, Digests>) + 2 * sizeof(void*);
+
+} // namespace
+
+std::unique_ptr<Platform::SequentialFile> OpenSequentialFile(const std::wstring& path) {
+    return Platform::SequentialFile::Open(std::filesystem::path(path));
+}
+
+size_t IdentityHash::operator()(const Platform::FileIdentity& identity) const {
+    // The file ID alone nearly always separates entries; the rest is mixed in for the rare collision.
+    uint64_t hash = identity.fileId * 0x9E3779B97F4A7C15ull;
+    hash ^= (identity.volume + static_cast<uint64_t>(identity.lastWriteTime)) * 0xC2B2AE3D27D4EB4Full;
+    hash ^= identity.size;
+    return static_cast<size_t>(hash ^ hash >> 29);
+}
+
+bool Cache::Find(const Platform::FileIdentity& identity, uint32_t algorithms, Digests& digests) const {
+    std::lock_guard lock(mutex_);
+    const auto entry = entries_.find(identity);
+    if (entry == entries_.end() || (entry->second.algorithms & algorithms) != algorithms) {
+        return false;
+    }
+    digests = entry->second;
+    return true;
+}
+
+void Cache::Store(const Platform::FileIdentity& identity, const Digests& digests) {
+    std::lock_guard lock(mutex_);
+    if (entries_.size() >= capacity_ && entries_.find(identity) == entries_.end()) {
+        entries_.clear();
+    }
+    entries_[identity] = digests;
+}
+
+size_t Cache::Size() const {
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+}
+
+size_t Cache::Bytes() const {
+    std::lock_guard lock(mutex_);
+    return entries_.size() * kEntryBytes + entries_.bucket_count() * sizeof(void*);
+}
+
+void Cache::TrimTo(size_t bytes) {
+    std::lock_guard lock(mutex_);
+    const size_t table = entries_.bucket_count() * sizeof(void*);
+    const size_t keep = bytes > table ? (bytes - table) / kEntryBytes : 0;
+    while (entries_.size() > keep) {
+        entries_.erase(entries_.begin());
+    }
+    if (entries_.empty()) {
+        // Only a rehash from empty gives the bucket array back.
+        entries_ = {};
+    }
+}
+
+std::vector<FileResult> HashFiles(const std::vector<std::wstring>& paths, Cache* cache, OpenFn open,
+    const Options& options, Stats* stats) {
+    std::vector<FileResult> results(paths.size());
+    std::counting_semaphore<> ioSlots(std::max<std::ptrdiff_t>(options.ioConcurrency, 1));
+    std::atomic<size_t> next{ 0 };
+    std::atomic<uint64_t> bytesRead{ 0 };
+    std::atomic<uint32_t> filesHashed{ 0 };
+    std::atomic<uint32_t> cacheHits{ 0 };
+    const uint32_t algorithms = options.algorithms ? options.algorithms : uint32_t{ kSha256 };
+
+    auto work = [&] {
+        std::vector<uint8_t> buffer(std::max<size_t>(options.chunkBytes, 64 << 10));
+        uint64_t read = 0;
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < paths.size();) {
+            FileResult& result = results[i];
+            const auto file = open(paths[i]);
+            if (!file) {
+                result.status = Status::NoFile;
+                continue;
+            }
+            if (cache && cache->Find(file->Identity(), algorithms, result.digests)) {
+                result.status = Status::Cached;
+                cacheHits.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            result.status = HashFile(*file, algorithms, options.level, buffer, ioSlots, result.digests, read);
+            if (result.status == Status::Hashed) {
+                filesHashed.fetch_add(1, std::memory_order_relaxed);
+                if (cache) {
+                    cache->Store(file->Identity(), result.digests);
+                }
+            }
+        }
+        bytesRead.fetch_add(read, std::memory_order_relaxed);
+    };
+
+    const size_t workerCount = std::min<size_t>(std::max(options.threads, 1u), paths.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (stats) {
+        stats->bytesRead = bytesRead;
+        stats->filesHashed = filesHashed;
+        stats->cacheHits = cacheHits;
+    }
+    return results;
+}
+
+std::wstring Format(const FileResult& result, Algorithm algorithm) {
+    switch (result.status) {
+    case Status::Hashed:
+    case Status::Cached:
+        if ((result.digests.algorithms & algorithm) == 0) {
+            return L"";
+        }
+        if (algorithm == kPeChecksum) {
+            return PeChecksum::Summary(result.digests.peChecksum);
+        }
+        return algorithm == kSha1 ? Sha::ToHex(result.digests.sha1.data(), result.digests.sha1.size())
+                                  : Sha::ToHex(result.digests.sha256.data(), result.digests.sha256.size());
+    case Status::NoFile:
+        return L"No file";
+    case Status::ReadError:
+        return L"Read error";
+    default:
+        return L"";
+    }
+}
+
+} // namespace FileHash
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "PeChecksum.h"
+#include "Platform.h"
+#include "Sha.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Content hashes of module files, for allow-listing. A pool of workers each takes a file and reads it
+// front to back in large chunks, hashing each chunk as it arrives; at most ioConcurrency reads are in
+// flight across the pool, so a cold disk sees a few sequential streams rather than one per core, while
+// the other workers keep hashing what has already been read.
+//
+// The same read can verify the PE CheckSum (kPeChecksum): the headers are found in the first chunk and
+// every chunk is also added to a PeChecksum::Accumulator.
+//
+// Digests are memoized by Platform::FileIdentity. A file that has not changed since it was last hashed
+// costs one open and no reads, so repeating the pass over every loaded module is cheap.
+namespace FileHash {
+
+enum Algorithm : uint32_t {
+    kSha256 = 1,
+    kSha1 = 2,       // For tooling that still keys on SHA-1
+    kPeChecksum = 4, // Not a hash, but needs the same full read
+};
+
+enum class Status : uint8_t {
+    NotHashed,
+    Hashed,
+    Cached,    // Unchanged since an earlier pass; no bytes were read
+    NoFile,    // Could not be opened
+    ReadError,
+};
+
+struct Digests {
+    uint32_t algorithms = 0; // Which of the digests below are set
+    Sha::Sha256::Digest sha256{};
+    Sha::Sha1::Digest sha1{};
+    PeChecksum::Result peChecksum;
+};
+
+struct FileResult {
+    Status status = Status::NotHashed;
+    Digests digests;
+};
+
+/// @brief Opens a file for hashing. Must be thread-safe.
+using OpenFn = std::unique_ptr<Platform::SequentialFile> (*)(const std::wstring& path);
+
+/// @brief Opens the file with Platform::SequentialFile.
+std::unique_ptr<Platform::SequentialFile> OpenSequentialFile(const std::wstring& path);
+
+struct IdentityHash {
+    size_t operator()(const Platform::FileIdentity& identity) const;
+};
+
+// Digests by file identity. Thread-safe. When full it is emptied rather than aged, since a pass touches
+// every entry it will need again anyway.
+class Cache {
+public:
+    static constexpr size_t kDefaultCapacity = 8192;
+
+    explicit Cache(size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+    /// @brief Copies the cached digests for identity into digests if they include every algorithm asked for.
+    bool Find(const Platform::FileIdentity& identity, uint32_t algorithms, Digests& digests) const;
+
+    void Store(const Platform::FileIdentity& identity, const Digests& digests);
+
+    size_t Size() const;
+
+    /// @brief Approximate bytes held: each entry and its share of the table.
+    size_t Bytes() const;
+
+    /// @brief Drops entries, in no particular order, until at most bytes are held. A dropped file is
+    /// read again the next time it is hashed.
+    void TrimTo(size_t bytes);
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<Platform::FileIdentity, Digests, IdentityHash> entries_;
+    size_t capacity_;
+};
+
+struct Options {
+    uint32_t threads = 1;
+    uint32_t ioConcurrency = 2;  // Reads in flight at once, across all workers
+    size_t chunkBytes = 1 << 20; // Size of each sequential read
+    uint32_t algorithms = kSha256;
+    Simd::Level level = Simd::Active(); // For the PE checksum
+};
+
+struct Stats {
+    uint64_t bytesRead = 0;
+    uint32_t filesHashed = 0;
+    uint32_t cacheHits = 0;
+};
+
+/// @brief Hashes every file; the result is parallel to paths. cache and stats may be null.
+std::vector<FileResult> HashFiles(const std::vector<std::wstring>& paths, Cache* cache, OpenFn open,
+    const Options& options, Stats* stats = nullptr);
+
+/// @brief Column text: the digest for algorithm in lowercase hex (or PeChecksum::Summary), "No file",
+/// "Read error", or empty.
+std::wstring Format(const FileResult& result, Algorithm algorithm);
+
+} // namespace FileHash
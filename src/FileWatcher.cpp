@@ -0,0 +1,227 @@
+#include "FileWatcher.h"
+
+#include <cwctype>
+
+namespace {
+
+std::wstring Lower(std::wstring text) {
+    for (auto& c : text) {
+        c = static_cast<wchar_t>(std::towlower(c));
+    }
+    return text;
+}
+
+// Splits a full path into its directory (keeping the separator of a root such as "C:\" or "/") and
+// file name. Returns false for a bare name.
+bool SplitPath(const std::wstring& path, std::wstring& directory, std::wstring& name) {
+    const size_t slash = path.find_last_of(L"\\/");
+    if (slash == std::wstring::npos || slash + 1 == path.size()) {
+        return false;
+    }
+    const bool root = slash == 0 || path[slash - 1] == L':';
+    directory = path.substr(0, root ? slash + 1 : slash);
+    name = path.substr(slash + 1);
+    return true;
+}
+
+std::wstring PendingKey(const std::wstring& lowerDirectory, const std::wstring& lowerName) {
+    return lowerDirectory + L'\n' + lowerName;
+}
+
+} // namespace
+
+FileWatcher::FileWatcher(ChangedFn onChanged, void* context, std::chrono::milliseconds coalesce)
+    : onChanged_(onChanged), context_(context), coalesce_(coalesce),
+      watch_(Platform::DirectoryWatch::Create(&FileWatcher::OnEvent, this)),
+      thread_(&FileWatcher::RunFlush, this) {}
+
+FileWatcher::~FileWatcher() {
+    // The backend goes first so no event arrives once the flush thread is gone.
+    watch_.reset();
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void FileWatcher::SetFiles(const std::vector<std::wstring>& paths) {
+    std::lock_guard serialize(setMutex_);
+    // Most calls follow a refresh that loaded or unloaded nothing.
+    if (paths == files_) {
+        return;
+    }
+    files_ = paths;
+    std::vector<std::wstring> subscribe;
+    std::vector<std::wstring> unsubscribe;
+    {
+        std::lock_guard lock(mutex_);
+        std::unordered_map<std::wstring, Directory> next;
+        bool added = false;
+        const uint64_t now = generation_.load(std::memory_order_relaxed) + 1;
+        std::wstring directoryPath;
+        std::wstring name;
+        for (const auto& path : paths) {
+            if (!SplitPath(path, directoryPath, name)) {
+                continue;
+            }
+            auto lowerDirectory = Lower(directoryPath);
+            auto [directory, newDirectory] = next.try_emplace(lowerDirectory);
+            const auto previous = directories_.find(lowerDirectory);
+            if (newDirectory) {
+                directory->second.path = directoryPath;
+                directory->second.subscribed = previous != directories_.end() && previous->second.subscribed;
+            }
+            auto lowerName = Lower(name);
+            auto [file, newFile] = directory->second.files.try_emplace(lowerName);
+            if (!newFile) {
+                continue;
+            }
+            file->second.path = path;
+            const File* known = nullptr;
+            if (previous != directories_.end()) {
+                const auto found = previous->second.files.find(lowerName);
+                known = found == previous->second.files.end() ? nullptr : &found->second;
+            }
+            if (known) {
+                file->second.changed = known->changed;
+            } else {
+                file->second.changed = now;
+                added = true;
+            }
+        }
+        for (auto& [key, directory] : next) {
+            if (!directory.subscribed) {
+                subscribe.push_back(key);
+            }
+        }
+        for (const auto& [key, directory] : directories_) {
+            if (directory.subscribed && !next.count(key)) {
+                unsubscribe.push_back(directory.path);
+            }
+        }
+        directories_ = std::move(next);
+        if (added) {
+            generation_.store(now, std::memory_order_release);
+        }
+    }
+
+    if (!watch_) {
+        return;
+    }
+    // A directory that could not be subscribed is tried again only once the file set changes.
+    for (const auto& path : unsubscribe) {
+        watch_->Remove(path);
+    }
+    for (auto& key : subscribe) {
+        std::wstring path;
+        {
+            std::lock_guard lock(mutex_);
+            path = directories_[key].path;
+        }
+        const bool subscribed = watch_->Add(path);
+        std::lock_guard lock(mutex_);
+        directories_[key].subscribed = subscribed;
+    }
+}
+
+uint64_t FileWatcher::Generation(const std::wstring& path) const {
+    std::wstring directory;
+    std::wstring name;
+    if (!SplitPath(path, directory, name)) {
+        return 0;
+    }
+    std::lock_guard lock(mutex_);
+    const auto found = directories_.find(Lower(directory));
+    if (found == directories_.end()) {
+        return 0;
+    }
+    const auto file = found->second.files.find(Lower(name));
+    return file == found->second.files.end() ? 0 : file->second.changed;
+}
+
+FileWatcher::Stats FileWatcher::GetStats() const {
+    std::lock_guard lock(mutex_);
+    Stats stats = { events_, flushes_, filesChanged_, 0, 0 };
+    for (const auto& [key, directory] : directories_) {
+        stats.directories += directory.subscribed;
+        stats.files += static_cast<uint32_t>(directory.files.size());
+    }
+    return stats;
+}
+
+void FileWatcher::OnEvent(void* context, const std::wstring& directoryPath, const std::wstring& name) {
+    auto* self = static_cast<FileWatcher*>(context);
+    bool first = false;
+    {
+        std::lock_guard lock(self->mutex_);
+        const auto lowerDirectory = Lower(directoryPath);
+        const auto directory = self->directories_.find(lowerDirectory);
+        if (directory == self->directories_.end()) {
+            return;
+        }
+        const size_t pendingBefore = self->pending_.size();
+        if (name.empty()) {
+            for (const auto& [lowerName, file] : directory->second.files) {
+                self->pending_.insert(PendingKey(lowerDirectory, lowerName));
+            }
+        } else {
+            auto lowerName = Lower(name);
+            if (!directory->second.files.count(lowerName)) {
+                return;
+            }
+            self->pending_.insert(PendingKey(lowerDirectory, lowerName));
+        }
+        ++self->events_;
+        // The window opens with the first event and is not extended, so a steady trickle of writes
+        // still produces a delivery every window.
+        first = pendingBefore == 0 && !self->pending_.empty();
+        if (first) {
+            self->flushAt_ = std::chrono::steady_clock::now() + self->coalesce_;
+        }
+    }
+    if (first) {
+        self->wake_.notify_all();
+    }
+}
+
+void FileWatcher::RunFlush() {
+    std::unique_lock lock(mutex_);
+    std::vector<std::wstring> changed;
+    for (;;) {
+        wake_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (stopping_) {
+            return;
+        }
+        if (wake_.wait_until(lock, flushAt_, [this] { return stopping_; })) {
+            return;
+        }
+        // Stamp before delivering, so caches consulted by whatever onChanged_ triggers already see it.
+        const uint64_t generation = generation_.load(std::memory_order_relaxed) + 1;
+        changed.clear();
+        for (const auto& key : pending_) {
+            const size_t separator = key.find(L'\n');
+            const auto directory = directories_.find(key.substr(0, separator));
+            if (directory == directories_.end()) {
+                continue;
+            }
+            const auto file = directory->second.files.find(key.substr(separator + 1));
+            if (file == directory->second.files.end()) {
+                continue;
+            }
+            file->second.changed = generation;
+            changed.push_back(file->second.path);
+        }
+        pending_.clear();
+        if (changed.empty()) {
+            continue;
+        }
+        generation_.store(generation, std::memory_order_release);
+        ++flushes_;
+        filesChanged_ += changed.size();
+        lock.unlock();
+        onChanged_(context_, changed);
+        lock.lock();
+    }
+}
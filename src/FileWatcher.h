@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Platform.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Notices when the file behind a loaded module is replaced, rewritten or deleted. Files are watched
+// through one Platform::DirectoryWatch subscription per directory, however many modules it holds, and
+// events for other entries in those directories are dropped. Events that arrive within the coalescing
+// window of the first one are delivered together, so an installer replacing a directory of DLLs causes
+// one notification rather than hundreds.
+//
+// Every delivery bumps a generation number and stamps each changed file with it. A cache keyed by path
+// records Generation() when it fills an entry and, on a hit, re-reads only if Generation(path) has moved
+// past that; nothing needs to be told which entries to drop, and an unchanged Generation() makes the
+// check a single atomic load.
+class FileWatcher {
+public:
+    /// @brief Called on the watcher's thread with the files (as passed to SetFiles) that changed.
+    using ChangedFn = void (*)(void* context, const std::vector<std::wstring>& paths);
+
+    struct Stats {
+        uint64_t events;       // Backend events for watched files, including overflows
+        uint64_t flushes;      // ChangedFn calls
+        uint64_t filesChanged; // Paths delivered across all flushes
+        uint32_t directories;  // Directories currently subscribed
+        uint32_t files;        // Files currently watched
+    };
+
+    FileWatcher(ChangedFn onChanged, void* context, std::chrono::milliseconds coalesce);
+
+    /// @brief Stops the backend and the flush thread; no callback runs after it returns. Pending events
+    /// are dropped.
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /// @brief False if the platform backend could not be started; SetFiles still tracks files, but
+    /// nothing is ever reported changed.
+    bool IsWatching() const { return watch_ != nullptr; }
+
+    /// @brief Replaces the set of watched files (full paths; compared ignoring case), subscribing to
+    /// directories that gained their first file and unsubscribing from those that lost their last. A
+    /// file that was not already watched counts as changed now, since it could have been replaced while
+    /// nobody was looking. Must not be called from ChangedFn.
+    void SetFiles(const std::vector<std::wstring>& paths);
+
+    /// @brief Bumped on every delivery and whenever SetFiles adds files.
+    uint64_t Generation() const { return generation_.load(std::memory_order_acquire); }
+
+    /// @brief The generation at which path was last seen to change, or 0 if it has not been (or is not
+    /// watched).
+    uint64_t Generation(const std::wstring& path) const;
+
+    Stats GetStats() const;
+
+private:
+    struct File {
+        std::wstring path;
+        uint64_t changed = 0;
+    };
+
+    struct Directory {
+        std::wstring path;
+        bool subscribed = false;
+        std::unordered_map<std::wstring, File> files; // By lowercase name
+    };
+
+    static void OnEvent(void* context, const std::wstring& directory, const std::wstring& name);
+    void RunFlush();
+
+    ChangedFn onChanged_;
+    void* context_;
+    std::chrono::milliseconds coalesce_;
+    std::mutex setMutex_;            // Serializes SetFiles, which calls the backend outside mutex_
+    std::vector<std::wstring> files_; // As last passed to SetFiles; guarded by setMutex_
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unordered_map<std::wstring, Directory> directories_; // By lowercase path
+    std::unordered_set<std::wstring> pending_;                 // Lowercase directory + '\n' + lowercase name
+    std::chrono::steady_clock::time_point flushAt_;
+    bool stopping_ = false;
+    std::atomic<uint64_t> generation_{ 0 };
+    uint64_t events_ = 0;
+    uint64_t flushes_ = 0;
+    uint64_t filesChanged_ = 0;
+    std::unique_ptr<Platform::DirectoryWatch> watch_;
+    std::thread thread_; // Last, so it starts after everything it uses
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Platform-neutral GUID with the same field layout as the Win32 GUID, so tables of interface ids can
+// be built at compile time and used off Windows.
+struct Guid {
+    uint32_t data1;
+    uint16_t data2;
+    uint16_t data3;
+    uint8_t data4[8];
+
+    constexpr bool operator==(const Guid& other) const {
+        if (data1 != other.data1 || data2 != other.data2 || data3 != other.data3) {
+            return false;
+        }
+        for (size_t i = 0; i < 8; ++i) {
+            if (data4[i] != other.data4[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief Parses "XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX" (no braces). Malformed text fails constant
+    /// evaluation, so typos in compile-time tables are caught by the compiler.
+    static constexpr Guid Parse(const char* text) {
+        Guid guid{};
+        size_t pos = 0;
+        guid.data1 = static_cast<uint32_t>(ParseHex(text, pos, 8));
+        Expect(text, pos, '-');
+        guid.data2 = static_cast<uint16_t>(ParseHex(text, pos, 4));
+        Expect(text, pos, '-');
+        guid.data3 = static_cast<uint16_t>(ParseHex(text, pos, 4));
+        Expect(text, pos, '-');
+        guid.data4[0] = static_cast<uint8_t>(ParseHex(text, pos, 2));
+        guid.data4[1] = static_cast<uint8_t>(ParseHex(text, pos, 2));
+        Expect(text, pos, '-');
+        for (size_t i = 2; i < 8; ++i) {
+            guid.data4[i] = static_cast<uint8_t>(ParseHex(text, pos, 2));
+        }
+        Expect(text, pos, '\0');
+        return guid;
+    }
+
+    /// @brief Registry-style text: "{XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX}".
+    std::wstring ToString() const;
+
+private:
+    static constexpr uint64_t ParseHex(const char* text, size_t& pos, size_t digits) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < digits; ++i, ++pos) {
+            const char ch = text[pos];
+            uint64_t digit = 0;
+            if (ch >= '0' && ch <= '9') {
+                digit = static_cast<uint64_t>(ch - '0');
+            } else if (ch >= 'a' && ch <= 'f') {
+                digit = static_cast<uint64_t>(ch - 'a' + 10);
+            } else if (ch >= 'A' && ch <= 'F') {
+                digit = static_cast<uint64_t>(ch - 'A' + 10);
+            } else {
+                throw "Guid::Parse: invalid hex digit";
+            }
+            value = (value << 4) | digit;
+        }
+        return value;
+    }
+
+    static constexpr void Expect(const char* text, size_t& pos, char expected) {
+        if (text[pos] != expected) {
+            throw "Guid::Parse: malformed GUID";
+        }
+        if (expected != '\0') {
+            ++pos;
+        }
+    }
+};
+
+struct GuidHash {
+    size_t operator()(const Guid& guid) const {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        auto mix = [&hash](uint64_t value) {
+            hash ^= value;
+            hash *= 0x100000001b3ull;
+        };
+        mix(guid.data1);
+        mix((static_cast<uint64_t>(guid.data2) << 16) | guid.data3);
+        for (uint8_t byte : guid.data4) {
+            mix(byte);
+        }
+        return static_cast<size_t>(hash);
+    }
+};
@@ -0,0 +1,458 @@
+#include "HookScan.h"
+
+#include "PeImage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cwchar>
+#include <iterator>
+#include <thread>
+
+namespace HookScan {
+namespace {
+
+constexpr size_t kImportDescriptorSize = 20;
+constexpr size_t kExportDirectorySize = 40;
+constexpr size_t kMaxNameChars = 4096;
+constexpr uint32_t kMaxDescriptors = 4096;
+constexpr uint32_t kMaxEntries = 65536;
+// Forwarder chains are short in practice (kernel32 -> kernelbase -> ntdll); a longer one is a loop.
+constexpr int kMaxForwards = 8;
+
+char LowerAscii(wchar_t ch) {
+    if (ch >= L'A' && ch <= L'Z') {
+        return static_cast<char>(ch - L'A' + 'a');
+    }
+    return ch < 0x80 ? static_cast<char>(ch) : '?';
+}
+
+std::string LowerDllName(std::string_view name) {
+    std::string lower;
+    lower.reserve(name.size() + 4);
+    for (char ch : name) {
+        lower += LowerAscii(static_cast<unsigned char>(ch));
+    }
+    if (lower.find('.') == std::string::npos) {
+        lower += ".dll";
+    }
+    return lower;
+}
+
+std::wstring_view FileName(std::wstring_view path) {
+    const size_t slash = path.find_last_of(L"\\/");
+    return slash == std::wstring_view::npos ? path : path.substr(slash + 1);
+}
+
+// A NUL-terminated ASCII string at an RVA, or empty if it is not terminated within the image.
+std::string_view CStringAt(const PeImage::View& view, uint32_t rva) {
+    size_t offset = 0;
+    if (!view.RvaToOffset(rva, 1, offset)) {
+        return {};
+    }
+    const auto* first = reinterpret_cast<const char*>(view.Data() + offset);
+    const size_t limit = std::min(view.Size() - offset, kMaxNameChars);
+    const auto* nul = static_cast<const char*>(std::memchr(first, 0, limit));
+    return nul ? std::string_view(first, static_cast<size_t>(nul - first)) : std::string_view();
+}
+
+bool ReadU32(const PeImage::View& view, uint64_t rva, uint32_t& value) {
+    const uint8_t* data = rva <= UINT32_MAX ? view.AtRva(static_cast<uint32_t>(rva), sizeof(value)) : nullptr;
+    if (!data) {
+        return false;
+    }
+    value = PeImage::ReadAt<uint32_t>(data, 0);
+    return true;
+}
+
+bool ReadThunk(const PeImage::View& view, uint64_t rva, uint64_t& value) {
+    const size_t width = view.Is64Bit() ? 8 : 4;
+    const uint8_t* data = rva <= UINT32_MAX ? view.AtRva(static_cast<uint32_t>(rva), width) : nullptr;
+    if (!data) {
+        return false;
+    }
+    value = width == 8 ? PeImage::ReadAt<uint64_t>(data, 0) : PeImage::ReadAt<uint32_t>(data, 0);
+    return true;
+}
+
+struct ExportDirectory {
+    PeImage::DataDirectory range = {};
+    uint32_t ordinalBase = 0;
+    uint32_t functionCount = 0;
+    uint32_t nameCount = 0;
+    uint32_t functions = 0;
+    uint32_t names = 0;
+    uint32_t ordinals = 0;
+};
+
+bool ReadExportDirectory(const PeImage::View& view, ExportDirectory& exports) {
+    exports.range = view.Directory(PeImage::kDirectoryExport);
+    const uint8_t* header = exports.range.rva != 0 ? view.AtRva(exports.range.rva, kExportDirectorySize) : nullptr;
+    if (!header) {
+        return false;
+    }
+    exports.ordinalBase = PeImage::ReadAt<uint32_t>(header, 16);
+    exports.functionCount = std::min(PeImage::ReadAt<uint32_t>(header, 20), kMaxEntries);
+    exports.nameCount = std::min(PeImage::ReadAt<uint32_t>(header, 24), kMaxEntries);
+    exports.functions = PeImage::ReadAt<uint32_t>(header, 28);
+    exports.names = PeImage::ReadAt<uint32_t>(header, 32);
+    exports.ordinals = PeImage::ReadAt<uint32_t>(header, 36);
+    return true;
+}
+
+// "#12" or "slot 3": appended rather than concatenated, which GCC 12 misreports under -Wrestrict.
+std::string NumberedName(const char* prefix, uint64_t number) {
+    std::string name = prefix;
+    name += std::to_string(number);
+    return name;
+}
+
+bool IsForwarder(const ExportDirectory& exports, uint32_t rva) {
+    return rva >= exports.range.rva && rva - exports.range.rva < exports.range.size;
+}
+
+class Scanner {
+public:
+    Scanner(const std::vector<Module>& modules, const ModuleIndex& index, ResolveFn resolve)
+        : modules_(modules), index_(index), resolve_(resolve) {
+        views_.reserve(modules.size());
+        for (const auto& module : modules) {
+            views_.emplace_back(module.image, module.image ? module.size : 0, PeImage::Layout::Mapped);
+        }
+    }
+
+    void ScanModule(uint32_t module, ModuleResult& result, std::vector<Finding>& findings) const {
+        if (!views_[module].IsValid()) {
+            return;
+        }
+        result.scanned = true;
+        ScanImports(module, result, findings);
+        ScanExports(module, result, findings);
+    }
+
+private:
+    uint32_t ResolveModule(std::string_view dllName) const {
+        uint32_t module = index_.FindByName(dllName);
+        if (module == kNoModule && resolve_) {
+            const uint64_t base = resolve_(dllName);
+            module = base ? index_.Find(base) : kNoModule;
+        }
+        return module;
+    }
+
+    // The address an export resolves to, by name or (with an empty name) by ordinal, following
+    // forwarders. 0 if it cannot be resolved.
+    uint64_t ResolveExport(uint32_t module, std::string_view name, uint32_t ordinal, int depth) const {
+        const auto& view = views_[module];
+        ExportDirectory exports;
+        if (!view.IsValid() || !ReadExportDirectory(view, exports)) {
+            return 0;
+        }
+
+        uint32_t index = UINT32_MAX;
+        if (!name.empty()) {
+            // The loader requires the name table sorted by strcmp; an unsorted one just fails to resolve.
+            uint32_t low = 0;
+            uint32_t high = exports.nameCount;
+            while (low < high) {
+                const uint32_t middle = low + (high - low) / 2;
+                uint32_t nameRva = 0;
+                if (!ReadU32(view, exports.names + middle * uint64_t{ 4 }, nameRva)) {
+                    return 0;
+                }
+                const int compare = CStringAt(view, nameRva).compare(name);
+                if (compare == 0) {
+                    const uint8_t* entry = view.AtRva(static_cast<uint32_t>(exports.ordinals + middle * uint64_t{ 2 }), 2);
+                    index = entry ? PeImage::ReadAt<uint16_t>(entry, 0) : UINT32_MAX;
+                    break;
+                }
+                if (compare < 0) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+        } else {
+            index = ordinal - exports.ordinalBase;
+        }
+
+        uint32_t rva = 0;
+        if (index >= exports.functionCount || !ReadU32(view, exports.functions + index * uint64_t{ 4 }, rva) || rva == 0) {
+            return 0;
+        }
+        if (!IsForwarder(exports, rva)) {
+            // A patched EAT entry is reported by ScanExports; it is no reference for the imports bound to it.
+            return rva < modules_[module].size ? modules_[module].base + rva : 0;
+        }
+
+        // "module.function" or "module.#ordinal"
+        const std::string_view forwarder = CStringAt(view, rva);
+        const size_t dot = forwarder.rfind('.');
+        if (depth >= kMaxForwards || dot == std::string_view::npos) {
+            return 0;
+        }
+        const uint32_t target = ResolveModule(forwarder.substr(0, dot));
+        const std::string_view function = forwarder.substr(dot + 1);
+        if (target == kNoModule || function.empty()) {
+            return 0;
+        }
+        if (function[0] == '#') {
+            uint32_t forwardedOrdinal = 0;
+            for (char ch : function.substr(1)) {
+                if (ch < '0' || ch > '9') {
+                    return 0;
+                }
+                forwardedOrdinal = forwardedOrdinal * 10 + static_cast<uint32_t>(ch - '0');
+            }
+            return ResolveExport(target, {}, forwardedOrdinal, depth + 1);
+        }
+        return ResolveExport(target, function, 0, depth + 1);
+    }
+
+    void ScanImports(uint32_t module, ModuleResult& result, std::vector<Finding>& findings) const {
+        const auto& view = views_[module];
+        const auto directory = view.Directory(PeImage::kDirectoryImport);
+        if (directory.rva == 0) {
+            return;
+        }
+        const uint64_t width = view.Is64Bit() ? 8 : 4;
+        const uint64_t ordinalFlag = view.Is64Bit() ? 0x8000000000000000ull : 0x80000000ull;
+
+        for (uint32_t d = 0; d < kMaxDescriptors; ++d) {
+            const uint64_t descriptorRva = directory.rva + uint64_t{ d } * kImportDescriptorSize;
+            const uint8_t* descriptor = descriptorRva <= UINT32_MAX
+                ? view.AtRva(static_cast<uint32_t>(descriptorRva), kImportDescriptorSize) : nullptr;
+            if (!descriptor) {
+                return;
+            }
+            const uint32_t lookupTable = PeImage::ReadAt<uint32_t>(descriptor, 0);
+            const uint32_t nameRva = PeImage::ReadAt<uint32_t>(descriptor, 12);
+            const uint32_t addressTable = PeImage::ReadAt<uint32_t>(descriptor, 16);
+            if (nameRva == 0 && addressTable == 0) {
+                return;
+            }
+            const std::string_view dllName = CStringAt(view, nameRva);
+            const uint32_t target = dllName.empty() ? kNoModule : ResolveModule(dllName);
+
+            for (uint32_t slot = 0; slot < kMaxEntries; ++slot) {
+                const uint64_t slotRva = addressTable + slot * width;
+                uint64_t actual = 0;
+                uint64_t lookup = 0;
+                if (!ReadThunk(view, slotRva, actual)) {
+                    break;
+                }
+                // Without a lookup table the names are gone once the loader has filled the IAT, so only
+                // the range check applies.
+                if (lookupTable != 0 ? !ReadThunk(view, lookupTable + slot * width, lookup) || lookup == 0 : actual == 0) {
+                    break;
+                }
+                ++result.importsChecked;
+
+                std::string_view function;
+                uint32_t ordinal = 0;
+                if (lookup & ordinalFlag) {
+                    ordinal = static_cast<uint32_t>(lookup & 0xFFFF);
+                } else if (lookup != 0) {
+                    function = CStringAt(view, static_cast<uint32_t>((lookup & 0x7FFFFFFF) + 2));
+                }
+                const bool named = !function.empty() || ordinal != 0;
+                const uint64_t expected = target != kNoModule && named ? ResolveExport(target, function, ordinal, 0) : 0;
+                const uint32_t owner = index_.Find(actual);
+                if (expected != 0 ? actual == expected : owner != kNoModule) {
+                    continue;
+                }
+
+                Finding finding;
+                finding.module = module;
+                finding.table = Table::Import;
+                finding.verdict = owner == kNoModule ? Verdict::Unbacked : Verdict::Redirected;
+                finding.function = !function.empty() ? std::string(function)
+                    : ordinal != 0 ? NumberedName("#", ordinal) : NumberedName("slot ", slot);
+                finding.importedFrom = std::string(dllName);
+                finding.slotRva = static_cast<uint32_t>(slotRva);
+                finding.expected = expected;
+                finding.actual = actual;
+                finding.actualModule = owner;
+                findings.push_back(std::move(finding));
+                ++result.hooked;
+            }
+        }
+    }
+
+    void ScanExports(uint32_t module, ModuleResult& result, std::vector<Finding>& findings) const {
+        const auto& view = views_[module];
+        const Module& self = modules_[module];
+        ExportDirectory exports;
+        if (!ReadExportDirectory(view, exports)) {
+            return;
+        }
+        for (uint32_t i = 0; i < exports.functionCount; ++i) {
+            const uint64_t entryRva = exports.functions + i * uint64_t{ 4 };
+            uint32_t rva = 0;
+            if (!ReadU32(view, entryRva, rva)) {
+                break;
+            }
+            if (rva == 0 || IsForwarder(exports, rva)) {
+                continue;
+            }
+            ++result.exportsChecked;
+            if (rva < self.size) {
+                continue;
+            }
+
+            Finding finding;
+            finding.module = module;
+            finding.table = Table::Export;
+            finding.actual = self.base + rva;
+            finding.actualModule = index_.Find(finding.actual);
+            finding.verdict = finding.actualModule == kNoModule ? Verdict::Unbacked : Verdict::Redirected;
+            finding.function = ExportName(view, exports, i);
+            finding.slotRva = static_cast<uint32_t>(entryRva);
+            findings.push_back(std::move(finding));
+            ++result.hooked;
+        }
+    }
+
+    // Only called for findings, so a linear search of the name table is fine.
+    static std::string ExportName(const PeImage::View& view, const ExportDirectory& exports, uint32_t index) {
+        for (uint32_t i = 0; i < exports.nameCount; ++i) {
+            const uint8_t* entry = view.AtRva(static_cast<uint32_t>(exports.ordinals + i * uint64_t{ 2 }), 2);
+            uint32_t nameRva = 0;
+            if (!entry || !ReadU32(view, exports.names + i * uint64_t{ 4 }, nameRva)) {
+                break;
+            }
+            if (PeImage::ReadAt<uint16_t>(entry, 0) == index) {
+                return std::string(CStringAt(view, nameRva));
+            }
+        }
+        return NumberedName("#", uint64_t{ exports.ordinalBase } + index);
+    }
+
+    const std::vector<Module>& modules_;
+    const ModuleIndex& index_;
+    ResolveFn resolve_;
+    std::vector<PeImage::View> views_;
+};
+
+std::wstring Widen(std::string_view text) {
+    return std::wstring(text.begin(), text.end());
+}
+
+} // namespace
+
+ModuleIndex::ModuleIndex(const std::vector<Module>& modules) {
+    ranges_.reserve(modules.size());
+    names_.reserve(modules.size());
+    for (uint32_t i = 0; i < modules.size(); ++i) {
+        const auto& module = modules[i];
+        if (module.size != 0) {
+            ranges_.push_back({ module.base, module.base + module.size, i });
+        }
+        std::string name;
+        for (wchar_t ch : FileName(module.path)) {
+            name += LowerAscii(ch);
+        }
+        names_.emplace_back(std::move(name), i);
+    }
+    std::sort(ranges_.begin(), ranges_.end(), [](const Range& left, const Range& right) {
+        return left.start < right.start;
+    });
+    std::sort(names_.begin(), names_.end());
+}
+
+uint32_t ModuleIndex::Find(uint64_t address) const {
+    auto it = std::upper_bound(ranges_.begin(), ranges_.end(), address, [](uint64_t value, const Range& range) {
+        return value < range.start;
+    });
+    if (it == ranges_.begin()) {
+        return kNoModule;
+    }
+    --it;
+    return address < it->end ? it->module : kNoModule;
+}
+
+uint32_t ModuleIndex::FindBase(uint64_t base) const {
+    auto it = std::lower_bound(ranges_.begin(), ranges_.end(), base, [](const Range& range, uint64_t value) {
+        return range.start < value;
+    });
+    return it != ranges_.end() && it->start == base ? it->module : kNoModule;
+}
+
+uint32_t ModuleIndex::FindByName(std::string_view dllName) const {
+    const std::string name = LowerDllName(dllName);
+    auto it = std::lower_bound(names_.begin(), names_.end(), name, [](const auto& entry, const std::string& value) {
+        return entry.first < value;
+    });
+    return it != names_.end() && it->first == name ? it->second : kNoModule;
+}
+
+Report Scan(const std::vector<Module>& modules, ResolveFn resolve, uint32_t threads) {
+    const ModuleIndex index(modules);
+    const Scanner scanner(modules, index, resolve);
+    Report report;
+    report.modules.resize(modules.size());
+    std::vector<std::vector<Finding>> findings(modules.size());
+
+    std::atomic<size_t> next{ 0 };
+    auto work = [&] {
+        for (size_t module; (module = next.fetch_add(1, std::memory_order_relaxed)) < modules.size();) {
+            scanner.ScanModule(static_cast<uint32_t>(module), report.modules[module], findings[module]);
+        }
+    };
+    const size_t workerCount = std::min<size_t>(std::max(threads, 1u), modules.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (auto& moduleFindings : findings) {
+        std::move(moduleFindings.begin(), moduleFindings.end(), std::back_inserter(report.findings));
+    }
+    return report;
+}
+
+std::wstring FormatFindings(const Report& report, const std::vector<Module>& modules, uint32_t module, size_t maxLines) {
+    auto first = std::lower_bound(report.findings.begin(), report.findings.end(), module,
+        [](const Finding& finding, uint32_t value) { return finding.module < value; });
+    std::wstring text;
+    size_t lines = 0;
+    size_t skipped = 0;
+    for (auto it = first; it != report.findings.end() && it->module == module; ++it) {
+        if (lines == maxLines) {
+            ++skipped;
+            continue;
+        }
+        const Finding& finding = *it;
+        text += finding.table == Table::Import ? L"IAT " : L"EAT ";
+        if (!finding.importedFrom.empty()) {
+            text += Widen(finding.importedFrom) + L"!";
+        }
+        text += Widen(finding.function);
+
+        wchar_t line[160] = {};
+        std::swprintf(line, std::size(line), L" -> 0x%016llX", static_cast<unsigned long long>(finding.actual));
+        text += line;
+        if (finding.actualModule != kNoModule && finding.actualModule < modules.size()) {
+            text += L" in ";
+            text += FileName(modules[finding.actualModule].path);
+        } else {
+            text += L" (outside every module)";
+        }
+        if (finding.expected != 0) {
+            std::swprintf(line, std::size(line), L", expected 0x%016llX", static_cast<unsigned long long>(finding.expected));
+            text += line;
+        }
+        text += L"\n";
+        ++lines;
+    }
+    if (skipped != 0) {
+        text += L"... and " + std::to_wstring(skipped) + L" more\n";
+    }
+    return text;
+}
+
+} // namespace HookScan
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Finds import and export address table entries that have been redirected, e.g. by third-party code
+// patching the tables of modules loaded into Explorer. Works over images as the loader maps them
+// (PeImage::Layout::Mapped), so it runs against the live process on Windows and against synthetic images
+// anywhere.
+//
+// Each IAT slot is checked against the address its import resolves to through the target module's
+// export table (following forwarders); if that cannot be resolved, only a pointer outside every module
+// is flagged. Each EAT entry must stay inside its own module. Addresses are attributed to modules with a
+// sorted interval index.
+namespace HookScan {
+
+constexpr uint32_t kNoModule = UINT32_MAX;
+
+struct Module {
+    std::wstring path;      // Imports are matched against the file name, case-insensitively
+    uint64_t base = 0;      // Address the image is loaded at
+    const uint8_t* image = nullptr; // The mapped image, size bytes readable; nullptr to skip the module
+    size_t size = 0;        // SizeOfImage
+};
+
+enum class Table : uint8_t {
+    Import,
+    Export,
+};
+
+enum class Verdict : uint8_t {
+    Redirected, // Points into a module other than the one it resolves to
+    Unbacked,   // Points outside every module (typically a trampoline in allocated memory)
+};
+
+struct Finding {
+    uint32_t module = 0;      // Index of the scanned module
+    Table table = Table::Import;
+    Verdict verdict = Verdict::Redirected;
+    std::string function;     // Name, or "#ordinal"
+    std::string importedFrom; // Imports: the DLL the descriptor names
+    uint32_t slotRva = 0;     // RVA of the IAT slot or EAT entry
+    uint64_t expected = 0;    // Resolved target, 0 if it could not be resolved
+    uint64_t actual = 0;
+    uint32_t actualModule = kNoModule;
+};
+
+struct ModuleResult {
+    uint32_t importsChecked = 0;
+    uint32_t exportsChecked = 0;
+    uint32_t hooked = 0;
+    bool scanned = false; // False if the image was skipped or its headers are invalid
+};
+
+// Module address ranges sorted by start, and file names sorted for import resolution.
+class ModuleIndex {
+public:
+    explicit ModuleIndex(const std::vector<Module>& modules);
+
+    /// @brief The module whose [base, base + size) contains address, or kNoModule.
+    uint32_t Find(uint64_t address) const;
+
+    /// @brief The module loaded exactly at base, or kNoModule.
+    uint32_t FindBase(uint64_t base) const;
+
+    /// @brief The module loaded under an ASCII DLL name (".dll" assumed without an extension), or kNoModule.
+    uint32_t FindByName(std::string_view dllName) const;
+
+private:
+    struct Range {
+        uint64_t start;
+        uint64_t end;
+        uint32_t module;
+    };
+
+    std::vector<Range> ranges_;
+    std::vector<std::pair<std::string, uint32_t>> names_; // Lower-case file name, module
+};
+
+/// @brief Resolves a DLL name the module list cannot (an API set, say) to the base of the module that
+/// implements it, or 0. Must be thread-safe.
+using ResolveFn = uint64_t (*)(std::string_view dllName);
+
+struct Report {
+    std::vector<ModuleResult> modules; // Parallel to the scanned modules
+    std::vector<Finding> findings;     // By module, then table, then slot RVA
+};
+
+/// @brief Scans every module's import and export address tables on up to threads threads.
+Report Scan(const std::vector<Module>& modules, ResolveFn resolve, uint32_t threads);
+
+/// @brief One line per finding of the module, at most maxLines, with a "... and n more" line if cut.
+std::wstring FormatFindings(const Report& report, const std::vector<Module>& modules, uint32_t module, size_t maxLines);
+
+} // namespace HookScan
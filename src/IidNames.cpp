@@ -1,45 +1,25 @@
 #include "IidNames.h"
 
-#include <objbase.h>
-#include <shlobj.h>
-#include <strsafe.h>
-#include <ModuleFolder.h>
+#include "IidTable.h"
+
+#include <cstring>
 
 namespace IidNames {
-namespace {
-const wchar_t* LookupName(REFIID iid) {
-    // Custom
-    if (IsEqualIID(iid, CLSID_ModuleFolder)) return L"CLSID_ModuleFolder";
 
-    // Windows
-    if (IsEqualIID(iid, IID_IUnknown)) return L"IUnknown";
-    if (IsEqualIID(iid, IID_IClassFactory)) return L"IClassFactory";
-    if (IsEqualIID(iid, IID_IShellFolder)) return L"IShellFolder";
-    if (IsEqualIID(iid, IID_IShellFolder2)) return L"IShellFolder2";
-    if (IsEqualIID(iid, IID_IPersist)) return L"IPersist";
-    if (IsEqualIID(iid, IID_IPersistFolder)) return L"IPersistFolder";
-    if (IsEqualIID(iid, IID_IPersistFolder2)) return L"IPersistFolder2";
-    if (IsEqualIID(iid, IID_IDropTarget)) return L"IDropTarget";
-    if (IsEqualIID(iid, IID_IShellView)) return L"IShellView";
-    if (IsEqualIID(iid, IID_IDataObject)) return L"IDataObject";
-    if (IsEqualIID(iid, IID_IEnumIDList)) return L"IEnumIDList";
-    return nullptr;
+static_assert(sizeof(Guid) == sizeof(GUID), "Guid must mirror the GUID layout");
+
+Guid ToGuid(REFIID iid) {
+    Guid guid;
+    std::memcpy(&guid, &iid, sizeof(guid));
+    return guid;
 }
-} // namespace
 
 std::wstring ToString(REFIID iid) {
-    wchar_t iidText[64] = {};
-    if (StringFromGUID2(iid, iidText, ARRAYSIZE(iidText)) == 0) {
-        lstrcpyW(iidText, L"<invalid>");
-    }
-
-    const wchar_t* name = LookupName(iid);
+    const Guid guid = ToGuid(iid);
+    const wchar_t* name = IidTable::Lookup(guid);
     if (!name) {
-        return iidText;
+        return guid.ToString();
     }
-
-    wchar_t combined[128] = {};
-    StringCchPrintfW(combined, ARRAYSIZE(combined), L"%s (%s)", name, iidText);
-    return combined;
+    return std::wstring(name) + L" (" + guid.ToString() + L")";
 }
 } // namespace IidNames
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "Guid.h"
+
 #include <windows.h>
 #include <string>
 
 namespace IidNames {
+/// @brief "Name ({GUID})" for interfaces in IidTable, otherwise just the registry-style GUID.
 std::wstring ToString(REFIID iid);
+
+Guid ToGuid(REFIID iid);
 } // namespace IidNames
@@ -0,0 +1,533 @@
+#include "IidTable.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+
+namespace IidTable {
+namespace {
+
+struct Entry {
+    const char* guid;
+    const wchar_t* name;
+};
+
+// Keep entries grouped by area. Anything Explorer asks for that is missing here shows up by GUID in the
+// QueryInterface profile (see QiProfiler), which is the cue to add it.
+constexpr Entry kEntries[] = {
+    // This extension
+    { "6B4E2E3B-3D6B-4D4E-9A1C-0F0C8D8E8F11", L"CLSID_ModuleFolder" },
+
+    // COM core
+    { "00000000-0000-0000-C000-000000000046", L"IUnknown" },
+    { "00000001-0000-0000-C000-000000000046", L"IClassFactory" },
+    { "00000002-0000-0000-C000-000000000046", L"IMalloc" },
+    { "00000003-0000-0000-C000-000000000046", L"IMarshal" },
+    { "0000000A-0000-0000-C000-000000000046", L"ILockBytes" },
+    { "0000000B-0000-0000-C000-000000000046", L"IStorage" },
+    { "0000000C-0000-0000-C000-000000000046", L"IStream" },
+    { "0000000D-0000-0000-C000-000000000046", L"IEnumSTATSTG" },
+    { "0000000E-0000-0000-C000-000000000046", L"IBindCtx" },
+    { "0000000F-0000-0000-C000-000000000046", L"IMoniker" },
+    { "00000010-0000-0000-C000-000000000046", L"IRunningObjectTable" },
+    { "00000012-0000-0000-C000-000000000046", L"IRootStorage" },
+    { "00000016-0000-0000-C000-000000000046", L"IMessageFilter" },
+    { "00000018-0000-0000-C000-000000000046", L"IStdMarshalInfo" },
+    { "00000019-0000-0000-C000-000000000046", L"IExternalConnection" },
+    { "0000001D-0000-0000-C000-000000000046", L"IMallocSpy" },
+    { "00000020-0000-0000-C000-000000000046", L"IMultiQI" },
+    { "00000035-0000-0000-C000-000000000046", L"IActivationFactory" },
+    { "00000037-0000-0000-C000-000000000046", L"IWeakReference" },
+    { "00000038-0000-0000-C000-000000000046", L"IWeakReferenceSource" },
+    { "00000100-0000-0000-C000-000000000046", L"IEnumUnknown" },
+    { "00000101-0000-0000-C000-000000000046", L"IEnumString" },
+    { "00000102-0000-0000-C000-000000000046", L"IEnumMoniker" },
+    { "00000103-0000-0000-C000-000000000046", L"IEnumFORMATETC" },
+    { "00000104-0000-0000-C000-000000000046", L"IEnumOLEVERB" },
+    { "00000105-0000-0000-C000-000000000046", L"IEnumSTATDATA" },
+    { "00000109-0000-0000-C000-000000000046", L"IPersistStream" },
+    { "0000010A-0000-0000-C000-000000000046", L"IPersistStorage" },
+    { "0000010B-0000-0000-C000-000000000046", L"IPersistFile" },
+    { "0000010C-0000-0000-C000-000000000046", L"IPersist" },
+    { "0000010D-0000-0000-C000-000000000046", L"IViewObject" },
+    { "0000010E-0000-0000-C000-000000000046", L"IDataObject" },
+    { "0000010F-0000-0000-C000-000000000046", L"IAdviseSink" },
+    { "00000110-0000-0000-C000-000000000046", L"IDataAdviseHolder" },
+    { "00000111-0000-0000-C000-000000000046", L"IOleAdviseHolder" },
+    { "00000112-0000-0000-C000-000000000046", L"IOleObject" },
+    { "00000113-0000-0000-C000-000000000046", L"IOleInPlaceObject" },
+    { "00000114-0000-0000-C000-000000000046", L"IOleWindow" },
+    { "00000115-0000-0000-C000-000000000046", L"IOleInPlaceUIWindow" },
+    { "00000116-0000-0000-C000-000000000046", L"IOleInPlaceFrame" },
+    { "00000117-0000-0000-C000-000000000046", L"IOleInPlaceActiveObject" },
+    { "00000118-0000-0000-C000-000000000046", L"IOleClientSite" },
+    { "00000119-0000-0000-C000-000000000046", L"IOleInPlaceSite" },
+    { "0000011A-0000-0000-C000-000000000046", L"IParseDisplayName" },
+    { "0000011B-0000-0000-C000-000000000046", L"IOleContainer" },
+    { "0000011C-0000-0000-C000-000000000046", L"IOleItemContainer" },
+    { "0000011D-0000-0000-C000-000000000046", L"IOleLink" },
+    { "0000011E-0000-0000-C000-000000000046", L"IOleCache" },
+    { "00000121-0000-0000-C000-000000000046", L"IDropSource" },
+    { "00000122-0000-0000-C000-000000000046", L"IDropTarget" },
+    { "00000125-0000-0000-C000-000000000046", L"IAdviseSink2" },
+    { "00000126-0000-0000-C000-000000000046", L"IRunnableObject" },
+    { "00000127-0000-0000-C000-000000000046", L"IViewObject2" },
+    { "00000128-0000-0000-C000-000000000046", L"IOleCache2" },
+    { "00000129-0000-0000-C000-000000000046", L"IOleCacheControl" },
+    { "00000131-0000-0000-C000-000000000046", L"IRemUnknown" },
+    { "00000138-0000-0000-C000-000000000046", L"IPropertyStorage" },
+    { "00000139-0000-0000-C000-000000000046", L"IEnumSTATPROPSTG" },
+    { "0000013A-0000-0000-C000-000000000046", L"IPropertySetStorage" },
+    { "0000013B-0000-0000-C000-000000000046", L"IEnumSTATPROPSETSTG" },
+    { "0000013D-0000-0000-C000-000000000046", L"IClientSecurity" },
+    { "0000013E-0000-0000-C000-000000000046", L"IServerSecurity" },
+    { "00000140-0000-0000-C000-000000000046", L"IClassActivator" },
+    { "00000143-0000-0000-C000-000000000046", L"IRemUnknown2" },
+    { "00000144-0000-0000-C000-000000000046", L"IRpcOptions" },
+    { "00000146-0000-0000-C000-000000000046", L"IGlobalInterfaceTable" },
+    { "000001CE-0000-0000-C000-000000000046", L"IComThreadingInfo" },
+    { "000001CF-0000-0000-C000-000000000046", L"IMarshal2" },
+    { "000001DA-0000-0000-C000-000000000046", L"IContextCallback" },
+    { "1C733A30-2A1C-11CE-ADE5-00AA0044773D", L"ICallFactory" },
+    { "94EA2B94-E9CC-49E0-C0FF-EE64CA8F5B90", L"IAgileObject" },
+    { "ECC8691B-C1DB-4DC0-855E-65F6C551AF49", L"INoMarshal" },
+    { "AF86E2E0-B12D-4C6A-9C5A-D7AA65101E90", L"IInspectable" },
+    { "99CAF010-415E-11CF-8814-00AA00B569F5", L"IFillLockBytes" },
+    { "A9D758A0-4617-11CF-95FC-00AA00680DB4", L"IProgressNotify" },
+
+    // Automation
+    { "00020400-0000-0000-C000-000000000046", L"IDispatch" },
+    { "00020401-0000-0000-C000-000000000046", L"ITypeInfo" },
+    { "00020402-0000-0000-C000-000000000046", L"ITypeLib" },
+    { "00020403-0000-0000-C000-000000000046", L"ITypeComp" },
+    { "00020404-0000-0000-C000-000000000046", L"IEnumVARIANT" },
+    { "00020405-0000-0000-C000-000000000046", L"ICreateTypeInfo" },
+    { "00020406-0000-0000-C000-000000000046", L"ICreateTypeLib" },
+    { "00020411-0000-0000-C000-000000000046", L"ITypeLib2" },
+    { "00020412-0000-0000-C000-000000000046", L"ITypeInfo2" },
+    { "1CF2B120-547D-101B-8E65-08002B2BD119", L"IErrorInfo" },
+    { "22F03340-547D-101B-8E65-08002B2BD119", L"ICreateErrorInfo" },
+    { "DF0B3D60-548F-101B-8E65-08002B2BD119", L"ISupportErrorInfo" },
+    { "A6EF9860-C720-11D0-9337-00A0C90DCAA9", L"IDispatchEx" },
+
+    // OLE controls and site plumbing
+    { "B196B283-BAB4-101A-B69C-00AA00341D07", L"IProvideClassInfo" },
+    { "A6BC3AC0-DBAA-11CE-9DE3-00AA004BB851", L"IProvideClassInfo2" },
+    { "B196B284-BAB4-101A-B69C-00AA00341D07", L"IConnectionPointContainer" },
+    { "B196B285-BAB4-101A-B69C-00AA00341D07", L"IEnumConnectionPoints" },
+    { "B196B286-BAB4-101A-B69C-00AA00341D07", L"IConnectionPoint" },
+    { "B196B287-BAB4-101A-B69C-00AA00341D07", L"IEnumConnections" },
+    { "B196B288-BAB4-101A-B69C-00AA00341D07", L"IOleControl" },
+    { "B196B289-BAB4-101A-B69C-00AA00341D07", L"IOleControlSite" },
+    { "B196B28B-BAB4-101A-B69C-00AA00341D07", L"ISpecifyPropertyPages" },
+    { "B196B28C-BAB4-101A-B69C-00AA00341D07", L"IPropertyPageSite" },
+    { "B196B28D-BAB4-101A-B69C-00AA00341D07", L"IPropertyPage" },
+    { "01E44665-24AC-101B-84ED-08002B2EC713", L"IPropertyPage2" },
+    { "9BFBBC02-EFF1-101A-84ED-00AA00341D07", L"IPropertyNotifySink" },
+    { "376BD3AA-3845-101B-84ED-08002B2EC713", L"IPerPropertyBrowsing" },
+    { "7FD52380-4E07-101B-AE2D-08002B2EC713", L"IPersistStreamInit" },
+    { "37D84F60-42CB-11CE-8135-00AA004BB851", L"IPersistPropertyBag" },
+    { "55272A00-42CB-11CE-8135-00AA004BB851", L"IPropertyBag" },
+    { "FC4801A3-2BA9-11CF-A229-00AA003D7352", L"IObjectWithSite" },
+    { "FC4801A1-2BA9-11CF-A229-00AA003D7352", L"IBindHost" },
+    { "6D5140C1-7436-11CE-8034-00AA006009FA", L"IServiceProvider" },
+    { "B722BCCB-4E68-101B-A2BC-00AA00404770", L"IOleCommandTarget" },
+    { "CB5BDC81-93C1-11CF-8F20-00805F2CD064", L"IObjectSafety" },
+    { "CF51ED10-62FE-11CF-BF86-00A0C9034836", L"IQuickActivate" },
+    { "55980BA0-35AA-11CF-B671-00AA004CD6D8", L"IPointerInactive" },
+    { "3AF24292-0C96-11CE-A0CF-00AA00600AB8", L"IViewObjectEx" },
+    { "1C2056CC-5EF4-101B-8BC8-00AA003E3B29", L"IOleInPlaceObjectWindowless" },
+    { "9C2CAD80-3424-11CF-B670-00AA004CD6D8", L"IOleInPlaceSiteEx" },
+    { "922EADA0-3424-11CF-B670-00AA004CD6D8", L"IOleInPlaceSiteWindowless" },
+    { "BEF6E002-A874-101A-8BBA-00AA00300CAB", L"IFont" },
+    { "BEF6E003-A874-101A-8BBA-00AA00300CAB", L"IFontDisp" },
+    { "7BF80980-BF32-101A-8BBB-00AA00300CAB", L"IPicture" },
+    { "7BF80981-BF32-101A-8BBB-00AA00300CAB", L"IPictureDisp" },
+    { "618736E0-3C3D-11CF-810C-00AA00389B71", L"IAccessible" },
+
+    // URL monikers and security
+    { "79EAC9C0-BAF9-11CE-8C82-00AA004BA90B", L"IBinding" },
+    { "79EAC9C1-BAF9-11CE-8C82-00AA004BA90B", L"IBindStatusCallback" },
+    { "79EAC9D0-BAF9-11CE-8C82-00AA004BA90B", L"IAuthenticate" },
+    { "79EAC9D1-BAF9-11CE-8C82-00AA004BA90B", L"ICodeInstall" },
+    { "79EAC9D2-BAF9-11CE-8C82-00AA004BA90B", L"IHttpNegotiate" },
+    { "79EAC9D5-BAF9-11CE-8C82-00AA004BA90B", L"IWindowForBindingUI" },
+    { "79EAC9EE-BAF9-11CE-8C82-00AA004BA90B", L"IInternetSecurityManager" },
+    { "79EAC9EF-BAF9-11CE-8C82-00AA004BA90B", L"IInternetZoneManager" },
+    { "3AF280B6-CB3F-11D0-891E-00C04FB6BFC4", L"IInternetHostSecurityManager" },
+    { "A39EE748-6A27-4817-A6F2-13914BEF5890", L"IUri" },
+
+    // Shell namespace (classic 000214xx block)
+    { "000214E2-0000-0000-C000-000000000046", L"IShellBrowser" },
+    { "000214E3-0000-0000-C000-000000000046", L"IShellView" },
+    { "000214E4-0000-0000-C000-000000000046", L"IContextMenu" },
+    { "000214E5-0000-0000-C000-000000000046", L"IShellIcon" },
+    { "000214E6-0000-0000-C000-000000000046", L"IShellFolder" },
+    { "000214E8-0000-0000-C000-000000000046", L"IShellExtInit" },
+    { "000214E9-0000-0000-C000-000000000046", L"IShellPropSheetExt" },
+    { "000214EA-0000-0000-C000-000000000046", L"IPersistFolder" },
+    { "000214EB-0000-0000-C000-000000000046", L"IExtractIconA" },
+    { "000214EC-0000-0000-C000-000000000046", L"IShellDetails" },
+    { "000214EE-0000-0000-C000-000000000046", L"IShellLinkA" },
+    { "000214EF-0000-0000-C000-000000000046", L"IShellCopyHookA" },
+    { "000214F0-0000-0000-C000-000000000046", L"IFileViewerA" },
+    { "000214F1-0000-0000-C000-000000000046", L"ICommDlgBrowser" },
+    { "000214F2-0000-0000-C000-000000000046", L"IEnumIDList" },
+    { "000214F3-0000-0000-C000-000000000046", L"IFileViewerSite" },
+    { "000214F4-0000-0000-C000-000000000046", L"IContextMenu2" },
+    { "000214F5-0000-0000-C000-000000000046", L"IShellExecuteHookA" },
+    { "000214F6-0000-0000-C000-000000000046", L"IPropSheetPage" },
+    { "000214F7-0000-0000-C000-000000000046", L"INewShortcutHookW" },
+    { "000214F8-0000-0000-C000-000000000046", L"IFileViewerW" },
+    { "000214F9-0000-0000-C000-000000000046", L"IShellLinkW" },
+    { "000214FA-0000-0000-C000-000000000046", L"IExtractIconW" },
+    { "000214FB-0000-0000-C000-000000000046", L"IShellExecuteHookW" },
+    { "000214FC-0000-0000-C000-000000000046", L"IShellCopyHookW" },
+    { "000214FE-0000-0000-C000-000000000046", L"IRemoteComputer" },
+    { "00021500-0000-0000-C000-000000000046", L"IQueryInfo" },
+
+    // Shell folders and views
+    { "93F2F68C-1D1B-11D3-A30E-00C04F79ABD1", L"IShellFolder2" },
+    { "1AC3D9F0-175C-11D1-95BE-00609797EA4F", L"IPersistFolder2" },
+    { "CEF04FDF-FE72-11D2-87A5-00C04F6837CF", L"IPersistFolder3" },
+    { "1079ACFC-29BD-11D3-8E0D-00C04F6837D5", L"IPersistIDList" },
+    { "2047E320-F2A9-11CE-AE65-08002B2E1262", L"IShellFolderViewCB" },
+    { "37A378C0-F82D-11CE-AE65-08002B2E1262", L"IShellFolderView" },
+    { "E7A1AF80-4D96-11CF-960C-0080C7F4EE85", L"IShellFolderViewDual" },
+    { "88E39E80-3578-11CF-AE69-08002B2E1262", L"IShellView2" },
+    { "EC39FA88-F8AF-41C5-8421-38BED28F4673", L"IShellView3" },
+    { "CDE725B0-CCC9-4519-917E-325D72FAB4CE", L"IFolderView" },
+    { "1AF3A467-214F-4298-908E-06B03E0B39F9", L"IFolderView2" },
+    { "AE8C987D-8797-4ED3-BE72-2A47DD938DB0", L"IFolderViewSettings" },
+    { "3CC974D2-B302-4D36-AD3E-06D93F695D3F", L"IFolderViewOptions" },
+    { "E693CF68-D967-4112-8763-99172AEE5E5A", L"IVisualProperties" },
+    { "BCFCE0A0-EC17-11D0-8D10-00A0C90F2719", L"IContextMenu3" },
+    { "3409E930-5A39-11D1-83FA-00A0C90DC849", L"IContextMenuCB" },
+    { "0811AEBE-0B87-4C54-9E72-548CF649016B", L"IContextMenuSite" },
+    { "10339516-2894-11D2-9039-00C04F8EEB3E", L"ICommDlgBrowser2" },
+    { "C8AD25A1-3294-41EE-8165-71174BD01C57", L"ICommDlgBrowser3" },
+    { "0E700BE1-9DB6-11D1-A1CE-00C04FD75D13", L"IEnumExtraSearch" },
+    { "ADD8BA80-002B-11D0-8F0F-00C04FD7D062", L"IDelegateFolder" },
+    { "10DF43C8-1DBE-11D3-8B34-006097DF5BD4", L"IBrowserFrameOptions" },
+    { "9CC22886-DC8E-11D2-B1D0-00C04F8EEB3E", L"IFolderFilter" },
+    { "C0A651F5-B48B-11D2-B5ED-006097C686F6", L"IFolderFilterSite" },
+    { "1DF0D7F1-B267-4D28-8B10-12E23202A5C4", L"IItemNameLimits" },
+    { "9AF64809-5864-4C26-A720-C1F78C086EE3", L"ICategoryProvider" },
+    { "A3B14589-9174-49A8-89A3-06A1AE2B9BA7", L"ICategorizer" },
+    { "E8025004-1C42-11D2-BE2C-00A0C9A83DA1", L"IColumnProvider" },
+    { "6A9D9026-0E6E-464C-B000-42ECC07DE673", L"IObjectWithFolderEnumMode" },
+    { "B3A4B685-B685-4805-99D9-5DEAD2873236", L"IParentAndItem" },
+    { "A6087428-3BE3-4D73-B308-7C04A540BF1A", L"IObjectProvider" },
+    { "D82BE2B1-5764-11D0-A96E-00C04FD705A2", L"IShellChangeNotify" },
+    { "96E5AE6D-6AE1-4B1C-900C-C6480EAA8828", L"IResultsFolder" },
+    { "A0FFBC28-5482-4366-BE27-3E81E78E06C2", L"ISearchFolderItemFactory" },
+    { "6E0F9881-42A8-4F2A-97F8-8AF4E026D92D", L"IInitializeNetworkFolder" },
+    { "01E18D10-4D8B-11D2-855D-006008059367", L"IFileSystemBindData" },
+    { "3ACF075F-71DB-4AFA-81F0-3FC4FDF2A5B8", L"IFileSystemBindData2" },
+    { "57CED8A7-3F4A-432C-9350-30F24483F74F", L"INamespaceWalk" },
+    { "028212A3-B627-47E9-8856-C14265554E4F", L"INameSpaceTreeControl" },
+    { "7CC7AED8-290E-49BC-8945-C1401CC9306C", L"INameSpaceTreeControl2" },
+
+    // Shell items and properties
+    { "43826D1E-E718-42EE-BC55-A1E261C37BFE", L"IShellItem" },
+    { "7E9FB0D3-919F-4307-AB2E-9B1860310C93", L"IShellItem2" },
+    { "B63EA76D-1F85-456F-A19C-48159EFA858B", L"IShellItemArray" },
+    { "70629033-E363-4A28-A567-0DB78006E6D7", L"IEnumShellItems" },
+    { "BCC18B79-BA16-442F-80C4-8A59C30C463B", L"IShellItemImageFactory" },
+    { "FF5693BE-2CE0-4D48-B5C5-40817D1ACDB9", L"IShellItemResources" },
+    { "2659B475-EEB8-48B7-8F07-B378810F48CF", L"IShellItemFilter" },
+    { "7D903FCA-D6F9-4810-8332-946C0177E247", L"IIdentityName" },
+    { "A73CE67A-8AB1-44F1-8D43-D2FCBF6B1CD0", L"IRelatedItem" },
+    { "240A7174-D653-4A1D-A6D3-D4943CFBFE3D", L"ICurrentItem" },
+    { "886D8EEB-8CF2-4446-8D02-CDBA1DBDCF99", L"IPropertyStore" },
+    { "BC110B6D-57E8-4148-A9C6-91015AB2F3A5", L"IPropertyStoreFactory" },
+    { "C8E2D566-186E-4D49-BF41-6909EAD56ACC", L"IPropertyStoreCapabilities" },
+    { "6F79D558-3E96-4549-A1D1-7D75D2288814", L"IPropertyDescription" },
+    { "CA724E8A-C3E6-442B-88A4-6FB0DB8035A3", L"IPropertySystem" },
+    { "A99400F4-3D84-4557-94BA-1242FB2CC9A6", L"IPropertyEnumTypeList" },
+    { "E318AD57-0AA0-450F-ACA5-6FAB7103D917", L"IPersistSerializedPropStorage" },
+    { "380F5CAD-1B5E-42F2-805D-637FD392D31E", L"IPropertyChangeArray" },
+    { "F917BC8A-1BBA-4478-A245-1BDE03EB9431", L"IPropertyChange" },
+    { "757A7D9F-919A-4118-99D7-DBB208C8CC66", L"IPropertyUI" },
+    { "C46CA590-3C3F-11D2-BEE6-0000F805CA57", L"IQueryAssociations" },
+    { "C7B236CE-EE80-11D0-985F-006008059382", L"IQueryCodePage" },
+    { "45E2B4AE-B1C3-11D0-B92F-00A0C90312E1", L"IShellLinkDataList" },
+    { "36DB0196-9665-46D1-9BA7-D3709EECF9ED", L"IObjectWithAppUserModelID" },
+    { "71E806FB-8DEE-46FC-BF8C-7748A8A1AE13", L"IObjectWithProgID" },
+    { "F279B885-0AE9-4B85-AC06-DDECF9408941", L"IObjectWithCancelEvent" },
+    { "92CA9DCD-5622-4BBA-A805-5E9F541BD8C9", L"IObjectArray" },
+    { "5632B1A4-E38A-400A-928A-D4CD63230295", L"IObjectCollection" },
+
+    // Shell extension handlers
+    { "A08CE4D0-FA25-44AB-B57C-C7B1C323E0B9", L"IExplorerCommand" },
+    { "A88826F8-186F-4987-AADE-EA0CEF8FBFE8", L"IEnumExplorerCommand" },
+    { "64961751-0835-43C0-8FFE-D57686530E64", L"IExplorerCommandProvider" },
+    { "BDDACB60-7657-47AE-8445-D23E1ACF82AE", L"IExplorerCommandState" },
+    { "85075ACF-231F-40EA-9610-D26B7B58F638", L"IInitializeCommand" },
+    { "1C9CD5BB-98E9-4491-A60F-31AACC72B83C", L"IObjectWithSelection" },
+    { "7F9185B0-CB92-43C5-80A9-92277A4F7B54", L"IExecuteCommand" },
+    { "E357FCCD-A995-4576-B01F-234630154E96", L"IThumbnailProvider" },
+    { "E35B4B2E-00DA-4BC1-9F13-38BC11F5D417", L"IThumbnailHandlerFactory" },
+    { "B824B49D-22AC-4161-AC8A-9916E8FA3F7F", L"IInitializeWithStream" },
+    { "B7D14566-0509-4CCE-A71F-0A554233BD9B", L"IInitializeWithFile" },
+    { "7F73BE3F-FB79-493C-A6C7-7EE14E245841", L"IInitializeWithItem" },
+    { "3E68D4BD-7135-4D10-8018-9FB6D9F33FA1", L"IInitializeWithWindow" },
+    { "C3E12EB5-7D8D-44F8-B6DD-0E77B34D6DE4", L"IInitializeWithPropertyStore" },
+    { "8895B1C6-B41F-4C1C-A562-0D564250836F", L"IPreviewHandler" },
+    { "196BF9A5-B346-4EF0-AA1E-5DCDB76768B1", L"IPreviewHandlerVisuals" },
+    { "FEC87AAF-35F9-447A-ADB7-20234491401A", L"IPreviewHandlerFrame" },
+    { "BB2E617C-0920-11D1-9A0B-00C04FC2D6C1", L"IExtractImage" },
+    { "953BB1EE-93B4-11D1-98A3-00C04FB687DA", L"IExtractImage2" },
+    { "41DED17D-D6B3-4261-997D-88C60E4B1D58", L"IDefaultExtractIconInit" },
+    { "0C6C4200-C589-11D0-999A-00C04FD655E1", L"IShellIconOverlayIdentifier" },
+    { "7D688A70-C613-11D0-999B-00C04FD655E1", L"IShellIconOverlay" },
+    { "F10B5E34-DD3B-42A7-AA7D-2F4EC54BB09B", L"IShellIconOverlayManager" },
+    { "C1FB73D0-EC3A-4BA2-B512-8CDB9187B6D1", L"IHWEventHandler" },
+    { "997706EF-F880-453B-8118-39E1A2D2655A", L"IHandlerInfo" },
+    { "35094A87-8BB1-4237-96C6-C417EEBDB078", L"IHandlerActivationHost" },
+    { "F04061AC-1659-4A3F-A954-775AA57FC083", L"IAssocHandler" },
+    { "973810AE-9599-4B88-9E4D-6EE98C9552DA", L"IEnumAssocHandlers" },
+    { "C2B937A9-3110-4398-8A56-F34C6342D244", L"ICreatingProcess" },
+
+    // Drag and drop, data transfer
+    { "3D8B0590-F691-11D2-8EA9-006097DF5BD4", L"IDataObjectAsyncCapability" },
+    { "DE5BF786-477A-11D2-839D-00C04FD918D0", L"IDragSourceHelper" },
+    { "83E07D0D-0C5F-4163-BF1A-60B274051E40", L"IDragSourceHelper2" },
+    { "4657278B-411B-11D2-839A-00C04FD918D0", L"IDropTargetHelper" },
+    { "7307055C-B24A-486B-9F25-163E597A28A9", L"IQueryContinue" },
+    { "8A87781B-39A7-4A1F-AAB3-A39B9C34A7D9", L"IDestinationStreamFactory" },
+    { "00ADB003-BDE9-45C6-8E29-D09F9353E108", L"ITransferSource" },
+    { "48ADDD32-3CA5-4124-ABE3-B5A72531B207", L"ITransferDestination" },
+    { "A5CAEE9B-8708-49D1-8D36-67D25A8DA00C", L"IDataTransferManagerInterop" },
+    { "64A1CBF0-3A1A-4461-9158-376969693950", L"IFileIsInUse" },
+    { "73DB1241-1E85-4581-8E4F-A81E1D0F8C57", L"IAttachmentExecute" },
+
+    // File operations, dialogs and browsers
+    { "947AAB5F-0A5C-4C13-B4D6-4BF7836FC9F8", L"IFileOperation" },
+    { "04B0F1A7-9490-44BC-96E1-4296A31252E2", L"IFileOperationProgressSink" },
+    { "42F85136-DB7E-439C-85F1-E4075D135FC8", L"IFileDialog" },
+    { "D57C7288-D4AD-4768-BE02-9D969532D960", L"IFileOpenDialog" },
+    { "84BCCD23-5FDE-4CDB-AEA4-AF64B83D78AB", L"IFileSaveDialog" },
+    { "973510DB-7D7F-452B-8975-74A85828D354", L"IFileDialogEvents" },
+    { "E6FDD21A-163F-4975-9C8C-A69F1BA37034", L"IFileDialogCustomize" },
+    { "DFD3B6B5-C10C-4BE9-85F6-A66969F402F6", L"IExplorerBrowser" },
+    { "361BBDC7-E6EE-4E13-BE58-58E2240C810F", L"IExplorerBrowserEvents" },
+    { "E07010EC-BC17-44C0-97B0-46C7C95B9EDC", L"IExplorerPaneVisibility" },
+    { "EBBC7C04-315E-11D2-B62F-006097DF5BD4", L"IProgressDialog" },
+    { "0C9FB851-E5C9-43EB-A370-F0677B13874C", L"IOperationsProgressDialog" },
+    { "49FF1172-EADC-446D-9285-156453A6431C", L"IActionProgressDialog" },
+    { "49FF1173-EADC-446D-9285-156453A6431C", L"IActionProgress" },
+    { "6CCB7BE0-6807-11D0-B810-00C04FD706EC", L"IShellTaskScheduler" },
+    { "85788D00-6807-11D0-B810-00C04FD706EC", L"IRunnableTask" },
+
+    // Shell UI, taskbar and miscellaneous services
+    { "D8F015C0-C278-11CE-A49E-444553540000", L"IShellDispatch" },
+    { "85CB6900-4D95-11CF-960C-0080C7F4EE85", L"IShellWindows" },
+    { "0002DF05-0000-0000-C000-000000000046", L"IWebBrowserApp" },
+    { "EAB22AC1-30C1-11CF-A7EB-0000C05BAE0B", L"IWebBrowser" },
+    { "D30C1661-CDAF-11D0-8A3E-00C04FC9E26E", L"IWebBrowser2" },
+    { "34A715A0-6587-11D0-924A-0020AFC7AC4D", L"DWebBrowserEvents2" },
+    { "729FE2F8-1EA8-11D1-8F85-00C04FC2FBE1", L"IShellUIHelper" },
+    { "BD3F23C0-D43E-11CF-893B-00AA00BDCE1A", L"IDocHostUIHandler" },
+    { "332C4425-26CB-11D0-B483-00C04FD90119", L"IHTMLDocument2" },
+    { "EE1F7637-E138-11D1-8379-00C04FD918D0", L"IShellMenu" },
+    { "EB0FE172-1A3A-11D0-89B3-00A0C90A90AC", L"IDeskBand" },
+    { "79D16DE4-ABEE-4021-8D9D-9169B261D657", L"IDeskBand2" },
+    { "012DD920-7B26-11D0-8CA9-00A0C92DBFE8", L"IDockingWindow" },
+    { "68284FAA-6A48-11D0-8C78-00C04FD918B4", L"IInputObject" },
+    { "F1DB8392-7331-11D0-8C99-00A0C92DBFE8", L"IInputObjectSite" },
+    { "4CF504B0-DE96-11D0-8B3F-00A0C911E8E5", L"IBandSite" },
+    { "56FDF342-FD6D-11D0-958A-006097C9A090", L"ITaskbarList" },
+    { "602D4995-B13A-429B-A66E-1935E44F4317", L"ITaskbarList2" },
+    { "EA1AFB91-9E28-4B86-90E9-9E9F8A5EEFAF", L"ITaskbarList3" },
+    { "C43DC798-95D1-4BEA-9030-BB99E2983A1A", L"ITaskbarList4" },
+    { "46EB5926-582E-4017-9FDF-E8998DAA0950", L"IImageList" },
+    { "192B9D83-50FC-457B-90A0-2B82A8B5DAE1", L"IImageList2" },
+    { "091162A4-BC96-411F-AAE8-C5122CD03363", L"ISharedBitmap" },
+    { "F676C15D-596A-4CE2-8234-33996F445DB1", L"IThumbnailCache" },
+    { "F4376F00-BEF5-4D45-80F3-1E023BBF1209", L"IThumbnailSettings" },
+    { "00BB2761-6A77-11D0-A535-00C04FD7D062", L"IObjMgr" },
+    { "77A130B0-94FD-11D0-A544-00C04FD7D062", L"IACList" },
+    { "00BB2762-6A77-11D0-A535-00C04FD7D062", L"IAutoComplete" },
+    { "EAC04BC0-3791-11D2-BB95-0060977B464C", L"IAutoComplete2" },
+    { "3AA7AF7E-9B36-420C-A8E3-F77D4674A488", L"IKnownFolder" },
+    { "8BE2D872-86AA-4D47-B776-32CCA40C7018", L"IKnownFolderManager" },
+    { "11A66EFA-382E-451A-9234-1E0E12EF3085", L"IShellLibrary" },
+    { "4E530B0A-E611-4C77-A3AC-9031D022281B", L"IApplicationAssociationRegistration" },
+    { "2E941141-7F97-4756-BA1D-9DECDE894A3D", L"IApplicationActivationManager" },
+    { "D11AD862-66DE-4DF4-BF6C-1F5621996AF1", L"IOpenControlPanel" },
+    { "4CD19ADA-25A5-4A32-B3B7-347BEE5BE36B", L"IStartMenuPinnedList" },
+    { "5752238B-24F0-495A-82F1-2FD593056796", L"IFrameworkInputPane" },
+
+    // Well-known CLSIDs that show up as class ids in DllGetClassObject or as bind targets
+    { "00021400-0000-0000-C000-000000000046", L"CLSID_ShellDesktop" },
+    { "00021401-0000-0000-C000-000000000046", L"CLSID_ShellLink" },
+    { "20D04FE0-3AEA-1069-A2D8-08002B30309D", L"CLSID_MyComputer" },
+    { "208D2C60-3AEA-1069-A2D7-08002B30309D", L"CLSID_NetworkPlaces" },
+    { "645FF040-5081-101B-9F08-00AA002F954E", L"CLSID_RecycleBin" },
+    { "21EC2020-3AEA-1069-A2DD-08002B30309D", L"CLSID_ControlPanel" },
+    { "2227A280-3AEA-1069-A2DE-08002B30309D", L"CLSID_Printers" },
+    { "F3364BA0-65B9-11CE-A9BA-00AA004AE837", L"CLSID_ShellFSFolder" },
+    { "9AC9FBE1-E0A2-4AD6-B4EE-E212013EA917", L"CLSID_ShellItem" },
+    { "DC1C5A9C-E88A-4DDE-A5A1-60F82A20AEF7", L"CLSID_FileOpenDialog" },
+    { "C0B4E2F3-BA21-4773-8DBA-335EC946EB8B", L"CLSID_FileSaveDialog" },
+    { "3AD05575-8857-4850-9277-11B85BDB8E09", L"CLSID_FileOperation" },
+    { "4657278A-411B-11D2-839A-00C04FD918D0", L"CLSID_DragDropHelper" },
+    { "0002DF01-0000-0000-C000-000000000046", L"CLSID_InternetExplorer" },
+    { "9BA05972-F6A8-11CF-A442-00A0C90A8F39", L"CLSID_ShellWindows" },
+    { "13709620-C279-11CE-A49E-444553540000", L"CLSID_Shell" },
+    { "A07034FD-6CAA-4954-AC3F-97A27216F98A", L"CLSID_QueryAssociations" },
+    { "56FDF344-FD6D-11D0-958A-006097C9A090", L"CLSID_TaskbarList" },
+    { "4DF0C730-DF9D-4AE3-9153-AA6B82E9795A", L"CLSID_KnownFolderManager" },
+    { "D9B3211D-E57F-4426-AAEF-30A806ADD397", L"CLSID_ShellLibrary" },
+    { "71F96385-DDD6-48D3-A0C1-AE06E8B055FB", L"CLSID_ExplorerBrowser" },
+    { "00000323-0000-0000-C000-000000000046", L"CLSID_StdGlobalInterfaceTable" },
+    { "591209C7-767B-42B2-9FBA-44EE4615F2C7", L"CLSID_ApplicationAssociationRegistration" },
+    { "45BA127D-10A8-46EA-8AB7-56EA9078943C", L"CLSID_ApplicationActivationManager" },
+    { "50EF4544-AC9F-4A8E-B21B-8A26180DB13F", L"CLSID_LocalThumbnailCache" },
+    { "77F10CF0-3DB5-4966-B520-B7C54FD35ED6", L"CLSID_DestinationList" },
+    { "2D3468C1-36A7-43B6-AC24-D3F02FD9607A", L"CLSID_EnumerableObjectCollection" },
+};
+
+constexpr size_t kEntryCount = std::size(kEntries);
+
+// Two-level "hash and displace" layout: keys hash into kBucketCount buckets, and each bucket stores the
+// displacement that sends all of its keys to distinct free slots. A load factor of 1/2 keeps the
+// compile-time search short.
+constexpr size_t kBucketCount = kEntryCount / 2 + 1;
+constexpr size_t kSlotCount = std::bit_ceil(kEntryCount * 2);
+
+static_assert(kEntryCount < 0xFFFF, "Slot indices are stored in 16 bits");
+
+constexpr uint64_t Mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+constexpr uint64_t HashGuid(const Guid& guid) {
+    const uint64_t low = guid.data1 | (static_cast<uint64_t>(guid.data2) << 32) |
+        (static_cast<uint64_t>(guid.data3) << 48);
+    uint64_t high = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        high |= static_cast<uint64_t>(guid.data4[i]) << (8 * i);
+    }
+    return Mix(low ^ Mix(high));
+}
+
+constexpr size_t SlotFor(uint64_t hash, uint16_t displacement) {
+    return static_cast<size_t>(Mix(hash + displacement * 0x9E3779B97F4A7C15ull) & (kSlotCount - 1));
+}
+
+struct Table {
+    std::array<Guid, kEntryCount> guids{};
+    std::array<uint16_t, kBucketCount> displacements{};
+    std::array<uint16_t, kSlotCount> slots{}; // entry index + 1; 0 = empty
+    bool complete = false;
+};
+
+constexpr Table Build() {
+    Table table;
+    std::array<uint64_t, kEntryCount> hashes{};
+    std::array<size_t, kBucketCount + 1> bucketStart{};
+    for (size_t i = 0; i < kEntryCount; ++i) {
+        table.guids[i] = Guid::Parse(kEntries[i].guid);
+        hashes[i] = HashGuid(table.guids[i]);
+        ++bucketStart[hashes[i] % kBucketCount + 1];
+    }
+
+    // Counting sort of entries by bucket.
+    for (size_t b = 0; b < kBucketCount; ++b) {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+    std::array<uint16_t, kEntryCount> members{};
+    std::array<size_t, kBucketCount> fill{};
+    for (size_t i = 0; i < kEntryCount; ++i) {
+        const size_t bucket = hashes[i] % kBucketCount;
+        members[bucketStart[bucket] + fill[bucket]++] = static_cast<uint16_t>(i);
+    }
+
+    // Place the largest buckets first, while the table is still mostly empty.
+    std::array<uint16_t, kBucketCount> order{};
+    for (size_t b = 0; b < kBucketCount; ++b) {
+        order[b] = static_cast<uint16_t>(b);
+    }
+    for (size_t i = 1; i < kBucketCount; ++i) {
+        for (size_t j = i; j > 0 && fill[order[j]] > fill[order[j - 1]]; --j) {
+            const uint16_t swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+
+    for (size_t o = 0; o < kBucketCount; ++o) {
+        const size_t bucket = order[o];
+        const size_t first = bucketStart[bucket];
+        const size_t count = fill[bucket];
+        if (count == 0) {
+            break;
+        }
+        bool placed = false;
+        for (uint32_t displacement = 0; displacement < 0x10000 && !placed; ++displacement) {
+            placed = true;
+            for (size_t m = 0; m < count && placed; ++m) {
+                const size_t slot = SlotFor(hashes[members[first + m]], static_cast<uint16_t>(displacement));
+                if (table.slots[slot] != 0) {
+                    placed = false;
+                }
+                for (size_t k = 0; k < m && placed; ++k) {
+                    if (SlotFor(hashes[members[first + k]], static_cast<uint16_t>(displacement)) == slot) {
+                        placed = false;
+                    }
+                }
+            }
+            if (placed) {
+                table.displacements[bucket] = static_cast<uint16_t>(displacement);
+                for (size_t m = 0; m < count; ++m) {
+                    const uint16_t entry = members[first + m];
+                    table.slots[SlotFor(hashes[entry], static_cast<uint16_t>(displacement))] =
+                        static_cast<uint16_t>(entry + 1);
+                }
+            }
+        }
+        if (!placed) {
+            return table;
+        }
+    }
+    table.complete = true;
+    return table;
+}
+
+constexpr Table kTable = Build();
+static_assert(kTable.complete, "IID table could not be perfectly hashed; look for a duplicate GUID");
+
+} // namespace
+
+size_t Size() {
+    return kEntryCount;
+}
+
+int IndexOf(const Guid& guid) {
+    const uint64_t hash = HashGuid(guid);
+    const uint16_t displacement = kTable.displacements[hash % kBucketCount];
+    const uint16_t slot = kTable.slots[SlotFor(hash, displacement)];
+    if (slot == 0 || !(kTable.guids[slot - 1] == guid)) {
+        return -1;
+    }
+    return slot - 1;
+}
+
+const wchar_t* NameAt(size_t index) {
+    return index < kEntryCount ? kEntries[index].name : nullptr;
+}
+
+const wchar_t* Lookup(const Guid& guid) {
+    int index = IndexOf(guid);
+    return index < 0 ? nullptr : kEntries[index].name;
+}
+
+} // namespace IidTable
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Guid.h"
+
+#include <cstddef>
+
+// Names for the COM and shell interfaces (and a few well-known CLSIDs) that Explorer probes extensions
+// with. Lookups go through a perfect hash built at compile time: one hash, one displacement read and a
+// single GUID compare, whatever the table size.
+namespace IidTable {
+
+/// @brief Number of named entries.
+size_t Size();
+
+/// @brief Returns the entry index for a GUID, or -1 if it is not in the table.
+int IndexOf(const Guid& guid);
+
+/// @brief Name of the entry at index (0 <= index < Size()).
+const wchar_t* NameAt(size_t index);
+
+/// @brief Returns the name for a GUID, or nullptr if it is not in the table.
+const wchar_t* Lookup(const Guid& guid);
+
+} // namespace IidTable
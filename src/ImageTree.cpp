@@ -0,0 +1,461 @@
+#include "ImageTree.h"
+
+#include "Diagnostics.h"
+#include "Perf.h"
+#include "Platform.h"
+
+#include <cstring>
+#include <iterator>
+
+namespace ImageTree {
+namespace {
+
+constexpr size_t kImportDescriptorSize = 20;
+constexpr size_t kExportDirectorySize = 40;
+constexpr size_t kMaxNameChars = 512;
+
+// The resource walk visits at most this many directory entries; the three levels multiply, so a
+// hostile count at each level must not.
+constexpr size_t kMaxResourceVisits = kMaxEntries * 4;
+
+constexpr uint32_t kScnCode = 0x00000020;
+constexpr uint32_t kScnInitializedData = 0x00000040;
+constexpr uint32_t kScnUninitializedData = 0x00000080;
+constexpr uint32_t kScnExecute = 0x20000000;
+constexpr uint32_t kScnRead = 0x40000000;
+constexpr uint32_t kScnWrite = 0x80000000;
+
+constexpr const wchar_t* kNodeNames[] = { L"Sections", L"Imports", L"Exports", L"Resources", L"Memory" };
+
+constexpr const wchar_t* kColumnTitles[kNodeCount][kDetailColumns + 1] = {
+    { L"Name", L"Virtual address", L"Virtual size", L"Characteristics" },
+    { L"Name", L"Module", L"Hint", L"IAT slot" },
+    { L"Name", L"Ordinal", L"RVA", L"Forwarder" },
+    { L"Name", L"Type", L"Language", L"Size" },
+    { L"Name", L"Committed", L"Private", L"Copy-on-write" },
+};
+
+static_assert(std::size(kNodeNames) == kNodeCount, "Node names out of date");
+
+std::wstring Hex(uint64_t value, int digits = 8) {
+    static constexpr wchar_t kDigits[] = L"0123456789ABCDEF";
+    wchar_t text[18] = {};
+    size_t length = 0;
+    for (uint64_t rest = value; rest != 0 || length < static_cast<size_t>(digits); rest >>= 4) {
+        text[length++] = kDigits[rest & 0xF];
+    }
+    std::wstring result(L"0x");
+    result.append(std::make_reverse_iterator(text + length), std::make_reverse_iterator(text));
+    return result;
+}
+
+std::wstring Decimal(uint64_t value) {
+    wchar_t text[20] = {};
+    size_t length = 0;
+    do {
+        text[length++] = static_cast<wchar_t>(L'0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return std::wstring(std::make_reverse_iterator(text + length), std::make_reverse_iterator(text));
+}
+
+// A NUL-terminated ASCII string at an RVA, bounded by the buffer and kMaxNameChars.
+std::wstring AsciiAt(const PeImage::View& view, uint32_t rva) {
+    size_t offset = 0;
+    if (!view.RvaToOffset(rva, 1, offset)) {
+        return {};
+    }
+    const auto* first = view.Data() + offset;
+    const size_t available = view.Size() - offset;
+    const auto* nul = static_cast<const uint8_t*>(std::memchr(first, 0, available < kMaxNameChars ? available : kMaxNameChars));
+    const auto* last = nul ? nul : first + (available < kMaxNameChars ? available : kMaxNameChars);
+    return std::wstring(first, last);
+}
+
+bool ReadU32(const PeImage::View& view, uint32_t rva, uint32_t& value) {
+    const uint8_t* data = view.AtRva(rva, sizeof(value));
+    if (!data) {
+        return false;
+    }
+    value = PeImage::ReadAt<uint32_t>(data, 0);
+    return true;
+}
+
+// Appends unless the listing is full, in which case it is marked truncated. Returns false once full.
+bool Add(Listing& listing, Entry entry) {
+    if (listing.entries.size() >= kMaxEntries) {
+        listing.truncated = true;
+        return false;
+    }
+    listing.entries.push_back(std::move(entry));
+    return true;
+}
+
+void DecodeSections(const PeImage::View& view, Listing& listing) {
+    for (uint32_t i = 0; i < view.SectionCount(); ++i) {
+        const auto section = view.SectionAt(i);
+        Entry entry;
+        for (char ch : section.name) {
+            if (ch == '\0') {
+                break;
+            }
+            entry.name += static_cast<wchar_t>(static_cast<uint8_t>(ch));
+        }
+        entry.details[0] = Hex(section.virtualAddress);
+        entry.details[1] = Hex(section.virtualSize);
+
+        std::wstring& flags = entry.details[2];
+        if (section.characteristics & kScnCode) {
+            flags = L"code, ";
+        } else if (section.characteristics & kScnInitializedData) {
+            flags = L"data, ";
+        } else if (section.characteristics & kScnUninitializedData) {
+            flags = L"uninitialized, ";
+        }
+        flags += (section.characteristics & kScnRead) ? L'R' : L'-';
+        flags += (section.characteristics & kScnWrite) ? L'W' : L'-';
+        flags += (section.characteristics & kScnExecute) ? L'X' : L'-';
+        if (!Add(listing, std::move(entry))) {
+            return;
+        }
+    }
+}
+
+void DecodeImports(const PeImage::View& view, Listing& listing) {
+    const auto directory = view.Directory(PeImage::kDirectoryImport);
+    if (directory.rva == 0) {
+        return;
+    }
+    const size_t thunkSize = view.Is64Bit() ? 8 : 4;
+    const uint64_t ordinalFlag = view.Is64Bit() ? 0x8000000000000000ull : 0x80000000ull;
+
+    for (uint32_t index = 0;; ++index) {
+        const uint64_t descriptorRva = directory.rva + static_cast<uint64_t>(index) * kImportDescriptorSize;
+        const uint8_t* descriptor = descriptorRva <= UINT32_MAX
+            ? view.AtRva(static_cast<uint32_t>(descriptorRva), kImportDescriptorSize) : nullptr;
+        if (!descriptor) {
+            return;
+        }
+        const uint32_t lookupTable = PeImage::ReadAt<uint32_t>(descriptor, 0);
+        const uint32_t nameRva = PeImage::ReadAt<uint32_t>(descriptor, 12);
+        const uint32_t addressTable = PeImage::ReadAt<uint32_t>(descriptor, 16);
+        if (nameRva == 0 && addressTable == 0) {
+            return; // Null terminator descriptor
+        }
+        const std::wstring module = AsciiAt(view, nameRva);
+        // Bound images overwrite the address table on disk only when there is no lookup table.
+        const uint32_t thunks = lookupTable != 0 ? lookupTable : addressTable;
+
+        for (uint32_t slot = 0;; ++slot) {
+            const uint64_t thunkRva = thunks + static_cast<uint64_t>(slot) * thunkSize;
+            const uint8_t* thunk = thunkRva <= UINT32_MAX ? view.AtRva(static_cast<uint32_t>(thunkRva), thunkSize) : nullptr;
+            if (!thunk) {
+                break;
+            }
+            const uint64_t value = thunkSize == 8 ? PeImage::ReadAt<uint64_t>(thunk, 0) : PeImage::ReadAt<uint32_t>(thunk, 0);
+            if (value == 0) {
+                break;
+            }
+            Entry entry;
+            if (value & ordinalFlag) {
+                entry.name = L"#" + Decimal(value & 0xFFFF);
+            } else {
+                const auto hintName = static_cast<uint32_t>(value & 0x7FFFFFFF);
+                if (const uint8_t* hint = view.AtRva(hintName, 2)) {
+                    entry.details[1] = Decimal(PeImage::ReadAt<uint16_t>(hint, 0));
+                }
+                entry.name = AsciiAt(view, hintName + 2);
+            }
+            entry.details[0] = module;
+            entry.details[2] = Hex(addressTable + static_cast<uint64_t>(slot) * thunkSize);
+            if (!Add(listing, std::move(entry))) {
+                return;
+            }
+        }
+    }
+}
+
+void DecodeExports(const PeImage::View& view, Listing& listing) {
+    const auto directory = view.Directory(PeImage::kDirectoryExport);
+    const uint8_t* header = directory.rva != 0 ? view.AtRva(directory.rva, kExportDirectorySize) : nullptr;
+    if (!header) {
+        return;
+    }
+    const uint32_t ordinalBase = PeImage::ReadAt<uint32_t>(header, 16);
+    uint32_t functionCount = PeImage::ReadAt<uint32_t>(header, 20);
+    uint32_t nameCount = PeImage::ReadAt<uint32_t>(header, 24);
+    const uint32_t functions = PeImage::ReadAt<uint32_t>(header, 28);
+    const uint32_t names = PeImage::ReadAt<uint32_t>(header, 32);
+    const uint32_t ordinals = PeImage::ReadAt<uint32_t>(header, 36);
+    if (functionCount > kMaxEntries) {
+        functionCount = kMaxEntries;
+        listing.truncated = true;
+    }
+    nameCount = nameCount < kMaxEntries ? nameCount : static_cast<uint32_t>(kMaxEntries);
+
+    // Name RVA per function index; 0 for exports by ordinal only.
+    std::vector<uint32_t> nameOf(functionCount, 0);
+    listing.entries.reserve(functionCount);
+    for (uint32_t i = 0; i < nameCount; ++i) {
+        uint32_t nameRva = 0;
+        const uint8_t* ordinal = view.AtRva(ordinals + i * 2u, 2);
+        if (!ordinal || !ReadU32(view, names + i * 4u, nameRva)) {
+            break;
+        }
+        const uint16_t index = PeImage::ReadAt<uint16_t>(ordinal, 0);
+        if (index < functionCount && nameOf[index] == 0) {
+            nameOf[index] = nameRva;
+        }
+    }
+
+    for (uint32_t i = 0; i < functionCount; ++i) {
+        uint32_t rva = 0;
+        if (!ReadU32(view, functions + i * 4u, rva)) {
+            break;
+        }
+        if (rva == 0) {
+            continue;
+        }
+        Entry entry;
+        entry.name = nameOf[i] != 0 ? AsciiAt(view, nameOf[i]) : L"#" + Decimal(ordinalBase + static_cast<uint64_t>(i));
+        entry.details[0] = Decimal(ordinalBase + static_cast<uint64_t>(i));
+        entry.details[1] = Hex(rva);
+        // An RVA inside the export directory is a "module.function" forwarder string.
+        if (rva >= directory.rva && rva - directory.rva < directory.size) {
+            entry.details[2] = AsciiAt(view, rva);
+        }
+        if (!Add(listing, std::move(entry))) {
+            return;
+        }
+    }
+}
+
+const wchar_t* ResourceTypeName(uint32_t id) {
+    switch (id) {
+    case 1: return L"Cursor";
+    case 2: return L"Bitmap";
+    case 3: return L"Icon";
+    case 4: return L"Menu";
+    case 5: return L"Dialog";
+    case 6: return L"String table";
+    case 7: return L"Font directory";
+    case 8: return L"Font";
+    case 9: return L"Accelerators";
+    case 10: return L"RCDATA";
+    case 11: return L"Message table";
+    case 12: return L"Group cursor";
+    case 14: return L"Group icon";
+    case 16: return L"Version";
+    case 17: return L"Dialog include";
+    case 19: return L"Plug and Play";
+    case 20: return L"VxD";
+    case 21: return L"Animated cursor";
+    case 22: return L"Animated icon";
+    case 23: return L"HTML";
+    case 24: return L"Manifest";
+    default: return nullptr;
+    }
+}
+
+// A resource directory entry's name: a counted UTF-16 string in the section, or "#id".
+std::wstring ResourceName(const uint8_t* rsrc, size_t size, uint32_t name, bool isType) {
+    if (!(name & 0x80000000u)) {
+        if (isType) {
+            if (const wchar_t* known = ResourceTypeName(name)) {
+                return known;
+            }
+        }
+        return L"#" + Decimal(name);
+    }
+    const size_t offset = name & 0x7FFFFFFFu;
+    std::wstring text;
+    if (offset + 2 > size) {
+        return text;
+    }
+    size_t length = PeImage::ReadAt<uint16_t>(rsrc, offset);
+    length = length < kMaxNameChars ? length : kMaxNameChars;
+    for (size_t i = 0; i < length && offset + 2 + i * 2 + 2 <= size; ++i) {
+        text += static_cast<wchar_t>(PeImage::ReadAt<uint16_t>(rsrc, offset + 2 + i * 2));
+    }
+    return text;
+}
+
+struct ResourceEntry {
+    uint32_t name;
+    uint32_t offset; // High bit set for a subdirectory
+};
+
+// Calls visit for each entry of the directory at offset. Stops early when visit returns false or the
+// visit budget runs out.
+template <class Visit>
+bool ForEachResourceEntry(const uint8_t* rsrc, size_t size, size_t directory, size_t& budget, Visit visit) {
+    if (directory + 16 > size) {
+        return true;
+    }
+    const uint32_t count = PeImage::ReadAt<uint16_t>(rsrc, directory + 12) + PeImage::ReadAt<uint16_t>(rsrc, directory + 14);
+    for (uint32_t i = 0; i < count; ++i) {
+        const size_t offset = directory + 16 + static_cast<size_t>(i) * 8;
+        if (offset + 8 > size) {
+            return true;
+        }
+        if (budget == 0) {
+            return false;
+        }
+        --budget;
+        const ResourceEntry entry = { PeImage::ReadAt<uint32_t>(rsrc, offset), PeImage::ReadAt<uint32_t>(rsrc, offset + 4) };
+        if (!visit(entry)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DecodeResources(const PeImage::View& view, Listing& listing) {
+    const auto directory = view.Directory(PeImage::kDirectoryResource);
+    const uint8_t* rsrc = directory.rva != 0 ? view.AtRva(directory.rva, directory.size) : nullptr;
+    if (!rsrc) {
+        return;
+    }
+    const size_t size = directory.size;
+    size_t budget = kMaxResourceVisits;
+
+    // Exactly three levels (type, name, language), so a directory that points back at an ancestor is
+    // read as one more level of entries rather than followed forever.
+    const bool complete = ForEachResourceEntry(rsrc, size, 0, budget, [&](const ResourceEntry& type) {
+        if (!(type.offset & 0x80000000u)) {
+            return true;
+        }
+        const std::wstring typeName = ResourceName(rsrc, size, type.name, true);
+        return ForEachResourceEntry(rsrc, size, type.offset & 0x7FFFFFFFu, budget, [&](const ResourceEntry& name) {
+            if (!(name.offset & 0x80000000u)) {
+                return true;
+            }
+            const std::wstring itemName = typeName + L"/" + ResourceName(rsrc, size, name.name, false);
+            return ForEachResourceEntry(rsrc, size, name.offset & 0x7FFFFFFFu, budget, [&](const ResourceEntry& language) {
+                if ((language.offset & 0x80000000u) || static_cast<size_t>(language.offset) + 16 > size) {
+                    return true;
+                }
+                Entry entry;
+                entry.name = itemName;
+                entry.details[0] = typeName;
+                entry.details[1] = (language.name & 0x80000000u) ? ResourceName(rsrc, size, language.name, false)
+                                                                 : Hex(language.name, 4);
+                entry.details[2] = Decimal(PeImage::ReadAt<uint32_t>(rsrc, language.offset + 4));
+                return Add(listing, std::move(entry));
+            });
+        });
+    });
+    if (!complete) {
+        listing.truncated = true;
+    }
+}
+
+std::wstring CacheKey(const std::wstring& path, Node node) {
+    std::wstring key = path;
+    key += L'|';
+    key += static_cast<wchar_t>(L'0' + static_cast<uint32_t>(node));
+    return key;
+}
+
+} // namespace
+
+const wchar_t* NodeName(Node node) {
+    const auto index = static_cast<size_t>(node);
+    return index < kNodeCount ? kNodeNames[index] : L"";
+}
+
+const wchar_t* ColumnTitle(Node node, size_t column) {
+    const auto index = static_cast<size_t>(node);
+    return index < kNodeCount && column <= kDetailColumns ? kColumnTitles[index][column] : L"";
+}
+
+size_t Listing::Bytes() const {
+    static const size_t kInlineChars = std::wstring().capacity();
+    const auto heap = [](const std::wstring& text) {
+        return text.capacity() > kInlineChars ? (text.capacity() + 1) * sizeof(wchar_t) : 0;
+    };
+    size_t bytes = sizeof(*this) + entries.capacity() * sizeof(Entry);
+    for (const auto& entry : entries) {
+        bytes += heap(entry.name);
+        for (const auto& detail : entry.details) {
+            bytes += heap(detail);
+        }
+    }
+    return bytes;
+}
+
+Listing Decode(const PeImage::View& view, Node node) {
+    Listing listing;
+    if (!view.IsValid()) {
+        return listing;
+    }
+    switch (node) {
+    case Node::Sections:
+        DecodeSections(view, listing);
+        break;
+    case Node::Imports:
+        DecodeImports(view, listing);
+        break;
+    case Node::Exports:
+        DecodeExports(view, listing);
+        break;
+    case Node::Resources:
+        DecodeResources(view, listing);
+        break;
+    default:
+        break;
+    }
+    return listing;
+}
+
+Cache::Cache(size_t budgetBytes) : listings_(budgetBytes) {
+}
+
+std::shared_ptr<const Listing> Cache::Get(const std::wstring& path, Node node) {
+    auto key = CacheKey(path, node);
+    {
+        std::lock_guard guard(lock_);
+        if (auto cached = listings_.Find(key)) {
+            return *cached;
+        }
+    }
+
+    std::shared_ptr<const Listing> listing;
+    {
+        Perf::ScopedTimer timer(Perf::Op::DecodeTreeNode);
+        Diagnostics::Increment(Diagnostics::Counter::TreeNodesDecoded);
+        auto file = Platform::MappedFile::Open(path);
+        if (file) {
+            listing = std::make_shared<const Listing>(Decode(PeImage::View(file->Data(), file->Size()), node));
+        } else {
+            listing = std::make_shared<const Listing>();
+        }
+    }
+
+    const size_t cost = listing->Bytes();
+    std::lock_guard guard(lock_);
+    const size_t evicted = listings_.Insert(std::move(key), listing, cost);
+    if (evicted) {
+        Diagnostics::Increment(Diagnostics::Counter::TreeCacheEvictions, evicted);
+    }
+    return listing;
+}
+
+size_t Cache::TotalBytes() const {
+    std::lock_guard guard(lock_);
+    return listings_.TotalCost();
+}
+
+void Cache::TrimTo(size_t bytes) {
+    std::lock_guard guard(lock_);
+    // TrimTo keeps the most recent listing, so an empty budget clears instead.
+    size_t evicted = listings_.Size();
+    if (bytes == 0) {
+        listings_.Clear();
+    } else {
+        evicted = listings_.TrimTo(bytes);
+    }
+    Diagnostics::Increment(Diagnostics::Counter::TreeCacheEvictions, evicted);
+}
+
+} // namespace ImageTree
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "LruCache.h"
+#include "PeImage.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The per-module subtree shown under each module item: one child per directory of the image, each
+// decoded into a flat list of entries only when it is opened. Decoding runs over PeImage::View, so a
+// malformed image yields fewer entries, never a fault.
+namespace ImageTree {
+
+enum class Node : uint32_t {
+    Sections = 0,
+    Imports = 1,
+    Exports = 2,
+    Resources = 3,
+    Memory = 4, // Live, from AddressSpace: not decoded from the file or cached
+    Count
+};
+
+constexpr size_t kNodeCount = static_cast<size_t>(Node::Count);
+
+// Columns after the name; their meaning depends on the node (see ColumnTitle).
+constexpr size_t kDetailColumns = 3;
+
+// Bounds one listing, so a hostile image cannot make a node allocate without limit.
+constexpr size_t kMaxEntries = 65536;
+
+const wchar_t* NodeName(Node node);
+
+/// @brief Title of column 0 (the name) or 1..kDetailColumns for entries of the node.
+const wchar_t* ColumnTitle(Node node, size_t column);
+
+struct Entry {
+    std::wstring name;
+    std::array<std::wstring, kDetailColumns> details;
+};
+
+struct Listing {
+    std::vector<Entry> entries;
+    bool truncated = false; // kMaxEntries reached
+
+    /// @brief Approximate heap footprint, the cost charged against the cache budget.
+    size_t Bytes() const;
+};
+
+/// @brief Decodes one node of an image laid out as a file on disk.
+///   Sections:  name | virtual address | virtual size | characteristics (e.g. "code, R-X")
+///   Imports:   function or "#ordinal" | module | hint | IAT slot RVA
+///   Exports:   name or "#ordinal" | ordinal | RVA | forwarder
+///   Resources: type/name | type | language | size
+/// Memory is not in the file, so it decodes to nothing; see AddressSpace::Describe.
+Listing Decode(const PeImage::View& view, Node node);
+
+// Decoded listings keyed by (module path, node), bounded by Listing::Bytes(). Thread-safe; decoding
+// happens outside the lock, so two threads opening the same node may both decode it once.
+class Cache {
+public:
+    explicit Cache(size_t budgetBytes);
+
+    /// @brief The cached listing, or maps the file and decodes it. Never returns nullptr; an image that
+    /// cannot be opened yields an empty listing (which is cached like any other).
+    std::shared_ptr<const Listing> Get(const std::wstring& path, Node node);
+
+    size_t TotalBytes() const;
+
+    /// @brief Evicts the least recently used listings until at most bytes are held. Folders keep the
+    /// listings they already have.
+    void TrimTo(size_t bytes);
+
+private:
+    mutable std::mutex lock_;
+    LruCache<std::wstring, std::shared_ptr<const Listing>> listings_;
+};
+
+} // namespace ImageTree
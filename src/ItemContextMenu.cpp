@@ -1,12 +1,24 @@
 #include "ItemContextMenu.h"
+#include "Diagnostics.h"
+#include "IidNames.h"
 #include "Log.h"
 #include "ModuleHelpers.h"
+#include "QiProfiler.h"
+#include "SignatureSearchWindow.h"
 
+#include <shobjidl.h>
 #include <shlwapi.h>
 #include <strsafe.h>
 
-ItemContextMenu::ItemContextMenu(std::vector<ContextMenuItemData> items, PIDLIST_ABSOLUTE folderPidl)
-    : items_(std::move(items)) {
+#include <chrono>
+
+namespace {
+// Findings listed per module in the detail view; the message box cannot scroll.
+constexpr size_t kHookLinesPerModule = 20;
+} // namespace
+
+ItemContextMenu::ItemContextMenu(std::vector<ContextMenuItemData> items, PIDLIST_ABSOLUTE folderPidl, bool diagnosticsItem)
+    : items_(std::move(items)), diagnosticsItem_(diagnosticsItem) {
     folderPidl_ = folderPidl ? ILCloneFull(folderPidl) : nullptr;
 }
 
@@ -16,6 +28,12 @@ ItemContextMenu::~ItemContextMenu() {
     }
 }
 
+IFACEMETHODIMP ItemContextMenu::QueryInterface(REFIID riid, void** ppv) {
+    HRESULT hr = RuntimeClass::QueryInterface(riid, ppv);
+    QiProfiler::Record(QiProfiler::Source::ItemContextMenu, IidNames::ToGuid(riid), SUCCEEDED(hr));
+    return hr;
+}
+
 IFACEMETHODIMP ItemContextMenu::QueryContextMenu(HMENU menu, UINT index, UINT idCmdFirst, UINT idCmdLast, UINT flags) {
     if (!menu) {
         return E_INVALIDARG;
@@ -29,10 +47,25 @@ IFACEMETHODIMP ItemContextMenu::QueryContextMenu(HMENU menu, UINT index, UINT id
         return E_FAIL; // Not enough IDs
     }
 
+    if (diagnosticsItem_) {
+        InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdShowDiagnostics, L"Show diagnostics");
+        InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdExportSnapshot, L"Export snapshot...");
+        InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdFindInModules, L"Find in modules...");
+        InsertMenuW(menu, index, MF_BYPOSITION | MF_STRING | (ModuleHelpers::DuplicatesOnly() ? MF_CHECKED : 0),
+            id + kCmdDuplicatesOnly, L"Show only duplicates");
+        SetMenuDefaultItem(menu, id + kCmdShowDiagnostics, FALSE);
+        return MAKE_HRESULT(SEVERITY_SUCCESS, 0, kCmdCount);
+    }
+
     InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdExplore, L"Explore to parent folder");
     InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdProperties, L"Properties");
     InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdUnload, L"Unload");
     InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdCopyPath, L"Copy path");
+    InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdShowHooks, L"Show hooked entries");
+    InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdExportSnapshot, L"Export snapshot...");
+    InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING, id + kCmdFindInModules, L"Find in modules...");
+    InsertMenuW(menu, index++, MF_BYPOSITION | MF_STRING | (ModuleHelpers::DuplicatesOnly() ? MF_CHECKED : 0),
+        id + kCmdDuplicatesOnly, L"Show only duplicates");
     
     return MAKE_HRESULT(SEVERITY_SUCCESS, 0, kCmdCount);
 }
@@ -54,6 +87,16 @@ IFACEMETHODIMP ItemContextMenu::InvokeCommand(LPCMINVOKECOMMANDINFO info) {
             cmd = kCmdUnload;
         } else if (lstrcmpiA(verb, "copypath") == 0) {
             cmd = kCmdCopyPath;
+        } else if (lstrcmpiA(verb, "diagnostics") == 0) {
+            cmd = kCmdShowDiagnostics;
+        } else if (lstrcmpiA(verb, "exportsnapshot") == 0) {
+            cmd = kCmdExportSnapshot;
+        } else if (lstrcmpiA(verb, "hooks") == 0) {
+            cmd = kCmdShowHooks;
+        } else if (lstrcmpiA(verb, "findinmodules") == 0) {
+            cmd = kCmdFindInModules;
+        } else if (lstrcmpiA(verb, "duplicatesonly") == 0) {
+            cmd = kCmdDuplicatesOnly;
         } else {
             return E_FAIL;
         }
@@ -80,7 +123,7 @@ IFACEMETHODIMP ItemContextMenu::InvokeCommand(LPCMINVOKECOMMANDINFO info) {
         bool refresh = false;
         for (const auto& item : items_) {
             if (item.baseAddress) {
-                Log::Write(Log::Level::Info, L"Unloading module at %p: %s", item.baseAddress, item.path.c_str());
+                LOG_INFO(L"Unloading module at {}: {}", item.baseAddress, item.path.c_str());
                 if (ModuleHelpers::UnloadLibrary(item.baseAddress)) {
                         refresh = true;
                 }
@@ -115,6 +158,25 @@ IFACEMETHODIMP ItemContextMenu::InvokeCommand(LPCMINVOKECOMMANDINFO info) {
         }
         break;
     }
+    case kCmdShowDiagnostics: {
+        auto report = Diagnostics::FormatReport();
+        MessageBoxW(info->hwnd, report.c_str(), L"Explorer Modules Diagnostics", MB_ICONINFORMATION | MB_OK);
+        break;
+    }
+    case kCmdExportSnapshot:
+        return ExportSnapshot(info->hwnd);
+    case kCmdShowHooks:
+        ShowHookedEntries(info->hwnd);
+        break;
+    case kCmdFindInModules:
+        return SignatureSearchWindow::Show();
+    case kCmdDuplicatesOnly:
+        // A view toggle for the whole folder, not the selected items.
+        ModuleHelpers::SetDuplicatesOnly(!ModuleHelpers::DuplicatesOnly());
+        if (folderPidl_) {
+            SHChangeNotify(SHCNE_UPDATEDIR, SHCNF_IDLIST, folderPidl_, nullptr);
+        }
+        break;
     default:
         return E_FAIL;
     }
@@ -135,6 +197,16 @@ IFACEMETHODIMP ItemContextMenu::GetCommandString(UINT_PTR idCmd, UINT type, UINT
         return HandleString(type, name, cchMax, "unload", L"unload", "Unload the module.", L"Unload the module.");
     case kCmdCopyPath:
         return HandleString(type, name, cchMax, "copypath", L"copypath", "Copy module path.", L"Copy module path.");
+    case kCmdShowDiagnostics:
+        return HandleString(type, name, cchMax, "diagnostics", L"diagnostics", "Show extension counters.", L"Show extension counters.");
+    case kCmdExportSnapshot:
+        return HandleString(type, name, cchMax, "exportsnapshot", L"exportsnapshot", "Save the module list to a file.", L"Save the module list to a file.");
+    case kCmdShowHooks:
+        return HandleString(type, name, cchMax, "hooks", L"hooks", "List patched import and export entries.", L"List patched import and export entries.");
+    case kCmdFindInModules:
+        return HandleString(type, name, cchMax, "findinmodules", L"findinmodules", "Search loaded modules for byte signatures.", L"Search loaded modules for byte signatures.");
+    case kCmdDuplicatesOnly:
+        return HandleString(type, name, cchMax, "duplicatesonly", L"duplicatesonly", "List only modules loaded more than once.", L"List only modules loaded more than once.");
     default:
         return E_INVALIDARG;
     }
@@ -151,6 +223,76 @@ IFACEMETHODIMP ItemContextMenu::HandleMenuMsg2(UINT, WPARAM, LPARAM, LRESULT* re
     return S_OK;
 }
 
+// Every loaded module is exported, not just the selection: the snapshot is for offline comparison.
+HRESULT ItemContextMenu::ExportSnapshot(HWND owner) {
+    Microsoft::WRL::ComPtr<IFileSaveDialog> dialog;
+    HRESULT hr = CoCreateInstance(CLSID_FileSaveDialog, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&dialog));
+    if (FAILED(hr)) {
+        LOG_ERROR(L"Cannot create the save dialog: 0x{:08X}", static_cast<unsigned long>(hr));
+        return hr;
+    }
+
+    static const COMDLG_FILTERSPEC kFileTypes[] = {
+        { L"Module snapshot (*.emsnap)", L"*.emsnap" },
+        { L"CSV (*.csv)", L"*.csv" },
+        { L"JSON (*.json)", L"*.json" },
+    };
+    dialog->SetFileTypes(ARRAYSIZE(kFileTypes), kFileTypes);
+    dialog->SetDefaultExtension(L"emsnap");
+    dialog->SetFileName(L"modules.emsnap");
+    dialog->SetTitle(L"Export module snapshot");
+
+    hr = dialog->Show(owner);
+    if (hr == HRESULT_FROM_WIN32(ERROR_CANCELLED)) {
+        return S_OK;
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    Microsoft::WRL::ComPtr<IShellItem> result;
+    hr = dialog->GetResult(&result);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    PWSTR path = nullptr;
+    hr = result->GetDisplayName(SIGDN_FILESYSPATH, &path);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    hr = ModuleHelpers::ExportSnapshot(path);
+    CoTaskMemFree(path);
+    if (FAILED(hr)) {
+        MessageBoxW(owner, L"The snapshot could not be written.", L"Explorer Modules", MB_ICONERROR | MB_OK);
+    }
+    return hr;
+}
+
+// Always rescans, so the list reflects the tables as they are now; the folder's column picks up the result.
+void ItemContextMenu::ShowHookedEntries(HWND owner) {
+    const auto scan = ModuleHelpers::RescanHooks();
+    std::wstring text;
+    for (const auto& item : items_) {
+        const uint64_t base = reinterpret_cast<uint64_t>(item.baseAddress);
+        const uint32_t module = scan->index.FindBase(base);
+        text += PathFindFileNameW(item.path.c_str());
+        if (module == HookScan::kNoModule || !scan->report.modules[module].scanned) {
+            text += L": not scanned\n\n";
+            continue;
+        }
+        const auto& result = scan->report.modules[module];
+        if (result.hooked == 0) {
+            text += L": no hooked entries (" + std::to_wstring(result.importsChecked) + L" imports, " +
+                std::to_wstring(result.exportsChecked) + L" exports checked)\n\n";
+            continue;
+        }
+        text += L": " + std::to_wstring(result.hooked) + L" hooked\n";
+        text += HookScan::FormatFindings(scan->report, scan->modules, module, kHookLinesPerModule);
+        text += L"\n";
+    }
+    MessageBoxW(owner, text.c_str(), L"Explorer Modules Hooked Entries", MB_ICONINFORMATION | MB_OK);
+}
+
 HRESULT ItemContextMenu::HandleString(UINT type, LPSTR name, UINT cchMax, const char* verbA, const wchar_t* verbW, const char* helpA, const wchar_t* helpW) {
     switch (type) {
     case GCS_HELPTEXTA:
@@ -14,9 +14,14 @@ struct ContextMenuItemData {
 class ItemContextMenu final
     : public Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>, IContextMenu3, IContextMenu2, IContextMenu> {
 public:
-    explicit ItemContextMenu(std::vector<ContextMenuItemData> items, PIDLIST_ABSOLUTE folderPidl);
+    /// @param diagnosticsItem True when the menu is for the virtual Diagnostics item, which offers only
+    /// "Show diagnostics", "Export snapshot...", "Find in modules..." and "Show only duplicates" and
+    /// ignores items.
+    explicit ItemContextMenu(std::vector<ContextMenuItemData> items, PIDLIST_ABSOLUTE folderPidl, bool diagnosticsItem = false);
     ~ItemContextMenu();
 
+    IFACEMETHODIMP QueryInterface(REFIID riid, void** ppv) override;
+
     IFACEMETHODIMP QueryContextMenu(HMENU menu, UINT index, UINT idCmdFirst, UINT idCmdLast, UINT flags) override;
     IFACEMETHODIMP InvokeCommand(LPCMINVOKECOMMANDINFO info) override;
     IFACEMETHODIMP GetCommandString(UINT_PTR idCmd, UINT type, UINT*, LPSTR name, UINT cchMax) override;
@@ -24,6 +29,8 @@ public:
     IFACEMETHODIMP HandleMenuMsg2(UINT, WPARAM, LPARAM, LRESULT* result) override;
 
 private:
+    HRESULT ExportSnapshot(HWND owner);
+    void ShowHookedEntries(HWND owner);
     HRESULT HandleString(UINT type, LPSTR name, UINT cchMax, const char* verbA, const wchar_t* verbW, const char* helpA, const wchar_t* helpW);
 
     enum : UINT {
@@ -31,9 +38,15 @@ private:
         kCmdProperties = 1,
         kCmdUnload = 2,
         kCmdCopyPath = 3,
-        kCmdCount = 4
+        kCmdShowDiagnostics = 4,
+        kCmdExportSnapshot = 5,
+        kCmdShowHooks = 6,
+        kCmdFindInModules = 7,
+        kCmdDuplicatesOnly = 8,
+        kCmdCount = 9
     };
 
     std::vector<ContextMenuItemData> items_;
     PIDLIST_ABSOLUTE folderPidl_ = nullptr;
+    bool diagnosticsItem_ = false;
 };
@@ -0,0 +1,95 @@
+#include "ItemIcon.h"
+#include "IidNames.h"
+#include "Log.h"
+#include "ModuleHelpers.h"
+#include "QiProfiler.h"
+
+#include <strsafe.h>
+
+#include <cstring>
+
+namespace {
+
+constexpr wchar_t kLocationPrefix[] = L"ExplorerModulesIcon:";
+
+// A 32-bit top-down DIB section with the decoded pixels; the mask is ignored for 32-bit colour but
+// CreateIconIndirect still needs one.
+HICON CreateIconFromImage(const PeIcon::Image& image) {
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = static_cast<LONG>(image.width);
+    info.bmiHeader.biHeight = -static_cast<LONG>(image.height);
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    HBITMAP color = CreateDIBSection(nullptr, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!color) {
+        return nullptr;
+    }
+    std::memcpy(bits, image.pixels.data(), image.pixels.size() * sizeof(uint32_t));
+    HBITMAP mask = CreateBitmap(static_cast<int>(image.width), static_cast<int>(image.height), 1, 1, nullptr);
+    HICON icon = nullptr;
+    if (mask) {
+        ICONINFO iconInfo = {};
+        iconInfo.fIcon = TRUE;
+        iconInfo.hbmColor = color;
+        iconInfo.hbmMask = mask;
+        icon = CreateIconIndirect(&iconInfo);
+        DeleteObject(mask);
+    }
+    DeleteObject(color);
+    return icon;
+}
+
+} // namespace
+
+ItemIcon::ItemIcon(std::wstring path, void* baseAddress) : path_(std::move(path)), baseAddress_(baseAddress) {}
+
+IFACEMETHODIMP ItemIcon::QueryInterface(REFIID riid, void** ppv) {
+    HRESULT hr = RuntimeClass::QueryInterface(riid, ppv);
+    QiProfiler::Record(QiProfiler::Source::ItemIcon, IidNames::ToGuid(riid), SUCCEEDED(hr));
+    return hr;
+}
+
+IFACEMETHODIMP ItemIcon::GetIconLocation(UINT, PWSTR iconFile, UINT cchMax, int* index, UINT* outFlags) {
+    if (!iconFile || !index || !outFlags) {
+        return E_POINTER;
+    }
+    Sha::Sha256::Digest digest;
+    if (!ModuleHelpers::GetModuleIconDigest(path_, baseAddress_, digest)) {
+        return S_FALSE; // The shell draws the default icon
+    }
+    const std::wstring location = kLocationPrefix + Sha::ToHex(digest.data(), digest.size());
+    HRESULT hr = StringCchCopyW(iconFile, cchMax, location.c_str());
+    if (FAILED(hr)) {
+        return hr;
+    }
+    *index = 0;
+    // Not a file: the shell calls Extract, and caches the result under the location.
+    *outFlags = GIL_NOTFILENAME | GIL_PERINSTANCE;
+    return S_OK;
+}
+
+IFACEMETHODIMP ItemIcon::Extract(PCWSTR, UINT, HICON* large, HICON* small, UINT iconSize) {
+    const UINT sizes[] = { LOWORD(iconSize), HIWORD(iconSize) };
+    HICON* icons[] = { large, small };
+    for (size_t i = 0; i < 2; ++i) {
+        if (!icons[i]) {
+            continue;
+        }
+        *icons[i] = nullptr;
+        if (sizes[i] == 0) {
+            continue;
+        }
+        auto image = ModuleHelpers::GetModuleIcon(path_, baseAddress_, sizes[i]);
+        *icons[i] = image ? CreateIconFromImage(*image) : nullptr;
+        if (!*icons[i]) {
+            LOG_TRACE(L"Extract: no {}px icon for {}", sizes[i], path_);
+            if (i == 0) {
+                return E_FAIL;
+            }
+        }
+    }
+    return S_OK;
+}
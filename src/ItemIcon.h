@@ -0,0 +1,24 @@
+#pragma once
+
+#include <windows.h>
+#include <shlobj.h>
+#include <string>
+#include <wrl.h>
+
+// The icon of one module item, drawn from the module's own RT_GROUP_ICON. The location is the icon's
+// content digest rather than the module path, so the shell image list keeps one copy of an icon that
+// many modules share, and modules without an icon fall back to the default.
+class ItemIcon final
+    : public Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>, IExtractIconW> {
+public:
+    ItemIcon(std::wstring path, void* baseAddress);
+
+    IFACEMETHODIMP QueryInterface(REFIID riid, void** ppv) override;
+
+    IFACEMETHODIMP GetIconLocation(UINT flags, PWSTR iconFile, UINT cchMax, int* index, UINT* outFlags) override;
+    IFACEMETHODIMP Extract(PCWSTR iconFile, UINT index, HICON* large, HICON* small, UINT iconSize) override;
+
+private:
+    std::wstring path_;
+    void* baseAddress_ = nullptr;
+};
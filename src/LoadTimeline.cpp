@@ -0,0 +1,168 @@
+#include "LoadTimeline.h"
+
+namespace {
+// Idle threads are only pruned once this many are held, so OnLoaded rarely scans them.
+constexpr size_t kMaxThreads = 64;
+} // namespace
+
+uint64_t LoadTimeline::BeginLoad(uint64_t thread, const std::wstring& path, Perf::Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    const uint64_t token = nextToken_++;
+    ThreadState& state = threads_[thread];
+    CloseCascade(state);
+    state.timed.push_back({ token, path, now });
+    state.lastEvent = now;
+    tokenThreads_[token] = thread;
+    return token;
+}
+
+void LoadTimeline::EndLoad(uint64_t token, const void* base, Perf::Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    const auto owner = tokenThreads_.find(token);
+    if (owner == tokenThreads_.end()) {
+        return;
+    }
+    const uint64_t thread = owner->second;
+    tokenThreads_.erase(owner);
+    const auto found = threads_.find(thread);
+    if (found == threads_.end()) {
+        return;
+    }
+    ThreadState& state = found->second;
+    auto open = state.timed.end();
+    for (auto it = state.timed.begin(); it != state.timed.end(); ++it) {
+        if (it->token == token) {
+            open = it;
+        }
+    }
+    if (open == state.timed.end()) {
+        return;
+    }
+    const OpenLoad load = std::move(*open);
+    state.timed.erase(open);
+    state.lastEvent = now;
+    ++timedLoads_;
+    Perf::RecordSpan(Perf::Op::ModuleLoad, load.started, now);
+
+    if (base) {
+        auto [record, inserted] = modules_.try_emplace(base);
+        if (inserted) {
+            // Its notification was missed (it arrived before registration, or on another thread).
+            record->second.path = load.path;
+            record->second.loadedAt = load.started;
+        }
+        record->second.duration = now - load.started;
+        record->second.loadedBy = state.timed.empty() ? std::wstring() : state.timed.back().path;
+        record->second.timed = true;
+    }
+    if (state.timed.empty() && !state.cascadeRoot) {
+        threads_.erase(found);
+    }
+}
+
+void LoadTimeline::OnLoaded(uint64_t thread, const void* base, const wchar_t* path, size_t pathLength,
+    Perf::Clock::time_point now) {
+    std::lock_guard lock(mutex_);
+    ++events_;
+    if (threads_.size() >= kMaxThreads && !threads_.count(thread)) {
+        PruneThreads(now);
+    }
+    ThreadState& state = threads_[thread];
+    Record record;
+    if (path) {
+        record.path.assign(path, pathLength);
+    }
+    record.loadedAt = now;
+
+    if (!state.timed.empty()) {
+        record.loadedBy = state.timed.back().path;
+        record.duration = now - state.lastEvent;
+        state.lastEvent = now;
+    } else {
+        const auto root = state.cascadeRoot ? modules_.find(state.cascadeRoot) : modules_.end();
+        if (root != modules_.end() && now - state.lastEvent <= kCascadeGap) {
+            record.loadedBy = root->second.path;
+            record.duration = now - state.lastEvent;
+            root->second.duration = now - state.cascadeStart;
+        } else {
+            CloseCascade(state);
+            state.cascadeRoot = base;
+            state.cascadeStart = now;
+            ++cascades_;
+        }
+        state.lastEvent = now;
+    }
+    modules_.insert_or_assign(base, std::move(record));
+}
+
+void LoadTimeline::OnUnloaded(const void* base) {
+    std::lock_guard lock(mutex_);
+    modules_.erase(base);
+    for (auto& [thread, state] : threads_) {
+        if (state.cascadeRoot == base) {
+            state.cascadeRoot = nullptr;
+        }
+    }
+}
+
+bool LoadTimeline::Find(const void* base, Record& record) const {
+    std::lock_guard lock(mutex_);
+    const auto found = modules_.find(base);
+    if (found == modules_.end()) {
+        return false;
+    }
+    record = found->second;
+    return true;
+}
+
+LoadTimeline::Stats LoadTimeline::GetStats() const {
+    std::lock_guard lock(mutex_);
+    return { events_, timedLoads_, cascades_, modules_.size() };
+}
+
+size_t LoadTimeline::Bytes() const {
+    std::lock_guard lock(mutex_);
+    // Each record sits in a node with its key, the next pointer and the cached hash.
+    size_t bytes = modules_.size() * (sizeof(std::pair<const void* const, Record>) + 2 * sizeof(void*)) +
+        modules_.bucket_count() * sizeof(void*);
+    for (const auto& [base, record] : modules_) {
+        bytes += (record.path.size() + record.loadedBy.size()) * sizeof(wchar_t);
+    }
+    return bytes;
+}
+
+void LoadTimeline::Clear() {
+    std::lock_guard lock(mutex_);
+    modules_.clear();
+    for (auto it = threads_.begin(); it != threads_.end();) {
+        if (it->second.timed.empty()) {
+            it = threads_.erase(it);
+        } else {
+            it->second.cascadeRoot = nullptr;
+            ++it;
+        }
+    }
+}
+
+void LoadTimeline::CloseCascade(ThreadState& state) {
+    if (!state.cascadeRoot) {
+        return;
+    }
+    // A root that brought in nothing has no measurable time of its own, so it stays out of the histogram.
+    const auto root = modules_.find(state.cascadeRoot);
+    if (root != modules_.end() && root->second.duration.count() > 0) {
+        Perf::RecordSpan(Perf::Op::ModuleLoad, state.cascadeStart, state.cascadeStart + root->second.duration);
+    }
+    state.cascadeRoot = nullptr;
+}
+
+void LoadTimeline::PruneThreads(Perf::Clock::time_point now) {
+    for (auto it = threads_.begin(); it != threads_.end();) {
+        if (it->second.timed.empty() && now - it->second.lastEvent > kCascadeGap) {
+            CloseCascade(it->second);
+            it = threads_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
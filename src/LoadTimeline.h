@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Perf.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Which modules took how long to load, and which load brought them in. Loader notifications arrive on
+// the thread doing the load, in the order the loader maps the graph, so each one is timestamped and
+// charged to the load in progress on its thread:
+//
+//  * A timed load (BeginLoad/EndLoad around LoadLibrary) is the root of every module its thread maps
+//    until it returns. Its own time is the whole call, dependencies and DllMains included.
+//  * Any other load is only seen through its notifications. A module mapped on a thread that mapped
+//    nothing in the last kCascadeGap starts a cascade, and the modules that follow closely on the same
+//    thread are charged to it; its time runs from its own notification to the last of theirs.
+//
+// A dependency's time is the gap since the previous notification on its thread: the loader mapping and
+// snapping it. Threads are opaque keys and times are passed in, so storms can be replayed off Windows.
+// Every method is safe from any thread, including under the loader lock.
+class LoadTimeline {
+public:
+    static constexpr std::chrono::milliseconds kCascadeGap{ 2 };
+
+    struct Record {
+        std::wstring path;
+        Perf::Clock::time_point loadedAt;
+        Perf::Clock::duration duration{}; // Whole call for a timed load, see above for the rest
+        std::wstring loadedBy;            // Root of the cascade; empty for a root
+        bool timed = false;               // A root timed around its LoadLibrary call
+    };
+
+    struct Stats {
+        uint64_t events;   // Loaded notifications recorded
+        uint64_t timed;    // Timed loads completed
+        uint64_t cascades; // Untimed roots
+        size_t modules;    // Records held (one per loaded module seen loading)
+    };
+
+    /// @brief Starts a timed load of path on thread. Loads may nest, on one thread or many.
+    /// @return A token for EndLoad.
+    uint64_t BeginLoad(uint64_t thread, const std::wstring& path, Perf::Clock::time_point now);
+
+    /// @brief Ends the timed load; base is the module it returned, or null if it failed. The module's
+    /// record becomes the root, timed from BeginLoad, and the span is recorded as Perf::Op::ModuleLoad.
+    void EndLoad(uint64_t token, const void* base, Perf::Clock::time_point now);
+
+    /// @brief A loaded notification: records the module and charges it to its thread's current load.
+    void OnLoaded(uint64_t thread, const void* base, const wchar_t* path, size_t pathLength, Perf::Clock::time_point now);
+
+    /// @brief An unloaded notification: forgets the module, so a base reused by a later load is not
+    /// mistaken for it.
+    void OnUnloaded(const void* base);
+
+    /// @brief The record of the module loaded at base, if it was seen loading.
+    bool Find(const void* base, Record& record) const;
+
+    Stats GetStats() const;
+
+    /// @brief Approximate bytes held by the records and their paths.
+    size_t Bytes() const;
+
+    /// @brief Forgets every module and untimed cascade, for when notifications stop arriving and unloads
+    /// would go unseen. Timed loads still in progress are kept.
+    void Clear();
+
+private:
+    struct OpenLoad {
+        uint64_t token;
+        std::wstring path;
+        Perf::Clock::time_point started;
+    };
+
+    struct ThreadState {
+        std::vector<OpenLoad> timed;     // Innermost last
+        const void* cascadeRoot = nullptr; // Untimed root still collecting modules
+        Perf::Clock::time_point cascadeStart{};
+        Perf::Clock::time_point lastEvent{};
+    };
+
+    void CloseCascade(ThreadState& state);
+    void PruneThreads(Perf::Clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<const void*, Record> modules_;
+    std::unordered_map<uint64_t, ThreadState> threads_;
+    std::unordered_map<uint64_t, uint64_t> tokenThreads_;
+    uint64_t nextToken_ = 1;
+    uint64_t events_ = 0;
+    uint64_t timedLoads_ = 0;
+    uint64_t cascades_ = 0;
+};
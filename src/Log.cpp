@@ -1,10 +1,11 @@
 #include "Log.h"
-
-#include <strsafe.h>
-#include <cstdarg>
+#include "Platform.h"
+#include "Settings.h"
 
 namespace Log {
 namespace {
+constexpr wchar_t kLogLevelSetting[] = L"LogLevel";
+
 const wchar_t* LevelToString(Level level) {
     switch (level) {
     case Level::Trace:
@@ -23,24 +24,28 @@ const wchar_t* LevelToString(Level level) {
 }
 } // namespace
 
-void Write(Level level, const wchar_t* format, ...) {
-    // Compile-time log level check
-    if (level > kMaxLogLevel) {
-        return;
-    }
-
-    if (!format) {
-        return;
-    }
+namespace detail {
+std::atomic<int> g_runtimeLevel{ static_cast<int>(kDefaultLogLevel) };
 
-    wchar_t message[1024] = {};
-    va_list args;
-    va_start(args, format);
-    StringCchVPrintfW(message, ARRAYSIZE(message), format, args);
-    va_end(args);
+void Emit(Level level, const std::wstring& message) {
+    std::wstring output = L"[ExplorerModules][";
+    output += LevelToString(level);
+    output += L"] ";
+    output += message;
+    output += L"\n";
+    Platform::DebugOutput(output);
+}
+} // namespace detail
 
-    wchar_t output[1200] = {};
-    StringCchPrintfW(output, ARRAYSIZE(output), L"[ExplorerModules][%s] %s\n", LevelToString(level), message);
-    OutputDebugStringW(output);
+void RefreshRuntimeLevel() {
+    const uint32_t value = Settings::ReadDword(kLogLevelSetting, static_cast<uint32_t>(kDefaultLogLevel));
+    int level = static_cast<int>(kDefaultLogLevel);
+    if (value <= static_cast<uint32_t>(Level::Trace)) {
+        level = static_cast<int>(value);
+    }
+    if (level > static_cast<int>(kMaxLogLevel)) {
+        level = static_cast<int>(kMaxLogLevel);
+    }
+    detail::g_runtimeLevel.store(level, std::memory_order_relaxed);
 }
 } // namespace Log
@@ -1,6 +1,27 @@
 #pragma once
 
-#include <windows.h>
+#include <atomic>
+#include <string>
+#include <utility>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+// Toolchains without std::format (GCC 12, used for the portable core and benchmarks) get a small
+// runtime formatter that understands the subset of the syntax used in this codebase: "{}", "{:X}" and
+// "{:08X}"-style hex specs, and "{{" / "}}". Its format strings are checked at compile time like
+// std::wformat_string's, against that subset: the field count, the specs, hex only for integers, and
+// no narrow strings, which std::format cannot put into a wide message.
+#if defined(__cpp_lib_format)
+#define EXPLORER_MODULES_HAS_STD_FORMAT 1
+#else
+#define EXPLORER_MODULES_HAS_STD_FORMAT 0
+#include <cstdint>
+#include <cwchar>
+#include <string_view>
+#include <type_traits>
+#endif
 
 namespace Log {
 enum class Level {
@@ -8,11 +29,211 @@ enum class Level {
     Error,
     Warn,
     Info,
-    Trace    
+    Trace
+};
+
+// Compile-time ceiling. Call sites above this level are discarded by the LOG_* macros, arguments
+// included. Define EXPLORER_MODULES_MAX_LOG_LEVEL (0 = Critical ... 4 = Trace) to strip levels from a build.
+#ifndef EXPLORER_MODULES_MAX_LOG_LEVEL
+#define EXPLORER_MODULES_MAX_LOG_LEVEL 4
+#endif
+constexpr Level kMaxLogLevel = static_cast<Level>(EXPLORER_MODULES_MAX_LOG_LEVEL);
+
+// Runtime level used until the registry says otherwise.
+constexpr Level kDefaultLogLevel = Level::Info;
+
+constexpr bool IsCompiledIn(Level level) {
+    return level <= kMaxLogLevel;
+}
+
+namespace detail {
+extern std::atomic<int> g_runtimeLevel;
+void Emit(Level level, const std::wstring& message);
+
+#if !EXPLORER_MODULES_HAS_STD_FORMAT
+// Longest flags and width ("08", "#018") a hex spec may put before its 'x' or 'X'.
+constexpr size_t kMaxHexFlags = 7;
+
+template <class T>
+constexpr bool kIsInteger = std::is_integral_v<std::decay_t<T>> || std::is_enum_v<std::decay_t<T>>;
+
+template <class T>
+constexpr bool kIsWideText = std::is_convertible_v<const T&, std::wstring_view>;
+
+template <class T>
+constexpr bool kIsNarrowText = std::is_convertible_v<const T&, std::string_view> ||
+    std::is_same_v<std::remove_cv_t<std::remove_pointer_t<std::decay_t<T>>>, char>;
+
+// Not constexpr: reaching it while checking a format string makes the call site ill-formed, and the
+// compiler names this function and the message in the error.
+inline void FormatStringError(const char*) {}
+
+// Checks "{}" and "{:[flags]x}" / "{:[flags]X}" fields against the argument types, during constant
+// evaluation of FormatString's constructor.
+template <class... Args>
+consteval void CheckFormat(const wchar_t* format) {
+    constexpr bool integer[] = { kIsInteger<Args>..., false };
+    size_t field = 0;
+    for (const wchar_t* p = format; *p; ++p) {
+        if ((*p == L'{' || *p == L'}') && p[1] == *p) {
+            ++p;
+            continue;
+        }
+        if (*p == L'}') {
+            FormatStringError("unmatched '}' in format string");
+        }
+        if (*p != L'{') {
+            continue;
+        }
+        ++p;
+        if (*p == L':') {
+            const wchar_t* spec = ++p;
+            while (*p && *p != L'}') {
+                ++p;
+            }
+            const size_t length = static_cast<size_t>(p - spec);
+            if (length == 0 || (p[-1] != L'x' && p[-1] != L'X')) {
+                FormatStringError("only {} and hex {:x} / {:X} fields are supported");
+            }
+            if (length - 1 > kMaxHexFlags) {
+                FormatStringError("hex spec flags are longer than kMaxHexFlags");
+            }
+            for (const wchar_t* flag = spec; flag + 1 < p; ++flag) {
+                if (!((*flag >= L'0' && *flag <= L'9') || *flag == L'#')) {
+                    FormatStringError("hex spec flags may only be digits and '#'");
+                }
+            }
+            if (field < sizeof...(Args) && !integer[field]) {
+                FormatStringError("hex spec applied to an argument that is not an integer");
+            }
+        }
+        if (*p != L'}') {
+            FormatStringError("replacement fields must be {} or {:spec}");
+        }
+        ++field;
+    }
+    if (field != sizeof...(Args)) {
+        FormatStringError("format string and argument count differ");
+    }
+    if constexpr (((kIsNarrowText<Args> && !kIsWideText<Args>) || ...)) {
+        FormatStringError("narrow string passed to a wide format string");
+    }
+}
+
+template <class... Args>
+struct FormatString {
+    consteval FormatString(const wchar_t* format) : text(format) {
+        CheckFormat<Args...>(format);
+    }
+
+    const wchar_t* text;
 };
 
-// Compile-time configuration for log level
-constexpr Level kMaxLogLevel = Level::Info;
+// Renders one argument; spec is the text after ':' in the replacement field (may be empty).
+template <class T>
+std::wstring FormatArg(std::wstring_view spec, const T& value) {
+    using Decayed = std::decay_t<T>;
+    static_assert(kIsWideText<T> || !kIsNarrowText<T>, "narrow strings cannot be formatted into a wide message");
+    if constexpr (std::is_integral_v<Decayed> || std::is_enum_v<Decayed>) {
+        const auto bits = static_cast<unsigned long long>(value);
+        if (!spec.empty() && (spec.back() == L'X' || spec.back() == L'x')) {
+            // CheckFormat refuses longer flags; should one get here anyway, it is formatted without them.
+            wchar_t format[8 + kMaxHexFlags] = L"%";
+            const std::wstring_view flags = spec.substr(0, spec.size() - 1);
+            if (flags.size() <= kMaxHexFlags) {
+                flags.copy(format + 1, flags.size());
+            }
+            std::wcscat(format, spec.back() == L'X' ? L"llX" : L"llx");
+            wchar_t buffer[40] = {};
+            std::swprintf(buffer, 40, format, bits);
+            return buffer;
+        }
+        if constexpr (std::is_signed_v<Decayed>) {
+            return std::to_wstring(static_cast<long long>(value));
+        } else {
+            return std::to_wstring(bits);
+        }
+    } else if constexpr (std::is_floating_point_v<Decayed>) {
+        return std::to_wstring(value);
+    } else if constexpr (std::is_pointer_v<Decayed> && !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Decayed>>, wchar_t> &&
+        !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Decayed>>, char>) {
+        wchar_t buffer[24] = {};
+        std::swprintf(buffer, 24, L"0x%llx", static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(value)));
+        return buffer;
+    } else {
+        return std::wstring(std::wstring_view(value));
+    }
+}
 
-void Write(Level level, const wchar_t* format, ...);
+template <class... Args>
+std::wstring FormatFallback(std::wstring_view format, const Args&... args) {
+    std::wstring result;
+    size_t next = 0;
+    for (size_t i = 0; i < format.size(); ++i) {
+        const wchar_t ch = format[i];
+        if ((ch == L'{' || ch == L'}') && i + 1 < format.size() && format[i + 1] == ch) {
+            result += ch;
+            ++i;
+            continue;
+        }
+        const size_t close = ch == L'{' ? format.find(L'}', i) : std::wstring_view::npos;
+        if (close == std::wstring_view::npos) {
+            result += ch;
+            continue;
+        }
+        const std::wstring_view field = format.substr(i + 1, close - i - 1);
+        const size_t colon = field.find(L':');
+        const std::wstring_view spec = colon == std::wstring_view::npos ? std::wstring_view() : field.substr(colon + 1);
+        size_t index = 0;
+        ((index++ == next ? (void)(result += FormatArg(spec, args)) : (void)0), ...);
+        (void)index;
+        (void)spec;
+        ++next;
+        i = close;
+    }
+    return result;
+}
+#endif
+} // namespace detail
+
+/// @brief Returns true if messages at the given level are currently written.
+inline bool IsEnabled(Level level) {
+    return static_cast<int>(level) <= detail::g_runtimeLevel.load(std::memory_order_relaxed);
+}
+
+/// @brief Re-reads the runtime level from HKCU\Software\ExplorerModulesNamespace, value "LogLevel"
+/// (REG_DWORD, 0 = Critical ... 4 = Trace). Missing or invalid values restore kDefaultLogLevel.
+/// The result is clamped to kMaxLogLevel.
+void RefreshRuntimeLevel();
+
+/// @brief Formats and writes a message. Prefer the LOG_* macros, which skip argument evaluation
+/// when the level is disabled.
+#if EXPLORER_MODULES_HAS_STD_FORMAT
+template <class... Args>
+void Write(Level level, std::wformat_string<Args...> format, Args&&... args) {
+    detail::Emit(level, std::format(format, std::forward<Args>(args)...));
+}
+#else
+template <class... Args>
+void Write(Level level, detail::FormatString<std::type_identity_t<Args>...> format, Args&&... args) {
+    detail::Emit(level, detail::FormatFallback(format.text, args...));
+}
+#endif
 } // namespace Log
+
+// Levels above kMaxLogLevel compile to nothing; enabled-but-filtered levels cost one relaxed load.
+// The format string is checked against the arguments at compile time either way.
+#define LOG_AT(level, ...)                          \
+    do {                                            \
+        if constexpr (::Log::IsCompiledIn(level)) { \
+            if (::Log::IsEnabled(level)) {          \
+                ::Log::Write(level, __VA_ARGS__);   \
+            }                                       \
+        }                                           \
+    } while (0)
+
+#define LOG_CRITICAL(...) LOG_AT(::Log::Level::Critical, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(::Log::Level::Error, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(::Log::Level::Warn, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(::Log::Level::Info, __VA_ARGS__)
+#define LOG_TRACE(...) LOG_AT(::Log::Level::Trace, __VA_ARGS__)
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// Least-recently-used cache bounded by a total cost. Each entry carries a caller-supplied cost (1 for
+// entry-count bounds, bytes for memory budgets); inserting past the budget evicts from the cold end.
+// Not thread-safe; owners serialize access.
+template <class Key, class Value, class Hash = std::hash<Key>>
+class LruCache {
+public:
+    explicit LruCache(size_t budget) : budget_(budget) {}
+
+    /// @brief Returns the cached value and marks it most recently used, or nullptr on a miss.
+    Value* Find(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->value;
+    }
+
+    /// @brief Inserts or replaces a value. Returns the number of other entries evicted to stay within budget.
+    /// The new entry itself is never evicted, even if it alone exceeds the budget.
+    size_t Insert(const Key& key, Value value, size_t cost = 1) {
+        Erase(key);
+        entries_.push_front({ key, std::move(value), cost });
+        index_.emplace(key, entries_.begin());
+        totalCost_ += cost;
+        return TrimTo(budget_);
+    }
+
+    /// @brief Removes one entry. Returns true if it was present.
+    bool Erase(const Key& key) {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        totalCost_ -= it->second->cost;
+        entries_.erase(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    /// @brief Evicts cold entries (keeping at least the most recent one) until the total cost is at or
+    /// below target. Returns the number evicted.
+    size_t TrimTo(size_t target) {
+        size_t evicted = 0;
+        while (totalCost_ > target && entries_.size() > 1) {
+            auto& victim = entries_.back();
+            totalCost_ -= victim.cost;
+            index_.erase(victim.key);
+            entries_.pop_back();
+            ++evicted;
+        }
+        return evicted;
+    }
+
+    void Clear() {
+        entries_.clear();
+        index_.clear();
+        totalCost_ = 0;
+    }
+
+    void SetBudget(size_t budget) { budget_ = budget; }
+
+    size_t Budget() const { return budget_; }
+    size_t TotalCost() const { return totalCost_; }
+    size_t Size() const { return index_.size(); }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t cost;
+    };
+
+    std::list<Entry> entries_;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index_;
+    size_t budget_;
+    size_t totalCost_ = 0;
+};
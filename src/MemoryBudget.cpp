@@ -0,0 +1,81 @@
+#include "MemoryBudget.h"
+
+#include <algorithm>
+
+namespace {
+
+std::wstring Kilobytes(size_t bytes) {
+    return std::to_wstring((bytes + 1023) / 1024) + L" KB";
+}
+
+} // namespace
+
+MemoryBudget& MemoryBudget::Process() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+void MemoryBudget::Register(const wchar_t* name, BytesFn bytes, TrimFn trim) {
+    std::lock_guard lock(mutex_);
+    pools_.push_back({ name, bytes, trim });
+}
+
+std::vector<MemoryBudget::Pool> MemoryBudget::Report() const {
+    std::lock_guard lock(mutex_);
+    std::vector<Pool> report;
+    report.reserve(pools_.size());
+    for (const auto& pool : pools_) {
+        report.push_back({ pool.name, pool.bytes(), pool.trim != nullptr });
+    }
+    return report;
+}
+
+size_t MemoryBudget::TotalBytes() const {
+    size_t total = 0;
+    for (const auto& pool : Report()) {
+        total += pool.bytes;
+    }
+    return total;
+}
+
+size_t MemoryBudget::TrimTo(size_t lowWater) {
+    std::lock_guard lock(mutex_);
+    std::vector<size_t> held(pools_.size());
+    size_t fixed = 0;
+    size_t trimmable = 0;
+    for (size_t i = 0; i < pools_.size(); ++i) {
+        held[i] = pools_[i].bytes();
+        (pools_[i].trim ? trimmable : fixed) += held[i];
+    }
+    if (fixed + trimmable <= lowWater || trimmable == 0) {
+        return 0;
+    }
+    // What is left for the trimmable pools once the fixed ones are counted, shared out by size.
+    const double keep = lowWater > fixed ? static_cast<double>(lowWater - fixed) / static_cast<double>(trimmable) : 0.0;
+    size_t released = 0;
+    for (size_t i = 0; i < pools_.size(); ++i) {
+        if (!pools_[i].trim || held[i] == 0) {
+            continue;
+        }
+        pools_[i].trim(static_cast<size_t>(static_cast<double>(held[i]) * keep));
+        const size_t after = pools_[i].bytes();
+        released += held[i] > after ? held[i] - after : 0;
+    }
+    return released;
+}
+
+std::wstring MemoryBudget::Format() const {
+    auto report = Report();
+    std::stable_sort(report.begin(), report.end(), [](const Pool& a, const Pool& b) { return a.bytes > b.bytes; });
+    std::wstring text;
+    size_t total = 0;
+    for (const auto& pool : report) {
+        text += pool.name;
+        text += L": ";
+        text += Kilobytes(pool.bytes);
+        text += pool.trimmable ? L"\n" : L" (freed with its owners)\n";
+        total += pool.bytes;
+    }
+    text += L"Total: " + Kilobytes(total) + L"\n";
+    return text;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// What the extension keeps between calls (caches, scan results, decoded listings, histories), by pool.
+// Each pool reports what it holds and trims itself to a target, with its own lock and eviction order;
+// the budget only adds them up and shares out a trim. Bytes are estimates: containers and strings are
+// counted by size, allocator overhead is not.
+class MemoryBudget {
+public:
+    /// @brief Bytes the pool holds now.
+    using BytesFn = size_t (*)();
+
+    /// @brief Releases entries until the pool holds at most target bytes, or as close as it can get.
+    using TrimFn = void (*)(size_t target);
+
+    struct Pool {
+        const wchar_t* name;
+        size_t bytes;
+        bool trimmable;
+    };
+
+    /// @brief The budget the extension's own pools register with.
+    static MemoryBudget& Process();
+
+    /// @brief Adds a pool. name must outlive the budget. trim may be null for a pool that only accounts,
+    /// because it is freed with the objects that own it.
+    void Register(const wchar_t* name, BytesFn bytes, TrimFn trim);
+
+    /// @brief Every pool, in registration order.
+    std::vector<Pool> Report() const;
+
+    size_t TotalBytes() const;
+
+    /// @brief Trims every trimmable pool by the same fraction, so the total comes to about lowWater,
+    /// and returns the bytes released. Pools that only account keep what they hold.
+    size_t TrimTo(size_t lowWater);
+
+    /// @brief One line per pool, largest first, then the total.
+    std::wstring Format() const;
+
+private:
+    struct Entry {
+        const wchar_t* name;
+        BytesFn bytes;
+        TrimFn trim;
+    };
+
+    // Guards the list only; pools are called under it, so they must never register.
+    mutable std::mutex mutex_;
+    std::vector<Entry> pools_;
+};
@@ -0,0 +1,45 @@
+#include "ModuleEnumerator.h"
+
+#include "Log.h"
+#include "Perf.h"
+#include "PidlCodec.h"
+
+#include <algorithm>
+
+ModuleEnumerator::ModuleEnumerator(std::shared_ptr<const Snapshot> modules, DescribeFn describe, bool includeDiagnostics)
+    : modules_(std::move(modules)), describe_(describe), includeDiagnostics_(includeDiagnostics) {
+}
+
+size_t ModuleEnumerator::Next(size_t count, void** items) {
+    Perf::ScopedTimer timer(Perf::Op::EnumNext);
+    size_t copied = 0;
+    while (copied < count && index_ < ItemCount()) {
+        void* item = nullptr;
+        if (includeDiagnostics_ && index_ == 0) {
+            item = PidlCodec::Create(PidlCodec::kDiagnosticsSignature, L"", 0, 0);
+        } else {
+            Handle module = (*modules_)[index_ - (includeDiagnostics_ ? 1 : 0)];
+            if (!describe_(module, scratch_)) {
+                // Unloaded since the snapshot was taken; the loader notification will refresh the view.
+                LOG_TRACE(L"ModuleEnumerator::Next skipping unloaded module {}", reinterpret_cast<const void*>(module));
+                ++index_;
+                continue;
+            }
+            item = PidlCodec::Create(PidlCodec::kModuleSignature, scratch_.path,
+                reinterpret_cast<uintptr_t>(scratch_.baseAddress), scratch_.size);
+        }
+        if (!item) {
+            LOG_ERROR(L"ModuleEnumerator::Next failed to create PIDL");
+            break;
+        }
+        items[copied++] = item;
+        ++index_;
+    }
+    return copied;
+}
+
+size_t ModuleEnumerator::Skip(size_t count) {
+    const size_t skipped = (std::min)(count, ItemCount() - index_);
+    index_ += skipped;
+    return skipped;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ModuleRecord {
+    std::wstring path;
+    void* baseAddress;
+    uint32_t size;
+};
+
+// Position and encoding logic behind EnumIDList, free of COM so it can run over fake snapshots. The
+// snapshot holds opaque module handles; a describe callback turns one into a ModuleRecord only when the
+// enumeration reaches it.
+class ModuleEnumerator {
+public:
+    using Handle = uintptr_t;
+    using Snapshot = std::vector<Handle>;
+    /// @brief Fills record for a handle. Returns false if the module is gone, in which case it is skipped.
+    using DescribeFn = bool (*)(Handle handle, ModuleRecord& record);
+
+    /// @param includeDiagnostics Yield the Diagnostics item ahead of the modules.
+    ModuleEnumerator(std::shared_ptr<const Snapshot> modules, DescribeFn describe, bool includeDiagnostics);
+
+    /// @brief Encodes up to count items (PidlCodec, shell-allocated) into items. Returns the number
+    /// written; fewer than count means the end was reached or an allocation failed.
+    size_t Next(size_t count, void** items);
+
+    /// @brief Advances without describing anything. A module that unloads in the skipped range still
+    /// uses up a position. Returns the number of positions skipped.
+    size_t Skip(size_t count);
+
+    void Reset() { index_ = 0; }
+
+    size_t ItemCount() const { return modules_->size() + (includeDiagnostics_ ? 1 : 0); }
+
+private:
+    std::shared_ptr<const Snapshot> modules_; // Shared with copies
+    DescribeFn describe_;
+    bool includeDiagnostics_;
+    size_t index_ = 0;
+    ModuleRecord scratch_ = {}; // Reused so describing a module does not allocate
+};
@@ -1,11 +1,18 @@
 #include "ModuleFolder.h"
 
+#include "Diagnostics.h"
 #include "EnumIDList.h"
 #include "IidNames.h"
 #include "ItemContextMenu.h"
+#include "ItemIcon.h"
 #include "Log.h"
+#include "Perf.h"
 #include "Pidl.h"
+#include "Platform.h"
+#include "QiProfiler.h"
 #include "ModuleHelpers.h"
+#include "ModuleTreeFolder.h"
+#include "Settings.h"
 
 #include <propkey.h>
 #include <psapi.h>
@@ -14,6 +21,7 @@
 #include <strsafe.h>
 #include <vector>
 #include <array>
+#include <chrono>
 #include <functional>
 
 using Microsoft::WRL::ComPtr;
@@ -27,7 +35,42 @@ constexpr UINT kColumnCompany = 4;
 constexpr UINT kColumnVersion = 5;
 constexpr UINT kColumnMachine = 6;
 constexpr UINT kColumnDescription = 7;
-constexpr UINT kColumnCount = 8;
+constexpr UINT kColumnHooks = 8;
+constexpr UINT kColumnIntegrity = 9;
+constexpr UINT kColumnSha256 = 10;
+constexpr UINT kColumnSha1 = 11;
+constexpr UINT kColumnChecksum = 12;
+constexpr UINT kColumnDuplicates = 13;
+constexpr UINT kColumnOnDisk = 14;
+constexpr UINT kColumnRelocation = 15;
+constexpr UINT kColumnLoadTime = 16;
+constexpr UINT kColumnLoadedBy = 17;
+constexpr UINT kColumnResident = 18;
+constexpr UINT kColumnSharing = 19;
+constexpr UINT kColumnCommitted = 20;
+constexpr UINT kColumnPrivate = 21;
+constexpr UINT kColumnCount = 22;
+
+// A hook scan covers every module at once, so it runs in the background; rows filled within this window
+// share one.
+constexpr std::chrono::milliseconds kHookScanMaxAge{ 5000 };
+// An integrity check reads every module file, so it runs in the background and is repeated less often.
+constexpr std::chrono::milliseconds kIntegrityMaxAge{ 60000 };
+// The hashing pass also verifies the PE checksum. Rehashing skips unchanged files, so a pass is mostly
+// opens and can be repeated sooner.
+constexpr std::chrono::milliseconds kHashMaxAge{ 30000 };
+// The address-space walk queries every region of the process, so it runs in the background too.
+constexpr std::chrono::milliseconds kAddressSpaceMaxAge{ 5000 };
+// Duplicate detection reads only headers once the hash cache is warm, so it keeps up with refreshes.
+constexpr std::chrono::milliseconds kDuplicatesMaxAge{ 2000 };
+
+// Metadata entries kept per folder; override with the MetadataCacheEntries setting.
+constexpr uint32_t kDefaultMetadataCacheEntries = 2048;
+
+constexpr wchar_t kDiagnosticsDisplayName[] = L"Diagnostics";
+
+// Interfaces listed in the QueryInterface profile written to the trace log when a folder is released.
+constexpr size_t kQiReportEntries = 20;
 
 HRESULT MakeStrRet(const wchar_t* value, STRRET* result) {
     if (!result) {
@@ -43,6 +86,20 @@ HRESULT MakeStrRet(const wchar_t* value, STRRET* result) {
     return S_OK;
 }
 
+// Hash and checksum columns: blank until the first background hashing pass completes; the view is
+// refreshed then.
+HRESULT MakeHashStrRet(PCUIDLIST_RELATIVE pidl, FileHash::Algorithm algorithm, STRRET* ret) {
+    const auto hashes = ModuleHelpers::GetModuleHashes(kHashMaxAge);
+    if (!hashes) {
+        return MakeStrRet(L"", ret);
+    }
+    const auto file = hashes->files.find(Pidl::GetPath(pidl));
+    if (file == hashes->files.end()) {
+        return MakeStrRet(L"", ret);
+    }
+    return MakeStrRet(FileHash::Format(file->second, algorithm).c_str(), ret);
+}
+
 struct ColumnDef {
     UINT id;
     const wchar_t* title;
@@ -88,6 +145,113 @@ const std::array<ColumnDef, kColumnCount> kColumns = {{
     { kColumnDescription, L"Description", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder& folder) {
         auto info = folder.GetImageInfo(Pidl::GetPath(pidl));
         return MakeStrRet(info.description.c_str(), ret);
+    }},
+    { kColumnHooks, L"Hooked entries", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        // Blank until the first background scan completes, when the view is refreshed, and for modules
+        // loaded after the scan or that could not be read.
+        const auto scan = ModuleHelpers::GetHookScan(kHookScanMaxAge);
+        const uint64_t base = reinterpret_cast<uint64_t>(Pidl::GetBaseAddress(pidl));
+        const uint32_t module = scan ? scan->index.FindBase(base) : HookScan::kNoModule;
+        if (module == HookScan::kNoModule || !scan->report.modules[module].scanned) {
+            return MakeStrRet(L"", ret);
+        }
+        wchar_t text[16] = {};
+        StringCchPrintfW(text, ARRAYSIZE(text), L"%u", scan->report.modules[module].hooked);
+        return MakeStrRet(text, ret);
+    }},
+    { kColumnIntegrity, L"Integrity", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        // Blank until the first background check completes; the view is refreshed then.
+        const auto check = ModuleHelpers::GetIntegrityCheck(kIntegrityMaxAge);
+        const uint32_t module = check ? check->index.FindBase(reinterpret_cast<uint64_t>(Pidl::GetBaseAddress(pidl)))
+            : HookScan::kNoModule;
+        if (module == HookScan::kNoModule) {
+            return MakeStrRet(L"", ret);
+        }
+        return MakeStrRet(CodeIntegrity::Summary(check->results[module]).c_str(), ret);
+    }},
+    { kColumnSha256, L"SHA-256", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        return MakeHashStrRet(pidl, FileHash::kSha256, ret);
+    }},
+    { kColumnSha1, L"SHA-1", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        return MakeHashStrRet(pidl, FileHash::kSha1, ret);
+    }},
+    { kColumnChecksum, L"Checksum", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        return MakeHashStrRet(pidl, FileHash::kPeChecksum, ret);
+    }},
+    { kColumnDuplicates, L"Duplicates", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        // Blank until the first background scan completes, and for modules loaded after it.
+        const auto duplicates = ModuleHelpers::GetDuplicates(kDuplicatesMaxAge);
+        if (!duplicates) {
+            return MakeStrRet(L"", ret);
+        }
+        const auto module = duplicates->byBase.find(reinterpret_cast<uint64_t>(Pidl::GetBaseAddress(pidl)));
+        if (module == duplicates->byBase.end()) {
+            return MakeStrRet(L"", ret);
+        }
+        return MakeStrRet(DuplicateScan::Summary(duplicates->report.modules[module->second]).c_str(), ret);
+    }},
+    { kColumnOnDisk, L"File on disk", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        // Blank while the file still matches the loaded image (or nothing has been reported changed).
+        switch (ModuleHelpers::GetDiskState(Pidl::GetPath(pidl))) {
+        case ModuleHelpers::DiskState::Replaced:
+            return MakeStrRet(L"Replaced", ret);
+        case ModuleHelpers::DiskState::Deleted:
+            return MakeStrRet(L"Deleted", ret);
+        default:
+            return MakeStrRet(L"", ret);
+        }
+    }},
+    { kColumnRelocation, L"Relocation", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder& folder) {
+        // Blank for a module at the base its file was linked for.
+        auto info = folder.GetImageInfo(Pidl::GetPath(pidl));
+        const auto actualBase = reinterpret_cast<uint64_t>(Pidl::GetBaseAddress(pidl));
+        return MakeStrRet(PeReloc::Describe(info.relocations, info.imageBase, actualBase, info.dllCharacteristics).c_str(), ret);
+    }},
+    { kColumnLoadTime, L"Load time", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        // Blank for modules loaded before the extension was, and for roots that loaded nothing else.
+        LoadTimeline::Record record;
+        if (!ModuleHelpers::GetLoadTimeline().Find(Pidl::GetBaseAddress(pidl), record) || record.duration.count() <= 0) {
+            return MakeStrRet(L"", ret);
+        }
+        const double ms = std::chrono::duration<double, std::milli>(record.duration).count();
+        wchar_t text[32] = {};
+        StringCchPrintfW(text, ARRAYSIZE(text), L"%.2f ms", ms);
+        return MakeStrRet(text, ret);
+    }},
+    { kColumnLoadedBy, L"Loaded by", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        LoadTimeline::Record record;
+        if (!ModuleHelpers::GetLoadTimeline().Find(Pidl::GetBaseAddress(pidl), record)) {
+            return MakeStrRet(L"", ret);
+        }
+        return MakeStrRet(PathFindFileNameW(record.loadedBy.c_str()), ret);
+    }},
+    { kColumnResident, L"Resident", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        // Blank until the first working-set query, which reading the column asks for, and for modules loaded
+        // since; those rows are refreshed then.
+        WorkingSet::Counts counts;
+        if (!ModuleHelpers::GetWorkingSet(Pidl::GetBaseAddress(pidl), counts)) {
+            return MakeStrRet(L"", ret);
+        }
+        return MakeStrRet(WorkingSet::FormatResident(counts, Platform::PageSize()).c_str(), ret);
+    }},
+    { kColumnSharing, L"Shared / Private", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        WorkingSet::Counts counts;
+        if (!ModuleHelpers::GetWorkingSet(Pidl::GetBaseAddress(pidl), counts)) {
+            return MakeStrRet(L"", ret);
+        }
+        return MakeStrRet(WorkingSet::FormatSharing(counts, Platform::PageSize()).c_str(), ret);
+    }},
+    { kColumnCommitted, L"Committed", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        // Blank until the first background walk completes, when the view is refreshed, and for modules
+        // loaded since.
+        const auto map = ModuleHelpers::GetAddressSpace(kAddressSpaceMaxAge);
+        const auto* module = map ? map->Find(reinterpret_cast<uint64_t>(Pidl::GetBaseAddress(pidl))) : nullptr;
+        return MakeStrRet(module ? AddressSpace::FormatCommitted(module->usage).c_str() : L"", ret);
+    }},
+    { kColumnPrivate, L"Private / Copy-on-write", [](PCUIDLIST_RELATIVE pidl, STRRET* ret, ModuleFolder&) {
+        const auto map = ModuleHelpers::GetAddressSpace(kAddressSpaceMaxAge);
+        const auto* module = map ? map->Find(reinterpret_cast<uint64_t>(Pidl::GetBaseAddress(pidl))) : nullptr;
+        return MakeStrRet(module ? AddressSpace::FormatPrivate(module->usage).c_str() : L"", ret);
     }}
 }};
 
@@ -107,7 +271,7 @@ std::vector<std::wstring> ExtractDropPaths(IDataObject* dataObject) {
     if (SUCCEEDED(dataObject->GetData(&hdropFormat, &medium))) {
         HDROP drop = static_cast<HDROP>(medium.hGlobal);
         UINT count = DragQueryFileW(drop, 0xFFFFFFFF, nullptr, 0);
-        Log::Write(Log::Level::Info, L"CF_HDROP items: %u", count);
+        LOG_INFO(L"CF_HDROP items: {}", count);
         for (UINT i = 0; i < count; ++i) {
             wchar_t path[MAX_PATH] = {};
             if (DragQueryFileW(drop, i, path, ARRAYSIZE(path))) {
@@ -122,7 +286,7 @@ std::vector<std::wstring> ExtractDropPaths(IDataObject* dataObject) {
     if (SUCCEEDED(dataObject->GetData(&shellFormat, &medium))) {
         auto cida = static_cast<CIDA*>(GlobalLock(medium.hGlobal));
         if (cida) {
-            Log::Write(Log::Level::Info, L"CFSTR_SHELLIDLIST items: %u", cida->cidl);
+            LOG_INFO(L"CFSTR_SHELLIDLIST items: {}", cida->cidl);
             auto base = reinterpret_cast<const BYTE*>(cida);
             auto parent = reinterpret_cast<PCIDLIST_ABSOLUTE>(base + cida->aoffset[0]);
             for (UINT i = 0; i < cida->cidl; ++i) {
@@ -144,6 +308,10 @@ std::vector<std::wstring> ExtractDropPaths(IDataObject* dataObject) {
     return paths;
 }
 
+bool DescribeLoadedModule(ModuleEnumerator::Handle handle, ModuleRecord& record) {
+    return ModuleHelpers::DescribeModule(reinterpret_cast<HMODULE>(handle), record);
+}
+
 bool SupportsDropFormat(IDataObject* dataObject) {
     if (!dataObject) {
         return false;
@@ -157,9 +325,63 @@ bool SupportsDropFormat(IDataObject* dataObject) {
 }
 } // namespace
 
-ModuleFolder::ModuleFolder() {
+ModuleFolder::ModuleFolder()
+    : session_(ModuleHelpers::AcquireSession()),
+      imageInfoCache_(Settings::ReadDword(L"MetadataCacheEntries", kDefaultMetadataCacheEntries)),
+      fileWatcher_(ModuleHelpers::AcquireFileWatcher()) {
     rootPidl_ = nullptr;
-    // Log::Write(Log::Level::Info, L"ModuleFolder constructed");
+    Diagnostics::Publish();
+    // LOG_INFO(L"ModuleFolder constructed");
+}
+
+ModuleFolder::~ModuleFolder() {
+    if (rootPidl_) {
+        ILFree(rootPidl_);
+    }
+    ModuleHelpers::AddMetadataEntries(-static_cast<int64_t>(imageInfoCache_.Size()));
+    // A view closing is a natural point to publish what this session cost.
+    if (Log::IsEnabled(Log::Level::Info)) {
+        auto summary = Perf::FormatSummary();
+        if (!summary.empty()) {
+            LOG_INFO(L"Latency summary:\n{}", summary);
+        }
+    }
+    Perf::FlushTrace();
+    if (Log::IsEnabled(Log::Level::Trace)) {
+        auto interfaces = QiProfiler::FormatReport(kQiReportEntries);
+        if (!interfaces.empty()) {
+            LOG_TRACE(L"QueryInterface profile:\n{}", interfaces);
+        }
+    }
+}
+
+IFACEMETHODIMP ModuleFolder::QueryInterface(REFIID riid, void** ppv) {
+    HRESULT hr = RuntimeClass::QueryInterface(riid, ppv);
+    QiProfiler::Record(QiProfiler::Source::ModuleFolder, IidNames::ToGuid(riid), SUCCEEDED(hr));
+    return hr;
+}
+
+ModuleHelpers::ImageInfo ModuleFolder::GetImageInfo(const std::wstring& path) {
+    // Taken before parsing, so a change reported while the file is read still invalidates the entry.
+    const uint64_t generation = fileWatcher_ ? fileWatcher_->Generation() : 0;
+    if (auto cached = imageInfoCache_.Find(path)) {
+        // Only when anything at all has changed since the entry was filled is the path itself looked up.
+        if (cached->generation == generation || fileWatcher_->Generation(path) <= cached->generation) {
+            Diagnostics::Increment(Diagnostics::Counter::MetadataCacheHits);
+            return cached->info;
+        }
+        Diagnostics::Increment(Diagnostics::Counter::MetadataInvalidations);
+    } else {
+        Diagnostics::Increment(Diagnostics::Counter::MetadataCacheMisses);
+    }
+    auto info = ModuleHelpers::GetImageInfo(path);
+    const size_t before = imageInfoCache_.Size();
+    size_t evicted = imageInfoCache_.Insert(path, { info, generation });
+    ModuleHelpers::AddMetadataEntries(static_cast<int64_t>(imageInfoCache_.Size()) - static_cast<int64_t>(before));
+    if (evicted) {
+        Diagnostics::Increment(Diagnostics::Counter::MetadataCacheEvictions, evicted);
+    }
+    return info;
 }
 
 IFACEMETHODIMP ModuleFolder::GetClassID(CLSID* classId) {
@@ -172,19 +394,19 @@ IFACEMETHODIMP ModuleFolder::GetClassID(CLSID* classId) {
 
 IFACEMETHODIMP ModuleFolder::Initialize(PCIDLIST_ABSOLUTE pidl) {
 
-    Log::Write(Log::Level::Trace, L"ModuleFolder::Initialize called (pidl=%p)", pidl);
+    LOG_TRACE(L"ModuleFolder::Initialize called (pidl={})", static_cast<const void*>(pidl));
 
     if (rootPidl_) {
         ILFree(rootPidl_);
     }
     if (!pidl) {
-        Log::Write(Log::Level::Warn, L"ModuleFolder::Initialize received null pidl");
+        LOG_WARN(L"ModuleFolder::Initialize received null pidl");
         rootPidl_ = nullptr;
         return S_OK;
     }
     rootPidl_ = ILCloneFull(pidl);
     if (!rootPidl_) {
-        Log::Write(Log::Level::Error, L"ModuleFolder::Initialize ILCloneFull failed");
+        LOG_ERROR(L"ModuleFolder::Initialize ILCloneFull failed");
         return E_OUTOFMEMORY;
     }
     return S_OK;
@@ -196,12 +418,12 @@ IFACEMETHODIMP ModuleFolder::GetCurFolder(PIDLIST_ABSOLUTE* pidl) {
     }
     *pidl = nullptr;
     if (!rootPidl_) {
-        Log::Write(Log::Level::Warn, L"GetCurFolder called without root PIDL");
+        LOG_WARN(L"GetCurFolder called without root PIDL");
         return S_FALSE;
     }
     *pidl = ILCloneFull(rootPidl_);
     if (!*pidl) {
-        Log::Write(Log::Level::Error, L"GetCurFolder: out of memory");
+        LOG_ERROR(L"GetCurFolder: out of memory");
         return E_OUTOFMEMORY;
     }
     return S_OK;
@@ -212,48 +434,83 @@ IFACEMETHODIMP ModuleFolder::ParseDisplayName(HWND, IBindCtx*, LPWSTR, ULONG*, P
 }
 
 IFACEMETHODIMP ModuleFolder::EnumObjects(HWND, SHCONTF flags, IEnumIDList** enumIdList) {
-    Log::Write(Log::Level::Info, L"EnumObjects called (flags=0x%X)", flags);
+    Perf::ScopedTimer timer(Perf::Op::EnumObjects);
+    LOG_INFO(L"EnumObjects called (flags=0x{:X})", flags);
     if (!enumIdList) {
         return E_POINTER;
     }
     *enumIdList = nullptr;
-    if (!(flags & SHCONTF_NONFOLDERS)) {
-        Log::Write(Log::Level::Info, L"EnumObjects skipped (NONFOLDERS not requested)");
+    // Modules are folders (of their image trees); the Diagnostics item is the one non-folder.
+    const bool includeModules = (flags & SHCONTF_FOLDERS) != 0;
+    const bool includeDiagnostics = (flags & SHCONTF_NONFOLDERS) != 0;
+    if (!includeModules && !includeDiagnostics) {
+        LOG_INFO(L"EnumObjects skipped (neither FOLDERS nor NONFOLDERS requested)");
         return S_FALSE;
     }
 
-    std::vector<PIDLIST_RELATIVE> items;
-    auto moduleItems = ModuleHelpers::GetLoadedModules();
-    items.reserve(moduleItems.size());
-    for (const auto& item : moduleItems) {
-        auto pidl = Pidl::CreateFromPath(item.path, item.baseAddress, item.size);
-        if (pidl) {
-            items.push_back(pidl);
+    // Only the handles are captured here; EnumIDList describes and encodes each module as Explorer pages
+    // through it.
+    auto handles = includeModules ? ModuleHelpers::GetLoadedModuleHandles() : std::vector<HMODULE>{};
+    auto modules = std::make_shared<ModuleEnumerator::Snapshot>();
+    modules->reserve(handles.size());
+    if (includeModules && ModuleHelpers::DuplicatesOnly()) {
+        // Filtered by the background scan, which can hash files and so never runs here. Until its first
+        // result the view lists no modules; the folder is refreshed when one arrives and whenever the
+        // flagged set changes.
+        const auto duplicates = ModuleHelpers::GetDuplicates(kDuplicatesMaxAge);
+        for (HMODULE module : handles) {
+            if (!duplicates) {
+                break;
+            }
+            const auto found = duplicates->byBase.find(reinterpret_cast<uint64_t>(module));
+            if (found != duplicates->byBase.end() && duplicates->report.modules[found->second].flags != 0) {
+                modules->push_back(reinterpret_cast<ModuleEnumerator::Handle>(module));
+            }
+        }
+    } else {
+        for (HMODULE module : handles) {
+            modules->push_back(reinterpret_cast<ModuleEnumerator::Handle>(module));
         }
     }
-
-    auto enumerator = Microsoft::WRL::Make<EnumIDList>(items);
-    for (auto item : items) {
-        Pidl::Free(item);
-    }
-
+    ModuleEnumerator items(std::move(modules), DescribeLoadedModule, includeDiagnostics);
+    const size_t itemCount = items.ItemCount();
+    auto enumerator = Microsoft::WRL::Make<EnumIDList>(std::move(items));
     if (!enumerator) {
-        Log::Write(Log::Level::Error, L"EnumIDList allocation failed");
+        LOG_ERROR(L"EnumIDList allocation failed");
         return E_OUTOFMEMORY;
     }
-    if (items.empty()) {
-        Log::Write(Log::Level::Info, L"EnumObjects returning 0 items");
-        return S_FALSE;
-    }
-    Log::Write(Log::Level::Info, L"EnumObjects returning %zu items", items.size());
+    Diagnostics::Increment(Diagnostics::Counter::EnumerationsServed);
+    LOG_INFO(L"EnumObjects returning up to {} items", itemCount);
     return enumerator.CopyTo(enumIdList);
 }
 
-IFACEMETHODIMP ModuleFolder::BindToObject(PCUIDLIST_RELATIVE, IBindCtx*, REFIID, void** ppv) {
-    if (ppv) {
-        *ppv = nullptr;
+IFACEMETHODIMP ModuleFolder::BindToObject(PCUIDLIST_RELATIVE pidl, IBindCtx* bindCtx, REFIID riid, void** ppv) {
+    if (!ppv) {
+        return E_POINTER;
     }
-    return E_NOTIMPL;
+    *ppv = nullptr;
+    if (!pidl || !Pidl::IsOurPidl(pidl)) {
+        return E_INVALIDARG;
+    }
+
+    // Each module is a folder of ImageTree nodes; binding to it opens nothing until a node is enumerated.
+    PIDLIST_RELATIVE item = Pidl::Clone(pidl);
+    PIDLIST_ABSOLUTE modulePidl = item ? ILCombine(rootPidl_, item) : nullptr;
+    Pidl::Free(item);
+    if (!modulePidl) {
+        return E_OUTOFMEMORY;
+    }
+    auto folder = Microsoft::WRL::Make<ModuleTreeFolder>(Pidl::GetPath(pidl),
+        reinterpret_cast<uint64_t>(Pidl::GetBaseAddress(pidl)), modulePidl, std::nullopt);
+    ILFree(modulePidl);
+    if (!folder) {
+        return E_OUTOFMEMORY;
+    }
+    PCUIDLIST_RELATIVE rest = ILNext(pidl);
+    if (ILIsEmpty(rest)) {
+        return folder.CopyTo(riid, ppv);
+    }
+    return folder->BindToObject(rest, bindCtx, riid, ppv);
 }
 
 IFACEMETHODIMP ModuleFolder::BindToStorage(PCUIDLIST_RELATIVE, IBindCtx*, REFIID, void** ppv) {
@@ -264,9 +521,18 @@ IFACEMETHODIMP ModuleFolder::BindToStorage(PCUIDLIST_RELATIVE, IBindCtx*, REFIID
 }
 
 IFACEMETHODIMP ModuleFolder::CompareIDs(LPARAM lParam, PCUIDLIST_RELATIVE pidl1, PCUIDLIST_RELATIVE pidl2) {
+    Perf::ScopedTimer timer(Perf::Op::CompareIDs);
     if (!pidl1 || !pidl2) {
         return E_INVALIDARG;
     }
+
+    // The Diagnostics item sorts ahead of every module.
+    bool diagnostics1 = Pidl::IsDiagnosticsPidl(pidl1);
+    bool diagnostics2 = Pidl::IsDiagnosticsPidl(pidl2);
+    if (diagnostics1 || diagnostics2) {
+        short compare = (diagnostics1 == diagnostics2) ? 0 : (diagnostics1 ? -1 : 1);
+        return MAKE_HRESULT(SEVERITY_SUCCESS, 0, static_cast<USHORT>(compare));
+    }
     
     // Check if PIDLs are ours
     bool ours1 = Pidl::IsOurPidl(pidl1);
@@ -274,53 +540,37 @@ IFACEMETHODIMP ModuleFolder::CompareIDs(LPARAM lParam, PCUIDLIST_RELATIVE pidl1,
 
     // If both are ours, compare based on column
     if (ours1 && ours2) {
-        int column = static_cast<int>(lParam & 0xFFFF);
-        int result = 0;
-
-        switch (column) {
+        PidlCodec::SortKey key = PidlCodec::SortKey::Path;
+        switch (static_cast<UINT>(lParam & 0xFFFF)) {
         case kColumnName:
-             {
-                 auto path1 = Pidl::GetPath(pidl1);
-                 auto path2 = Pidl::GetPath(pidl2);
-                 const wchar_t* name1 = PathFindFileNameW(path1.c_str());
-                 const wchar_t* name2 = PathFindFileNameW(path2.c_str());
-                 result = lstrcmpiW(name1, name2);
-                 if (result == 0) {
-                     // Fallback to full path to be deterministic
-                     result = lstrcmpiW(path1.c_str(), path2.c_str());
-                 }
-             }
-             break;
+            key = PidlCodec::SortKey::Name;
+            break;
         case kColumnBase:
-             {
-                 uintptr_t base1 = reinterpret_cast<uintptr_t>(Pidl::GetBaseAddress(pidl1));
-                 uintptr_t base2 = reinterpret_cast<uintptr_t>(Pidl::GetBaseAddress(pidl2));
-                 if (base1 < base2) result = -1;
-                 else if (base1 > base2) result = 1;
-             }
-             break;
-        case kColumnSize:
-            {
-                 DWORD size1 = Pidl::GetSize(pidl1);
-                 DWORD size2 = Pidl::GetSize(pidl2);
-                 if (size1 < size2) result = -1;
-                 else if (size1 > size2) result = 1;
-            }
+            key = PidlCodec::SortKey::BaseAddress;
             break;
-        case kColumnPath:
-            {
-                 auto path1 = Pidl::GetPath(pidl1);
-                 auto path2 = Pidl::GetPath(pidl2);
-                 result = lstrcmpiW(path1.c_str(), path2.c_str());
-            }
+        case kColumnSize:
+            key = PidlCodec::SortKey::Size;
             break;
         default:
-             {
-                 auto path1 = Pidl::GetPath(pidl1);
-                 auto path2 = Pidl::GetPath(pidl2);
-                 result = lstrcmpiW(path1.c_str(), path2.c_str());
-             }
-             break;
+            break;
+        }
+        int result = PidlCodec::Compare(pidl1, pidl2, key);
+        if (result == 0 && PidlCodec::Compare(pidl1, pidl2, PidlCodec::SortKey::Path) == 0) {
+            // Same module: anything below it is ordered by the module's own folder.
+            PCUIDLIST_RELATIVE rest1 = ILNext(pidl1);
+            PCUIDLIST_RELATIVE rest2 = ILNext(pidl2);
+            if (ILIsEmpty(rest1) || ILIsEmpty(rest2)) {
+                result = static_cast<int>(!ILIsEmpty(rest1)) - static_cast<int>(!ILIsEmpty(rest2));
+            } else {
+                ComPtr<IShellFolder> module;
+                PIDLIST_RELATIVE first = Pidl::Clone(pidl1);
+                HRESULT hr = first ? BindToObject(first, nullptr, IID_PPV_ARGS(&module)) : E_OUTOFMEMORY;
+                Pidl::Free(first);
+                if (FAILED(hr)) {
+                    return hr;
+                }
+                return module->CompareIDs(lParam, rest1, rest2);
+            }
         }
 
         short compare = static_cast<short>(result);
@@ -352,25 +602,25 @@ IFACEMETHODIMP ModuleFolder::CreateViewObject(HWND, REFIID riid, void** ppv) {
     }
     *ppv = nullptr;
     if (IsEqualIID(riid, IID_IShellView)) {
-        Log::Write(Log::Level::Info, L"CreateViewObject called");
+        LOG_INFO(L"CreateViewObject called");
         SFV_CREATE sfv = {};
         sfv.cbSize = sizeof(sfv);
         ComPtr<IShellFolder> shellFolder;
         HRESULT hr = QueryInterface(IID_PPV_ARGS(&shellFolder));
         if (FAILED(hr)) {
-            Log::Write(Log::Level::Error, L"CreateViewObject QI IShellFolder failed: 0x%08X", hr);
+            LOG_ERROR(L"CreateViewObject QI IShellFolder failed: 0x{:08X}", static_cast<unsigned long>(hr));
             return hr;
         }
         sfv.pshf = shellFolder.Get();
             sfv.psfvcb = static_cast<IShellFolderViewCB*>(this);
         hr = SHCreateShellFolderView(&sfv, reinterpret_cast<IShellView**>(ppv));
         if (!SUCCEEDED(hr)) {
-            Log::Write(Log::Level::Info, L"SHCreateShellFolderView hr=0x%08X", hr);
+            LOG_INFO(L"SHCreateShellFolderView hr=0x{:08X}", static_cast<unsigned long>(hr));
         }
         return hr;
     }
     if (IsEqualIID(riid, IID_IDropTarget)) {
-        Log::Write(Log::Level::Trace, L"CreateViewObject returning IDropTarget");
+        LOG_TRACE(L"CreateViewObject returning IDropTarget");
         return QueryInterface(IID_PPV_ARGS(reinterpret_cast<IDropTarget**>(ppv)));
     }
     return E_NOINTERFACE;
@@ -380,15 +630,24 @@ IFACEMETHODIMP ModuleFolder::GetAttributesOf(UINT cidl, PCUITEMID_CHILD_ARRAY ap
     if (!rgfInOut) {
         return E_POINTER;
     }
+    // The folder takes dropped DLLs (its IDropTarget loads them).
     SFGAOF folderAttrs = SFGAO_FOLDER | SFGAO_BROWSABLE | SFGAO_DROPTARGET;
-    SFGAOF itemAttrs = SFGAO_STREAM | SFGAO_READONLY | SFGAO_DROPTARGET;
+    // Modules browse into their ImageTree nodes (see ModuleTreeFolder). They have no stream behind them
+    // and take no drops, so the shell must not offer to copy them or drop onto them.
+    SFGAOF itemAttrs = SFGAO_FOLDER | SFGAO_BROWSABLE | SFGAO_HASSUBFOLDER | SFGAO_READONLY;
+    SFGAOF diagnosticsAttrs = SFGAO_READONLY;
     SFGAOF attrs = (cidl == 0 || !apidl) ? folderAttrs : itemAttrs;
+    for (UINT i = 0; apidl && i < cidl; ++i) {
+        if (Pidl::IsDiagnosticsPidl(apidl[i])) {
+            attrs &= diagnosticsAttrs;
+        }
+    }
     if (*rgfInOut) {
         *rgfInOut &= attrs;
     } else {
         *rgfInOut = attrs;
     }
-    Log::Write(Log::Level::Trace, L"GetAttributesOf %s attrs=0x%08X", (cidl == 0 || !apidl) ? L"folder" : L"item", *rgfInOut);
+    LOG_TRACE(L"GetAttributesOf {} attrs=0x{:08X}", (cidl == 0 || !apidl) ? L"folder" : L"item", *rgfInOut);
     return S_OK;
 }
 
@@ -398,16 +657,30 @@ IFACEMETHODIMP ModuleFolder::GetUIObjectOf(HWND, UINT cidl, PCUITEMID_CHILD_ARRA
         return E_POINTER;
     }
     *ppv = nullptr;
-    Log::Write(Log::Level::Trace, L"GetUIObjectOf cidl=%u riid=%s", cidl, IidNames::ToString(riid).c_str());
+    LOG_TRACE(L"GetUIObjectOf cidl={} riid={}", cidl, IidNames::ToString(riid));
     if (cidl == 0 && IsEqualIID(riid, IID_IDropTarget)) {
         return QueryInterface(IID_PPV_ARGS(reinterpret_cast<IDropTarget**>(ppv)));
     }
+    if (cidl == 1 && IsEqualIID(riid, IID_IExtractIconW) && Pidl::IsOurPidl(apidl[0])) {
+        auto icon = Microsoft::WRL::Make<ItemIcon>(Pidl::GetPath(apidl[0]), Pidl::GetBaseAddress(apidl[0]));
+        if (!icon) {
+            return E_OUTOFMEMORY;
+        }
+        return icon.CopyTo(riid, ppv);
+    }
     if (cidl > 0 && (IsEqualIID(riid, IID_IContextMenu) || IsEqualIID(riid, IID_IContextMenu2) || IsEqualIID(riid, IID_IContextMenu3))) {
+        if (cidl == 1 && Pidl::IsDiagnosticsPidl(apidl[0])) {
+            auto menu = Microsoft::WRL::Make<ItemContextMenu>(std::vector<ContextMenuItemData>(), rootPidl_, true);
+            if (!menu) {
+                return E_OUTOFMEMORY;
+            }
+            return menu.CopyTo(riid, ppv);
+        }
         std::vector<ContextMenuItemData> items;
         items.reserve(cidl);
         for (UINT i = 0; i < cidl; ++i) {
             if (!Pidl::IsOurPidl(apidl[i])) {
-                Log::Write(Log::Level::Warn, L"GetUIObjectOf: PIDL %u is not ours", i);
+                LOG_WARN(L"GetUIObjectOf: PIDL {} is not ours", i);
                 continue;
             }
             auto path = Pidl::GetPath(apidl[i]);
@@ -415,11 +688,11 @@ IFACEMETHODIMP ModuleFolder::GetUIObjectOf(HWND, UINT cidl, PCUITEMID_CHILD_ARRA
             if (!path.empty()) {
                 items.push_back({ std::move(path), baseAddress });
             } else {
-                Log::Write(Log::Level::Warn, L"GetUIObjectOf: PIDL %u has empty path", i);
+                LOG_WARN(L"GetUIObjectOf: PIDL {} has empty path", i);
             }
         }
         if (items.empty()) {
-            Log::Write(Log::Level::Error, L"GetUIObjectOf: No valid items found");
+            LOG_ERROR(L"GetUIObjectOf: No valid items found");
             return E_FAIL;
         }
         auto menu = Microsoft::WRL::Make<ItemContextMenu>(std::move(items), rootPidl_);
@@ -427,7 +700,7 @@ IFACEMETHODIMP ModuleFolder::GetUIObjectOf(HWND, UINT cidl, PCUITEMID_CHILD_ARRA
             return E_OUTOFMEMORY;
         }
         HRESULT hr = menu.CopyTo(riid, ppv);
-        Log::Write(Log::Level::Info, L"GetUIObjectOf: Context menu created, hr=0x%08X", hr);
+        LOG_INFO(L"GetUIObjectOf: Context menu created, hr=0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
     return E_NOINTERFACE;
@@ -437,6 +710,9 @@ IFACEMETHODIMP ModuleFolder::GetDisplayNameOf(PCUITEMID_CHILD pidl, SHGDNF, STRR
     if (!pidl || !name) {
         return E_INVALIDARG;
     }
+    if (Pidl::IsDiagnosticsPidl(pidl)) {
+        return MakeStrRet(kDiagnosticsDisplayName, name);
+    }
     if (!Pidl::IsOurPidl(pidl)) {
         return E_INVALIDARG;
     }
@@ -477,7 +753,27 @@ IFACEMETHODIMP ModuleFolder::GetDefaultColumnState(UINT column, SHCOLSTATEF* sta
     if (column >= kColumnCount) {
         return E_INVALIDARG;
     }
-    *state = SHCOLSTATE_TYPE_STR | SHCOLSTATE_ONBYDEFAULT;
+    // Columns that scan every module, or read every module file, are off until the user adds them, so
+    // opening the folder costs only what the visible columns need.
+    bool optional = false;
+    switch (column) {
+    case kColumnHooks:      // Import and export tables of every module
+    case kColumnIntegrity:  // Code sections of every module file
+    case kColumnSha256:     // Every byte of every module file
+    case kColumnSha1:       // Only filled when the HashSha1 setting asks for it
+    case kColumnChecksum:   // Verified by the same pass over every module file
+    case kColumnDuplicates: // Fingerprints every module, hashing files whose fingerprints collide
+    case kColumnOnDisk:     // Blank for almost every module
+    case kColumnResident:   // Starts the working-set timer querying once shown
+    case kColumnSharing:
+    case kColumnCommitted:  // Walks the whole address space
+    case kColumnPrivate:
+        optional = true;
+        break;
+    default:
+        break;
+    }
+    *state = optional ? SHCOLSTATE_TYPE_STR : SHCOLSTATE_TYPE_STR | SHCOLSTATE_ONBYDEFAULT;
     return S_OK;
 }
 
@@ -486,6 +782,7 @@ IFACEMETHODIMP ModuleFolder::GetDetailsEx(PCUITEMID_CHILD, const SHCOLUMNID*, VA
 }
 
 IFACEMETHODIMP ModuleFolder::GetDetailsOf(PCUITEMID_CHILD pidl, UINT column, SHELLDETAILS* details) {
+    Perf::ScopedTimer timer(Perf::Op::GetDetailsOf);
     if (!details) {
         return E_POINTER;
     }
@@ -501,9 +798,20 @@ IFACEMETHODIMP ModuleFolder::GetDetailsOf(PCUITEMID_CHILD pidl, UINT column, SHE
         return MakeStrRet(kColumns[column].title, &details->str);
     }
 
+    // The Diagnostics item only fills the name and a one-line counter summary.
+    if (Pidl::IsDiagnosticsPidl(pidl)) {
+        if (column == kColumnName) {
+            return MakeStrRet(kDiagnosticsDisplayName, &details->str);
+        }
+        if (column == kColumnDescription) {
+            return MakeStrRet(Diagnostics::FormatCompact().c_str(), &details->str);
+        }
+        return MakeStrRet(L"", &details->str);
+    }
+
     // Item request
     if (!Pidl::IsOurPidl(pidl)) {
-        Log::Write(Log::Level::Warn, L"GetDetailsOf: Invalid PIDL for column %u", column);
+        LOG_WARN(L"GetDetailsOf: Invalid PIDL for column {}", column);
         return E_INVALIDARG;
     }
 
@@ -569,7 +877,7 @@ IFACEMETHODIMP ModuleFolder::DragEnter(IDataObject* dataObject, DWORD keyState,
     } else {
         *effect = DROPEFFECT_NONE;
     }
-    Log::Write(Log::Level::Trace, L"DragEnter: %s (In: 0x%X, Out: 0x%X, Key: 0x%X)", canDrop_ ? L"accepted" : L"rejected", inputEffect, *effect, keyState);    
+    LOG_TRACE(L"DragEnter: {} (In: 0x{:X}, Out: 0x{:X}, Key: 0x{:X})", canDrop_ ? L"accepted" : L"rejected", inputEffect, *effect, keyState);    
     return S_OK;
 }
 
@@ -597,7 +905,7 @@ IFACEMETHODIMP ModuleFolder::DragOver(DWORD keyState, POINTL, DWORD* effect) {
     static DWORD lastInput = 0xFFFFFFFF;
     static DWORD lastOutput = 0xFFFFFFFF;
     if (input != lastInput || *effect != lastOutput) {
-         Log::Write(Log::Level::Trace, L"DragOver: In: 0x%X, Out: 0x%X", input, *effect);
+         LOG_TRACE(L"DragOver: In: 0x{:X}, Out: 0x{:X}", input, *effect);
          lastInput = input;
          lastOutput = *effect;
     }
@@ -606,7 +914,7 @@ IFACEMETHODIMP ModuleFolder::DragOver(DWORD keyState, POINTL, DWORD* effect) {
 
 IFACEMETHODIMP ModuleFolder::DragLeave() {
     canDrop_ = false;
-    Log::Write(Log::Level::Trace, L"DragLeave");
+    LOG_TRACE(L"DragLeave");
     return S_OK;
 }
 
@@ -623,7 +931,7 @@ IFACEMETHODIMP ModuleFolder::Drop(IDataObject* dataObject, DWORD, POINTL, DWORD*
     canDrop_ = false;
 
     auto paths = ExtractDropPaths(dataObject);
-    Log::Write(Log::Level::Info, L"Drop received %zu paths", paths.size());
+    LOG_INFO(L"Drop received {} paths", paths.size());
     if (!paths.empty()) {
         int loaded = ModuleHelpers::LoadModulesIf(paths);
         if (loaded > 0 && rootPidl_) {
@@ -638,7 +946,7 @@ IFACEMETHODIMP ModuleFolder::MessageSFVCB(UINT msg, WPARAM wParam, LPARAM lParam
     UNREFERENCED_PARAMETER(lParam);
     
     if (msg == SFVM_GETNOTIFY) {
-        Log::Write(Log::Level::Trace, L"MessageSFVCB msg=SFVM_GETNOTIFY");
+        LOG_TRACE(L"MessageSFVCB msg=SFVM_GETNOTIFY");
     }
     
     // Return E_NOTIMPL to let the default view handler process messages
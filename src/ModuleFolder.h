@@ -3,8 +3,8 @@
 #include <windows.h>
 #include <shlobj.h>
 #include <wrl.h>
-#include <map>
 #include <string>
+#include "LruCache.h"
 #include "ModuleHelpers.h"
 
 // {6B4E2E3B-3D6B-4D4E-9A1C-0F0C8D8E8F11}
@@ -29,6 +29,11 @@ class ModuleFolder final
         IDropTarget> {
 public:
     ModuleFolder();
+    ~ModuleFolder();
+
+    // IUnknown
+    /// @brief Forwards to the WRL implementation and records the request in QiProfiler.
+    IFACEMETHODIMP QueryInterface(REFIID riid, void** ppv) override;
 
     // IPersist
     IFACEMETHODIMP GetClassID(CLSID* classId) override;
@@ -93,16 +98,20 @@ public:
     // IShellFolderViewCB
     IFACEMETHODIMP MessageSFVCB(UINT msg, WPARAM wParam, LPARAM lParam) override;
 
-    const ModuleHelpers::ImageInfo& GetImageInfo(const std::wstring& path) {
-        auto it = imageInfoCache_.find(path);
-        if (it == imageInfoCache_.end()) {
-            it = imageInfoCache_.emplace(path, ModuleHelpers::GetImageInfo(path)).first;
-        }
-        return it->second;
-    }
+    /// @brief Returns version/header metadata for an image, parsing it on first use and again once the
+    /// file watcher reports the file changed.
+    ModuleHelpers::ImageInfo GetImageInfo(const std::wstring& path);
 
 private:
     PIDLIST_ABSOLUTE rootPidl_ = nullptr;
     bool canDrop_ = false;
-    std::map<std::wstring, ModuleHelpers::ImageInfo> imageInfoCache_;
+    struct CachedImageInfo {
+        ModuleHelpers::ImageInfo info;
+        uint64_t generation; // fileWatcher_->Generation() when parsing started
+    };
+
+    std::shared_ptr<void> session_; // ModuleHelpers::AcquireSession; first, so it is released last
+    LruCache<std::wstring, CachedImageInfo> imageInfoCache_;
+    std::shared_ptr<FileWatcher> fileWatcher_; // Null when watching is off; entries then never go stale
+
 };
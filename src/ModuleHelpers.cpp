@@ -1,128 +1,476 @@
 #include "ModuleHelpers.h"
+#include "Diagnostics.h"
+#include "DllNotification.h"
+#include "DuplicateScan.h"
+#include "LruCache.h"
 #include "Log.h"
+#include "MemoryBudget.h"
+#include "ModuleFolder.h"
+#include "Perf.h"
+#include "Pidl.h"
+#include "Platform.h"
+#include "Settings.h"
+#include "SnapshotExport.h"
 #include <windows.h>
 #include <psapi.h>
+#include <shlobj.h>
 #include <strsafe.h>
+#include <wrl/module.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <utility>
 
 namespace ModuleHelpers {
+namespace {
+bool DescribeHandle(ModuleEnumerator::Handle handle, ModuleRecord& record) {
+    return DescribeModule(reinterpret_cast<HMODULE>(handle), record);
+}
 
-ImageInfo GetImageInfo(const std::wstring& path) {
-    ImageInfo info;
-    info.machineType = L"Unknown";
-
-    // Version Info
-    DWORD handle = 0;
-    DWORD size = GetFileVersionInfoSizeW(path.c_str(), &handle);
-    if (size > 0) {
-        std::vector<BYTE> buffer(size);
-        if (GetFileVersionInfoW(path.c_str(), handle, size, buffer.data())) {
-            struct LANGANDCODEPAGE {
-                WORD wLanguage;
-                WORD wCodePage;
-            } *lpTranslate;
-            UINT cbTranslate = 0;
-
-            if (VerQueryValueW(buffer.data(), L"\\VarFileInfo\\Translation", (LPVOID*)&lpTranslate, &cbTranslate)) {
-                 for(unsigned int i=0; i < (cbTranslate/sizeof(struct LANGANDCODEPAGE)); i++ ) {
-                     wchar_t subBlock[256];
-                     // CompanyName
-                     StringCchPrintfW(subBlock, ARRAYSIZE(subBlock),
-                        L"\\StringFileInfo\\%04x%04x\\CompanyName",
-                        lpTranslate[i].wLanguage,
-                        lpTranslate[i].wCodePage);
-                     void* bufferValue = nullptr;
-                     UINT len = 0;
-                     if (VerQueryValueW(buffer.data(), subBlock, &bufferValue, &len)) {
-                         info.companyName = static_cast<wchar_t*>(bufferValue);
-                     }
-                     
-                     // FileVersion
-                     StringCchPrintfW(subBlock, ARRAYSIZE(subBlock),
-                        L"\\StringFileInfo\\%04x%04x\\FileVersion",
-                        lpTranslate[i].wLanguage,
-                        lpTranslate[i].wCodePage);
-                     if (VerQueryValueW(buffer.data(), subBlock, &bufferValue, &len)) {
-                         info.fileVersion = static_cast<wchar_t*>(bufferValue);
-                     }
-
-                     // FileDescription
-                     StringCchPrintfW(subBlock, ARRAYSIZE(subBlock),
-                        L"\\StringFileInfo\\%04x%04x\\FileDescription",
-                        lpTranslate[i].wLanguage,
-                        lpTranslate[i].wCodePage);
-                     if (VerQueryValueW(buffer.data(), subBlock, &bufferValue, &len)) {
-                         info.description = static_cast<wchar_t*>(bufferValue);
-                     }
-                     
-                     if (!info.companyName.empty() || !info.fileVersion.empty() || !info.description.empty()) break; 
-                 }
+// True if every page of [start, start + size) is committed and readable without faulting. Images can
+// carry PAGE_NOACCESS or guard pages (and hooking code sometimes adds them), so the scanner must not
+// assume SizeOfImage bytes are all there.
+bool IsReadable(const BYTE* start, size_t size) {
+    const BYTE* end = start + size;
+    for (const BYTE* address = start; address < end;) {
+        MEMORY_BASIC_INFORMATION region = {};
+        if (VirtualQuery(address, &region, sizeof(region)) == 0 || region.State != MEM_COMMIT ||
+            (region.Protect & (PAGE_NOACCESS | PAGE_GUARD)) != 0) {
+            return false;
+        }
+        address = static_cast<const BYTE*>(region.BaseAddress) + region.RegionSize;
+    }
+    return true;
+}
+
+// Import descriptors name API sets (api-ms-win-*) that map to no file in the module list; the loader
+// has already resolved them, so ask it.
+uint64_t ResolveLoadedModule(std::string_view dllName) {
+    char name[MAX_PATH] = {};
+    if (dllName.size() >= ARRAYSIZE(name)) {
+        return 0;
+    }
+    std::copy(dllName.begin(), dllName.end(), name);
+    return reinterpret_cast<uint64_t>(GetModuleHandleA(name));
+}
+
+// Every loaded module, pinned so that none can unload while its image is read. A module whose image is
+// not fully readable is listed with a null image.
+class PinnedModules {
+public:
+    explicit PinnedModules(const wchar_t* purpose) {
+        const auto handles = GetLoadedModuleHandles();
+        pinned_.reserve(handles.size());
+        modules_.reserve(handles.size());
+        ModuleInfo info = {};
+        for (HMODULE handle : handles) {
+            HMODULE module = nullptr;
+            if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(handle), &module)) {
+                continue;
+            }
+            pinned_.push_back(module);
+            if (!DescribeModule(module, info) || info.size == 0) {
+                continue;
+            }
+            const auto* image = static_cast<const BYTE*>(info.baseAddress);
+            HookScan::Module loaded;
+            loaded.path = info.path;
+            loaded.base = reinterpret_cast<uint64_t>(image);
+            loaded.size = info.size;
+            loaded.image = IsReadable(image, info.size) ? image : nullptr;
+            if (!loaded.image) {
+                LOG_WARN(L"{} skips {}: image not fully readable", purpose, info.path);
+            }
+            modules_.push_back(std::move(loaded));
+        }
+    }
+
+    ~PinnedModules() {
+        Release();
+    }
+
+    PinnedModules(const PinnedModules&) = delete;
+    PinnedModules& operator=(const PinnedModules&) = delete;
+
+    const std::vector<HookScan::Module>& Modules() const { return modules_; }
+
+    /// Unpins the modules and returns them with every image pointer cleared.
+    std::vector<HookScan::Module> Release() {
+        for (auto& module : modules_) {
+            module.image = nullptr;
+        }
+        for (HMODULE module : pinned_) {
+            FreeLibrary(module);
+        }
+        pinned_.clear();
+        return std::move(modules_);
+    }
+
+private:
+    std::vector<HMODULE> pinned_;
+    std::vector<HookScan::Module> modules_;
+};
+
+// Rough sizes of the scan results for the memory budget: elements and string characters, not allocator
+// overhead. A module index is taken to be about as big as the module list it indexes.
+size_t ApproxBytes(const std::wstring& text) {
+    return text.size() * sizeof(wchar_t);
+}
+
+size_t ApproxBytes(const std::vector<HookScan::Module>& modules) {
+    size_t bytes = modules.size() * sizeof(HookScan::Module) * 2;
+    for (const auto& module : modules) {
+        bytes += ApproxBytes(module.path);
+    }
+    return bytes;
+}
+
+size_t ApproxBytes(const HookScanResult& result) {
+    size_t bytes = ApproxBytes(result.modules) + result.report.modules.size() * sizeof(HookScan::ModuleResult);
+    for (const auto& finding : result.report.findings) {
+        bytes += sizeof(finding) + finding.function.size() + finding.importedFrom.size();
+    }
+    return bytes;
+}
+
+size_t ApproxBytes(const AddressSpace::Map& map) {
+    return map.Bytes();
+}
+
+size_t ApproxBytes(const IntegrityResult& result) {
+    size_t bytes = ApproxBytes(result.modules);
+    for (const auto& module : result.results) {
+        bytes += sizeof(module) + module.ranges.size() * sizeof(CodeIntegrity::Range);
+    }
+    return bytes;
+}
+
+size_t ApproxBytes(const HashResult& result) {
+    size_t bytes = 0;
+    for (const auto& [path, file] : result.files) {
+        bytes += sizeof(path) + ApproxBytes(path) + sizeof(file) + 2 * sizeof(void*);
+    }
+    return bytes;
+}
+
+size_t ApproxBytes(const DuplicateResult& result) {
+    size_t bytes = result.report.modules.size() * sizeof(DuplicateScan::ModuleResult) +
+        result.byBase.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*));
+    for (const auto& module : result.modules) {
+        bytes += sizeof(module) + ApproxBytes(module.path);
+    }
+    return bytes;
+}
+
+// A result over all loaded modules that is too slow to compute on the UI thread. Get returns whatever is
+// current and, when that is missing or stale, computes a new one on a detached thread; the thread holds a
+// module reference so the DLL cannot unload under it. The folder is refreshed when a result arrives
+// where there was none, or when needsRefresh says the new one changes what the folder lists.
+template <class T>
+class BackgroundResult {
+public:
+    /// @brief Whether replacing before (null if there was none) with after changes the folder's items.
+    using RefreshFn = bool (*)(const T* before, const T& after);
+
+    explicit BackgroundResult(std::shared_ptr<const T> (*compute)(), RefreshFn needsRefresh = nullptr)
+        : compute_(compute), needsRefresh_(needsRefresh) {}
+
+    size_t Bytes() {
+        std::lock_guard lock(mutex_);
+        return result_ ? ApproxBytes(*result_) : 0;
+    }
+
+    /// @brief Drops the current result unless it fits in target bytes; it is recomputed the next time it
+    /// is asked for. Folders still holding it keep it alive until they let go.
+    void TrimTo(size_t target) {
+        std::lock_guard lock(mutex_);
+        if (result_ && ApproxBytes(*result_) > target) {
+            result_.reset();
+        }
+    }
+
+    std::shared_ptr<const T> Get(std::chrono::milliseconds maxAge) {
+        std::lock_guard lock(mutex_);
+        if (!running_ && (!result_ || std::chrono::steady_clock::now() - completedAt_ > maxAge)) {
+            running_ = true;
+            auto& module = Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule();
+            module.IncrementObjectCount();
+            const Platform::ThreadFn run = [](void* self) { static_cast<BackgroundResult*>(self)->Run(); };
+            if (!Platform::StartDetachedThread(run, this)) {
+                module.DecrementObjectCount();
+                running_ = false;
+                LOG_ERROR(L"Could not start a background module check");
             }
         }
+        return result_;
+    }
+
+    /// @brief Computes a result on the calling thread and makes it current, for a caller that needs the
+    /// present state rather than the latest one.
+    std::shared_ptr<const T> Refresh() {
+        auto result = compute_();
+        std::lock_guard lock(mutex_);
+        result_ = result;
+        completedAt_ = std::chrono::steady_clock::now();
+        return result;
     }
 
-    // Machine Type - Read PE Header
-    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
-    if (hFile != INVALID_HANDLE_VALUE) {
-        LARGE_INTEGER liSize;
-        if (GetFileSizeEx(hFile, &liSize) && liSize.QuadPart > sizeof(IMAGE_DOS_HEADER)) {
-            HANDLE hMap = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
-            if (hMap) {
-                void* pBase = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
-                if (pBase) {
-                    PIMAGE_DOS_HEADER dosHeader = (PIMAGE_DOS_HEADER)pBase;
-                    if (dosHeader->e_magic == IMAGE_DOS_SIGNATURE) {
-                        // Check if e_lfanew is within bounds
-                        if (dosHeader->e_lfanew > 0 && 
-                            dosHeader->e_lfanew < liSize.QuadPart - sizeof(IMAGE_NT_HEADERS)) {
-                            
-                            PIMAGE_NT_HEADERS ntHeaders = (PIMAGE_NT_HEADERS)((BYTE*)pBase + dosHeader->e_lfanew);
-                            if (ntHeaders->Signature == IMAGE_NT_SIGNATURE) {
-                                switch (ntHeaders->FileHeader.Machine) {
-                                case IMAGE_FILE_MACHINE_I386: info.machineType = L"x86"; break;
-                                case IMAGE_FILE_MACHINE_AMD64: info.machineType = L"x64"; break;
-                                case IMAGE_FILE_MACHINE_ARM: info.machineType = L"ARM"; break;
-                                case IMAGE_FILE_MACHINE_ARM64: info.machineType = L"ARM64"; break;
-                                default: {
-                                    wchar_t buf[32];
-                                    StringCchPrintfW(buf, ARRAYSIZE(buf), L"0x%04X", ntHeaders->FileHeader.Machine);
-                                    info.machineType = buf;
-                                    break;
-                                }
-                                }
-                            }
-                        }
-                    }
-                    UnmapViewOfFile(pBase);
-                }
-                CloseHandle(hMap);
+private:
+    void Run() {
+        auto result = compute_();
+        std::shared_ptr<const T> previous;
+        {
+            std::lock_guard lock(mutex_);
+            previous = std::exchange(result_, result);
+            completedAt_ = std::chrono::steady_clock::now();
+            running_ = false;
+        }
+        // Only blank cells (or a changed item list) need the folder refreshed. A newer result shows as rows
+        // repaint; refreshing for it too would have the refresh re-read the column, start the next pass and
+        // refresh again.
+        const bool refresh = needsRefresh_ ? result && needsRefresh_(previous.get(), *result) : !previous;
+        if (refresh) {
+            HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+            NotifyFolderChanged();
+            if (SUCCEEDED(hr)) {
+                CoUninitialize();
             }
         }
-        CloseHandle(hFile);
+        Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().DecrementObjectCount();
     }
 
-    return info;
+    std::shared_ptr<const T> (*compute_)();
+    RefreshFn needsRefresh_;
+    std::mutex mutex_;
+    std::shared_ptr<const T> result_;
+    std::chrono::steady_clock::time_point completedAt_;
+    bool running_ = false;
+};
+
+BackgroundResult<HookScanResult> g_hookScan(ScanHooks);
+BackgroundResult<AddressSpace::Map> g_addressSpace(MapAddressSpace);
+BackgroundResult<IntegrityResult> g_integrity(CheckIntegrity);
+BackgroundResult<HashResult> g_hashes(HashModuleFiles);
+std::atomic<bool> g_duplicatesOnly{ false };
+
+std::vector<uint64_t> FlaggedBases(const DuplicateResult& result) {
+    std::vector<uint64_t> bases;
+    for (size_t i = 0; i < result.modules.size(); ++i) {
+        if (result.report.modules[i].flags != 0) {
+            bases.push_back(result.modules[i].base);
+        }
+    }
+    std::sort(bases.begin(), bases.end());
+    return bases;
+}
+
+// The duplicates-only view lists the flagged modules, so it follows every change to that set.
+bool DuplicateViewChanged(const DuplicateResult* before, const DuplicateResult& after) {
+    if (!before) {
+        return true;
+    }
+    return g_duplicatesOnly.load(std::memory_order_relaxed) && FlaggedBases(*before) != FlaggedBases(after);
+}
+
+BackgroundResult<DuplicateResult> g_duplicates(FindDuplicates, DuplicateViewChanged);
+
+// Digests by file identity, kept across passes for as long as the DLL is loaded.
+FileHash::Cache g_hashCache;
+
+// Decoded icons by content, and each module's icon digest by path.
+PeIcon::Cache g_iconCache;
+struct ModuleIcon {
+    uint64_t base = 0;
+    bool found = false;
+    Sha::Sha256::Digest digest{};
+};
+std::mutex g_moduleIconMutex;
+LruCache<std::wstring, ModuleIcon> g_moduleIcons(1 << 20); // Bytes, about 4,000 modules
+
+// Both copies of the key (list and index), the entry, and the nodes holding them.
+size_t ModuleIconBytes(const std::wstring& path) {
+    return 2 * (sizeof(std::wstring) + ApproxBytes(path)) + sizeof(ModuleIcon) + 6 * sizeof(void*);
+}
+
+// Runs read on the headers and resources of the module at base, pinned and checked to still be path.
+template <class Read>
+bool ReadLoadedImage(const std::wstring& path, void* baseAddress, Read read) {
+    HMODULE module = nullptr;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, static_cast<LPCWSTR>(baseAddress), &module)) {
+        return false;
+    }
+    bool done = false;
+    ModuleInfo info = {};
+    if (DescribeModule(module, info) && info.baseAddress == baseAddress && _wcsicmp(info.path.c_str(), path.c_str()) == 0) {
+        const auto* image = static_cast<const BYTE*>(info.baseAddress);
+        if (IsReadable(image, info.size)) {
+            done = read(PeImage::View(image, info.size, PeImage::Layout::Mapped));
+        }
+    }
+    FreeLibrary(module);
+    return done;
+}
+
+// Folders holding the session. Starting and stopping happen under the mutex, so a folder opened as the
+// last one closes cannot find the loader callback half torn down.
+std::mutex g_sessionMutex;
+uint32_t g_sessionHolders = 0;
+// Bumped whenever a session starts, which cancels an idle trim still waiting out the last one.
+uint64_t g_sessionGeneration = 0;
+std::condition_variable g_sessionChanged;
+uint32_t g_idleTrimsPending = 0;
+bool g_trimNow = false; // Set by ReadyToUnload: skip the rest of the idle period
+
+// Entries held by the metadata caches of every open folder, and what one typically costs: the node, the
+// path twice and the version strings.
+std::atomic<int64_t> g_metadataEntries{ 0 };
+constexpr size_t kMetadataEntryBytes = sizeof(ImageInfo) + 2 * sizeof(std::wstring) + 200 * sizeof(wchar_t) + 6 * sizeof(void*);
+
+constexpr uint32_t kDefaultIdleTrimSeconds = 60;
+constexpr uint32_t kDefaultIdleTrimLowWaterBytes = 1 << 20;
+
+constexpr uint32_t kDefaultWorkingSetRefreshMs = 5000;
+// Past this many changed modules one folder refresh is cheaper than a notification per item.
+constexpr size_t kMaxItemNotifications = 64;
+
+// The working-set query and what it was last asked about. The handle list is compared first, so an
+// unchanged module list costs one EnumProcessModules and no per-module calls.
+std::mutex g_workingSetMutex;
+std::vector<HMODULE> g_workingSetHandles;
+std::vector<WorkingSet::Module> g_workingSetModules;
+// Set when a working-set column is first read in a session, and cleared when a new session starts. The
+// timer queries only while it is set, so until the columns are shown it costs nothing. A read is not
+// asked for on every tick because rows whose counts did not change are not repainted and not read again.
+std::atomic<bool> g_workingSetWanted{ false };
+
+WorkingSet::Tracker& WorkingSetTracker() {
+    static WorkingSet::Tracker tracker(Platform::QueryWorkingSet, Platform::PageSize());
+    return tracker;
+}
+
+// Held weakly, so the watcher stops when the last folder closes rather than at DLL unload, where
+// joining its threads under the loader lock would deadlock.
+std::mutex g_fileWatcherMutex;
+std::weak_ptr<FileWatcher> g_fileWatcher;
+std::mutex g_diskStateMutex;
+std::unordered_map<std::wstring, DiskState> g_diskStates; // Only files found Replaced or Deleted
+
+// Changes within this long of the first are reported together; an installer replacing many DLLs
+// causes one refresh.
+constexpr std::chrono::milliseconds kFileWatchCoalesce{ 250 };
+
+// Compares the header fingerprint of a loaded module's file with that of its image in memory.
+DiskState CheckDiskState(const std::wstring& path) {
+    constexpr size_t kHeaderBytes = 0x1000;
+    HMODULE module = nullptr;
+    if (!GetModuleHandleExW(0, path.c_str(), &module)) {
+        return DiskState::Unchanged; // Unloaded since; there is no image to differ from
+    }
+    DuplicateScan::Fingerprint loaded;
+    bool haveLoaded = false;
+    ModuleInfo info = {};
+    if (DescribeModule(module, info)) {
+        const auto* image = static_cast<const BYTE*>(info.baseAddress);
+        const size_t headerBytes = (std::min)(static_cast<size_t>(info.size), kHeaderBytes);
+        haveLoaded = IsReadable(image, headerBytes) && DuplicateScan::ReadFingerprint(image, headerBytes, loaded);
+    }
+    FreeLibrary(module);
+    if (!haveLoaded) {
+        return DiskState::Unchanged;
+    }
+
+    auto file = Platform::SequentialFile::Open(path);
+    if (!file) {
+        return DiskState::Deleted;
+    }
+    std::array<uint8_t, kHeaderBytes> headers;
+    size_t bytesRead = 0;
+    DuplicateScan::Fingerprint onDisk;
+    if (!file->Read(headers.data(), headers.size(), bytesRead) || !DuplicateScan::ReadFingerprint(headers.data(), bytesRead, onDisk)) {
+        return DiskState::Replaced;
+    }
+    return onDisk == loaded ? DiskState::Unchanged : DiskState::Replaced;
+}
+
+// Refreshes the folder from a new thread, so the watcher's own thread never creates shell objects (one
+// of which could end up releasing the last reference to the watcher and joining that very thread).
+void NotifyFolderChangedDetached() {
+    auto& module = Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule();
+    module.IncrementObjectCount();
+    const bool started = Platform::StartDetachedThread([] {
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        NotifyFolderChanged();
+        if (SUCCEEDED(hr)) {
+            CoUninitialize();
+        }
+        Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().DecrementObjectCount();
+    });
+    if (!started) {
+        module.DecrementObjectCount();
+        LOG_ERROR(L"Could not start a refresh for changed module files");
+    }
+}
+
+// FileWatcher::ChangedFn. Folders drop their cached metadata for these paths on their own (by
+// generation); this records which files no longer match their images and refreshes the view.
+void OnModuleFilesChanged(void*, const std::vector<std::wstring>& paths) {
+    Diagnostics::Increment(Diagnostics::Counter::ModuleFilesChanged, paths.size());
+    size_t differing = 0;
+    for (const auto& path : paths) {
+        const DiskState state = CheckDiskState(path);
+        differing += state != DiskState::Unchanged;
+        std::lock_guard lock(g_diskStateMutex);
+        if (state == DiskState::Unchanged) {
+            g_diskStates.erase(path);
+        } else {
+            g_diskStates[path] = state;
+        }
+    }
+    LOG_INFO(L"{} module files changed on disk, {} no longer match the loaded image", paths.size(), differing);
+    NotifyFolderChangedDetached();
+}
+} // namespace
+
+ImageInfo GetImageInfo(const std::wstring& path) {
+    return PeImage::ReadImageInfo(path);
+}
+
+LoadTimeline& GetLoadTimeline() {
+    static LoadTimeline timeline;
+    return timeline;
 }
 
 int LoadModulesIf(const std::vector<std::wstring>& paths) {
     int loadedCount = 0;
+    auto& timeline = GetLoadTimeline();
     for (const auto& path : paths) {
         if (GetModuleHandleW(path.c_str())) {
-            Log::Write(Log::Level::Info, L"Module already loaded: %s", path.c_str());
+            LOG_INFO(L"Module already loaded: {}", path.c_str());
             continue;
         }
 
         // We're not calling FreeLibrary on purpose.
+        const auto started = Perf::Clock::now();
+        const uint64_t token = timeline.BeginLoad(GetCurrentThreadId(), path, started);
         HMODULE module = LoadLibraryW(path.c_str());
+        const auto finished = Perf::Clock::now();
+        timeline.EndLoad(token, module, finished);
         if (!module) {
             DWORD error = GetLastError();
-            Log::Write(Log::Level::Error, L"LoadLibrary failed: %s (%lu)", path.c_str(), error);
+            LOG_ERROR(L"LoadLibrary failed: {} ({})", path.c_str(), error);
             wchar_t message[1024] = {};
             StringCchPrintfW(message, ARRAYSIZE(message),
                 L"LoadLibrary failed.\nPath: %s\nError: %lu", path.c_str(), error);
             MessageBoxW(nullptr, message, L"Explorer Modules", MB_ICONERROR | MB_OK);
             continue;
         }
-        Log::Write(Log::Level::Info, L"LoadLibrary succeeded: %s", path.c_str());
+        LOG_INFO(L"LoadLibrary succeeded: {} ({} us)", path.c_str(),
+            std::chrono::duration_cast<std::chrono::microseconds>(finished - started).count());
         loadedCount++;
     }
     return loadedCount;
@@ -134,7 +482,7 @@ bool UnloadLibrary(void* baseAddress) {
     HMODULE hModule = static_cast<HMODULE>(baseAddress);
     wchar_t path[MAX_PATH] = {};
     if (GetModuleFileNameW(hModule, path, ARRAYSIZE(path)) == 0) {
-        Log::Write(Log::Level::Warn, L"UnloadLibrary: GetModuleFileNameW failed, cannot verify unload");
+        LOG_WARN(L"UnloadLibrary: GetModuleFileNameW failed, cannot verify unload");
         return false;
     }
 
@@ -152,25 +500,24 @@ bool UnloadLibrary(void* baseAddress) {
     }
 
     if (unloaded) {
-        Log::Write(Log::Level::Info, L"Module unloaded after %d attempts", i + 1);
+        LOG_INFO(L"Module unloaded after {} attempts", i + 1);
     }
     else
     {
-        Log::Write(Log::Level::Warn, L"Module is still loaded after %d FreeLibrary attempts", i);
+        LOG_WARN(L"Module is still loaded after {} FreeLibrary attempts", i);
     }
     
     return unloaded;
 }
 
-std::vector<ModuleInfo> GetLoadedModules() {
-    std::vector<ModuleInfo> items;
-
+std::vector<HMODULE> GetLoadedModuleHandles() {
+    Perf::ScopedTimer timer(Perf::Op::GetLoadedModules);
     // Initial guess
     std::vector<HMODULE> modules(1024);
     DWORD needed = 0;
     if (!EnumProcessModules(GetCurrentProcess(), modules.data(), static_cast<DWORD>(modules.size() * sizeof(HMODULE)), &needed)) {
-        Log::Write(Log::Level::Error, L"EnumProcessModules failed: %lu", GetLastError());
-        return items;
+        LOG_ERROR(L"EnumProcessModules failed: {}", GetLastError());
+        return {};
     }
 
     DWORD count = needed / sizeof(HMODULE);
@@ -178,27 +525,685 @@ std::vector<ModuleInfo> GetLoadedModules() {
         modules.resize(count);
         // Retry with larger buffer
         if (!EnumProcessModules(GetCurrentProcess(), modules.data(), static_cast<DWORD>(modules.size() * sizeof(HMODULE)), &needed)) {
-            Log::Write(Log::Level::Error, L"EnumProcessModules (retry) failed: %lu", GetLastError());
-            return items;
+            LOG_ERROR(L"EnumProcessModules (retry) failed: {}", GetLastError());
+            return {};
+        }
+        // Modules may have loaded between the two calls; take what fit.
+        count = (std::min)(static_cast<DWORD>(modules.size()), needed / static_cast<DWORD>(sizeof(HMODULE)));
+    }
+    modules.resize(count);
+    return modules;
+}
+
+bool DescribeModule(HMODULE module, ModuleInfo& info) {
+    info.path.resize(MAX_PATH);
+    DWORD length = GetModuleFileNameW(module, info.path.data(), MAX_PATH);
+    if (length == 0) {
+        info.path.clear();
+        return false;
+    }
+    info.path.resize(length);
+
+    MODULEINFO moduleInfo = {};
+    if (GetModuleInformation(GetCurrentProcess(), module, &moduleInfo, sizeof(moduleInfo))) {
+        info.baseAddress = moduleInfo.lpBaseOfDll;
+        info.size = moduleInfo.SizeOfImage;
+        LOG_TRACE(L"Module: {} Base={} Size={}", info.path, info.baseAddress, info.size);
+    } else {
+        info.baseAddress = module;
+        info.size = 0;
+        LOG_WARN(L"GetModuleInformation failed for: {}", info.path);
+    }
+    return true;
+}
+
+std::vector<ModuleInfo> GetLoadedModules() {
+    std::vector<ModuleInfo> items;
+
+    auto modules = GetLoadedModuleHandles();
+    LOG_INFO(L"Enumerating {} modules", modules.size());
+    items.reserve(modules.size());
+    ModuleInfo info = {};
+    for (HMODULE module : modules) {
+        if (DescribeModule(module, info)) {
+            items.push_back(info);
+        }
+    }
+
+    return items;
+}
+
+HRESULT ExportSnapshot(const std::wstring& path) {
+    const auto handles = GetLoadedModuleHandles();
+    ModuleEnumerator::Snapshot modules;
+    modules.reserve(handles.size());
+    for (HMODULE module : handles) {
+        modules.push_back(reinterpret_cast<ModuleEnumerator::Handle>(module));
+    }
+
+    const auto capturedAt = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto writer = SnapshotExport::Open(SnapshotExport::FormatFromPath(path), path, modules.size(),
+        static_cast<uint64_t>(capturedAt), Platform::CurrentProcessId());
+    if (!writer) {
+        LOG_ERROR(L"Cannot create snapshot file: {}", path);
+        return HRESULT_FROM_WIN32(ERROR_CANNOT_MAKE);
+    }
+    uint64_t rows = 0;
+    if (!SnapshotExport::WriteModules(*writer, modules, DescribeHandle, PeImage::ReadImageInfo, rows) || !writer->Finish()) {
+        LOG_ERROR(L"Snapshot export to {} failed", path);
+        return HRESULT_FROM_WIN32(ERROR_WRITE_FAULT);
+    }
+    LOG_INFO(L"Exported {} modules to {}", rows, path);
+    return S_OK;
+}
+
+std::shared_ptr<const HookScanResult> ScanHooks() {
+    Perf::ScopedTimer timer(Perf::Op::HookScan);
+    PinnedModules pinned(L"Hook scan");
+    auto report = HookScan::Scan(pinned.Modules(), ResolveLoadedModule, (std::max)(std::thread::hardware_concurrency(), 1u));
+    auto modules = pinned.Release();
+
+    Diagnostics::Increment(Diagnostics::Counter::HookScans);
+    Diagnostics::Increment(Diagnostics::Counter::HookedEntriesFound, report.findings.size());
+    LOG_INFO(L"Hook scan: {} modules, {} hooked entries", modules.size(), report.findings.size());
+    return std::make_shared<const HookScanResult>(std::move(modules), std::move(report));
+}
+
+std::shared_ptr<const HookScanResult> GetHookScan(std::chrono::milliseconds maxAge) {
+    return g_hookScan.Get(maxAge);
+}
+
+std::shared_ptr<const HookScanResult> RescanHooks() {
+    return g_hookScan.Refresh();
+}
+
+std::shared_ptr<const AddressSpace::Map> MapAddressSpace() {
+    Perf::ScopedTimer timer(Perf::Op::AddressSpace);
+    const uint64_t pageSize = Platform::PageSize();
+    const auto handles = GetLoadedModuleHandles();
+    std::vector<AddressSpace::Module> modules;
+    modules.reserve(handles.size());
+    for (HMODULE handle : handles) {
+        HMODULE pinned = nullptr;
+        if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(handle), &pinned)) {
+            continue;
+        }
+        MODULEINFO info = {};
+        if (GetModuleInformation(GetCurrentProcess(), pinned, &info, sizeof(info)) && info.SizeOfImage) {
+            // Only the headers are read, and a loaded image's header page is always mapped.
+            PeImage::View view(static_cast<const uint8_t*>(info.lpBaseOfDll), info.SizeOfImage, PeImage::Layout::Mapped);
+            AddressSpace::Module module;
+            module.base = reinterpret_cast<uint64_t>(info.lpBaseOfDll);
+            module.size = info.SizeOfImage;
+            module.sections = AddressSpace::Sections(view, pageSize);
+            modules.push_back(std::move(module));
         }
+        FreeLibrary(pinned);
     }
 
-    Log::Write(Log::Level::Info, L"Enumerating %lu modules", count);
-    for (DWORD i = 0; i < count; ++i) {
-        wchar_t path[MAX_PATH] = {};
-        if (GetModuleFileNameW(modules[i], path, ARRAYSIZE(path))) {
+    std::vector<Platform::MemoryRegion> regions;
+    if (!Platform::WalkAddressSpace(regions)) {
+        LOG_WARN(L"Address space walk found no regions");
+    }
+    auto map = std::make_shared<const AddressSpace::Map>(std::move(modules), regions);
+    const auto stats = map->GetStats();
+    LOG_INFO(L"Address space: {} regions, {} modules in {} intervals, {} KB committed to images", stats.regions,
+        map->Modules().size(), stats.intervals, stats.imageBytes / 1024);
+    return map;
+}
+
+std::shared_ptr<const AddressSpace::Map> GetAddressSpace(std::chrono::milliseconds maxAge) {
+    return g_addressSpace.Get(maxAge);
+}
+
+std::shared_ptr<const AddressSpace::Map> RemapAddressSpace() {
+    return g_addressSpace.Refresh();
+}
+
+std::shared_ptr<const IntegrityResult> CheckIntegrity() {
+    Perf::ScopedTimer timer(Perf::Op::IntegrityCheck);
+    PinnedModules pinned(L"Integrity check");
+    CodeIntegrity::Options options;
+    options.threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    options.ioConcurrency = Settings::ReadDword(L"IntegrityIoConcurrency", 4);
+    auto results = CodeIntegrity::Check(pinned.Modules(), CodeIntegrity::OpenMappedFile, options);
+    auto modules = pinned.Release();
+
+    size_t modified = 0;
+    for (const auto& result : results) {
+        if (result.status == CodeIntegrity::Status::Modified) {
+            ++modified;
+        }
+    }
+    Diagnostics::Increment(Diagnostics::Counter::IntegrityChecks);
+    Diagnostics::Increment(Diagnostics::Counter::ModifiedModulesFound, modified);
+    LOG_INFO(L"Integrity check: {} modules, {} with modified code ({})", modules.size(), modified,
+        Simd::LevelName(options.level));
+    return std::make_shared<const IntegrityResult>(std::move(modules), std::move(results));
+}
+
+std::shared_ptr<const IntegrityResult> GetIntegrityCheck(std::chrono::milliseconds maxAge) {
+    return g_integrity.Get(maxAge);
+}
+
+std::shared_ptr<const HashResult> HashModuleFiles() {
+    Perf::ScopedTimer timer(Perf::Op::HashModuleFiles);
+    const auto modules = GetLoadedModules();
+    std::vector<std::wstring> paths;
+    paths.reserve(modules.size());
+    for (const auto& module : modules) {
+        paths.push_back(module.path);
+    }
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+    FileHash::Options options;
+    options.threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    options.ioConcurrency = Settings::ReadDword(L"HashIoConcurrency", 2);
+    options.algorithms = FileHash::kSha256 | FileHash::kPeChecksum |
+        (Settings::ReadDword(L"HashSha1", 0) ? FileHash::kSha1 : 0);
+    FileHash::Stats stats;
+    auto results = FileHash::HashFiles(paths, &g_hashCache, FileHash::OpenSequentialFile, options, &stats);
+
+    auto result = std::make_shared<HashResult>();
+    result->algorithms = options.algorithms;
+    result->files.reserve(paths.size());
+    size_t mismatches = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (results[i].digests.peChecksum.status == PeChecksum::Status::Mismatch) {
+            LOG_WARN(L"PE checksum mismatch: {} (stored 0x{:08X}, computed 0x{:08X})", paths[i],
+                results[i].digests.peChecksum.stored, results[i].digests.peChecksum.computed);
+            ++mismatches;
+        }
+        result->files.emplace(std::move(paths[i]), results[i]);
+    }
+    Diagnostics::Increment(Diagnostics::Counter::FilesHashed, stats.filesHashed);
+    Diagnostics::Increment(Diagnostics::Counter::HashCacheHits, stats.cacheHits);
+    Diagnostics::Increment(Diagnostics::Counter::ChecksumMismatchesFound, mismatches);
+    LOG_INFO(L"Hashed {} module files: {} read ({} MB), {} unchanged, {} checksum mismatches ({}, {})", results.size(),
+        stats.filesHashed, stats.bytesRead >> 20, stats.cacheHits, mismatches,
+        Simd::ShaExtensions() ? L"SHA extensions" : L"portable", Simd::LevelName(options.level));
+    return result;
+}
+
+std::shared_ptr<const HashResult> GetModuleHashes(std::chrono::milliseconds maxAge) {
+    return g_hashes.Get(maxAge);
+}
+
+std::shared_ptr<const DuplicateResult> FindDuplicates() {
+    Perf::ScopedTimer timer(Perf::Op::FindDuplicates);
+    // The fingerprint fields are all in the first page of the headers, which is always mapped for a
+    // loaded image; each module is pinned only while that page is read.
+    constexpr size_t kHeaderBytes = 0x1000;
+    auto result = std::make_shared<DuplicateResult>();
+    const auto handles = GetLoadedModuleHandles();
+    result->modules.reserve(handles.size());
+    ModuleInfo info = {};
+    for (HMODULE handle : handles) {
+        HMODULE module = nullptr;
+        if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(handle), &module)) {
+            continue;
+        }
+        if (DescribeModule(module, info)) {
+            DuplicateScan::Module entry;
+            entry.path = info.path;
+            entry.base = reinterpret_cast<uint64_t>(info.baseAddress);
+            const size_t headerBytes = (std::min)(static_cast<size_t>(info.size), kHeaderBytes);
+            const auto* headers = static_cast<const BYTE*>(info.baseAddress);
+            entry.fingerprinted = IsReadable(headers, headerBytes) &&
+                DuplicateScan::ReadFingerprint(headers, headerBytes, entry.fingerprint);
+            result->modules.push_back(std::move(entry));
+        }
+        FreeLibrary(module);
+    }
+
+    result->report = DuplicateScan::Detect(result->modules, FileHash::OpenSequentialFile, &g_hashCache,
+        (std::max)(std::thread::hardware_concurrency(), 1u));
+    result->byBase.reserve(result->modules.size());
+    for (size_t i = 0; i < result->modules.size(); ++i) {
+        result->byBase.emplace(result->modules[i].base, static_cast<uint32_t>(i));
+    }
+    Diagnostics::Increment(Diagnostics::Counter::DuplicateScans);
+    Diagnostics::Increment(Diagnostics::Counter::DuplicateModulesFound, result->report.copies + result->report.versions);
+    LOG_INFO(L"Duplicate scan: {} modules, {} copies, {} side-by-side versions, {} files compared",
+        result->modules.size(), result->report.copies, result->report.versions, result->report.filesHashed);
+    return result;
+}
+
+std::shared_ptr<const DuplicateResult> GetDuplicates(std::chrono::milliseconds maxAge) {
+    return g_duplicates.Get(maxAge);
+}
+
+bool DuplicatesOnly() {
+    return g_duplicatesOnly.load(std::memory_order_relaxed);
+}
+
+void SetDuplicatesOnly(bool enabled) {
+    g_duplicatesOnly.store(enabled, std::memory_order_relaxed);
+    LOG_INFO(L"Duplicates-only view {}", enabled ? L"on" : L"off");
+}
+
+namespace {
+
+void RegisterMemoryPools() {
+    auto& budget = MemoryBudget::Process();
+    budget.Register(L"File hashes", [] { return g_hashCache.Bytes(); }, [](size_t target) { g_hashCache.TrimTo(target); });
+    budget.Register(L"Icons", [] { return g_iconCache.GetStats().bytes; }, [](size_t target) { g_iconCache.TrimTo(target); });
+    budget.Register(L"Icon digests", [] {
+        std::lock_guard lock(g_moduleIconMutex);
+        return g_moduleIcons.TotalCost();
+    }, [](size_t target) {
+        std::lock_guard lock(g_moduleIconMutex);
+        if (target == 0) {
+            g_moduleIcons.Clear();
+        } else {
+            g_moduleIcons.TrimTo(target);
+        }
+    });
+    budget.Register(L"Hook scan", [] { return g_hookScan.Bytes(); }, [](size_t target) { g_hookScan.TrimTo(target); });
+    budget.Register(L"Integrity check", [] { return g_integrity.Bytes(); }, [](size_t target) { g_integrity.TrimTo(target); });
+    budget.Register(L"File hash results", [] { return g_hashes.Bytes(); }, [](size_t target) { g_hashes.TrimTo(target); });
+    budget.Register(L"Duplicate scan", [] { return g_duplicates.Bytes(); }, [](size_t target) { g_duplicates.TrimTo(target); });
+    budget.Register(L"Address space", [] { return g_addressSpace.Bytes(); }, [](size_t target) { g_addressSpace.TrimTo(target); });
+    budget.Register(L"Working set", [] {
+        std::lock_guard lock(g_workingSetMutex);
+        return WorkingSetTracker().Bytes() + g_workingSetModules.capacity() * sizeof(WorkingSet::Module);
+    }, [](size_t target) {
+        std::lock_guard lock(g_workingSetMutex);
+        if (WorkingSetTracker().Bytes() > target) {
+            WorkingSetTracker().Clear();
+            g_workingSetHandles = {};
+            g_workingSetModules = {};
+        }
+    });
+    budget.Register(L"Load timeline", [] { return GetLoadTimeline().Bytes(); }, nullptr);
+    budget.Register(L"Module metadata", [] {
+        return static_cast<size_t>((std::max)(g_metadataEntries.load(std::memory_order_relaxed), int64_t{ 0 })) * kMetadataEntryBytes;
+    }, nullptr);
+}
+
+// Refreshes the working-set columns, while they are shown, until the session it was started for ends.
+// Holds a module reference for as long as it runs.
+void StartWorkingSetTimer() {
+    const auto interval = std::chrono::milliseconds(Settings::ReadDword(L"WorkingSetRefreshMs", kDefaultWorkingSetRefreshMs));
+    if (interval.count() == 0) {
+        return;
+    }
+    const uint64_t generation = g_sessionGeneration;
+    auto& module = Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule();
+    module.IncrementObjectCount();
+    const bool started = Platform::StartDetachedThread([generation, interval] {
+        HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        std::unique_lock lock(g_sessionMutex);
+        do {
+            lock.unlock();
+            if (g_workingSetWanted.load(std::memory_order_relaxed)) {
+                NotifyModulesChanged(RefreshWorkingSet());
+            }
+            lock.lock();
+        } while (!g_sessionChanged.wait_for(lock, interval, [generation] {
+            return g_sessionGeneration != generation || g_sessionHolders == 0;
+        }));
+        lock.unlock();
+        if (SUCCEEDED(hr)) {
+            CoUninitialize();
+        }
+        Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().DecrementObjectCount();
+    });
+    if (!started) {
+        module.DecrementObjectCount();
+        LOG_ERROR(L"Could not start the working-set refresh");
+    }
+}
+
+// Opt-in Chrome trace capture: set TraceFile (REG_SZ / REG_EXPAND_SZ) to a .json path. Once per process,
+// since a trace spans sessions. Not in DllMain, which holds the loader lock, nor in DllGetClassObject,
+// which runs on every bind.
+void StartTraceIfRequested() {
+    auto tracePath = Settings::ReadString(L"TraceFile");
+    if (!tracePath.empty()) {
+        if (Perf::StartTrace(tracePath)) {
+            LOG_INFO(L"Recording trace to {}", tracePath);
+        } else {
+            LOG_WARN(L"Could not open trace file {}", tracePath);
+        }
+    }
+}
+
+void StartSession() {
+    const auto start = Perf::Clock::now();
+    // Every session, so a changed LogLevel applies the next time a folder opens, without restarting Explorer.
+    Log::RefreshRuntimeLevel();
+    static bool registered = false;
+    if (!registered) {
+        StartTraceIfRequested();
+        RegisterMemoryPools();
+        registered = true;
+    }
+    ++g_sessionGeneration;
+    g_trimNow = false;
+    g_workingSetWanted.store(false, std::memory_order_relaxed);
+    g_sessionChanged.notify_all();
+    InitializeDllNotification();
+    StartWorkingSetTimer();
+    Diagnostics::Increment(Diagnostics::Counter::SessionsStarted);
+    LOG_INFO(L"Session started in {} us",
+        std::chrono::duration_cast<std::chrono::microseconds>(Perf::Clock::now() - start).count());
+}
+
+// Called with g_sessionMutex held, so a folder opening waits for the trim rather than racing it.
+void TrimIdle(size_t lowWater) {
+    auto& budget = MemoryBudget::Process();
+    const size_t before = budget.TotalBytes();
+    const size_t released = budget.TrimTo(lowWater);
+    Diagnostics::Increment(Diagnostics::Counter::IdleTrims);
+    Diagnostics::Increment(Diagnostics::Counter::BytesTrimmed, released);
+    LOG_INFO(L"Idle trim released {} KB of {} KB", released / 1024, before / 1024);
+    if (Log::IsEnabled(Log::Level::Trace)) {
+        LOG_TRACE(L"Memory held after trim:\n{}", budget.Format());
+    }
+}
+
+// Waits out the idle period on a thread of its own, which holds a module reference so the DLL stays
+// loaded until it is done (ReadyToUnload cuts the wait short).
+void ScheduleIdleTrim() {
+    const uint64_t generation = g_sessionGeneration;
+    const auto idle = std::chrono::seconds(Settings::ReadDword(L"IdleTrimSeconds", kDefaultIdleTrimSeconds));
+    const size_t lowWater = Settings::ReadDword(L"IdleTrimLowWaterBytes", kDefaultIdleTrimLowWaterBytes);
+    auto& module = Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule();
+    module.IncrementObjectCount();
+    ++g_idleTrimsPending;
+    const bool started = Platform::StartDetachedThread([generation, idle, lowWater] {
+        {
+            std::unique_lock lock(g_sessionMutex);
+            g_sessionChanged.wait_for(lock, idle, [generation] {
+                return g_sessionGeneration != generation || g_trimNow;
+            });
+            if (g_sessionGeneration == generation) {
+                TrimIdle(lowWater);
+            }
+            --g_idleTrimsPending;
+        }
+        Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().DecrementObjectCount();
+    });
+    if (!started) {
+        --g_idleTrimsPending;
+        module.DecrementObjectCount();
+        LOG_ERROR(L"Could not start the idle trim");
+    }
+}
+
+// What only holds while notifications arrive and files are watched goes now; the caches stay warm for
+// a folder opened again soon and are trimmed once the session has been idle for IdleTrimSeconds.
+void StopSession() {
+    ShutdownDllNotification();
+    g_sessionChanged.notify_all(); // Ends the working-set timer
+    GetLoadTimeline().Clear();
+    {
+        std::lock_guard lock(g_diskStateMutex);
+        g_diskStates.clear();
+    }
+    ScheduleIdleTrim();
+    // Spans recorded since the last view closed (background passes, loader refreshes) reach the file now
+    // rather than waiting for the next session.
+    Perf::FlushTrace();
+    LOG_INFO(L"Session stopped");
+}
+
+} // namespace
+
+std::shared_ptr<void> AcquireSession() {
+    std::lock_guard lock(g_sessionMutex);
+    if (g_sessionHolders++ == 0) {
+        StartSession();
+    }
+    // Nothing is owned; the deleter is the release.
+    return std::shared_ptr<void>(&g_sessionHolders, [](void*) {
+        std::lock_guard lock(g_sessionMutex);
+        if (--g_sessionHolders == 0) {
+            StopSession();
+        }
+    });
+}
+
+bool ReadyToUnload() {
+    std::lock_guard lock(g_sessionMutex);
+    if (g_sessionHolders) {
+        return false;
+    }
+    if (g_idleTrimsPending) {
+        g_trimNow = true;
+        g_sessionChanged.notify_all();
+        return false;
+    }
+    return DllNotificationIdle();
+}
+
+void AddMetadataEntries(int64_t delta) {
+    g_metadataEntries.fetch_add(delta, std::memory_order_relaxed);
+}
+
+std::vector<uint64_t> RefreshWorkingSet() {
+    auto handles = GetLoadedModuleHandles();
+    std::lock_guard lock(g_workingSetMutex);
+    if (handles != g_workingSetHandles) {
+        g_workingSetModules.clear();
+        for (HMODULE module : handles) {
             MODULEINFO info = {};
-            if (GetModuleInformation(GetCurrentProcess(), modules[i], &info, sizeof(info))) {
-                 items.push_back({path, info.lpBaseOfDll, info.SizeOfImage});
-                 Log::Write(Log::Level::Trace, L"Module: %s Base=%p Size=%u", path, info.lpBaseOfDll, info.SizeOfImage);
-            } else {
-                 items.push_back({path, modules[i], 0});
-                 Log::Write(Log::Level::Warn, L"GetModuleInformation failed for: %s", path);
+            if (GetModuleInformation(GetCurrentProcess(), module, &info, sizeof(info))) {
+                g_workingSetModules.push_back({ reinterpret_cast<uint64_t>(info.lpBaseOfDll), info.SizeOfImage });
             }
         }
+        g_workingSetHandles = std::move(handles);
+    }
+    auto& tracker = WorkingSetTracker();
+    if (!tracker.Refresh(g_workingSetModules)) {
+        LOG_WARN(L"QueryWorkingSetEx failed: {}", GetLastError());
+        return {};
     }
+    return tracker.Changed();
+}
 
-    return items;
+bool GetWorkingSet(void* baseAddress, WorkingSet::Counts& counts) {
+    g_workingSetWanted.store(true, std::memory_order_relaxed);
+    std::lock_guard lock(g_workingSetMutex);
+    const auto* found = WorkingSetTracker().Find(reinterpret_cast<uint64_t>(baseAddress));
+    if (!found) {
+        return false;
+    }
+    counts = *found;
+    return true;
+}
+
+std::shared_ptr<FileWatcher> AcquireFileWatcher() {
+    if (!Settings::ReadDword(L"WatchModuleFiles", 1)) {
+        return nullptr;
+    }
+    {
+        std::lock_guard lock(g_fileWatcherMutex);
+        if (auto watcher = g_fileWatcher.lock()) {
+            return watcher;
+        }
+    }
+    std::shared_ptr<FileWatcher> watcher;
+    try {
+        watcher = std::make_shared<FileWatcher>(OnModuleFilesChanged, nullptr, kFileWatchCoalesce);
+    } catch (const std::system_error&) {
+        LOG_ERROR(L"Could not start the module file watcher");
+        return nullptr;
+    }
+    if (!watcher->IsWatching()) {
+        LOG_WARN(L"Module file watcher unavailable; metadata will not follow files replaced on disk");
+        return nullptr;
+    }
+    {
+        std::lock_guard lock(g_fileWatcherMutex);
+        // Another folder may have started one meanwhile; keep that and let this one go.
+        if (auto existing = g_fileWatcher.lock()) {
+            return existing;
+        }
+        g_fileWatcher = watcher;
+    }
+    UpdateWatchedFiles();
+    return watcher;
+}
+
+void UpdateWatchedFiles() {
+    std::shared_ptr<FileWatcher> watcher;
+    {
+        std::lock_guard lock(g_fileWatcherMutex);
+        watcher = g_fileWatcher.lock();
+    }
+    if (!watcher) {
+        return;
+    }
+    std::vector<std::wstring> paths;
+    const auto handles = GetLoadedModuleHandles();
+    paths.reserve(handles.size());
+    ModuleInfo info = {};
+    for (HMODULE handle : handles) {
+        if (DescribeModule(handle, info)) {
+            paths.push_back(info.path);
+        }
+    }
+    watcher->SetFiles(paths);
+    const auto stats = watcher->GetStats();
+    LOG_TRACE(L"Watching {} module files in {} directories", stats.files, stats.directories);
+
+    std::lock_guard lock(g_diskStateMutex);
+    if (!g_diskStates.empty()) {
+        const std::unordered_set<std::wstring> loaded(paths.begin(), paths.end());
+        std::erase_if(g_diskStates, [&loaded](const auto& entry) { return !loaded.count(entry.first); });
+    }
+}
+
+DiskState GetDiskState(const std::wstring& path) {
+    std::lock_guard lock(g_diskStateMutex);
+    const auto found = g_diskStates.find(path);
+    return found == g_diskStates.end() ? DiskState::Unchanged : found->second;
+}
+
+bool GetModuleIconDigest(const std::wstring& path, void* baseAddress, Sha::Sha256::Digest& digest) {
+    const auto base = reinterpret_cast<uint64_t>(baseAddress);
+    {
+        std::lock_guard lock(g_moduleIconMutex);
+        if (const auto* cached = g_moduleIcons.Find(path); cached && cached->base == base) {
+            digest = cached->digest;
+            return cached->found;
+        }
+    }
+    ModuleIcon entry;
+    entry.base = base;
+    PeIcon::Group group;
+    entry.found = ReadLoadedImage(path, baseAddress, [&group](const PeImage::View& view) {
+        return PeIcon::ReadGroup(view, group);
+    });
+    entry.digest = group.digest;
+    digest = entry.digest;
+    std::lock_guard lock(g_moduleIconMutex);
+    g_moduleIcons.Insert(path, entry, ModuleIconBytes(path));
+    return entry.found;
+}
+
+std::shared_ptr<const PeIcon::Image> GetModuleIcon(const std::wstring& path, void* baseAddress, uint32_t size) {
+    Perf::ScopedTimer timer(Perf::Op::ExtractIcon);
+    Sha::Sha256::Digest digest;
+    if (!GetModuleIconDigest(path, baseAddress, digest)) {
+        return nullptr;
+    }
+    if (auto cached = g_iconCache.Find(digest, size)) {
+        Diagnostics::Increment(Diagnostics::Counter::IconCacheHits);
+        return cached;
+    }
+    PeIcon::Image image;
+    const bool decoded = ReadLoadedImage(path, baseAddress, [&image, size](const PeImage::View& view) {
+        PeIcon::Group group;
+        return PeIcon::ReadGroup(view, group) && PeIcon::Load(view, group, size, image);
+    });
+    if (!decoded) {
+        return nullptr;
+    }
+    Diagnostics::Increment(Diagnostics::Counter::IconsDecoded);
+    return g_iconCache.Store(digest, size, std::move(image));
+}
+
+SignatureScan::Stats SearchModules(const SignatureScan::Matcher& matcher, SignatureScan::HitSink sink, void* context,
+    const std::atomic<bool>* cancel) {
+    Perf::ScopedTimer timer(Perf::Op::SignatureSearch);
+    PinnedModules pinned(L"Signature search");
+    SignatureScan::Options options;
+    options.threads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    options.maxHits = Settings::ReadDword(L"SignatureMaxHits", 100000);
+    options.cancel = cancel;
+    const auto stats = SignatureScan::Search(pinned.Modules(), matcher, options, sink, context);
+    pinned.Release();
+
+    Diagnostics::Increment(Diagnostics::Counter::SignatureSearches);
+    Diagnostics::Increment(Diagnostics::Counter::SignatureHitsFound, stats.hits);
+    LOG_INFO(L"Signature search: {} patterns, {} MB, {} hits{} ({})", matcher.Patterns().size(),
+        stats.bytesScanned >> 20, stats.hits, stats.truncated ? L" (stopped early)" : L"", Simd::LevelName(options.level));
+    return stats;
+}
+
+namespace {
+
+// The module folder's absolute PIDL, or null if it could not be located. Free with CoTaskMemFree.
+PIDLIST_ABSOLUTE ParseFolderPidl() {
+    // Prefix with :: to ensure it parses as a CLSID/Namespace location
+    std::wstring parsingName = std::wstring(kNamespaceParentParsingName) + L"\\::" + kModuleFolderClsidString;
+
+    // SHCNF_PARSE_NAME is not standard, so we must parse it to a PIDL first.
+    PIDLIST_ABSOLUTE pidl = nullptr;
+    SFGAOF sfgao = 0;
+    HRESULT hr = SHParseDisplayName(parsingName.c_str(), nullptr, &pidl, 0, &sfgao);
+    if (FAILED(hr)) {
+        LOG_ERROR(L"SHParseDisplayName failed for {}: 0x{:08X}", parsingName.c_str(), static_cast<unsigned long>(hr));
+        return nullptr;
+    }
+    return pidl;
+}
+
+} // namespace
+
+bool NotifyFolderChanged() {
+    PIDLIST_ABSOLUTE pidl = ParseFolderPidl();
+    if (!pidl) {
+        return false;
+    }
+    // SHCNE_UPDATEDIR indicates the contents of the folder identified by the PIDL have changed.
+    SHChangeNotify(SHCNE_UPDATEDIR, SHCNF_IDLIST, pidl, nullptr);
+    CoTaskMemFree(pidl);
+    return true;
+}
+
+bool NotifyModulesChanged(const std::vector<uint64_t>& bases) {
+    if (bases.empty()) {
+        return true;
+    }
+    if (bases.size() > kMaxItemNotifications) {
+        return NotifyFolderChanged();
+    }
+    PIDLIST_ABSOLUTE folder = ParseFolderPidl();
+    if (!folder) {
+        return false;
+    }
+    // The items are built as EnumObjects builds them, so the view matches each one to its row.
+    ModuleInfo info = {};
+    for (const uint64_t base : bases) {
+        if (!DescribeModule(reinterpret_cast<HMODULE>(base), info)) {
+            continue; // Unloaded since; the loader notification refreshes the folder
+        }
+        PIDLIST_RELATIVE child = Pidl::CreateFromPath(info.path, info.baseAddress, info.size);
+        PIDLIST_ABSOLUTE item = child ? ILCombine(folder, child) : nullptr;
+        if (item) {
+            SHChangeNotify(SHCNE_UPDATEITEM, SHCNF_IDLIST, item, nullptr);
+            ILFree(item);
+        }
+        Pidl::Free(child);
+    }
+    CoTaskMemFree(folder);
+    return true;
 }
 
 }
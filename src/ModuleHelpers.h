@@ -1,24 +1,35 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include <windows.h>
 
+#include "AddressSpace.h"
+#include "CodeIntegrity.h"
+#include "DuplicateScan.h"
+#include "FileHash.h"
+#include "FileWatcher.h"
+#include "HookScan.h"
+#include "LoadTimeline.h"
+#include "ModuleEnumerator.h"
+#include "PeIcon.h"
+#include "PeImage.h"
+#include "SignatureScan.h"
+#include "WorkingSet.h"
+
 namespace ModuleHelpers {
 
-struct ModuleInfo {
-    std::wstring path;
-    void* baseAddress;
-    DWORD size;
-};
+using ModuleInfo = ModuleRecord;
+using ImageInfo = PeImage::ImageInfo;
 
-struct ImageInfo {
-    std::wstring companyName;
-    std::wstring description;
-    std::wstring fileVersion;
-    std::wstring machineType;
-};
+/// @brief The process-wide record of module loads, fed by the loader notification and by LoadModulesIf.
+LoadTimeline& GetLoadTimeline();
 
-/// @brief Loads modules from the specified paths if they are not already loaded.
+/// @brief Loads modules from the specified paths if they are not already loaded. Each LoadLibraryW is
+/// timed into the load timeline as the root of whatever it loads.
 /// @param paths A vector of module file paths to load.
 /// @return The number of modules successfully loaded.
 int LoadModulesIf(const std::vector<std::wstring>& paths);
@@ -37,4 +48,177 @@ ImageInfo GetImageInfo(const std::wstring& path);
 /// @return A vector of ModuleInfo structures representing the loaded modules.
 std::vector<ModuleInfo> GetLoadedModules();
 
+/// @brief Snapshots the handles of the loaded modules without describing them. This is one
+/// EnumProcessModules call; pair it with DescribeModule to fetch paths only for the modules needed.
+std::vector<HMODULE> GetLoadedModuleHandles();
+
+/// @brief Fills info with the path, base address and size of a module. The path string is reused, so
+/// a caller describing many modules into the same ModuleInfo allocates only once.
+/// @return False if the module has been unloaded since the handle was obtained.
+bool DescribeModule(HMODULE module, ModuleInfo& info);
+
+/// @brief Writes the loaded modules with their image info to path, in the format its extension selects
+/// (see SnapshotExport::FormatFromPath). Rows are streamed, so the table is never held in memory.
+/// @return S_OK, or a failure HRESULT if the file could not be created or written.
+HRESULT ExportSnapshot(const std::wstring& path);
+
+// A hook scan of every loaded module. The images are only pinned while the scan runs, so every
+// HookScan::Module::image is null here; the paths and bases stay valid for reporting.
+struct HookScanResult {
+    explicit HookScanResult(std::vector<HookScan::Module> scanned, HookScan::Report scanReport)
+        : modules(std::move(scanned)), report(std::move(scanReport)), index(modules) {}
+
+    std::vector<HookScan::Module> modules;
+    HookScan::Report report;
+    HookScan::ModuleIndex index;
+};
+
+/// @brief Scans the import and export address tables of every loaded module on all cores.
+/// Modules that unload mid-scan, or whose image is not fully readable, are skipped.
+std::shared_ptr<const HookScanResult> ScanHooks();
+
+/// @brief The latest ScanHooks result, or null before the first one completes. When it is missing or
+/// older than maxAge a new scan starts in the background, as GetIntegrityCheck does, and the folder is
+/// refreshed when it completes.
+std::shared_ptr<const HookScanResult> GetHookScan(std::chrono::milliseconds maxAge);
+
+/// @brief Scans on the calling thread and makes the result the one GetHookScan returns, so a detail
+/// view and the column agree.
+std::shared_ptr<const HookScanResult> RescanHooks();
+
+/// @brief Walks the address space once and attributes its committed memory to the sections of every
+/// loaded module. Modules are pinned only while their section tables are read.
+std::shared_ptr<const AddressSpace::Map> MapAddressSpace();
+
+/// @brief The latest MapAddressSpace result for the folder's columns, or null before the first walk
+/// completes. When it is missing or older than maxAge a new walk starts in the background, as
+/// GetHookScan does.
+std::shared_ptr<const AddressSpace::Map> GetAddressSpace(std::chrono::milliseconds maxAge);
+
+/// @brief Walks on the calling thread and makes the result the one GetAddressSpace returns, for a
+/// module's Memory node, which shows the address space as it is when the node is opened.
+std::shared_ptr<const AddressSpace::Map> RemapAddressSpace();
+
+// A code integrity check of every loaded module; like HookScanResult, the image pointers are null.
+struct IntegrityResult {
+    explicit IntegrityResult(std::vector<HookScan::Module> checked, std::vector<CodeIntegrity::ModuleResult> checkResults)
+        : modules(std::move(checked)), results(std::move(checkResults)), index(modules) {}
+
+    std::vector<HookScan::Module> modules;
+    std::vector<CodeIntegrity::ModuleResult> results; // Parallel to modules
+    HookScan::ModuleIndex index;
+};
+
+/// @brief Compares the code of every loaded module with its file on all cores, reading at most
+/// IntegrityIoConcurrency files (default 4) at a time.
+std::shared_ptr<const IntegrityResult> CheckIntegrity();
+
+/// @brief The latest CheckIntegrity result without waiting for one: null until the first completes.
+/// When it is missing or older than maxAge, a check starts on a background thread, and the folder view
+/// is refreshed when it finishes so that the column fills in.
+std::shared_ptr<const IntegrityResult> GetIntegrityCheck(std::chrono::milliseconds maxAge);
+
+// Content hashes of the files behind the loaded modules, by module path.
+struct HashResult {
+    std::unordered_map<std::wstring, FileHash::FileResult> files;
+    uint32_t algorithms = 0;
+};
+
+/// @brief Hashes the file of every loaded module on all cores, reading at most HashIoConcurrency files
+/// (default 2) at a time. SHA-256 and the PE checksum always; SHA-1 as well when the HashSha1 setting is
+/// nonzero. Files unchanged since an earlier pass are not read again.
+std::shared_ptr<const HashResult> HashModuleFiles();
+
+/// @brief The latest HashModuleFiles result without waiting for one, refreshed in the background as
+/// GetIntegrityCheck is.
+std::shared_ptr<const HashResult> GetModuleHashes(std::chrono::milliseconds maxAge);
+
+// Modules loaded more than once, from different paths or in different builds.
+struct DuplicateResult {
+    std::vector<DuplicateScan::Module> modules;
+    DuplicateScan::Report report;                // Parallel to modules
+    std::unordered_map<uint64_t, uint32_t> byBase; // Module index by base address
+};
+
+/// @brief Fingerprints every loaded module from its in-memory headers and groups them with
+/// DuplicateScan::Detect. Only files whose fingerprints collide are read, through the hash cache.
+std::shared_ptr<const DuplicateResult> FindDuplicates();
+
+/// @brief The latest FindDuplicates result without waiting for one, refreshed in the background as
+/// GetIntegrityCheck is. While DuplicatesOnly is on, a result that flags a different set of modules also
+/// refreshes the folder.
+std::shared_ptr<const DuplicateResult> GetDuplicates(std::chrono::milliseconds maxAge);
+
+/// @brief Whether the folder lists only modules FindDuplicates flags. Process-wide, off at startup.
+bool DuplicatesOnly();
+void SetDuplicatesOnly(bool enabled);
+
+// The file behind a loaded module, as the file watcher last found it.
+enum class DiskState : uint8_t {
+    Unchanged, // Not reported changed, or rewritten with the same headers
+    Replaced,  // The file's header fingerprint no longer matches the loaded image
+    Deleted,   // The file can no longer be opened
+};
+
+/// @brief Holds the subsystems folders and their enumerators need: the loader notification, and
+/// through it the refresh pipeline and load timeline. The first holder starts them, so a process that
+/// loads the DLL without browsing the folder pays for nothing beyond the load. The last to let go stops
+/// them; after IdleTrimSeconds (default 60) with no holder, the caches registered with
+/// MemoryBudget::Process are trimmed to IdleTrimLowWaterBytes (default 1 MB).
+std::shared_ptr<void> AcquireSession();
+
+/// @brief For DllCanUnloadNow: true when no session is held and nothing the extension started is still
+/// running. A pending idle trim is told to finish at once, so a later call can succeed.
+bool ReadyToUnload();
+
+/// @brief Adjusts the entry count of the folders' metadata caches, as accounted to the memory budget.
+void AddMetadataEntries(int64_t delta);
+
+/// @brief Re-queries the residency of every loaded module's pages in one batched call. Runs every
+/// WorkingSetRefreshMs (default 5000, 0 for never) while a session is held, once a working-set column
+/// has been read in it, and refreshes the rows of the modules whose counts changed.
+/// Returns the bases of those modules; empty if the query failed.
+std::vector<uint64_t> RefreshWorkingSet();
+
+/// @brief The counts the last refresh found for the module loaded at base; false if it was not
+/// loaded then, or nothing has been queried yet. The first call in a session starts the timer querying.
+bool GetWorkingSet(void* baseAddress, WorkingSet::Counts& counts);
+
+/// @brief Returns the process-wide watcher on the files of the loaded modules, starting it if no one
+/// holds it. It stops when the last holder lets go, so each open folder keeps one. Null when the
+/// WatchModuleFiles setting is 0 or the watcher could not start.
+std::shared_ptr<FileWatcher> AcquireFileWatcher();
+
+/// @brief Points the running watcher, if any, at the files of the modules loaded now. Call after the
+/// module list changes; never under the loader lock.
+void UpdateWatchedFiles();
+
+/// @brief The state recorded for a module file the last time the watcher reported it changed.
+DiskState GetDiskState(const std::wstring& path);
+
+/// @brief Identifies a loaded module's icon by content: reads the first RT_GROUP_ICON of the image in
+/// memory and hashes its images, once per module (memoized by path and base). Returns false if the
+/// module has no usable icon or is no longer loaded at base.
+bool GetModuleIconDigest(const std::wstring& path, void* baseAddress, Sha::Sha256::Digest& digest);
+
+/// @brief The module's icon decoded for drawing at size pixels, from the process-wide icon cache; each
+/// distinct icon is decoded once per size however many modules carry it. Null if there is none.
+std::shared_ptr<const PeIcon::Image> GetModuleIcon(const std::wstring& path, void* baseAddress, uint32_t size);
+
+/// @brief Searches every loaded module image for matcher's patterns on all cores, streaming hits to sink
+/// as SignatureScan::Search does. The modules are pinned only while the search runs, so a sink must copy
+/// what it needs from them. Stops early when cancel (which may be null) becomes true.
+SignatureScan::Stats SearchModules(const SignatureScan::Matcher& matcher, SignatureScan::HitSink sink, void* context,
+    const std::atomic<bool>* cancel);
+
+/// @brief Tells Explorer that the contents of the module folder have changed, so open views re-read them.
+/// @return False if the folder could not be located.
+bool NotifyFolderChanged();
+
+/// @brief Tells Explorer that the details of the modules loaded at bases have changed, one
+/// SHCNE_UPDATEITEM each, so open views repaint those rows without re-reading the folder. Falls back to
+/// NotifyFolderChanged when many modules changed at once.
+/// @return False if the folder could not be located.
+bool NotifyModulesChanged(const std::vector<uint64_t>& bases);
+
 }
@@ -0,0 +1,451 @@
+#include "ModuleTreeFolder.h"
+
+#include "IidNames.h"
+#include "Log.h"
+#include "MemoryBudget.h"
+#include "ModuleFolder.h"
+#include "ModuleHelpers.h"
+#include "Perf.h"
+#include "Pidl.h"
+#include "QiProfiler.h"
+#include "Settings.h"
+
+#include <shlwapi.h>
+#include <functional>
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+constexpr UINT kColumnName = 0;
+
+// Decoded listings kept across all module folders; override with the TreeCacheBytes setting.
+constexpr uint32_t kDefaultTreeCacheBytes = 16 * 1024 * 1024;
+
+ImageTree::Cache& TreeCache() {
+    static ImageTree::Cache cache(Settings::ReadDword(L"TreeCacheBytes", kDefaultTreeCacheBytes));
+    static const bool registered = [] {
+        MemoryBudget::Process().Register(L"Module subtrees", [] { return TreeCache().TotalBytes(); },
+            [](size_t target) { TreeCache().TrimTo(target); });
+        return true;
+    }();
+    (void)registered;
+    return cache;
+}
+
+HRESULT MakeStrRet(const wchar_t* value, STRRET* result) {
+    if (!result) {
+        return E_POINTER;
+    }
+    wchar_t* dup = nullptr;
+    HRESULT hr = SHStrDupW(value, &dup);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    result->uType = STRRET_WSTR;
+    result->pOleStr = dup;
+    return S_OK;
+}
+
+HRESULT MakeCompareResult(int result) {
+    short compare = static_cast<short>(result < 0 ? -1 : (result > 0 ? 1 : 0));
+    return MAKE_HRESULT(SEVERITY_SUCCESS, 0, static_cast<USHORT>(compare));
+}
+
+// The node a node item stands for, or nullopt if the item is not a valid node item.
+std::optional<ImageTree::Node> NodeOf(PCUIDLIST_RELATIVE pidl) {
+    if (!Pidl::IsTreeNodePidl(pidl)) {
+        return std::nullopt;
+    }
+    const auto node = PidlCodec::GetData(pidl)->size;
+    if (node >= ImageTree::kNodeCount) {
+        return std::nullopt;
+    }
+    return static_cast<ImageTree::Node>(node);
+}
+
+// IEnumIDList over count items created on demand, so a node with thousands of entries encodes only the
+// pages Explorer asks for.
+class ItemEnum final
+    : public Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>,
+        IEnumIDList> {
+public:
+    using CreateFn = std::function<PITEMID_CHILD(size_t index)>;
+
+    ItemEnum(size_t count, std::shared_ptr<const CreateFn> create, size_t position = 0)
+        : count_(count), create_(std::move(create)), position_(position) {
+    }
+
+    IFACEMETHODIMP Next(ULONG celt, PITEMID_CHILD* rgelt, ULONG* fetched) override {
+        if (!rgelt || (celt > 1 && !fetched)) {
+            return E_POINTER;
+        }
+        ULONG copied = 0;
+        while (copied < celt && position_ < count_) {
+            PITEMID_CHILD item = (*create_)(position_);
+            if (!item) {
+                break;
+            }
+            rgelt[copied++] = item;
+            ++position_;
+        }
+        if (fetched) {
+            *fetched = copied;
+        }
+        return (copied == celt) ? S_OK : S_FALSE;
+    }
+
+    IFACEMETHODIMP Skip(ULONG celt) override {
+        const size_t skipped = celt < count_ - position_ ? celt : count_ - position_;
+        position_ += skipped;
+        return (skipped == celt) ? S_OK : S_FALSE;
+    }
+
+    IFACEMETHODIMP Reset() override {
+        position_ = 0;
+        return S_OK;
+    }
+
+    IFACEMETHODIMP Clone(IEnumIDList** ppenum) override {
+        if (!ppenum) {
+            return E_POINTER;
+        }
+        auto clone = Microsoft::WRL::Make<ItemEnum>(count_, create_, position_);
+        if (!clone) {
+            return E_OUTOFMEMORY;
+        }
+        return clone.CopyTo(ppenum);
+    }
+
+private:
+    size_t count_;
+    std::shared_ptr<const CreateFn> create_;
+    size_t position_;
+};
+} // namespace
+
+ModuleTreeFolder::ModuleTreeFolder(std::wstring modulePath, uint64_t baseAddress, PCIDLIST_ABSOLUTE folderPidl,
+    std::optional<ImageTree::Node> node)
+    : modulePath_(std::move(modulePath)), baseAddress_(baseAddress), node_(node) {
+    folderPidl_ = folderPidl ? ILCloneFull(folderPidl) : nullptr;
+}
+
+ModuleTreeFolder::~ModuleTreeFolder() {
+    if (folderPidl_) {
+        ILFree(folderPidl_);
+    }
+}
+
+IFACEMETHODIMP ModuleTreeFolder::QueryInterface(REFIID riid, void** ppv) {
+    HRESULT hr = RuntimeClass::QueryInterface(riid, ppv);
+    QiProfiler::Record(QiProfiler::Source::ModuleTreeFolder, IidNames::ToGuid(riid), SUCCEEDED(hr));
+    return hr;
+}
+
+const ImageTree::Listing& ModuleTreeFolder::Listing() {
+    if (!listing_ && *node_ == ImageTree::Node::Memory) {
+        // Live, so never cached; opening the node walks the address space again.
+        const auto map = ModuleHelpers::RemapAddressSpace();
+        // By the item's base, not the path: two copies of a DLL loaded from one path have one handle.
+        const auto* module = map->Find(baseAddress_);
+        listing_ = std::make_shared<const ImageTree::Listing>(module ? AddressSpace::Describe(*module) : ImageTree::Listing{});
+    }
+    if (!listing_) {
+        listing_ = TreeCache().Get(modulePath_, *node_);
+        LOG_INFO(L"{} of {}: {} entries{}", ImageTree::NodeName(*node_), modulePath_, listing_->entries.size(),
+            listing_->truncated ? L" (truncated)" : L"");
+    }
+    return *listing_;
+}
+
+UINT ModuleTreeFolder::ColumnCount() const {
+    return node_ ? static_cast<UINT>(1 + ImageTree::kDetailColumns) : 1;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetClassID(CLSID* classId) {
+    if (!classId) {
+        return E_POINTER;
+    }
+    // A module's subtree is reached only through its parent folder; no CLSID creates one on its own.
+    *classId = CLSID_NULL;
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::Initialize(PCIDLIST_ABSOLUTE pidl) {
+    if (folderPidl_) {
+        ILFree(folderPidl_);
+    }
+    folderPidl_ = pidl ? ILCloneFull(pidl) : nullptr;
+    return (pidl && !folderPidl_) ? E_OUTOFMEMORY : S_OK;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetCurFolder(PIDLIST_ABSOLUTE* pidl) {
+    if (!pidl) {
+        return E_POINTER;
+    }
+    *pidl = nullptr;
+    if (!folderPidl_) {
+        return S_FALSE;
+    }
+    *pidl = ILCloneFull(folderPidl_);
+    return *pidl ? S_OK : E_OUTOFMEMORY;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::ParseDisplayName(HWND, IBindCtx*, LPWSTR, ULONG*, PIDLIST_RELATIVE*, ULONG*) {
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::EnumObjects(HWND, SHCONTF flags, IEnumIDList** enumIdList) {
+    Perf::ScopedTimer timer(Perf::Op::EnumObjects);
+    if (!enumIdList) {
+        return E_POINTER;
+    }
+    *enumIdList = nullptr;
+
+    size_t count = 0;
+    std::shared_ptr<const ItemEnum::CreateFn> create;
+    if (!node_) {
+        // Node items are folders; listing them opens nothing.
+        if (!(flags & SHCONTF_FOLDERS)) {
+            return S_FALSE;
+        }
+        count = ImageTree::kNodeCount;
+        create = std::make_shared<const ItemEnum::CreateFn>([](size_t index) {
+            const auto node = static_cast<ImageTree::Node>(index);
+            return reinterpret_cast<PITEMID_CHILD>(Pidl::CreateTreeNode(static_cast<DWORD>(index), ImageTree::NodeName(node)));
+        });
+    } else {
+        if (!(flags & SHCONTF_NONFOLDERS)) {
+            return S_FALSE;
+        }
+        // Entries are encoded as Explorer pages through them; the enumerator shares the listing so it
+        // outlives an eviction.
+        Listing();
+        count = listing_->entries.size();
+        const auto node = static_cast<DWORD>(*node_);
+        create = std::make_shared<const ItemEnum::CreateFn>([listing = listing_, node](size_t index) {
+            return reinterpret_cast<PITEMID_CHILD>(Pidl::CreateTreeEntry(node, index, listing->entries[index].name));
+        });
+    }
+
+    auto enumerator = Microsoft::WRL::Make<ItemEnum>(count, std::move(create));
+    if (!enumerator) {
+        LOG_ERROR(L"ItemEnum allocation failed");
+        return E_OUTOFMEMORY;
+    }
+    return enumerator.CopyTo(enumIdList);
+}
+
+IFACEMETHODIMP ModuleTreeFolder::BindToObject(PCUIDLIST_RELATIVE pidl, IBindCtx*, REFIID riid, void** ppv) {
+    if (!ppv) {
+        return E_POINTER;
+    }
+    *ppv = nullptr;
+    const auto node = NodeOf(pidl);
+    if (node_ || !node || !ILIsEmpty(ILNext(pidl))) {
+        return E_INVALIDARG;
+    }
+
+    PIDLIST_RELATIVE item = Pidl::Clone(pidl);
+    PIDLIST_ABSOLUTE nodePidl = item ? ILCombine(folderPidl_, item) : nullptr;
+    Pidl::Free(item);
+    if (!nodePidl) {
+        return E_OUTOFMEMORY;
+    }
+    auto folder = Microsoft::WRL::Make<ModuleTreeFolder>(modulePath_, baseAddress_, nodePidl, node);
+    ILFree(nodePidl);
+    if (!folder) {
+        return E_OUTOFMEMORY;
+    }
+    return folder.CopyTo(riid, ppv);
+}
+
+IFACEMETHODIMP ModuleTreeFolder::BindToStorage(PCUIDLIST_RELATIVE, IBindCtx*, REFIID, void** ppv) {
+    if (ppv) {
+        *ppv = nullptr;
+    }
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::CompareIDs(LPARAM lParam, PCUIDLIST_RELATIVE pidl1, PCUIDLIST_RELATIVE pidl2) {
+    Perf::ScopedTimer timer(Perf::Op::CompareIDs);
+    if (!pidl1 || !pidl2) {
+        return E_INVALIDARG;
+    }
+    const auto* data1 = PidlCodec::GetData(pidl1);
+    const auto* data2 = PidlCodec::GetData(pidl2);
+    if (!data1 || !data2 || data1->signature != data2->signature) {
+        return E_INVALIDARG;
+    }
+
+    if (!node_) {
+        // Nodes keep their fixed order; anything below them is compared by the node's own folder.
+        int result = static_cast<int>(data1->size) - static_cast<int>(data2->size);
+        if (result != 0 || ILIsEmpty(ILNext(pidl1)) || ILIsEmpty(ILNext(pidl2))) {
+            if (result == 0) {
+                result = static_cast<int>(!ILIsEmpty(ILNext(pidl1))) - static_cast<int>(!ILIsEmpty(ILNext(pidl2)));
+            }
+            return MakeCompareResult(result);
+        }
+        ComPtr<IShellFolder> child;
+        PIDLIST_RELATIVE first = Pidl::Clone(pidl1);
+        HRESULT hr = first ? BindToObject(first, nullptr, IID_PPV_ARGS(&child)) : E_OUTOFMEMORY;
+        Pidl::Free(first);
+        if (FAILED(hr)) {
+            return hr;
+        }
+        return child->CompareIDs(lParam, ILNext(pidl1), ILNext(pidl2));
+    }
+
+    // Natural order, so "#10" follows "#9" and decimal columns sort by value; ties fall back to the
+    // listing order.
+    const auto column = static_cast<UINT>(lParam & 0xFFFF);
+    int result = 0;
+    if (column == kColumnName) {
+        result = StrCmpLogicalW(PidlCodec::GetPath(pidl1).c_str(), PidlCodec::GetPath(pidl2).c_str());
+    } else if (column < ColumnCount()) {
+        const auto& entries = Listing().entries;
+        if (data1->baseAddress < entries.size() && data2->baseAddress < entries.size()) {
+            result = StrCmpLogicalW(entries[data1->baseAddress].details[column - 1].c_str(),
+                entries[data2->baseAddress].details[column - 1].c_str());
+        }
+    }
+    if (result == 0) {
+        result = data1->baseAddress < data2->baseAddress ? -1 : (data1->baseAddress > data2->baseAddress ? 1 : 0);
+    }
+    return MakeCompareResult(result);
+}
+
+IFACEMETHODIMP ModuleTreeFolder::CreateViewObject(HWND, REFIID riid, void** ppv) {
+    if (!ppv) {
+        return E_POINTER;
+    }
+    *ppv = nullptr;
+    if (!IsEqualIID(riid, IID_IShellView)) {
+        return E_NOINTERFACE;
+    }
+    ComPtr<IShellFolder> shellFolder;
+    HRESULT hr = QueryInterface(IID_PPV_ARGS(&shellFolder));
+    if (FAILED(hr)) {
+        return hr;
+    }
+    SFV_CREATE sfv = {};
+    sfv.cbSize = sizeof(sfv);
+    sfv.pshf = shellFolder.Get();
+    hr = SHCreateShellFolderView(&sfv, reinterpret_cast<IShellView**>(ppv));
+    if (FAILED(hr)) {
+        LOG_ERROR(L"SHCreateShellFolderView (subtree) failed: 0x{:08X}", static_cast<unsigned long>(hr));
+    }
+    return hr;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetAttributesOf(UINT cidl, PCUITEMID_CHILD_ARRAY apidl, SFGAOF* rgfInOut) {
+    if (!rgfInOut) {
+        return E_POINTER;
+    }
+    SFGAOF folderAttrs = SFGAO_FOLDER | SFGAO_BROWSABLE | SFGAO_READONLY;
+    SFGAOF attrs = folderAttrs;
+    for (UINT i = 0; apidl && i < cidl; ++i) {
+        if (!Pidl::IsTreeNodePidl(apidl[i])) {
+            attrs &= SFGAO_READONLY;
+        }
+    }
+    if (*rgfInOut) {
+        *rgfInOut &= attrs;
+    } else {
+        *rgfInOut = attrs;
+    }
+    return S_OK;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetUIObjectOf(HWND, UINT cidl, PCUITEMID_CHILD_ARRAY, REFIID riid, UINT*, void** ppv) {
+    if (!ppv) {
+        return E_POINTER;
+    }
+    *ppv = nullptr;
+    LOG_TRACE(L"ModuleTreeFolder::GetUIObjectOf cidl={} riid={}", cidl, IidNames::ToString(riid));
+    return E_NOINTERFACE;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetDisplayNameOf(PCUITEMID_CHILD pidl, SHGDNF, STRRET* name) {
+    if (!pidl || !name) {
+        return E_INVALIDARG;
+    }
+    if (!Pidl::IsTreeNodePidl(pidl) && !Pidl::IsTreeEntryPidl(pidl)) {
+        return E_INVALIDARG;
+    }
+    return MakeStrRet(PidlCodec::GetPath(pidl).c_str(), name);
+}
+
+IFACEMETHODIMP ModuleTreeFolder::SetNameOf(HWND, PCUITEMID_CHILD, LPCWSTR, SHGDNF, PITEMID_CHILD* newPidl) {
+    if (newPidl) {
+        *newPidl = nullptr;
+    }
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetDefaultSearchGUID(GUID*) {
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::EnumSearches(IEnumExtraSearch**) {
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetDefaultColumn(DWORD, ULONG* sort, ULONG* display) {
+    if (sort) {
+        *sort = kColumnName;
+    }
+    if (display) {
+        *display = kColumnName;
+    }
+    return S_OK;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetDefaultColumnState(UINT column, SHCOLSTATEF* state) {
+    if (!state) {
+        return E_POINTER;
+    }
+    if (column >= ColumnCount()) {
+        return E_INVALIDARG;
+    }
+    *state = SHCOLSTATE_TYPE_STR | SHCOLSTATE_ONBYDEFAULT;
+    return S_OK;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetDetailsEx(PCUITEMID_CHILD, const SHCOLUMNID*, VARIANT*) {
+    return E_NOTIMPL;
+}
+
+IFACEMETHODIMP ModuleTreeFolder::GetDetailsOf(PCUITEMID_CHILD pidl, UINT column, SHELLDETAILS* details) {
+    Perf::ScopedTimer timer(Perf::Op::GetDetailsOf);
+    if (!details) {
+        return E_POINTER;
+    }
+    details->fmt = LVCFMT_LEFT;
+    details->cxChar = column == kColumnName ? 32 : 16;
+
+    if (column >= ColumnCount()) {
+        return E_INVALIDARG;
+    }
+
+    // Header request
+    if (!pidl) {
+        return MakeStrRet(node_ ? ImageTree::ColumnTitle(*node_, column) : L"Name", &details->str);
+    }
+    if (column == kColumnName) {
+        return GetDisplayNameOf(pidl, SHGDN_NORMAL, &details->str);
+    }
+
+    // Detail columns exist only at node level, where items index the listing.
+    if (!Pidl::IsTreeEntryPidl(pidl)) {
+        return E_INVALIDARG;
+    }
+    const auto index = PidlCodec::GetData(pidl)->baseAddress;
+    const auto& entries = Listing().entries;
+    return MakeStrRet(index < entries.size() ? entries[index].details[column - 1].c_str() : L"", &details->str);
+}
+
+IFACEMETHODIMP ModuleTreeFolder::MapColumnToSCID(UINT, SHCOLUMNID*) {
+    // As in ModuleFolder: Explorer falls back to GetDetailsOf.
+    return E_NOTIMPL;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <windows.h>
+#include <shlobj.h>
+#include <wrl.h>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "ImageTree.h"
+
+// The folder behind a module item, and behind each node under it. At module level it lists one folder
+// item per ImageTree node (Sections, Imports, Exports, Resources, Memory) without opening the image; at
+// node level it lists that node's entries, decoding the node on first use through a process-wide
+// ImageTree::Cache bounded by the TreeCacheBytes setting. Memory is the exception: it describes the
+// loaded image, from a fresh ModuleHelpers::GetAddressSpace walk each time the node is opened.
+class ModuleTreeFolder final
+    : public Microsoft::WRL::RuntimeClass<Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::ClassicCom>,
+        IShellFolder,
+        IShellFolder2,
+        IPersistFolder,
+        IPersistFolder2> {
+public:
+    /// @param baseAddress Where the module is loaded, as its item records it.
+    /// @param folderPidl Absolute PIDL of this folder (the module item, or the node item under it). Copied.
+    /// @param node Empty for the module level.
+    ModuleTreeFolder(std::wstring modulePath, uint64_t baseAddress, PCIDLIST_ABSOLUTE folderPidl,
+        std::optional<ImageTree::Node> node);
+    ~ModuleTreeFolder();
+
+    // IUnknown
+    /// @brief Forwards to the WRL implementation and records the request in QiProfiler.
+    IFACEMETHODIMP QueryInterface(REFIID riid, void** ppv) override;
+
+    // IPersist
+    IFACEMETHODIMP GetClassID(CLSID* classId) override;
+
+    // IPersistFolder
+    IFACEMETHODIMP Initialize(PCIDLIST_ABSOLUTE pidl) override;
+
+    // IPersistFolder2
+    IFACEMETHODIMP GetCurFolder(PIDLIST_ABSOLUTE* pidl) override;
+
+    // IShellFolder
+    IFACEMETHODIMP ParseDisplayName(HWND hwnd, IBindCtx* bindCtx, LPWSTR displayName,
+        ULONG* eaten, PIDLIST_RELATIVE* pidl, ULONG* attributes) override;
+    IFACEMETHODIMP EnumObjects(HWND hwnd, SHCONTF flags, IEnumIDList** enumIdList) override;
+    /// @brief Binds to a node folder (module level only); entries are not folders.
+    IFACEMETHODIMP BindToObject(PCUIDLIST_RELATIVE pidl, IBindCtx* bindCtx, REFIID riid, void** ppv) override;
+    IFACEMETHODIMP BindToStorage(PCUIDLIST_RELATIVE pidl, IBindCtx* bindCtx, REFIID riid, void** ppv) override;
+    IFACEMETHODIMP CompareIDs(LPARAM lParam, PCUIDLIST_RELATIVE pidl1, PCUIDLIST_RELATIVE pidl2) override;
+    IFACEMETHODIMP CreateViewObject(HWND hwnd, REFIID riid, void** ppv) override;
+    IFACEMETHODIMP GetAttributesOf(UINT cidl, PCUITEMID_CHILD_ARRAY apidl, SFGAOF* rgfInOut) override;
+    IFACEMETHODIMP GetUIObjectOf(HWND hwnd, UINT cidl, PCUITEMID_CHILD_ARRAY apidl,
+        REFIID riid, UINT* rgfReserved, void** ppv) override;
+    IFACEMETHODIMP GetDisplayNameOf(PCUITEMID_CHILD pidl, SHGDNF flags, STRRET* name) override;
+    IFACEMETHODIMP SetNameOf(HWND hwnd, PCUITEMID_CHILD pidl, LPCWSTR name, SHGDNF flags,
+        PITEMID_CHILD* newPidl) override;
+
+    // IShellFolder2
+    IFACEMETHODIMP GetDefaultSearchGUID(GUID* pguid) override;
+    IFACEMETHODIMP EnumSearches(IEnumExtraSearch** ppenum) override;
+    IFACEMETHODIMP GetDefaultColumn(DWORD reserved, ULONG* sort, ULONG* display) override;
+    IFACEMETHODIMP GetDefaultColumnState(UINT column, SHCOLSTATEF* state) override;
+    IFACEMETHODIMP GetDetailsEx(PCUITEMID_CHILD pidl, const SHCOLUMNID* pscid, VARIANT* pv) override;
+    IFACEMETHODIMP GetDetailsOf(PCUITEMID_CHILD pidl, UINT column, SHELLDETAILS* details) override;
+    IFACEMETHODIMP MapColumnToSCID(UINT column, SHCOLUMNID* pscid) override;
+
+private:
+    /// @brief The node's listing, fetched from the cache on first use and held for this folder's life so
+    /// entry indices stay valid even if the cache evicts it.
+    const ImageTree::Listing& Listing();
+    UINT ColumnCount() const;
+
+    std::wstring modulePath_;
+    uint64_t baseAddress_;
+    PIDLIST_ABSOLUTE folderPidl_ = nullptr;
+    std::optional<ImageTree::Node> node_;
+    std::shared_ptr<const ImageTree::Listing> listing_;
+};
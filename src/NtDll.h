@@ -1,7 +1,32 @@
 #pragma once
 
+#ifdef _WIN32
 #include <windows.h>
 #include <winternl.h>
+#else
+// Just enough of the Windows types for the notification structs to compile elsewhere, so the refresh
+// pipeline and its storm simulator can run on Linux.
+#include <cstdint>
+
+typedef uint32_t ULONG;
+typedef void* PVOID;
+typedef int32_t NTSTATUS;
+#define VOID void
+#define CALLBACK
+#define NTAPI
+#ifndef _In_
+#define _In_
+#define _In_opt_
+#define _Out_
+#endif
+
+typedef struct _UNICODE_STRING {
+    uint16_t Length;        // Bytes, excluding any terminator
+    uint16_t MaximumLength;
+    wchar_t* Buffer;
+} UNICODE_STRING;
+typedef const UNICODE_STRING* PCUNICODE_STRING;
+#endif
 
 // LDR notification definitions
 typedef struct _LDR_DLL_LOADED_NOTIFICATION_DATA {
@@ -0,0 +1,200 @@
+#include "PeChecksum.h"
+
+#include "PeImage.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(EXPLORER_MODULES_X64)
+#include <immintrin.h>
+#endif
+
+namespace PeChecksum {
+namespace {
+
+// Each kernel adds two words into every 32-bit lane per step, at most 0x1FFFE; this many steps cannot
+// overflow a lane, after which the lanes are widened into the 64-bit total.
+constexpr size_t kStepsPerBlock = 16384;
+
+// Two words per 32-bit half of a 64-bit register at a time.
+uint64_t SumWordsScalar(const uint8_t* data, size_t size) {
+    constexpr uint64_t kLowWords = 0x0000FFFF0000FFFFull;
+    uint64_t total = 0;
+    while (size >= 8) {
+        const size_t steps = std::min(size / 8, kStepsPerBlock);
+        uint64_t lanes = 0;
+        for (size_t i = 0; i < steps; ++i, data += 8) {
+            uint64_t value = 0;
+            std::memcpy(&value, data, sizeof(value));
+            lanes += (value & kLowWords) + (value >> 16 & kLowWords);
+        }
+        total += (lanes & 0xFFFFFFFFu) + (lanes >> 32);
+        size -= steps * 8;
+    }
+    for (; size >= 2; size -= 2, data += 2) {
+        total += PeImage::ReadAt<uint16_t>(data, 0);
+    }
+    return total;
+}
+
+#if defined(EXPLORER_MODULES_X64)
+uint64_t SumWordsSse2(const uint8_t* data, size_t size) {
+    const __m128i lowWords = _mm_set1_epi32(0xFFFF);
+    uint64_t total = 0;
+    while (size >= 32) {
+        const size_t steps = std::min(size / 32, kStepsPerBlock);
+        __m128i a = _mm_setzero_si128();
+        __m128i b = _mm_setzero_si128();
+        for (size_t i = 0; i < steps; ++i, data += 32) {
+            const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+            a = _mm_add_epi32(a, _mm_add_epi32(_mm_and_si128(v0, lowWords), _mm_srli_epi32(v0, 16)));
+            b = _mm_add_epi32(b, _mm_add_epi32(_mm_and_si128(v1, lowWords), _mm_srli_epi32(v1, 16)));
+        }
+        uint32_t lanes[8];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), a);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + 4), b);
+        for (uint32_t lane : lanes) {
+            total += lane;
+        }
+        size -= steps * 32;
+    }
+    return total + SumWordsScalar(data, size);
+}
+
+EXPLORER_MODULES_TARGET_AVX2
+uint64_t SumWordsAvx2(const uint8_t* data, size_t size) {
+    const __m256i lowWords = _mm256_set1_epi32(0xFFFF);
+    uint64_t total = 0;
+    while (size >= 64) {
+        const size_t steps = std::min(size / 64, kStepsPerBlock);
+        __m256i a = _mm256_setzero_si256();
+        __m256i b = _mm256_setzero_si256();
+        for (size_t i = 0; i < steps; ++i, data += 64) {
+            const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32));
+            a = _mm256_add_epi32(a, _mm256_add_epi32(_mm256_and_si256(v0, lowWords), _mm256_srli_epi32(v0, 16)));
+            b = _mm256_add_epi32(b, _mm256_add_epi32(_mm256_and_si256(v1, lowWords), _mm256_srli_epi32(v1, 16)));
+        }
+        uint32_t lanes[16];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), a);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + 8), b);
+        for (uint32_t lane : lanes) {
+            total += lane;
+        }
+        size -= steps * 64;
+    }
+    return total + SumWordsSse2(data, size);
+}
+#endif
+
+// Folds a sum of words to 16 bits with end-around carry, which is what adding them one at a time and
+// folding after each add produces.
+uint32_t Fold(uint64_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return static_cast<uint32_t>(sum);
+}
+
+// Takes the stored CheckSum's two words back out of the folded sum, borrowing as CheckSumMappedFile
+// does, so the result matches it bit for bit even where ones' complement has two zeros.
+uint32_t Finalize(uint64_t sum, uint32_t stored, uint64_t length) {
+    uint32_t folded = Fold(sum);
+    for (const uint32_t word : { stored & 0xFFFF, stored >> 16 }) {
+        folded = folded >= word ? folded - word : ((folded - word) & 0xFFFF) - 1;
+    }
+    return folded + static_cast<uint32_t>(length);
+}
+
+} // namespace
+
+uint64_t SumWords(const uint8_t* data, size_t size, Simd::Level level) {
+#if defined(EXPLORER_MODULES_X64)
+    if (level == Simd::Level::Avx2) {
+        return SumWordsAvx2(data, size);
+    }
+    if (level == Simd::Level::Sse2) {
+        return SumWordsSse2(data, size);
+    }
+#else
+    (void)level;
+#endif
+    return SumWordsScalar(data, size);
+}
+
+void Accumulator::Update(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    length_ += size;
+    if (pending_ >= 0) {
+        sum_ += static_cast<uint32_t>(pending_) | uint32_t{ data[0] } << 8;
+        pending_ = -1;
+        ++data;
+        --size;
+    }
+    sum_ += SumWords(data, size & ~size_t{ 1 }, level_);
+    if (size & 1) {
+        pending_ = data[size - 1];
+    }
+}
+
+uint32_t Accumulator::Finish(uint32_t stored) const {
+    // An odd final byte counts as a word with a zero high byte.
+    return Finalize(sum_ + static_cast<uint32_t>(std::max(pending_, 0)), stored, length_);
+}
+
+bool ReadStored(const uint8_t* data, size_t size, uint32_t& stored) {
+    const PeImage::View view(data, size);
+    if (!view.IsValid() || view.ChecksumOffset() + sizeof(uint32_t) > size) {
+        return false;
+    }
+    stored = view.Checksum();
+    return true;
+}
+
+Result Compare(uint32_t stored, uint32_t computed) {
+    Result result;
+    result.stored = stored;
+    result.computed = computed;
+    if (stored == 0) {
+        result.status = Status::NotSet;
+    } else {
+        result.status = stored == computed ? Status::Ok : Status::Mismatch;
+    }
+    return result;
+}
+
+Result Verify(const uint8_t* data, size_t size, Simd::Level level) {
+    uint32_t stored = 0;
+    if (!ReadStored(data, size, stored)) {
+        return {};
+    }
+    Accumulator accumulator(level);
+    accumulator.Update(data, size);
+    return Compare(stored, accumulator.Finish(stored));
+}
+
+uint32_t Compute(const uint8_t* data, size_t size, Simd::Level level) {
+    uint32_t stored = 0;
+    ReadStored(data, size, stored);
+    Accumulator accumulator(level);
+    accumulator.Update(data, size);
+    return accumulator.Finish(stored);
+}
+
+const wchar_t* Summary(const Result& result) {
+    switch (result.status) {
+    case Status::Ok:
+        return L"OK";
+    case Status::Mismatch:
+        return L"Mismatch";
+    case Status::NotSet:
+        return L"Not set";
+    default:
+        return L"";
+    }
+}
+
+} // namespace PeChecksum
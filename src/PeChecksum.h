@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Simd.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// The PE optional header's CheckSum, as link /release and imagehlp's CheckSumMappedFile compute it: the
+// file summed as little-endian 16-bit words with end-around carry, the stored CheckSum field taken back
+// out, plus the file length. Drivers and boot-critical DLLs must carry a correct one; for any other
+// module a mismatch means the file was altered or damaged after it was linked.
+//
+// The words are added into 32-bit lanes of a vector register and folded to 16 bits once at the end, so
+// the kernel runs at memory speed. An Accumulator takes the file in pieces, so the checksum can be
+// computed from the same sequential read that hashes the file.
+namespace PeChecksum {
+
+enum class Status : uint8_t {
+    NotChecked, // Not a PE file, or the headers did not fit in the first piece read
+    Ok,
+    Mismatch,
+    NotSet,     // The CheckSum field is zero, which the linker writes unless asked not to
+};
+
+struct Result {
+    Status status = Status::NotChecked;
+    uint32_t stored = 0;
+    uint32_t computed = 0;
+};
+
+/// @brief Sum of the little-endian 16-bit words of an even-sized buffer, without folding.
+uint64_t SumWords(const uint8_t* data, size_t size, Simd::Level level = Simd::Active());
+
+// Computes the checksum over a file supplied front to back in pieces of any size.
+class Accumulator {
+public:
+    explicit Accumulator(Simd::Level level = Simd::Active()) : level_(level) {}
+
+    void Update(const uint8_t* data, size_t size);
+
+    /// @brief The checksum of everything passed to Update, for a file whose CheckSum field holds stored.
+    uint32_t Finish(uint32_t stored) const;
+
+private:
+    uint64_t sum_ = 0;
+    uint64_t length_ = 0;
+    int pending_ = -1; // The first byte of a word split across two pieces
+    Simd::Level level_;
+};
+
+/// @brief Finds the CheckSum field in the headers at the start of a file. Returns false if they do not
+/// parse within size bytes.
+bool ReadStored(const uint8_t* data, size_t size, uint32_t& stored);
+
+/// @brief Compares the stored CheckSum with computed.
+Result Compare(uint32_t stored, uint32_t computed);
+
+/// @brief Checks a whole file held in memory.
+Result Verify(const uint8_t* data, size_t size, Simd::Level level = Simd::Active());
+
+/// @brief The checksum a whole file in memory should carry, whatever its CheckSum field holds now.
+uint32_t Compute(const uint8_t* data, size_t size, Simd::Level level = Simd::Active());
+
+/// @brief Column text: "OK", "Mismatch", "Not set", or empty when not checked.
+const wchar_t* Summary(const Result& result);
+
+} // namespace PeChecksum
@@ -0,0 +1,241 @@
+#include "PeIcon.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <tuple>
+
+namespace PeIcon {
+namespace {
+
+using PeImage::ReadAt;
+
+constexpr size_t kGroupHeaderSize = 6;
+constexpr size_t kGroupEntrySize = 14;
+constexpr size_t kBitmapInfoHeaderSize = 40;
+constexpr uint32_t kMaxDimension = 256;
+// Real groups list a dozen images at most; the cap bounds the work a malformed directory can cause.
+constexpr uint32_t kMaxEntries = 64;
+
+constexpr uint8_t kPngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+} // namespace
+
+const uint8_t* FindIcon(const PeImage::View& view, uint16_t id, size_t& length) {
+    return PeImage::FindResourceData(view, kResourceTypeIcon, id, length);
+}
+
+bool ReadGroup(const PeImage::View& view, Group& group) {
+    group.entries.clear();
+    size_t length = 0;
+    const uint8_t* directory = PeImage::FindResourceData(view, kResourceTypeGroupIcon, -1, length);
+    if (!directory || length < kGroupHeaderSize || ReadAt<uint16_t>(directory, 0) != 0 ||
+        ReadAt<uint16_t>(directory, 2) != 1) {
+        return false;
+    }
+    const uint32_t count = std::min<uint32_t>(ReadAt<uint16_t>(directory, 4), kMaxEntries);
+    Sha::Sha256 hash;
+    for (uint32_t i = 0; i < count; ++i) {
+        const size_t offset = kGroupHeaderSize + static_cast<size_t>(i) * kGroupEntrySize;
+        if (offset + kGroupEntrySize > length) {
+            break;
+        }
+        Entry entry;
+        entry.width = directory[offset] ? directory[offset] : kMaxDimension;
+        entry.height = directory[offset + 1] ? directory[offset + 1] : kMaxDimension;
+        entry.bitCount = ReadAt<uint16_t>(directory, offset + 6);
+        entry.bytes = ReadAt<uint32_t>(directory, offset + 8);
+        entry.id = ReadAt<uint16_t>(directory, offset + 12);
+        size_t iconLength = 0;
+        const uint8_t* icon = FindIcon(view, entry.id, iconLength);
+        if (!icon) {
+            continue;
+        }
+        // Each image's length goes in first, so the digest also fixes where one ends and the next begins.
+        const auto size = static_cast<uint32_t>(iconLength);
+        hash.Update(&size, sizeof(size));
+        hash.Update(icon, iconLength);
+        group.entries.push_back(entry);
+    }
+    if (group.entries.empty()) {
+        return false;
+    }
+    group.digest = hash.Final();
+    return true;
+}
+
+bool Decode(const uint8_t* data, size_t length, Image& image) {
+    if (length >= sizeof(kPngSignature) && std::memcmp(data, kPngSignature, sizeof(kPngSignature)) == 0) {
+        return false;
+    }
+    if (length < kBitmapInfoHeaderSize) {
+        return false;
+    }
+    const uint32_t headerSize = ReadAt<uint32_t>(data, 0);
+    const int32_t width = ReadAt<int32_t>(data, 4);
+    const int32_t doubleHeight = ReadAt<int32_t>(data, 8); // The XOR bitmap and the AND mask
+    const uint16_t bitCount = ReadAt<uint16_t>(data, 14);
+    const uint32_t compression = ReadAt<uint32_t>(data, 16);
+    const uint32_t colorsUsed = ReadAt<uint32_t>(data, 32);
+    if (headerSize < kBitmapInfoHeaderSize || headerSize > length || width <= 0 ||
+        static_cast<uint32_t>(width) > kMaxDimension || doubleHeight < 2 ||
+        static_cast<uint32_t>(doubleHeight) / 2 > kMaxDimension || compression != 0) {
+        return false;
+    }
+    if (bitCount != 1 && bitCount != 4 && bitCount != 8 && bitCount != 24 && bitCount != 32) {
+        return false;
+    }
+    const auto w = static_cast<uint32_t>(width);
+    const auto h = static_cast<uint32_t>(doubleHeight) / 2;
+    const uint32_t paletteSize = bitCount > 8 ? 0 : (colorsUsed ? std::min(colorsUsed, 1u << bitCount) : 1u << bitCount);
+    const size_t paletteOffset = headerSize;
+    const size_t xorOffset = paletteOffset + size_t{ paletteSize } * 4;
+    const size_t xorStride = (size_t{ w } * bitCount + 31) / 32 * 4;
+    const size_t andOffset = xorOffset + xorStride * h;
+    const size_t andStride = (size_t{ w } + 31) / 32 * 4;
+    if (andOffset > length) {
+        return false;
+    }
+    const bool haveMask = andOffset + andStride * h <= length;
+
+    // Indices past the palette draw black.
+    uint32_t palette[256];
+    std::fill(std::begin(palette), std::end(palette), 0xFF000000u);
+    for (uint32_t i = 0; i < paletteSize; ++i) {
+        palette[i] |= ReadAt<uint32_t>(data, paletteOffset + size_t{ i } * 4) & 0x00FFFFFFu;
+    }
+
+    image.width = w;
+    image.height = h;
+    image.pixels.resize(size_t{ w } * h);
+    bool anyAlpha = false;
+    for (uint32_t y = 0; y < h; ++y) {
+        // DIB rows run bottom-up.
+        const uint8_t* row = data + xorOffset + (h - 1 - y) * xorStride;
+        uint32_t* out = image.pixels.data() + size_t{ y } * w;
+        switch (bitCount) {
+        case 32:
+            std::memcpy(out, row, size_t{ w } * 4);
+            for (uint32_t x = 0; x < w; ++x) {
+                anyAlpha |= (out[x] >> 24) != 0;
+            }
+            break;
+        case 24:
+            for (uint32_t x = 0; x < w; ++x) {
+                const uint8_t* bgr = row + size_t{ x } * 3;
+                out[x] = 0xFF000000u | uint32_t{ bgr[2] } << 16 | uint32_t{ bgr[1] } << 8 | bgr[0];
+            }
+            break;
+        case 8:
+            for (uint32_t x = 0; x < w; ++x) {
+                out[x] = palette[row[x]];
+            }
+            break;
+        default: {
+            const uint32_t perByte = 8 / bitCount;
+            const uint32_t mask = (1u << bitCount) - 1;
+            for (uint32_t x = 0; x < w; ++x) {
+                const uint32_t shift = 8 - bitCount * (x % perByte + 1);
+                out[x] = palette[row[x / perByte] >> shift & mask];
+            }
+            break;
+        }
+        }
+    }
+
+    // Images with an alpha channel ignore the mask; for the rest it is the only transparency.
+    if (bitCount == 32 && anyAlpha) {
+        return true;
+    }
+    for (uint32_t y = 0; y < h; ++y) {
+        const uint8_t* row = data + andOffset + (h - 1 - y) * andStride;
+        uint32_t* out = image.pixels.data() + size_t{ y } * w;
+        for (uint32_t x = 0; x < w; ++x) {
+            const bool transparent = haveMask && (row[x / 8] >> (7 - x % 8) & 1);
+            out[x] = transparent ? 0 : (out[x] | 0xFF000000u);
+        }
+    }
+    return true;
+}
+
+std::vector<size_t> Preference(const Group& group, uint32_t size) {
+    std::vector<size_t> order(group.entries.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    auto rank = [&group, size](size_t index) {
+        const Entry& entry = group.entries[index];
+        const int tier = entry.width == size ? 0 : (entry.width > size ? 1 : 2);
+        const int64_t distance = tier == 1 ? int64_t{ entry.width } : -int64_t{ entry.width };
+        return std::make_tuple(tier, distance, -int{ entry.bitCount }, index);
+    };
+    std::sort(order.begin(), order.end(), [&rank](size_t left, size_t right) { return rank(left) < rank(right); });
+    return order;
+}
+
+bool Load(const PeImage::View& view, const Group& group, uint32_t size, Image& image) {
+    for (size_t index : Preference(group, size)) {
+        size_t length = 0;
+        const uint8_t* data = FindIcon(view, group.entries[index].id, length);
+        if (data && Decode(data, length, image)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Cache::KeyHash::operator()(const Key& key) const {
+    // The digest is already uniformly distributed.
+    uint64_t hash = 0;
+    std::memcpy(&hash, key.digest.data(), sizeof(hash));
+    return static_cast<size_t>(hash ^ key.size * 0x9E3779B97F4A7C15ull);
+}
+
+std::shared_ptr<const Image> Cache::Find(const Sha::Sha256::Digest& digest, uint32_t size) {
+    std::lock_guard lock(mutex_);
+    if (auto* image = images_.Find({ digest, size })) {
+        ++hits_;
+        return *image;
+    }
+    ++misses_;
+    return nullptr;
+}
+
+std::shared_ptr<const Image> Cache::Store(const Sha::Sha256::Digest& digest, uint32_t size, Image image) {
+    const size_t cost = image.pixels.size() * sizeof(uint32_t);
+    auto shared = std::make_shared<const Image>(std::move(image));
+    std::lock_guard lock(mutex_);
+    images_.Insert({ digest, size }, shared, cost);
+    return shared;
+}
+
+Cache::Stats Cache::GetStats() const {
+    std::lock_guard lock(mutex_);
+    return { hits_, misses_, images_.Size(), images_.TotalCost() };
+}
+
+void Cache::TrimTo(size_t bytes) {
+    std::lock_guard lock(mutex_);
+    if (bytes == 0) {
+        images_.Clear();
+    } else {
+        images_.TrimTo(bytes);
+    }
+}
+
+std::shared_ptr<const Image> Get(const PeImage::View& view, uint32_t size, Cache& cache) {
+    Group group;
+    if (!ReadGroup(view, group)) {
+        return nullptr;
+    }
+    if (auto cached = cache.Find(group.digest, size)) {
+        return cached;
+    }
+    Image image;
+    if (!Load(view, group, size, image)) {
+        return nullptr;
+    }
+    return cache.Store(group.digest, size, std::move(image));
+}
+
+} // namespace PeIcon
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "LruCache.h"
+#include "PeImage.h"
+#include "Sha.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Module icons, read straight from an image's resources: the first RT_GROUP_ICON names the RT_ICON
+// images drawn at each size, and the best one for a requested size is decoded from its DIB into 32-bit
+// pixels. Like PeImage, every offset is bounds-checked, so a malformed icon is simply "no icon".
+//
+// Most system DLLs carry one of a handful of icons, so icons are identified by content: a group's
+// digest is the SHA-256 of all its images' bytes, whichever module they came from. The Cache holds
+// decoded pixels by digest and size, so each distinct icon is decoded once per size and redrawing a
+// view only copies pixels.
+namespace PeIcon {
+
+constexpr uint32_t kResourceTypeIcon = 3;       // RT_ICON
+constexpr uint32_t kResourceTypeGroupIcon = 14; // RT_GROUP_ICON
+
+// One GRPICONDIRENTRY.
+struct Entry {
+    uint32_t width = 0; // 256 when the directory says 0
+    uint32_t height = 0;
+    uint16_t bitCount = 0;
+    uint32_t bytes = 0;
+    uint16_t id = 0; // RT_ICON resource id
+};
+
+struct Group {
+    std::vector<Entry> entries;
+    Sha::Sha256::Digest digest{}; // Of every listed image's bytes, in directory order
+};
+
+/// @brief Reads the first RT_GROUP_ICON (any name, any language) and hashes its images. Returns false
+/// if the image has no icon group or none of its images can be found.
+bool ReadGroup(const PeImage::View& view, Group& group);
+
+/// @brief The bytes of the RT_ICON resource with this id (any language), or nullptr.
+const uint8_t* FindIcon(const PeImage::View& view, uint16_t id, size_t& length);
+
+// Decoded pixels, top row first, each 0xAARRGGBB (BGRA in memory) with straight alpha.
+struct Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint32_t> pixels;
+};
+
+/// @brief Decodes an RT_ICON image stored as a DIB (BITMAPINFOHEADER, palette, XOR bitmap, AND mask)
+/// at 1, 4, 8, 24 or 32 bits per pixel. Returns false for PNG-compressed images and anything
+/// malformed. 32-bit images with no alpha at all take their transparency from the AND mask.
+bool Decode(const uint8_t* data, size_t length, Image& image);
+
+/// @brief Entry indices of group in the order they should be tried for drawing at size pixels: the
+/// exact size first (deepest colour first), then larger sizes from the smallest up, then smaller ones
+/// from the largest down.
+std::vector<size_t> Preference(const Group& group, uint32_t size);
+
+/// @brief Decodes the first image of group, in Preference order, that decodes.
+bool Load(const PeImage::View& view, const Group& group, uint32_t size, Image& image);
+
+// Decoded icons by content digest and requested size, bounded by pixel bytes. Thread-safe.
+class Cache {
+public:
+    static constexpr size_t kDefaultBudget = 8 << 20;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t images;
+        size_t bytes;
+    };
+
+    explicit Cache(size_t budget = kDefaultBudget) : images_(budget) {}
+
+    std::shared_ptr<const Image> Find(const Sha::Sha256::Digest& digest, uint32_t size);
+
+    /// @brief Stores image, replacing any entry for the same digest and size, and returns it shared.
+    std::shared_ptr<const Image> Store(const Sha::Sha256::Digest& digest, uint32_t size, Image image);
+
+    Stats GetStats() const;
+
+    /// @brief Drops the least recently used images until at most bytes of pixels are held. Images
+    /// already handed out stay valid.
+    void TrimTo(size_t bytes);
+
+private:
+    struct Key {
+        Sha::Sha256::Digest digest;
+        uint32_t size;
+
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    mutable std::mutex mutex_;
+    LruCache<Key, std::shared_ptr<const Image>, KeyHash> images_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+/// @brief The icon of an image at size pixels through cache: reads the group and, unless its digest
+/// and size are cached, decodes and stores it. Null if the image has no usable icon.
+std::shared_ptr<const Image> Get(const PeImage::View& view, uint32_t size, Cache& cache);
+
+} // namespace PeIcon
@@ -0,0 +1,406 @@
+#include "PeImage.h"
+
+#include "Diagnostics.h"
+#include "Perf.h"
+#include "Platform.h"
+
+#include <cstdio>
+#include <cwchar>
+#include <iterator>
+
+namespace PeImage {
+namespace {
+
+constexpr uint16_t kDosSignature = 0x5A4D; // 'MZ'
+constexpr uint32_t kNtSignature = 0x00004550; // 'PE\0\0'
+constexpr size_t kDosHeaderSize = 0x40;
+constexpr size_t kFileHeaderSize = 20;
+constexpr size_t kSectionHeaderSize = 40;
+constexpr uint32_t kFixedFileInfoSignature = 0xFEEF04BD;
+constexpr size_t kFixedFileInfoSize = 52;
+
+// VS_VERSIONINFO-style blocks (VS_VERSIONINFO, StringFileInfo, StringTable, String, VarFileInfo, Var).
+struct Block {
+    size_t start;
+    size_t end;
+    uint16_t valueLength;
+    uint16_t type;
+    size_t keyOffset;
+    size_t keyChars;
+    size_t valueOffset;
+    size_t childrenOffset;
+};
+
+constexpr size_t Align4(size_t offset) {
+    return (offset + 3) & ~static_cast<size_t>(3);
+}
+
+bool ReadBlock(const uint8_t* data, size_t limit, size_t offset, Block& block) {
+    if (offset + 6 > limit) {
+        return false;
+    }
+    const uint16_t length = ReadAt<uint16_t>(data, offset);
+    if (length < 6 || offset + length > limit) {
+        return false;
+    }
+    block.start = offset;
+    block.end = offset + length;
+    block.valueLength = ReadAt<uint16_t>(data, offset + 2);
+    block.type = ReadAt<uint16_t>(data, offset + 4);
+    block.keyOffset = offset + 6;
+
+    size_t pos = block.keyOffset;
+    while (pos + 2 <= block.end && ReadAt<uint16_t>(data, pos) != 0) {
+        pos += 2;
+    }
+    block.keyChars = (pos - block.keyOffset) / 2;
+    pos = Align4(pos + 2);
+    block.valueOffset = pos < block.end ? pos : block.end;
+
+    const size_t valueBytes = block.type == 1 ? block.valueLength * size_t{ 2 } : block.valueLength;
+    const size_t children = Align4(block.valueOffset + valueBytes);
+    block.childrenOffset = children < block.end ? children : block.end;
+    return true;
+}
+
+bool KeyEquals(const uint8_t* data, const Block& block, const char* ascii) {
+    size_t i = 0;
+    for (; ascii[i] != '\0'; ++i) {
+        if (i >= block.keyChars) {
+            return false;
+        }
+        uint16_t ch = ReadAt<uint16_t>(data, block.keyOffset + i * 2);
+        char expected = ascii[i];
+        if (ch >= 'A' && ch <= 'Z') {
+            ch = static_cast<uint16_t>(ch - 'A' + 'a');
+        }
+        if (expected >= 'A' && expected <= 'Z') {
+            expected = static_cast<char>(expected - 'A' + 'a');
+        }
+        if (ch != static_cast<uint8_t>(expected)) {
+            return false;
+        }
+    }
+    return i == block.keyChars;
+}
+
+// Appends UTF-16LE text, stopping at a NUL or after count code units. wchar_t is UTF-16 on Windows and
+// UTF-32 elsewhere, where surrogate pairs are combined.
+void AppendUtf16(std::wstring& out, const uint8_t* data, size_t offset, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint16_t unit = ReadAt<uint16_t>(data, offset + i * 2);
+        if (unit == 0) {
+            break;
+        }
+        if constexpr (sizeof(wchar_t) == 4) {
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 1 < count) {
+                const uint16_t low = ReadAt<uint16_t>(data, offset + (i + 1) * 2);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    out += static_cast<wchar_t>(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00));
+                    ++i;
+                    continue;
+                }
+            }
+        }
+        out += static_cast<wchar_t>(unit);
+    }
+}
+
+// Walks one level of the resource directory. Returns the entry's OffsetToData, or 0 if not found.
+// id < 0 takes the first entry.
+uint32_t FindResourceEntry(const uint8_t* rsrc, size_t size, size_t directory, int64_t id) {
+    if (directory + 16 > size) {
+        return 0;
+    }
+    const uint32_t named = ReadAt<uint16_t>(rsrc, directory + 12);
+    const uint32_t ids = ReadAt<uint16_t>(rsrc, directory + 14);
+    for (uint32_t i = 0; i < named + ids; ++i) {
+        const size_t entry = directory + 16 + static_cast<size_t>(i) * 8;
+        if (entry + 8 > size) {
+            return 0;
+        }
+        const uint32_t name = ReadAt<uint32_t>(rsrc, entry);
+        if (id < 0 || (i >= named && !(name & 0x80000000u) && name == static_cast<uint32_t>(id))) {
+            return ReadAt<uint32_t>(rsrc, entry + 4);
+        }
+    }
+    return 0;
+}
+
+void ReadVersionStrings(const View& view, ImageInfo& info) {
+    size_t length = 0;
+    const uint8_t* data = FindResourceData(view, kResourceTypeVersion, -1, length);
+    Block root = {};
+    if (!data || !ReadBlock(data, length, 0, root) || !KeyEquals(data, root, "VS_VERSION_INFO")) {
+        return;
+    }
+    if (root.valueLength >= kFixedFileInfoSize && root.valueOffset + kFixedFileInfoSize <= root.end &&
+        ReadAt<uint32_t>(data, root.valueOffset) == kFixedFileInfoSignature) {
+        info.fileVersionNumber = (static_cast<uint64_t>(ReadAt<uint32_t>(data, root.valueOffset + 8)) << 32) |
+            ReadAt<uint32_t>(data, root.valueOffset + 12);
+    }
+
+    // Collect translations and string tables in one pass, then resolve in translation order.
+    constexpr size_t kMaxTables = 16;
+    Block tables[kMaxTables] = {};
+    size_t tableCount = 0;
+    uint32_t translations[kMaxTables] = {};
+    size_t translationCount = 0;
+
+    Block child = {};
+    for (size_t pos = root.childrenOffset; pos < root.end && ReadBlock(data, root.end, pos, child); pos = Align4(child.end)) {
+        Block grandchild = {};
+        if (KeyEquals(data, child, "StringFileInfo")) {
+            for (size_t p = child.childrenOffset; p < child.end && tableCount < kMaxTables &&
+                 ReadBlock(data, child.end, p, grandchild); p = Align4(grandchild.end)) {
+                tables[tableCount++] = grandchild;
+            }
+        } else if (KeyEquals(data, child, "VarFileInfo")) {
+            for (size_t p = child.childrenOffset; p < child.end && ReadBlock(data, child.end, p, grandchild);
+                 p = Align4(grandchild.end)) {
+                if (!KeyEquals(data, grandchild, "Translation")) {
+                    continue;
+                }
+                for (size_t v = grandchild.valueOffset;
+                     v + 4 <= grandchild.valueOffset + grandchild.valueLength && v + 4 <= grandchild.end &&
+                     translationCount < kMaxTables;
+                     v += 4) {
+                    translations[translationCount++] = ReadAt<uint32_t>(data, v);
+                }
+            }
+        }
+    }
+
+    for (size_t t = 0; t < translationCount; ++t) {
+        char key[9] = {};
+        const auto language = static_cast<unsigned>(translations[t] & 0xFFFF);
+        const auto codePage = static_cast<unsigned>(translations[t] >> 16);
+        std::snprintf(key, sizeof(key), "%04x%04x", language, codePage);
+        for (size_t i = 0; i < tableCount; ++i) {
+            if (!KeyEquals(data, tables[i], key)) {
+                continue;
+            }
+            Block entry = {};
+            for (size_t p = tables[i].childrenOffset; p < tables[i].end && ReadBlock(data, tables[i].end, p, entry);
+                 p = Align4(entry.end)) {
+                std::wstring* target = nullptr;
+                if (KeyEquals(data, entry, "CompanyName")) {
+                    target = &info.companyName;
+                } else if (KeyEquals(data, entry, "FileVersion")) {
+                    target = &info.fileVersion;
+                } else if (KeyEquals(data, entry, "FileDescription")) {
+                    target = &info.description;
+                }
+                if (target) {
+                    target->clear();
+                    AppendUtf16(*target, data, entry.valueOffset, (entry.end - entry.valueOffset) / 2);
+                }
+            }
+            break;
+        }
+        if (!info.companyName.empty() || !info.fileVersion.empty() || !info.description.empty()) {
+            break;
+        }
+    }
+}
+
+} // namespace
+
+View::View(const uint8_t* data, size_t size, Layout layout) : data_(data), size_(size), layout_(layout) {
+    if (!data_ || size_ < kDosHeaderSize || ReadAt<uint16_t>(data_, 0) != kDosSignature) {
+        return;
+    }
+    const uint32_t ntOffset = ReadAt<uint32_t>(data_, 0x3C);
+    if (ntOffset == 0 || static_cast<uint64_t>(ntOffset) + 4 + kFileHeaderSize + 2 > size_ ||
+        ReadAt<uint32_t>(data_, ntOffset) != kNtSignature) {
+        return;
+    }
+    const size_t fileHeader = ntOffset + 4;
+    machine_ = ReadAt<uint16_t>(data_, fileHeader);
+    sectionCount_ = ReadAt<uint16_t>(data_, fileHeader + 2);
+    timeDateStamp_ = ReadAt<uint32_t>(data_, fileHeader + 4);
+    const uint16_t optionalSize = ReadAt<uint16_t>(data_, fileHeader + 16);
+    const size_t optional = fileHeader + kFileHeaderSize;
+    if (optional + optionalSize > size_) {
+        return;
+    }
+    optionalMagic_ = ReadAt<uint16_t>(data_, optional);
+
+    size_t directoryStart = 0;
+    size_t countOffset = 0;
+    if (optionalMagic_ == kOptionalMagicPe32) {
+        if (optionalSize < 96) {
+            return;
+        }
+        imageBase_ = ReadAt<uint32_t>(data_, optional + 28);
+        countOffset = 92;
+        directoryStart = 96;
+    } else if (optionalMagic_ == kOptionalMagicPe32Plus) {
+        if (optionalSize < 112) {
+            return;
+        }
+        imageBase_ = ReadAt<uint64_t>(data_, optional + 24);
+        countOffset = 108;
+        directoryStart = 112;
+    } else {
+        return;
+    }
+    dllCharacteristics_ = ReadAt<uint16_t>(data_, optional + 70);
+    sizeOfImage_ = ReadAt<uint32_t>(data_, optional + 56);
+    sizeOfHeaders_ = ReadAt<uint32_t>(data_, optional + 60);
+    checksumOffset_ = optional + 64;
+
+    const uint32_t declared = ReadAt<uint32_t>(data_, optional + countOffset);
+    const size_t fits = (optionalSize - directoryStart) / 8;
+    directoryCount_ = static_cast<uint32_t>(declared < fits ? declared : fits);
+    if (directoryCount_ > kDirectoryCount) {
+        directoryCount_ = kDirectoryCount;
+    }
+    directoriesOffset_ = optional + directoryStart;
+
+    sectionTableOffset_ = optional + optionalSize;
+    if (sectionTableOffset_ + static_cast<uint64_t>(sectionCount_) * kSectionHeaderSize > size_) {
+        return;
+    }
+    valid_ = true;
+}
+
+Section View::SectionAt(uint32_t index) const {
+    Section section = {};
+    if (!valid_ || index >= sectionCount_) {
+        return section;
+    }
+    const size_t offset = sectionTableOffset_ + static_cast<size_t>(index) * kSectionHeaderSize;
+    std::memcpy(section.name, data_ + offset, sizeof(section.name));
+    section.virtualSize = ReadAt<uint32_t>(data_, offset + 8);
+    section.virtualAddress = ReadAt<uint32_t>(data_, offset + 12);
+    section.sizeOfRawData = ReadAt<uint32_t>(data_, offset + 16);
+    section.pointerToRawData = ReadAt<uint32_t>(data_, offset + 20);
+    section.characteristics = ReadAt<uint32_t>(data_, offset + 36);
+    return section;
+}
+
+DataDirectory View::Directory(uint32_t index) const {
+    if (!valid_ || index >= directoryCount_) {
+        return { 0, 0 };
+    }
+    const size_t offset = directoriesOffset_ + static_cast<size_t>(index) * 8;
+    return { ReadAt<uint32_t>(data_, offset), ReadAt<uint32_t>(data_, offset + 4) };
+}
+
+bool View::RvaToOffset(uint32_t rva, size_t length, size_t& offset) const {
+    if (!valid_) {
+        return false;
+    }
+    const uint64_t end = static_cast<uint64_t>(rva) + length;
+    if (layout_ == Layout::Mapped) {
+        if (end > size_) {
+            return false;
+        }
+        offset = rva;
+        return true;
+    }
+    if (rva < sizeOfHeaders_) {
+        if (end > sizeOfHeaders_ || end > size_) {
+            return false;
+        }
+        offset = rva;
+        return true;
+    }
+    for (uint32_t i = 0; i < sectionCount_; ++i) {
+        const Section section = SectionAt(i);
+        if (rva < section.virtualAddress || rva - section.virtualAddress >= section.sizeOfRawData) {
+            continue;
+        }
+        const uint64_t delta = rva - section.virtualAddress;
+        if (delta + length > section.sizeOfRawData) {
+            return false;
+        }
+        const uint64_t fileOffset = section.pointerToRawData + delta;
+        if (fileOffset + length > size_) {
+            return false;
+        }
+        offset = static_cast<size_t>(fileOffset);
+        return true;
+    }
+    return false;
+}
+
+const uint8_t* View::AtRva(uint32_t rva, size_t length) const {
+    size_t offset = 0;
+    return RvaToOffset(rva, length, offset) ? data_ + offset : nullptr;
+}
+
+std::wstring MachineName(uint16_t machine) {
+    switch (machine) {
+    case kMachineI386:
+        return L"x86";
+    case kMachineAmd64:
+        return L"x64";
+    case kMachineArm:
+        return L"ARM";
+    case kMachineArm64:
+        return L"ARM64";
+    default: {
+        wchar_t text[16] = {};
+        std::swprintf(text, std::size(text), L"0x%04X", static_cast<unsigned>(machine));
+        return text;
+    }
+    }
+}
+
+const uint8_t* FindResourceData(const View& view, uint32_t type, int64_t name, size_t& length) {
+    const DataDirectory directory = view.Directory(kDirectoryResource);
+    if (directory.rva == 0 || directory.size < 16) {
+        return nullptr;
+    }
+    const uint8_t* rsrc = view.AtRva(directory.rva, directory.size);
+    if (!rsrc) {
+        return nullptr;
+    }
+
+    uint32_t offset = FindResourceEntry(rsrc, directory.size, 0, type);
+    for (int level = 0; level < 2; ++level) {
+        if (!(offset & 0x80000000u)) {
+            return nullptr; // Type and name levels must be subdirectories
+        }
+        offset = FindResourceEntry(rsrc, directory.size, offset & 0x7FFFFFFFu, level == 0 ? name : -1);
+    }
+    if (offset == 0 || (offset & 0x80000000u) || static_cast<size_t>(offset) + 16 > directory.size) {
+        return nullptr;
+    }
+    const uint32_t dataRva = ReadAt<uint32_t>(rsrc, offset);
+    const uint32_t dataSize = ReadAt<uint32_t>(rsrc, offset + 4);
+    length = dataSize;
+    return view.AtRva(dataRva, dataSize);
+}
+
+ImageInfo ParseImageInfo(const uint8_t* data, size_t size) {
+    ImageInfo info;
+    info.machineType = L"Unknown";
+    View view(data, size);
+    if (!view.IsValid()) {
+        return info;
+    }
+    info.machine = view.Machine();
+    info.machineType = MachineName(info.machine);
+    info.imageBase = view.ImageBase();
+    info.dllCharacteristics = view.DllCharacteristics();
+    info.relocations = PeReloc::Decode(view);
+    ReadVersionStrings(view, info);
+    return info;
+}
+
+ImageInfo ReadImageInfo(const std::filesystem::path& path) {
+    Perf::ScopedTimer timer(Perf::Op::GetImageInfo);
+    Diagnostics::Increment(Diagnostics::Counter::ModulesParsed);
+    auto file = Platform::MappedFile::Open(path);
+    if (!file) {
+        ImageInfo info;
+        info.machineType = L"Unknown";
+        return info;
+    }
+    return ParseImageInfo(file->Data(), file->Size());
+}
+
+} // namespace PeImage
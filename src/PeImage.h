@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "PeReloc.h"
+
+// Portable reader for PE images held in memory (a mapped file or a test buffer). It never trusts the
+// image: every offset is bounds-checked against the buffer, so malformed files yield "not valid" or empty
+// results rather than faults. Values are read little-endian with memcpy, so alignment does not matter.
+namespace PeImage {
+
+constexpr uint16_t kMachineI386 = 0x014C;
+constexpr uint16_t kMachineArm = 0x01C0;
+constexpr uint16_t kMachineAmd64 = 0x8664;
+constexpr uint16_t kMachineArm64 = 0xAA64;
+
+constexpr uint16_t kOptionalMagicPe32 = 0x10B;
+constexpr uint16_t kOptionalMagicPe32Plus = 0x20B;
+
+// Data directory indices
+constexpr uint32_t kDirectoryExport = 0;
+constexpr uint32_t kDirectoryImport = 1;
+constexpr uint32_t kDirectoryResource = 2;
+constexpr uint32_t kDirectoryBaseReloc = 5;
+constexpr uint32_t kDirectoryLoadConfig = 10;
+constexpr uint32_t kDirectoryIat = 12;
+constexpr uint32_t kDirectoryCount = 16;
+
+constexpr uint32_t kResourceTypeVersion = 16; // RT_VERSION
+
+template <class T>
+T ReadAt(const uint8_t* data, size_t offset) {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+struct DataDirectory {
+    uint32_t rva;
+    uint32_t size;
+};
+
+struct Section {
+    char name[8]; // Not necessarily NUL-terminated
+    uint32_t virtualSize;
+    uint32_t virtualAddress;
+    uint32_t sizeOfRawData;
+    uint32_t pointerToRawData;
+    uint32_t characteristics;
+};
+
+// How sections are placed in the buffer a View reads.
+enum class Layout {
+    File,   // At their raw file offsets, as on disk or in a mapped file
+    Mapped, // At their RVAs, as the loader maps an image; size is usually SizeOfImage
+};
+
+// Parsed headers of a PE image, laid out as a file on disk unless told otherwise.
+class View {
+public:
+    View(const uint8_t* data, size_t size, Layout layout = Layout::File);
+
+    /// @brief True if the DOS, NT and optional headers and the section table are all within bounds.
+    bool IsValid() const { return valid_; }
+
+    const uint8_t* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+    uint16_t Machine() const { return machine_; }
+    uint32_t TimeDateStamp() const { return timeDateStamp_; }
+    bool Is64Bit() const { return optionalMagic_ == kOptionalMagicPe32Plus; }
+    uint64_t ImageBase() const { return imageBase_; }
+    /// @brief IMAGE_OPTIONAL_HEADER.DllCharacteristics (dynamic base, NX compatible, ...).
+    uint16_t DllCharacteristics() const { return dllCharacteristics_; }
+    uint32_t SizeOfImage() const { return sizeOfImage_; }
+    uint32_t SizeOfHeaders() const { return sizeOfHeaders_; }
+    /// @brief File offset of the optional header's CheckSum field.
+    size_t ChecksumOffset() const { return checksumOffset_; }
+    uint32_t Checksum() const { return ReadAt<uint32_t>(data_, checksumOffset_); }
+
+    uint32_t SectionCount() const { return sectionCount_; }
+    Section SectionAt(uint32_t index) const;
+
+    /// @brief The directory entry, or {0, 0} if the image has fewer directories.
+    DataDirectory Directory(uint32_t index) const;
+
+    Layout GetLayout() const { return layout_; }
+
+    /// @brief Maps an RVA to an offset in the buffer. For the file layout it fails for RVAs in
+    /// virtual-only space (past SizeOfRawData); for either, for ranges that run past the end of the buffer.
+    bool RvaToOffset(uint32_t rva, size_t length, size_t& offset) const;
+
+    /// @brief Pointer to length bytes at an RVA, or nullptr if they are not all backed by the file.
+    const uint8_t* AtRva(uint32_t rva, size_t length) const;
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    Layout layout_;
+    bool valid_ = false;
+    uint16_t machine_ = 0;
+    uint32_t timeDateStamp_ = 0;
+    uint16_t optionalMagic_ = 0;
+    uint64_t imageBase_ = 0;
+    uint16_t dllCharacteristics_ = 0;
+    uint32_t sizeOfImage_ = 0;
+    uint32_t sizeOfHeaders_ = 0;
+    size_t checksumOffset_ = 0;
+    size_t directoriesOffset_ = 0;
+    uint32_t directoryCount_ = 0;
+    size_t sectionTableOffset_ = 0;
+    uint32_t sectionCount_ = 0;
+};
+
+struct ImageInfo {
+    std::wstring companyName;
+    std::wstring description;
+    std::wstring fileVersion;
+    std::wstring machineType;
+    uint16_t machine = 0;             // IMAGE_FILE_HEADER.Machine, 0 if the headers are invalid
+    uint64_t fileVersionNumber = 0;   // VS_FIXEDFILEINFO dwFileVersionMS:dwFileVersionLS, 0 if absent
+    uint64_t imageBase = 0;           // The preferred base the file was linked for
+    uint16_t dllCharacteristics = 0;
+    PeReloc::Summary relocations{};   // What loading anywhere but imageBase costs
+};
+
+/// @brief Splits a fileVersionNumber into its four 16-bit parts (major, minor, build, revision).
+constexpr uint16_t VersionPart(uint64_t version, int index) {
+    return static_cast<uint16_t>(version >> (48 - 16 * index));
+}
+
+/// @brief The data of the first resource of a type with an integer name (name < 0 for any name), in any
+/// language. Returns nullptr if there is none or it is not backed by the buffer.
+const uint8_t* FindResourceData(const View& view, uint32_t type, int64_t name, size_t& length);
+
+/// @brief "x86", "x64", "ARM", "ARM64", or "0x%04X" for anything else.
+std::wstring MachineName(uint16_t machine);
+
+/// @brief Reads the machine type, preferred base, base relocation summary, the fixed file version and
+/// the CompanyName / FileDescription / FileVersion strings of the image's RT_VERSION resource, using the first translation that has any of them (as VerQueryValue
+/// lookups driven by \VarFileInfo\Translation would). machineType is "Unknown" if the headers are invalid.
+ImageInfo ParseImageInfo(const uint8_t* data, size_t size);
+
+/// @brief Maps the file and parses it with ParseImageInfo. Counted as a parsed module and timed as
+/// Perf::Op::GetImageInfo.
+ImageInfo ReadImageInfo(const std::filesystem::path& path);
+
+} // namespace PeImage
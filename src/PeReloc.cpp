@@ -0,0 +1,201 @@
+#include "PeReloc.h"
+
+#include "PeImage.h"
+
+#include <algorithm>
+
+namespace PeReloc {
+namespace {
+
+constexpr uint32_t kBlockHeaderSize = 8;
+
+constexpr uint16_t kRelocAbsolute = 0;
+constexpr uint16_t kRelocHigh = 1;
+constexpr uint16_t kRelocLow = 2;
+constexpr uint16_t kRelocHighAdj = 4;
+constexpr uint16_t kRelocArmMov32 = 5;
+constexpr uint16_t kRelocThumbMov32 = 7;
+constexpr uint16_t kRelocDir64 = 10;
+
+// Bytes a fixup of this type writes, to tell whether it spills into the next page.
+uint32_t FixupWidth(uint16_t type) {
+    switch (type) {
+    case kRelocHigh:
+    case kRelocLow:
+    case kRelocHighAdj:
+        return 2;
+    case kRelocArmMov32:
+    case kRelocThumbMov32:
+    case kRelocDir64:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+} // namespace
+
+Decoder::Decoder(uint32_t sizeOfImage, PageFn onPage, void* context)
+    : sizeOfImage_(sizeOfImage), onPage_(onPage), context_(context),
+      written_((uint64_t{ sizeOfImage } + kPageSize - 1) / kPageSize / 64 + 1, 0) {}
+
+void Decoder::Update(const uint8_t* data, size_t size) {
+    while (size != 0 && !stopped_) {
+        if (headerFill_ < kBlockHeaderSize) {
+            const size_t take = std::min<size_t>(kBlockHeaderSize - headerFill_, size);
+            std::copy(data, data + take, header_ + headerFill_);
+            headerFill_ += static_cast<uint32_t>(take);
+            data += take;
+            size -= take;
+            if (headerFill_ == kBlockHeaderSize) {
+                BeginBlock();
+            }
+            continue;
+        }
+        if (pending_ >= 0) {
+            const uint8_t joined[2] = { static_cast<uint8_t>(pending_), data[0] };
+            Entries(joined, 1);
+            pending_ = -1;
+            remaining_ -= 2;
+            ++data;
+            --size;
+        } else if (remaining_ >= 2) {
+            // Whole entries straight from the piece; this is where nearly all the time goes.
+            const size_t count = std::min<size_t>(remaining_ / 2, size / 2);
+            Entries(data, count);
+            remaining_ -= static_cast<uint32_t>(count * 2);
+            data += count * 2;
+            size -= count * 2;
+            if (size == 1 && remaining_ >= 2) {
+                pending_ = data[0];
+                ++data;
+                --size;
+            }
+        } else if (remaining_ == 1) {
+            // An odd-sized block; the last byte is not an entry.
+            remaining_ = 0;
+            ++data;
+            --size;
+        }
+        if (remaining_ == 0 && pending_ < 0) {
+            EndBlock();
+        }
+    }
+}
+
+void Decoder::BeginBlock() {
+    page_ = PeImage::ReadAt<uint32_t>(header_, 0);
+    const uint32_t blockSize = PeImage::ReadAt<uint32_t>(header_, 4);
+    if (blockSize == 0 && page_ == 0) {
+        // Some linkers end the directory with an empty block.
+        stopped_ = true;
+        return;
+    }
+    if (blockSize < kBlockHeaderSize) {
+        summary_.malformed = true;
+        stopped_ = true;
+        return;
+    }
+    ++summary_.blocks;
+    remaining_ = blockSize - kBlockHeaderSize;
+    blockFixups_ = 0;
+    skipOperand_ = false;
+    if (remaining_ == 0) {
+        EndBlock();
+    }
+}
+
+void Decoder::EndBlock() {
+    if (onPage_ && blockFixups_ != 0) {
+        onPage_(context_, page_, blockFixups_);
+    }
+    headerFill_ = 0;
+}
+
+void Decoder::Entries(const uint8_t* data, size_t count) {
+    // The counters live in locals for the loop: stores through the byte pointer could otherwise alias
+    // the members and force them back to memory on every entry.
+    uint64_t fixups = 0;
+    uint32_t blockFixups = blockFixups_;
+    bool skipOperand = skipOperand_;
+    const uint64_t page = page_;
+    for (size_t i = 0; i < count; ++i) {
+        const uint16_t entry = PeImage::ReadAt<uint16_t>(data, i * 2);
+        const uint16_t type = entry >> 12;
+        if (skipOperand || type == kRelocAbsolute) {
+            skipOperand = false;
+            continue;
+        }
+        skipOperand = type == kRelocHighAdj;
+        ++blockFixups;
+        ++fixups;
+        const uint64_t rva = page + (entry & 0xFFF);
+        const uint64_t last = rva + FixupWidth(type) - 1;
+        if (rva / kPageSize != lastPage_ || last / kPageSize != lastPage_) {
+            MarkPage(rva);
+            if (last / kPageSize != rva / kPageSize) {
+                MarkPage(last);
+            }
+        }
+    }
+    summary_.fixups += fixups;
+    blockFixups_ = blockFixups;
+    skipOperand_ = skipOperand;
+}
+
+void Decoder::MarkPage(uint64_t rva) {
+    if (rva >= sizeOfImage_) {
+        summary_.malformed = true;
+        return;
+    }
+    const uint64_t page = rva / kPageSize;
+    lastPage_ = page;
+    uint64_t& word = written_[page / 64];
+    const uint64_t bit = uint64_t{ 1 } << (page % 64);
+    if (!(word & bit)) {
+        word |= bit;
+        ++summary_.pages;
+    }
+}
+
+Summary Decoder::Finish() const {
+    Summary summary = summary_;
+    if (!stopped_ && (headerFill_ != 0 || pending_ >= 0)) {
+        summary.malformed = true;
+    }
+    return summary;
+}
+
+Summary Decode(const PeImage::View& view) {
+    const auto directory = view.Directory(PeImage::kDirectoryBaseReloc);
+    if (directory.rva == 0 || directory.size == 0) {
+        return {};
+    }
+    const uint8_t* data = view.AtRva(directory.rva, directory.size);
+    if (!data) {
+        Summary summary;
+        summary.malformed = true;
+        return summary;
+    }
+    Decoder decoder(view.SizeOfImage());
+    decoder.Update(data, directory.size);
+    return decoder.Finish();
+}
+
+std::wstring Describe(const Summary& summary, uint64_t preferredBase, uint64_t actualBase, uint16_t dllCharacteristics) {
+    if (preferredBase == 0 || preferredBase == actualBase) {
+        return L"";
+    }
+    const bool dynamicBase = (dllCharacteristics & kDllDynamicBase) != 0;
+    std::wstring text = dynamicBase ? L"ASLR: " : L"Rebased: ";
+    text += std::to_wstring(summary.fixups) + L" fixups, " + std::to_wstring(summary.pages) + L" pages";
+    if (!dynamicBase && summary.pages != 0) {
+        text += L" (" + std::to_wstring(uint64_t{ summary.pages } * kPageSize / 1024) + L" KB private)";
+    }
+    if (summary.malformed) {
+        text += L", malformed";
+    }
+    return text;
+}
+
+} // namespace PeReloc
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace PeImage {
+class View;
+}
+
+// Base relocations: the .reloc directory is a run of IMAGE_BASE_RELOCATION blocks, each a page RVA and
+// size followed by 16-bit entries (fixup type in the top 4 bits, offset in the page in the low 12). A
+// module mapped anywhere but its preferred ImageBase has every fixup patched, and each page written
+// stops being shared with the file. The Decoder takes the directory in pieces of any size and counts
+// fixups and distinct pages as it goes, without ever holding the entries, so a rebase can be costed
+// from the same pass that reads the image.
+namespace PeReloc {
+
+constexpr uint32_t kPageSize = 4096;
+
+constexpr uint16_t kDllDynamicBase = 0x0040; // IMAGE_DLLCHARACTERISTICS_DYNAMIC_BASE
+
+struct Summary {
+    uint32_t blocks = 0;
+    uint64_t fixups = 0;    // Entries the loader applies; IMAGE_REL_BASED_ABSOLUTE padding is not counted
+    uint32_t pages = 0;     // Distinct pages those fixups write, including the next page for one that straddles
+    bool malformed = false; // A block was shorter than its header, ran past the directory, or named a page past the image
+};
+
+// Decodes a relocation directory supplied front to back in pieces.
+class Decoder {
+public:
+    /// @brief Called once per block with its page and the fixups it applies there.
+    using PageFn = void (*)(void* context, uint32_t pageRva, uint32_t fixups);
+
+    /// @param sizeOfImage Bounds the pages fixups may write.
+    explicit Decoder(uint32_t sizeOfImage, PageFn onPage = nullptr, void* context = nullptr);
+
+    void Update(const uint8_t* data, size_t size);
+
+    /// @brief The summary of everything passed to Update. A block left incomplete marks it malformed.
+    Summary Finish() const;
+
+private:
+    void BeginBlock();
+    void EndBlock();
+    void Entries(const uint8_t* data, size_t count);
+    void MarkPage(uint64_t rva);
+
+    uint32_t sizeOfImage_;
+    PageFn onPage_;
+    void* context_;
+    std::vector<uint64_t> written_; // One bit per page of the image
+    uint64_t lastPage_ = UINT64_MAX; // The page marked most recently; a block's fixups rarely leave it
+    Summary summary_;
+    bool stopped_ = false;          // After a terminator or a malformed block, the rest is ignored
+    uint8_t header_[8] = {};
+    uint32_t headerFill_ = 0;
+    uint32_t page_ = 0;
+    uint32_t remaining_ = 0;        // Entry bytes left in the current block
+    uint32_t blockFixups_ = 0;
+    int pending_ = -1;              // The first byte of an entry split across two pieces
+    bool skipOperand_ = false;      // The next entry is the operand of a HIGHADJ fixup
+};
+
+/// @brief Decodes the base relocation directory of an image in one piece. An image without one
+/// summarizes to zero blocks.
+Summary Decode(const PeImage::View& view);
+
+/// @brief Column text for a module loaded at actualBase: empty at its preferred base, otherwise
+/// "Rebased" (or "ASLR" for a dynamic-base image) with its fixup and page counts. Rebased pages are
+/// private to the process, so for those the cost is also given in KB.
+std::wstring Describe(const Summary& summary, uint64_t preferredBase, uint64_t actualBase, uint16_t dllCharacteristics);
+
+} // namespace PeReloc
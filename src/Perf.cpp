@@ -0,0 +1,278 @@
+#include "Perf.h"
+
+#include <bit>
+#include <cstdio>
+#include <cwchar>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace Perf {
+namespace {
+
+constexpr std::array<const char*, kOpCount> kOpNames = {
+    "EnumObjects",
+    "GetLoadedModules",
+    "GetImageInfo",
+    "CompareIDs",
+    "GetDetailsOf",
+    "EnumNext",
+    "LoaderRefresh",
+    "DecodeTreeNode",
+    "HookScan",
+    "IntegrityCheck",
+    "SignatureSearch",
+    "HashModuleFiles",
+    "FindDuplicates",
+    "ExtractIcon",
+    "ModuleLoad",
+    "WorkingSet",
+    "AddressSpace",
+};
+
+// Buffered spans are written out once this many accumulate, keeping memory bounded for long sessions.
+constexpr size_t kTraceFlushThreshold = 4096;
+
+struct TraceEvent {
+    Op op;
+    uint32_t threadIndex;
+    int64_t startNs;
+    int64_t durationNs;
+};
+
+struct TraceSession {
+    std::mutex mutex;
+    std::ofstream file;
+    std::vector<TraceEvent> events;
+    Clock::time_point epoch;
+    bool firstEvent = true;
+};
+
+std::array<Histogram, kOpCount> g_histograms;
+std::atomic<bool> g_tracing{ false };
+std::atomic<uint32_t> g_nextThreadIndex{ 0 };
+
+TraceSession& Session() {
+    static TraceSession session;
+    return session;
+}
+
+uint32_t CurrentThreadIndex() {
+    // Small stable ids read better in trace viewers than hashed std::thread::id values.
+    thread_local uint32_t index = g_nextThreadIndex.fetch_add(1, std::memory_order_relaxed) + 1;
+    return index;
+}
+
+// Caller holds session.mutex.
+void WriteEventsLocked(TraceSession& session) {
+    if (!session.file.is_open()) {
+        session.events.clear();
+        return;
+    }
+    char line[256] = {};
+    for (const auto& event : session.events) {
+        int length = std::snprintf(line,
+            sizeof(line),
+            "%s{\"name\":\"%s\",\"cat\":\"shell\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            session.firstEvent ? "\n" : ",\n",
+            OpName(event.op),
+            event.threadIndex,
+            static_cast<double>(event.startNs) / 1000.0,
+            static_cast<double>(event.durationNs) / 1000.0);
+        if (length > 0) {
+            session.file.write(line, length);
+        }
+        session.firstEvent = false;
+    }
+    session.events.clear();
+    session.file.flush();
+}
+
+std::wstring FormatDuration(uint64_t ns) {
+    wchar_t text[32] = {};
+    if (ns < 1000) {
+        std::swprintf(text, std::size(text), L"%lluns", static_cast<unsigned long long>(ns));
+    } else if (ns < 1000 * 1000) {
+        std::swprintf(text, std::size(text), L"%.1fus", static_cast<double>(ns) / 1e3);
+    } else if (ns < 1000ull * 1000 * 1000) {
+        std::swprintf(text, std::size(text), L"%.2fms", static_cast<double>(ns) / 1e6);
+    } else {
+        std::swprintf(text, std::size(text), L"%.2fs", static_cast<double>(ns) / 1e9);
+    }
+    return text;
+}
+
+} // namespace
+
+const char* OpName(Op op) {
+    auto index = static_cast<size_t>(op);
+    return index < kOpNames.size() ? kOpNames[index] : "Unknown";
+}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+    if (value < kSubBucketCount) {
+        return static_cast<size_t>(value);
+    }
+    // Top kSubBucketBits + 1 significant bits select the bucket; everything below is precision we drop.
+    const uint32_t shift = static_cast<uint32_t>(std::bit_width(value)) - 1 - kSubBucketBits;
+    const uint64_t subBucket = (value >> shift) & (kSubBucketCount - 1);
+    return (static_cast<size_t>(shift) + 1) * kSubBucketCount + static_cast<size_t>(subBucket);
+}
+
+uint64_t Histogram::BucketUpperBound(size_t index) {
+    if (index < kSubBucketCount) {
+        return index;
+    }
+    const uint32_t shift = static_cast<uint32_t>(index / kSubBucketCount) - 1;
+    const uint64_t subBucket = index % kSubBucketCount;
+    const uint64_t lower = (kSubBucketCount + subBucket) << shift;
+    return lower + ((1ull << shift) - 1);
+}
+
+void Histogram::Record(uint64_t value) {
+    buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t currentMax = max_.load(std::memory_order_relaxed);
+    while (value > currentMax && !max_.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::ValueAtPercentile(double percentile) const {
+    const uint64_t total = Count();
+    if (total == 0) {
+        return 0;
+    }
+    if (percentile > 100.0) {
+        percentile = 100.0;
+    }
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(total) + 0.5);
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            const uint64_t bound = BucketUpperBound(i);
+            const uint64_t max = Max();
+            return bound < max ? bound : max;
+        }
+    }
+    return Max();
+}
+
+Histogram& GetHistogram(Op op) {
+    return g_histograms[static_cast<size_t>(op)];
+}
+
+void ResetHistograms() {
+    for (auto& histogram : g_histograms) {
+        histogram.Reset();
+    }
+}
+
+std::wstring FormatSummary() {
+    std::wstring summary;
+    for (size_t i = 0; i < kOpCount; ++i) {
+        const auto& histogram = g_histograms[i];
+        const uint64_t count = histogram.Count();
+        if (count == 0) {
+            continue;
+        }
+        const char* name = OpName(static_cast<Op>(i));
+        summary.append(name, name + std::char_traits<char>::length(name));
+        summary += L": n=" + std::to_wstring(count);
+        summary += L" p50=" + FormatDuration(histogram.ValueAtPercentile(50));
+        summary += L" p90=" + FormatDuration(histogram.ValueAtPercentile(90));
+        summary += L" p99=" + FormatDuration(histogram.ValueAtPercentile(99));
+        summary += L" max=" + FormatDuration(histogram.Max());
+        summary += L" total=" + FormatDuration(histogram.Sum());
+        summary += L"\n";
+    }
+    return summary;
+}
+
+bool StartTrace(const std::filesystem::path& path) {
+    auto& session = Session();
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (g_tracing.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    session.file.open(path, std::ios::binary | std::ios::trunc);
+    if (!session.file.is_open()) {
+        return false;
+    }
+    session.file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    session.events.clear();
+    session.events.reserve(kTraceFlushThreshold);
+    session.epoch = Clock::now();
+    session.firstEvent = true;
+    g_tracing.store(true, std::memory_order_release);
+    return true;
+}
+
+void FlushTrace() {
+    if (!IsTracing()) {
+        return;
+    }
+    auto& session = Session();
+    std::lock_guard<std::mutex> lock(session.mutex);
+    WriteEventsLocked(session);
+}
+
+void StopTrace() {
+    auto& session = Session();
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (!g_tracing.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    WriteEventsLocked(session);
+    session.file << "\n]}\n";
+    session.file.close();
+}
+
+void DiscardTrace() {
+    auto& session = Session();
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (!g_tracing.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    // WriteEventsLocked flushes the stream after every batch, so closing only releases the handle.
+    session.events.clear();
+    session.file.close();
+}
+
+bool IsTracing() {
+    return g_tracing.load(std::memory_order_acquire);
+}
+
+void RecordSpan(Op op, Clock::time_point start, Clock::time_point end) {
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    GetHistogram(op).Record(duration > 0 ? static_cast<uint64_t>(duration) : 0);
+
+    if (!g_tracing.load(std::memory_order_relaxed)) {
+        return;
+    }
+    auto& session = Session();
+    std::lock_guard<std::mutex> lock(session.mutex);
+    if (!g_tracing.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const auto startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - session.epoch).count();
+    session.events.push_back({ op, CurrentThreadIndex(), startNs, duration });
+    if (session.events.size() >= kTraceFlushThreshold) {
+        WriteEventsLocked(session);
+    }
+}
+
+} // namespace Perf
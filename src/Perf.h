@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Lightweight latency instrumentation for the COM entry points and helpers that sit on the
+// folder-open path. Every ScopedTimer feeds a per-operation histogram; when a trace session is
+// active the span is also recorded as a Chrome trace event ("X" phase) for chrome://tracing or Perfetto.
+//
+// This file has no platform dependencies so it can be benchmarked off Windows.
+namespace Perf {
+
+enum class Op : uint32_t {
+    EnumObjects,
+    GetLoadedModules,
+    GetImageInfo,
+    CompareIDs,
+    GetDetailsOf,
+    EnumNext,
+    LoaderRefresh, // From the first loader event a refresh covers until the refresh was sent
+    DecodeTreeNode, // Mapping an image and decoding one subtree node (ImageTree::Cache miss)
+    HookScan, // Scanning the import and export tables of every loaded module
+    IntegrityCheck, // Comparing the code of every loaded module with its file
+    SignatureSearch, // Searching every loaded module image for byte signatures
+    HashModuleFiles, // Hashing the file behind every loaded module
+    FindDuplicates,  // Fingerprinting and grouping loaded modules
+    ExtractIcon,     // Finding or decoding one module icon for the shell
+    ModuleLoad,      // Loading a module and what it pulls in (timed loads exactly, others from notifications)
+    WorkingSet,      // One residency query over every module page, and attributing it
+    AddressSpace,    // Walking the address space and attributing it to module sections
+    Count
+};
+
+constexpr size_t kOpCount = static_cast<size_t>(Op::Count);
+
+const char* OpName(Op op);
+
+using Clock = std::chrono::steady_clock;
+
+// HDR-style histogram: values are bucketed log-linearly (8 sub-buckets per power of two), so any
+// recorded value is reported within 12.5% of its true magnitude across the full 64-bit range.
+// Recording is lock-free and safe from any thread.
+class Histogram {
+public:
+    static constexpr uint32_t kSubBucketBits = 3;
+    static constexpr uint32_t kSubBucketCount = 1u << kSubBucketBits;
+    static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+    void Record(uint64_t value);
+    void Reset();
+
+    uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t Sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return max_.load(std::memory_order_relaxed); }
+
+    /// @brief Returns the highest value equivalent to the bucket holding the given percentile (0-100).
+    uint64_t ValueAtPercentile(double percentile) const;
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+    std::atomic<uint64_t> count_{ 0 };
+    std::atomic<uint64_t> sum_{ 0 };
+    std::atomic<uint64_t> max_{ 0 };
+};
+
+/// @brief Latency histogram (nanoseconds) for an operation.
+Histogram& GetHistogram(Op op);
+
+/// @brief Clears all operation histograms.
+void ResetHistograms();
+
+/// @brief One line per operation that has samples: count, p50/p90/p99, max and total time.
+std::wstring FormatSummary();
+
+/// @brief Starts recording spans to a Chrome trace-event JSON file. Returns false if a session is
+/// already active or the file cannot be created.
+bool StartTrace(const std::filesystem::path& path);
+
+/// @brief Writes buffered spans to the trace file without ending the session.
+void FlushTrace();
+
+/// @brief Flushes and closes the trace file, producing a complete JSON document.
+void StopTrace();
+
+/// @brief Ends the session without writing anything: spans not yet flushed are dropped and the document
+/// is left unterminated. For DLL_PROCESS_DETACH, where file writes would run under the loader lock.
+void DiscardTrace();
+
+bool IsTracing();
+
+/// @brief Records a completed span. Called by ScopedTimer; exposed for spans that do not map to a scope.
+void RecordSpan(Op op, Clock::time_point start, Clock::time_point end);
+
+// Times the enclosing scope and records it against an operation.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Op op) : op_(op), start_(Clock::now()) {}
+    ~ScopedTimer() { RecordSpan(op_, start_, Clock::now()); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Op op_;
+    Clock::time_point start_;
+};
+
+} // namespace Perf
@@ -4,31 +4,36 @@
 #include <shlobj.h>
 #include <string>
 
+#include "PidlCodec.h"
+
 // PIDL = Pointer to an ID list - opaque data used by our extension and Explorer to identify items.
 //
 // An absolute PIDL is a fullly qualified path to the item.
 // A relative PIDL is relative to the item's parent folder.
 namespace Pidl {
-constexpr DWORD kSignature = 0x4C444F4D; // 'MODL'
-
-// Define the binary structure of our PIDL explicitly.
-// #pragma pack(1) ensures no padding bytes are inserted by the compiler.
-#pragma pack(push, 1)
-struct PidlData {
-    DWORD signature;
-    UINT64 baseAddress;
-    DWORD size;
-    // Variable length path string follows this struct
-};
-#pragma pack(pop)
+// The encoding itself lives in PidlCodec; this namespace adapts it to the shell's ITEMIDLIST types.
+constexpr DWORD kSignature = PidlCodec::kModuleSignature;
+constexpr DWORD kDiagnosticsSignature = PidlCodec::kDiagnosticsSignature;
+constexpr DWORD kTreeNodeSignature = PidlCodec::kTreeNodeSignature;
+constexpr DWORD kTreeEntrySignature = PidlCodec::kTreeEntrySignature;
 
-static_assert(sizeof(PidlData) == 16, "PidlData size mismatch");
+using PidlData = PidlCodec::ItemData;
 
 PIDLIST_ABSOLUTE CreateRoot();
 PIDLIST_RELATIVE CreateFromPath(const std::wstring& path, void* baseAddress, DWORD size);
+/// @brief Creates the item for the virtual, read-only "Diagnostics" entry. It shares the PidlData
+/// layout but carries kDiagnosticsSignature, so IsOurPidl() (module items only) rejects it.
+PIDLIST_RELATIVE CreateDiagnostics();
+/// @brief Creates a child of a module item: one ImageTree node (Sections, Imports, ...).
+PIDLIST_RELATIVE CreateTreeNode(DWORD node, const std::wstring& name);
+/// @brief Creates the index-th entry of an ImageTree node listing.
+PIDLIST_RELATIVE CreateTreeEntry(DWORD node, size_t index, const std::wstring& name);
 PIDLIST_RELATIVE Clone(PCUIDLIST_RELATIVE pidl);
 void Free(PIDLIST_RELATIVE pidl);
 bool IsOurPidl(PCUIDLIST_RELATIVE pidl);
+bool IsDiagnosticsPidl(PCUIDLIST_RELATIVE pidl);
+bool IsTreeNodePidl(PCUIDLIST_RELATIVE pidl);
+bool IsTreeEntryPidl(PCUIDLIST_RELATIVE pidl);
 std::wstring GetPath(PCUIDLIST_RELATIVE pidl);
 void* GetBaseAddress(PCUIDLIST_RELATIVE pidl);
 DWORD GetSize(PCUIDLIST_RELATIVE pidl);
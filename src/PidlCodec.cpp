@@ -0,0 +1,135 @@
+#include "PidlCodec.h"
+
+#include "Diagnostics.h"
+#include "Log.h"
+#include "Platform.h"
+
+#include <cstring>
+#include <cwchar>
+
+namespace PidlCodec {
+namespace {
+
+// Leave a small margin below 0xFFFF for cb.
+constexpr size_t kMaxItemSize = 0xFFF0;
+
+uint16_t ReadCb(const void* item) {
+    uint16_t cb = 0;
+    std::memcpy(&cb, item, sizeof(cb));
+    return cb;
+}
+
+int CompareValues(uint64_t left, uint64_t right) {
+    return left < right ? -1 : (left > right ? 1 : 0);
+}
+
+} // namespace
+
+void* Create(uint32_t signature, std::wstring_view path, uint64_t baseAddress, uint32_t size) {
+    const size_t pathBytes = (path.size() + 1) * sizeof(wchar_t);
+    const size_t cb = kPathOffset + pathBytes;
+    if (cb > kMaxItemSize) {
+        LOG_ERROR(L"PidlCodec::Create: item size too large ({})", cb);
+        return nullptr;
+    }
+
+    const size_t totalSize = cb + sizeof(uint16_t); // cb + data + null terminator (for next item 0)
+    auto bytes = static_cast<uint8_t*>(Platform::AllocateShellMemory(totalSize));
+    if (!bytes) {
+        LOG_ERROR(L"PidlCodec::Create failed for {} bytes", totalSize);
+        return nullptr;
+    }
+    Diagnostics::Increment(Diagnostics::Counter::PidlBytesAllocated, totalSize);
+
+    const auto cb16 = static_cast<uint16_t>(cb);
+    std::memcpy(bytes, &cb16, sizeof(cb16));
+    const ItemData data = { signature, baseAddress, size };
+    std::memcpy(bytes + sizeof(uint16_t), &data, sizeof(data));
+    std::memcpy(bytes + kPathOffset, path.data(), path.size() * sizeof(wchar_t));
+    // Path terminator and list terminator
+    std::memset(bytes + kPathOffset + path.size() * sizeof(wchar_t), 0, sizeof(wchar_t) + sizeof(uint16_t));
+    return bytes;
+}
+
+void* Clone(const void* item) {
+    if (!item) {
+        LOG_WARN(L"Clone called with null pidl");
+        return nullptr;
+    }
+    const uint16_t cb = ReadCb(item);
+    if (cb == 0) {
+        return nullptr;
+    }
+
+    auto bytes = static_cast<uint8_t*>(Platform::AllocateShellMemory(cb + sizeof(uint16_t)));
+    if (!bytes) {
+        LOG_ERROR(L"Clone allocation failed");
+        return nullptr;
+    }
+    Diagnostics::Increment(Diagnostics::Counter::PidlBytesAllocated, cb + sizeof(uint16_t));
+    std::memcpy(bytes, item, cb);
+    // Zero terminate list
+    std::memset(bytes + cb, 0, sizeof(uint16_t));
+    return bytes;
+}
+
+void Free(void* item) {
+    if (item) {
+        Platform::FreeShellMemory(item);
+    }
+}
+
+const ItemData* GetData(const void* item) {
+    if (!item || ReadCb(item) < sizeof(uint16_t) + sizeof(ItemData)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const ItemData*>(static_cast<const uint8_t*>(item) + sizeof(uint16_t));
+}
+
+bool HasSignature(const void* item, uint32_t signature) {
+    const ItemData* data = GetData(item);
+    return data && data->signature == signature;
+}
+
+std::wstring GetPath(const void* item) {
+    const uint16_t cb = item ? ReadCb(item) : 0;
+    if (cb < kPathOffset) {
+        return {};
+    }
+    // The path may not be wchar_t-aligned off Windows, so copy rather than point into the item.
+    const size_t maxChars = (cb - kPathOffset) / sizeof(wchar_t);
+    const uint8_t* start = static_cast<const uint8_t*>(item) + kPathOffset;
+    std::wstring path(maxChars, L'\0');
+    std::memcpy(path.data(), start, maxChars * sizeof(wchar_t));
+    path.resize(std::wcslen(path.c_str()));
+    return path;
+}
+
+std::wstring_view FileName(std::wstring_view path) {
+    const size_t separator = path.find_last_of(L"\\/:");
+    return separator == std::wstring_view::npos ? path : path.substr(separator + 1);
+}
+
+int Compare(const void* left, const void* right, SortKey key) {
+    switch (key) {
+    case SortKey::BaseAddress:
+        return CompareValues(GetData(left)->baseAddress, GetData(right)->baseAddress);
+    case SortKey::Size:
+        return CompareValues(GetData(left)->size, GetData(right)->size);
+    case SortKey::Name: {
+        const std::wstring path1 = GetPath(left);
+        const std::wstring path2 = GetPath(right);
+        int result = Platform::CompareNoCase(FileName(path1), FileName(path2));
+        if (result == 0) {
+            // Fallback to full path to be deterministic
+            result = Platform::CompareNoCase(path1, path2);
+        }
+        return result;
+    }
+    case SortKey::Path:
+    default:
+        return Platform::CompareNoCase(GetPath(left), GetPath(right));
+    }
+}
+
+} // namespace PidlCodec
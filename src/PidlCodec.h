@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Byte-level encoding of the folder's item IDs, independent of the shell headers so it can be
+// benchmarked off Windows. Pidl.h wraps this with the ITEMIDLIST types.
+//
+// A single-item ID list is laid out as:
+//   [uint16 cb][ItemData][path, wchar_t, NUL-terminated][uint16 0]
+// where cb counts itself, ItemData and the path. Items are allocated with Platform::AllocateShellMemory
+// so the shell can free them.
+namespace PidlCodec {
+constexpr uint32_t kModuleSignature = 0x4C444F4D; // 'MODL'
+constexpr uint32_t kDiagnosticsSignature = 0x4741494D; // 'MIAG'
+// Items of the per-module subtree (ImageTree). A node item carries the node in size and its name as
+// the path; an entry item carries the node in size, its index in the listing in baseAddress and its
+// name as the path.
+constexpr uint32_t kTreeNodeSignature = 0x444F4E4D; // 'MNOD'
+constexpr uint32_t kTreeEntrySignature = 0x544E454D; // 'MENT'
+
+// #pragma pack(1) ensures no padding bytes are inserted by the compiler.
+#pragma pack(push, 1)
+struct ItemData {
+    uint32_t signature;
+    uint64_t baseAddress;
+    uint32_t size;
+    // Variable length path string follows this struct
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ItemData) == 16, "ItemData size mismatch");
+
+// Offset of the path within an item.
+constexpr size_t kPathOffset = sizeof(uint16_t) + sizeof(ItemData);
+
+/// @brief Allocates and encodes a single-item ID list. Returns nullptr if the path is too long to fit in
+/// an item or allocation fails.
+void* Create(uint32_t signature, std::wstring_view path, uint64_t baseAddress, uint32_t size);
+
+/// @brief Copies the first item of an ID list, adding the terminator. Returns nullptr for an empty list.
+void* Clone(const void* item);
+
+void Free(void* item);
+
+/// @brief Returns the item's header, or nullptr if the item is too short to be one of ours.
+const ItemData* GetData(const void* item);
+
+bool HasSignature(const void* item, uint32_t signature);
+
+/// @brief The encoded path, bounded by cb so a truncated or foreign item cannot overrun.
+std::wstring GetPath(const void* item);
+
+/// @brief The text after the last path separator (the whole path if there is none).
+std::wstring_view FileName(std::wstring_view path);
+
+enum class SortKey {
+    Name,        // File name, then full path
+    BaseAddress,
+    Size,
+    Path,
+};
+
+/// @brief Orders two module items (both must pass GetData) as the folder's CompareIDs does.
+/// Returns <0, 0 or >0.
+int Compare(const void* left, const void* right, SortKey key);
+
+} // namespace PidlCodec
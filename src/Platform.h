@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Thin seam over the handful of OS services the portable code needs. PlatformWin.cpp is the real
+// implementation; PlatformPosix.cpp is a stand-in so the same code can be exercised and benchmarked on Linux.
+namespace Platform {
+
+uint32_t CurrentProcessId();
+
+/// @brief Writes one line of diagnostic output (OutputDebugString on Windows, stderr elsewhere).
+void DebugOutput(const std::wstring& text);
+
+/// @brief Allocates memory the shell may free: CoTaskMemAlloc on Windows, malloc elsewhere.
+void* AllocateShellMemory(size_t size);
+void FreeShellMemory(void* memory);
+
+using ThreadFn = void (*)(void* context);
+
+/// @brief Runs run(context) on a new thread that nobody joins. On Windows the thread takes a reference
+/// to the module holding this code as it starts and drops it with FreeLibraryAndExitThread, so the
+/// DLL stays loaded until the thread has left it; until run is called the caller must keep the DLL
+/// loaded itself. Returns false, without calling run, if the thread could not be started.
+bool StartDetachedThread(ThreadFn run, void* context);
+
+/// @brief StartDetachedThread for a callable, which is moved to the new thread.
+template <class Work>
+bool StartDetachedThread(Work work) {
+    auto owned = std::make_unique<Work>(std::move(work));
+    const ThreadFn run = [](void* context) {
+        const std::unique_ptr<Work> work(static_cast<Work*>(context));
+        (*work)();
+    };
+    if (!StartDetachedThread(run, owned.get())) {
+        return false;
+    }
+    owned.release();
+    return true;
+}
+
+/// @brief Case-insensitive comparison in the user's locale, as Explorer sorts names. Returns <0, 0 or >0.
+int CompareNoCase(std::wstring_view left, std::wstring_view right);
+
+// A named, process-shared block of memory. On Windows this is a pagefile-backed section in the
+// session namespace; the POSIX stand-in uses shm_open.
+class SharedMemory {
+public:
+    virtual ~SharedMemory() = default;
+
+    /// @brief Creates a writable block of at least size bytes that only this user can write and the
+    /// rest of the logon session can read. Returns nullptr if the name already exists: whoever created
+    /// it would control the block's size and access.
+    static std::unique_ptr<SharedMemory> Create(const std::wstring& name, size_t size);
+
+    /// @brief Opens an existing block for reading. Returns nullptr if it does not exist.
+    static std::unique_ptr<SharedMemory> OpenReadOnly(const std::wstring& name, size_t size);
+
+    virtual void* Data() const = 0;
+    virtual size_t Size() const = 0;
+};
+
+// A whole file mapped read-only.
+class MappedFile {
+public:
+    virtual ~MappedFile() = default;
+
+    /// @brief Maps an existing, non-empty file. Returns nullptr if it cannot be opened or mapped.
+    static std::unique_ptr<MappedFile> Open(const std::filesystem::path& path);
+
+    virtual const uint8_t* Data() const = 0;
+    virtual size_t Size() const = 0;
+};
+
+// What identifies a file's contents without reading them: the same file on the same volume, with the
+// same size and last-write time, is taken to hold the same bytes.
+struct FileIdentity {
+    uint64_t volume = 0;
+    uint64_t fileId = 0;
+    uint64_t size = 0;
+    int64_t lastWriteTime = 0; // FILETIME ticks on Windows, nanoseconds since the epoch elsewhere
+
+    bool operator==(const FileIdentity&) const = default;
+};
+
+// A file opened to be read front to back, with the OS told so it can read ahead.
+class SequentialFile {
+public:
+    virtual ~SequentialFile() = default;
+
+    /// @brief Opens an existing file. Returns nullptr if it cannot be opened or identified.
+    static std::unique_ptr<SequentialFile> Open(const std::filesystem::path& path);
+
+    virtual const FileIdentity& Identity() const = 0;
+
+    /// @brief Reads the next size bytes, or fewer at the end of the file, into buffer.
+    /// @return False on a read error.
+    virtual bool Read(void* buffer, size_t size, size_t& bytesRead) = 0;
+};
+
+// Residency of a page in QueryWorkingSet; the values match WorkingSet::PageFlags.
+enum PageResidency : uint8_t {
+    kPageResident = 1, // In this process's working set
+    kPageShared = 2,   // Resident and still shareable: QueryWorkingSetEx's Shared bit, or a file page on Linux
+};
+
+/// @brief The page size the residency query works in.
+uint64_t PageSize();
+
+/// @brief Fills flags[i] with PageResidency bits for pages[i], which are page-aligned and ascending.
+/// Windows answers every page in one QueryWorkingSetEx call; the POSIX stand-in reads
+/// /proc/self/pagemap once per run of consecutive pages. Returns false if the backend is unavailable.
+bool QueryWorkingSet(const uint64_t* pages, size_t count, uint8_t* flags);
+
+// What a region of the address space holds, as far as the commit charge and sharing go.
+enum class RegionUse : uint8_t {
+    Reserved,    // Address space only
+    Shared,      // Committed, and still the file's or section's pages (unwritten image, any mapped view)
+    CopyOnWrite, // Committed, shared until first written (PAGE_WRITECOPY)
+    Private,     // Committed and this process's own: allocations and written image copies
+};
+
+// A run of pages with the same allocation state and protection.
+struct MemoryRegion {
+    uint64_t base = 0;
+    uint64_t size = 0;
+    RegionUse use = RegionUse::Reserved;
+};
+
+/// @brief Lists every allocated region of this process's address space in ascending order, in one
+/// walk: VirtualQuery from the lowest address to the highest on Windows, /proc/self/maps in the POSIX
+/// stand-in (where a written copy cannot be told from an unwritten one, so every writable private file
+/// mapping is CopyOnWrite and anonymous memory is Private). regions is reused. Returns false if the
+/// backend is unavailable.
+bool WalkAddressSpace(std::vector<MemoryRegion>& regions);
+
+// Change notifications for a set of directories (not their subdirectories), delivered on a thread the
+// watch owns: ReadDirectoryChangesW on an I/O completion port on Windows, inotify elsewhere.
+class DirectoryWatch {
+public:
+    /// @brief Called on the watch thread with a directory, as passed to Add, and the name of an entry
+    /// in it that was created, written, renamed or deleted. name is empty when events were lost (the
+    /// backend's buffer overflowed) and anything in the directory may have changed.
+    using EventFn = void (*)(void* context, const std::wstring& directory, const std::wstring& name);
+
+    /// @brief Stops the thread; no callback runs after the destructor returns.
+    virtual ~DirectoryWatch() = default;
+
+    /// @brief Starts the watch thread. Returns nullptr if the backend is unavailable.
+    static std::unique_ptr<DirectoryWatch> Create(EventFn onEvent, void* context);
+
+    /// @brief Starts watching a directory. Returns false if it cannot be watched. Must not be called
+    /// from the callback.
+    virtual bool Add(const std::wstring& directory) = 0;
+
+    /// @brief Stops watching a directory; events already read may still be delivered.
+    virtual void Remove(const std::wstring& directory) = 0;
+};
+
+} // namespace Platform
@@ -0,0 +1,419 @@
+#include "Platform.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwctype>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Platform {
+namespace {
+
+// shm_open wants a single leading slash and no others; Windows-style names ("Local\Foo") are mapped onto that.
+std::string ToShmName(const std::wstring& name) {
+    std::string result = "/";
+    for (wchar_t ch : name) {
+        result += (ch == L'/' || ch == L'\\') ? '.' : static_cast<char>(ch < 0x80 ? ch : '_');
+    }
+    return result;
+}
+
+class SharedMemoryPosix final : public SharedMemory {
+public:
+    // A non-empty unlinkName marks the creator, which removes the name on destruction so the object goes
+    // away with its owner, as a Windows section does.
+    SharedMemoryPosix(void* view, size_t size, std::string unlinkName)
+        : view_(view), size_(size), unlinkName_(std::move(unlinkName)) {}
+    ~SharedMemoryPosix() override {
+        munmap(view_, size_);
+        if (!unlinkName_.empty()) {
+            shm_unlink(unlinkName_.c_str());
+        }
+    }
+
+    void* Data() const override { return view_; }
+    size_t Size() const override { return size_; }
+
+private:
+    void* view_;
+    size_t size_;
+    std::string unlinkName_;
+};
+
+class MappedFilePosix final : public MappedFile {
+public:
+    MappedFilePosix(void* view, size_t size) : view_(view), size_(size) {}
+    ~MappedFilePosix() override { munmap(view_, size_); }
+
+    const uint8_t* Data() const override { return static_cast<const uint8_t*>(view_); }
+    size_t Size() const override { return size_; }
+
+private:
+    void* view_;
+    size_t size_;
+};
+
+class SequentialFilePosix final : public SequentialFile {
+public:
+    SequentialFilePosix(int fd, const FileIdentity& identity) : fd_(fd), identity_(identity) {}
+    ~SequentialFilePosix() override { close(fd_); }
+
+    const FileIdentity& Identity() const override { return identity_; }
+
+    bool Read(void* buffer, size_t size, size_t& bytesRead) override {
+        bytesRead = 0;
+        while (bytesRead < size) {
+            const ssize_t count = read(fd_, static_cast<char*>(buffer) + bytesRead, size - bytesRead);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (count == 0) {
+                break;
+            }
+            bytesRead += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+private:
+    int fd_;
+    FileIdentity identity_;
+};
+
+class DirectoryWatchPosix final : public DirectoryWatch {
+public:
+    DirectoryWatchPosix(int inotify, int wake, EventFn onEvent, void* context)
+        : inotify_(inotify), wake_(wake), onEvent_(onEvent), context_(context), thread_(&DirectoryWatchPosix::Run, this) {}
+
+    ~DirectoryWatchPosix() override {
+        const uint64_t one = 1;
+        (void)write(wake_, &one, sizeof(one));
+        thread_.join();
+        close(inotify_);
+        close(wake_);
+    }
+
+    bool Add(const std::wstring& directory) override {
+        std::lock_guard lock(mutex_);
+        if (byDirectory_.count(directory)) {
+            return true;
+        }
+        // A file replaced by rename shows up as IN_MOVED_TO; one rewritten in place as IN_CLOSE_WRITE.
+        const int watch = inotify_add_watch(inotify_, std::filesystem::path(directory).c_str(),
+            IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+        if (watch < 0) {
+            return false;
+        }
+        byDirectory_[directory] = watch;
+        byWatch_[watch] = directory;
+        return true;
+    }
+
+    void Remove(const std::wstring& directory) override {
+        std::lock_guard lock(mutex_);
+        const auto found = byDirectory_.find(directory);
+        if (found == byDirectory_.end()) {
+            return;
+        }
+        inotify_rm_watch(inotify_, found->second);
+        byWatch_.erase(found->second);
+        byDirectory_.erase(found);
+    }
+
+private:
+    void Run() {
+        alignas(inotify_event) char buffer[16 * 1024];
+        std::vector<std::pair<std::wstring, std::wstring>> events;
+        for (;;) {
+            pollfd fds[2] = { { inotify_, POLLIN, 0 }, { wake_, POLLIN, 0 } };
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            if (fds[1].revents) {
+                return;
+            }
+            const ssize_t length = read(inotify_, buffer, sizeof(buffer));
+            if (length <= 0) {
+                continue;
+            }
+            events.clear();
+            {
+                std::lock_guard lock(mutex_);
+                for (ssize_t offset = 0; offset < length;) {
+                    const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                    offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                    if (event->mask & IN_Q_OVERFLOW) {
+                        for (const auto& [watch, directory] : byWatch_) {
+                            events.emplace_back(directory, std::wstring());
+                        }
+                        continue;
+                    }
+                    const auto found = byWatch_.find(event->wd);
+                    if (found == byWatch_.end() || event->len == 0) {
+                        continue;
+                    }
+                    events.emplace_back(found->second, std::filesystem::path(event->name).wstring());
+                }
+            }
+            for (const auto& [directory, name] : events) {
+                onEvent_(context_, directory, name);
+            }
+        }
+    }
+
+    int inotify_;
+    int wake_;
+    EventFn onEvent_;
+    void* context_;
+    std::mutex mutex_;
+    std::unordered_map<std::wstring, int> byDirectory_;
+    std::unordered_map<int, std::wstring> byWatch_;
+    std::thread thread_; // Last, so it starts after everything it uses
+};
+
+} // namespace
+
+uint32_t CurrentProcessId() {
+    return static_cast<uint32_t>(getpid());
+}
+
+void DebugOutput(const std::wstring& text) {
+    std::fputws(text.c_str(), stderr);
+}
+
+bool StartDetachedThread(ThreadFn run, void* context) {
+    try {
+        std::thread(run, context).detach();
+    } catch (const std::system_error&) {
+        return false;
+    }
+    return true;
+}
+
+void* AllocateShellMemory(size_t size) {
+    return std::malloc(size);
+}
+
+void FreeShellMemory(void* memory) {
+    std::free(memory);
+}
+
+uint64_t PageSize() {
+    static const uint64_t size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+bool QueryWorkingSet(const uint64_t* pages, size_t count, uint8_t* flags) {
+    // One 64-bit entry per virtual page: bit 63 present, bit 61 a file page (or shared anonymous).
+    constexpr uint64_t kPresent = 1ull << 63;
+    constexpr uint64_t kFilePage = 1ull << 61;
+    int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const uint64_t pageSize = PageSize();
+    std::vector<uint64_t> entries;
+    bool ok = true;
+    for (size_t first = 0; first < count && ok;) {
+        size_t last = first + 1;
+        while (last < count && pages[last] == pages[last - 1] + pageSize) {
+            ++last;
+        }
+        entries.resize(last - first);
+        const size_t bytes = entries.size() * sizeof(uint64_t);
+        const auto offset = static_cast<off_t>(pages[first] / pageSize * sizeof(uint64_t));
+        const ssize_t read = pread(fd, entries.data(), bytes, offset);
+        if (read < 0) {
+            ok = false;
+            break;
+        }
+        // Past the end of the address space the read comes up short; those pages are not mapped.
+        const size_t answered = static_cast<size_t>(read) / sizeof(uint64_t);
+        for (size_t i = first; i < last; ++i) {
+            const uint64_t entry = i - first < answered ? entries[i - first] : 0;
+            flags[i] = (entry & kPresent) ? static_cast<uint8_t>(kPageResident | ((entry & kFilePage) ? kPageShared : 0)) : 0;
+        }
+        first = last;
+    }
+    close(fd);
+    return ok;
+}
+
+bool WalkAddressSpace(std::vector<MemoryRegion>& regions) {
+    regions.clear();
+    int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    // The file has no size to ask for; it is generated as it is read.
+    std::string text;
+    char buffer[65536];
+    ssize_t read = 0;
+    while ((read = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, static_cast<size_t>(read));
+    }
+    close(fd);
+    if (read < 0) {
+        return false;
+    }
+
+    // "start-end perms offset dev inode [path]", one region per line
+    for (size_t line = 0; line < text.size();) {
+        size_t next = text.find('\n', line);
+        if (next == std::string::npos) {
+            next = text.size();
+        }
+        char* cursor = text.data() + line;
+        const uint64_t start = std::strtoull(cursor, &cursor, 16);
+        const uint64_t end = std::strtoull(cursor + 1, &cursor, 16);
+        const char* perms = cursor + 1;
+        if (perms + 4 <= text.data() + next && end > start) {
+            std::strtoull(perms + 5, &cursor, 16);                   // offset
+            cursor = std::strchr(cursor + 1, ' ');                     // dev
+            const uint64_t inode = cursor ? std::strtoull(cursor + 1, nullptr, 10) : 0;
+            RegionUse use = RegionUse::Shared;
+            if (perms[0] == '-' && perms[1] == '-' && perms[2] == '-') {
+                use = RegionUse::Reserved;
+            } else if (perms[3] == 's') {
+                use = RegionUse::Shared;
+            } else if (inode == 0) {
+                use = RegionUse::Private;
+            } else if (perms[1] == 'w') {
+                use = RegionUse::CopyOnWrite;
+            }
+            regions.push_back({ start, end - start, use });
+        }
+        line = next + 1;
+    }
+    return !regions.empty();
+}
+
+int CompareNoCase(std::wstring_view left, std::wstring_view right) {
+    const size_t length = left.size() < right.size() ? left.size() : right.size();
+    for (size_t i = 0; i < length; ++i) {
+        const wint_t a = std::towlower(static_cast<wint_t>(left[i]));
+        const wint_t b = std::towlower(static_cast<wint_t>(right[i]));
+        if (a != b) {
+            return a < b ? -1 : 1;
+        }
+    }
+    return left.size() == right.size() ? 0 : (left.size() < right.size() ? -1 : 1);
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::Create(const std::wstring& name, size_t size) {
+    const std::string shmName = ToShmName(name);
+    // Exclusive, so a block someone else created first is never written into.
+    int fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0640);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return nullptr;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::make_unique<SharedMemoryPosix>(view, size, shmName);
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::OpenReadOnly(const std::wstring& name, size_t size) {
+    int fd = shm_open(ToShmName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < size) {
+        close(fd);
+        return nullptr;
+    }
+    void* view = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::make_unique<SharedMemoryPosix>(view, size, std::string());
+}
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info = {};
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<size_t>(info.st_size);
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::make_unique<MappedFilePosix>(view, size);
+}
+
+std::unique_ptr<SequentialFile> SequentialFile::Open(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info = {};
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    FileIdentity identity;
+    identity.volume = static_cast<uint64_t>(info.st_dev);
+    identity.fileId = static_cast<uint64_t>(info.st_ino);
+    identity.size = static_cast<uint64_t>(info.st_size);
+    identity.lastWriteTime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return std::make_unique<SequentialFilePosix>(fd, identity);
+}
+
+std::unique_ptr<DirectoryWatch> DirectoryWatch::Create(EventFn onEvent, void* context) {
+    const int inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify < 0) {
+        return nullptr;
+    }
+    const int wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake < 0) {
+        close(inotify);
+        return nullptr;
+    }
+    try {
+        return std::make_unique<DirectoryWatchPosix>(inotify, wake, onEvent, context);
+    } catch (const std::system_error&) {
+        close(inotify);
+        close(wake);
+        return nullptr;
+    }
+}
+
+} // namespace Platform
@@ -0,0 +1,474 @@
+#include "Platform.h"
+
+#include <windows.h>
+#include <objbase.h>
+#include <psapi.h>
+#include <sddl.h>
+
+#include <algorithm>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Platform {
+namespace {
+
+class SharedMemoryWin final : public SharedMemory {
+public:
+    SharedMemoryWin(HANDLE mapping, void* view, size_t size) : mapping_(mapping), view_(view), size_(size) {}
+    ~SharedMemoryWin() override {
+        UnmapViewOfFile(view_);
+        CloseHandle(mapping_);
+    }
+
+    void* Data() const override { return view_; }
+    size_t Size() const override { return size_; }
+
+private:
+    HANDLE mapping_;
+    void* view_;
+    size_t size_;
+};
+
+class MappedFileWin final : public MappedFile {
+public:
+    MappedFileWin(HANDLE mapping, const void* view, size_t size) : mapping_(mapping), view_(view), size_(size) {}
+    ~MappedFileWin() override {
+        UnmapViewOfFile(view_);
+        CloseHandle(mapping_);
+    }
+
+    const uint8_t* Data() const override { return static_cast<const uint8_t*>(view_); }
+    size_t Size() const override { return size_; }
+
+private:
+    HANDLE mapping_;
+    const void* view_;
+    size_t size_;
+};
+
+class SequentialFileWin final : public SequentialFile {
+public:
+    SequentialFileWin(HANDLE file, const FileIdentity& identity) : file_(file), identity_(identity) {}
+    ~SequentialFileWin() override { CloseHandle(file_); }
+
+    const FileIdentity& Identity() const override { return identity_; }
+
+    bool Read(void* buffer, size_t size, size_t& bytesRead) override {
+        bytesRead = 0;
+        while (bytesRead < size) {
+            const DWORD request = static_cast<DWORD>((std::min)(size - bytesRead, size_t{ 1 } << 30));
+            DWORD count = 0;
+            if (!ReadFile(file_, static_cast<char*>(buffer) + bytesRead, request, &count, nullptr)) {
+                return false;
+            }
+            if (count == 0) {
+                break;
+            }
+            bytesRead += count;
+        }
+        return true;
+    }
+
+private:
+    HANDLE file_;
+    FileIdentity identity_;
+};
+
+// One overlapped ReadDirectoryChangesW per directory, all completing on one port. A removed or failed
+// watch is freed only when its outstanding read completes, since the kernel writes into its buffer.
+class DirectoryWatchWin final : public DirectoryWatch {
+public:
+    DirectoryWatchWin(HANDLE port, EventFn onEvent, void* context)
+        : port_(port), onEvent_(onEvent), context_(context), thread_(&DirectoryWatchWin::Run, this) {}
+
+    ~DirectoryWatchWin() override {
+        // A packet without an OVERLAPPED tells the thread to cancel everything and exit once drained.
+        PostQueuedCompletionStatus(port_, 0, 0, nullptr);
+        thread_.join();
+        CloseHandle(port_);
+    }
+
+    bool Add(const std::wstring& directory) override {
+        std::lock_guard lock(mutex_);
+        if (watches_.count(directory)) {
+            return true;
+        }
+        HANDLE handle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        auto watch = std::make_unique<Watch>();
+        watch->directory = directory;
+        watch->handle = handle;
+        if (!CreateIoCompletionPort(handle, port_, reinterpret_cast<ULONG_PTR>(watch.get()), 0) || !Issue(*watch)) {
+            CloseHandle(handle);
+            return false;
+        }
+        watches_.emplace(directory, std::move(watch));
+        return true;
+    }
+
+    void Remove(const std::wstring& directory) override {
+        std::lock_guard lock(mutex_);
+        const auto found = watches_.find(directory);
+        if (found == watches_.end()) {
+            return;
+        }
+        Retire(std::move(found->second));
+        watches_.erase(found);
+    }
+
+private:
+    struct Watch {
+        std::wstring directory;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+        bool removing = false;
+        alignas(DWORD) BYTE buffer[32 * 1024];
+    };
+
+    // Called with mutex_ held.
+    bool Issue(Watch& watch) {
+        watch.overlapped = {};
+        if (!ReadDirectoryChangesW(watch.handle, watch.buffer, sizeof(watch.buffer), FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE, nullptr,
+                &watch.overlapped, nullptr)) {
+            return false;
+        }
+        ++outstanding_;
+        return true;
+    }
+
+    // Called with mutex_ held.
+    void Retire(std::unique_ptr<Watch> watch) {
+        watch->removing = true;
+        CancelIoEx(watch->handle, &watch->overlapped);
+        removing_.push_back(std::move(watch));
+    }
+
+    void Run() {
+        bool quitting = false;
+        std::vector<std::wstring> names;
+        for (;;) {
+            DWORD bytes = 0;
+            ULONG_PTR key = 0;
+            OVERLAPPED* overlapped = nullptr;
+            const BOOL ok = GetQueuedCompletionStatus(port_, &bytes, &key, &overlapped, INFINITE);
+            std::wstring directory;
+            bool lost = false;
+            names.clear();
+            {
+                std::lock_guard lock(mutex_);
+                if (!overlapped) {
+                    quitting = true;
+                    for (auto& [name, watch] : watches_) {
+                        Retire(std::move(watch));
+                    }
+                    watches_.clear();
+                } else {
+                    --outstanding_;
+                    auto* watch = reinterpret_cast<Watch*>(key);
+                    if (watch->removing) {
+                        CloseHandle(watch->handle);
+                        std::erase_if(removing_, [watch](const auto& retired) { return retired.get() == watch; });
+                    } else {
+                        directory = watch->directory;
+                        // A zero-byte completion means the buffer overflowed; a failed one (e.g. the
+                        // directory went away) may also have lost events.
+                        lost = !ok || bytes == 0;
+                        for (DWORD offset = 0; !lost && offset + sizeof(FILE_NOTIFY_INFORMATION) <= bytes;) {
+                            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(watch->buffer + offset);
+                            names.emplace_back(info->FileName, info->FileNameLength / sizeof(wchar_t));
+                            if (info->NextEntryOffset == 0) {
+                                break;
+                            }
+                            offset += info->NextEntryOffset;
+                        }
+                        if (!Issue(*watch)) {
+                            CloseHandle(watch->handle);
+                            watches_.erase(directory);
+                        }
+                    }
+                }
+                if (quitting && outstanding_ == 0) {
+                    return;
+                }
+            }
+            if (lost) {
+                onEvent_(context_, directory, std::wstring());
+            }
+            for (const auto& name : names) {
+                onEvent_(context_, directory, name);
+            }
+        }
+    }
+
+    HANDLE port_;
+    EventFn onEvent_;
+    void* context_;
+    std::mutex mutex_;
+    std::unordered_map<std::wstring, std::unique_ptr<Watch>> watches_;
+    std::vector<std::unique_ptr<Watch>> removing_; // Cancelled, waiting for their reads to complete
+    size_t outstanding_ = 0;                       // Reads issued and not yet completed
+    std::thread thread_; // Last, so it starts after everything it uses
+};
+
+// "D:P(A;;GA;;;OW)(A;;GR;;;<logon SID>)": full access for the owner, read for the logon session, and
+// nothing inherited.
+std::wstring SharedMemorySddl() {
+    std::wstring sddl = L"D:P(A;;GA;;;OW)";
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) {
+        return sddl;
+    }
+    DWORD size = 0;
+    GetTokenInformation(token, TokenGroups, nullptr, 0, &size);
+    std::vector<uint8_t> buffer(size);
+    if (size && GetTokenInformation(token, TokenGroups, buffer.data(), size, &size)) {
+        const auto* groups = reinterpret_cast<const TOKEN_GROUPS*>(buffer.data());
+        for (DWORD i = 0; i < groups->GroupCount; ++i) {
+            if ((groups->Groups[i].Attributes & SE_GROUP_LOGON_ID) != SE_GROUP_LOGON_ID) {
+                continue;
+            }
+            wchar_t* sid = nullptr;
+            if (ConvertSidToStringSidW(groups->Groups[i].Sid, &sid)) {
+                sddl += L"(A;;GR;;;" + std::wstring(sid) + L")";
+                LocalFree(sid);
+            }
+            break;
+        }
+    }
+    CloseHandle(token);
+    return sddl;
+}
+
+struct ThreadStart {
+    ThreadFn run;
+    void* context;
+};
+
+DWORD WINAPI DetachedThreadMain(void* parameter) {
+    const ThreadStart start = *static_cast<ThreadStart*>(parameter);
+    delete static_cast<ThreadStart*>(parameter);
+    // The starter's reference keeps the module loaded until run releases it; this one lasts until the
+    // thread exits, which FreeLibraryAndExitThread does without returning here.
+    HMODULE self = nullptr;
+    const BOOL pinned = GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+        reinterpret_cast<LPCWSTR>(&DetachedThreadMain), &self);
+    start.run(start.context);
+    if (pinned) {
+        FreeLibraryAndExitThread(self, 0);
+    }
+    return 0;
+}
+
+} // namespace
+
+uint32_t CurrentProcessId() {
+    return GetCurrentProcessId();
+}
+
+void DebugOutput(const std::wstring& text) {
+    OutputDebugStringW(text.c_str());
+}
+
+bool StartDetachedThread(ThreadFn run, void* context) {
+    auto* start = new ThreadStart{ run, context };
+    const HANDLE thread = CreateThread(nullptr, 0, DetachedThreadMain, start, 0, nullptr);
+    if (!thread) {
+        delete start;
+        return false;
+    }
+    CloseHandle(thread);
+    return true;
+}
+
+void* AllocateShellMemory(size_t size) {
+    return CoTaskMemAlloc(size);
+}
+
+void FreeShellMemory(void* memory) {
+    CoTaskMemFree(memory);
+}
+
+uint64_t PageSize() {
+    static const uint64_t size = [] {
+        SYSTEM_INFO info = {};
+        GetSystemInfo(&info);
+        return uint64_t{ info.dwPageSize };
+    }();
+    return size;
+}
+
+bool QueryWorkingSet(const uint64_t* pages, size_t count, uint8_t* flags) {
+    std::vector<PSAPI_WORKING_SET_EX_INFORMATION> entries(count);
+    for (size_t i = 0; i < count; ++i) {
+        entries[i].VirtualAddress = reinterpret_cast<PVOID>(static_cast<uintptr_t>(pages[i]));
+    }
+    if (!QueryWorkingSetEx(GetCurrentProcess(), entries.data(), static_cast<DWORD>(entries.size() * sizeof(entries[0])))) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        const auto& attributes = entries[i].VirtualAttributes;
+        flags[i] = attributes.Valid ? static_cast<uint8_t>(kPageResident | (attributes.Shared ? kPageShared : 0)) : 0;
+    }
+    return true;
+}
+
+bool WalkAddressSpace(std::vector<MemoryRegion>& regions) {
+    regions.clear();
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+    auto address = reinterpret_cast<uintptr_t>(info.lpMinimumApplicationAddress);
+    const auto end = reinterpret_cast<uintptr_t>(info.lpMaximumApplicationAddress);
+    MEMORY_BASIC_INFORMATION region = {};
+    while (address <= end && VirtualQuery(reinterpret_cast<LPCVOID>(address), &region, sizeof(region)) == sizeof(region)) {
+        if (region.State != MEM_FREE) {
+            RegionUse use = RegionUse::Reserved;
+            if (region.State == MEM_COMMIT) {
+                // Image sections are mapped copy-on-write, so a writable image page is a written copy: it
+                // reports PAGE_READWRITE from then on. A read-write MEM_MAPPED view writes through to the
+                // section it shares with other processes, so it stays Shared.
+                const DWORD protect = region.Protect & 0xFF;
+                const bool writable = (protect & (PAGE_READWRITE | PAGE_EXECUTE_READWRITE)) != 0;
+                if (protect & (PAGE_WRITECOPY | PAGE_EXECUTE_WRITECOPY)) {
+                    use = RegionUse::CopyOnWrite;
+                } else if (region.Type == MEM_PRIVATE || (region.Type == MEM_IMAGE && writable)) {
+                    use = RegionUse::Private;
+                } else {
+                    use = RegionUse::Shared;
+                }
+            }
+            regions.push_back({ reinterpret_cast<uintptr_t>(region.BaseAddress), region.RegionSize, use });
+        }
+        const auto next = reinterpret_cast<uintptr_t>(region.BaseAddress) + region.RegionSize;
+        if (next <= address) {
+            break;
+        }
+        address = next;
+    }
+    return !regions.empty();
+}
+
+int CompareNoCase(std::wstring_view left, std::wstring_view right) {
+    // Same comparison lstrcmpiW makes, but on counted strings.
+    int result = CompareStringEx(LOCALE_NAME_USER_DEFAULT,
+        NORM_IGNORECASE,
+        left.data(),
+        static_cast<int>(left.size()),
+        right.data(),
+        static_cast<int>(right.size()),
+        nullptr,
+        nullptr,
+        0);
+    return result == 0 ? 0 : result - CSTR_EQUAL;
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::Create(const std::wstring& name, size_t size) {
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(SharedMemorySddl().c_str(), SDDL_REVISION_1, &descriptor, nullptr)) {
+        return nullptr;
+    }
+    SECURITY_ATTRIBUTES attributes = { sizeof(attributes), descriptor, FALSE };
+    const auto size64 = static_cast<ULONGLONG>(size);
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE,
+        &attributes,
+        PAGE_READWRITE,
+        static_cast<DWORD>(size64 >> 32),
+        static_cast<DWORD>(size64),
+        name.c_str());
+    const DWORD error = GetLastError();
+    LocalFree(descriptor);
+    if (!mapping) {
+        return nullptr;
+    }
+    // Pre-created by someone else, with their size and their ACL: do not publish into it.
+    if (error == ERROR_ALREADY_EXISTS) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    return std::make_unique<SharedMemoryWin>(mapping, view, size);
+}
+
+std::unique_ptr<SharedMemory> SharedMemory::OpenReadOnly(const std::wstring& name, size_t size) {
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, name.c_str());
+    if (!mapping) {
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if (!view) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    return std::make_unique<SharedMemoryWin>(mapping, view, size);
+}
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size = {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+        static_cast<ULONGLONG>(size.QuadPart) > static_cast<ULONGLONG>(SIZE_MAX)) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // The mapping keeps the file open.
+    CloseHandle(file);
+    if (!mapping) {
+        return nullptr;
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    return std::make_unique<MappedFileWin>(mapping, view, static_cast<size_t>(size.QuadPart));
+}
+
+std::unique_ptr<SequentialFile> SequentialFile::Open(const std::filesystem::path& path) {
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    BY_HANDLE_FILE_INFORMATION info = {};
+    if (!GetFileInformationByHandle(file, &info)) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    FileIdentity identity;
+    identity.volume = info.dwVolumeSerialNumber;
+    identity.fileId = uint64_t{ info.nFileIndexHigh } << 32 | info.nFileIndexLow;
+    identity.size = uint64_t{ info.nFileSizeHigh } << 32 | info.nFileSizeLow;
+    identity.lastWriteTime = static_cast<int64_t>(uint64_t{ info.ftLastWriteTime.dwHighDateTime } << 32 |
+        info.ftLastWriteTime.dwLowDateTime);
+    return std::make_unique<SequentialFileWin>(file, identity);
+}
+
+std::unique_ptr<DirectoryWatch> DirectoryWatch::Create(EventFn onEvent, void* context) {
+    HANDLE port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (!port) {
+        return nullptr;
+    }
+    try {
+        return std::make_unique<DirectoryWatchWin>(port, onEvent, context);
+    } catch (const std::system_error&) {
+        CloseHandle(port);
+        return nullptr;
+    }
+}
+
+} // namespace Platform
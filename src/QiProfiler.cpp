@@ -0,0 +1,186 @@
+#include "QiProfiler.h"
+
+#include "IidTable.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace QiProfiler {
+namespace {
+
+constexpr size_t kSourceCount = static_cast<size_t>(Source::Count);
+constexpr size_t kMaxUnknownGuids = 64;
+
+constexpr std::array<const wchar_t*, kSourceCount> kSourceNames = {
+    L"ModuleFolder",
+    L"ItemContextMenu",
+    L"ClassFactory",
+    L"ModuleTreeFolder",
+    L"ItemIcon",
+};
+
+// counts[source][entry][accepted]
+class KnownCounters {
+public:
+    KnownCounters() : entries_(IidTable::Size()), counts_(new std::atomic<uint64_t>[kSourceCount * entries_ * 2]()) {}
+
+    std::atomic<uint64_t>& At(Source source, size_t entry, bool accepted) {
+        return counts_[(static_cast<size_t>(source) * entries_ + entry) * 2 + (accepted ? 1 : 0)];
+    }
+
+    size_t Entries() const { return entries_; }
+
+private:
+    size_t entries_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+};
+
+KnownCounters& Known() {
+    static KnownCounters counters;
+    return counters;
+}
+
+struct UnknownKey {
+    Source source;
+    Guid iid;
+
+    bool operator==(const UnknownKey& other) const { return source == other.source && iid == other.iid; }
+};
+
+struct UnknownKeyHash {
+    size_t operator()(const UnknownKey& key) const {
+        return GuidHash()(key.iid) ^ static_cast<size_t>(key.source);
+    }
+};
+
+struct UnknownState {
+    std::mutex mutex;
+    std::unordered_map<UnknownKey, Totals, UnknownKeyHash> counts;
+    std::array<Totals, kSourceCount> overflow{}; // Unknown GUIDs seen after the map filled up
+};
+
+UnknownState& Unknown() {
+    static UnknownState state;
+    return state;
+}
+
+struct Row {
+    Source source;
+    std::wstring name;
+    Totals totals;
+};
+
+std::wstring NameFor(const Guid& iid) {
+    const wchar_t* name = IidTable::Lookup(iid);
+    return name ? std::wstring(name) : iid.ToString();
+}
+
+} // namespace
+
+const wchar_t* SourceName(Source source) {
+    auto index = static_cast<size_t>(source);
+    return index < kSourceNames.size() ? kSourceNames[index] : L"Unknown";
+}
+
+void Record(Source source, const Guid& iid, bool accepted) {
+    const int entry = IidTable::IndexOf(iid);
+    if (entry >= 0) {
+        Known().At(source, static_cast<size_t>(entry), accepted).fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& unknown = Unknown();
+    std::lock_guard<std::mutex> lock(unknown.mutex);
+    const UnknownKey key{ source, iid };
+    auto it = unknown.counts.find(key);
+    Totals* totals = nullptr;
+    if (it != unknown.counts.end()) {
+        totals = &it->second;
+    } else if (unknown.counts.size() < kMaxUnknownGuids) {
+        totals = &unknown.counts.emplace(key, Totals{}).first->second;
+    } else {
+        totals = &unknown.overflow[static_cast<size_t>(source)];
+    }
+    ++(accepted ? totals->accepted : totals->rejected);
+}
+
+Totals Get(Source source, const Guid& iid) {
+    const int entry = IidTable::IndexOf(iid);
+    if (entry >= 0) {
+        auto& known = Known();
+        return { known.At(source, static_cast<size_t>(entry), true).load(std::memory_order_relaxed),
+            known.At(source, static_cast<size_t>(entry), false).load(std::memory_order_relaxed) };
+    }
+    auto& unknown = Unknown();
+    std::lock_guard<std::mutex> lock(unknown.mutex);
+    auto it = unknown.counts.find(UnknownKey{ source, iid });
+    return it != unknown.counts.end() ? it->second : Totals{};
+}
+
+std::wstring FormatReport(size_t maxEntries) {
+    std::vector<Row> rows;
+    auto& known = Known();
+    for (size_t s = 0; s < kSourceCount; ++s) {
+        const auto source = static_cast<Source>(s);
+        for (size_t entry = 0; entry < known.Entries(); ++entry) {
+            const Totals totals{ known.At(source, entry, true).load(std::memory_order_relaxed),
+                known.At(source, entry, false).load(std::memory_order_relaxed) };
+            if (totals.accepted + totals.rejected != 0) {
+                rows.push_back({ source, IidTable::NameAt(entry), totals });
+            }
+        }
+    }
+    {
+        auto& unknown = Unknown();
+        std::lock_guard<std::mutex> lock(unknown.mutex);
+        for (const auto& [key, totals] : unknown.counts) {
+            rows.push_back({ key.source, NameFor(key.iid), totals });
+        }
+        for (size_t s = 0; s < kSourceCount; ++s) {
+            const Totals& totals = unknown.overflow[s];
+            if (totals.accepted + totals.rejected != 0) {
+                rows.push_back({ static_cast<Source>(s), L"(other unknown interfaces)", totals });
+            }
+        }
+    }
+
+    const size_t count = std::min(maxEntries, rows.size());
+    std::partial_sort(rows.begin(), rows.begin() + count, rows.end(), [](const Row& a, const Row& b) {
+        return a.totals.accepted + a.totals.rejected > b.totals.accepted + b.totals.rejected;
+    });
+
+    std::wstring report;
+    for (size_t i = 0; i < count; ++i) {
+        const Row& row = rows[i];
+        report += SourceName(row.source);
+        report += L" ";
+        report += row.name;
+        report += L": " + std::to_wstring(row.totals.accepted + row.totals.rejected);
+        if (row.totals.rejected != 0) {
+            report += L" (" + std::to_wstring(row.totals.rejected) + L" rejected)";
+        }
+        report += L"\n";
+    }
+    return report;
+}
+
+void Reset() {
+    auto& known = Known();
+    for (size_t s = 0; s < kSourceCount; ++s) {
+        for (size_t entry = 0; entry < known.Entries(); ++entry) {
+            known.At(static_cast<Source>(s), entry, true).store(0, std::memory_order_relaxed);
+            known.At(static_cast<Source>(s), entry, false).store(0, std::memory_order_relaxed);
+        }
+    }
+    auto& unknown = Unknown();
+    std::lock_guard<std::mutex> lock(unknown.mutex);
+    unknown.counts.clear();
+    unknown.overflow = {};
+}
+
+} // namespace QiProfiler
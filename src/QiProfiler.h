@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Guid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Counts QueryInterface traffic per interface for the objects Explorer talks to, split into requests we
+// satisfied and requests we rejected. Rejections that Explorer keeps repeating point at interfaces worth
+// implementing to keep it off its fallback paths.
+//
+// Known interfaces (IidTable) are counted with lock-free atomics; unknown GUIDs go to a small map behind
+// a mutex, capped so a misbehaving caller cannot grow it without bound.
+namespace QiProfiler {
+
+enum class Source : uint32_t {
+    ModuleFolder,
+    ItemContextMenu,
+    ClassFactory,
+    ModuleTreeFolder,
+    ItemIcon,
+    Count
+};
+
+const wchar_t* SourceName(Source source);
+
+void Record(Source source, const Guid& iid, bool accepted);
+
+struct Totals {
+    uint64_t accepted;
+    uint64_t rejected;
+};
+
+/// @brief Counts for one interface on one source.
+Totals Get(Source source, const Guid& iid);
+
+/// @brief The busiest interfaces across all sources, one line each, most requested first. Empty when no
+/// calls have been recorded.
+std::wstring FormatReport(size_t maxEntries);
+
+void Reset();
+
+} // namespace QiProfiler
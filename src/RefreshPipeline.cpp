@@ -0,0 +1,80 @@
+#include "RefreshPipeline.h"
+
+#include "Diagnostics.h"
+#include "Log.h"
+#include "Platform.h"
+
+#include <thread>
+
+void RefreshPipeline::OnLoaderEvent() {
+    const auto now = Perf::Clock::now();
+    events_.fetch_add(1, std::memory_order_acq_rel);
+    Diagnostics::Increment(Diagnostics::Counter::LoaderEventsReceived);
+    if (pending_.exchange(true, std::memory_order_acq_rel)) {
+        coalesced_.fetch_add(1, std::memory_order_relaxed);
+        Diagnostics::Increment(Diagnostics::Counter::LoaderEventsCoalesced);
+        return;
+    }
+
+    // Execute the refresh on a separate thread to avoid deadlock issues
+    // "It is unsafe for the notification callback to call functions in ANY other module other than itself."
+    pendingSince_.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+    inFlight_.fetch_add(1, std::memory_order_acq_rel);
+    threadsStarted_.fetch_add(1, std::memory_order_relaxed);
+    const Platform::ThreadFn run = [](void* self) { static_cast<RefreshPipeline*>(self)->RunRefresh(); };
+    if (!Platform::StartDetachedThread(run, this)) {
+        // Let the next event try again rather than leaving every later event coalesced into nothing.
+        threadsStarted_.fetch_sub(1, std::memory_order_relaxed);
+        inFlight_.fetch_sub(1, std::memory_order_acq_rel);
+        pending_.store(false, std::memory_order_release);
+        LOG_ERROR(L"Could not start a refresh thread");
+        return;
+    }
+    Diagnostics::Increment(Diagnostics::Counter::RefreshThreadsStarted);
+}
+
+VOID CALLBACK RefreshPipeline::DllNotificationCallback(
+    _In_     ULONG                       NotificationReason,
+    _In_     PCLDR_DLL_NOTIFICATION_DATA NotificationData,
+    _In_opt_ PVOID                       Context
+) {
+    (void)NotificationData;
+    if (Context && (NotificationReason == LDR_DLL_NOTIFICATION_REASON_LOADED ||
+                    NotificationReason == LDR_DLL_NOTIFICATION_REASON_UNLOADED)) {
+        static_cast<RefreshPipeline*>(Context)->OnLoaderEvent();
+    }
+}
+
+void RefreshPipeline::RunRefresh() {
+    const Perf::Clock::time_point since(Perf::Clock::duration(pendingSince_.load(std::memory_order_relaxed)));
+    // Clear before notifying so that a load racing with this refresh still schedules one of its own.
+    pending_.store(false, std::memory_order_release);
+    const uint64_t seen = events_.load(std::memory_order_acquire);
+
+    notify_();
+
+    Perf::RecordSpan(Perf::Op::LoaderRefresh, since, Perf::Clock::now());
+    uint64_t covered = covered_.load(std::memory_order_relaxed);
+    while (covered < seen && !covered_.compare_exchange_weak(covered, seen, std::memory_order_acq_rel)) {
+    }
+    refreshes_.fetch_add(1, std::memory_order_relaxed);
+    inFlight_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void RefreshPipeline::Drain() const {
+    while (inFlight_.load(std::memory_order_acquire) != 0) {
+        std::this_thread::yield();
+    }
+}
+
+RefreshPipeline::Stats RefreshPipeline::GetStats() const {
+    Stats stats = {};
+    stats.events = events_.load(std::memory_order_acquire);
+    stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+    stats.threadsStarted = threadsStarted_.load(std::memory_order_relaxed);
+    stats.refreshes = refreshes_.load(std::memory_order_relaxed);
+    const uint64_t covered = covered_.load(std::memory_order_acquire);
+    stats.uncovered = stats.events > covered ? stats.events - covered : 0;
+    stats.inFlight = inFlight_.load(std::memory_order_acquire);
+    return stats;
+}
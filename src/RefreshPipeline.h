@@ -0,0 +1,63 @@
+#pragma once
+
+#include "NtDll.h"
+#include "Perf.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Turns loader notifications into folder refreshes. The loader callback runs under the loader lock, so
+// it only records the event and, unless a refresh is already pending, starts a thread to send one.
+// Events that arrive while a refresh is pending ride along with it (coalesced).
+//
+// The refresh itself is injected: the extension notifies the shell, the storm simulator counts.
+class RefreshPipeline {
+public:
+    /// @brief Sends one refresh. Runs on a refresh thread, never under the loader lock.
+    using NotifyFn = void (*)();
+
+    struct Stats {
+        uint64_t events;         // Loaded and unloaded notifications received
+        uint64_t coalesced;      // Events that found a refresh already pending
+        uint64_t threadsStarted;
+        uint64_t refreshes;      // Notify calls completed
+        uint64_t uncovered;      // Events no completed refresh was sent after (0 once drained)
+        uint32_t inFlight;       // Refresh threads started and not yet finished
+    };
+
+    explicit RefreshPipeline(NotifyFn notify) : notify_(notify) {}
+
+    RefreshPipeline(const RefreshPipeline&) = delete;
+    RefreshPipeline& operator=(const RefreshPipeline&) = delete;
+
+    /// @brief Records one loader event and schedules a refresh unless one is already pending.
+    void OnLoaderEvent();
+
+    /// @brief PLDR_DLL_NOTIFICATION_FUNCTION to register with LdrRegisterDllNotification; context is
+    /// the RefreshPipeline. Only loaded and unloaded notifications count as events.
+    static VOID CALLBACK DllNotificationCallback(
+        _In_     ULONG                       NotificationReason,
+        _In_     PCLDR_DLL_NOTIFICATION_DATA NotificationData,
+        _In_opt_ PVOID                       Context);
+
+    /// @brief Waits until no refresh thread is running. Threads are detached, so an owner that is about to
+    /// go away must drain first.
+    void Drain() const;
+
+    Stats GetStats() const;
+
+private:
+    void RunRefresh();
+
+    NotifyFn notify_;
+    // Set while a refresh thread is queued but has not yet started.
+    std::atomic<bool> pending_{ false };
+    // Time of the event that set pending_; read by the thread that event started.
+    std::atomic<Perf::Clock::rep> pendingSince_{ 0 };
+    std::atomic<uint32_t> inFlight_{ 0 };
+    std::atomic<uint64_t> events_{ 0 };
+    std::atomic<uint64_t> coalesced_{ 0 };
+    std::atomic<uint64_t> threadsStarted_{ 0 };
+    std::atomic<uint64_t> refreshes_{ 0 };
+    std::atomic<uint64_t> covered_{ 0 }; // Events seen by the latest completed refresh
+};
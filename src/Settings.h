@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Per-user tuning knobs stored under HKCU\Software\ExplorerModulesNamespace. Everything here is
+// optional; callers supply the value to use when a setting is absent. Off Windows, setting "Name" comes
+// from the environment variable EXPLORER_MODULES_Name.
+namespace Settings {
+
+/// @brief Reads a REG_DWORD value, returning defaultValue if it is missing or has another type.
+uint32_t ReadDword(const wchar_t* name, uint32_t defaultValue);
+
+/// @brief Reads a REG_SZ / REG_EXPAND_SZ value (environment variables expanded), or an empty string.
+std::wstring ReadString(const wchar_t* name);
+
+} // namespace Settings
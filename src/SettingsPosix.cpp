@@ -0,0 +1,49 @@
+#include "Settings.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <string>
+
+namespace Settings {
+namespace {
+// Stand-in for the registry key: a setting "Name" is read from the environment variable
+// EXPLORER_MODULES_Name.
+const char* Lookup(const wchar_t* name) {
+    std::string variable = "EXPLORER_MODULES_";
+    for (const wchar_t* ch = name; *ch; ++ch) {
+        variable += static_cast<char>(*ch < 0x80 ? *ch : '_');
+    }
+    return std::getenv(variable.c_str());
+}
+} // namespace
+
+uint32_t ReadDword(const wchar_t* name, uint32_t defaultValue) {
+    const char* text = Lookup(name);
+    if (!text || !*text) {
+        return defaultValue;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const unsigned long long value = std::strtoull(text, &end, 0);
+    if (errno != 0 || *end != '\0' || value > std::numeric_limits<uint32_t>::max()) {
+        return defaultValue;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+std::wstring ReadString(const wchar_t* name) {
+    const char* text = Lookup(name);
+    if (!text) {
+        return {};
+    }
+    std::wstring result(std::mbstowcs(nullptr, text, 0) + 1, L'\0');
+    const size_t length = std::mbstowcs(result.data(), text, result.size());
+    if (length == static_cast<size_t>(-1)) {
+        return {};
+    }
+    result.resize(length);
+    return result;
+}
+
+} // namespace Settings
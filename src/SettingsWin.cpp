@@ -0,0 +1,35 @@
+#include "Settings.h"
+
+#include <windows.h>
+#include <vector>
+
+namespace Settings {
+namespace {
+constexpr wchar_t kSettingsKey[] = L"Software\\ExplorerModulesNamespace";
+} // namespace
+
+uint32_t ReadDword(const wchar_t* name, uint32_t defaultValue) {
+    DWORD value = 0;
+    DWORD size = sizeof(value);
+    if (RegGetValueW(HKEY_CURRENT_USER, kSettingsKey, name, RRF_RT_REG_DWORD, nullptr, &value, &size) != ERROR_SUCCESS) {
+        return defaultValue;
+    }
+    return value;
+}
+
+std::wstring ReadString(const wchar_t* name) {
+    DWORD size = 0;
+    const DWORD flags = RRF_RT_REG_SZ | RRF_RT_REG_EXPAND_SZ;
+    if (RegGetValueW(HKEY_CURRENT_USER, kSettingsKey, name, flags, nullptr, nullptr, &size) != ERROR_SUCCESS ||
+        size < sizeof(wchar_t)) {
+        return {};
+    }
+    std::vector<wchar_t> buffer(size / sizeof(wchar_t) + 1);
+    size = static_cast<DWORD>(buffer.size() * sizeof(wchar_t));
+    if (RegGetValueW(HKEY_CURRENT_USER, kSettingsKey, name, flags, nullptr, buffer.data(), &size) != ERROR_SUCCESS) {
+        return {};
+    }
+    return buffer.data();
+}
+
+} // namespace Settings
@@ -0,0 +1,339 @@
+#include "Sha.h"
+
+#include <cstring>
+
+#if defined(EXPLORER_MODULES_X64)
+#include <immintrin.h>
+#endif
+
+namespace Sha {
+namespace {
+
+constexpr uint32_t kRound256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+uint32_t LoadBigEndian(const uint8_t* bytes) {
+    return uint32_t{ bytes[0] } << 24 | uint32_t{ bytes[1] } << 16 | uint32_t{ bytes[2] } << 8 | bytes[3];
+}
+
+void StoreBigEndian(uint8_t* bytes, uint32_t value) {
+    bytes[0] = static_cast<uint8_t>(value >> 24);
+    bytes[1] = static_cast<uint8_t>(value >> 16);
+    bytes[2] = static_cast<uint8_t>(value >> 8);
+    bytes[3] = static_cast<uint8_t>(value);
+}
+
+uint32_t RotateRight(uint32_t value, int count) {
+    return value >> count | value << (32 - count);
+}
+
+uint32_t RotateLeft(uint32_t value, int count) {
+    return value << count | value >> (32 - count);
+}
+
+void Compress256Scalar(uint32_t* state, const uint8_t* blocks, size_t count) {
+    for (; count != 0; --count, blocks += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = LoadBigEndian(blocks + 4 * i);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t t1 = h + (RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25)) + ((e & f) ^ (~e & g)) +
+                kRound256[i] + w[i];
+            const uint32_t t2 = (RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+void Compress1Scalar(uint32_t* state, const uint8_t* blocks, size_t count) {
+    for (; count != 0; --count, blocks += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = LoadBigEndian(blocks + 4 * i);
+        }
+        for (int i = 16; i < 80; ++i) {
+            w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f = 0;
+            uint32_t k = 0;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            const uint32_t t = RotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = RotateLeft(b, 30);
+            b = a;
+            a = t;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+}
+
+#if defined(EXPLORER_MODULES_X64)
+// The SHA extensions keep the SHA-256 state as two vectors, ABEF and CDGH, and each SHA256RNDS2 does two
+// rounds. The message schedule for rounds 16-63 is built four words at a time by MSG1/MSG2 from the
+// previous four groups, held in a ring of four registers.
+EXPLORER_MODULES_TARGET_SHA
+void Compress256Extensions(uint32_t* state, const uint8_t* blocks, size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i dcba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    __m128i hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    const __m128i cdab = _mm_shuffle_epi32(dcba, 0xB1);
+    const __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1B);
+    __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xF0);
+
+    for (; count != 0; --count, blocks += 64) {
+        const __m128i abefSaved = abef;
+        const __m128i cdghSaved = cdgh;
+        __m128i message[4];
+        for (int group = 0; group < 16; ++group) {
+            __m128i& current = message[group % 4];
+            if (group < 4) {
+                current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * group)), byteSwap);
+            }
+            __m128i words = _mm_add_epi32(current, _mm_loadu_si128(reinterpret_cast<const __m128i*>(kRound256 + 4 * group)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+            if (group >= 3 && group <= 14) {
+                __m128i& next = message[(group + 1) % 4];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(current, message[(group + 3) % 4], 4));
+                next = _mm_sha256msg2_epu32(next, current);
+            }
+            words = _mm_shuffle_epi32(words, 0x0E);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, words);
+            if (group >= 1 && group <= 12) {
+                __m128i& previous = message[(group + 3) % 4];
+                previous = _mm_sha256msg1_epu32(previous, current);
+            }
+        }
+        abef = _mm_add_epi32(abef, abefSaved);
+        cdgh = _mm_add_epi32(cdgh, cdghSaved);
+    }
+
+    const __m128i feba = _mm_shuffle_epi32(abef, 0x1B);
+    const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xB1);
+    dcba = _mm_blend_epi16(feba, dchg, 0xF0);
+    hgfe = _mm_alignr_epi8(dchg, feba, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), dcba);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), hgfe);
+}
+
+// SHA1RNDS4 does four rounds; E is carried separately and folded into the next message group by
+// SHA1NEXTE. Each schedule group n >= 4 is built over three steps: MSG1 three groups ahead, an XOR two
+// ahead and MSG2 one ahead.
+EXPLORER_MODULES_TARGET_SHA
+void Compress1Extensions(uint32_t* state, const uint8_t* blocks, size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+    __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+    for (; count != 0; --count, blocks += 64) {
+        const __m128i abcdSaved = abcd;
+        const __m128i eSaved = e0;
+        __m128i e1 = _mm_setzero_si128();
+        __m128i message[4];
+        for (int group = 0; group < 20; ++group) {
+            __m128i& current = message[group % 4];
+            if (group < 4) {
+                current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * group)), byteSwap);
+            }
+            // E for this group comes from the ABCD saved before the previous one; the two registers alternate.
+            __m128i& e = group % 2 == 0 ? e0 : e1;
+            __m128i& saved = group % 2 == 0 ? e1 : e0;
+            e = group == 0 ? _mm_add_epi32(e, current) : _mm_sha1nexte_epu32(e, current);
+            saved = abcd;
+            if (group >= 3 && group <= 18) {
+                __m128i& next = message[(group + 1) % 4];
+                next = _mm_sha1msg2_epu32(next, current);
+            }
+            switch (group / 5) {
+            case 0:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+                break;
+            case 1:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 1);
+                break;
+            case 2:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 2);
+                break;
+            default:
+                abcd = _mm_sha1rnds4_epu32(abcd, e, 3);
+                break;
+            }
+            if (group >= 1 && group <= 16) {
+                __m128i& previous = message[(group + 3) % 4];
+                previous = _mm_sha1msg1_epu32(previous, current);
+            }
+            if (group >= 2 && group <= 17) {
+                __m128i& later = message[(group + 2) % 4];
+                later = _mm_xor_si128(later, current);
+            }
+        }
+        // Group 19 is odd, so e0 holds the ABCD from before it.
+        e0 = _mm_sha1nexte_epu32(e0, eSaved);
+        abcd = _mm_add_epi32(abcd, abcdSaved);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+#endif
+
+// Shared Merkle-Damgard framing: buffers partial blocks and hands whole ones to compress.
+template <class Compress>
+void Absorb(uint8_t* buffer, size_t& buffered, uint64_t& length, const void* data, size_t size, Compress compress) {
+    if (size == 0) {
+        return;
+    }
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    length += size;
+    if (buffered != 0) {
+        const size_t take = size < 64 - buffered ? size : 64 - buffered;
+        std::memcpy(buffer + buffered, bytes, take);
+        buffered += take;
+        bytes += take;
+        size -= take;
+        if (buffered < 64) {
+            return;
+        }
+        compress(buffer, 1);
+        buffered = 0;
+    }
+    if (size >= 64) {
+        compress(bytes, size / 64);
+        bytes += size / 64 * 64;
+        size %= 64;
+    }
+    std::memcpy(buffer, bytes, size);
+    buffered = size;
+}
+
+template <class Compress>
+void Pad(uint8_t* buffer, size_t buffered, uint64_t length, Compress compress) {
+    buffer[buffered++] = 0x80;
+    if (buffered > 56) {
+        std::memset(buffer + buffered, 0, 64 - buffered);
+        compress(buffer, 1);
+        buffered = 0;
+    }
+    std::memset(buffer + buffered, 0, 56 - buffered);
+    const uint64_t bits = length * 8;
+    StoreBigEndian(buffer + 56, static_cast<uint32_t>(bits >> 32));
+    StoreBigEndian(buffer + 60, static_cast<uint32_t>(bits));
+    compress(buffer, 1);
+}
+
+} // namespace
+
+Sha256::Sha256(bool useExtensions)
+    : state_{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+      buffer_{}, extensions_(useExtensions) {}
+
+void Sha256::Compress(const uint8_t* blocks, size_t count) {
+#if defined(EXPLORER_MODULES_X64)
+    if (extensions_) {
+        Compress256Extensions(state_, blocks, count);
+        return;
+    }
+#endif
+    Compress256Scalar(state_, blocks, count);
+}
+
+void Sha256::Update(const void* data, size_t size) {
+    Absorb(buffer_, buffered_, length_, data, size, [this](const uint8_t* blocks, size_t count) { Compress(blocks, count); });
+}
+
+Sha256::Digest Sha256::Final() {
+    Pad(buffer_, buffered_, length_, [this](const uint8_t* blocks, size_t count) { Compress(blocks, count); });
+    Digest digest;
+    for (size_t i = 0; i < 8; ++i) {
+        StoreBigEndian(digest.data() + 4 * i, state_[i]);
+    }
+    return digest;
+}
+
+Sha1::Sha1(bool useExtensions)
+    : state_{ 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 }, buffer_{}, extensions_(useExtensions) {}
+
+void Sha1::Compress(const uint8_t* blocks, size_t count) {
+#if defined(EXPLORER_MODULES_X64)
+    if (extensions_) {
+        Compress1Extensions(state_, blocks, count);
+        return;
+    }
+#endif
+    Compress1Scalar(state_, blocks, count);
+}
+
+void Sha1::Update(const void* data, size_t size) {
+    Absorb(buffer_, buffered_, length_, data, size, [this](const uint8_t* blocks, size_t count) { Compress(blocks, count); });
+}
+
+Sha1::Digest Sha1::Final() {
+    Pad(buffer_, buffered_, length_, [this](const uint8_t* blocks, size_t count) { Compress(blocks, count); });
+    Digest digest;
+    for (size_t i = 0; i < 5; ++i) {
+        StoreBigEndian(digest.data() + 4 * i, state_[i]);
+    }
+    return digest;
+}
+
+std::wstring ToHex(const uint8_t* digest, size_t size) {
+    static constexpr wchar_t kDigits[] = L"0123456789abcdef";
+    std::wstring text(size * 2, L'0');
+    for (size_t i = 0; i < size; ++i) {
+        text[2 * i] = kDigits[digest[i] >> 4];
+        text[2 * i + 1] = kDigits[digest[i] & 15];
+    }
+    return text;
+}
+
+} // namespace Sha
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Simd.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Streaming SHA-256 and SHA-1. Whole 64-byte blocks go straight from the caller's buffer to the
+// compression function, which uses the x64 SHA extensions when the CPU has them and portable code
+// otherwise; only a partial block at either end is copied.
+namespace Sha {
+
+class Sha256 {
+public:
+    static constexpr size_t kDigestSize = 32;
+    using Digest = std::array<uint8_t, kDigestSize>;
+
+    explicit Sha256(bool useExtensions = Simd::ShaExtensions());
+
+    void Update(const void* data, size_t size);
+
+    /// @brief Pads and returns the digest. The object must not be updated afterwards.
+    Digest Final();
+
+private:
+    void Compress(const uint8_t* blocks, size_t count);
+
+    uint32_t state_[8];
+    uint8_t buffer_[64];
+    size_t buffered_ = 0;
+    uint64_t length_ = 0;
+    bool extensions_;
+};
+
+class Sha1 {
+public:
+    static constexpr size_t kDigestSize = 20;
+    using Digest = std::array<uint8_t, kDigestSize>;
+
+    explicit Sha1(bool useExtensions = Simd::ShaExtensions());
+
+    void Update(const void* data, size_t size);
+    Digest Final();
+
+private:
+    void Compress(const uint8_t* blocks, size_t count);
+
+    uint32_t state_[5];
+    uint8_t buffer_[64];
+    size_t buffered_ = 0;
+    uint64_t length_ = 0;
+    bool extensions_;
+};
+
+/// @brief Lowercase hex, as sha256sum and Get-FileHash (after lowercasing) print it.
+std::wstring ToHex(const uint8_t* digest, size_t size);
+
+} // namespace Sha
@@ -0,0 +1,505 @@
+#include "SignatureScan.h"
+
+#include "PeImage.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <cwctype>
+#include <mutex>
+#include <thread>
+
+#if defined(EXPLORER_MODULES_X64)
+#include <immintrin.h>
+#endif
+
+namespace SignatureScan {
+namespace {
+
+constexpr uint32_t kNoState = 0xFFFFFFFFu;
+
+// The shufti prefilter pays for itself only while few bytes pass it: each byte that does costs a pair
+// lookup and a branch the scalar loop does not take. Past this many of the 256 byte values the pair
+// table alone is faster.
+constexpr uint32_t kMaxShuftiBytes = 32;
+
+int HexDigit(wchar_t c) {
+    if (c >= L'0' && c <= L'9') {
+        return c - L'0';
+    }
+    if (c >= L'a' && c <= L'f') {
+        return c - L'a' + 10;
+    }
+    if (c >= L'A' && c <= L'F') {
+        return c - L'A' + 10;
+    }
+    return -1;
+}
+
+bool ParseHex(std::wstring_view text, Pattern& pattern, std::wstring& error) {
+    for (size_t i = 0; i < text.size();) {
+        if (std::iswspace(text[i])) {
+            ++i;
+            continue;
+        }
+        if (text[i] == L'?') {
+            // "??" and a lone "?" are both one wildcard byte.
+            i += (i + 1 < text.size() && text[i + 1] == L'?') ? 2 : 1;
+            pattern.bytes.push_back(0);
+            pattern.mask.push_back(0);
+            continue;
+        }
+        const int high = HexDigit(text[i]);
+        const int low = i + 1 < text.size() ? HexDigit(text[i + 1]) : -1;
+        if (high < 0 || low < 0) {
+            error = L"Expected a hex byte or ?? at position " + std::to_wstring(i + 1);
+            return false;
+        }
+        pattern.bytes.push_back(static_cast<uint8_t>(high << 4 | low));
+        pattern.mask.push_back(0xFF);
+        i += 2;
+    }
+    return true;
+}
+
+bool ParseString(std::wstring_view text, bool wide, Pattern& pattern, std::wstring& error) {
+    if (text.size() < 2 || text.back() != L'"') {
+        error = L"Missing closing quote";
+        return false;
+    }
+    text = text.substr(1, text.size() - 2);
+    auto append = [&](uint8_t byte) {
+        pattern.bytes.push_back(byte);
+        pattern.mask.push_back(0xFF);
+    };
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t c = static_cast<uint32_t>(text[i]);
+        if (c == L'\\' && i + 1 < text.size()) {
+            c = static_cast<uint32_t>(text[++i]);
+        }
+        if (!wide) {
+            if (c > 0x7F) {
+                error = L"Non-ASCII character in a \"...\" string; use w\"...\" for UTF-16";
+                return false;
+            }
+            append(static_cast<uint8_t>(c));
+        } else if (c > 0xFFFF) {
+            // Only reachable where wchar_t is 32 bits.
+            c -= 0x10000;
+            const uint16_t units[2] = { static_cast<uint16_t>(0xD800 | c >> 10), static_cast<uint16_t>(0xDC00 | (c & 0x3FF)) };
+            for (const uint16_t unit : units) {
+                append(static_cast<uint8_t>(unit));
+                append(static_cast<uint8_t>(unit >> 8));
+            }
+        } else {
+            append(static_cast<uint8_t>(c));
+            append(static_cast<uint8_t>(c >> 8));
+        }
+    }
+    return true;
+}
+
+// The longest run of fixed bytes, the first one on ties, cut to kMaxAnchorBytes.
+void FindAnchor(const Pattern& pattern, size_t& offset, size_t& length) {
+    offset = 0;
+    length = 0;
+    for (size_t i = 0; i < pattern.mask.size();) {
+        if (pattern.mask[i] != 0xFF) {
+            ++i;
+            continue;
+        }
+        size_t end = i;
+        while (end < pattern.mask.size() && pattern.mask[end] == 0xFF) {
+            ++end;
+        }
+        if (end - i > length) {
+            offset = i;
+            length = end - i;
+        }
+        i = end;
+    }
+    length = std::min(length, kMaxAnchorBytes);
+}
+
+// Whether the two bytes at position can start an anchor; a lone last byte always may.
+inline bool PairAt(const uint64_t* pairs, const uint8_t* data, size_t position, size_t size) {
+    if (position + 1 >= size) {
+        return true;
+    }
+    const uint32_t pair = uint32_t{ data[position] } << 8 | data[position + 1];
+    return (pairs[pair >> 6] >> (pair & 63) & 1) != 0;
+}
+
+// The SIMD finders below test the first byte of 16 or 32 positions at once, then the pair table for each
+// position that passed, so dense first bytes do not keep restarting the vector loop.
+#if defined(EXPLORER_MODULES_X64)
+size_t FindNeedlesSse2(const uint8_t* data, size_t position, size_t size, const uint8_t* needles, uint32_t count,
+    const uint64_t* pairs) {
+    const __m128i n0 = _mm_set1_epi8(static_cast<char>(needles[0]));
+    const __m128i n1 = _mm_set1_epi8(static_cast<char>(needles[count > 1 ? 1 : 0]));
+    const __m128i n2 = _mm_set1_epi8(static_cast<char>(needles[count > 2 ? 2 : 0]));
+    for (; position + 16 <= size; position += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+        const __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, n0), _mm_or_si128(_mm_cmpeq_epi8(v, n1), _mm_cmpeq_epi8(v, n2)));
+        uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        for (; bits != 0; bits &= bits - 1) {
+            const size_t candidate = position + static_cast<size_t>(std::countr_zero(bits));
+            if (PairAt(pairs, data, candidate, size)) {
+                return candidate;
+            }
+        }
+    }
+    return position;
+}
+
+EXPLORER_MODULES_TARGET_AVX2
+size_t FindNeedlesAvx2(const uint8_t* data, size_t position, size_t size, const uint8_t* needles, uint32_t count,
+    const uint64_t* pairs) {
+    const __m256i n0 = _mm256_set1_epi8(static_cast<char>(needles[0]));
+    const __m256i n1 = _mm256_set1_epi8(static_cast<char>(needles[count > 1 ? 1 : 0]));
+    const __m256i n2 = _mm256_set1_epi8(static_cast<char>(needles[count > 2 ? 2 : 0]));
+    for (; position + 32 <= size; position += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position));
+        const __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, n0),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, n1), _mm256_cmpeq_epi8(v, n2)));
+        uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        for (; bits != 0; bits &= bits - 1) {
+            const size_t candidate = position + static_cast<size_t>(std::countr_zero(bits));
+            if (PairAt(pairs, data, candidate, size)) {
+                return candidate;
+            }
+        }
+    }
+    return position;
+}
+
+// Classifies 32 bytes at a time by looking up both nibbles with PSHUFB (the "shufti" technique). With more
+// than eight distinct high nibbles among the first bytes, buckets are shared and a candidate may be a
+// false positive, which the automaton then simply rejects.
+EXPLORER_MODULES_TARGET_AVX2
+size_t FindShuftiAvx2(const uint8_t* data, size_t position, size_t size, const uint8_t* low, const uint8_t* high,
+    const uint64_t* pairs) {
+    const __m256i lowTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(low)));
+    const __m256i highTable = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(high)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    for (; position + 32 <= size; position += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + position));
+        const __m256i l = _mm256_shuffle_epi8(lowTable, _mm256_and_si256(v, nibble));
+        const __m256i h = _mm256_shuffle_epi8(highTable, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        const __m256i none = _mm256_cmpeq_epi8(_mm256_and_si256(l, h), zero);
+        uint32_t bits = ~static_cast<uint32_t>(_mm256_movemask_epi8(none));
+        for (; bits != 0; bits &= bits - 1) {
+            const size_t candidate = position + static_cast<size_t>(std::countr_zero(bits));
+            if (PairAt(pairs, data, candidate, size)) {
+                return candidate;
+            }
+        }
+    }
+    return position;
+}
+#endif
+
+} // namespace
+
+bool Parse(std::wstring_view text, Pattern& pattern, std::wstring& error) {
+    pattern = {};
+    while (!text.empty() && std::iswspace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::iswspace(text.back())) {
+        text.remove_suffix(1);
+    }
+    pattern.text = text;
+
+    bool parsed = false;
+    if (!text.empty() && text.front() == L'"') {
+        parsed = ParseString(text, false, pattern, error);
+    } else if (text.size() > 1 && (text.front() == L'w' || text.front() == L'W') && text[1] == L'"') {
+        parsed = ParseString(text.substr(1), true, pattern, error);
+    } else {
+        parsed = ParseHex(text, pattern, error);
+    }
+    if (!parsed) {
+        return false;
+    }
+    if (pattern.bytes.size() > kMaxPatternBytes) {
+        error = L"Longer than " + std::to_wstring(kMaxPatternBytes) + L" bytes";
+        return false;
+    }
+    if (std::find(pattern.mask.begin(), pattern.mask.end(), uint8_t{ 0xFF }) == pattern.mask.end()) {
+        error = L"Needs at least one byte that is not a wildcard";
+        return false;
+    }
+    return true;
+}
+
+Matcher::Matcher(std::vector<Pattern> patterns) : patterns_(std::move(patterns)) {
+    anchorOffset_.resize(patterns_.size());
+    anchorLength_.resize(patterns_.size());
+    for (size_t p = 0; p < patterns_.size(); ++p) {
+        size_t offset = 0;
+        size_t length = 0;
+        FindAnchor(patterns_[p], offset, length);
+        anchorOffset_[p] = static_cast<uint16_t>(offset);
+        anchorLength_[p] = static_cast<uint16_t>(length);
+        maxPatternBytes_ = std::max(maxPatternBytes_, patterns_[p].bytes.size());
+        maxAnchorEnd_ = std::max(maxAnchorEnd_, offset + length);
+        for (size_t i = offset; i < offset + length; ++i) {
+            byteClass_[patterns_[p].bytes[i]] = 1;
+        }
+        if (length != 0) {
+            const uint8_t first = patterns_[p].bytes[offset];
+            firstByte_[first] = true;
+            // A one-byte anchor can be followed by anything.
+            for (uint32_t second = 0; second < 256; ++second) {
+                if (length == 1 || second == patterns_[p].bytes[offset + 1]) {
+                    const uint32_t pair = uint32_t{ first } << 8 | second;
+                    pairs_[pair >> 6] |= uint64_t{ 1 } << (pair & 63);
+                }
+            }
+        }
+    }
+    // Bytes that occur in no anchor share class 0; every other byte has its own class.
+    for (uint32_t b = 0; b < 256; ++b) {
+        byteClass_[b] = byteClass_[b] ? static_cast<uint8_t>(classCount_++) : 0;
+    }
+
+    // Trie of the anchors, with the patterns whose anchor ends at each state.
+    const uint32_t classes = classCount_;
+    next_.assign(classes, kNoState);
+    std::vector<std::vector<uint32_t>> ends(1);
+    for (uint32_t p = 0; p < patterns_.size(); ++p) {
+        if (anchorLength_[p] == 0) {
+            continue; // All wildcards: can never be anchored, so never matches
+        }
+        uint32_t state = 0;
+        for (size_t i = anchorOffset_[p]; i < size_t{ anchorOffset_[p] } + anchorLength_[p]; ++i) {
+            const size_t slot = size_t{ state } * classes + byteClass_[patterns_[p].bytes[i]];
+            if (next_[slot] == kNoState) {
+                const uint32_t created = static_cast<uint32_t>(ends.size());
+                ends.emplace_back();
+                next_.resize(next_.size() + classes, kNoState);
+                next_[slot] = created;
+            }
+            state = next_[slot];
+        }
+        ends[state].push_back(p);
+    }
+
+    // Breadth-first, turn the trie into a DFA: a missing transition follows the failure link, and a state
+    // also reports what its failure state reports.
+    std::vector<uint32_t> fail(ends.size(), 0);
+    std::vector<uint32_t> queue;
+    queue.reserve(ends.size());
+    for (uint32_t c = 0; c < classes; ++c) {
+        if (next_[c] == kNoState) {
+            next_[c] = 0;
+        } else {
+            queue.push_back(next_[c]);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const uint32_t state = queue[head];
+        for (uint32_t c = 0; c < classes; ++c) {
+            const size_t slot = size_t{ state } * classes + c;
+            const uint32_t fallback = next_[size_t{ fail[state] } * classes + c];
+            if (next_[slot] == kNoState) {
+                next_[slot] = fallback;
+                continue;
+            }
+            const uint32_t child = next_[slot];
+            fail[child] = fallback;
+            ends[child].insert(ends[child].end(), ends[fallback].begin(), ends[fallback].end());
+            queue.push_back(child);
+        }
+    }
+    outputBegin_.reserve(ends.size() + 1);
+    for (const auto& list : ends) {
+        outputBegin_.push_back(static_cast<uint32_t>(outputs_.size()));
+        outputs_.insert(outputs_.end(), list.begin(), list.end());
+    }
+    outputBegin_.push_back(static_cast<uint32_t>(outputs_.size()));
+
+    // Prefilter tables.
+    uint8_t highNibbles[16] = {};
+    uint32_t highCount = 0;
+    for (uint32_t b = 0; b < 256; ++b) {
+        if (!firstByte_[b]) {
+            continue;
+        }
+        if (needleCount_ < 3) {
+            needles_[needleCount_] = static_cast<uint8_t>(b);
+        }
+        ++needleCount_;
+        uint32_t bucket = 0;
+        while (bucket < highCount && highNibbles[bucket] != (b >> 4)) {
+            ++bucket;
+        }
+        if (bucket == highCount) {
+            highNibbles[highCount++] = static_cast<uint8_t>(b >> 4);
+        }
+        const uint8_t bit = static_cast<uint8_t>(1u << (bucket % 8));
+        nibbleLow_[b & 15] |= bit;
+        nibbleHigh_[b >> 4] |= bit;
+    }
+    // Past eight distinct high nibbles the buckets are shared and unrelated bytes pass as well.
+    uint32_t passing = 0;
+    for (uint32_t b = 0; b < 256; ++b) {
+        passing += (nibbleLow_[b & 15] & nibbleHigh_[b >> 4]) != 0;
+    }
+    shufti_ = needleCount_ > 3 && passing <= kMaxShuftiBytes;
+}
+
+size_t Matcher::NextCandidate(const uint8_t* data, size_t position, size_t size, Simd::Level level) const {
+    if (needleCount_ == 0) {
+        return size;
+    }
+#if defined(EXPLORER_MODULES_X64)
+    if (level == Simd::Level::Avx2 && needleCount_ <= 3) {
+        position = FindNeedlesAvx2(data, position, size, needles_, needleCount_, pairs_);
+    } else if (level == Simd::Level::Avx2 && shufti_) {
+        position = FindShuftiAvx2(data, position, size, nibbleLow_, nibbleHigh_, pairs_);
+    } else if (level == Simd::Level::Sse2 && needleCount_ <= 3) {
+        position = FindNeedlesSse2(data, position, size, needles_, needleCount_, pairs_);
+    }
+#else
+    (void)level;
+#endif
+    // Scalar: one pair lookup per byte, without a branch on the first byte.
+    for (; position + 1 < size; ++position) {
+        const uint32_t pair = uint32_t{ data[position] } << 8 | data[position + 1];
+        if ((pairs_[pair >> 6] >> (pair & 63) & 1) != 0) {
+            return position;
+        }
+    }
+    return position < size && !firstByte_[data[position]] ? size : position;
+}
+
+void Matcher::Confirm(const uint8_t* data, size_t size, size_t anchorEnd, size_t limit, uint32_t pattern,
+    std::vector<Match>& matches) const {
+    const size_t lead = size_t{ anchorOffset_[pattern] } + anchorLength_[pattern];
+    if (anchorEnd < lead) {
+        return;
+    }
+    const size_t start = anchorEnd - lead;
+    const Pattern& p = patterns_[pattern];
+    if (start >= limit || p.bytes.size() > size - start) {
+        return;
+    }
+    for (size_t i = 0; i < p.bytes.size(); ++i) {
+        if (((data[start + i] ^ p.bytes[i]) & p.mask[i]) != 0) {
+            return;
+        }
+    }
+    matches.push_back({ start, pattern });
+}
+
+void Matcher::Scan(const uint8_t* data, size_t size, size_t limit, std::vector<Match>& matches, Simd::Level level) const {
+    // Past limit + maxAnchorEnd_ every anchor belongs to a match starting at or after limit.
+    const size_t end = std::min(size, limit + maxAnchorEnd_);
+    const uint32_t classes = classCount_;
+    uint32_t state = 0;
+    for (size_t position = 0; position < end;) {
+        if (state == 0) {
+            position = NextCandidate(data, position, end, level);
+            if (position == end) {
+                break;
+            }
+        }
+        state = next_[size_t{ state } * classes + byteClass_[data[position++]]];
+        for (uint32_t o = outputBegin_[state]; o < outputBegin_[state + 1]; ++o) {
+            Confirm(data, size, position, limit, outputs_[o], matches);
+        }
+    }
+}
+
+Stats Search(const std::vector<HookScan::Module>& modules, const Matcher& matcher, const Options& options,
+    HitSink sink, void* context) {
+    struct Chunk {
+        uint32_t module;
+        size_t start;
+        size_t end;
+    };
+    std::vector<Chunk> chunks;
+    const size_t chunkBytes = std::max<size_t>(options.chunkBytes, 4096);
+    for (uint32_t m = 0; m < modules.size(); ++m) {
+        if (!modules[m].image) {
+            continue;
+        }
+        for (size_t start = 0; start < modules[m].size; start += chunkBytes) {
+            chunks.push_back({ m, start, std::min(modules[m].size, start + chunkBytes) });
+        }
+    }
+
+    Stats stats;
+    std::mutex sinkLock;
+    std::atomic<size_t> next{ 0 };
+    std::atomic<bool> stop{ false };
+    size_t chunksScanned = 0;
+    const size_t overlap = matcher.MaxPatternBytes() ? matcher.MaxPatternBytes() - 1 : 0;
+    auto work = [&] {
+        std::vector<Match> matches;
+        std::vector<Hit> hits;
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size();) {
+            if (stop.load(std::memory_order_relaxed) ||
+                (options.cancel && options.cancel->load(std::memory_order_relaxed))) {
+                stop = true;
+                break;
+            }
+            const Chunk& chunk = chunks[i];
+            const HookScan::Module& module = modules[chunk.module];
+            const size_t scanEnd = std::min(module.size, chunk.end + overlap);
+            matches.clear();
+            matcher.Scan(module.image + chunk.start, scanEnd - chunk.start, chunk.end - chunk.start, matches,
+                options.level);
+
+            hits.clear();
+            const PeImage::View view(module.image, module.size, PeImage::Layout::Mapped);
+            for (const auto& match : matches) {
+                Hit hit{ chunk.module, match.pattern, static_cast<uint32_t>(chunk.start + match.offset), {} };
+                for (uint32_t s = 0; view.IsValid() && s < view.SectionCount(); ++s) {
+                    const auto section = view.SectionAt(s);
+                    const uint32_t extent = std::max(section.virtualSize, section.sizeOfRawData);
+                    if (hit.rva >= section.virtualAddress && hit.rva - section.virtualAddress < extent) {
+                        std::memcpy(hit.section, section.name, sizeof(section.name));
+                        break;
+                    }
+                }
+                hits.push_back(hit);
+            }
+
+            std::lock_guard lock(sinkLock);
+            ++chunksScanned;
+            stats.bytesScanned += chunk.end - chunk.start;
+            const size_t room = options.maxHits - std::min<size_t>(stats.hits, options.maxHits);
+            if (hits.size() > room) {
+                hits.resize(room);
+                stats.truncated = true;
+            }
+            stats.hits += hits.size();
+            if (stats.hits >= options.maxHits) {
+                stop = true;
+            }
+            if (!hits.empty() && sink) {
+                sink(modules, hits, context);
+            }
+        }
+    };
+
+    const size_t workerCount = std::min<size_t>(std::max(options.threads, 1u), chunks.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < workerCount; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (chunksScanned < chunks.size()) {
+        stats.truncated = true;
+    }
+    return stats;
+}
+
+} // namespace SignatureScan
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "HookScan.h"
+#include "Simd.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Searches loaded module images for a set of byte signatures at once. Each pattern is anchored on its
+// longest run of fixed bytes; the anchors go into one Aho-Corasick automaton (a DFA over byte classes),
+// and a hit on an anchor is confirmed by matching the whole pattern, wildcards included, around it.
+// While the automaton is in its root state a vectorized prefilter skips to the next byte that can start
+// an anchor, then checks the byte after it against a table of anchor prefixes, so code that contains
+// none of the signatures rarely enters the automaton at all.
+namespace SignatureScan {
+
+constexpr size_t kMaxPatternBytes = 256;
+constexpr size_t kMaxPatterns = 1024;
+// Anchors are cut to this many bytes, which keeps the automaton for kMaxPatterns patterns to a few tens of
+// thousands of states; a longer anchor would not make a random false start noticeably rarer.
+constexpr size_t kMaxAnchorBytes = 16;
+
+struct Pattern {
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> mask; // 0xFF where the byte must match, 0 for a wildcard
+    std::wstring text;         // As written
+};
+
+/// @brief Parses one pattern: hex bytes with ?? wildcards ("48 8B ?? 05 E8"), a quoted ASCII string
+/// ("CreateRemoteThread") or a UTF-16LE string (w"kernel32"). Fails with a message in error on
+/// malformed input, on more than kMaxPatternBytes bytes, or if every byte is a wildcard.
+bool Parse(std::wstring_view text, Pattern& pattern, std::wstring& error);
+
+struct Match {
+    size_t offset;    // Where the pattern starts
+    uint32_t pattern; // Index into the matcher's patterns
+};
+
+class Matcher {
+public:
+    explicit Matcher(std::vector<Pattern> patterns);
+
+    const std::vector<Pattern>& Patterns() const { return patterns_; }
+    size_t StateCount() const { return outputBegin_.empty() ? 0 : outputBegin_.size() - 1; }
+    size_t MaxPatternBytes() const { return maxPatternBytes_; }
+
+    /// @brief Appends every match that starts in [0, limit) of data, reading up to size bytes so that a
+    /// match starting before limit may end after it. Chunks scanned this way with an overlap of
+    /// MaxPatternBytes() - 1 report each match exactly once.
+    void Scan(const uint8_t* data, size_t size, size_t limit, std::vector<Match>& matches, Simd::Level level) const;
+
+private:
+    size_t NextCandidate(const uint8_t* data, size_t position, size_t size, Simd::Level level) const;
+    void Confirm(const uint8_t* data, size_t size, size_t anchorEnd, size_t limit, uint32_t pattern,
+        std::vector<Match>& matches) const;
+
+    std::vector<Pattern> patterns_;
+    std::vector<uint16_t> anchorOffset_; // Per pattern: where its anchor starts
+    std::vector<uint16_t> anchorLength_;
+    size_t maxPatternBytes_ = 0;
+    size_t maxAnchorEnd_ = 0; // Largest anchorOffset_ + anchorLength_
+
+    uint8_t byteClass_[256] = {}; // 0 for bytes in no anchor
+    uint32_t classCount_ = 1;
+    std::vector<uint32_t> next_;        // state * classCount_ + class -> state
+    std::vector<uint32_t> outputBegin_; // Patterns whose anchor ends at state s: outputs_[outputBegin_[s], outputBegin_[s + 1])
+    std::vector<uint32_t> outputs_;
+
+    // Prefilter: the bytes an anchor can start with, and the pairs of bytes (first << 8 | second).
+    bool firstByte_[256] = {};
+    uint64_t pairs_[65536 / 64] = {};
+    uint8_t needles_[3] = {}; // The first bytes when there are at most three
+    uint32_t needleCount_ = 0;
+    uint8_t nibbleLow_[16] = {}; // Shufti tables: byte b is a candidate if low[b & 15] & high[b >> 4]
+    uint8_t nibbleHigh_[16] = {};
+    bool shufti_ = false; // More than three first bytes, and the tables let few other bytes through
+};
+
+struct Hit {
+    uint32_t module;
+    uint32_t pattern;
+    uint32_t rva;
+    char section[9]; // Name of the section holding the hit, empty for the headers
+};
+
+/// @brief Receives hits as they are found, one batch per scanned chunk. Batches arrive from worker
+/// threads but never concurrently.
+using HitSink = void (*)(const std::vector<HookScan::Module>& modules, const std::vector<Hit>& hits, void* context);
+
+struct Options {
+    uint32_t threads = 1;
+    size_t chunkBytes = 1 << 20; // Unit of parallel work; large modules are split
+    size_t maxHits = 100000;     // Stop once this many have been reported
+    Simd::Level level = Simd::Active();
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+struct Stats {
+    uint64_t bytesScanned = 0;
+    uint64_t hits = 0;
+    bool truncated = false; // maxHits reached or cancelled
+};
+
+/// @brief Scans every module with an image in parallel chunks, streaming hits to sink.
+Stats Search(const std::vector<HookScan::Module>& modules, const Matcher& matcher, const Options& options,
+    HitSink sink, void* context);
+
+} // namespace SignatureScan
@@ -0,0 +1,409 @@
+#include "SignatureSearchWindow.h"
+#include "Log.h"
+#include "ModuleHelpers.h"
+#include "Platform.h"
+#include "SignatureScan.h"
+
+#include <commctrl.h>
+#include <shlwapi.h>
+#include <strsafe.h>
+#include <wrl/module.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+extern HMODULE g_module;
+
+namespace SignatureSearchWindow {
+namespace {
+
+constexpr wchar_t kClassName[] = L"ExplorerModulesSignatureSearch";
+constexpr UINT kMessageHits = WM_APP + 1; // Rows are waiting in pending_
+constexpr UINT kMessageDone = WM_APP + 2; // The search thread has finished
+
+enum : int {
+    kIdPatterns = 100,
+    kIdFind,
+    kIdStatus,
+    kIdResults,
+};
+
+enum : int {
+    kColumnModule,
+    kColumnSection,
+    kColumnRva,
+    kColumnAddress,
+    kColumnPattern,
+};
+
+constexpr int kMargin = 8;
+constexpr int kPatternsHeight = 96;
+constexpr int kButtonWidth = 96;
+constexpr int kButtonHeight = 26;
+constexpr int kStatusHeight = 20;
+
+constexpr wchar_t kPrompt[] = L"One pattern per line: hex bytes with ?? wildcards (48 8B ?? ?? E8), \"ASCII\" or w\"UTF-16\".";
+
+struct Row {
+    std::wstring module; // File name
+    std::wstring section;
+    wchar_t rva[16];
+    wchar_t address[24];
+    uint32_t pattern;
+};
+
+class SearchWindow {
+public:
+    static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam) {
+        SearchWindow* self = nullptr;
+        if (message == WM_NCCREATE) {
+            self = static_cast<SearchWindow*>(reinterpret_cast<CREATESTRUCTW*>(lParam)->lpCreateParams);
+            self->hwnd_ = hwnd;
+            SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(self));
+        } else {
+            self = reinterpret_cast<SearchWindow*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+        }
+        return self ? self->Handle(message, wParam, lParam) : DefWindowProcW(hwnd, message, wParam, lParam);
+    }
+
+private:
+    LRESULT Handle(UINT message, WPARAM wParam, LPARAM lParam) {
+        switch (message) {
+        case WM_CREATE:
+            return CreateChildren() ? 0 : -1;
+        case WM_SIZE:
+            Layout(LOWORD(lParam), HIWORD(lParam));
+            return 0;
+        case WM_COMMAND:
+            if (LOWORD(wParam) == kIdFind && HIWORD(wParam) == BN_CLICKED) {
+                if (search_.joinable()) {
+                    cancel_ = true;
+                } else {
+                    StartSearch();
+                }
+            }
+            return 0;
+        case WM_NOTIFY: {
+            const auto* header = reinterpret_cast<const NMHDR*>(lParam);
+            if (header->idFrom == kIdResults && header->code == LVN_GETDISPINFOW) {
+                GetDisplayInfo(reinterpret_cast<NMLVDISPINFOW*>(lParam)->item);
+            } else if (header->idFrom == kIdResults && header->code == LVN_COLUMNCLICK) {
+                SortBy(reinterpret_cast<const NMLISTVIEW*>(lParam)->iSubItem);
+            }
+            return 0;
+        }
+        case kMessageHits:
+            TakePending();
+            return 0;
+        case kMessageDone:
+            FinishSearch();
+            return 0;
+        case WM_DESTROY:
+            // The search thread posts to this window and reads the matcher; it must be gone first.
+            if (search_.joinable()) {
+                cancel_ = true;
+                search_.join();
+            }
+            PostQuitMessage(0);
+            return 0;
+        default:
+            return DefWindowProcW(hwnd_, message, wParam, lParam);
+        }
+    }
+
+    bool CreateChildren() {
+        const auto font = reinterpret_cast<WPARAM>(GetStockObject(DEFAULT_GUI_FONT));
+        patterns_ = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", nullptr,
+            WS_CHILD | WS_VISIBLE | WS_TABSTOP | WS_VSCROLL | ES_MULTILINE | ES_AUTOVSCROLL | ES_WANTRETURN,
+            0, 0, 0, 0, hwnd_, reinterpret_cast<HMENU>(static_cast<INT_PTR>(kIdPatterns)), g_module, nullptr);
+        find_ = CreateWindowExW(0, L"BUTTON", L"Find", WS_CHILD | WS_VISIBLE | WS_TABSTOP | BS_DEFPUSHBUTTON,
+            0, 0, 0, 0, hwnd_, reinterpret_cast<HMENU>(static_cast<INT_PTR>(kIdFind)), g_module, nullptr);
+        status_ = CreateWindowExW(0, L"STATIC", kPrompt, WS_CHILD | WS_VISIBLE | SS_LEFTNOWORDWRAP | SS_ENDELLIPSIS,
+            0, 0, 0, 0, hwnd_, reinterpret_cast<HMENU>(static_cast<INT_PTR>(kIdStatus)), g_module, nullptr);
+        // Owner data: the list asks for the rows it paints, so hundreds of thousands of hits cost no items.
+        results_ = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, nullptr,
+            WS_CHILD | WS_VISIBLE | WS_TABSTOP | LVS_REPORT | LVS_OWNERDATA | LVS_SHOWSELALWAYS,
+            0, 0, 0, 0, hwnd_, reinterpret_cast<HMENU>(static_cast<INT_PTR>(kIdResults)), g_module, nullptr);
+        if (!patterns_ || !find_ || !status_ || !results_) {
+            LOG_ERROR(L"Could not create the Find in modules controls: {}", GetLastError());
+            return false;
+        }
+        for (HWND child : { patterns_, find_, status_, results_ }) {
+            SendMessageW(child, WM_SETFONT, font, FALSE);
+        }
+        ListView_SetExtendedListViewStyle(results_, LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER);
+
+        static const struct {
+            const wchar_t* name;
+            int width;
+        } kColumns[] = {
+            { L"Module", 200 },
+            { L"Section", 80 },
+            { L"RVA", 100 },
+            { L"Address", 150 },
+            { L"Pattern", 300 },
+        };
+        for (int i = 0; i < static_cast<int>(ARRAYSIZE(kColumns)); ++i) {
+            LVCOLUMNW column = {};
+            column.mask = LVCF_TEXT | LVCF_WIDTH | LVCF_SUBITEM;
+            column.pszText = const_cast<wchar_t*>(kColumns[i].name);
+            column.cx = kColumns[i].width;
+            column.iSubItem = i;
+            ListView_InsertColumn(results_, i, &column);
+        }
+        SetFocus(patterns_);
+        return true;
+    }
+
+    void Layout(int width, int height) {
+        const int editWidth = (std::max)(width - 3 * kMargin - kButtonWidth, 0);
+        MoveWindow(patterns_, kMargin, kMargin, editWidth, kPatternsHeight, TRUE);
+        MoveWindow(find_, width - kMargin - kButtonWidth, kMargin, kButtonWidth, kButtonHeight, TRUE);
+        const int statusTop = 2 * kMargin + kPatternsHeight;
+        MoveWindow(status_, kMargin, statusTop, (std::max)(width - 2 * kMargin, 0), kStatusHeight, TRUE);
+        const int listTop = statusTop + kStatusHeight + kMargin / 2;
+        MoveWindow(results_, kMargin, listTop, (std::max)(width - 2 * kMargin, 0), (std::max)(height - listTop - kMargin, 0), TRUE);
+    }
+
+    // Parses the patterns, one per line; blank lines and lines starting with # are skipped.
+    std::shared_ptr<const SignatureScan::Matcher> ParsePatterns() {
+        std::wstring text(static_cast<size_t>(GetWindowTextLengthW(patterns_)) + 1, L'\0');
+        text.resize(static_cast<size_t>(GetWindowTextW(patterns_, text.data(), static_cast<int>(text.size()))));
+
+        std::vector<SignatureScan::Pattern> patterns;
+        size_t lineNumber = 0;
+        for (size_t start = 0; start <= text.size();) {
+            size_t end = text.find(L'\n', start);
+            if (end == std::wstring::npos) {
+                end = text.size();
+            }
+            std::wstring_view line(text.data() + start, end - start);
+            start = end + 1;
+            ++lineNumber;
+            const size_t first = line.find_first_not_of(L" \t\r");
+            if (first == std::wstring_view::npos || line[first] == L'#') {
+                continue;
+            }
+            SignatureScan::Pattern pattern;
+            std::wstring error;
+            if (!SignatureScan::Parse(line, pattern, error)) {
+                const std::wstring message = L"Line " + std::to_wstring(lineNumber) + L": " + error;
+                MessageBoxW(hwnd_, message.c_str(), L"Find in modules", MB_ICONWARNING | MB_OK);
+                return nullptr;
+            }
+            patterns.push_back(std::move(pattern));
+        }
+        if (patterns.empty()) {
+            SetWindowTextW(status_, kPrompt);
+            return nullptr;
+        }
+        if (patterns.size() > SignatureScan::kMaxPatterns) {
+            const std::wstring message = L"At most " + std::to_wstring(SignatureScan::kMaxPatterns) + L" patterns.";
+            MessageBoxW(hwnd_, message.c_str(), L"Find in modules", MB_ICONWARNING | MB_OK);
+            return nullptr;
+        }
+        return std::make_shared<const SignatureScan::Matcher>(std::move(patterns));
+    }
+
+    void StartSearch() {
+        auto matcher = ParsePatterns();
+        if (!matcher) {
+            return;
+        }
+        matcher_ = std::move(matcher);
+        rows_.clear();
+        {
+            std::lock_guard lock(pendingLock_);
+            pending_.clear();
+            notified_ = false;
+        }
+        ListView_SetItemCountEx(results_, 0, 0);
+        cancel_ = false;
+        try {
+            search_ = std::thread([this] {
+                stats_ = ModuleHelpers::SearchModules(*matcher_, &SearchWindow::Sink, this, &cancel_);
+                PostMessageW(hwnd_, kMessageDone, 0, 0);
+            });
+        } catch (const std::system_error&) {
+            LOG_ERROR(L"Could not start a signature search");
+            return;
+        }
+        SetWindowTextW(find_, L"Stop");
+        SetWindowTextW(status_, L"Searching...");
+    }
+
+    // Runs on the search threads, one call at a time. Formats the hits while the modules are pinned and
+    // wakes the window only if it is not already due to collect.
+    static void Sink(const std::vector<HookScan::Module>& modules, const std::vector<SignatureScan::Hit>& hits, void* context) {
+        auto* self = static_cast<SearchWindow*>(context);
+        std::vector<Row> rows;
+        rows.reserve(hits.size());
+        for (const auto& hit : hits) {
+            const auto& module = modules[hit.module];
+            Row row;
+            row.module = PathFindFileNameW(module.path.c_str());
+            for (const char* c = hit.section; *c; ++c) {
+                row.section += static_cast<wchar_t>(static_cast<unsigned char>(*c));
+            }
+            StringCchPrintfW(row.rva, ARRAYSIZE(row.rva), L"0x%08X", hit.rva);
+            StringCchPrintfW(row.address, ARRAYSIZE(row.address), L"0x%016llX",
+                static_cast<unsigned long long>(module.base + hit.rva));
+            row.pattern = hit.pattern;
+            rows.push_back(std::move(row));
+        }
+
+        std::lock_guard lock(self->pendingLock_);
+        self->pending_.insert(self->pending_.end(), std::make_move_iterator(rows.begin()), std::make_move_iterator(rows.end()));
+        if (!self->notified_) {
+            self->notified_ = PostMessageW(self->hwnd_, kMessageHits, 0, 0) != FALSE;
+        }
+    }
+
+    void TakePending() {
+        {
+            std::lock_guard lock(pendingLock_);
+            rows_.insert(rows_.end(), std::make_move_iterator(pending_.begin()), std::make_move_iterator(pending_.end()));
+            pending_.clear();
+            notified_ = false;
+        }
+        ListView_SetItemCountEx(results_, static_cast<int>(rows_.size()), LVSICF_NOINVALIDATEALL | LVSICF_NOSCROLL);
+        if (search_.joinable()) {
+            const std::wstring status = L"Searching... " + std::to_wstring(rows_.size()) + L" hits";
+            SetWindowTextW(status_, status.c_str());
+        }
+    }
+
+    void FinishSearch() {
+        search_.join();
+        TakePending();
+        std::wstring status = std::to_wstring(stats_.hits) + L" hits in " + std::to_wstring(stats_.bytesScanned >> 20) +
+            L" MB of module images";
+        if (stats_.truncated) {
+            status += cancel_ ? L" (stopped)" : L" (limit reached)";
+        }
+        SetWindowTextW(status_, status.c_str());
+        SetWindowTextW(find_, L"Find");
+    }
+
+    void GetDisplayInfo(LVITEMW& item) {
+        if ((item.mask & LVIF_TEXT) == 0 || item.iItem < 0 || static_cast<size_t>(item.iItem) >= rows_.size()) {
+            return;
+        }
+        const Row& row = rows_[static_cast<size_t>(item.iItem)];
+        const wchar_t* text = L"";
+        switch (item.iSubItem) {
+        case kColumnModule:
+            text = row.module.c_str();
+            break;
+        case kColumnSection:
+            text = row.section.c_str();
+            break;
+        case kColumnRva:
+            text = row.rva;
+            break;
+        case kColumnAddress:
+            text = row.address;
+            break;
+        case kColumnPattern:
+            text = matcher_->Patterns()[row.pattern].text.c_str();
+            break;
+        }
+        StringCchCopyW(item.pszText, item.cchTextMax, text);
+    }
+
+    // Hits arrive in scan order, which interleaves modules; a column click orders them by that column.
+    void SortBy(int column) {
+        std::stable_sort(rows_.begin(), rows_.end(), [column](const Row& a, const Row& b) {
+            switch (column) {
+            case kColumnModule:
+                return _wcsicmp(a.module.c_str(), b.module.c_str()) < 0;
+            case kColumnSection:
+                return a.section < b.section;
+            case kColumnRva:
+                return wcscmp(a.rva, b.rva) < 0;
+            case kColumnAddress:
+                return wcscmp(a.address, b.address) < 0;
+            default:
+                return a.pattern < b.pattern;
+            }
+        });
+        InvalidateRect(results_, nullptr, FALSE);
+    }
+
+    HWND hwnd_ = nullptr;
+    HWND patterns_ = nullptr;
+    HWND find_ = nullptr;
+    HWND status_ = nullptr;
+    HWND results_ = nullptr;
+
+    std::shared_ptr<const SignatureScan::Matcher> matcher_;
+    std::thread search_;
+    std::atomic<bool> cancel_{ false };
+    SignatureScan::Stats stats_; // Written by the search thread, read after joining it
+
+    std::mutex pendingLock_;
+    std::vector<Row> pending_; // Formatted by the search thread, not yet in rows_
+    bool notified_ = false;    // A kMessageHits is on its way
+
+    std::vector<Row> rows_;
+};
+
+void RunWindow() {
+    INITCOMMONCONTROLSEX controls = { sizeof(controls), ICC_LISTVIEW_CLASSES | ICC_STANDARD_CLASSES };
+    InitCommonControlsEx(&controls);
+
+    WNDCLASSEXW windowClass = { sizeof(windowClass) };
+    windowClass.lpfnWndProc = SearchWindow::WindowProc;
+    windowClass.hInstance = g_module;
+    windowClass.hCursor = LoadCursorW(nullptr, IDC_ARROW);
+    windowClass.hbrBackground = reinterpret_cast<HBRUSH>(COLOR_BTNFACE + 1);
+    windowClass.lpszClassName = kClassName;
+    if (!RegisterClassExW(&windowClass) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+        LOG_ERROR(L"RegisterClassExW failed for the Find in modules window: {}", GetLastError());
+        return;
+    }
+
+    SearchWindow window;
+    HWND hwnd = CreateWindowExW(0, kClassName, L"Find in modules", WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT,
+        900, 600, nullptr, nullptr, g_module, &window);
+    if (hwnd) {
+        ShowWindow(hwnd, SW_SHOWNORMAL);
+        MSG message;
+        while (GetMessageW(&message, nullptr, 0, 0) > 0) {
+            if (!IsDialogMessageW(hwnd, &message)) {
+                TranslateMessage(&message);
+                DispatchMessageW(&message);
+            }
+        }
+    } else {
+        LOG_ERROR(L"CreateWindowExW failed for the Find in modules window: {}", GetLastError());
+    }
+    // The class points into this DLL, so it must not outlive it. This fails, harmlessly, while another
+    // search window is open; the last one to close unregisters it.
+    UnregisterClassW(kClassName, g_module);
+}
+
+} // namespace
+
+HRESULT Show() {
+    auto& module = Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule();
+    module.IncrementObjectCount();
+    const bool started = Platform::StartDetachedThread([] {
+        RunWindow();
+        Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().DecrementObjectCount();
+    });
+    if (!started) {
+        module.DecrementObjectCount();
+        LOG_ERROR(L"Could not start the Find in modules window");
+        return E_OUTOFMEMORY;
+    }
+    return S_OK;
+}
+
+} // namespace SignatureSearchWindow
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <windows.h>
+
+// The "Find in modules" window: a box for byte signatures (one per line, in SignatureScan::Parse
+// syntax) and a list of where they occur in the loaded modules. Each window runs on its own thread, so
+// neither Explorer nor a long search blocks the other, and hits appear as the search finds them.
+namespace SignatureSearchWindow {
+
+/// @brief Opens a new window and returns at once. The window holds a module reference until closed.
+/// @return S_OK, or E_OUTOFMEMORY if its thread could not be started.
+HRESULT Show();
+
+} // namespace SignatureSearchWindow
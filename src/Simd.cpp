@@ -0,0 +1,100 @@
+#include "Simd.h"
+
+#include "Settings.h"
+
+#if defined(EXPLORER_MODULES_X64) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(EXPLORER_MODULES_X64)
+#include <cpuid.h>
+#endif
+
+namespace Simd {
+namespace {
+
+Level DetectOnce() {
+#if defined(EXPLORER_MODULES_X64) && defined(_MSC_VER)
+    int registers[4] = {};
+    __cpuid(registers, 0);
+    if (registers[0] < 7) {
+        return Level::Sse2;
+    }
+    __cpuid(registers, 1);
+    constexpr int kOsxsave = 1 << 27;
+    constexpr int kAvx = 1 << 28;
+    if ((registers[2] & (kOsxsave | kAvx)) != (kOsxsave | kAvx) || (_xgetbv(0) & 0x6) != 0x6) {
+        return Level::Sse2;
+    }
+    __cpuidex(registers, 7, 0);
+    constexpr int kAvx2 = 1 << 5;
+    return (registers[1] & kAvx2) ? Level::Avx2 : Level::Sse2;
+#elif defined(EXPLORER_MODULES_X64)
+    // libgcc checks OSXSAVE and XCR0 before reporting AVX features.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? Level::Avx2 : Level::Sse2;
+#else
+    return Level::Scalar;
+#endif
+}
+
+bool DetectSha() {
+    constexpr unsigned kSsse3 = 1u << 9;
+    constexpr unsigned kSse41 = 1u << 19;
+    constexpr unsigned kSha = 1u << 29;
+#if defined(EXPLORER_MODULES_X64) && defined(_MSC_VER)
+    int registers[4] = {};
+    __cpuid(registers, 0);
+    if (registers[0] < 7) {
+        return false;
+    }
+    __cpuid(registers, 1);
+    const unsigned features = static_cast<unsigned>(registers[2]);
+    __cpuidex(registers, 7, 0);
+    const unsigned extended = static_cast<unsigned>(registers[1]);
+#elif defined(EXPLORER_MODULES_X64)
+    // __builtin_cpu_supports does not know "sha" on every supported compiler.
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const unsigned features = ecx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const unsigned extended = ebx;
+#else
+    const unsigned features = 0;
+    const unsigned extended = 0;
+#endif
+    return (features & (kSsse3 | kSse41)) == (kSsse3 | kSse41) && (extended & kSha) != 0;
+}
+
+} // namespace
+
+Level Detect() {
+    static const Level level = DetectOnce();
+    return level;
+}
+
+Level Active() {
+    static const Level level = [] {
+        const uint32_t cap = Settings::ReadDword(L"SimdLevel", static_cast<uint32_t>(Level::Avx2));
+        const Level detected = Detect();
+        return cap < static_cast<uint32_t>(detected) ? static_cast<Level>(cap) : detected;
+    }();
+    return level;
+}
+
+bool ShaExtensions() {
+    static const bool available = Active() != Level::Scalar && DetectSha();
+    return available;
+}
+
+const wchar_t* LevelName(Level level) {
+    switch (level) {
+    case Level::Avx2: return L"AVX2";
+    case Level::Sse2: return L"SSE2";
+    default: return L"scalar";
+    }
+}
+
+} // namespace Simd
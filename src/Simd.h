@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// Instruction-set selection for the vectorized kernels. Each kernel keeps a scalar version; SSE2 is the
+// x64 baseline and AVX2 is chosen at run time, so one binary runs on any x64 or ARM64 machine.
+#if defined(_M_X64) || defined(__x86_64__)
+#define EXPLORER_MODULES_X64 1
+#endif
+
+// Marks a function that may use AVX2 intrinsics. MSVC allows them anywhere; GCC and Clang need the
+// target attribute, and the caller must check Simd::Active() first.
+#if defined(EXPLORER_MODULES_X64) && (defined(__GNUC__) || defined(__clang__))
+#define EXPLORER_MODULES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define EXPLORER_MODULES_TARGET_AVX2
+#endif
+
+// Likewise for the SHA extensions, whose kernels also use SSSE3 and SSE4.1 shuffles.
+#if defined(EXPLORER_MODULES_X64) && (defined(__GNUC__) || defined(__clang__))
+#define EXPLORER_MODULES_TARGET_SHA __attribute__((target("sha,ssse3,sse4.1")))
+#else
+#define EXPLORER_MODULES_TARGET_SHA
+#endif
+
+namespace Simd {
+
+enum class Level : uint8_t {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+/// @brief The best level the CPU and OS support (AVX2 also needs the OS to save the YMM registers).
+Level Detect();
+
+/// @brief Detect(), capped by the SimdLevel setting (0 scalar, 1 SSE2, 2 AVX2). Read once.
+Level Active();
+
+/// @brief "AVX2", "SSE2" or "scalar". Wide, for the LOG_* format strings.
+const wchar_t* LevelName(Level level);
+
+/// @brief True if the CPU has the SHA extensions (with SSSE3 and SSE4.1) and Active() is not Scalar.
+bool ShaExtensions();
+
+} // namespace Simd
@@ -0,0 +1,237 @@
+#include "SnapshotCompare.h"
+
+#include <algorithm>
+
+namespace SnapshotCompare {
+namespace {
+
+uint64_t Mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+char16_t Fold(char16_t ch) {
+    return ch >= u'A' && ch <= u'Z' ? static_cast<char16_t>(ch - u'A' + u'a') : ch;
+}
+
+// Hashes the folded path four code units per step; a byte-at-a-time hash dominates interning otherwise.
+uint64_t HashFolded(std::u16string_view path) {
+    uint64_t hash = path.size();
+    size_t i = 0;
+    for (; i + 4 <= path.size(); i += 4) {
+        const uint64_t block = static_cast<uint64_t>(Fold(path[i])) | static_cast<uint64_t>(Fold(path[i + 1])) << 16 |
+            static_cast<uint64_t>(Fold(path[i + 2])) << 32 | static_cast<uint64_t>(Fold(path[i + 3])) << 48;
+        hash = (hash ^ block) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < path.size(); ++i) {
+        hash = (hash ^ Fold(path[i])) * 0x9E3779B97F4A7C15ull;
+    }
+    return Mix(hash);
+}
+
+bool EqualsFolded(std::u16string_view folded, std::u16string_view path) {
+    if (folded.size() != path.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (folded[i] != Fold(path[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// PathId -> uint32_t map with open addressing, for the per-snapshot joins. Sized once for the number of
+// keys it will hold, so it never rehashes.
+class IdTable {
+public:
+    explicit IdTable(size_t keys) {
+        size_t capacity = 16;
+        while (capacity < keys * 2) {
+            capacity *= 2;
+        }
+        slots_.assign(capacity, { kNoPath, 0 });
+        mask_ = capacity - 1;
+    }
+
+    /// @brief Returns the slot's value and true if the key was already present, or stores value and false.
+    std::pair<uint32_t*, bool> Insert(PathId key, uint32_t value) {
+        for (size_t i = Mix(key) & mask_;; i = (i + 1) & mask_) {
+            auto& slot = slots_[i];
+            if (slot.first == key) {
+                return { &slot.second, true };
+            }
+            if (slot.first == kNoPath) {
+                slot = { key, value };
+                return { &slot.second, false };
+            }
+        }
+    }
+
+    uint32_t* Find(PathId key) {
+        for (size_t i = Mix(key) & mask_;; i = (i + 1) & mask_) {
+            auto& slot = slots_[i];
+            if (slot.first == key) {
+                return &slot.second;
+            }
+            if (slot.first == kNoPath) {
+                return nullptr;
+            }
+        }
+    }
+
+private:
+    std::vector<std::pair<PathId, uint32_t>> slots_;
+    size_t mask_ = 0;
+};
+
+} // namespace
+
+PathId PathInterner::Intern(std::u16string_view path) {
+    const uint64_t hash = HashFolded(path);
+    const auto shardIndex = static_cast<uint32_t>(hash >> (64 - kShardBits));
+    auto& shard = shards_[shardIndex];
+    std::lock_guard guard(shard.lock);
+    if (shard.slots.size() < (shard.paths.size() + 1) * 2) {
+        std::vector<Slot> slots(shard.slots.empty() ? 64 : shard.slots.size() * 2, Slot{ 0, kNoPath });
+        for (const auto& slot : shard.slots) {
+            if (slot.id != kNoPath) {
+                size_t i = slot.hash & (slots.size() - 1);
+                while (slots[i].id != kNoPath) {
+                    i = (i + 1) & (slots.size() - 1);
+                }
+                slots[i] = slot;
+            }
+        }
+        shard.slots = std::move(slots);
+    }
+
+    const size_t mask = shard.slots.size() - 1;
+    size_t i = hash & mask;
+    for (; shard.slots[i].id != kNoPath; i = (i + 1) & mask) {
+        const auto& slot = shard.slots[i];
+        if (slot.hash == hash && EqualsFolded(shard.paths[slot.id & ((PathId{ 1 } << kIndexBits) - 1)], path)) {
+            return slot.id;
+        }
+    }
+    if (shard.paths.size() >= (size_t{ 1 } << kIndexBits) - 1) {
+        return kNoPath;
+    }
+    const PathId id = (shardIndex << kIndexBits) | static_cast<PathId>(shard.paths.size());
+    auto& stored = shard.paths.emplace_back(path);
+    for (auto& ch : stored) {
+        ch = Fold(ch);
+    }
+    shard.slots[i] = { hash, id };
+    return id;
+}
+
+std::u16string_view PathInterner::Path(PathId id) const {
+    if (id == kNoPath) {
+        return {};
+    }
+    const auto& shard = shards_[id >> kIndexBits];
+    std::lock_guard guard(shard.lock);
+    const size_t index = id & ((PathId{ 1 } << kIndexBits) - 1);
+    return index < shard.paths.size() ? std::u16string_view(shard.paths[index]) : std::u16string_view();
+}
+
+size_t PathInterner::Size() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard guard(shard.lock);
+        size += shard.paths.size();
+    }
+    return size;
+}
+
+std::vector<Entry> LoadEntries(const SnapshotFormat::Reader& reader, PathInterner& interner) {
+    using SnapshotFormat::ColumnId;
+    const auto* paths = reader.StringColumn(ColumnId::Path);
+    if (!paths) {
+        return {};
+    }
+    const auto* bases = reader.U64Column(ColumnId::BaseAddress);
+    const auto* sizes = reader.U32Column(ColumnId::Size);
+    const auto* versions = reader.U64Column(ColumnId::FileVersion);
+
+    std::vector<Entry> entries;
+    entries.reserve(static_cast<size_t>(reader.RowCount()));
+    IdTable seen(static_cast<size_t>(reader.RowCount()));
+    for (uint64_t row = 0; row < reader.RowCount(); ++row) {
+        const Entry entry = {
+            interner.Intern(reader.String(paths[row])),
+            bases ? bases[row] : 0,
+            sizes ? sizes[row] : 0,
+            versions ? versions[row] : 0,
+        };
+        if (entry.path == kNoPath) {
+            continue;
+        }
+        if (auto [index, present] = seen.Insert(entry.path, static_cast<uint32_t>(entries.size())); present) {
+            entries[*index] = entry;
+            continue;
+        }
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+Diff Compare(const std::vector<Entry>& before, const std::vector<Entry>& after) {
+    // Build on before, probe with after; a matched slot's value is set to kMatched so the removed pass
+    // needs no second table.
+    constexpr uint32_t kMatched = UINT32_MAX;
+    IdTable index(before.size());
+    for (size_t i = 0; i < before.size(); ++i) {
+        index.Insert(before[i].path, static_cast<uint32_t>(i));
+    }
+
+    Diff diff;
+    for (const auto& entry : after) {
+        uint32_t* slot = index.Find(entry.path);
+        if (!slot || *slot == kMatched) {
+            diff.added.push_back(entry);
+            continue;
+        }
+        const Entry& old = before[*slot];
+        if (old.fileVersion != entry.fileVersion || old.size != entry.size || old.baseAddress != entry.baseAddress) {
+            diff.changed.push_back({ old, entry });
+        }
+        *slot = kMatched;
+    }
+    for (const auto& entry : before) {
+        if (*index.Find(entry.path) != kMatched) {
+            diff.removed.push_back(entry);
+        }
+    }
+    return diff;
+}
+
+void Prevalence::Add(const std::vector<Entry>& snapshot) {
+    for (const auto& entry : snapshot) {
+        ++counts_[entry.path];
+    }
+    ++snapshots_;
+}
+
+void Prevalence::Merge(const Prevalence& other) {
+    for (const auto& [path, count] : other.counts_) {
+        counts_[path] += count;
+    }
+    snapshots_ += other.snapshots_;
+}
+
+std::vector<std::pair<PathId, uint64_t>> Prevalence::Sorted(const PathInterner& interner) const {
+    std::vector<std::pair<PathId, uint64_t>> result(counts_.begin(), counts_.end());
+    std::sort(result.begin(), result.end(), [&interner](const auto& left, const auto& right) {
+        if (left.second != right.second) {
+            return left.second > right.second;
+        }
+        return interner.Path(left.first) < interner.Path(right.first);
+    });
+    return result;
+}
+
+} // namespace SnapshotCompare
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "SnapshotFormat.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Comparison of module snapshots collected from many machines: pairwise diffs and fleet-wide
+// prevalence. Paths are interned once to 32-bit ids so every later join compares integers.
+namespace SnapshotCompare {
+
+using PathId = uint32_t;
+
+constexpr PathId kNoPath = UINT32_MAX;
+
+// Thread-safe path interner. Paths are folded to lower case (ASCII, as Windows paths in practice are
+// compared) before interning, so C:\Windows\System32 and c:\windows\system32 share an id. The table is
+// split into shards, each with its own lock, so parallel loaders rarely contend.
+class PathInterner {
+public:
+    /// @brief Returns kNoPath only if the interner is full (2^26 paths in one shard).
+    PathId Intern(std::u16string_view path);
+
+    /// @brief The folded path for an id returned by Intern.
+    std::u16string_view Path(PathId id) const;
+
+    size_t Size() const;
+
+private:
+    static constexpr uint32_t kShardBits = 6;
+    static constexpr uint32_t kIndexBits = 32 - kShardBits;
+
+    struct Slot {
+        uint64_t hash;
+        PathId id; // kNoPath when empty
+    };
+
+    struct Shard {
+        mutable std::mutex lock;
+        std::vector<Slot> slots;          // Open addressing, linear probing, at most half full
+        std::deque<std::u16string> paths; // Stable addresses; Path() returns views into them
+    };
+
+    std::array<Shard, size_t{ 1 } << kShardBits> shards_;
+};
+
+struct Entry {
+    PathId path;
+    uint64_t baseAddress;
+    uint32_t size;
+    uint64_t fileVersion;
+};
+
+/// @brief The rows of a snapshot keyed by interned path. A path listed twice keeps its last row.
+/// Returns an empty vector if the Path column is missing.
+std::vector<Entry> LoadEntries(const SnapshotFormat::Reader& reader, PathInterner& interner);
+
+struct Change {
+    Entry before;
+    Entry after;
+};
+
+struct Diff {
+    std::vector<Entry> added;
+    std::vector<Entry> removed;
+    std::vector<Change> changed; // Same path, different version, size or base address
+};
+
+/// @brief Hash-joins the two snapshots on path id. Each list comes back in the order of the snapshot it
+/// was taken from (removed in before's order, added and changed in after's).
+Diff Compare(const std::vector<Entry>& before, const std::vector<Entry>& after);
+
+// Per-path count of the snapshots containing it. Each loader thread accumulates into its own Prevalence
+// and the results are merged, so counting needs no locks.
+class Prevalence {
+public:
+    void Add(const std::vector<Entry>& snapshot);
+    void Merge(const Prevalence& other);
+
+    uint64_t Snapshots() const { return snapshots_; }
+
+    /// @brief (path, count) pairs, most prevalent first, ties by path. Ids depend on the order threads
+    /// interned them, so they are not used for ordering.
+    std::vector<std::pair<PathId, uint64_t>> Sorted(const PathInterner& interner) const;
+
+private:
+    std::unordered_map<PathId, uint64_t> counts_;
+    uint64_t snapshots_ = 0;
+};
+
+} // namespace SnapshotCompare
@@ -0,0 +1,316 @@
+#include "SnapshotExport.h"
+
+#include "Log.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string_view>
+
+namespace SnapshotExport {
+namespace {
+
+// wchar_t is UTF-16 on Windows (surrogate pairs combined here) and UTF-32 elsewhere.
+void AppendUtf8(std::string& out, std::wstring_view text) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        auto codePoint = static_cast<uint32_t>(text[i]);
+        if constexpr (sizeof(wchar_t) == 2) {
+            if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < text.size()) {
+                const auto low = static_cast<uint32_t>(text[i + 1]);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+            }
+        }
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+}
+
+void AppendVersion(std::string& out, uint64_t version) {
+    if (version == 0) {
+        return;
+    }
+    char text[32] = {};
+    std::snprintf(text, sizeof(text), "%u.%u.%u.%u", PeImage::VersionPart(version, 0), PeImage::VersionPart(version, 1),
+        PeImage::VersionPart(version, 2), PeImage::VersionPart(version, 3));
+    out += text;
+}
+
+void AppendMachine(std::string& out, uint16_t machine) {
+    if (machine != 0) {
+        AppendUtf8(out, PeImage::MachineName(machine));
+    }
+}
+
+class BinaryWriter final : public RowWriter {
+public:
+    BinaryWriter(const std::filesystem::path& path, uint64_t capacity, uint64_t capturedAtUnixMs, uint32_t processId)
+        : writer_(path, capacity, capturedAtUnixMs, processId) {}
+
+    bool IsOpen() const { return writer_.IsOpen(); }
+    bool Append(const SnapshotFormat::Row& row) override { return writer_.Append(row); }
+    bool Finish() override { return writer_.Finish(); }
+
+private:
+    SnapshotFormat::Writer writer_;
+};
+
+// RFC 4180: fields containing a comma, quote or line break are quoted, with quotes doubled.
+class CsvWriter final : public RowWriter {
+public:
+    explicit CsvWriter(const std::filesystem::path& path) : file_(path, std::ios::binary | std::ios::trunc) {
+        file_ << "path,base_address,size,file_version,file_version_text,company,description,machine\r\n";
+    }
+
+    bool IsOpen() const { return static_cast<bool>(file_); }
+
+    bool Append(const SnapshotFormat::Row& row) override {
+        line_.clear();
+        AppendField(row.path);
+        char numbers[48] = {};
+        std::snprintf(numbers, sizeof(numbers), "0x%llX,%u,", static_cast<unsigned long long>(row.baseAddress), row.size);
+        line_ += numbers;
+        AppendVersion(line_, row.fileVersion);
+        line_ += ',';
+        AppendField(row.fileVersionText);
+        AppendField(row.company);
+        AppendField(row.description);
+        AppendMachine(line_, row.machine);
+        line_ += "\r\n";
+        file_.write(line_.data(), static_cast<std::streamsize>(line_.size()));
+        return static_cast<bool>(file_);
+    }
+
+    bool Finish() override {
+        file_.close();
+        return !file_.fail();
+    }
+
+private:
+    void AppendField(std::wstring_view text) {
+        field_.clear();
+        AppendUtf8(field_, text);
+        if (field_.find_first_of(",\"\r\n") == std::string::npos) {
+            line_ += field_;
+        } else {
+            line_ += '"';
+            for (char ch : field_) {
+                line_ += ch;
+                if (ch == '"') {
+                    line_ += '"';
+                }
+            }
+            line_ += '"';
+        }
+        line_ += ',';
+    }
+
+    std::ofstream file_;
+    std::string line_;  // Reused across rows
+    std::string field_;
+};
+
+// {"capturedAtUnixMs":..., "processId":..., "modules":[{...}, ...]}, one module per line.
+class JsonWriter final : public RowWriter {
+public:
+    JsonWriter(const std::filesystem::path& path, uint64_t capturedAtUnixMs, uint32_t processId)
+        : file_(path, std::ios::binary | std::ios::trunc) {
+        file_ << "{\"capturedAtUnixMs\":" << capturedAtUnixMs << ",\"processId\":" << processId << ",\"modules\":[";
+    }
+
+    bool IsOpen() const { return static_cast<bool>(file_); }
+
+    bool Append(const SnapshotFormat::Row& row) override {
+        line_.assign(first_ ? "\n" : ",\n");
+        first_ = false;
+        line_ += "{\"path\":";
+        AppendString(row.path);
+        char numbers[64] = {};
+        std::snprintf(numbers, sizeof(numbers), ",\"baseAddress\":\"0x%llX\",\"size\":%u,\"fileVersion\":\"",
+            static_cast<unsigned long long>(row.baseAddress), row.size);
+        line_ += numbers;
+        AppendVersion(line_, row.fileVersion);
+        line_ += "\",\"fileVersionText\":";
+        AppendString(row.fileVersionText);
+        line_ += ",\"company\":";
+        AppendString(row.company);
+        line_ += ",\"description\":";
+        AppendString(row.description);
+        line_ += ",\"machine\":\"";
+        AppendMachine(line_, row.machine);
+        line_ += "\"}";
+        file_.write(line_.data(), static_cast<std::streamsize>(line_.size()));
+        return static_cast<bool>(file_);
+    }
+
+    bool Finish() override {
+        file_ << "\n]}\n";
+        file_.close();
+        return !file_.fail();
+    }
+
+private:
+    void AppendString(std::wstring_view text) {
+        field_.clear();
+        AppendUtf8(field_, text);
+        line_ += '"';
+        for (char ch : field_) {
+            switch (ch) {
+            case '"':
+                line_ += "\\\"";
+                break;
+            case '\\':
+                line_ += "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(ch) < 0x20) {
+                    char escape[8] = {};
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(ch));
+                    line_ += escape;
+                } else {
+                    line_ += ch;
+                }
+            }
+        }
+        line_ += '"';
+    }
+
+    std::ofstream file_;
+    bool first_ = true;
+    std::string line_;
+    std::string field_;
+};
+
+std::wstring Widen(std::u16string_view text) {
+    std::wstring result;
+    result.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        auto unit = static_cast<uint32_t>(text[i]);
+        if constexpr (sizeof(wchar_t) == 4) {
+            if (unit >= 0xD800 && unit < 0xDC00 && i + 1 < text.size()) {
+                const auto low = static_cast<uint32_t>(text[i + 1]);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+            }
+        }
+        result += static_cast<wchar_t>(unit);
+    }
+    return result;
+}
+
+} // namespace
+
+Format FormatFromPath(const std::filesystem::path& path) {
+    auto extension = path.extension().wstring();
+    for (auto& ch : extension) {
+        ch = static_cast<wchar_t>(ch >= L'A' && ch <= L'Z' ? ch - L'A' + L'a' : ch);
+    }
+    if (extension == L".csv") {
+        return Format::Csv;
+    }
+    if (extension == L".json") {
+        return Format::Json;
+    }
+    return Format::Binary;
+}
+
+std::unique_ptr<RowWriter> Open(Format format, const std::filesystem::path& path, uint64_t capacity,
+    uint64_t capturedAtUnixMs, uint32_t processId) {
+    switch (format) {
+    case Format::Csv: {
+        auto writer = std::make_unique<CsvWriter>(path);
+        return writer->IsOpen() ? std::move(writer) : nullptr;
+    }
+    case Format::Json: {
+        auto writer = std::make_unique<JsonWriter>(path, capturedAtUnixMs, processId);
+        return writer->IsOpen() ? std::move(writer) : nullptr;
+    }
+    case Format::Binary:
+    default: {
+        auto writer = std::make_unique<BinaryWriter>(path, capacity, capturedAtUnixMs, processId);
+        return writer->IsOpen() ? std::move(writer) : nullptr;
+    }
+    }
+}
+
+bool WriteModules(RowWriter& writer, const ModuleEnumerator::Snapshot& modules, ModuleEnumerator::DescribeFn describe,
+    ImageInfoFn readInfo, uint64_t& rowsWritten) {
+    rowsWritten = 0;
+    ModuleRecord record = {};
+    for (auto handle : modules) {
+        if (!describe(handle, record)) {
+            continue;
+        }
+        const auto info = readInfo(record.path);
+        const SnapshotFormat::Row row = {
+            record.path,
+            reinterpret_cast<uintptr_t>(record.baseAddress),
+            record.size,
+            info.fileVersionNumber,
+            info.fileVersion,
+            info.companyName,
+            info.description,
+            info.machine,
+        };
+        if (!writer.Append(row)) {
+            LOG_ERROR(L"Snapshot export failed after {} rows", rowsWritten);
+            return false;
+        }
+        ++rowsWritten;
+    }
+    return true;
+}
+
+bool Convert(const SnapshotFormat::Reader& reader, RowWriter& writer) {
+    using SnapshotFormat::ColumnId;
+    const auto* paths = reader.StringColumn(ColumnId::Path);
+    const auto* bases = reader.U64Column(ColumnId::BaseAddress);
+    const auto* sizes = reader.U32Column(ColumnId::Size);
+    const auto* versions = reader.U64Column(ColumnId::FileVersion);
+    const auto* versionTexts = reader.StringColumn(ColumnId::FileVersionText);
+    const auto* companies = reader.StringColumn(ColumnId::Company);
+    const auto* descriptions = reader.StringColumn(ColumnId::Description);
+    const auto* machines = reader.U16Column(ColumnId::Machine);
+    if (!paths || !bases || !sizes) {
+        return false;
+    }
+
+    for (uint64_t i = 0; i < reader.RowCount(); ++i) {
+        const std::wstring path = Widen(reader.String(paths[i]));
+        const std::wstring versionText = versionTexts ? Widen(reader.String(versionTexts[i])) : std::wstring();
+        const std::wstring company = companies ? Widen(reader.String(companies[i])) : std::wstring();
+        const std::wstring description = descriptions ? Widen(reader.String(descriptions[i])) : std::wstring();
+        const SnapshotFormat::Row row = {
+            path,
+            bases[i],
+            sizes[i],
+            versions ? versions[i] : 0,
+            versionText,
+            company,
+            description,
+            machines ? machines[i] : uint16_t{ 0 },
+        };
+        if (!writer.Append(row)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace SnapshotExport
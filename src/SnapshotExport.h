@@ -0,0 +1,52 @@
+#pragma once
+
+#include "ModuleEnumerator.h"
+#include "PeImage.h"
+#include "SnapshotFormat.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+// Writes module tables out of the process: the columnar SnapshotFormat file, or CSV / JSON (UTF-8) for
+// tools that cannot read it. Every writer streams row by row, so memory use does not grow with the
+// number of modules.
+namespace SnapshotExport {
+
+enum class Format {
+    Binary, // SnapshotFormat, .emsnap
+    Csv,
+    Json,
+};
+
+/// @brief Picks the format from the extension: .csv, .json, anything else binary.
+Format FormatFromPath(const std::filesystem::path& path);
+
+class RowWriter {
+public:
+    virtual ~RowWriter() = default;
+
+    virtual bool Append(const SnapshotFormat::Row& row) = 0;
+
+    /// @brief Completes the document. Nothing written before this is guaranteed to be readable.
+    virtual bool Finish() = 0;
+};
+
+/// @brief Creates the file and a writer for it, or returns nullptr if the file cannot be created.
+/// capacity bounds the rows of a binary snapshot (its layout is fixed up front); text formats ignore it.
+std::unique_ptr<RowWriter> Open(Format format, const std::filesystem::path& path, uint64_t capacity,
+    uint64_t capturedAtUnixMs, uint32_t processId);
+
+using ImageInfoFn = PeImage::ImageInfo (*)(const std::filesystem::path& path);
+
+/// @brief Describes each module in the snapshot, reads its image info and appends the row. Modules that
+/// no longer describe (unloaded since the snapshot) are skipped. Returns false on a write failure;
+/// rowsWritten counts the rows appended either way.
+bool WriteModules(RowWriter& writer, const ModuleEnumerator::Snapshot& modules, ModuleEnumerator::DescribeFn describe,
+    ImageInfoFn readInfo, uint64_t& rowsWritten);
+
+/// @brief Re-emits every row of a binary snapshot, e.g. to turn a collected .emsnap into CSV.
+bool Convert(const SnapshotFormat::Reader& reader, RowWriter& writer);
+
+} // namespace SnapshotExport
@@ -0,0 +1,246 @@
+#include "SnapshotFormat.h"
+
+#include <cstring>
+#include <iterator>
+#include <system_error>
+#include <utility>
+
+namespace SnapshotFormat {
+namespace {
+
+constexpr uint64_t kChunkRows = 4096;
+constexpr size_t kStringFlushChars = 64 * 1024;
+// Companies, descriptions and version strings repeat across modules; paths rarely do. Bounded so a
+// pathological snapshot cannot grow the table without limit.
+constexpr size_t kMaxDedupeEntries = 16384;
+
+constexpr uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// wchar_t is UTF-16 on Windows and UTF-32 elsewhere.
+void AppendUtf16(std::u16string& out, std::wstring_view text) {
+    for (wchar_t ch : text) {
+        const auto codePoint = static_cast<uint32_t>(ch);
+        if constexpr (sizeof(wchar_t) == 4) {
+            if (codePoint >= 0x10000) {
+                out += static_cast<char16_t>(0xD800 + ((codePoint - 0x10000) >> 10));
+                out += static_cast<char16_t>(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+                continue;
+            }
+        }
+        out += static_cast<char16_t>(codePoint);
+    }
+}
+
+} // namespace
+
+size_t TypeWidth(ColumnType type) {
+    switch (type) {
+    case ColumnType::U16:
+        return 2;
+    case ColumnType::U32:
+        return 4;
+    case ColumnType::U64:
+        return 8;
+    case ColumnType::String:
+        return sizeof(StringRef);
+    }
+    return 0;
+}
+
+Reader::Reader(const uint8_t* data, size_t size) : data_(data), size_(size) {
+    if (!data_ || size_ < sizeof(Header) || reinterpret_cast<uintptr_t>(data_) % 8 != 0) {
+        return;
+    }
+    std::memcpy(&header_, data_, sizeof(header_));
+    if (header_.magic != kMagic || header_.majorVersion != kMajorVersion || header_.headerSize < sizeof(Header)) {
+        return;
+    }
+    const uint64_t directoryEnd = header_.headerSize + static_cast<uint64_t>(header_.columnCount) * sizeof(ColumnEntry);
+    if (directoryEnd > size_) {
+        return;
+    }
+    if (header_.stringTableOffset % 2 != 0 || header_.stringTableSize % 2 != 0 ||
+        header_.stringTableOffset > size_ || header_.stringTableSize > size_ - header_.stringTableOffset) {
+        return;
+    }
+    strings_ = reinterpret_cast<const char16_t*>(data_ + header_.stringTableOffset);
+    stringChars_ = static_cast<size_t>(header_.stringTableSize / 2);
+    valid_ = true;
+}
+
+const uint8_t* Reader::Column(ColumnId id, ColumnType type) const {
+    if (!valid_) {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < header_.columnCount; ++i) {
+        ColumnEntry entry;
+        std::memcpy(&entry, data_ + header_.headerSize + static_cast<size_t>(i) * sizeof(ColumnEntry), sizeof(entry));
+        if (entry.id != id) {
+            continue;
+        }
+        const size_t width = TypeWidth(type);
+        if (entry.type != type || entry.offset % 8 != 0 || entry.offset > size_ || entry.size > size_ - entry.offset ||
+            header_.rowCount > entry.size / width) {
+            return nullptr;
+        }
+        return data_ + entry.offset;
+    }
+    return nullptr;
+}
+
+const uint16_t* Reader::U16Column(ColumnId id) const {
+    return reinterpret_cast<const uint16_t*>(Column(id, ColumnType::U16));
+}
+
+const uint32_t* Reader::U32Column(ColumnId id) const {
+    return reinterpret_cast<const uint32_t*>(Column(id, ColumnType::U32));
+}
+
+const uint64_t* Reader::U64Column(ColumnId id) const {
+    return reinterpret_cast<const uint64_t*>(Column(id, ColumnType::U64));
+}
+
+const StringRef* Reader::StringColumn(ColumnId id) const {
+    return reinterpret_cast<const StringRef*>(Column(id, ColumnType::String));
+}
+
+std::u16string_view Reader::String(StringRef ref) const {
+    if (ref.offset > stringChars_ || ref.length > stringChars_ - ref.offset) {
+        return {};
+    }
+    return { strings_ + ref.offset, ref.length };
+}
+
+Writer::Writer(const std::filesystem::path& path, uint64_t capacity, uint64_t capturedAtUnixMs, uint32_t processId)
+    : path_(path), file_(path, std::ios::binary | std::ios::trunc), capacity_(capacity) {
+    static constexpr std::pair<ColumnId, ColumnType> kColumns[] = {
+        { ColumnId::Path, ColumnType::String },
+        { ColumnId::BaseAddress, ColumnType::U64 },
+        { ColumnId::Size, ColumnType::U32 },
+        { ColumnId::FileVersion, ColumnType::U64 },
+        { ColumnId::FileVersionText, ColumnType::String },
+        { ColumnId::Company, ColumnType::String },
+        { ColumnId::Description, ColumnType::String },
+        { ColumnId::Machine, ColumnType::U16 },
+    };
+
+    uint64_t offset = AlignUp(sizeof(Header) + std::size(kColumns) * sizeof(ColumnEntry), 8);
+    for (const auto& [id, type] : kColumns) {
+        columns_.push_back({ id, type, offset, {} });
+        offset = AlignUp(offset + capacity_ * TypeWidth(type), 8);
+    }
+
+    header_.magic = kMagic;
+    header_.majorVersion = kMajorVersion;
+    header_.minorVersion = kMinorVersion;
+    header_.headerSize = sizeof(Header);
+    header_.columnCount = static_cast<uint32_t>(columns_.size());
+    header_.capturedAtUnixMs = capturedAtUnixMs;
+    header_.processId = processId;
+    header_.stringTableOffset = offset;
+}
+
+void Writer::Put(Column& column, const void* value) {
+    const auto* bytes = static_cast<const uint8_t*>(value);
+    column.pending.insert(column.pending.end(), bytes, bytes + TypeWidth(column.type));
+}
+
+StringRef Writer::AddString(std::wstring_view text, bool deduplicate) {
+    std::u16string converted;
+    AppendUtf16(converted, text);
+    if (deduplicate) {
+        if (auto it = dedupe_.find(converted); it != dedupe_.end()) {
+            return it->second;
+        }
+    }
+    if (stringChars_ + converted.size() > UINT32_MAX) {
+        return {};
+    }
+    const StringRef ref = { static_cast<uint32_t>(stringChars_), static_cast<uint32_t>(converted.size()) };
+    pendingStrings_ += converted;
+    stringChars_ += converted.size();
+    if (deduplicate && dedupe_.size() < kMaxDedupeEntries) {
+        dedupe_.emplace(std::move(converted), ref);
+    }
+    return ref;
+}
+
+bool Writer::Append(const Row& row) {
+    if (!file_ || rows_ >= capacity_) {
+        return false;
+    }
+    const StringRef path = AddString(row.path, false);
+    const StringRef versionText = AddString(row.fileVersionText, true);
+    const StringRef company = AddString(row.company, true);
+    const StringRef description = AddString(row.description, true);
+
+    Put(columns_[0], &path);
+    Put(columns_[1], &row.baseAddress);
+    Put(columns_[2], &row.size);
+    Put(columns_[3], &row.fileVersion);
+    Put(columns_[4], &versionText);
+    Put(columns_[5], &company);
+    Put(columns_[6], &description);
+    Put(columns_[7], &row.machine);
+    ++rows_;
+
+    if (rows_ - flushedRows_ >= kChunkRows && !FlushColumns()) {
+        return false;
+    }
+    if (pendingStrings_.size() >= kStringFlushChars && !FlushStrings()) {
+        return false;
+    }
+    return true;
+}
+
+bool Writer::FlushColumns() {
+    for (auto& column : columns_) {
+        if (column.pending.empty()) {
+            continue;
+        }
+        file_.seekp(static_cast<std::streamoff>(column.offset + flushedRows_ * TypeWidth(column.type)));
+        file_.write(reinterpret_cast<const char*>(column.pending.data()), static_cast<std::streamsize>(column.pending.size()));
+        column.pending.clear();
+    }
+    flushedRows_ = rows_;
+    return static_cast<bool>(file_);
+}
+
+bool Writer::FlushStrings() {
+    if (!pendingStrings_.empty()) {
+        file_.seekp(static_cast<std::streamoff>(header_.stringTableOffset + flushedStringChars_ * sizeof(char16_t)));
+        file_.write(reinterpret_cast<const char*>(pendingStrings_.data()),
+            static_cast<std::streamsize>(pendingStrings_.size() * sizeof(char16_t)));
+        pendingStrings_.clear();
+        flushedStringChars_ = stringChars_;
+    }
+    return static_cast<bool>(file_);
+}
+
+bool Writer::Finish() {
+    if (!file_ || !FlushColumns() || !FlushStrings()) {
+        return false;
+    }
+    header_.rowCount = rows_;
+    header_.stringTableSize = stringChars_ * sizeof(char16_t);
+
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    for (const auto& column : columns_) {
+        const ColumnEntry entry = { column.id, column.type, column.offset, rows_ * TypeWidth(column.type) };
+        file_.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    file_.close();
+    if (file_.fail()) {
+        return false;
+    }
+    // Unused capacity and an empty string table can leave the file short of where the header says the
+    // string table ends.
+    std::error_code error;
+    std::filesystem::resize_file(path_, header_.stringTableOffset + header_.stringTableSize, error);
+    return !error;
+}
+
+} // namespace SnapshotFormat
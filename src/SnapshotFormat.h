@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Versioned, columnar binary snapshot of a module table (.emsnap). Designed to be mapped and read in
+// place: every column is a fixed-width little-endian array at an 8-byte aligned offset, and strings are
+// (offset, length) references into one UTF-16LE string table. A reader validates the header and
+// directory once and then indexes the arrays directly.
+//
+//   [Header][ColumnEntry x columnCount][column arrays ...][string table]
+//
+// Readers accept any file with the same major version and find columns by id, so minor versions can
+// add columns without breaking them.
+namespace SnapshotFormat {
+
+constexpr uint32_t kMagic = 0x53534D45; // 'EMSS'
+constexpr uint16_t kMajorVersion = 1;
+constexpr uint16_t kMinorVersion = 0;
+
+enum class ColumnId : uint32_t {
+    Path = 1,
+    BaseAddress = 2,
+    Size = 3,
+    FileVersion = 4,     // VS_FIXEDFILEINFO file version, PeImage::VersionPart layout
+    FileVersionText = 5,
+    Company = 6,
+    Description = 7,
+    Machine = 8,         // IMAGE_FILE_HEADER.Machine
+};
+
+enum class ColumnType : uint32_t {
+    U16 = 1,
+    U32 = 2,
+    U64 = 3,
+    String = 4, // StringRef
+};
+
+#pragma pack(push, 1)
+struct Header {
+    uint32_t magic;
+    uint16_t majorVersion;
+    uint16_t minorVersion;
+    uint32_t headerSize;  // Offset of the column directory
+    uint32_t columnCount;
+    uint64_t rowCount;
+    uint64_t capturedAtUnixMs;
+    uint32_t processId;
+    uint32_t reserved;
+    uint64_t stringTableOffset;
+    uint64_t stringTableSize; // Bytes
+    uint8_t padding[8];
+};
+
+struct ColumnEntry {
+    ColumnId id;
+    ColumnType type;
+    uint64_t offset;
+    uint64_t size; // Bytes; rowCount * width
+};
+
+struct StringRef {
+    uint32_t offset; // UTF-16 code units from the start of the string table
+    uint32_t length; // UTF-16 code units, no terminator
+};
+#pragma pack(pop)
+
+static_assert(sizeof(Header) == 64, "Header size mismatch");
+static_assert(sizeof(ColumnEntry) == 24, "ColumnEntry size mismatch");
+static_assert(sizeof(StringRef) == 8, "StringRef size mismatch");
+
+// One module as the writers take it (binary here, CSV and JSON in SnapshotExport).
+struct Row {
+    std::wstring_view path;
+    uint64_t baseAddress;
+    uint32_t size;
+    uint64_t fileVersion;
+    std::wstring_view fileVersionText;
+    std::wstring_view company;
+    std::wstring_view description;
+    uint16_t machine;
+};
+
+/// @brief Bytes per value of a column type.
+size_t TypeWidth(ColumnType type);
+
+/// @brief A validated view over a snapshot held in memory (typically a mapped file). Column accessors
+/// return pointers into the buffer, or nullptr if the column is absent or has an unexpected type.
+class Reader {
+public:
+    /// @brief The buffer must be 8-byte aligned (mapped files are) and outlive the reader.
+    Reader(const uint8_t* data, size_t size);
+
+    bool IsValid() const { return valid_; }
+    const Header& GetHeader() const { return header_; }
+    uint64_t RowCount() const { return header_.rowCount; }
+
+    const uint16_t* U16Column(ColumnId id) const;
+    const uint32_t* U32Column(ColumnId id) const;
+    const uint64_t* U64Column(ColumnId id) const;
+    const StringRef* StringColumn(ColumnId id) const;
+
+    /// @brief The referenced string, or empty if the reference is out of bounds.
+    std::u16string_view String(StringRef ref) const;
+
+private:
+    const uint8_t* Column(ColumnId id, ColumnType type) const;
+
+    const uint8_t* data_;
+    size_t size_;
+    bool valid_ = false;
+    Header header_ = {};
+    const char16_t* strings_ = nullptr;
+    size_t stringChars_ = 0;
+};
+
+/// @brief Streams rows into a snapshot file. The row capacity is fixed up front so every column's
+/// position is known; values are buffered per column in chunks and the header is written by Finish().
+/// Memory use is bounded by the chunk size and the string de-duplication table, not the row count.
+class Writer {
+public:
+    Writer(const std::filesystem::path& path, uint64_t capacity, uint64_t capturedAtUnixMs, uint32_t processId);
+
+    /// @brief False if the file could not be created or a write failed.
+    bool IsOpen() const { return static_cast<bool>(file_); }
+
+    /// @brief Appends a row. Returns false once capacity is reached or on I/O failure.
+    bool Append(const Row& row);
+
+    /// @brief Flushes the remaining rows and writes the header. The file is only valid after this.
+    bool Finish();
+
+    uint64_t RowCount() const { return rows_; }
+
+private:
+    struct Column {
+        ColumnId id;
+        ColumnType type;
+        uint64_t offset;
+        std::vector<uint8_t> pending;
+    };
+
+    StringRef AddString(std::wstring_view text, bool deduplicate);
+    void Put(Column& column, const void* value);
+    bool FlushColumns();
+    bool FlushStrings();
+
+    std::filesystem::path path_;
+    std::ofstream file_;
+    uint64_t capacity_;
+    uint64_t rows_ = 0;
+    uint64_t flushedRows_ = 0;
+    Header header_ = {};
+    std::vector<Column> columns_;
+    std::u16string pendingStrings_;
+    uint64_t stringChars_ = 0; // Total, including flushed
+    uint64_t flushedStringChars_ = 0;
+    std::unordered_map<std::u16string, StringRef> dedupe_;
+};
+
+} // namespace SnapshotFormat
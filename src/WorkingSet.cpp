@@ -0,0 +1,146 @@
+#include "WorkingSet.h"
+
+#include "Perf.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace WorkingSet {
+namespace {
+
+Counts Count(const uint8_t* flags, uint32_t pageCount) {
+    Counts counts;
+    counts.pages = pageCount;
+    for (uint32_t i = 0; i < pageCount; ++i) {
+        const uint8_t page = flags[i];
+        counts.resident += page & kResident;
+        counts.shared += (page & (kResident | kShared)) == (kResident | kShared);
+    }
+    counts.privatePages = counts.resident - counts.shared;
+    return counts;
+}
+
+std::wstring Kilobytes(uint64_t pages, uint64_t pageSize) {
+    return std::to_wstring(pages * pageSize / 1024) + L" KB";
+}
+
+} // namespace
+
+bool Tracker::Refresh(const std::vector<Module>& modules) {
+    Perf::ScopedTimer timer(Perf::Op::WorkingSet);
+    const bool rebuild = modules != modules_;
+    if (rebuild) {
+        Rebuild(modules);
+    }
+    previous_.swap(flags_);
+    flags_.resize(pages_.size());
+    if (!pages_.empty() && !query_(pages_.data(), pages_.size(), flags_.data())) {
+        if (rebuild) {
+            Clear();
+        } else {
+            flags_.swap(previous_);
+        }
+        return false;
+    }
+    ++stats_.refreshes;
+    stats_.rebuilds += rebuild;
+    stats_.pagesQueried += pages_.size();
+
+    changed_.clear();
+    for (size_t i = 0; i < spans_.size(); ++i) {
+        const Span& span = spans_[i];
+        const uint8_t* now = flags_.data() + span.firstPage;
+        // The delta path: a module whose flags match the last query keeps its counts.
+        if (!rebuild && std::memcmp(now, previous_.data() + span.firstPage, span.pageCount) == 0) {
+            continue;
+        }
+        const Counts counts = Count(now, span.pageCount);
+        if (rebuild || counts != counts_[i]) {
+            counts_[i] = counts;
+            changed_.push_back(span.base);
+        }
+    }
+    return true;
+}
+
+void Tracker::Rebuild(const std::vector<Module>& modules) {
+    modules_ = modules;
+    spans_.clear();
+    spans_.reserve(modules.size());
+    for (uint32_t i = 0; i < modules.size(); ++i) {
+        if (modules[i].size) {
+            spans_.push_back({ modules[i].base, modules[i].base + modules[i].size, 0, 0, i });
+        }
+    }
+    std::sort(spans_.begin(), spans_.end(), [](const Span& a, const Span& b) { return a.base < b.base; });
+
+    pages_.clear();
+    uint64_t covered = 0; // End of the pages already listed
+    for (auto& span : spans_) {
+        const uint64_t first = std::max(span.base / pageSize_ * pageSize_, covered);
+        const uint64_t last = (span.end + pageSize_ - 1) / pageSize_ * pageSize_;
+        span.firstPage = static_cast<uint32_t>(pages_.size());
+        for (uint64_t page = first; page < last; page += pageSize_) {
+            pages_.push_back(page);
+        }
+        span.pageCount = static_cast<uint32_t>(pages_.size()) - span.firstPage;
+        covered = std::max(covered, last);
+    }
+    // Overlapping images (never seen in practice) end where the next one starts.
+    for (size_t i = 0; i + 1 < spans_.size(); ++i) {
+        spans_[i].end = std::min(spans_[i].end, std::max(spans_[i].base, spans_[i + 1].base));
+    }
+    flags_.assign(pages_.size(), 0);
+    counts_.assign(spans_.size(), Counts{});
+}
+
+const Counts* Tracker::Find(uint64_t base) const {
+    const auto span = std::lower_bound(spans_.begin(), spans_.end(), base,
+        [](const Span& entry, uint64_t value) { return entry.base < value; });
+    if (span == spans_.end() || span->base != base) {
+        return nullptr;
+    }
+    return &counts_[static_cast<size_t>(span - spans_.begin())];
+}
+
+size_t Tracker::FindAddress(uint64_t address) const {
+    const auto next = std::upper_bound(spans_.begin(), spans_.end(), address,
+        [](uint64_t value, const Span& entry) { return value < entry.base; });
+    if (next == spans_.begin() || address >= std::prev(next)->end) {
+        return SIZE_MAX;
+    }
+    return std::prev(next)->module;
+}
+
+size_t Tracker::Bytes() const {
+    return modules_.capacity() * sizeof(Module) + spans_.capacity() * sizeof(Span) +
+        pages_.capacity() * sizeof(uint64_t) + flags_.capacity() + previous_.capacity() +
+        counts_.capacity() * sizeof(Counts) + changed_.capacity() * sizeof(uint64_t);
+}
+
+void Tracker::Clear() {
+    modules_ = {};
+    spans_ = {};
+    pages_ = {};
+    flags_ = {};
+    previous_ = {};
+    counts_ = {};
+    changed_ = {};
+}
+
+std::wstring FormatResident(const Counts& counts, uint64_t pageSize) {
+    if (counts.pages == 0) {
+        return {};
+    }
+    return Kilobytes(counts.resident, pageSize) + L" (" +
+        std::to_wstring(uint64_t{ counts.resident } * 100 / counts.pages) + L"%)";
+}
+
+std::wstring FormatSharing(const Counts& counts, uint64_t pageSize) {
+    if (counts.resident == 0) {
+        return {};
+    }
+    return Kilobytes(counts.shared, pageSize) + L" / " + Kilobytes(counts.privatePages, pageSize);
+}
+
+} // namespace WorkingSet
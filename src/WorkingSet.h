@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How much of each module's image is in the working set. Every page of every module goes into one
+// batched residency query (Platform::QueryWorkingSet), and the answers are attributed back through a
+// range index: modules sorted by base, each owning a contiguous run of the page list.
+//
+// A resident page is either shared, still the page of the image file that other processes map too, or
+// private, a copy this process wrote (relocations, writable data).
+namespace WorkingSet {
+
+// Residency of one page, as reported by the query.
+enum PageFlags : uint8_t {
+    kResident = 1,
+    kShared = 2, // Only with kResident
+};
+
+/// @brief Fills flags[i] for pages[i], all page-aligned and ascending, in as few calls as the backend
+/// allows. Returns false if the backend is unavailable.
+using QueryFn = bool (*)(const uint64_t* pages, size_t count, uint8_t* flags);
+
+struct Module {
+    uint64_t base = 0;
+    uint64_t size = 0; // SizeOfImage
+
+    bool operator==(const Module&) const = default;
+};
+
+struct Counts {
+    uint32_t pages = 0;    // In the image
+    uint32_t resident = 0; // shared + private
+    uint32_t shared = 0;
+    uint32_t privatePages = 0;
+
+    bool operator==(const Counts&) const = default;
+};
+
+// Keeps the page list, index and flags of the last refresh, so that a refresh over the same modules
+// only queries and compares: the page list is not rebuilt and a module is recounted only when its
+// flags changed. Not thread-safe; the owner serializes calls.
+class Tracker {
+public:
+    struct Stats {
+        uint64_t refreshes = 0;
+        uint64_t rebuilds = 0;     // Refreshes whose module list differed from the last one
+        uint64_t pagesQueried = 0;
+    };
+
+    explicit Tracker(QueryFn query, uint64_t pageSize = 4096) : query_(query), pageSize_(pageSize) {}
+
+    /// @brief Queries every page of modules (in any order; overlaps are counted once, for the module
+    /// starting first) and updates the counts. Returns false if the query fails: the last counts are kept
+    /// if the modules are the same, and dropped otherwise.
+    bool Refresh(const std::vector<Module>& modules);
+
+    /// @brief The counts of the module loaded at base, or null if it was not in the last refresh.
+    const Counts* Find(uint64_t base) const;
+
+    /// @brief The index of the module whose image contains address, or SIZE_MAX. Indexes are those of
+    /// the modules passed to the last Refresh.
+    size_t FindAddress(uint64_t address) const;
+
+    /// @brief Bases of the modules whose counts changed in the last Refresh (every module after a rebuild).
+    const std::vector<uint64_t>& Changed() const { return changed_; }
+
+    Stats GetStats() const { return stats_; }
+
+    /// @brief Approximate bytes held by the page list, flags and index.
+    size_t Bytes() const;
+
+    /// @brief Forgets everything; the next Refresh rebuilds.
+    void Clear();
+
+private:
+    struct Span {
+        uint64_t base;
+        uint64_t end;        // Exclusive, clipped to the next module's base
+        uint32_t firstPage;  // Into pages_ and flags_
+        uint32_t pageCount;
+        uint32_t module;     // Index into the modules passed to Refresh
+    };
+
+    void Rebuild(const std::vector<Module>& modules);
+
+    QueryFn query_;
+    uint64_t pageSize_;
+    std::vector<Module> modules_;   // As passed to the last Refresh
+    std::vector<Span> spans_;       // Sorted by base: the range index
+    std::vector<uint64_t> pages_;   // Every page of every span, ascending
+    std::vector<uint8_t> flags_;    // Parallel to pages_, from the last query
+    std::vector<uint8_t> previous_; // The query before that
+    std::vector<Counts> counts_;    // Parallel to spans_
+    std::vector<uint64_t> changed_;
+    Stats stats_;
+};
+
+/// @brief Column text: "1234 KB (56%)" of the image resident, or empty for a module with no pages.
+std::wstring FormatResident(const Counts& counts, uint64_t pageSize);
+
+/// @brief Column text: "1100 KB / 134 KB", shared then private, or empty when nothing is resident.
+std::wstring FormatSharing(const Counts& counts, uint64_t pageSize);
+
+} // namespace WorkingSet
@@ -1,6 +1,7 @@
 #include "ModuleFolder.h"
 #include "Log.h"
 #include "DllNotification.h"
+#include "Perf.h"
 
 #include <shlobj.h>
 #include <strsafe.h>
@@ -74,7 +75,7 @@ HRESULT RegisterClsid(const wchar_t* modulePath) {
         &clsidKey,
         nullptr));
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"RegCreateKeyExW CLSID failed: 0x%08X", hr);
+        LOG_ERROR(L"RegCreateKeyExW CLSID failed: 0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
 
@@ -90,13 +91,13 @@ HRESULT RegisterClsid(const wchar_t* modulePath) {
         &classKey,
         nullptr));
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"RegCreateKeyExW CLSID subkey failed: 0x%08X", hr);
+        LOG_ERROR(L"RegCreateKeyExW CLSID subkey failed: 0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
 
     hr = SetStringValue(classKey, nullptr, kModuleFolderDisplayName);
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"Set CLSID display name failed: 0x%08X", hr);
+        LOG_ERROR(L"Set CLSID display name failed: 0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
 
@@ -129,7 +130,7 @@ HRESULT RegisterClsid(const wchar_t* modulePath) {
         &inprocKey,
         nullptr));
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"RegCreateKeyExW InProcServer32 failed: 0x%08X", hr);
+        LOG_ERROR(L"RegCreateKeyExW InProcServer32 failed: 0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
 
@@ -138,14 +139,15 @@ HRESULT RegisterClsid(const wchar_t* modulePath) {
         hr = SetStringValue(inprocKey, L"ThreadingModel", L"Apartment");
     }
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"Set InProcServer32 values failed: 0x%08X", hr);
+        LOG_ERROR(L"Set InProcServer32 values failed: 0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
 
     ScopedKey shellFolderKey;
     if (RegCreateKeyExW(classKey, L"ShellFolder", 0, nullptr, REG_OPTION_NON_VOLATILE, KEY_WRITE, nullptr, &shellFolderKey, nullptr) == ERROR_SUCCESS) {
         SetDwordValue(shellFolderKey, L"Attributes", SFGAO_FOLDER | SFGAO_DROPTARGET);
-        SetDwordValue(shellFolderKey, L"FolderValueFlags", FWF_NOSUBFOLDERS);
+        // No FolderValueFlags: FWF_NOSUBFOLDERS would hide the modules, which are folders.
+        RegDeleteValueW(shellFolderKey, L"FolderValueFlags");
     }
 
     ScopedKey iconKey;
@@ -155,7 +157,7 @@ HRESULT RegisterClsid(const wchar_t* modulePath) {
         SetStringValue(iconKey, nullptr, iconValue);
     }
 
-    Log::Write(Log::Level::Info, L"Registered CLSID %s", kModuleFolderClsidString);
+    LOG_INFO(L"Registered CLSID {}", kModuleFolderClsidString);
     return S_OK;
 }
 
@@ -172,7 +174,7 @@ HRESULT RegisterNamespace() {
         &nsKey,
         nullptr));
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"RegCreateKeyExW MyComputer NameSpace failed: 0x%08X", hr);
+        LOG_ERROR(L"RegCreateKeyExW MyComputer NameSpace failed: 0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
 
@@ -188,15 +190,15 @@ HRESULT RegisterNamespace() {
         &clsidKey,
         nullptr));
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"RegCreateKeyExW NameSpace CLSID failed: 0x%08X", hr);
+        LOG_ERROR(L"RegCreateKeyExW NameSpace CLSID failed: 0x{:08X}", static_cast<unsigned long>(hr));
         return hr;
     }
 
     hr = SetStringValue(clsidKey, nullptr, kModuleFolderDisplayName);
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"Set NameSpace display name failed: 0x%08X", hr);
+        LOG_ERROR(L"Set NameSpace display name failed: 0x{:08X}", static_cast<unsigned long>(hr));
     } else {
-        Log::Write(Log::Level::Info, L"Registered NameSpace entry for %s", kModuleFolderClsidString);
+        LOG_INFO(L"Registered NameSpace entry for {}", kModuleFolderClsidString);
     }
     return hr;
 }
@@ -206,25 +208,31 @@ HRESULT UnregisterTree(HKEY root, const wchar_t* subkey) {
 }
 } // namespace
 
-BOOL APIENTRY DllMain(HMODULE module, DWORD reason, LPVOID) {
+BOOL APIENTRY DllMain(HMODULE module, DWORD reason, LPVOID reserved) {
     if (reason == DLL_PROCESS_ATTACH) {
         g_module = module;
         Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().Create();
         DisableThreadLibraryCalls(module);
-        InitializeDllNotification();
+        // Nothing else starts here: the loader notification and the caches wait for the first folder
+        // (ModuleHelpers::AcquireSession), so processes that never browse it pay only for the load.
     }
     else if (reason == DLL_PROCESS_DETACH) {
+        // Normally already done by the last folder; a leaked one must not leave the callback registered.
         ShutdownDllNotification();
+        if (!reserved) {
+            // FreeLibrary rather than process exit, so no thread died holding the trace lock. The document
+            // was finished by DllCanUnloadNow; nothing is written here, under the loader lock.
+            Perf::DiscardTrace();
+        }
         Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule().Terminate();
     }
     return TRUE;
 }
 
 extern "C" STDAPI DllGetClassObject(REFCLSID clsid, REFIID riid, void** ppv) {
+    LOG_TRACE(L"DllGetClassObject called: clsid={}, riid={}",
+        IidNames::ToString(clsid), IidNames::ToString(riid));
 
-    Log::Write(Log::Level::Trace, L"DllGetClassObject called: clsid=%s, riid=%s", 
-        IidNames::ToString(clsid).c_str(), IidNames::ToString(riid).c_str());
-    
     if (!IsEqualCLSID(clsid, CLSID_ModuleFolder)) {
         return CLASS_E_CLASSNOTAVAILABLE;
     }
@@ -232,24 +240,31 @@ extern "C" STDAPI DllGetClassObject(REFCLSID clsid, REFIID riid, void** ppv) {
 }
 
 extern "C" STDAPI DllCanUnloadNow() {
+    // First, so a pending idle trim is told to finish even while its thread still counts as an object.
+    const bool ready = ModuleHelpers::ReadyToUnload();
     auto& module = Microsoft::WRL::Module<Microsoft::WRL::InProc>::GetModule();
-    return (module.GetObjectCount() == 0) ? S_OK : S_FALSE;
+    if (!ready || module.GetObjectCount() != 0) {
+        return S_FALSE;
+    }
+    // COM frees the DLL after this; finish the trace document now, outside the loader lock.
+    Perf::StopTrace();
+    return S_OK;
 }
 
 extern "C" STDAPI DllRegisterServer() {
     wchar_t modulePath[MAX_PATH] = {};
     if (!GetModuleFileNameW(g_module, modulePath, ARRAYSIZE(modulePath))) {
-        Log::Write(Log::Level::Error, L"GetModuleFileNameW failed: %lu", GetLastError());
+        LOG_ERROR(L"GetModuleFileNameW failed: {}", GetLastError());
         return HRESULT_FROM_WIN32(GetLastError());
     }
 
-    Log::Write(Log::Level::Info, L"DllRegisterServer: %s", modulePath);
+    LOG_INFO(L"DllRegisterServer: {}", modulePath);
     HRESULT hr = RegisterClsid(modulePath);
     if (SUCCEEDED(hr)) {
         hr = RegisterNamespace();
     }
     if (FAILED(hr)) {
-        Log::Write(Log::Level::Error, L"DllRegisterServer failed: 0x%08X", hr);
+        LOG_ERROR(L"DllRegisterServer failed: 0x{:08X}", static_cast<unsigned long>(hr));
     }
 
     SHChangeNotify(SHCNE_ASSOCCHANGED, SHCNF_IDLIST, nullptr, nullptr);
@@ -267,7 +282,7 @@ extern "C" STDAPI DllUnregisterServer() {
         L"%s\\%s", kKeyNamespaceRoot, kModuleFolderClsidString);
     UnregisterTree(HKEY_CURRENT_USER, nsPath);
 
-    Log::Write(Log::Level::Info, L"DllUnregisterServer completed");
+    LOG_INFO(L"DllUnregisterServer completed");
 
     SHChangeNotify(SHCNE_ASSOCCHANGED, SHCNF_IDLIST, nullptr, nullptr);
     return S_OK;
@@ -0,0 +1,233 @@
+#include "AddressSpace.h"
+#include "SyntheticPe.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Region-to-module attribution: a hand-worked layout whose regions straddle the edges of modules and
+// sections, then random layouts against a page-by-page reference. Also the section list of a synthetic
+// image, and the detail rows.
+
+namespace {
+
+constexpr uint64_t kPage = 0x1000;
+
+using Platform::RegionUse;
+
+AddressSpace::Section MakeSection(const char* name, uint32_t rva, uint32_t size) {
+    AddressSpace::Section section;
+    section.name = name;
+    section.rva = rva;
+    section.size = size;
+    return section;
+}
+
+AddressSpace::Usage MakeUsage(uint64_t committed, uint64_t privateBytes, uint64_t copyOnWrite) {
+    AddressSpace::Usage usage;
+    usage.committed = committed;
+    usage.privateBytes = privateBytes;
+    usage.copyOnWrite = copyOnWrite;
+    return usage;
+}
+
+AddressSpace::Usage UsageOf(RegionUse use, uint64_t bytes) {
+    switch (use) {
+    case RegionUse::Reserved:
+        return {};
+    case RegionUse::Shared:
+        return MakeUsage(bytes, 0, 0);
+    case RegionUse::CopyOnWrite:
+        return MakeUsage(bytes, 0, bytes);
+    case RegionUse::Private:
+        return MakeUsage(bytes, bytes, 0);
+    }
+    return {};
+}
+
+uint32_t g_seed = 777;
+
+uint32_t Next() {
+    g_seed = g_seed * 1664525 + 1013904223;
+    return g_seed >> 8;
+}
+
+} // namespace
+
+TEST_CASE(AddressSpaceStraddlingRegions) {
+    // A at 0x10000: headers, .text, a one-page gap, .data, and a one-page tail with no section. B starts
+    // right where A ends.
+    AddressSpace::Module a;
+    a.base = 0x10000;
+    a.size = 0x6000;
+    a.sections = { MakeSection("(headers)", 0, 0x1000), MakeSection(".text", 0x1000, 0x2000),
+        MakeSection(".data", 0x4000, 0x1000) };
+    AddressSpace::Module b;
+    b.base = 0x16000;
+    b.size = 0x3000;
+    b.sections = { MakeSection("(headers)", 0, 0x1000), MakeSection(".text", 0x1000, 0x2000) };
+
+    const std::vector<Platform::MemoryRegion> regions = {
+        { 0x8000, 0x9000, RegionUse::Private },      // From below A into its headers
+        { 0x11000, 0x2000, RegionUse::Shared },      // Exactly A's .text
+        { 0x13000, 0x2000, RegionUse::CopyOnWrite }, // A's gap and .data
+        { 0x15000, 0x2000, RegionUse::Private },     // A's tail and B's headers
+        { 0x17000, 0x1000, RegionUse::Reserved },
+        { 0x18000, 0x2000, RegionUse::Shared },      // B's last page and beyond
+    };
+    const AddressSpace::Map map({ b, a }, regions);
+
+    CHECK(map.Modules().size() == 2);
+    CHECK(map.Modules()[0].base == a.base);
+    const auto* first = map.Find(a.base);
+    const auto* second = map.Find(b.base);
+    CHECK(first && second);
+    CHECK(map.Find(a.base + kPage) == nullptr);
+
+    CHECK(first->usage == MakeUsage(0x6000, 0x2000, 0x2000));
+    CHECK(first->sections[0].usage == MakeUsage(0x1000, 0x1000, 0));
+    CHECK(first->sections[1].usage == MakeUsage(0x2000, 0, 0));
+    CHECK(first->sections[2].usage == MakeUsage(0x1000, 0, 0x1000));
+
+    CHECK(second->usage == MakeUsage(0x2000, 0x1000, 0));
+    CHECK(second->sections[0].usage == MakeUsage(0x1000, 0x1000, 0));
+    CHECK(second->sections[1].usage == MakeUsage(0x1000, 0, 0));
+
+    const auto stats = map.GetStats();
+    CHECK(stats.regions == regions.size());
+    CHECK(stats.intervals == 5 + 2);
+    CHECK(stats.imageBytes == 0x8000);
+
+    // The gap and the tail come out as "(other)".
+    const auto listing = AddressSpace::Describe(*first);
+    CHECK(listing.entries.size() == 4);
+    CHECK(listing.entries[0].name == L"(headers)");
+    CHECK(listing.entries[3].name == L"(other)");
+    CHECK(listing.entries[3].details[0] == L"8 KB");
+    CHECK(listing.entries[3].details[1] == L"4 KB");
+    CHECK(listing.entries[3].details[2] == L"4 KB");
+    CHECK(AddressSpace::Describe(*second).entries.size() == 2);
+}
+
+TEST_CASE(AddressSpaceOverlappingImages) {
+    // The second image starts inside the first, which ends there.
+    AddressSpace::Module a;
+    a.base = 0x40000;
+    a.size = 0x4000;
+    a.sections = { MakeSection(".text", 0, 0x4000) };
+    AddressSpace::Module b;
+    b.base = 0x42000;
+    b.size = 0x2000;
+    b.sections = { MakeSection(".text", 0, 0x2000) };
+    const AddressSpace::Map map({ a, b }, { { 0x40000, 0x4000, RegionUse::Shared } });
+    CHECK(map.Find(a.base)->usage.committed == 0x2000);
+    CHECK(map.Find(a.base)->sections[0].usage.committed == 0x2000);
+    CHECK(map.Find(b.base)->usage.committed == 0x2000);
+    CHECK(map.GetStats().imageBytes == 0x4000);
+}
+
+TEST_CASE(AddressSpaceMatchesReference) {
+    for (int round = 0; round < 50; ++round) {
+        // Modules a few pages apart or adjacent, each with sections separated by the odd gap.
+        std::vector<AddressSpace::Module> modules;
+        uint64_t base = 0x100000;
+        for (int m = 0; m < 6; ++m) {
+            AddressSpace::Module module;
+            module.base = base;
+            uint32_t rva = 0;
+            for (int s = 0; s < 4; ++s) {
+                rva += static_cast<uint32_t>(Next() % 2 * kPage);
+                const auto size = static_cast<uint32_t>((1 + Next() % 3) * kPage);
+                module.sections.push_back(MakeSection("s", rva, size));
+                rva += size;
+            }
+            module.size = rva + Next() % 2 * kPage;
+            modules.push_back(module);
+            base += module.size + Next() % 3 * kPage;
+        }
+
+        // Regions of one to eight pages with random uses and holes, from below the first module to
+        // beyond the last.
+        std::vector<Platform::MemoryRegion> regions;
+        for (uint64_t address = 0xF0000; address < base + 0x10000;) {
+            const uint64_t size = (1 + Next() % 8) * kPage;
+            if (Next() % 4 != 0) {
+                regions.push_back({ address, size, static_cast<RegionUse>(Next() % 4) });
+            }
+            address += size;
+        }
+
+        // Reference: page by page, the module containing it and the section within that module.
+        std::vector<AddressSpace::Usage> moduleUsage(modules.size());
+        std::vector<std::vector<AddressSpace::Usage>> sectionUsage(modules.size());
+        for (size_t m = 0; m < modules.size(); ++m) {
+            sectionUsage[m].resize(modules[m].sections.size());
+        }
+        for (const auto& region : regions) {
+            for (uint64_t page = region.base; page < region.base + region.size; page += kPage) {
+                for (size_t m = 0; m < modules.size(); ++m) {
+                    const auto& module = modules[m];
+                    if (page < module.base || page >= module.base + module.size) {
+                        continue;
+                    }
+                    moduleUsage[m] += UsageOf(region.use, kPage);
+                    for (size_t s = 0; s < module.sections.size(); ++s) {
+                        const uint64_t start = module.base + module.sections[s].rva;
+                        if (page >= start && page < start + module.sections[s].size) {
+                            sectionUsage[m][s] += UsageOf(region.use, kPage);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Reversed, so the map has to sort them.
+        std::vector<AddressSpace::Module> reversed(modules.rbegin(), modules.rend());
+        const AddressSpace::Map map(std::move(reversed), regions);
+        uint64_t imageBytes = 0;
+        for (size_t m = 0; m < modules.size(); ++m) {
+            const auto* module = map.Find(modules[m].base);
+            CHECK(module != nullptr);
+            if (module == nullptr) {
+                continue;
+            }
+            CHECK(module->usage == moduleUsage[m]);
+            for (size_t s = 0; s < modules[m].sections.size(); ++s) {
+                CHECK(module->sections[s].usage == sectionUsage[m][s]);
+            }
+            imageBytes += moduleUsage[m].committed;
+        }
+        CHECK(map.GetStats().imageBytes == imageBytes);
+    }
+}
+
+TEST_CASE(AddressSpaceSectionsOfImage) {
+    SyntheticPe::Options options;
+    options.sectionCount = 3;
+    options.codeSize = 0x2800;
+    const auto image = SyntheticPe::Build(options);
+    const PeImage::View view(image.data(), image.size());
+    const auto sections = AddressSpace::Sections(view, kPage);
+    CHECK(sections.size() == view.SectionCount() + 1);
+    CHECK(sections[0].name == "(headers)");
+    CHECK(sections[0].rva == 0);
+    CHECK(sections[0].size == sections[1].rva);
+    CHECK(sections[1].name == ".text");
+    CHECK(sections[1].size == 0x3000);
+    for (size_t i = 1; i < sections.size(); ++i) {
+        CHECK(sections[i].size % kPage == 0);
+        CHECK(sections[i - 1].rva < sections[i].rva);
+        CHECK(uint64_t{ sections[i].rva } + sections[i].size <= view.SizeOfImage());
+    }
+
+    const std::vector<uint8_t> notPe(512);
+    CHECK(AddressSpace::Sections(PeImage::View(notPe.data(), notPe.size()), kPage).empty());
+}
+
+TEST_CASE(AddressSpaceFormat) {
+    CHECK(AddressSpace::FormatCommitted(MakeUsage(1, 0, 0)) == L"1 KB");
+    CHECK(AddressSpace::FormatCommitted({}) == L"0 KB");
+    CHECK(AddressSpace::FormatPrivate({}).empty());
+    CHECK(AddressSpace::FormatPrivate(MakeUsage(0x5000, 0x3000, 0x1000)) == L"12 KB / 4 KB");
+}
@@ -0,0 +1,116 @@
+#include "CodeIntegrity.h"
+#include "PeImage.h"
+#include "SyntheticProcess.h"
+#include "Test.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Relocated synthetic images must compare equal to their files, planted jumps must be found, and an image
+// whose load config carries a dynamic value relocation table must be skipped rather than reported.
+
+namespace {
+
+const std::vector<SyntheticProcess::Image>* g_images = nullptr;
+
+CodeIntegrity::File OpenImage(const std::wstring& path) {
+    for (const auto& image : *g_images) {
+        if (image.path == path) {
+            CodeIntegrity::File file;
+            file.data = image.file.data();
+            file.size = image.file.size();
+            return file;
+        }
+    }
+    return {};
+}
+
+std::vector<SyntheticProcess::Image> MakeProcess(uint32_t relocations = 64) {
+    SyntheticProcess::Options options;
+    options.modules = 6;
+    options.exportsPerModule = 16;
+    options.importModules = 2;
+    options.importsPerModule = 8;
+    options.codeSize = 16 << 10;
+    options.relocations = relocations;
+    return SyntheticProcess::Build(options);
+}
+
+std::vector<CodeIntegrity::ModuleResult> Check(const std::vector<SyntheticProcess::Image>& images) {
+    g_images = &images;
+    CodeIntegrity::Options options;
+    options.threads = 2;
+    return CodeIntegrity::Check(SyntheticProcess::Modules(images), OpenImage, options);
+}
+
+// Writes a load config of configSize bytes into .text of both the file and the mapped image, with the
+// DynamicValueRelocTableSection field set if dvrt, and points the load config directory at it. The image
+// must have no relocations, or the config could overwrite a fixup.
+void PlantLoadConfig(SyntheticProcess::Image& image, uint32_t configSize, bool dvrt) {
+    const PeImage::View view(image.file.data(), image.file.size());
+    const auto text = view.SectionAt(0);
+    std::vector<uint8_t> config(configSize);
+    std::memcpy(config.data(), &configSize, sizeof(configSize));
+    const size_t sectionField = view.Is64Bit() ? 0xE4 : 0x8C;
+    if (dvrt && sectionField + sizeof(uint16_t) <= config.size()) {
+        const uint32_t offset = 0x10;
+        const uint16_t section = 1;
+        std::memcpy(config.data() + sectionField - sizeof(offset), &offset, sizeof(offset));
+        std::memcpy(config.data() + sectionField, &section, sizeof(section));
+    }
+    const uint32_t rva = text.virtualAddress + 0x400;
+    std::memcpy(image.file.data() + text.pointerToRawData + 0x400, config.data(), config.size());
+    std::memcpy(image.mapped.data() + rva, config.data(), config.size());
+
+    const size_t optionalHeader = PeImage::ReadAt<uint32_t>(image.file.data(), 0x3C) + 24;
+    const size_t directories = optionalHeader + (view.Is64Bit() ? 112 : 96);
+    const PeImage::DataDirectory entry = { rva, configSize };
+    const size_t slot = directories + PeImage::kDirectoryLoadConfig * sizeof(entry);
+    std::memcpy(image.file.data() + slot, &entry, sizeof(entry));
+    std::memcpy(image.mapped.data() + slot, &entry, sizeof(entry));
+}
+
+} // namespace
+
+TEST_CASE(CodeIntegrityRelocatedImagesIntact) {
+    const auto images = MakeProcess();
+    const auto results = Check(images);
+    CHECK(results.size() == images.size());
+    for (const auto& result : results) {
+        CHECK(result.status == CodeIntegrity::Status::Intact);
+        CHECK(result.sectionsChecked != 0);
+        CHECK(result.bytesChanged == 0);
+        CHECK(CodeIntegrity::Summary(result) == L"OK");
+    }
+}
+
+TEST_CASE(CodeIntegrityPatchesFound) {
+    auto images = MakeProcess();
+    const size_t patched = SyntheticProcess::PatchCode(images, 5, 7);
+    CHECK(patched == 5);
+    size_t ranges = 0;
+    for (const auto& result : Check(images)) {
+        if (result.status == CodeIntegrity::Status::Modified) {
+            ranges += result.ranges.size();
+            CHECK(result.bytesChanged != 0);
+        } else {
+            CHECK(result.status == CodeIntegrity::Status::Intact);
+        }
+    }
+    CHECK(ranges == patched);
+}
+
+TEST_CASE(CodeIntegrityDynamicRelocationsSkipped) {
+    auto images = MakeProcess(0);
+    PlantLoadConfig(images[1], 0x100, true);
+    // A load config without the table, and one too old to have the fields, are still compared.
+    PlantLoadConfig(images[2], 0x100, false);
+    PlantLoadConfig(images[3], 0x40, true);
+    const auto results = Check(images);
+    CHECK(results[1].status == CodeIntegrity::Status::DynamicRelocations);
+    CHECK(CodeIntegrity::Summary(results[1]) == L"Not checked (dynamic relocations)");
+    CHECK(results[2].status == CodeIntegrity::Status::Intact);
+    CHECK(results[3].status == CodeIntegrity::Status::Intact);
+    CHECK(results[0].status == CodeIntegrity::Status::Intact);
+}
@@ -0,0 +1,168 @@
+#include "DuplicateScan.h"
+#include "SyntheticPe.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+// Grouping by fingerprint and then by content hash, over files served from memory: a true copy at a
+// second path, a fingerprint collision between different files, an older build under the same name, a
+// module without a fingerprint, and files that cannot be read.
+
+namespace {
+
+struct FakeFile {
+    uint64_t fileId;
+    std::string content;
+};
+
+const std::map<std::wstring, FakeFile> kFiles = {
+    { L"C:\\Windows\\System32\\a.dll", { 1, "alpha" } },
+    { L"C:\\App\\a.dll", { 2, "alpha" } },
+    { L"C:\\Temp\\b.dll", { 3, "beta" } },
+    { L"C:\\Other\\c.dll", { 4, "gamma" } },
+    { L"C:\\Old\\A.DLL", { 5, "alpha, an older build" } },
+    { L"C:\\Z\\e.dll", { 6, "alpha" } },
+};
+
+std::atomic<size_t> g_bytesRead{ 0 };
+
+class MemoryFile : public Platform::SequentialFile {
+public:
+    explicit MemoryFile(const FakeFile& file) : content_(file.content) {
+        identity_.volume = 1;
+        identity_.fileId = file.fileId;
+        identity_.size = content_.size();
+    }
+
+    const Platform::FileIdentity& Identity() const override { return identity_; }
+
+    bool Read(void* buffer, size_t size, size_t& bytesRead) override {
+        bytesRead = std::min(size, content_.size() - offset_);
+        std::copy_n(content_.data() + offset_, bytesRead, static_cast<char*>(buffer));
+        offset_ += bytesRead;
+        g_bytesRead += bytesRead;
+        return true;
+    }
+
+private:
+    Platform::FileIdentity identity_;
+    const std::string& content_;
+    size_t offset_ = 0;
+};
+
+std::unique_ptr<Platform::SequentialFile> OpenMemoryFile(const std::wstring& path) {
+    const auto file = kFiles.find(path);
+    if (file == kFiles.end()) {
+        return nullptr;
+    }
+    return std::make_unique<MemoryFile>(file->second);
+}
+
+DuplicateScan::Module MakeModule(const wchar_t* path, uint32_t timeDateStamp) {
+    DuplicateScan::Module module;
+    module.path = path;
+    module.fingerprint.timeDateStamp = timeDateStamp;
+    module.fingerprint.sizeOfImage = 0x20000;
+    module.fingerprint.checksum = 0x1234;
+    module.fingerprint.machine = 0x8664;
+    module.fingerprinted = timeDateStamp != 0;
+    return module;
+}
+
+std::vector<DuplicateScan::Module> Modules() {
+    return {
+        MakeModule(L"C:\\Windows\\System32\\a.dll", 100), // 0: copied by 1
+        MakeModule(L"C:\\App\\a.dll", 100),               // 1
+        MakeModule(L"C:\\Temp\\b.dll", 200),              // 2: same fingerprint as 3, different content
+        MakeModule(L"C:\\Other\\c.dll", 200),             // 3
+        MakeModule(L"C:\\Old\\A.DLL", 99),                // 4: an older a.dll
+        MakeModule(L"C:\\Z\\e.dll", 0),                   // 5: no fingerprint; same content as 0 and 1
+        MakeModule(L"C:\\Gone\\f.dll", 300),              // 6: unreadable, same fingerprint as 7
+        MakeModule(L"C:\\Gone\\g.dll", 300),              // 7
+    };
+}
+
+} // namespace
+
+TEST_CASE(DuplicateScanGroupsByFingerprintAndHash) {
+    for (const uint32_t threads : { 1u, 3u }) {
+        const auto report = DuplicateScan::Detect(Modules(), OpenMemoryFile, nullptr, threads);
+        CHECK(report.modules.size() == 8);
+
+        // Identical content at two paths.
+        CHECK(report.modules[0].flags == (DuplicateScan::kCopy | DuplicateScan::kVersion));
+        CHECK(report.modules[0].copies == 2);
+        CHECK(report.modules[1].copies == 2);
+        // Colliding fingerprints whose hashes differ are not copies.
+        CHECK(report.modules[2].flags == 0);
+        CHECK(report.modules[3].flags == 0);
+        // Two builds under the name a.dll, whatever the case and directory.
+        CHECK(report.modules[0].versions == 2);
+        CHECK(report.modules[1].versions == 2);
+        CHECK(report.modules[4].flags == DuplicateScan::kVersion);
+        CHECK(report.modules[4].versions == 2);
+        // Without a fingerprint a module matches nothing, and it is never read.
+        CHECK(report.modules[5].flags == 0);
+        // Files that cannot be read stay matched by fingerprint alone.
+        CHECK(report.modules[6].flags == DuplicateScan::kCopy);
+        CHECK(report.modules[7].copies == 2);
+
+        CHECK(report.copies == 4);
+        CHECK(report.versions == 3);
+        CHECK(report.filesHashed == 6);
+
+        CHECK(DuplicateScan::Summary(report.modules[0]) == L"2 copies, 2 versions");
+        CHECK(DuplicateScan::Summary(report.modules[4]) == L"2 versions");
+        CHECK(DuplicateScan::Summary(report.modules[6]) == L"2 copies");
+        CHECK(DuplicateScan::Summary(report.modules[2]).empty());
+    }
+}
+
+TEST_CASE(DuplicateScanCachedHashes) {
+    FileHash::Cache cache;
+    const auto modules = Modules();
+    g_bytesRead = 0;
+    const auto first = DuplicateScan::Detect(modules, OpenMemoryFile, &cache);
+    CHECK(g_bytesRead != 0);
+
+    // Unchanged files are not read again, and the grouping is the same.
+    g_bytesRead = 0;
+    const auto second = DuplicateScan::Detect(modules, OpenMemoryFile, &cache);
+    CHECK(g_bytesRead == 0);
+    CHECK(second.copies == first.copies);
+    CHECK(second.versions == first.versions);
+    for (size_t i = 0; i < modules.size(); ++i) {
+        CHECK(second.modules[i].flags == first.modules[i].flags);
+    }
+}
+
+TEST_CASE(DuplicateScanNoCollisionsNoReads) {
+    auto modules = Modules();
+    modules.resize(1);
+    modules.push_back(MakeModule(L"C:\\Temp\\b.dll", 200));
+    g_bytesRead = 0;
+    const auto report = DuplicateScan::Detect(modules, OpenMemoryFile, nullptr);
+    CHECK(g_bytesRead == 0);
+    CHECK(report.filesHashed == 0);
+    CHECK(report.copies == 0 && report.versions == 0);
+}
+
+TEST_CASE(DuplicateScanReadFingerprint) {
+    SyntheticPe::Options options;
+    options.checksum = true;
+    const auto image = SyntheticPe::Build(options);
+    const PeImage::View view(image.data(), image.size());
+    DuplicateScan::Fingerprint fingerprint;
+    CHECK(DuplicateScan::ReadFingerprint(image.data(), image.size(), fingerprint));
+    CHECK(fingerprint.timeDateStamp == view.TimeDateStamp());
+    CHECK(fingerprint.sizeOfImage == view.SizeOfImage());
+    CHECK(fingerprint.checksum == view.Checksum() && fingerprint.checksum != 0);
+    CHECK(fingerprint.machine == PeImage::kMachineAmd64);
+
+    const std::vector<uint8_t> notPe(256);
+    CHECK(!DuplicateScan::ReadFingerprint(notPe.data(), notPe.size(), fingerprint));
+}
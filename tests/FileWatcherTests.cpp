@@ -0,0 +1,69 @@
+#include "FileWatcher.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+// Generations stamped by SetFiles, and one rewrite delivered through the platform backend. Where the
+// backend cannot start, only the bookkeeping is checked.
+
+namespace {
+
+struct Deliveries {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::wstring> paths;
+};
+
+void OnChanged(void* context, const std::vector<std::wstring>& paths) {
+    auto* deliveries = static_cast<Deliveries*>(context);
+    {
+        std::lock_guard lock(deliveries->mutex);
+        deliveries->paths.insert(deliveries->paths.end(), paths.begin(), paths.end());
+    }
+    deliveries->changed.notify_all();
+}
+
+} // namespace
+
+TEST_CASE(FileWatcherGenerations) {
+    const auto directory = std::filesystem::temp_directory_path() / "explorer_modules_test.watch";
+    std::filesystem::create_directories(directory);
+    const auto watched = directory / "watched.dll";
+    const auto other = directory / "other.dll";
+    std::ofstream(watched) << 1;
+    std::ofstream(other) << 1;
+
+    Deliveries deliveries;
+    FileWatcher watcher(OnChanged, &deliveries, std::chrono::milliseconds(5));
+    CHECK(watcher.Generation(watched.wstring()) == 0);
+    watcher.SetFiles({ watched.wstring() });
+    const uint64_t added = watcher.Generation();
+    CHECK(added > 0);
+    CHECK(watcher.Generation(watched.wstring()) == added); // New files count as changed
+    CHECK(watcher.Generation((directory / "WATCHED.DLL").wstring()) == added);
+    CHECK(watcher.Generation(other.wstring()) == 0);
+    CHECK(watcher.GetStats().files == 1 && watcher.GetStats().directories == 1);
+
+    if (watcher.IsWatching()) {
+        std::ofstream(other) << 2; // Same directory, not watched: dropped
+        std::ofstream(watched) << 2;
+        std::unique_lock lock(deliveries.mutex);
+        deliveries.changed.wait_for(lock, std::chrono::seconds(5), [&] { return !deliveries.paths.empty(); });
+        // Truncate and write may land in separate windows; either way only the watched file is reported.
+        CHECK(!deliveries.paths.empty());
+        CHECK(std::all_of(deliveries.paths.begin(), deliveries.paths.end(),
+            [&](const std::wstring& path) { return path == watched.wstring(); }));
+        lock.unlock();
+        CHECK(watcher.Generation(watched.wstring()) > added);
+    }
+
+    watcher.SetFiles({});
+    CHECK(watcher.Generation(watched.wstring()) == 0);
+    CHECK(watcher.GetStats().files == 0 && watcher.GetStats().directories == 0);
+    std::error_code ignored;
+    std::filesystem::remove_all(directory, ignored);
+}
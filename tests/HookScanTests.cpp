@@ -0,0 +1,116 @@
+#include "HookScan.h"
+#include "SyntheticProcess.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// A bound synthetic process must scan clean, and after SyntheticProcess::Hook every patched table entry,
+// found independently by diffing the images, must come back as exactly one finding with the right verdict.
+
+namespace {
+
+std::vector<SyntheticProcess::Image> MakeProcess() {
+    SyntheticProcess::Options options;
+    options.modules = 12;
+    options.exportsPerModule = 40;
+    options.importModules = 3;
+    options.importsPerModule = 10;
+    return SyntheticProcess::Build(options);
+}
+
+// (module, RVA) of each 4-byte-aligned dword that differs between the two processes.
+std::vector<std::pair<uint32_t, uint32_t>> ChangedDwords(const std::vector<SyntheticProcess::Image>& before,
+    const std::vector<SyntheticProcess::Image>& after) {
+    std::vector<std::pair<uint32_t, uint32_t>> dwords;
+    for (uint32_t i = 0; i < before.size(); ++i) {
+        const auto& a = before[i].mapped;
+        const auto& b = after[i].mapped;
+        for (uint32_t rva = 0; rva + 4 <= a.size(); rva += 4) {
+            if (std::memcmp(a.data() + rva, b.data() + rva, 4) != 0) {
+                dwords.emplace_back(i, rva);
+            }
+        }
+    }
+    return dwords;
+}
+
+} // namespace
+
+TEST_CASE(HookScanCleanProcess) {
+    const auto images = MakeProcess();
+    const auto modules = SyntheticProcess::Modules(images);
+    const auto report = HookScan::Scan(modules, nullptr, 2);
+    CHECK(report.findings.empty());
+    CHECK(report.modules.size() == modules.size());
+    for (const auto& result : report.modules) {
+        CHECK(result.scanned);
+        CHECK(result.importsChecked == 3 * 10);
+        CHECK(result.exportsChecked == 40);
+        CHECK(result.hooked == 0);
+    }
+}
+
+TEST_CASE(HookScanPlantedHooksFlagged) {
+    const auto clean = MakeProcess();
+    auto images = clean;
+    const size_t planted = SyntheticProcess::Hook(images, 25, 3);
+    CHECK(planted == 25);
+
+    const auto modules = SyntheticProcess::Modules(images);
+    const HookScan::ModuleIndex index(modules);
+    const auto report = HookScan::Scan(modules, nullptr, 3);
+    CHECK(report.findings.size() == planted);
+
+    uint32_t hooked = 0;
+    for (const auto& result : report.modules) {
+        hooked += result.hooked;
+    }
+    CHECK(hooked == planted);
+    // Every changed dword lies in exactly one flagged slot: 8 bytes for an IAT slot, 4 for an EAT entry.
+    auto unclaimed = ChangedDwords(clean, images);
+    for (const auto& finding : report.findings) {
+        const uint32_t width = finding.table == HookScan::Table::Import ? 8 : 4;
+        const auto claimed = std::remove_if(unclaimed.begin(), unclaimed.end(), [&](const auto& dword) {
+            return dword.first == finding.module && dword.second >= finding.slotRva &&
+                dword.second < finding.slotRva + width;
+        });
+        CHECK(claimed != unclaimed.end());
+        unclaimed.erase(claimed, unclaimed.end());
+
+        const uint32_t owner = index.Find(finding.actual);
+        CHECK(finding.actualModule == owner);
+        if (owner == HookScan::kNoModule) {
+            CHECK(finding.verdict == HookScan::Verdict::Unbacked);
+        } else {
+            CHECK(finding.verdict == HookScan::Verdict::Redirected);
+            CHECK(owner != finding.module);
+        }
+        if (finding.table == HookScan::Table::Import) {
+            CHECK(finding.expected != 0);
+            CHECK(!finding.importedFrom.empty());
+        }
+        CHECK(!finding.function.empty());
+    }
+    CHECK(unclaimed.empty());
+}
+
+TEST_CASE(HookScanModuleIndex) {
+    const auto images = MakeProcess();
+    const auto modules = SyntheticProcess::Modules(images);
+    const HookScan::ModuleIndex index(modules);
+    for (uint32_t i = 0; i < modules.size(); ++i) {
+        CHECK(index.Find(modules[i].base) == i);
+        CHECK(index.Find(modules[i].base + modules[i].size - 1) == i);
+        // Build leaves a gap after every module.
+        CHECK(index.Find(modules[i].base + modules[i].size) == HookScan::kNoModule);
+        CHECK(index.FindBase(modules[i].base) == i);
+        CHECK(index.FindBase(modules[i].base + 0x1000) == HookScan::kNoModule);
+    }
+    CHECK(index.Find(0) == HookScan::kNoModule);
+    CHECK(index.FindByName("synthetic-import-0004.dll") == 4);
+    CHECK(index.FindByName("SYNTHETIC-IMPORT-0004") == 4);
+    CHECK(index.FindByName("synthetic-import-0099.dll") == HookScan::kNoModule);
+}
@@ -0,0 +1,79 @@
+#include "LoadTimeline.h"
+#include "Test.h"
+
+#include <string>
+
+// Load storms replayed with fixed timestamps and thread keys, so every duration and attribution below
+// is exact.
+
+namespace {
+
+using std::chrono::milliseconds;
+
+const Perf::Clock::time_point kStart = Perf::Clock::time_point() + std::chrono::hours(1);
+
+const void* Base(uintptr_t value) {
+    return reinterpret_cast<const void*>(value);
+}
+
+void Loaded(LoadTimeline& timeline, uint64_t thread, uintptr_t base, const std::wstring& path, milliseconds at) {
+    timeline.OnLoaded(thread, Base(base), path.c_str(), path.size(), kStart + at);
+}
+
+} // namespace
+
+TEST_CASE(LoadTimelineTimedLoad) {
+    LoadTimeline timeline;
+    const uint64_t token = timeline.BeginLoad(1, L"root.dll", kStart);
+    Loaded(timeline, 1, 0x2000, L"dep.dll", milliseconds(3));
+    Loaded(timeline, 1, 0x1000, L"root.dll", milliseconds(4));
+    timeline.EndLoad(token, Base(0x1000), kStart + milliseconds(10));
+
+    LoadTimeline::Record record;
+    CHECK(timeline.Find(Base(0x1000), record));
+    CHECK(record.timed && record.loadedBy.empty());
+    CHECK(record.duration == milliseconds(10));
+    CHECK(timeline.Find(Base(0x2000), record));
+    CHECK(!record.timed && record.loadedBy == L"root.dll");
+    CHECK(record.duration == milliseconds(3));
+
+    const auto stats = timeline.GetStats();
+    CHECK(stats.events == 2 && stats.timed == 1 && stats.cascades == 0 && stats.modules == 2);
+}
+
+TEST_CASE(LoadTimelineCascades) {
+    LoadTimeline timeline;
+    Loaded(timeline, 7, 0x1000, L"a.dll", milliseconds(0));
+    Loaded(timeline, 7, 0x2000, L"b.dll", milliseconds(1));
+    Loaded(timeline, 7, 0x3000, L"c.dll", milliseconds(2));
+    Loaded(timeline, 8, 0x4000, L"other.dll", milliseconds(2)); // Another thread starts its own cascade
+    Loaded(timeline, 7, 0x5000, L"late.dll", milliseconds(20));  // Past kCascadeGap: a new root
+
+    LoadTimeline::Record record;
+    CHECK(timeline.Find(Base(0x1000), record));
+    CHECK(record.loadedBy.empty() && record.duration == milliseconds(2));
+    CHECK(timeline.Find(Base(0x3000), record));
+    CHECK(record.loadedBy == L"a.dll" && record.duration == milliseconds(1));
+    CHECK(timeline.Find(Base(0x4000), record));
+    CHECK(record.loadedBy.empty());
+    CHECK(timeline.Find(Base(0x5000), record));
+    CHECK(record.loadedBy.empty() && record.duration == milliseconds(0));
+    CHECK(timeline.GetStats().cascades == 3);
+}
+
+TEST_CASE(LoadTimelineUnload) {
+    LoadTimeline timeline;
+    Loaded(timeline, 1, 0x1000, L"a.dll", milliseconds(0));
+    timeline.OnUnloaded(Base(0x1000));
+    LoadTimeline::Record record;
+    CHECK(!timeline.Find(Base(0x1000), record));
+
+    // The root is gone, so a module following it closely is not charged to it.
+    Loaded(timeline, 1, 0x2000, L"b.dll", milliseconds(1));
+    CHECK(timeline.Find(Base(0x2000), record));
+    CHECK(record.loadedBy.empty());
+
+    timeline.Clear();
+    CHECK(!timeline.Find(Base(0x2000), record));
+    CHECK(timeline.GetStats().modules == 0);
+}
@@ -0,0 +1,34 @@
+#include "Log.h"
+#include "Test.h"
+
+#include <string>
+
+// The runtime half of the fallback formatter. Its compile-time half refuses what these cases cannot
+// express: narrow strings, hex specs on non-integers, over-long flags and mismatched field counts.
+
+#if !EXPLORER_MODULES_HAS_STD_FORMAT
+
+namespace {
+
+template <class... Args>
+std::wstring Format(Log::detail::FormatString<std::type_identity_t<Args>...> format, const Args&... args) {
+    return Log::detail::FormatFallback(format.text, args...);
+}
+
+} // namespace
+
+TEST_CASE(LogFallbackFields) {
+    CHECK(Format(L"plain") == L"plain");
+    CHECK(Format(L"{} and {}", 42, -7) == L"42 and -7");
+    CHECK(Format(L"{}: {}", L"path", std::wstring(L"value")) == L"path: value");
+    CHECK(Format(L"{{literal}} {}", 1u) == L"{literal} 1");
+}
+
+TEST_CASE(LogFallbackHex) {
+    CHECK(Format(L"0x{:08X}", 0xBEEFu) == L"0x0000BEEF");
+    CHECK(Format(L"{:x}", 0xABCDull) == L"abcd");
+    CHECK(Format(L"{:X}", 0x80070005u) == L"80070005");
+    CHECK(Format(L"{:#0018x}", 1u) == L"0x0000000000000001");
+}
+
+#endif
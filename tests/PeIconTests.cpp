@@ -0,0 +1,197 @@
+#include "PeIcon.h"
+#include "SyntheticPe.h"
+#include "Test.h"
+
+#include <cstring>
+#include <vector>
+
+// DIB decoding against hand-built bitmaps with known pixels, the icons of synthetic images at every bit
+// depth, and identification by content: images carrying the same icon share one digest and one cached
+// decode, whatever else differs between them.
+
+namespace {
+
+template <class T>
+void Append(std::vector<uint8_t>& out, T value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+// A BITMAPINFOHEADER for a width x height icon (the height field counts the AND mask too), then the
+// palette, the XOR rows and the AND rows, each already bottom-up and padded to 4 bytes.
+std::vector<uint8_t> MakeDib(int32_t width, int32_t height, uint16_t bitCount, const std::vector<uint32_t>& palette,
+    const std::vector<uint8_t>& xorRows, const std::vector<uint8_t>& andRows) {
+    std::vector<uint8_t> dib;
+    Append(dib, uint32_t{ 40 });
+    Append(dib, width);
+    Append(dib, height * 2);
+    Append(dib, uint16_t{ 1 });
+    Append(dib, bitCount);
+    dib.resize(40);
+    for (const uint32_t colour : palette) {
+        Append(dib, colour);
+    }
+    dib.insert(dib.end(), xorRows.begin(), xorRows.end());
+    dib.insert(dib.end(), andRows.begin(), andRows.end());
+    return dib;
+}
+
+std::vector<uint8_t> IconImage(uint32_t iconSet, uint16_t bitCount = 32, uint32_t exports = 0) {
+    SyntheticPe::Options options;
+    options.iconSet = iconSet;
+    options.iconBitCount = bitCount;
+    options.exportCount = exports;
+    options.sectionCount = exports ? 3 : 1;
+    return SyntheticPe::Build(options);
+}
+
+} // namespace
+
+TEST_CASE(PeIconDecodeIndexedWithMask) {
+    // 2x2 at 1 bit per pixel: blue and red. Top row red, blue; bottom row blue, red. The top-left pixel
+    // is masked out.
+    const std::vector<uint8_t> xorRows = { 0x40, 0, 0, 0, 0x80, 0, 0, 0 };
+    const std::vector<uint8_t> andRows = { 0x00, 0, 0, 0, 0x80, 0, 0, 0 };
+    const auto dib = MakeDib(2, 2, 1, { 0x000000FF, 0x00FF0000 }, xorRows, andRows);
+    PeIcon::Image image;
+    CHECK(PeIcon::Decode(dib.data(), dib.size(), image));
+    CHECK(image.width == 2 && image.height == 2);
+    CHECK(image.pixels == (std::vector<uint32_t>{ 0, 0xFF0000FF, 0xFF0000FF, 0xFFFF0000 }));
+}
+
+TEST_CASE(PeIconDecodeTrueColour) {
+    // 24 bits per pixel: BGR triplets; 2x1 with a padded row and no mask bits.
+    const auto rgb = MakeDib(2, 1, 24, {}, { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0, 0 }, { 0, 0, 0, 0 });
+    PeIcon::Image image;
+    CHECK(PeIcon::Decode(rgb.data(), rgb.size(), image));
+    CHECK(image.pixels == (std::vector<uint32_t>{ 0xFF332211, 0xFF665544 }));
+
+    // 32 bits with an alpha channel: the mask is ignored, even where set.
+    std::vector<uint8_t> pixels;
+    Append(pixels, uint32_t{ 0x80FF0000 });
+    Append(pixels, uint32_t{ 0x00000000 });
+    const auto alpha = MakeDib(2, 1, 32, {}, pixels, { 0xC0, 0, 0, 0 });
+    CHECK(PeIcon::Decode(alpha.data(), alpha.size(), image));
+    CHECK(image.pixels == (std::vector<uint32_t>{ 0x80FF0000, 0 }));
+
+    // 32 bits with no alpha anywhere: the mask supplies it.
+    pixels.clear();
+    Append(pixels, uint32_t{ 0x00123456 });
+    Append(pixels, uint32_t{ 0x00ABCDEF });
+    const auto noAlpha = MakeDib(2, 1, 32, {}, pixels, { 0x40, 0, 0, 0 });
+    CHECK(PeIcon::Decode(noAlpha.data(), noAlpha.size(), image));
+    CHECK(image.pixels == (std::vector<uint32_t>{ 0xFF123456, 0 }));
+}
+
+TEST_CASE(PeIconDecodeRejects) {
+    PeIcon::Image image;
+    const uint8_t png[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0, 0, 0, 13 };
+    CHECK(!PeIcon::Decode(png, sizeof(png), image));
+
+    const auto valid = MakeDib(2, 2, 24, {}, std::vector<uint8_t>(16), std::vector<uint8_t>(8));
+    CHECK(PeIcon::Decode(valid.data(), valid.size(), image));
+    // Cut inside the XOR bitmap.
+    CHECK(!PeIcon::Decode(valid.data(), 48, image));
+    CHECK(!PeIcon::Decode(valid.data(), 20, image));
+
+    auto bad = valid;
+    bad[14] = 16; // 16 bits per pixel
+    CHECK(!PeIcon::Decode(bad.data(), bad.size(), image));
+    bad = valid;
+    bad[16] = 3; // BI_BITFIELDS
+    CHECK(!PeIcon::Decode(bad.data(), bad.size(), image));
+    bad = valid;
+    std::memset(bad.data() + 4, 0xFF, 4); // Negative width
+    CHECK(!PeIcon::Decode(bad.data(), bad.size(), image));
+}
+
+TEST_CASE(PeIconSyntheticDepths) {
+    for (const uint16_t bitCount : { uint16_t{ 1 }, uint16_t{ 4 }, uint16_t{ 8 }, uint16_t{ 24 }, uint16_t{ 32 } }) {
+        const auto file = IconImage(7, bitCount);
+        const PeImage::View view(file.data(), file.size());
+        PeIcon::Group group;
+        CHECK(PeIcon::ReadGroup(view, group));
+        CHECK(group.entries.size() == 3);
+        for (const uint32_t size : { 16u, 32u, 48u }) {
+            PeIcon::Image image;
+            CHECK(PeIcon::Load(view, group, size, image));
+            CHECK(image.width == size && image.height == size);
+            CHECK(image.pixels.size() == size_t{ size } * size);
+            // The generator clears the top-left corner and nothing near the bottom-right.
+            CHECK(image.pixels.front() == 0);
+            CHECK(image.pixels.back() >> 24 == 0xFF);
+        }
+    }
+
+    // The generator draws the same colours at 24 and 32 bits, so the decodes must agree pixel for pixel.
+    const auto rgb = IconImage(7, 24);
+    const auto argb = IconImage(7, 32);
+    PeIcon::Group rgbGroup;
+    PeIcon::Group argbGroup;
+    const PeImage::View rgbView(rgb.data(), rgb.size());
+    const PeImage::View argbView(argb.data(), argb.size());
+    CHECK(PeIcon::ReadGroup(rgbView, rgbGroup) && PeIcon::ReadGroup(argbView, argbGroup));
+    PeIcon::Image fromRgb;
+    PeIcon::Image fromArgb;
+    CHECK(PeIcon::Load(rgbView, rgbGroup, 32, fromRgb) && PeIcon::Load(argbView, argbGroup, 32, fromArgb));
+    CHECK(fromRgb.pixels == fromArgb.pixels);
+}
+
+TEST_CASE(PeIconPreference) {
+    PeIcon::Group group;
+    group.entries = {
+        { 16, 16, 32, 0, 1 }, // 0
+        { 32, 32, 8, 0, 2 },  // 1
+        { 48, 48, 32, 0, 3 }, // 2
+        { 32, 32, 32, 0, 4 }, // 3
+        { 24, 24, 32, 0, 5 }, // 4
+        { 64, 64, 32, 0, 6 }, // 5
+    };
+    CHECK(PeIcon::Preference(group, 32) == (std::vector<size_t>{ 3, 1, 2, 5, 4, 0 }));
+    CHECK(PeIcon::Preference(group, 20) == (std::vector<size_t>{ 4, 3, 1, 2, 5, 0 }));
+    CHECK(PeIcon::Preference(group, 100) == (std::vector<size_t>{ 5, 2, 3, 1, 4, 0 }));
+}
+
+TEST_CASE(PeIconDeduplicatedByContent) {
+    // Same icon set in otherwise different images; a different set; no icon at all.
+    const auto first = IconImage(3);
+    const auto second = IconImage(3, 32, 40);
+    const auto other = IconImage(4);
+    const auto none = IconImage(0);
+    CHECK(first != second);
+    const PeImage::View firstView(first.data(), first.size());
+    const PeImage::View secondView(second.data(), second.size());
+    const PeImage::View otherView(other.data(), other.size());
+    const PeImage::View noneView(none.data(), none.size());
+
+    PeIcon::Group a;
+    PeIcon::Group b;
+    PeIcon::Group c;
+    CHECK(PeIcon::ReadGroup(firstView, a) && PeIcon::ReadGroup(secondView, b) && PeIcon::ReadGroup(otherView, c));
+    CHECK(a.digest == b.digest);
+    CHECK(a.digest != c.digest);
+    PeIcon::Group empty;
+    CHECK(!PeIcon::ReadGroup(noneView, empty));
+
+    PeIcon::Cache cache;
+    const auto icon = PeIcon::Get(firstView, 32, cache);
+    CHECK(icon != nullptr);
+    // The second image's icon is the first one's, decoded once.
+    CHECK(PeIcon::Get(secondView, 32, cache) == icon);
+    auto stats = cache.GetStats();
+    CHECK(stats.hits == 1 && stats.images == 1);
+    CHECK(stats.bytes >= size_t{ 32 } * 32 * 4);
+
+    // Another size, or another icon, is a separate entry.
+    CHECK(PeIcon::Get(secondView, 16, cache) != icon);
+    CHECK(PeIcon::Get(otherView, 32, cache) != icon);
+    CHECK(PeIcon::Get(noneView, 32, cache) == nullptr);
+    stats = cache.GetStats();
+    CHECK(stats.images == 3);
+
+    // Trimming drops cached pixels, but an icon already handed out stays valid.
+    cache.TrimTo(0);
+    CHECK(cache.GetStats().images == 0);
+    CHECK(icon->width == 32 && icon->pixels.size() == size_t{ 32 } * 32);
+    CHECK(PeIcon::Get(firstView, 32, cache) != icon);
+}
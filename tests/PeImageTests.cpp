@@ -0,0 +1,54 @@
+#include "PeImage.h"
+#include "SyntheticPe.h"
+#include "Test.h"
+
+#include <vector>
+
+// Version resources and machine types of synthetic images, whose contents are fixed by the generator's
+// options rather than read back from the parser under test, and every generator defect parsed without
+// leaving the buffer.
+
+TEST_CASE(PeImageVersionInfo) {
+    SyntheticPe::Options options;
+    options.version = { L"Fabrikam", L"Test module", L"1.2.3.4", 0x0001000200030004 };
+    const auto image = SyntheticPe::Build(options);
+    const auto info = PeImage::ParseImageInfo(image.data(), image.size());
+    CHECK(info.companyName == L"Fabrikam");
+    CHECK(info.description == L"Test module");
+    CHECK(info.fileVersion == L"1.2.3.4");
+    CHECK(info.fileVersionNumber == 0x0001000200030004);
+    CHECK(PeImage::VersionPart(info.fileVersionNumber, 0) == 1 && PeImage::VersionPart(info.fileVersionNumber, 3) == 4);
+    CHECK(info.machine == PeImage::kMachineAmd64);
+    CHECK(info.machineType == L"x64");
+
+    options.versionResource = false;
+    const auto bare = SyntheticPe::Build(options);
+    const auto none = PeImage::ParseImageInfo(bare.data(), bare.size());
+    CHECK(none.companyName.empty() && none.fileVersion.empty() && none.fileVersionNumber == 0);
+    CHECK(none.machineType == L"x64");
+}
+
+TEST_CASE(PeImageMachineNames) {
+    CHECK(PeImage::MachineName(PeImage::kMachineI386) == L"x86");
+    CHECK(PeImage::MachineName(PeImage::kMachineAmd64) == L"x64");
+    CHECK(PeImage::MachineName(0x1234) == L"0x1234");
+
+    const std::vector<uint8_t> notPe(512, 0x4D);
+    const auto info = PeImage::ParseImageInfo(notPe.data(), notPe.size());
+    CHECK(info.machine == 0 && info.machineType == L"Unknown");
+}
+
+TEST_CASE(PeImageDefectsStayBounded) {
+    for (const auto defect : SyntheticPe::kAllDefects) {
+        SyntheticPe::Options options;
+        options.sectionCount = 4;
+        options.exportCount = 10;
+        options.importModuleCount = 2;
+        options.importsPerModule = 3;
+        options.defect = defect;
+        const auto image = SyntheticPe::Build(options);
+        const auto info = PeImage::ParseImageInfo(image.data(), image.size());
+        // The strings may or may not survive a defect; the parse must simply stay inside the buffer.
+        CHECK(info.companyName.size() <= image.size());
+    }
+}
@@ -0,0 +1,75 @@
+#include "PeImage.h"
+#include "PeReloc.h"
+#include "SyntheticPe.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <vector>
+
+// Fixup and page counts from a synthetic image with a known number of relocations, and from a hand-built
+// directory whose blocks, HIGHADJ operands, padding and page-straddling fixups are counted by hand.
+
+namespace {
+
+SyntheticPe::Options Relocated() {
+    SyntheticPe::Options options;
+    options.machine = PeImage::kMachineI386;
+    options.sectionCount = 4;
+    options.codeSize = 3 * PeReloc::kPageSize + 100;
+    options.relocationCount = 30;
+    return options;
+}
+
+} // namespace
+
+TEST_CASE(PeRelocKnownImage) {
+    const auto image = SyntheticPe::Build(Relocated());
+    const PeImage::View view(image.data(), image.size());
+    CHECK(view.IsValid());
+    const auto summary = PeReloc::Decode(view);
+    CHECK(!summary.malformed);
+    CHECK(summary.fixups == 30);
+    CHECK(summary.blocks >= 1 && summary.pages >= summary.blocks);
+    CHECK(summary.pages <= view.SizeOfImage() / PeReloc::kPageSize);
+
+    const auto info = PeImage::ParseImageInfo(image.data(), image.size());
+    CHECK(info.relocations.fixups == summary.fixups && info.relocations.pages == summary.pages);
+    CHECK(PeReloc::Describe(summary, info.imageBase, info.imageBase, 0).empty());
+    CHECK(!PeReloc::Describe(summary, info.imageBase, info.imageBase + 0x10000, 0).empty());
+
+    SyntheticPe::Options plain;
+    const auto bare = SyntheticPe::Build(plain);
+    const auto nothing = PeReloc::Decode(PeImage::View(bare.data(), bare.size()));
+    CHECK(nothing.blocks == 0 && nothing.fixups == 0 && !nothing.malformed);
+}
+
+TEST_CASE(PeRelocPieces) {
+    // A hand-built directory: two blocks, the second with a HIGHADJ operand and ABSOLUTE padding.
+    const std::vector<uint8_t> directory = {
+        0x00, 0x10, 0x00, 0x00, 0x0C, 0x00, 0x00, 0x00, // Page 0x1000, 12 bytes
+        0x10, 0x30, 0xFE, 0x3F,                         // HIGHLOW at 0x010, HIGHLOW at 0xFFE (straddles)
+        0x00, 0x30, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, // Page 0x3000, 16 bytes
+        0x20, 0x40, 0x34, 0x12,                         // HIGHADJ at 0x020 and its operand
+        0x40, 0x30, 0x00, 0x00,                         // HIGHLOW at 0x040, ABSOLUTE padding
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // Terminator
+    };
+    for (const size_t piece : { size_t{ 1 }, size_t{ 2 }, size_t{ 3 }, size_t{ 5 }, size_t{ 8 }, directory.size() }) {
+        PeReloc::Decoder decoder(0x10000);
+        for (size_t offset = 0; offset < directory.size(); offset += piece) {
+            decoder.Update(directory.data() + offset, std::min(piece, directory.size() - offset));
+        }
+        const auto summary = decoder.Finish();
+        CHECK(summary.blocks == 2);
+        CHECK(summary.fixups == 4);
+        CHECK(summary.pages == 3); // 0x1000, 0x2000 by the straddling fixup, and 0x3000
+        CHECK(!summary.malformed);
+    }
+
+    PeReloc::Decoder outside(0x2000); // Page 0x3000 lies past the image
+    outside.Update(directory.data(), directory.size());
+    CHECK(outside.Finish().malformed);
+
+    PeReloc::Decoder truncated(0x10000);
+    truncated.Update(directory.data(), 10);
+    CHECK(truncated.Finish().malformed);
+}
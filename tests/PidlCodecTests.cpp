@@ -0,0 +1,117 @@
+#include "PidlCodec.h"
+#include "Test.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Item IDs come back from the shell and from persisted views, so the decoder must stay within cb
+// whatever it says: a short cb truncates the path or the header, never reads past the item.
+
+namespace {
+
+constexpr wchar_t kPath[] = L"C:\\Windows\\System32\\kernel32.dll";
+
+uint16_t Cb(const void* item) {
+    uint16_t cb = 0;
+    std::memcpy(&cb, item, sizeof(cb));
+    return cb;
+}
+
+// A copy of item with cb rewritten, in a buffer as long as the original so reads past cb would still
+// land in memory (and be caught by a sanitizer build only if they go further).
+std::vector<uint8_t> WithCb(const void* item, uint16_t cb) {
+    std::vector<uint8_t> bytes(static_cast<const uint8_t*>(item), static_cast<const uint8_t*>(item) + Cb(item) + 2);
+    std::memcpy(bytes.data(), &cb, sizeof(cb));
+    return bytes;
+}
+
+} // namespace
+
+TEST_CASE(PidlRoundTrip) {
+    void* item = PidlCodec::Create(PidlCodec::kModuleSignature, kPath, 0x7FFA12340000ull, 0x1A2000);
+    CHECK(item);
+    CHECK(Cb(item) == PidlCodec::kPathOffset + sizeof(kPath));
+    const auto* data = PidlCodec::GetData(item);
+    CHECK(data && data->signature == PidlCodec::kModuleSignature);
+    CHECK(data && data->baseAddress == 0x7FFA12340000ull && data->size == 0x1A2000);
+    CHECK(PidlCodec::GetPath(item) == kPath);
+    CHECK(PidlCodec::HasSignature(item, PidlCodec::kModuleSignature));
+    CHECK(!PidlCodec::HasSignature(item, PidlCodec::kDiagnosticsSignature));
+
+    void* clone = PidlCodec::Clone(item);
+    CHECK(clone && std::memcmp(clone, item, Cb(item) + 2) == 0);
+    CHECK(PidlCodec::GetPath(clone) == kPath);
+    PidlCodec::Free(clone);
+    PidlCodec::Free(item);
+}
+
+TEST_CASE(PidlEmptyPath) {
+    void* item = PidlCodec::Create(PidlCodec::kDiagnosticsSignature, L"", 0, 3);
+    CHECK(item && PidlCodec::GetPath(item).empty());
+    CHECK(item && PidlCodec::GetData(item)->size == 3);
+    PidlCodec::Free(item);
+}
+
+TEST_CASE(PidlTooLong) {
+    CHECK(PidlCodec::Create(PidlCodec::kModuleSignature, std::wstring(0x8000, L'x'), 0, 0) == nullptr);
+}
+
+TEST_CASE(PidlTruncatedCb) {
+    void* item = PidlCodec::Create(PidlCodec::kModuleSignature, kPath, 0x10000, 0x2000);
+    const std::wstring path = kPath;
+
+    // cb ending inside the path: the characters that fit, and half a character is dropped
+    for (size_t chars = 0; chars <= 4; ++chars) {
+        for (size_t extra = 0; extra < sizeof(wchar_t); ++extra) {
+            const auto cb = static_cast<uint16_t>(PidlCodec::kPathOffset + chars * sizeof(wchar_t) + extra);
+            const auto bytes = WithCb(item, cb);
+            CHECK(PidlCodec::GetData(bytes.data()) != nullptr);
+            CHECK(PidlCodec::GetPath(bytes.data()) == path.substr(0, chars));
+        }
+    }
+
+    // cb ending inside the header: no data, no path
+    const uint16_t shortCbs[] = { 0, 1, 2, 10, static_cast<uint16_t>(PidlCodec::kPathOffset - 1) };
+    for (const uint16_t cb : shortCbs) {
+        const auto bytes = WithCb(item, cb);
+        CHECK(PidlCodec::GetData(bytes.data()) == nullptr);
+        CHECK(PidlCodec::GetPath(bytes.data()).empty());
+        CHECK(!PidlCodec::HasSignature(bytes.data(), PidlCodec::kModuleSignature));
+    }
+
+    // Exactly the header: data but no path
+    const auto header = WithCb(item, static_cast<uint16_t>(PidlCodec::kPathOffset));
+    CHECK(PidlCodec::GetData(header.data()) != nullptr);
+    CHECK(PidlCodec::GetPath(header.data()).empty());
+
+    // A cloned truncated item keeps only cb bytes and is terminated after them
+    const auto shortItem = WithCb(item, static_cast<uint16_t>(PidlCodec::kPathOffset + 3 * sizeof(wchar_t)));
+    void* clone = PidlCodec::Clone(shortItem.data());
+    CHECK(clone && Cb(clone) == PidlCodec::kPathOffset + 3 * sizeof(wchar_t));
+    CHECK(clone && PidlCodec::GetPath(clone) == path.substr(0, 3));
+    uint16_t terminator = 1;
+    if (clone) {
+        std::memcpy(&terminator, static_cast<const uint8_t*>(clone) + Cb(clone), sizeof(terminator));
+    }
+    CHECK(terminator == 0);
+    PidlCodec::Free(clone);
+
+    // A zero cb is the end of a list: nothing to clone
+    const auto empty = WithCb(item, 0);
+    CHECK(PidlCodec::Clone(empty.data()) == nullptr);
+    PidlCodec::Free(item);
+}
+
+TEST_CASE(PidlCompare) {
+    void* a = PidlCodec::Create(PidlCodec::kModuleSignature, L"C:\\b\\ALPHA.dll", 0x2000, 10);
+    void* b = PidlCodec::Create(PidlCodec::kModuleSignature, L"C:\\a\\beta.dll", 0x1000, 20);
+    CHECK(PidlCodec::Compare(a, b, PidlCodec::SortKey::Name) < 0);
+    CHECK(PidlCodec::Compare(a, b, PidlCodec::SortKey::Path) > 0);
+    CHECK(PidlCodec::Compare(a, b, PidlCodec::SortKey::BaseAddress) > 0);
+    CHECK(PidlCodec::Compare(a, b, PidlCodec::SortKey::Size) < 0);
+    CHECK(PidlCodec::Compare(a, a, PidlCodec::SortKey::Name) == 0);
+    CHECK(PidlCodec::FileName(L"C:\\b\\ALPHA.dll") == L"ALPHA.dll");
+    PidlCodec::Free(a);
+    PidlCodec::Free(b);
+}
@@ -0,0 +1,75 @@
+#include "Sha.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// The FIPS 180-2 examples (appendices A and B for SHA-1 and SHA-256): "abc", the 448-bit two-block
+// message and one million 'a', plus the empty message. Each runs through the portable compression and,
+// when the CPU has them, the SHA extensions, fed whole and in pieces that straddle block boundaries.
+
+namespace {
+
+struct Vector {
+    std::string message;
+    const char* sha1;
+    const char* sha256;
+};
+
+const std::vector<Vector>& Vectors() {
+    static const std::vector<Vector> vectors = {
+        { "", "da39a3ee5e6b4b0d3255bfef95601890afd80709",
+            "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abc", "a9993e364706816aba3e25717850c26c9cd0d89d",
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+        { std::string(1000000, 'a'), "34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+            "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" },
+    };
+    return vectors;
+}
+
+// 0 for the whole message at once; otherwise the piece size.
+constexpr size_t kPieces[] = { 0, 1, 63, 65, 1000 };
+
+template <class Hash>
+std::string Digest(const std::string& message, size_t piece, bool extensions) {
+    Hash hash(extensions);
+    if (piece == 0) {
+        hash.Update(message.data(), message.size());
+    } else {
+        for (size_t offset = 0; offset < message.size(); offset += piece) {
+            hash.Update(message.data() + offset, std::min(piece, message.size() - offset));
+        }
+    }
+    const auto digest = hash.Final();
+    return Test::Hex(digest.data(), digest.size());
+}
+
+template <class Hash>
+void CheckVectors(const char* Vector::*expected) {
+    for (const bool extensions : { false, Simd::ShaExtensions() }) {
+        for (const auto& vector : Vectors()) {
+            for (const size_t piece : kPieces) {
+                CHECK(Digest<Hash>(vector.message, piece, extensions) == vector.*expected);
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE(Sha1FipsVectors) {
+    CheckVectors<Sha::Sha1>(&Vector::sha1);
+}
+
+TEST_CASE(Sha256FipsVectors) {
+    CheckVectors<Sha::Sha256>(&Vector::sha256);
+}
+
+TEST_CASE(ShaToHex) {
+    const uint8_t digest[] = { 0x00, 0x0F, 0xA5, 0xFF };
+    CHECK(Sha::ToHex(digest, sizeof(digest)) == L"000fa5ff");
+}
@@ -0,0 +1,145 @@
+#include "SignatureScan.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// The matcher against a byte-by-byte reference: planted and random hits must come out the same at
+// every SIMD level, for pattern counts on both sides of each prefilter (one needle, three, four or more).
+
+namespace {
+
+uint32_t g_seed = 12345;
+
+uint32_t Next() {
+    g_seed = g_seed * 1664525 + 1013904223;
+    return g_seed >> 8;
+}
+
+std::vector<Simd::Level> Levels() {
+    std::vector<Simd::Level> levels;
+    for (const auto level : { Simd::Level::Scalar, Simd::Level::Sse2, Simd::Level::Avx2 }) {
+        if (level <= Simd::Detect()) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+std::vector<SignatureScan::Pattern> MakePatterns(size_t count) {
+    static const wchar_t kHex[] = L"0123456789ABCDEF";
+    std::vector<SignatureScan::Pattern> patterns;
+    while (patterns.size() < count) {
+        std::wstring text;
+        const size_t length = 3 + Next() % 10;
+        for (size_t i = 0; i < length; ++i) {
+            if (i > 0 && i + 1 < length && Next() % 5 == 0) {
+                text += L"?? ";
+            } else {
+                const uint32_t value = Next() & 0xFF;
+                text += kHex[value >> 4];
+                text += kHex[value & 15];
+                text += L' ';
+            }
+        }
+        SignatureScan::Pattern pattern;
+        std::wstring error;
+        CHECK(SignatureScan::Parse(text, pattern, error));
+        patterns.push_back(std::move(pattern));
+    }
+    return patterns;
+}
+
+std::vector<SignatureScan::Match> Reference(const std::vector<SignatureScan::Pattern>& patterns,
+    const std::vector<uint8_t>& data) {
+    std::vector<SignatureScan::Match> matches;
+    for (size_t offset = 0; offset < data.size(); ++offset) {
+        for (uint32_t p = 0; p < patterns.size(); ++p) {
+            const auto& pattern = patterns[p];
+            if (offset + pattern.bytes.size() > data.size()) {
+                continue;
+            }
+            bool equal = true;
+            for (size_t i = 0; i < pattern.bytes.size() && equal; ++i) {
+                equal = (data[offset + i] & pattern.mask[i]) == (pattern.bytes[i] & pattern.mask[i]);
+            }
+            if (equal) {
+                matches.push_back({ offset, p });
+            }
+        }
+    }
+    return matches;
+}
+
+void Sort(std::vector<SignatureScan::Match>& matches) {
+    std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b) {
+        return a.offset != b.offset ? a.offset < b.offset : a.pattern < b.pattern;
+    });
+}
+
+} // namespace
+
+TEST_CASE(SignatureParse) {
+    SignatureScan::Pattern pattern;
+    std::wstring error;
+    CHECK(SignatureScan::Parse(L"48 8B ?? 05", pattern, error));
+    CHECK(pattern.bytes.size() == 4 && pattern.bytes[0] == 0x48 && pattern.bytes[3] == 0x05);
+    CHECK(pattern.mask[2] == 0 && pattern.mask[3] == 0xFF);
+    CHECK(SignatureScan::Parse(L"\"MZ\"", pattern, error));
+    CHECK(pattern.bytes == (std::vector<uint8_t>{ 'M', 'Z' }));
+    CHECK(SignatureScan::Parse(L"w\"ab\"", pattern, error));
+    CHECK(pattern.bytes == (std::vector<uint8_t>{ 'a', 0, 'b', 0 }));
+    CHECK(!SignatureScan::Parse(L"?? ??", pattern, error) && !error.empty());
+    CHECK(!SignatureScan::Parse(L"4G", pattern, error));
+    CHECK(!SignatureScan::Parse(L"", pattern, error));
+}
+
+TEST_CASE(SignatureMatchesReference) {
+    for (const size_t count : { 1, 3, 4, 64 }) {
+        const auto patterns = MakePatterns(count);
+        std::vector<uint8_t> data(1 << 16);
+        for (auto& byte : data) {
+            byte = static_cast<uint8_t>(Next());
+        }
+        // Plant every pattern a few times, one of them at the very end
+        for (const auto& pattern : patterns) {
+            for (int copy = 0; copy < 3; ++copy) {
+                const size_t offset = copy == 2 ? data.size() - pattern.bytes.size()
+                                                : Next() % (data.size() - pattern.bytes.size());
+                for (size_t i = 0; i < pattern.bytes.size(); ++i) {
+                    if (pattern.mask[i]) {
+                        data[offset + i] = pattern.bytes[i];
+                    }
+                }
+            }
+        }
+        auto expected = Reference(patterns, data);
+        Sort(expected);
+        CHECK(expected.size() >= count);
+
+        const SignatureScan::Matcher matcher(patterns);
+        for (const auto level : Levels()) {
+            std::vector<SignatureScan::Match> matches;
+            matcher.Scan(data.data(), data.size(), data.size(), matches, level);
+            Sort(matches);
+            const bool equal = matches.size() == expected.size() &&
+                std::equal(matches.begin(), matches.end(), expected.begin(),
+                    [](const auto& a, const auto& b) { return a.offset == b.offset && a.pattern == b.pattern; });
+            CHECK(equal);
+
+            // Two chunks with the documented overlap report the same hits
+            const size_t split = data.size() / 2;
+            std::vector<SignatureScan::Match> chunked;
+            matcher.Scan(data.data(), std::min(data.size(), split + matcher.MaxPatternBytes() - 1), split, chunked, level);
+            std::vector<SignatureScan::Match> second;
+            matcher.Scan(data.data() + split, data.size() - split, data.size() - split, second, level);
+            for (auto match : second) {
+                match.offset += split;
+                chunked.push_back(match);
+            }
+            Sort(chunked);
+            CHECK(chunked.size() == expected.size());
+        }
+    }
+}
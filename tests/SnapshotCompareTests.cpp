@@ -0,0 +1,165 @@
+#include "Platform.h"
+#include "SnapshotCompare.h"
+#include "SnapshotFormat.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Interning across case and threads, the added/removed/changed split of a pairwise diff, rows read back
+// from a snapshot file (a path listed twice keeps its last row), and fleet prevalence merged from
+// per-thread counts.
+
+namespace {
+
+using SnapshotCompare::Entry;
+using SnapshotCompare::PathId;
+
+std::u16string Path(const char* text) {
+    return std::u16string(text, text + std::char_traits<char>::length(text));
+}
+
+std::vector<PathId> PathsOf(const std::vector<Entry>& entries) {
+    std::vector<PathId> paths;
+    for (const auto& entry : entries) {
+        paths.push_back(entry.path);
+    }
+    return paths;
+}
+
+} // namespace
+
+TEST_CASE(SnapshotCompareInterning) {
+    SnapshotCompare::PathInterner interner;
+    const PathId system = interner.Intern(Path("C:\\Windows\\System32\\ntdll.dll"));
+    CHECK(system != SnapshotCompare::kNoPath);
+    CHECK(interner.Intern(Path("c:\\windows\\SYSTEM32\\NTDLL.DLL")) == system);
+    CHECK(interner.Path(system) == Path("c:\\windows\\system32\\ntdll.dll"));
+    const PathId other = interner.Intern(Path("C:\\Windows\\SysWOW64\\ntdll.dll"));
+    CHECK(other != system);
+    CHECK(interner.Size() == 2);
+
+    // Four threads interning overlapping halves of 2,000 paths agree on every id.
+    SnapshotCompare::PathInterner shared;
+    constexpr int kPaths = 2000;
+    std::vector<std::vector<PathId>> ids(4, std::vector<PathId>(kPaths, SnapshotCompare::kNoPath));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared, &ids, t] {
+            for (int i = (t % 2) * kPaths / 4; i < kPaths; ++i) {
+                const std::string text = (t < 2 ? "C:\\Mod\\" : "c:\\mod\\") + std::to_string(i) + ".dll";
+                ids[t][i] = shared.Intern(Path(text.c_str()));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(shared.Size() == kPaths);
+    size_t disagreements = 0;
+    for (int i = kPaths / 4; i < kPaths; ++i) {
+        disagreements += !(ids[0][i] == ids[1][i] && ids[1][i] == ids[2][i] && ids[2][i] == ids[3][i]);
+    }
+    CHECK(disagreements == 0);
+    CHECK(shared.Path(ids[0][7]) == Path("c:\\mod\\7.dll"));
+}
+
+TEST_CASE(SnapshotCompareDiff) {
+    SnapshotCompare::PathInterner interner;
+    const PathId a = interner.Intern(Path("a.dll"));
+    const PathId b = interner.Intern(Path("b.dll"));
+    const PathId c = interner.Intern(Path("c.dll"));
+    const PathId d = interner.Intern(Path("d.dll"));
+    const PathId e = interner.Intern(Path("e.dll"));
+    const PathId f = interner.Intern(Path("f.dll"));
+
+    const std::vector<Entry> before = {
+        { a, 0x10000, 0x1000, 1 },
+        { b, 0x20000, 0x1000, 1 },
+        { c, 0x30000, 0x1000, 1 },
+        { e, 0x40000, 0x1000, 1 },
+        { f, 0x50000, 0x1000, 1 },
+    };
+    const std::vector<Entry> after = {
+        { f, 0x50000, 0x2000, 1 }, // Size
+        { c, 0x38000, 0x1000, 1 }, // Base address
+        { d, 0x60000, 0x1000, 1 }, // New
+        { a, 0x10000, 0x1000, 2 }, // Version
+        { b, 0x20000, 0x1000, 1 }, // Same
+    };
+    const auto diff = SnapshotCompare::Compare(before, after);
+    CHECK(PathsOf(diff.added) == std::vector<PathId>{ d });
+    CHECK(PathsOf(diff.removed) == std::vector<PathId>{ e });
+    CHECK(diff.changed.size() == 3);
+    if (diff.changed.size() == 3) {
+        // In after's order.
+        CHECK(diff.changed[0].after.path == f && diff.changed[0].before.size == 0x1000 && diff.changed[0].after.size == 0x2000);
+        CHECK(diff.changed[1].after.path == c && diff.changed[1].after.baseAddress == 0x38000);
+        CHECK(diff.changed[2].before.path == a && diff.changed[2].before.fileVersion == 1 &&
+            diff.changed[2].after.fileVersion == 2);
+    }
+
+    // Each side against nothing.
+    const auto gone = SnapshotCompare::Compare(before, {});
+    CHECK(PathsOf(gone.removed) == PathsOf(before));
+    CHECK(gone.added.empty() && gone.changed.empty());
+    const auto fresh = SnapshotCompare::Compare({}, after);
+    CHECK(PathsOf(fresh.added) == PathsOf(after));
+    CHECK(SnapshotCompare::Compare(after, after).changed.empty());
+}
+
+TEST_CASE(SnapshotCompareLoadEntries) {
+    const auto path = std::filesystem::temp_directory_path() / "explorer_modules_compare_test.emsnap";
+    {
+        SnapshotFormat::Writer writer(path, 3, 0, 1);
+        CHECK(writer.IsOpen());
+        CHECK(writer.Append({ L"C:\\Windows\\System32\\kernel32.dll", 0x7FF810000000, 0x1000, 10, L"", L"", L"", 0x8664 }));
+        CHECK(writer.Append({ L"C:\\Windows\\System32\\user32.dll", 0x7FF820000000, 0x2000, 11, L"", L"", L"", 0x8664 }));
+        // The same file under another case: one entry, with this row's values.
+        CHECK(writer.Append({ L"C:\\WINDOWS\\System32\\KERNEL32.dll", 0x7FF830000000, 0x3000, 12, L"", L"", L"", 0x8664 }));
+        CHECK(writer.Finish());
+    }
+    {
+        const auto file = Platform::MappedFile::Open(path);
+        CHECK(file);
+        if (file) {
+            const SnapshotFormat::Reader reader(file->Data(), file->Size());
+            CHECK(reader.IsValid());
+            SnapshotCompare::PathInterner interner;
+            const auto entries = SnapshotCompare::LoadEntries(reader, interner);
+            CHECK(entries.size() == 2);
+            if (entries.size() == 2) {
+                CHECK(interner.Path(entries[0].path) == Path("c:\\windows\\system32\\kernel32.dll"));
+                CHECK(entries[0].baseAddress == 0x7FF830000000 && entries[0].size == 0x3000 && entries[0].fileVersion == 12);
+                CHECK(interner.Path(entries[1].path) == Path("c:\\windows\\system32\\user32.dll"));
+                CHECK(entries[1].size == 0x2000 && entries[1].fileVersion == 11);
+            }
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(SnapshotComparePrevalence) {
+    SnapshotCompare::PathInterner interner;
+    // Interned out of name order, so Sorted cannot lean on the ids.
+    const PathId z = interner.Intern(Path("z.dll"));
+    const PathId m = interner.Intern(Path("m.dll"));
+    const PathId a = interner.Intern(Path("a.dll"));
+    const PathId q = interner.Intern(Path("q.dll"));
+
+    // Two loader threads' worth: z is everywhere, m and a in two snapshots, q in one.
+    SnapshotCompare::Prevalence first;
+    first.Add({ { z, 0, 0, 0 }, { m, 0, 0, 0 } });
+    first.Add({ { z, 0, 0, 0 }, { a, 0, 0, 0 } });
+    SnapshotCompare::Prevalence second;
+    second.Add({ { z, 0, 0, 0 }, { m, 0, 0, 0 }, { a, 0, 0, 0 }, { q, 0, 0, 0 } });
+    first.Merge(second);
+
+    CHECK(first.Snapshots() == 3);
+    const auto sorted = first.Sorted(interner);
+    const std::vector<std::pair<PathId, uint64_t>> expected = { { z, 3 }, { a, 2 }, { m, 2 }, { q, 1 } };
+    CHECK(sorted == expected);
+}
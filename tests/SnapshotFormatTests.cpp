@@ -0,0 +1,163 @@
+#include "Platform.h"
+#include "SnapshotFormat.h"
+#include "Test.h"
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Rows written with SnapshotFormat::Writer come back unchanged through a Reader over the mapped file:
+// enough rows to flush every column more than once, repeated strings that share one table entry, empty
+// and non-ASCII strings. A damaged header is rejected rather than read.
+
+namespace {
+
+constexpr uint64_t kRows = 5000;
+constexpr uint64_t kCapturedAt = 1700000000123;
+constexpr uint32_t kProcessId = 4242;
+
+struct Values {
+    std::wstring path;
+    std::wstring fileVersionText;
+    std::wstring company;
+    std::wstring description;
+};
+
+Values ValuesFor(uint64_t row) {
+    Values values;
+    values.path = L"C:\\Program Files\\Contoso\\module" + std::to_wstring(row) + L"\x00E9.dll";
+    values.fileVersionText = L"10.0." + std::to_wstring(row % 7);
+    values.company = row % 3 == 0 ? L"" : (row % 3 == 1 ? L"Contoso Ltd." : L"Fabrikam \x00AE");
+    values.description = L"Module " + std::to_wstring(row);
+    return values;
+}
+
+SnapshotFormat::Row RowFor(uint64_t row, const Values& values) {
+    return { values.path, 0x7FF800000000ull + row * 0x200000, static_cast<uint32_t>(0x1000 + row),
+        0x000A000000000000ull | row, values.fileVersionText, values.company, values.description,
+        static_cast<uint16_t>(row % 2 ? 0x8664 : 0xAA64) };
+}
+
+bool Equal(std::u16string_view stored, const std::wstring& expected) {
+    if (stored.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < stored.size(); ++i) {
+        if (stored[i] != static_cast<char16_t>(expected[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::filesystem::path WriteSnapshot() {
+    const auto path = std::filesystem::temp_directory_path() / "explorer_modules_test.emsnap";
+    SnapshotFormat::Writer writer(path, kRows, kCapturedAt, kProcessId);
+    CHECK(writer.IsOpen());
+    for (uint64_t row = 0; row < kRows; ++row) {
+        const auto values = ValuesFor(row);
+        CHECK(writer.Append(RowFor(row, values)));
+    }
+    const auto extra = ValuesFor(kRows);
+    CHECK(!writer.Append(RowFor(kRows, extra))); // Past capacity
+    CHECK(writer.Finish());
+    CHECK(writer.RowCount() == kRows);
+    return path;
+}
+
+} // namespace
+
+TEST_CASE(SnapshotRoundTrip) {
+    const auto path = WriteSnapshot();
+    {
+        const auto file = Platform::MappedFile::Open(path);
+        CHECK(file);
+        if (!file) {
+            return;
+        }
+        const SnapshotFormat::Reader reader(file->Data(), file->Size());
+        CHECK(reader.IsValid());
+        CHECK(reader.RowCount() == kRows);
+        CHECK(reader.GetHeader().capturedAtUnixMs == kCapturedAt);
+        CHECK(reader.GetHeader().processId == kProcessId);
+        CHECK(reader.GetHeader().minorVersion == SnapshotFormat::kMinorVersion);
+
+        using SnapshotFormat::ColumnId;
+        const auto* paths = reader.StringColumn(ColumnId::Path);
+        const auto* bases = reader.U64Column(ColumnId::BaseAddress);
+        const auto* sizes = reader.U32Column(ColumnId::Size);
+        const auto* versions = reader.U64Column(ColumnId::FileVersion);
+        const auto* versionTexts = reader.StringColumn(ColumnId::FileVersionText);
+        const auto* companies = reader.StringColumn(ColumnId::Company);
+        const auto* descriptions = reader.StringColumn(ColumnId::Description);
+        const auto* machines = reader.U16Column(ColumnId::Machine);
+        CHECK(paths && bases && sizes && versions && versionTexts && companies && descriptions && machines);
+        CHECK(reader.U32Column(ColumnId::BaseAddress) == nullptr); // Wrong type
+        if (!(paths && bases && sizes && versions && versionTexts && companies && descriptions && machines)) {
+            return;
+        }
+
+        size_t mismatches = 0;
+        for (uint64_t row = 0; row < kRows; ++row) {
+            const auto values = ValuesFor(row);
+            const auto expected = RowFor(row, values);
+            const bool equal = Equal(reader.String(paths[row]), values.path) && bases[row] == expected.baseAddress &&
+                sizes[row] == expected.size && versions[row] == expected.fileVersion &&
+                Equal(reader.String(versionTexts[row]), values.fileVersionText) &&
+                Equal(reader.String(companies[row]), values.company) &&
+                Equal(reader.String(descriptions[row]), values.description) && machines[row] == expected.machine;
+            mismatches += equal ? 0 : 1;
+        }
+        CHECK(mismatches == 0);
+
+        // Repeated company names share one string
+        CHECK(companies[1].offset == companies[4].offset && companies[2].offset == companies[5].offset);
+        CHECK(companies[1].offset != companies[2].offset);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE(SnapshotRejectsDamage) {
+    const auto path = WriteSnapshot();
+    std::vector<uint64_t> aligned;
+    size_t size = 0;
+    {
+        const auto file = Platform::MappedFile::Open(path);
+        CHECK(file);
+        if (!file) {
+            return;
+        }
+        size = file->Size();
+        aligned.resize((size + 7) / 8);
+        std::memcpy(aligned.data(), file->Data(), size);
+    }
+    std::filesystem::remove(path);
+    auto* bytes = reinterpret_cast<uint8_t*>(aligned.data());
+
+    CHECK(SnapshotFormat::Reader(bytes, size).IsValid());
+    CHECK(!SnapshotFormat::Reader(bytes, sizeof(SnapshotFormat::Header) - 1).IsValid());
+
+    SnapshotFormat::Header header;
+    std::memcpy(&header, bytes, sizeof(header));
+    auto damaged = header;
+    damaged.majorVersion = SnapshotFormat::kMajorVersion + 1;
+    std::memcpy(bytes, &damaged, sizeof(damaged));
+    CHECK(!SnapshotFormat::Reader(bytes, size).IsValid());
+
+    damaged = header;
+    damaged.stringTableSize = size; // Runs past the end
+    std::memcpy(bytes, &damaged, sizeof(damaged));
+    CHECK(!SnapshotFormat::Reader(bytes, size).IsValid());
+
+    damaged = header;
+    damaged.rowCount = size; // More rows than any column holds
+    std::memcpy(bytes, &damaged, sizeof(damaged));
+    const SnapshotFormat::Reader reader(bytes, size);
+    CHECK(reader.U64Column(SnapshotFormat::ColumnId::BaseAddress) == nullptr);
+
+    damaged = header;
+    damaged.minorVersion = SnapshotFormat::kMinorVersion + 1; // Newer minor versions stay readable
+    std::memcpy(bytes, &damaged, sizeof(damaged));
+    CHECK(SnapshotFormat::Reader(bytes, size).IsValid());
+}
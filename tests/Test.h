@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Minimal known-answer test harness. TEST_CASE registers a function; CHECK records a failure with its
+// location and carries on, so one run reports every broken expectation. The executable exits nonzero
+// if any check failed.
+namespace Test {
+
+using Function = void (*)();
+
+struct Registrar {
+    Registrar(const char* name, Function function);
+};
+
+void Fail(const char* file, int line, const char* expression);
+
+/// @brief Lowercase hex of size bytes, for comparing digests with published vectors.
+std::string Hex(const uint8_t* data, size_t size);
+
+int RunAll(int argc, char** argv);
+
+} // namespace Test
+
+#define TEST_CASE(name)                                         \
+    static void name();                                         \
+    static const Test::Registrar name##Registrar(#name, name); \
+    static void name()
+
+#define CHECK(expression)                                  \
+    do {                                                   \
+        if (!(expression)) {                               \
+            Test::Fail(__FILE__, __LINE__, #expression);   \
+        }                                                  \
+    } while (0)
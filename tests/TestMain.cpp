@@ -0,0 +1,66 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace Test {
+namespace {
+
+struct Case {
+    const char* name;
+    Function function;
+};
+
+std::vector<Case>& Registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+size_t g_failures = 0;
+
+} // namespace
+
+Registrar::Registrar(const char* name, Function function) {
+    Registry().push_back({ name, function });
+}
+
+void Fail(const char* file, int line, const char* expression) {
+    std::printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+    ++g_failures;
+}
+
+std::string Hex(const uint8_t* data, size_t size) {
+    static constexpr char kDigits[] = "0123456789abcdef";
+    std::string text;
+    for (size_t i = 0; i < size; ++i) {
+        text.push_back(kDigits[data[i] >> 4]);
+        text.push_back(kDigits[data[i] & 15]);
+    }
+    return text;
+}
+
+int RunAll(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    size_t run = 0;
+    size_t failed = 0;
+    for (const auto& testCase : Registry()) {
+        if (filter && !std::strstr(testCase.name, filter)) {
+            continue;
+        }
+        const size_t before = g_failures;
+        testCase.function();
+        ++run;
+        const bool passed = g_failures == before;
+        failed += passed ? 0 : 1;
+        std::printf("%-48s %s\n", testCase.name, passed ? "ok" : "FAILED");
+    }
+    std::printf("%zu cases, %zu failed\n", run, failed);
+    return failed == 0 && run > 0 ? 0 : 1;
+}
+
+} // namespace Test
+
+int main(int argc, char** argv) {
+    return Test::RunAll(argc, argv);
+}
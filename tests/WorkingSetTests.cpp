@@ -0,0 +1,165 @@
+#include "Test.h"
+#include "WorkingSet.h"
+
+#include <cstdint>
+#include <vector>
+
+// Page aggregation against a fake residency query whose answer is a function of the page address, so the
+// expected counts can be worked out page by page. Covers unsorted, unaligned, empty and overlapping
+// images, the delta path of a repeated refresh and a failing query.
+
+namespace {
+
+constexpr uint64_t kPage = 4096;
+
+bool g_fail = false;
+uint64_t g_evicted = 0; // A page the query reports as not resident, whatever the rule says
+std::vector<uint64_t> g_queried;
+
+uint8_t Rule(uint64_t page) {
+    if (page == g_evicted) {
+        return 0;
+    }
+    switch (page / kPage % 3) {
+    case 0:
+        return 0;
+    case 1:
+        return WorkingSet::kResident | WorkingSet::kShared;
+    default:
+        return WorkingSet::kResident;
+    }
+}
+
+bool Query(const uint64_t* pages, size_t count, uint8_t* flags) {
+    if (g_fail) {
+        return false;
+    }
+    g_queried.assign(pages, pages + count);
+    for (size_t i = 0; i < count; ++i) {
+        flags[i] = Rule(pages[i]);
+    }
+    return true;
+}
+
+// The counts for the pages [first, last) by the rule.
+WorkingSet::Counts Expected(uint64_t first, uint64_t last) {
+    WorkingSet::Counts counts;
+    for (uint64_t page = first; page < last; page += kPage) {
+        const uint8_t flags = Rule(page);
+        ++counts.pages;
+        counts.resident += (flags & WorkingSet::kResident) != 0;
+        counts.shared += (flags & WorkingSet::kShared) != 0;
+    }
+    counts.privatePages = counts.resident - counts.shared;
+    return counts;
+}
+
+// Not in base order. The second image ends mid-page, the third has no pages, and the last overlaps
+// the first, which keeps the shared pages.
+std::vector<WorkingSet::Module> Modules() {
+    return {
+        { 0x7FF800000000, 0x20000 },
+        { 0x7FF700000000, 0x5800 },
+        { 0x7FF600000000, 0 },
+        { 0x7FF800010000, 0x18000 },
+    };
+}
+
+void Reset() {
+    g_fail = false;
+    g_evicted = 0;
+    g_queried.clear();
+}
+
+} // namespace
+
+TEST_CASE(WorkingSetPageAggregation) {
+    Reset();
+    WorkingSet::Tracker tracker(Query, kPage);
+    const auto modules = Modules();
+    CHECK(tracker.Refresh(modules));
+
+    // Every page once, ascending.
+    CHECK(g_queried.size() == 6 + 0x28000 / kPage);
+    for (size_t i = 1; i < g_queried.size(); ++i) {
+        CHECK(g_queried[i - 1] < g_queried[i]);
+    }
+
+    const auto* first = tracker.Find(0x7FF800000000);
+    const auto* unaligned = tracker.Find(0x7FF700000000);
+    const auto* overlapping = tracker.Find(0x7FF800010000);
+    CHECK(first && unaligned && overlapping);
+    CHECK(*first == Expected(0x7FF800000000, 0x7FF800020000));
+    CHECK(unaligned->pages == 6);
+    CHECK(*unaligned == Expected(0x7FF700000000, 0x7FF700006000));
+    CHECK(*overlapping == Expected(0x7FF800020000, 0x7FF800028000));
+    CHECK(tracker.Find(0x7FF600000000) == nullptr);
+    CHECK(tracker.Find(0x7FF800001000) == nullptr);
+    CHECK(tracker.Changed().size() == 3);
+
+    const auto stats = tracker.GetStats();
+    CHECK(stats.refreshes == 1);
+    CHECK(stats.rebuilds == 1);
+    CHECK(stats.pagesQueried == g_queried.size());
+    CHECK(tracker.Bytes() != 0);
+}
+
+TEST_CASE(WorkingSetFindAddress) {
+    Reset();
+    WorkingSet::Tracker tracker(Query, kPage);
+    CHECK(tracker.Refresh(Modules()));
+    CHECK(tracker.FindAddress(0x7FF700000000) == 1);
+    CHECK(tracker.FindAddress(0x7FF7000057FF) == 1);
+    CHECK(tracker.FindAddress(0x7FF700005800) == SIZE_MAX);
+    CHECK(tracker.FindAddress(0x7FF80000FFFF) == 0);
+    // The overlap belongs to the image that starts there.
+    CHECK(tracker.FindAddress(0x7FF800010000) == 3);
+    CHECK(tracker.FindAddress(0x7FF800027FFF) == 3);
+    CHECK(tracker.FindAddress(0x7FF800028000) == SIZE_MAX);
+    CHECK(tracker.FindAddress(0x7FF600000000) == SIZE_MAX);
+    CHECK(tracker.FindAddress(0) == SIZE_MAX);
+}
+
+TEST_CASE(WorkingSetDeltaRefresh) {
+    Reset();
+    WorkingSet::Tracker tracker(Query, kPage);
+    const auto modules = Modules();
+    CHECK(tracker.Refresh(modules));
+
+    // Same answers: nothing changed, and the page list is reused.
+    CHECK(tracker.Refresh(modules));
+    CHECK(tracker.Changed().empty());
+    CHECK(tracker.GetStats().rebuilds == 1);
+
+    // One resident page of the unaligned image leaves the working set.
+    g_evicted = 0x7FF700002000;
+    const auto before = *tracker.Find(0x7FF700000000);
+    CHECK(tracker.Refresh(modules));
+    CHECK(tracker.Changed() == std::vector<uint64_t>{ 0x7FF700000000 });
+    CHECK(tracker.Find(0x7FF700000000)->resident + 1 == before.resident);
+    CHECK(*tracker.Find(0x7FF700000000) == Expected(0x7FF700000000, 0x7FF700006000));
+
+    // A failed query keeps the last counts for the same modules, and drops them for new ones.
+    g_fail = true;
+    CHECK(!tracker.Refresh(modules));
+    CHECK(tracker.Find(0x7FF700000000) != nullptr);
+    CHECK(!tracker.Refresh({ { 0x7FF700000000, 0x1000 } }));
+    CHECK(tracker.Find(0x7FF700000000) == nullptr);
+
+    g_fail = false;
+    CHECK(tracker.Refresh(modules));
+    CHECK(tracker.Changed().size() == 3);
+    CHECK(tracker.GetStats().rebuilds == 2);
+}
+
+TEST_CASE(WorkingSetFormat) {
+    WorkingSet::Counts counts;
+    CHECK(WorkingSet::FormatResident(counts, kPage).empty());
+    CHECK(WorkingSet::FormatSharing(counts, kPage).empty());
+    counts.pages = 10;
+    counts.resident = 5;
+    counts.shared = 3;
+    counts.privatePages = 2;
+    CHECK(WorkingSet::FormatResident(counts, kPage) == L"20 KB (50%)");
+    CHECK(WorkingSet::FormatSharing(counts, kPage) == L"12 KB / 8 KB");
+}
@@ -0,0 +1,88 @@
+// Reads the diagnostics block published by the extension in another process and prints its counters.
+//
+//   DiagnosticsDump <pid> [interval-ms]
+//
+// With an interval the counters are re-read until interrupted, printing the delta since the last sample.
+
+#include "Diagnostics.h"
+#include "Platform.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string Narrow(const wchar_t* text) {
+    std::string result;
+    for (; *text; ++text) {
+        result += static_cast<char>(*text < 0x80 ? *text : '?');
+    }
+    return result;
+}
+
+uint64_t ReadCounter(const Diagnostics::SharedBlock* block, uint32_t index) {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t&>(block->counters[index])).load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <pid> [interval-ms]\n", argv[0]);
+        return 2;
+    }
+    const auto processId = static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10));
+    const long intervalMs = argc > 2 ? std::strtol(argv[2], nullptr, 10) : 0;
+
+    auto memory = Platform::SharedMemory::OpenReadOnly(Diagnostics::SharedBlockName(processId),
+        sizeof(Diagnostics::SharedBlock));
+    if (!memory) {
+        std::fprintf(stderr, "No diagnostics block for process %u (is a folder open?)\n", processId);
+        return 1;
+    }
+
+    const auto* block = static_cast<const Diagnostics::SharedBlock*>(memory->Data());
+    if (std::atomic_ref<uint32_t>(const_cast<uint32_t&>(block->magic)).load(std::memory_order_acquire) !=
+        Diagnostics::kMagic) {
+        std::fprintf(stderr, "Block for process %u is not initialized\n", processId);
+        return 1;
+    }
+    if (block->layoutVersion > Diagnostics::kLayoutVersion) {
+        std::fprintf(stderr, "Layout version %u is newer than this tool (%u); showing known counters only\n",
+            block->layoutVersion, Diagnostics::kLayoutVersion);
+    }
+
+    uint32_t count = block->counterCount;
+    if (count > static_cast<uint32_t>(Diagnostics::Counter::Count)) {
+        count = static_cast<uint32_t>(Diagnostics::Counter::Count);
+    }
+
+    std::vector<uint64_t> previous(count, 0);
+    for (bool first = true;; first = false) {
+        std::printf("process %u, layout v%u\n", block->processId, block->layoutVersion);
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint64_t value = ReadCounter(block, i);
+            const auto name = Narrow(Diagnostics::CounterName(static_cast<Diagnostics::Counter>(i)));
+            if (first) {
+                std::printf("  %-28s %14llu\n", name.c_str(), static_cast<unsigned long long>(value));
+            } else {
+                std::printf("  %-28s %14llu  (+%llu)\n",
+                    name.c_str(),
+                    static_cast<unsigned long long>(value),
+                    static_cast<unsigned long long>(value - previous[i]));
+            }
+            previous[i] = value;
+        }
+        if (intervalMs <= 0) {
+            break;
+        }
+        std::fflush(stdout);
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    return 0;
+}
@@ -0,0 +1,173 @@
+// Measures what the extension costs a process that loads it: the DLL's own load, and the extra time
+// every unrelated LoadLibrary/FreeLibrary pair takes while it is loaded, first with no folder open and
+// then with one open (so its loader notification is registered). Windows only.
+//
+//   ExtensionLoadCost [--dll <path>] [--probe <dll name>] [--rounds <n>]
+//
+// --dll defaults to ExplorerModulesNamespace.dll next to this executable; --probe is a system DLL the
+// process does not load otherwise (msimg32.dll by default). Each phase loads and frees the probe --rounds
+// times and reports the median and 90th percentile of a pair. The "no folder" phase should match the
+// baseline within noise; "folder open" shows what a session adds per load.
+
+#include <windows.h>
+#include <objbase.h>
+#include <shlobj.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cwchar>
+#include <string>
+#include <vector>
+
+namespace {
+
+// CLSID_ModuleFolder; ModuleFolder.h needs WRL, so it is repeated here.
+constexpr CLSID kModuleFolderClsid = { 0x6b4e2e3b, 0x3d6b, 0x4d4e, { 0x9a, 0x1c, 0x0f, 0x0c, 0x8d, 0x8e, 0x8f, 0x11 } };
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+    std::wstring dll;
+    std::wstring probe = L"msimg32.dll";
+    uint32_t rounds = 2000;
+};
+
+struct Percentiles {
+    double p50Us = 0;
+    double p90Us = 0;
+};
+
+Percentiles Summarize(std::vector<double>& samples) {
+    if (samples.empty()) {
+        return {};
+    }
+    std::sort(samples.begin(), samples.end());
+    return { samples[samples.size() / 2], samples[samples.size() * 9 / 10] };
+}
+
+double ElapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+bool MeasureProbe(const Config& config, Percentiles& result) {
+    std::vector<double> samples;
+    samples.reserve(config.rounds);
+    for (uint32_t i = 0; i < config.rounds; ++i) {
+        const auto start = Clock::now();
+        HMODULE probe = LoadLibraryW(config.probe.c_str());
+        if (!probe) {
+            std::fwprintf(stderr, L"Could not load %ls (%lu)\n", config.probe.c_str(), GetLastError());
+            return false;
+        }
+        FreeLibrary(probe);
+        samples.push_back(ElapsedUs(start));
+    }
+    result = Summarize(samples);
+    return true;
+}
+
+void Report(const wchar_t* phase, const Percentiles& percentiles, const Percentiles& baseline) {
+    std::wprintf(L"%-28ls p50 %8.2f us  p90 %8.2f us  (+%.2f us over baseline at p50)\n", phase,
+        percentiles.p50Us, percentiles.p90Us, percentiles.p50Us - baseline.p50Us);
+}
+
+std::wstring DefaultDllPath() {
+    wchar_t path[MAX_PATH] = {};
+    const DWORD length = GetModuleFileNameW(nullptr, path, ARRAYSIZE(path));
+    std::wstring dll(path, length);
+    const size_t slash = dll.find_last_of(L"\\/");
+    dll.resize(slash == std::wstring::npos ? 0 : slash + 1);
+    return dll + L"ExplorerModulesNamespace.dll";
+}
+
+bool ParseArgs(int argc, wchar_t** argv, Config& config) {
+    config.dll = DefaultDllPath();
+    for (int i = 1; i < argc; ++i) {
+        const std::wstring arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        if (arg == L"--dll") {
+            config.dll = argv[++i];
+        } else if (arg == L"--probe") {
+            config.probe = argv[++i];
+        } else if (arg == L"--rounds") {
+            config.rounds = static_cast<uint32_t>(std::wcstoul(argv[++i], nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+    return config.rounds != 0;
+}
+
+} // namespace
+
+int wmain(int argc, wchar_t** argv) {
+    Config config;
+    if (!ParseArgs(argc, argv, config)) {
+        std::fwprintf(stderr, L"usage: ExtensionLoadCost [--dll <path>] [--probe <dll name>] [--rounds <n>]\n");
+        return 2;
+    }
+    if (GetModuleHandleW(config.probe.c_str())) {
+        std::fwprintf(stderr, L"%ls is already loaded; pick another --probe\n", config.probe.c_str());
+        return 2;
+    }
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+
+    Percentiles baseline;
+    if (!MeasureProbe(config, baseline)) {
+        return 1;
+    }
+    Report(L"Baseline", baseline, baseline);
+
+    auto start = Clock::now();
+    HMODULE extension = LoadLibraryW(config.dll.c_str());
+    const double loadUs = ElapsedUs(start);
+    if (!extension) {
+        std::fwprintf(stderr, L"Could not load %ls (%lu)\n", config.dll.c_str(), GetLastError());
+        return 1;
+    }
+    std::wprintf(L"%-28ls %8.2f us\n", L"Extension LoadLibrary", loadUs);
+
+    Percentiles loaded;
+    if (!MeasureProbe(config, loaded)) {
+        return 1;
+    }
+    Report(L"Loaded, no folder", loaded, baseline);
+
+    using GetClassObjectFn = HRESULT(STDAPICALLTYPE*)(REFCLSID, REFIID, void**);
+    auto getClassObject = reinterpret_cast<GetClassObjectFn>(GetProcAddress(extension, "DllGetClassObject"));
+    IClassFactory* factory = nullptr;
+    IShellFolder* folder = nullptr;
+    start = Clock::now();
+    if (getClassObject && SUCCEEDED(getClassObject(kModuleFolderClsid, IID_PPV_ARGS(&factory)))) {
+        factory->CreateInstance(nullptr, IID_PPV_ARGS(&folder));
+        factory->Release();
+    }
+    if (!folder) {
+        std::fwprintf(stderr, L"Could not create a module folder\n");
+        return 1;
+    }
+    std::wprintf(L"%-28ls %8.2f us\n", L"First folder (session start)", ElapsedUs(start));
+
+    Percentiles open;
+    if (!MeasureProbe(config, open)) {
+        return 1;
+    }
+    Report(L"Folder open", open, baseline);
+
+    folder->Release();
+    Percentiles closed;
+    if (!MeasureProbe(config, closed)) {
+        return 1;
+    }
+    Report(L"Folder released", closed, baseline);
+
+    FreeLibrary(extension);
+    if (SUCCEEDED(hr)) {
+        CoUninitialize();
+    }
+    return 0;
+}
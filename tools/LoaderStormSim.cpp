@@ -0,0 +1,220 @@
+// Feeds synthetic loader notifications through RefreshPipeline at a configurable rate and burst shape,
+// with the shell notification replaced by a stub that burns a fixed amount of time and counts.
+//
+//   LoaderStormSim [--rate <events/s>] [--duration <ms>] [--shape steady|burst|ramp] [--burst <events>]
+//                  [--producers <threads>] [--notify-us <us>]
+//
+// steady spaces events evenly; burst sends them back to back in groups of --burst with the gaps chosen
+// to keep the average rate; ramp rises linearly from 0 to twice the rate. Each producer thread plays the
+// part of a thread calling LoadLibrary/FreeLibrary and alternates loaded and unloaded notifications.
+
+#include "FakeModules.h"
+#include "NtDll.h"
+#include "Perf.h"
+#include "RefreshPipeline.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum class Shape { Steady, Burst, Ramp };
+
+struct Config {
+    double rate = 10000;
+    uint32_t durationMs = 2000;
+    Shape shape = Shape::Steady;
+    uint32_t burst = 64;
+    uint32_t producers = 1;
+    uint32_t notifyUs = 150; // Roughly SHParseDisplayName + SHChangeNotify on an idle machine
+};
+
+std::atomic<uint64_t> g_notifications{ 0 };
+uint32_t g_notifyUs = 0;
+
+void StubNotify() {
+    const auto until = Perf::Clock::now() + std::chrono::microseconds(g_notifyUs);
+    while (Perf::Clock::now() < until) {
+    }
+    g_notifications.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Offset from the start of the run at which a producer's index-th event is due.
+std::chrono::nanoseconds DueAt(const Config& config, double producerRate, uint64_t index) {
+    const double period = 1e9 / producerRate;
+    double ns = 0;
+    switch (config.shape) {
+    case Shape::Steady:
+        ns = static_cast<double>(index) * period;
+        break;
+    case Shape::Burst:
+        ns = static_cast<double>(index / config.burst * config.burst) * period;
+        break;
+    case Shape::Ramp: {
+        // Rate r(t) = 2 * rate * t / T, so events(t) = rate * t^2 / T and t = sqrt(index * T / rate).
+        const double durationNs = config.durationMs * 1e6;
+        ns = std::sqrt(static_cast<double>(index) * durationNs * period);
+        break;
+    }
+    }
+    return std::chrono::nanoseconds(static_cast<int64_t>(ns));
+}
+
+struct ProducerResult {
+    uint64_t sent = 0;
+    int64_t maxLagNs = 0;
+};
+
+void Produce(const Config& config, RefreshPipeline& pipeline, uint32_t producer, Perf::Clock::time_point start,
+    ProducerResult& result) {
+    const double producerRate = config.rate / config.producers;
+    const auto end = start + std::chrono::milliseconds(config.durationMs);
+
+    // A small rotating set of module names, as a plugin host loading and unloading the same DLLs would.
+    constexpr size_t kNames = 64;
+    std::vector<std::wstring> fullNames;
+    std::vector<UNICODE_STRING> fullStrings(kNames);
+    std::vector<UNICODE_STRING> baseStrings(kNames);
+    fullNames.reserve(kNames);
+    for (size_t i = 0; i < kNames; ++i) {
+        ModuleRecord record = {};
+        FakeModules::Describe(static_cast<ModuleEnumerator::Handle>(producer * kNames + i + 1), record);
+        fullNames.push_back(record.path);
+    }
+    for (size_t i = 0; i < kNames; ++i) {
+        auto& name = fullNames[i];
+        const size_t baseOffset = name.find_last_of(L'\\') + 1;
+        fullStrings[i] = { static_cast<uint16_t>(name.size() * sizeof(wchar_t)),
+            static_cast<uint16_t>(name.size() * sizeof(wchar_t)), name.data() };
+        baseStrings[i] = { static_cast<uint16_t>((name.size() - baseOffset) * sizeof(wchar_t)),
+            static_cast<uint16_t>((name.size() - baseOffset) * sizeof(wchar_t)), name.data() + baseOffset };
+    }
+
+    for (uint64_t index = 0;; ++index) {
+        const auto due = start + DueAt(config, producerRate, index);
+        if (due >= end) {
+            break;
+        }
+        auto now = Perf::Clock::now();
+        if (due - now > std::chrono::microseconds(500)) {
+            std::this_thread::sleep_until(due - std::chrono::microseconds(200));
+        }
+        while ((now = Perf::Clock::now()) < due) {
+            std::this_thread::yield(); // Leave the CPU to refresh threads on small machines
+        }
+        const int64_t lag = std::chrono::duration_cast<std::chrono::nanoseconds>(now - due).count();
+        result.maxLagNs = lag > result.maxLagNs ? lag : result.maxLagNs;
+
+        const size_t slot = index % kNames;
+        LDR_DLL_NOTIFICATION_DATA data = {};
+        data.Loaded.FullDllName = &fullStrings[slot];
+        data.Loaded.BaseDllName = &baseStrings[slot];
+        data.Loaded.DllBase = reinterpret_cast<PVOID>(static_cast<uintptr_t>(FakeModules::BaseAddress(slot)));
+        data.Loaded.SizeOfImage = 0x20000;
+        const ULONG reason = (index & 1) == 0 ? LDR_DLL_NOTIFICATION_REASON_LOADED : LDR_DLL_NOTIFICATION_REASON_UNLOADED;
+        RefreshPipeline::DllNotificationCallback(reason, &data, &pipeline);
+        ++result.sent;
+    }
+}
+
+bool ParseArgs(int argc, char** argv, Config& config) {
+    for (int i = 1; i < argc; ++i) {
+        const char* name = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            return false;
+        }
+        ++i;
+        if (std::strcmp(name, "--rate") == 0) {
+            config.rate = std::strtod(value, nullptr);
+        } else if (std::strcmp(name, "--duration") == 0) {
+            config.durationMs = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(name, "--burst") == 0) {
+            config.burst = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(name, "--producers") == 0) {
+            config.producers = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(name, "--notify-us") == 0) {
+            config.notifyUs = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        } else if (std::strcmp(name, "--shape") == 0) {
+            if (std::strcmp(value, "steady") == 0) {
+                config.shape = Shape::Steady;
+            } else if (std::strcmp(value, "burst") == 0) {
+                config.shape = Shape::Burst;
+            } else if (std::strcmp(value, "ramp") == 0) {
+                config.shape = Shape::Ramp;
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return config.rate > 0 && config.durationMs > 0 && config.burst > 0 && config.producers > 0;
+}
+
+double Microseconds(uint64_t ns) {
+    return static_cast<double>(ns) / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Config config;
+    if (!ParseArgs(argc, argv, config)) {
+        std::fprintf(stderr,
+            "usage: %s [--rate <events/s>] [--duration <ms>] [--shape steady|burst|ramp] [--burst <events>]\n"
+            "          [--producers <threads>] [--notify-us <us>]\n",
+            argv[0]);
+        return 2;
+    }
+    g_notifyUs = config.notifyUs;
+
+    RefreshPipeline pipeline(StubNotify);
+    Perf::GetHistogram(Perf::Op::LoaderRefresh).Reset();
+
+    std::vector<ProducerResult> results(config.producers);
+    std::vector<std::thread> producers;
+    const auto start = Perf::Clock::now() + std::chrono::milliseconds(10);
+    for (uint32_t i = 0; i < config.producers; ++i) {
+        producers.emplace_back(Produce, std::cref(config), std::ref(pipeline), i, start, std::ref(results[i]));
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    const auto produced = Perf::Clock::now();
+    pipeline.Drain();
+    const auto drained = Perf::Clock::now();
+
+    uint64_t sent = 0;
+    int64_t maxLagNs = 0;
+    for (const auto& result : results) {
+        sent += result.sent;
+        maxLagNs = result.maxLagNs > maxLagNs ? result.maxLagNs : maxLagNs;
+    }
+    const auto stats = pipeline.GetStats();
+    const auto& latency = Perf::GetHistogram(Perf::Op::LoaderRefresh);
+    const double seconds = std::chrono::duration<double>(produced - start).count();
+
+    std::printf("events sent        %llu (%.0f/s achieved, producers up to %.1f us behind schedule)\n",
+        static_cast<unsigned long long>(sent), static_cast<double>(sent) / seconds, maxLagNs / 1000.0);
+    std::printf("events received    %llu\n", static_cast<unsigned long long>(stats.events));
+    std::printf("events coalesced   %llu (%.1f%%)\n", static_cast<unsigned long long>(stats.coalesced),
+        stats.events ? 100.0 * static_cast<double>(stats.coalesced) / static_cast<double>(stats.events) : 0.0);
+    std::printf("events dropped     %llu\n", static_cast<unsigned long long>(stats.uncovered + (sent - stats.events)));
+    std::printf("threads created    %llu\n", static_cast<unsigned long long>(stats.threadsStarted));
+    std::printf("refreshes emitted  %llu (stub saw %llu)\n", static_cast<unsigned long long>(stats.refreshes),
+        static_cast<unsigned long long>(g_notifications.load()));
+    std::printf("event-to-refresh   p50 %.1f us, p90 %.1f us, p99 %.1f us, max %.1f us\n",
+        Microseconds(latency.ValueAtPercentile(50)), Microseconds(latency.ValueAtPercentile(90)),
+        Microseconds(latency.ValueAtPercentile(99)), Microseconds(latency.Max()));
+    std::printf("drain              %.1f ms after the last event\n",
+        std::chrono::duration<double, std::milli>(drained - produced).count());
+    return 0;
+}
@@ -0,0 +1,208 @@
+// Generates a corpus of synthetic PE images plus a matching fake module snapshot, or fuzzes the PE parser
+// with mutated images.
+//
+//   PeCorpusGen <output-dir> [modules] [malformed-every] [seed]
+//   PeCorpusGen --fuzz <iterations> [seed]
+//   PeCorpusGen --fleet <output-dir> <machines> [modules] [seed]
+//
+// The corpus is one image per module, named as FakeModules::FileName names them, and snapshot.tsv with
+// one "base<TAB>size<TAB>defect<TAB>path" line per image in load order. Every malformed-every-th image
+// (default 16, 0 for none) carries one of the SyntheticPe defects.
+//
+// Fuzzing builds corpus images in memory, overwrites a few bytes of each and runs the parsers and the
+// code integrity check over the result. It exits non-zero only by crashing, so run it under a sanitizer.
+//
+// --fleet writes one module snapshot (.emsnap) per simulated machine for SnapshotDiff. Machines share
+// the first modules FakeModules modules but each skips a few, loads a few of its own and has a few at a
+// different version, base address or size.
+
+#include "CodeIntegrity.h"
+#include "FakeModules.h"
+#include "ImageTree.h"
+#include "PeImage.h"
+#include "SnapshotFormat.h"
+#include "SyntheticPe.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t kDefaultModules = 1500;
+constexpr uint32_t kDefaultMalformedEvery = 16;
+constexpr uint64_t kDefaultSeed = 1;
+
+// The fuzzed image stands in for both the module file and the loaded image in CheckIntegrity.
+const std::vector<uint8_t>* g_fuzzImage = nullptr;
+
+CodeIntegrity::File OpenFuzzImage(const std::wstring&) {
+    CodeIntegrity::File file;
+    file.data = g_fuzzImage->data();
+    file.size = g_fuzzImage->size();
+    return file;
+}
+
+// Compares the image, read as if mapped at a different base, with itself read as a file: the section
+// spans, relocation blocks and IAT mask all come from mutated headers.
+size_t CheckIntegrity(const std::vector<uint8_t>& image) {
+    g_fuzzImage = &image;
+    const std::vector<CodeIntegrity::Module> modules = { { L"fuzz.dll", 0x7FF800000000ull, image.data(), image.size() } };
+    const auto results = CodeIntegrity::Check(modules, OpenFuzzImage, {});
+    return results.front().ranges.size();
+}
+
+// Touches every table the parsers would: all sections, every directory's bytes and each subtree node.
+size_t WalkImage(const std::vector<uint8_t>& image, size_t& treeEntries) {
+    PeImage::View view(image.data(), image.size());
+    if (!view.IsValid()) {
+        return 0;
+    }
+    for (size_t node = 0; node < ImageTree::kNodeCount; ++node) {
+        treeEntries += ImageTree::Decode(view, static_cast<ImageTree::Node>(node)).entries.size();
+    }
+    size_t touched = 0;
+    for (uint32_t i = 0; i < view.SectionCount(); ++i) {
+        touched += view.SectionAt(i).sizeOfRawData != 0 ? 1 : 0;
+    }
+    for (uint32_t i = 0; i < PeImage::kDirectoryCount; ++i) {
+        const auto directory = view.Directory(i);
+        touched += view.AtRva(directory.rva, directory.size) ? 1 : 0;
+    }
+    return touched;
+}
+
+int Generate(const std::filesystem::path& directory, size_t modules, uint32_t malformedEvery, uint64_t seed) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::fprintf(stderr, "Cannot create %s: %s\n", directory.string().c_str(), error.message().c_str());
+        return 1;
+    }
+    FILE* snapshot = std::fopen((directory / "snapshot.tsv").string().c_str(), "w");
+    if (!snapshot) {
+        std::fprintf(stderr, "Cannot create snapshot.tsv in %s\n", directory.string().c_str());
+        return 1;
+    }
+
+    uint64_t bytes = 0;
+    size_t malformed = 0;
+    for (size_t i = 0; i < modules; ++i) {
+        const auto options = SyntheticPe::CorpusOptions(seed, i, malformedEvery);
+        const auto image = SyntheticPe::Build(options);
+        const auto path = directory / FakeModules::FileName(i);
+        if (!SyntheticPe::Write(path, image)) {
+            std::fprintf(stderr, "Cannot write %s\n", path.string().c_str());
+            std::fclose(snapshot);
+            return 1;
+        }
+        PeImage::View view(image.data(), image.size());
+        std::fprintf(snapshot, "0x%016llx\t%u\t%s\t%s\n",
+            static_cast<unsigned long long>(FakeModules::BaseAddress(i)),
+            view.IsValid() ? view.SizeOfImage() : static_cast<uint32_t>(image.size()),
+            SyntheticPe::DefectName(options.defect),
+            path.string().c_str());
+        bytes += image.size();
+        malformed += options.defect != SyntheticPe::Defect::None ? 1 : 0;
+    }
+    std::fclose(snapshot);
+    std::printf("Wrote %zu images (%zu malformed, %.1f MB) to %s\n", modules, malformed,
+        static_cast<double>(bytes) / (1024.0 * 1024.0), directory.string().c_str());
+    return 0;
+}
+
+int Fuzz(uint64_t iterations, uint64_t seed) {
+    size_t valid = 0;
+    size_t withVersion = 0;
+    size_t touched = 0;
+    size_t treeEntries = 0;
+    size_t changedRanges = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        auto image = SyntheticPe::Build(SyntheticPe::CorpusOptions(seed, static_cast<size_t>(i), 4));
+        SyntheticPe::Mutate(image, seed ^ (i * 0x9E3779B97F4A7C15ull), 1 + static_cast<uint32_t>(i % 16));
+        const auto info = PeImage::ParseImageInfo(image.data(), image.size());
+        valid += info.machineType != L"Unknown" ? 1 : 0;
+        withVersion += info.companyName.empty() ? 0 : 1;
+        touched += WalkImage(image, treeEntries);
+        changedRanges += CheckIntegrity(image);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%llu images: %zu valid headers, %zu with version strings, %zu tables reached, %zu subtree entries, "
+        "%zu changed code ranges, %.1f us/image\n",
+        static_cast<unsigned long long>(iterations), valid, withVersion, touched, treeEntries, changedRanges,
+        iterations ? seconds * 1e6 / static_cast<double>(iterations) : 0.0);
+    return 0;
+}
+
+int Fleet(const std::filesystem::path& directory, size_t machines, size_t modules, uint64_t seed) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        std::fprintf(stderr, "Cannot create %s: %s\n", directory.string().c_str(), error.message().c_str());
+        return 1;
+    }
+
+    const auto extras = modules / 50 + 1;
+    ModuleRecord record = {};
+    for (size_t machine = 0; machine < machines; ++machine) {
+        std::mt19937_64 random(seed ^ (machine * 0x9E3779B97F4A7C15ull));
+        char name[32] = {};
+        std::snprintf(name, sizeof(name), "machine%06u.emsnap", static_cast<unsigned>(machine % 1000000));
+        const auto path = directory / name;
+        SnapshotFormat::Writer writer(path, modules + extras, 0, static_cast<uint32_t>(machine));
+
+        // Shared modules, then machine-specific ones drawn from a long tail past the shared range.
+        for (size_t i = 0; i < modules + extras; ++i) {
+            const size_t index = i < modules ? i : modules + random() % (modules * 10 + 1);
+            const uint64_t roll = random() % 1000;
+            if (i < modules && roll < 20) {
+                continue;
+            }
+            FakeModules::Describe(static_cast<ModuleEnumerator::Handle>(index + 1), record);
+            const uint64_t version = roll < 40 ? 0x000A0000585D0002ull : 0x000A0000585D0001ull;
+            const uint64_t base = roll < 45 ? FakeModules::BaseAddress(index) + 0x10000000 : FakeModules::BaseAddress(index);
+            const uint32_t size = roll >= 45 && roll < 50 ? record.size + 0x1000 : record.size;
+            const SnapshotFormat::Row row = { record.path, base, size, version, L"10.0.22621.1",
+                L"Contoso Ltd.", L"Contoso synthetic module", PeImage::kMachineAmd64 };
+            writer.Append(row);
+        }
+        if (!writer.Finish()) {
+            std::fprintf(stderr, "Cannot write %s\n", path.string().c_str());
+            return 1;
+        }
+    }
+    std::printf("Wrote %zu snapshots of about %zu modules to %s\n", machines, modules, directory.string().c_str());
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "--fuzz") == 0) {
+        const uint64_t iterations = std::strtoull(argv[2], nullptr, 10);
+        const uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 0) : kDefaultSeed;
+        return Fuzz(iterations, seed);
+    }
+    if (argc >= 4 && std::strcmp(argv[1], "--fleet") == 0) {
+        const size_t machines = static_cast<size_t>(std::strtoull(argv[3], nullptr, 10));
+        const size_t modules = argc > 4 ? static_cast<size_t>(std::strtoull(argv[4], nullptr, 10)) : kDefaultModules;
+        const uint64_t seed = argc > 5 ? std::strtoull(argv[5], nullptr, 0) : kDefaultSeed;
+        return Fleet(argv[2], machines, modules, seed);
+    }
+    if (argc < 2 || argv[1][0] == '-') {
+        std::fprintf(stderr, "usage: %s <output-dir> [modules] [malformed-every] [seed]\n", argv[0]);
+        std::fprintf(stderr, "       %s --fuzz <iterations> [seed]\n", argv[0]);
+        std::fprintf(stderr, "       %s --fleet <output-dir> <machines> [modules] [seed]\n", argv[0]);
+        return 2;
+    }
+    const size_t modules = argc > 2 ? static_cast<size_t>(std::strtoull(argv[2], nullptr, 10)) : kDefaultModules;
+    const auto malformedEvery = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : kDefaultMalformedEvery;
+    const uint64_t seed = argc > 4 ? std::strtoull(argv[4], nullptr, 0) : kDefaultSeed;
+    return Generate(argv[1], modules, malformedEvery, seed);
+}
@@ -0,0 +1,214 @@
+// Compares module snapshots exported by the extension (.emsnap).
+//
+//   SnapshotDiff <before> <after> [<later> ...]
+//   SnapshotDiff --prevalence [--threads <n>] [--top <n>] <file-or-directory> ...
+//
+// The first form lists modules added, removed or changed (version, size, base address) between each
+// consecutive pair. The second counts, across every snapshot found (directories are searched
+// recursively for *.emsnap), how many contain each module. Snapshots are mapped and read in place and
+// loaded by a pool of threads; paths are compared case-insensitively.
+
+#include "PeImage.h"
+#include "Platform.h"
+#include "SnapshotCompare.h"
+#include "SnapshotFormat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using SnapshotCompare::Entry;
+
+std::string Utf8(std::u16string_view text) {
+    std::string result;
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t codePoint = text[i];
+        if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < text.size() && text[i + 1] >= 0xDC00 &&
+            text[i + 1] < 0xE000) {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (text[++i] - 0xDC00);
+        }
+        if (codePoint < 0x80) {
+            result += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            result += static_cast<char>(0xC0 | (codePoint >> 6));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            result += static_cast<char>(0xE0 | (codePoint >> 12));
+            result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            result += static_cast<char>(0xF0 | (codePoint >> 18));
+            result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+    return result;
+}
+
+std::string Version(uint64_t version) {
+    char text[32] = "-";
+    if (version != 0) {
+        std::snprintf(text, sizeof(text), "%u.%u.%u.%u", PeImage::VersionPart(version, 0),
+            PeImage::VersionPart(version, 1), PeImage::VersionPart(version, 2), PeImage::VersionPart(version, 3));
+    }
+    return text;
+}
+
+// False (with a message) if the file cannot be mapped or is not a snapshot.
+bool Load(const std::filesystem::path& path, SnapshotCompare::PathInterner& interner, std::vector<Entry>& entries) {
+    const auto file = Platform::MappedFile::Open(path);
+    if (!file) {
+        std::fprintf(stderr, "%s: cannot open\n", path.string().c_str());
+        return false;
+    }
+    const SnapshotFormat::Reader reader(file->Data(), file->Size());
+    if (!reader.IsValid()) {
+        std::fprintf(stderr, "%s: not a module snapshot\n", path.string().c_str());
+        return false;
+    }
+    entries = SnapshotCompare::LoadEntries(reader, interner);
+    return true;
+}
+
+int Diff(const std::vector<std::filesystem::path>& paths) {
+    SnapshotCompare::PathInterner interner;
+    std::vector<Entry> before;
+    if (!Load(paths[0], interner, before)) {
+        return 1;
+    }
+    for (size_t i = 1; i < paths.size(); ++i) {
+        std::vector<Entry> after;
+        if (!Load(paths[i], interner, after)) {
+            return 1;
+        }
+        const auto diff = SnapshotCompare::Compare(before, after);
+        std::printf("--- %s\n+++ %s\n", paths[i - 1].string().c_str(), paths[i].string().c_str());
+        for (const auto& entry : diff.removed) {
+            std::printf("- %s %s\n", Utf8(interner.Path(entry.path)).c_str(), Version(entry.fileVersion).c_str());
+        }
+        for (const auto& entry : diff.added) {
+            std::printf("+ %s %s\n", Utf8(interner.Path(entry.path)).c_str(), Version(entry.fileVersion).c_str());
+        }
+        for (const auto& change : diff.changed) {
+            std::printf("~ %s", Utf8(interner.Path(change.after.path)).c_str());
+            if (change.before.fileVersion != change.after.fileVersion) {
+                std::printf(" version %s -> %s", Version(change.before.fileVersion).c_str(),
+                    Version(change.after.fileVersion).c_str());
+            }
+            if (change.before.size != change.after.size) {
+                std::printf(" size %u -> %u", change.before.size, change.after.size);
+            }
+            if (change.before.baseAddress != change.after.baseAddress) {
+                std::printf(" base 0x%llX -> 0x%llX", static_cast<unsigned long long>(change.before.baseAddress),
+                    static_cast<unsigned long long>(change.after.baseAddress));
+            }
+            std::printf("\n");
+        }
+        std::printf("%zu removed, %zu added, %zu changed\n", diff.removed.size(), diff.added.size(), diff.changed.size());
+        before = std::move(after);
+    }
+    return 0;
+}
+
+std::vector<std::filesystem::path> FindSnapshots(const std::vector<std::filesystem::path>& roots) {
+    std::vector<std::filesystem::path> files;
+    for (const auto& root : roots) {
+        std::error_code error;
+        if (!std::filesystem::is_directory(root, error)) {
+            files.push_back(root);
+            continue;
+        }
+        for (auto it = std::filesystem::recursive_directory_iterator(root, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_regular_file(error) && it->path().extension() == ".emsnap") {
+                files.push_back(it->path());
+            }
+        }
+    }
+    return files;
+}
+
+int Prevalence(const std::vector<std::filesystem::path>& roots, uint32_t threadCount, size_t top) {
+    const auto files = FindSnapshots(roots);
+    if (files.empty()) {
+        std::fprintf(stderr, "no snapshots found\n");
+        return 1;
+    }
+
+    SnapshotCompare::PathInterner interner;
+    std::vector<SnapshotCompare::Prevalence> partial(threadCount);
+    std::atomic<size_t> next{ 0 };
+    std::atomic<size_t> failed{ 0 };
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([&, i] {
+            std::vector<Entry> entries;
+            for (size_t file; (file = next.fetch_add(1, std::memory_order_relaxed)) < files.size();) {
+                if (Load(files[file], interner, entries)) {
+                    partial[i].Add(entries);
+                } else {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    SnapshotCompare::Prevalence total;
+    for (const auto& part : partial) {
+        total.Merge(part);
+    }
+    const auto sorted = total.Sorted(interner);
+    std::printf("%llu snapshots (%zu unreadable), %zu distinct modules\n",
+        static_cast<unsigned long long>(total.Snapshots()), failed.load(), sorted.size());
+    const double snapshots = static_cast<double>(total.Snapshots());
+    for (size_t i = 0; i < sorted.size() && i < top; ++i) {
+        std::printf("%10llu %6.2f%%  %s\n", static_cast<unsigned long long>(sorted[i].second),
+            100.0 * static_cast<double>(sorted[i].second) / snapshots, Utf8(interner.Path(sorted[i].first)).c_str());
+    }
+    return failed.load() == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool prevalence = false;
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t top = 50;
+    std::vector<std::filesystem::path> paths;
+    bool valid = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--prevalence") == 0) {
+            prevalence = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            valid = valid && threads > 0;
+        } else if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            valid = false;
+        } else {
+            paths.emplace_back(argv[i]);
+        }
+    }
+    if (!valid || paths.empty() || (!prevalence && paths.size() < 2)) {
+        std::fprintf(stderr,
+            "usage: %s <before> <after> [<later> ...]\n"
+            "       %s --prevalence [--threads <n>] [--top <n>] <file-or-directory> ...\n",
+            argv[0], argv[0]);
+        return 2;
+    }
+    return prevalence ? Prevalence(paths, threads, top) : Diff(paths);
+}